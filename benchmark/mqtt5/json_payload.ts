@@ -0,0 +1,211 @@
+/**
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0.
+ */
+
+/*
+ * Compares parsing received JSON payloads with JSON.parse in the message handler against jsonPayloadOptions, which
+ * validates and tokenizes them on the client's I/O thread and builds the value in JavaScript on first access.
+ * Reports messages per second, the utilization of the benchmark's event loop, and garbage collection counts and pause
+ * time for each mode.
+ *
+ * Needs a broker at --endpoint/--port.
+ */
+
+import {ICrtError, mqtt5} from "aws-crt";
+import {once} from "events";
+import {performance, PerformanceObserver, EventLoopUtilization} from "perf_hooks";
+
+type Args = { [index: string]: any };
+
+const yargs = require('yargs');
+
+yargs.command('*', false, (yargs: any) => {
+    yargs.option({
+        'endpoint': {
+            description: 'STR: endpoint to connect to',
+            type: 'string',
+            default: 'localhost',
+        },
+        'port': {
+            description: 'INT: port to connect to',
+            type: 'number',
+            default: 1883,
+        },
+        'messages': {
+            description: 'INT: number of publishes per run',
+            type: 'number',
+            default: 50000,
+        },
+        'fields': {
+            description: 'INT: number of members in each published document',
+            type: 'number',
+            default: 16,
+        },
+        'read_fraction': {
+            description: 'NUMBER: fraction of received documents whose value is actually read',
+            type: 'number',
+            default: 1,
+        }
+    });
+}, main).parse();
+
+type ParseMode = "json_parse" | "native_tape";
+
+interface ParseResult {
+    mode: ParseMode;
+    messages: number;
+    payloadBytes: number;
+    seconds: number;
+    messagesPerSecond: number;
+    eventLoopUtilization: number;
+    gcCount: number;
+    gcPauseMs: number;
+}
+
+/* a mix of numbers, strings, booleans, nulls and nesting, roughly like device telemetry */
+function makeDocument(fields: number) : string {
+    let document : any = {};
+    for (let i = 0; i < fields; i++) {
+        switch (i % 5) {
+            case 0:
+                document[`reading${i}`] = i * 1.25;
+                break;
+            case 1:
+                document[`label${i}`] = `sensor-${i}-é`;
+                break;
+            case 2:
+                document[`enabled${i}`] = (i % 2) == 0;
+                break;
+            case 3:
+                document[`missing${i}`] = null;
+                break;
+            default:
+                document[`nested${i}`] = { values: [i, i + 1, i + 2], unit: "celsius" };
+                break;
+        }
+    }
+
+    return JSON.stringify(document);
+}
+
+function makeClient(args: Args, mode: ParseMode, topic: string) : mqtt5.Mqtt5Client {
+    let config : mqtt5.Mqtt5ClientConfig = {
+        hostName: args.endpoint,
+        port: args.port,
+    };
+
+    if (mode == "native_tape") {
+        config.jsonPayloadOptions = { topicFilters: [topic] };
+    }
+
+    let client : mqtt5.Mqtt5Client = new mqtt5.Mqtt5Client(config);
+    client.on('error', (error: ICrtError) => { });
+
+    return client;
+}
+
+async function startClient(client: mqtt5.Mqtt5Client) {
+    let connectionSuccess = once(client, mqtt5.Mqtt5Client.CONNECTION_SUCCESS);
+    client.start();
+    await connectionSuccess;
+}
+
+async function stopClient(client: mqtt5.Mqtt5Client) {
+    let stopped = once(client, mqtt5.Mqtt5Client.STOPPED);
+    client.stop();
+    await stopped;
+    client.close();
+}
+
+async function runMode(args: Args, mode: ParseMode) : Promise<ParseResult> {
+    let topic : string = `bench/json_payload/${mode}/${Date.now()}`;
+    let document : string = makeDocument(args.fields);
+    let readInterval : number = args.read_fraction > 0 ? Math.max(1, Math.round(1 / args.read_fraction)) : 0;
+
+    let subscriber : mqtt5.Mqtt5Client = makeClient(args, mode, topic);
+    let publisher : mqtt5.Mqtt5Client = makeClient(args, "json_parse", topic);
+
+    await startClient(subscriber);
+    await startClient(publisher);
+
+    await subscriber.subscribe({
+        subscriptions: [{ topicFilter: topic, qos: mqtt5.QoS.AtLeastOnce }]
+    });
+
+    let received : number = 0;
+    let checksum : number = 0;
+    let allReceived = new Promise<void>((resolve) => {
+        subscriber.on(mqtt5.Mqtt5Client.MESSAGE_RECEIVED, (event: mqtt5.MessageReceivedEvent) => {
+            if (readInterval > 0 && (received % readInterval) == 0) {
+                let value : any = (mode == "native_tape") ?
+                    event.json :
+                    JSON.parse(Buffer.from(event.message.payload as ArrayBuffer).toString('utf8'));
+                checksum += Object.keys(value).length;
+            }
+
+            if (++received == args.messages) {
+                resolve();
+            }
+        });
+    });
+
+    let gcCount : number = 0;
+    let gcPauseMs : number = 0;
+    let gcObserver = new PerformanceObserver((list) => {
+        for (let entry of list.getEntries()) {
+            gcCount++;
+            gcPauseMs += entry.duration;
+        }
+    });
+    gcObserver.observe({ entryTypes: ['gc'] });
+
+    let payload : Buffer = Buffer.from(document, 'utf8');
+    let eluStart : EventLoopUtilization = performance.eventLoopUtilization();
+    let start = process.hrtime.bigint();
+    for (let i = 0; i < args.messages; i++) {
+        publisher.publish({
+            topicName: topic,
+            qos: mqtt5.QoS.AtLeastOnce,
+            payload: payload
+        }).catch(() => {});
+    }
+
+    await allReceived;
+    let seconds = Number(process.hrtime.bigint() - start) / 1e9;
+    let elu : EventLoopUtilization = performance.eventLoopUtilization(eluStart);
+
+    /* let pending gc entries be delivered before disconnecting the observer */
+    await new Promise((resolve) => setImmediate(resolve));
+    gcObserver.disconnect();
+
+    await stopClient(publisher);
+    await stopClient(subscriber);
+
+    if (readInterval > 0 && checksum == 0) {
+        throw new Error("no documents were read");
+    }
+
+    return {
+        mode: mode,
+        messages: args.messages,
+        payloadBytes: payload.length,
+        seconds: seconds,
+        messagesPerSecond: args.messages / seconds,
+        eventLoopUtilization: elu.utilization,
+        gcCount: gcCount,
+        gcPauseMs: gcPauseMs,
+    };
+}
+
+async function main(args : Args) {
+    let results : Array<ParseResult> = [];
+
+    for (let mode of ["json_parse", "native_tape"] as Array<ParseMode>) {
+        results.push(await runMode(args, mode));
+    }
+
+    console.log(JSON.stringify(results, null, 2));
+
+    process.exit(0);
+}
@@ -0,0 +1,34 @@
+/**
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0.
+ */
+
+/*
+ * Hosts the repository's test broker on a worker thread so that broker work does not count against the event loop
+ * utilization measured on the benchmark's main thread.
+ *
+ * Posts { port } once listening; on a "stop" message, stops the broker and posts { statistics }.
+ */
+
+import {parentPort, workerData} from "worker_threads";
+import {LocalMqttBroker} from "../../test/mqtt_broker";
+
+async function run() {
+    let broker : LocalMqttBroker = new LocalMqttBroker();
+    broker.latencyMs = workerData?.latencyMs ?? 0;
+    broker.dropRate = workerData?.dropRate ?? 0;
+
+    let port : number = await broker.start();
+
+    parentPort?.on('message', async (message: string) => {
+        if (message == "stop") {
+            await broker.stop();
+            parentPort?.postMessage({ statistics: broker.statistics });
+            parentPort?.close();
+        }
+    });
+
+    parentPort?.postMessage({ port: port });
+}
+
+run();
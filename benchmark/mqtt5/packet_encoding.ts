@@ -0,0 +1,194 @@
+/**
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0.
+ */
+
+/*
+ * Compares how quickly received publishes reach JavaScript when they are built property by property through N-API,
+ * built lazily (lazyPublishProperties), decoded from a binary record (binaryPublishEncoding), or read from a shared
+ * memory ring (sharedMessageRingOptions).  Reports messages per second along with garbage collection counts and pause
+ * time for each mode.
+ *
+ * Needs a broker at --endpoint/--port.
+ */
+
+import {ICrtError, mqtt5} from "aws-crt";
+import {once} from "events";
+import {PerformanceObserver} from "perf_hooks";
+
+type Args = { [index: string]: any };
+
+const yargs = require('yargs');
+
+yargs.command('*', false, (yargs: any) => {
+    yargs.option({
+        'endpoint': {
+            description: 'STR: endpoint to connect to',
+            type: 'string',
+            default: 'localhost',
+        },
+        'port': {
+            description: 'INT: port to connect to',
+            type: 'number',
+            default: 1883,
+        },
+        'messages': {
+            description: 'INT: number of publishes per run',
+            type: 'number',
+            default: 50000,
+        },
+        'payload_size': {
+            description: 'INT: payload size in bytes',
+            type: 'number',
+            default: 64,
+        },
+        'user_properties': {
+            description: 'INT: number of user properties on each publish',
+            type: 'number',
+            default: 4,
+        },
+        'read_properties': {
+            description: 'BOOL: read every secondary field of each received publish',
+            type: 'boolean',
+            default: false,
+        }
+    });
+}, main).parse();
+
+type EncodingMode = "object" | "lazy" | "binary" | "ring";
+
+interface EncodingResult {
+    mode: EncodingMode;
+    messages: number;
+    seconds: number;
+    messagesPerSecond: number;
+    gcCount: number;
+    gcPauseMs: number;
+    secondaryFieldsRead: number;
+}
+
+function makeClient(args: Args, mode: EncodingMode) : mqtt5.Mqtt5Client {
+    let config : mqtt5.Mqtt5ClientConfig = {
+        hostName: args.endpoint,
+        port: args.port,
+        lazyPublishProperties: mode == "lazy",
+        binaryPublishEncoding: mode == "binary",
+    };
+
+    if (mode == "ring") {
+        config.sharedMessageRingOptions = { sizeInBytes: 64 * 1024 * 1024 };
+    }
+
+    let client : mqtt5.Mqtt5Client = new mqtt5.Mqtt5Client(config);
+    client.on('error', (error: ICrtError) => { });
+
+    return client;
+}
+
+async function startClient(client: mqtt5.Mqtt5Client) {
+    let connectionSuccess = once(client, mqtt5.Mqtt5Client.CONNECTION_SUCCESS);
+    client.start();
+    await connectionSuccess;
+}
+
+async function stopClient(client: mqtt5.Mqtt5Client) {
+    let stopped = once(client, mqtt5.Mqtt5Client.STOPPED);
+    client.stop();
+    await stopped;
+    client.close();
+}
+
+function touchSecondaryFields(packet: mqtt5.PublishPacket) : number {
+    return (packet.userProperties?.length ?? 0) +
+        (packet.subscriptionIdentifiers?.length ?? 0) +
+        (packet.responseTopic?.length ?? 0) +
+        (packet.contentType?.length ?? 0);
+}
+
+async function runMode(args: Args, mode: EncodingMode) : Promise<EncodingResult> {
+    let topic : string = `bench/packet_encoding/${mode}/${Date.now()}`;
+
+    let subscriber : mqtt5.Mqtt5Client = makeClient(args, mode);
+    let publisher : mqtt5.Mqtt5Client = makeClient(args, "object");
+
+    await startClient(subscriber);
+    await startClient(publisher);
+
+    await subscriber.subscribe({
+        subscriptions: [{ topicFilter: topic, qos: mqtt5.QoS.AtLeastOnce }]
+    });
+
+    let received : number = 0;
+    let secondaryFieldsRead : number = 0;
+    let allReceived = new Promise<void>((resolve) => {
+        subscriber.on(mqtt5.Mqtt5Client.MESSAGE_RECEIVED, (event: mqtt5.MessageReceivedEvent) => {
+            if (args.read_properties) {
+                secondaryFieldsRead += touchSecondaryFields(event.message);
+            }
+
+            if (++received == args.messages) {
+                resolve();
+            }
+        });
+    });
+
+    let userProperties : Array<mqtt5.UserProperty> = [];
+    for (let i = 0; i < args.user_properties; i++) {
+        userProperties.push({ name: `property-${i}`, value: `value-${i}` });
+    }
+
+    let gcCount : number = 0;
+    let gcPauseMs : number = 0;
+    let gcObserver = new PerformanceObserver((list) => {
+        for (let entry of list.getEntries()) {
+            gcCount++;
+            gcPauseMs += entry.duration;
+        }
+    });
+    gcObserver.observe({ entryTypes: ['gc'] });
+
+    let payload : Buffer = Buffer.alloc(args.payload_size, 'a');
+    let start = process.hrtime.bigint();
+    for (let i = 0; i < args.messages; i++) {
+        publisher.publish({
+            topicName: topic,
+            qos: mqtt5.QoS.AtLeastOnce,
+            payload: payload,
+            responseTopic: "bench/reply",
+            contentType: "application/octet-stream",
+            userProperties: userProperties
+        }).catch(() => {});
+    }
+
+    await allReceived;
+    let seconds = Number(process.hrtime.bigint() - start) / 1e9;
+
+    /* let pending gc entries be delivered before disconnecting the observer */
+    await new Promise((resolve) => setImmediate(resolve));
+    gcObserver.disconnect();
+
+    await stopClient(publisher);
+    await stopClient(subscriber);
+
+    return {
+        mode: mode,
+        messages: args.messages,
+        seconds: seconds,
+        messagesPerSecond: args.messages / seconds,
+        gcCount: gcCount,
+        gcPauseMs: gcPauseMs,
+        secondaryFieldsRead: secondaryFieldsRead,
+    };
+}
+
+async function main(args : Args) {
+    let results : Array<EncodingResult> = [];
+
+    for (let mode of ["object", "lazy", "binary", "ring"] as Array<EncodingMode>) {
+        results.push(await runMode(args, mode));
+    }
+
+    console.log(JSON.stringify(results, null, 2));
+
+    process.exit(0);
+}
@@ -0,0 +1,209 @@
+/**
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0.
+ */
+
+/*
+ * Compares QoS 1 publish throughput with and without a persistent queue, and measures how long a client takes to
+ * recover and resubmit a backlog of persisted publishes.
+ *
+ * The throughput phase needs a broker at --endpoint/--port.  The recovery phase runs entirely offline.
+ */
+
+import {ICrtError, mqtt5} from "aws-crt";
+import {once} from "events";
+import * as fs from "fs";
+import * as os from "os";
+import * as path from "path";
+
+type Args = { [index: string]: any };
+
+const yargs = require('yargs');
+
+yargs.command('*', false, (yargs: any) => {
+    yargs.option({
+        'endpoint': {
+            description: 'STR: endpoint to connect to',
+            type: 'string',
+            default: 'localhost',
+        },
+        'port': {
+            description: 'INT: port to connect to',
+            type: 'number',
+            default: 1883,
+        },
+        'messages': {
+            description: 'INT: number of publishes per run',
+            type: 'number',
+            default: 10000,
+        },
+        'payload_size': {
+            description: 'INT: payload size in bytes',
+            type: 'number',
+            default: 256,
+        },
+        'in_flight': {
+            description: 'INT: maximum number of outstanding publishes',
+            type: 'number',
+            default: 100,
+        },
+        'skip_throughput': {
+            description: 'BOOL: only run the offline recovery benchmark',
+            type: 'boolean',
+            default: false,
+        }
+    });
+}, main).parse();
+
+interface ThroughputResult {
+    persistent: boolean;
+    messages: number;
+    seconds: number;
+    messagesPerSecond: number;
+}
+
+interface RecoveryResult {
+    messages: number;
+    logBytes: number;
+    recoveryMs: number;
+}
+
+function sleep(millisecond: number) {
+    return new Promise((resolve) => setTimeout(resolve, millisecond));
+}
+
+function makeQueueDirectory() : string {
+    return fs.mkdtempSync(path.join(os.tmpdir(), "mqtt5-queue-bench-"));
+}
+
+function directorySize(directory: string) : number {
+    return fs.readdirSync(directory)
+        .map((name) => fs.statSync(path.join(directory, name)).size)
+        .reduce((total, size) => total + size, 0);
+}
+
+async function runThroughput(args: Args, persistent: boolean) : Promise<ThroughputResult> {
+    let queueDirectory : string | undefined = persistent ? makeQueueDirectory() : undefined;
+
+    let config : mqtt5.Mqtt5ClientConfig = {
+        hostName: args.endpoint,
+        port: args.port,
+    };
+
+    if (queueDirectory) {
+        config.persistentQueueOptions = {
+            directory: queueDirectory,
+            maxSizeBytes: 1024 * 1024 * 1024,
+        };
+    }
+
+    let client : mqtt5.Mqtt5Client = new mqtt5.Mqtt5Client(config);
+    client.on('error', (error: ICrtError) => { });
+
+    let connectionSuccess = once(client, mqtt5.Mqtt5Client.CONNECTION_SUCCESS);
+    client.start();
+    await connectionSuccess;
+
+    let payload : Buffer = Buffer.alloc(args.payload_size, 'a');
+    let outstanding : Set<Promise<any>> = new Set();
+
+    let start = process.hrtime.bigint();
+    for (let i = 0; i < args.messages; i++) {
+        let publish : Promise<any> = client.publish({
+            topicName: "bench/persistent_queue",
+            qos: mqtt5.QoS.AtLeastOnce,
+            payload: payload
+        });
+
+        let settle = () => { outstanding.delete(publish); };
+        outstanding.add(publish);
+        publish.then(settle, settle);
+
+        if (outstanding.size >= args.in_flight) {
+            await Promise.race(outstanding);
+        }
+    }
+    await Promise.all(outstanding);
+    let seconds = Number(process.hrtime.bigint() - start) / 1e9;
+
+    let stopped = once(client, mqtt5.Mqtt5Client.STOPPED);
+    client.stop();
+    await stopped;
+    client.close();
+
+    if (queueDirectory) {
+        fs.rmSync(queueDirectory, { recursive: true, force: true });
+    }
+
+    return {
+        persistent: persistent,
+        messages: args.messages,
+        seconds: seconds,
+        messagesPerSecond: args.messages / seconds,
+    };
+}
+
+async function runRecovery(args: Args) : Promise<RecoveryResult> {
+    let queueDirectory : string = makeQueueDirectory();
+
+    /* the client is never started, so every QoS 1 publish stays pending in the persistent queue */
+    let config : mqtt5.Mqtt5ClientConfig = {
+        hostName: args.endpoint,
+        port: args.port,
+        persistentQueueOptions: {
+            directory: queueDirectory,
+            maxSizeBytes: 1024 * 1024 * 1024,
+        }
+    };
+
+    let payload : Buffer = Buffer.alloc(args.payload_size, 'a');
+    let writer : mqtt5.Mqtt5Client = new mqtt5.Mqtt5Client(config);
+    for (let i = 0; i < args.messages; i++) {
+        writer.publish({
+            topicName: "bench/persistent_queue",
+            qos: mqtt5.QoS.AtLeastOnce,
+            payload: payload
+        }).catch(() => {});
+    }
+    writer.close();
+
+    /* give native client shutdown a moment to release the queue */
+    await sleep(1000);
+
+    let logBytes = directorySize(queueDirectory);
+
+    let start = process.hrtime.bigint();
+    let reader : mqtt5.Mqtt5Client = new mqtt5.Mqtt5Client(config);
+    let recoveryMs = Number(process.hrtime.bigint() - start) / 1e6;
+
+    let statistics : mqtt5.ClientStatistics = reader.getOperationalStatistics();
+    if (statistics.persistentQueuePendingCount != args.messages) {
+        console.log(`Warning: expected ${args.messages} recovered publishes, found ${statistics.persistentQueuePendingCount}`);
+    }
+
+    reader.close();
+    await sleep(1000);
+
+    fs.rmSync(queueDirectory, { recursive: true, force: true });
+
+    return {
+        messages: args.messages,
+        logBytes: logBytes,
+        recoveryMs: recoveryMs,
+    };
+}
+
+async function main(args : Args) {
+    let results : any = {};
+
+    if (!args.skip_throughput) {
+        results.inMemory = await runThroughput(args, false);
+        results.persistent = await runThroughput(args, true);
+    }
+
+    results.recovery = await runRecovery(args);
+
+    console.log(JSON.stringify(results, null, 2));
+
+    process.exit(0);
+}
@@ -0,0 +1,331 @@
+/**
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0.
+ */
+
+/*
+ * Publish/subscribe throughput and latency benchmark for the MQTT5 client and the MQTT 3.1.1 connection.
+ *
+ * For every (client, QoS) pair, one connection publishes at a fixed rate (or as fast as --max_in_flight allows) to a
+ * topic that a second connection subscribes to.  Each payload carries its send time, so the subscriber can compute
+ * publish-to-receive latency.  Messages sent during --warmup are delivered but not measured.
+ *
+ * Unless --endpoint is given, the repository's local test broker is started on a worker thread, keeping broker work off
+ * the event loop whose utilization is reported.  Results are printed as JSON for regression tracking.
+ */
+
+import {crt, ICrtError, io, mqtt, mqtt5} from "aws-crt";
+import {once} from "events";
+import {performance, EventLoopUtilization} from "perf_hooks";
+import {Worker} from "worker_threads";
+import * as path from "path";
+
+type Args = { [index: string]: any };
+
+const yargs = require('yargs');
+
+yargs.command('*', false, (yargs: any) => {
+    yargs.option({
+        'endpoint': {
+            description: 'STR: external broker to connect to; if omitted, a local broker is started',
+            type: 'string',
+        },
+        'port': {
+            description: 'INT: port of the external broker',
+            type: 'number',
+            default: 1883,
+        },
+        'clients': {
+            description: 'STR[]: client implementations to benchmark (mqtt5, mqtt311)',
+            type: 'array',
+            default: ['mqtt5', 'mqtt311'],
+        },
+        'qos': {
+            description: 'INT[]: QoS levels to benchmark',
+            type: 'array',
+            default: [0, 1],
+        },
+        'rate': {
+            description: 'INT: target publishes per second; 0 publishes as fast as --max_in_flight allows',
+            type: 'number',
+            default: 0,
+        },
+        'max_in_flight': {
+            description: 'INT: maximum number of publishes awaiting completion',
+            type: 'number',
+            default: 1000,
+        },
+        'payload_size': {
+            description: 'INT: payload size in bytes (at least 8, which holds the send timestamp)',
+            type: 'number',
+            default: 64,
+        },
+        'duration': {
+            description: 'INT: seconds to measure for each run',
+            type: 'number',
+            default: 10,
+        },
+        'warmup': {
+            description: 'INT: seconds to publish before measuring',
+            type: 'number',
+            default: 2,
+        },
+        'broker_latency_ms': {
+            description: 'INT: delay the local broker adds to every delivery',
+            type: 'number',
+            default: 0,
+        }
+    });
+}, main).parse();
+
+type ClientKind = "mqtt5" | "mqtt311";
+
+/* The subset of each client's API the benchmark needs */
+interface BenchmarkConnection {
+    subscribe(topic: string, qos: number, onMessage: (payload: ArrayBuffer) => void) : Promise<void>;
+    publish(topic: string, payload: Buffer, qos: number) : Promise<void>;
+    close() : Promise<void>;
+}
+
+interface LatencyPercentiles {
+    p50: number;
+    p90: number;
+    p99: number;
+    p999: number;
+    max: number;
+}
+
+interface ThroughputResult {
+    client: ClientKind;
+    qos: number;
+    payloadSize: number;
+    targetRate: number;
+    seconds: number;
+    sent: number;
+    received: number;
+    publishFailures: number;
+    messagesPerSecond: number;
+    latencyMs: LatencyPercentiles;
+    nativeMemoryBytes: { start: number, end: number, peak: number };
+    eventLoopUtilization: number;
+}
+
+async function createMqtt5Connection(host: string, port: number) : Promise<BenchmarkConnection> {
+    let client : mqtt5.Mqtt5Client = new mqtt5.Mqtt5Client({
+        hostName: host,
+        port: port,
+        connectProperties: {
+            keepAliveIntervalSeconds: 1200
+        }
+    });
+    client.on('error', (error: ICrtError) => { });
+
+    let connectionSuccess = once(client, mqtt5.Mqtt5Client.CONNECTION_SUCCESS);
+    client.start();
+    await connectionSuccess;
+
+    return {
+        subscribe: async (topic: string, qos: number, onMessage: (payload: ArrayBuffer) => void) => {
+            client.on(mqtt5.Mqtt5Client.MESSAGE_RECEIVED, (event: mqtt5.MessageReceivedEvent) => {
+                onMessage(event.message.payload as ArrayBuffer);
+            });
+            await client.subscribe({ subscriptions: [{ topicFilter: topic, qos: qos }] });
+        },
+        publish: async (topic: string, payload: Buffer, qos: number) => {
+            await client.publish({ topicName: topic, qos: qos, payload: payload });
+        },
+        close: async () => {
+            let stopped = once(client, mqtt5.Mqtt5Client.STOPPED);
+            client.stop();
+            await stopped;
+            client.close();
+        }
+    };
+}
+
+async function createMqtt311Connection(host: string, port: number) : Promise<BenchmarkConnection> {
+    let client : mqtt.MqttClient = new mqtt.MqttClient(new io.ClientBootstrap());
+    let connection : mqtt.MqttClientConnection = client.new_connection({
+        client_id: `bench-${Date.now()}-${Math.floor(Math.random() * 1000000)}`,
+        host_name: host,
+        port: port,
+        clean_session: true,
+        keep_alive: 1200,
+        socket_options: new io.SocketOptions()
+    });
+    connection.on('error', (error: ICrtError) => { });
+
+    await connection.connect();
+
+    return {
+        subscribe: async (topic: string, qos: number, onMessage: (payload: ArrayBuffer) => void) => {
+            await connection.subscribe(topic, qos, (topic: string, payload: ArrayBuffer) => { onMessage(payload); });
+        },
+        publish: async (topic: string, payload: Buffer, qos: number) => {
+            await connection.publish(topic, payload, qos);
+        },
+        close: async () => {
+            await connection.disconnect();
+        }
+    };
+}
+
+function createConnection(kind: ClientKind, host: string, port: number) : Promise<BenchmarkConnection> {
+    return kind == "mqtt5" ? createMqtt5Connection(host, port) : createMqtt311Connection(host, port);
+}
+
+function computePercentiles(latencies: Float64Array) : LatencyPercentiles {
+    latencies.sort();
+
+    let at = (fraction: number) : number => {
+        if (latencies.length == 0) {
+            return 0;
+        }
+
+        return latencies[Math.min(latencies.length - 1, Math.floor(fraction * latencies.length))];
+    };
+
+    return {
+        p50: at(0.5),
+        p90: at(0.9),
+        p99: at(0.99),
+        p999: at(0.999),
+        max: latencies.length > 0 ? latencies[latencies.length - 1] : 0,
+    };
+}
+
+async function runBenchmark(args: Args, kind: ClientKind, qos: number, host: string, port: number) : Promise<ThroughputResult> {
+    let topic : string = `bench/throughput/${kind}/${qos}/${Date.now()}`;
+
+    let subscriber : BenchmarkConnection = await createConnection(kind, host, port);
+    let publisher : BenchmarkConnection = await createConnection(kind, host, port);
+
+    let warmupEnd : bigint = BigInt(0);
+    let measureEnd : bigint = BigInt(0);
+    let latencies : Array<number> = [];
+    let received : number = 0;
+
+    await subscriber.subscribe(topic, qos, (payload: ArrayBuffer) => {
+        let sentAt : bigint = Buffer.from(payload, 0, 8).readBigUInt64BE(0);
+        if (sentAt >= warmupEnd && sentAt < measureEnd) {
+            received++;
+            latencies.push(Number(process.hrtime.bigint() - sentAt) / 1e6);
+        }
+    });
+
+    let payloadSize : number = Math.max(8, args.payload_size);
+    let sent : number = 0;
+    let measuredSent : number = 0;
+    let publishFailures : number = 0;
+    let inFlight : number = 0;
+
+    let nativeMemoryStart : number = crt.native_memory();
+    let nativeMemoryPeak : number = nativeMemoryStart;
+    let eluStart : EventLoopUtilization | undefined = undefined;
+
+    let start : bigint = process.hrtime.bigint();
+    warmupEnd = start + BigInt(args.warmup * 1e9);
+    measureEnd = warmupEnd + BigInt(args.duration * 1e9);
+
+    await new Promise<void>((resolve) => {
+        let timer = setInterval(() => {
+            let now : bigint = process.hrtime.bigint();
+            if (eluStart === undefined && now >= warmupEnd) {
+                eluStart = performance.eventLoopUtilization();
+            }
+
+            nativeMemoryPeak = Math.max(nativeMemoryPeak, crt.native_memory());
+
+            if (now >= measureEnd) {
+                clearInterval(timer);
+                resolve();
+                return;
+            }
+
+            let due : number = args.rate > 0 ? Math.floor(Number(now - start) / 1e9 * args.rate) - sent : Infinity;
+            let count : number = Math.min(due, args.max_in_flight - inFlight);
+
+            for (let i = 0; i < count; i++) {
+                /* every payload is a fresh buffer since the client may still reference earlier ones */
+                let payload : Buffer = Buffer.alloc(payloadSize);
+                let sentAt : bigint = process.hrtime.bigint();
+                payload.writeBigUInt64BE(sentAt, 0);
+
+                sent++;
+                if (sentAt >= warmupEnd) {
+                    measuredSent++;
+                }
+
+                inFlight++;
+                publisher.publish(topic, payload, qos)
+                    .catch(() => { publishFailures++; })
+                    .finally(() => { inFlight--; });
+            }
+        }, 1);
+    });
+
+    let elu : EventLoopUtilization = performance.eventLoopUtilization(eluStart);
+
+    /* give publishes sent near the end of the window a chance to arrive */
+    let drainDeadline : number = Date.now() + 5000;
+    while (received < measuredSent - publishFailures && Date.now() < drainDeadline) {
+        await new Promise((resolve) => setTimeout(resolve, 50));
+    }
+
+    let nativeMemoryEnd : number = crt.native_memory();
+
+    await publisher.close();
+    await subscriber.close();
+
+    return {
+        client: kind,
+        qos: qos,
+        payloadSize: payloadSize,
+        targetRate: args.rate,
+        seconds: args.duration,
+        sent: measuredSent,
+        received: received,
+        publishFailures: publishFailures,
+        messagesPerSecond: received / args.duration,
+        latencyMs: computePercentiles(Float64Array.from(latencies)),
+        nativeMemoryBytes: { start: nativeMemoryStart, end: nativeMemoryEnd, peak: nativeMemoryPeak },
+        eventLoopUtilization: elu.utilization,
+    };
+}
+
+async function startLocalBroker(args: Args) : Promise<{ worker: Worker, port: number }> {
+    let worker : Worker = new Worker(path.join(__dirname, "local_broker_worker.js"), {
+        workerData: { latencyMs: args.broker_latency_ms }
+    });
+
+    let message : any = (await once(worker, 'message'))[0];
+    return { worker: worker, port: message.port };
+}
+
+async function main(args : Args) {
+    let host : string = args.endpoint ?? "127.0.0.1";
+    let port : number = args.port;
+
+    let broker : { worker: Worker, port: number } | undefined = undefined;
+    if (args.endpoint === undefined) {
+        broker = await startLocalBroker(args);
+        port = broker.port;
+    }
+
+    let results : Array<ThroughputResult> = [];
+    for (let kind of args.clients as Array<ClientKind>) {
+        for (let qos of args.qos as Array<number>) {
+            results.push(await runBenchmark(args, kind, Number(qos), host, port));
+        }
+    }
+
+    if (broker) {
+        let stopped = once(broker.worker, 'message');
+        broker.worker.postMessage("stop");
+        await stopped;
+    }
+
+    console.log(JSON.stringify(results, null, 2));
+
+    process.exit(0);
+}
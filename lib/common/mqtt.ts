@@ -62,7 +62,8 @@ export type Payload = string | Record<string, unknown> | ArrayBuffer | ArrayBuff
  * Function called upon receipt of a Publish message on a subscribed topic.
  *
  * @param topic The topic to which the message was published.
- * @param payload The payload data.
+ * @param payload The payload data.  In node, every handler a message is delivered to receives a view of the same
+ *                memory, so handlers should treat it as read-only.
  * @param dup DUP flag. If true, this might be re-delivery of an earlier
  *            attempt to send the message.
  * @param qos Quality of Service used to deliver the message.
@@ -339,6 +339,34 @@ export interface MessageReceivedEvent {
      * PUBLISH packet received from the server
      */
     message: mqtt5_packet.PublishPacket;
+
+    /**
+     * (Node only) The message's payload parsed as JSON, if its topic matched the client's JSON payload options and the
+     * payload is valid JSON.  Parsing happens off of the JavaScript thread; the value itself is built on first access.
+     */
+    json?: any;
+
+    /**
+     * (Node only) Why the message's payload could not be parsed as JSON, if its topic matched the client's JSON
+     * payload options and the payload is not valid JSON.
+     */
+    jsonError?: JsonParseError;
+}
+
+/**
+ * Describes a payload that is not valid JSON
+ */
+export interface JsonParseError {
+
+    /**
+     * What made the payload invalid
+     */
+    message: string;
+
+    /**
+     * Byte offset in the payload at which the problem was found
+     */
+    offset: number;
 }
 
 /**
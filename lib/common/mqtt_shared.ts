@@ -60,3 +60,115 @@ export function normalize_payload_to_buffer(payload: any): Buffer {
 
 /** @internal */
 export const DEFAULT_KEEP_ALIVE : number = 1200;
+
+/**
+ * A rule in a received-message filter installed with `setMessageFilter` on a Node MQTT5 client or MQTT 3.1.1
+ * connection.  Rules are evaluated on the client's event loop thread, before a message is copied for delivery to
+ * JavaScript.
+ *
+ * The first rule whose topic filter matches a message's topic decides whether it is delivered; messages matching no
+ * rule are always delivered.  A matching rule drops the message if it fails the rule's predicates, is skipped by
+ * sampling, or exceeds the rule's rate limit, in that order.  Sampling and rate limits apply to each distinct topic
+ * separately.
+ *
+ * @group Node-only
+ */
+export interface MessageFilterRule {
+
+    /**
+     * MQTT topic filter (wildcards allowed) selecting the messages this rule applies to
+     */
+    topicFilter : string;
+
+    /**
+     * If true, every matching message is dropped
+     */
+    drop? : boolean;
+
+    /**
+     * If set, only messages whose retain flag equals this value are delivered
+     */
+    retain? : boolean;
+
+    /**
+     * If set, only messages carrying a user property with this name (and value, if given) are delivered.  MQTT 3.1.1
+     * messages have no user properties, so they never satisfy this predicate.
+     */
+    userProperty? : {
+        name : string;
+        value? : string;
+    };
+
+    /**
+     * If greater than one, only the first of every `sampleEvery` messages on each topic is delivered
+     */
+    sampleEvery? : number;
+
+    /**
+     * If set, at most this many messages per second are delivered on each topic, with bursts of up to one second's
+     * worth allowed
+     */
+    maxMessagesPerSecond? : number;
+}
+
+/**
+ * Configuration for a native cache of the latest message per topic, installed with `setLastValueCache` on a Node
+ * MQTT5 client.  The cache is updated on the client's event loop thread, so reading the latest value of a topic does
+ * not require every message on it to be delivered to JavaScript.
+ *
+ * When the cache would exceed either limit, the least recently used topics (by update or lookup) are evicted.
+ *
+ * @group Node-only
+ */
+export interface LastValueCacheOptions {
+
+    /**
+     * MQTT topic filters (wildcards allowed) selecting the messages to cache.  The client must separately be
+     * subscribed to these topics.
+     */
+    topicFilters : Array<string>;
+
+    /**
+     * Maximum number of distinct topics to cache.  Defaults to 10000.
+     */
+    maxTopicCount? : number;
+
+    /**
+     * Maximum total size, in bytes, of cached topics and payloads.  A message larger than this is never cached.
+     * Defaults to 16MB.
+     */
+    maxSizeBytes? : number;
+
+    /**
+     * If true, cached messages are not also delivered to the message received event.  Defaults to false.
+     */
+    suppressDelivery? : boolean;
+}
+
+/**
+ * Latest message received on a topic, as held by a last value cache
+ *
+ * @group Node-only
+ */
+export interface LastValue {
+
+    /**
+     * Topic the message was published to
+     */
+    topic : string;
+
+    /**
+     * Payload of the message
+     */
+    payload : ArrayBuffer;
+
+    /**
+     * Retain flag of the message
+     */
+    retain : boolean;
+
+    /**
+     * Milliseconds since the message was received
+     */
+    ageMs : number;
+}
@@ -184,9 +184,25 @@ export class AwsIotMqttConnectionConfigBuilder {
                 throw new CrtError("AwsIotMqttConnectionConfigBuilder configure_websocket_handshake: builder not defined");
             }
 
-            builder.params.websocket_handshake_transform = async (request, done) => {
-                const signing_config = options.create_signing_config?.()
-                    ?? {
+            const create_signing_config = options.create_signing_config;
+            if (create_signing_config) {
+                /* a custom config is rebuilt for every handshake, which has to happen in JS */
+                builder.params.websocket_signing_config = undefined;
+                builder.params.websocket_handshake_transform = async (request, done) => {
+                    try {
+                        await aws_sign_request(request, create_signing_config() as AwsSigningConfig);
+                        done();
+                    } catch (error) {
+                        if (error instanceof CrtError) {
+                            done(error.error_code);
+                        } else {
+                            done(3); /* TODO: AWS_ERROR_UNKNOWN */
+                        }
+                    }
+                };
+            } else {
+                builder.params.websocket_handshake_transform = undefined;
+                builder.params.websocket_signing_config = {
                     algorithm: AwsSigningAlgorithm.SigV4,
                     signature_type: AwsSignatureType.HttpRequestViaQueryParams,
                     provider: options.credentials_provider,
@@ -195,18 +211,7 @@ export class AwsIotMqttConnectionConfigBuilder {
                     signed_body_value: AwsSignedBodyValue.EmptySha256,
                     omit_session_token: true,
                 };
-
-                try {
-                    await aws_sign_request(request, signing_config as AwsSigningConfig);
-                    done();
-                } catch (error) {
-                    if (error instanceof CrtError) {
-                        done(error.error_code);
-                    } else {
-                        done(3); /* TODO: AWS_ERROR_UNKNOWN */
-                    }
-                }
-            };
+            }
         }
 
         return builder;
@@ -12,7 +12,6 @@
 import * as mqtt5 from "./mqtt5";
 import * as io from "./io";
 import * as auth from "./auth";
-import {CrtError} from "./error";
 import * as iot_shared from "../common/aws_iot_shared";
 import * as http from "./http";
 import * as mqtt_shared from "../common/mqtt_shared";
@@ -220,27 +219,14 @@ export class AwsIotMqtt5ClientConfigBuilder {
             credentialsProvider = auth.AwsCredentialsProvider.newDefault();
         }
 
-        builder.config.websocketHandshakeTransform = async (request, done) => {
-            try {
-                const signingConfig : auth.AwsSigningConfig = {
-                    algorithm: auth.AwsSigningAlgorithm.SigV4,
-                    signature_type: auth.AwsSignatureType.HttpRequestViaQueryParams,
-                    provider: credentialsProvider as auth.AwsCredentialsProvider,
-                    region: options?.region ?? iot_shared.extractRegionFromEndpoint(hostName),
-                    service: "iotdevicegateway",
-                    signed_body_value: auth.AwsSignedBodyValue.EmptySha256,
-                    omit_session_token: true,
-                };
-
-                await auth.aws_sign_request(request, signingConfig);
-                done();
-            } catch (error) {
-                if (error instanceof CrtError) {
-                    done(error.error_code);
-                } else {
-                    done(3); /* TODO: AWS_ERROR_UNKNOWN */
-                }
-            }
+        builder.config.websocketSigningConfig = {
+            algorithm: auth.AwsSigningAlgorithm.SigV4,
+            signature_type: auth.AwsSignatureType.HttpRequestViaQueryParams,
+            provider: credentialsProvider,
+            region: options?.region ?? iot_shared.extractRegionFromEndpoint(hostName),
+            service: "iotdevicegateway",
+            signed_body_value: auth.AwsSignedBodyValue.EmptySha256,
+            omit_session_token: true,
         };
 
         return builder;
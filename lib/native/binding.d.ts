@@ -14,11 +14,12 @@ import { InputStream, TlsContextOptions } from "./io";
 import {AwsSigningConfig, CognitoCredentialsProviderConfig, X509CredentialsConfig} from "./auth";
 import { HttpHeader, HttpHeaders as CommonHttpHeaders } from "../common/http";
 import { OnMessageCallback, QoS } from "../common/mqtt";
-import { Mqtt5ClientConfig, Mqtt5Client, ClientStatistics, NegotiatedSettings } from "./mqtt5";
+import { Mqtt5ClientConfig, Mqtt5Client, ClientStatistics, NegotiatedSettings, PublishOptions } from "./mqtt5";
 import * as mqtt5_packet from "../common/mqtt5_packet";
-import { PublishCompletionResult } from "../common/mqtt5";
+import { JsonParseError, PublishCompletionResult } from "../common/mqtt5";
 import * as eventstream from "./eventstream";
-import { ConnectionStatistics } from "./mqtt";
+import { ConnectionStatistics, NativeMessageBatch } from "./mqtt";
+import { LastValue, LastValueCacheOptions, MessageFilterRule } from "../common/mqtt_shared";
 
 
 /**
@@ -51,7 +52,7 @@ export function io_logging_enable(log_level: number): void;
 export function is_alpn_available(): boolean;
 /* wraps aws_client_bootstrap #TODO: Wrap with ClassBinder */
 /** @internal */
-export function io_client_bootstrap_new(): NativeHandle;
+export function io_client_bootstrap_new(event_loop_thread_count?: number): NativeHandle;
 /* wraps aws_tls_context #TODO: Wrap with ClassBinder */
 /** @internal */
 export function io_tls_ctx_new(
@@ -156,11 +157,13 @@ export function mqtt5_client_new(
     on_connection_success_handler: (client: Mqtt5Client, connack: mqtt5_packet.ConnackPacket, settings: NegotiatedSettings) => void,
     on_connection_failure_handler: (client: Mqtt5Client, errorCode: number, connack?: mqtt5_packet.ConnackPacket) => void,
     on_disconnection_handler: (client: Mqtt5Client, errorCode: number, disconnect?: mqtt5_packet.DisconnectPacket) => void,
-    on_message_received_handler: (client: Mqtt5Client, message: mqtt5_packet.PublishPacket) => void,
+    on_message_received_handler: (client: Mqtt5Client, message: mqtt5_packet.PublishPacket | ArrayBuffer, record_length?: number, payload?: mqtt5_packet.Payload, json?: ArrayBuffer | JsonParseError) => void,
     client_bootstrap?: NativeHandle,
     socket_options?: NativeHandle,
     tls_ctx?: NativeHandle,
     proxy_options?: NativeHandle,
+    message_ring?: Uint8Array | null,
+    on_message_ring_ready_handler?: (client: Mqtt5Client) => void,
 ): NativeHandle;
 
 /** @internal */
@@ -176,11 +179,50 @@ export function mqtt5_client_subscribe(client: NativeHandle, subscribe_packet: m
 export function mqtt5_client_unsubscribe(client: NativeHandle, unsubscribe_packet: mqtt5_packet.UnsubscribePacket, on_resolution: (client: Mqtt5Client, errorCode: number, unsuback?: mqtt5_packet.UnsubackPacket) => void) : void;
 
 /** @internal */
-export function mqtt5_client_publish(client: NativeHandle, publish_packet: mqtt5_packet.PublishPacket, on_resolution: (client: Mqtt5Client, errorCode: number, result: PublishCompletionResult) => void) : void;
+export function mqtt5_client_publish(client: NativeHandle, publish_packet: mqtt5_packet.PublishPacket, options: PublishOptions | undefined, on_resolution: (client: Mqtt5Client, errorCode: number, result: PublishCompletionResult) => void) : void;
+
+/** @internal */
+export function mqtt5_client_prepare_publish(client: NativeHandle, publish_packet: mqtt5_packet.PublishPacket) : NativeHandle;
+
+/** @internal */
+export function mqtt5_client_publish_prepared(client: NativeHandle, prepared_publish: NativeHandle, payload: StringLike | null, options: PublishOptions | undefined, on_resolution: (client: Mqtt5Client, errorCode: number, result: PublishCompletionResult) => void) : void;
 
 /** @internal */
 export function mqtt5_client_get_queue_statistics(client: NativeHandle) : ClientStatistics;
 
+/** @internal */
+export function mqtt5_client_enable_request_response(client: NativeHandle, on_response_received_handler: (client: Mqtt5Client, request_id: number, topic: string, payload: ArrayBuffer) => void) : void;
+
+/** @internal */
+export function mqtt5_client_disable_request_response(client: NativeHandle) : void;
+
+/** @internal */
+export function mqtt5_client_add_response_filter(client: NativeHandle, topic_filter: string) : void;
+
+/** @internal */
+export function mqtt5_client_remove_response_filter(client: NativeHandle, topic_filter: string) : void;
+
+/** @internal */
+export function mqtt5_client_add_pending_request(client: NativeHandle, request_id: number, response_topics: Array<string>, correlation_data: StringLike | null) : void;
+
+/** @internal */
+export function mqtt5_client_remove_pending_request(client: NativeHandle, request_id: number) : boolean;
+
+/** @internal */
+export function mqtt5_client_set_message_filter(client: NativeHandle, rules: Array<MessageFilterRule> | null) : void;
+
+/** @internal */
+export function mqtt5_client_set_last_value_cache(client: NativeHandle, options: LastValueCacheOptions | null) : void;
+
+/** @internal */
+export function mqtt5_client_get_last_value(client: NativeHandle, topic: string) : LastValue | undefined;
+
+/** @internal */
+export function mqtt5_client_get_last_value_snapshot(client: NativeHandle, topic_prefix: string) : Array<LastValue>;
+
+/** @internal */
+export function mqtt5_client_set_live_statistics(client: NativeHandle, memory: Uint8Array) : void;
+
 /** @internal */
 export function mqtt5_client_close(client: NativeHandle) : void;
 
@@ -208,6 +250,8 @@ export function mqtt_client_connection_new(
     websocket_handshake_transform?: (request: HttpRequest, done: (error_code?: number) => void) => void,
     reconnect_min_sec?: number,
     reconnect_max_sec?: number,
+    websocket_signing_config?: AwsSigningConfig,
+    topic_intern_cache_size?: number,
 ): NativeHandle;
 
 /** @internal */
@@ -237,15 +281,29 @@ export function mqtt_client_connection_publish(
     on_publish?: (packet_id: number, error_code: number) => void,
 ): void;
 
+/** @internal */
+export function mqtt_client_connection_publish_many(
+    connection: NativeHandle,
+    messages: (StringLike | number)[],
+    on_complete?: (results: number[]) => void,
+): void;
+
 /** @internal */
 export function mqtt_client_connection_subscribe(
     connection: NativeHandle,
     topic: StringLike,
     qos: number,
-    on_publish?: OnMessageCallback,
+    on_publish?: (batch: NativeMessageBatch) => void,
     on_suback?: (packet_id: number, topic: string, qos: QoS, error_code: number) => void,
 ): void;
 
+/** @internal */
+export function mqtt_client_connection_subscribe_multiple(
+    connection: NativeHandle,
+    subscriptions: { topic: StringLike, qos: number, handler?: (batch: NativeMessageBatch) => void }[],
+    on_suback?: (packet_id: number, results: { topic: string, qos: number }[], error_code: number) => void,
+): void;
+
 /** @internal */
 export function mqtt_client_connection_on_message(
     connection: NativeHandle,
@@ -274,6 +332,12 @@ export function mqtt_client_connection_close(connection: NativeHandle): void;
 /** @internal */
 export function mqtt_client_connection_get_queue_statistics(connection: NativeHandle) : ConnectionStatistics;
 
+/** @internal */
+export function mqtt_client_connection_set_message_filter(connection: NativeHandle, rules: Array<MessageFilterRule> | null) : void;
+
+/** @internal */
+export function mqtt_client_connection_set_live_statistics(connection: NativeHandle, memory: Uint8Array) : void;
+
 /* HTTP */
 /* wraps aws_http_proxy_options #TODO: Wrap with ClassBinder */
 /** @internal */
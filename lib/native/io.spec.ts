@@ -21,6 +21,11 @@ test('ALPN availability', () => {
     expect(io.is_alpn_available()).toBeDefined();
 });
 
+test('Client bootstrap - event loop thread count out of range', () => {
+    expect(() => { new io.ClientBootstrap(65536); }).toThrow();
+    expect(() => { new io.ClientBootstrap(-1); }).toThrow();
+});
+
 const PKCS11_LIB_PATH = process.env.AWS_TEST_PKCS11_LIB ?? "";
 /**
  * Skip test if cruntime is Musl. Softhsm library crashes on Alpine if we don't use AWS_PKCS11_LIB_STRICT_INITIALIZE_FINALIZE.
@@ -128,8 +128,13 @@ export class InputStream extends NativeResource {
  * @category IO
  */
 export class ClientBootstrap extends NativeResource {
-    constructor() {
-        super(crt_native.io_client_bootstrap_new());
+    /**
+     * @param eventLoopThreadCount if set, the bootstrap runs its connections on this many dedicated event loop
+     * threads (at most 65535) rather than the event loop shared by the rest of the process.  Each new connection goes
+     * to the less loaded of two of those threads picked at random, so connections are not necessarily spread evenly.
+     */
+    constructor(eventLoopThreadCount?: number) {
+        super(crt_native.io_client_bootstrap_new(eventLoopThreadCount));
     }
 }
 
@@ -0,0 +1,108 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0.
+ */
+
+/**
+ * Slots of the shared counter array; must match aws_napi_live_statistic in live_statistics.h
+ *
+ * @group Node-only
+ */
+export enum LiveStatisticsCounter {
+    IncompleteOperationCount = 0,
+    IncompleteOperationSize = 1,
+    UnackedOperationCount = 2,
+    UnackedOperationSize = 3,
+    PublishesSent = 4,
+    PublishBytesSent = 5,
+    PublishesFailed = 6,
+    PublishesReceived = 7,
+    PublishBytesReceived = 8,
+    ConnectionSuccesses = 9,
+    ConnectionFailures = 10,
+    ConnectionDrops = 11,
+    Reconnects = 12,
+}
+
+/* AWS_NAPI_LIVE_STATISTICS_SLOT_COUNT in live_statistics.h; slots past the last counter are reserved */
+const LIVE_STATISTICS_SLOT_COUNT : number = 16;
+
+/* The BigUint64Array overloads of Atomics are declared in a newer lib than the one this package compiles against */
+const atomicsLoad = Atomics.load as unknown as (typedArray: BigUint64Array, index: number) => bigint;
+
+/**
+ * Client counters that native code updates in place as events happen, so they can be read at any rate without
+ * calling into native code or allocating a statistics object.  Counts start from when live statistics were
+ * enabled on the client; enable them before connecting to cover the client's whole lifetime.
+ *
+ * Operation counts and sizes are gauges refreshed whenever the client sends or completes a publish, subscribe or
+ * unsubscribe, or changes connection state.  Every other counter only increases.
+ *
+ * @group Node-only
+ */
+export class LiveStatistics {
+
+    /**
+     * The memory native code writes into.  Can be handed to worker threads, which can wrap it in their own
+     * LiveStatistics or read {@link counters} directly with Atomics.
+     */
+    readonly memory : SharedArrayBuffer;
+
+    /**
+     * The raw counters, indexed by {@link LiveStatisticsCounter}
+     */
+    readonly counters : BigUint64Array;
+
+    constructor(memory?: SharedArrayBuffer) {
+        this.memory = memory ?? new SharedArrayBuffer(LIVE_STATISTICS_SLOT_COUNT * 8);
+        this.counters = new BigUint64Array(this.memory, 0, LIVE_STATISTICS_SLOT_COUNT);
+    }
+
+    /**
+     * Reads a single counter
+     *
+     * @param counter counter to read
+     */
+    get(counter: LiveStatisticsCounter) : number {
+        return Number(atomicsLoad(this.counters, counter));
+    }
+
+    /** Operations submitted to the client that have not yet completed */
+    get incompleteOperationCount() : number { return this.get(LiveStatisticsCounter.IncompleteOperationCount); }
+
+    /** Total packet size of operations submitted to the client that have not yet completed */
+    get incompleteOperationSize() : number { return this.get(LiveStatisticsCounter.IncompleteOperationSize); }
+
+    /** Operations sent to the server that are waiting for an acknowledgement */
+    get unackedOperationCount() : number { return this.get(LiveStatisticsCounter.UnackedOperationCount); }
+
+    /** Total packet size of operations sent to the server that are waiting for an acknowledgement */
+    get unackedOperationSize() : number { return this.get(LiveStatisticsCounter.UnackedOperationSize); }
+
+    /** Publishes that completed successfully */
+    get publishesSent() : number { return this.get(LiveStatisticsCounter.PublishesSent); }
+
+    /** Total payload bytes of publishes that completed successfully */
+    get publishBytesSent() : number { return this.get(LiveStatisticsCounter.PublishBytesSent); }
+
+    /** Publishes that completed with an error */
+    get publishesFailed() : number { return this.get(LiveStatisticsCounter.PublishesFailed); }
+
+    /** Publishes received from the server, whether or not they were then filtered or delivered */
+    get publishesReceived() : number { return this.get(LiveStatisticsCounter.PublishesReceived); }
+
+    /** Total payload bytes of publishes received from the server */
+    get publishBytesReceived() : number { return this.get(LiveStatisticsCounter.PublishBytesReceived); }
+
+    /** Successful connections, including reconnects */
+    get connectionSuccesses() : number { return this.get(LiveStatisticsCounter.ConnectionSuccesses); }
+
+    /** Connection attempts that failed */
+    get connectionFailures() : number { return this.get(LiveStatisticsCounter.ConnectionFailures); }
+
+    /** Established connections that were lost or closed */
+    get connectionDrops() : number { return this.get(LiveStatisticsCounter.ConnectionDrops); }
+
+    /** Successful connections after the first */
+    get reconnects() : number { return this.get(LiveStatisticsCounter.Reconnects); }
+}
@@ -5,12 +5,13 @@
 
 import * as test_env from "@test/test_env"
 import { ClientBootstrap, TlsContextOptions, ClientTlsContext, SocketOptions } from './io';
-import { MqttClient, MqttConnectionConfig, QoS } from './mqtt';
+import { MqttClient, MqttClientConnection, MqttConnectionConfig, QoS, ReceivedMessage } from './mqtt';
 import { v4 as uuid } from 'uuid';
 import { OnConnectionSuccessResult, OnConnectionClosedResult } from '../common/mqtt';
 import {HttpProxyOptions, HttpProxyAuthenticationType, HttpProxyConnectionType} from "./http"
 import { AwsIotMqttConnectionConfigBuilder } from './aws_iot';
 import {once} from "events";
+import { LocalMqttBroker } from "@test/mqtt_broker";
 
 jest.setTimeout(10000);
 
@@ -385,3 +386,359 @@ test_env.conditional_test(test_env.AWS_IOT_ENV.mqtt311_is_valid_iot_cred())('MQT
     });
     await expect(promise).resolves.toBeTruthy();
 });
+
+function make_local_broker_connection(broker: LocalMqttBroker, config?: Partial<MqttConnectionConfig>) : MqttClientConnection {
+    const client = new MqttClient(new ClientBootstrap());
+    return client.new_connection({
+        client_id: `local-${uuid()}`,
+        host_name: "127.0.0.1",
+        port: broker.port,
+        clean_session: true,
+        socket_options: new SocketOptions(),
+        ...config
+    });
+}
+
+test('MQTT311 local broker - wildcard subscribe and publish', async () => {
+    const broker = new LocalMqttBroker();
+    await broker.start();
+
+    const connection = make_local_broker_connection(broker);
+
+    await connection.connect();
+
+    let on_message: (topic: string) => void = () => {};
+    const received = new Promise<string>((resolve) => { on_message = resolve; });
+    await connection.subscribe("local/+/status", QoS.AtLeastOnce, (topic) => { on_message(topic); });
+
+    const test_topic = `local/${uuid()}/status`;
+    await connection.publish(test_topic, "online", QoS.AtLeastOnce);
+    await expect(received).resolves.toEqual(test_topic);
+
+    await connection.disconnect();
+    await broker.stop();
+});
+
+test('MQTT311 local broker - handlers share one payload', async () => {
+    const broker = new LocalMqttBroker();
+    await broker.start();
+
+    const connection = make_local_broker_connection(broker);
+
+    await connection.connect();
+
+    /* one subscription callback per overlapping subscription, plus on_message, all over the same payload */
+    const received: Array<string> = [];
+    let on_all_received: () => void = () => {};
+    const all_received = new Promise<void>((resolve) => { on_all_received = resolve; });
+    const handler = (topic: string, payload: ArrayBuffer) => {
+        const bytes = new Uint8Array(payload);
+        received.push(Buffer.from(bytes).toString());
+        if (received.length == 3) {
+            on_all_received();
+        }
+    };
+
+    await connection.subscribe("shared/payload", QoS.AtLeastOnce, handler);
+    await connection.subscribe("shared/+", QoS.AtLeastOnce, handler);
+    connection.on('message', handler);
+
+    await connection.publish("shared/payload", "intact", QoS.AtLeastOnce);
+    await all_received;
+
+    expect(received).toEqual(["intact", "intact", "intact"]);
+
+    await connection.disconnect();
+    await broker.stop();
+});
+
+test('MQTT311 local broker - message filter', async () => {
+    const broker = new LocalMqttBroker();
+    await broker.start();
+
+    const connection = make_local_broker_connection(broker);
+
+    await connection.connect();
+
+    connection.setMessageFilter([
+        { topicFilter: "filter/drop/#", drop: true },
+        { topicFilter: "filter/sample", sampleEvery: 3 }
+    ]);
+
+    const received: Array<string> = [];
+    let on_done: () => void = () => {};
+    const done = new Promise<void>((resolve) => { on_done = resolve; });
+    await connection.subscribe("filter/#", QoS.AtLeastOnce, (topic, payload) => {
+        if (topic == "filter/done") {
+            on_done();
+        } else {
+            received.push(`${topic}:${Buffer.from(payload).toString()}`);
+        }
+    });
+
+    /* overlapping subscriptions and the message event see the same sample, and don't advance sampling themselves */
+    const receivedOverlapping: Array<string> = [];
+    await connection.subscribe("filter/sample", QoS.AtLeastOnce, (topic, payload) => {
+        receivedOverlapping.push(Buffer.from(payload).toString());
+    });
+    const receivedAny: Array<string> = [];
+    connection.on('message', (topic, payload) => {
+        if (topic == "filter/sample") {
+            receivedAny.push(Buffer.from(payload).toString());
+        }
+    });
+
+    for (let i = 0; i < 6; i++) {
+        await connection.publish("filter/sample", `${i}`, QoS.AtLeastOnce);
+    }
+    await connection.publish("filter/drop/me", "x", QoS.AtLeastOnce);
+    await connection.publish("filter/keep", "y", QoS.AtLeastOnce);
+    await connection.publish("filter/done", "", QoS.AtLeastOnce);
+    await done;
+
+    expect(received).toEqual(["filter/sample:0", "filter/sample:3", "filter/keep:y"]);
+    expect(receivedOverlapping).toEqual(["0", "3"]);
+    expect(receivedAny).toEqual(["0", "3"]);
+
+    const statistics = connection.getOperationalStatistics();
+    expect(statistics.filteredMessageCount).toEqual(1);
+    expect(statistics.sampledOutMessageCount).toEqual(4);
+    expect(statistics.rateLimitedMessageCount).toEqual(0);
+
+    await connection.disconnect();
+    await broker.stop();
+});
+
+test('MQTT311 local broker - live statistics', async () => {
+    const broker = new LocalMqttBroker();
+    await broker.start();
+
+    const connection = make_local_broker_connection(broker);
+
+    const statistics = connection.enableLiveStatistics();
+    expect(connection.enableLiveStatistics()).toBe(statistics);
+
+    await connection.connect();
+    expect(statistics.connectionSuccesses).toEqual(1);
+    expect(statistics.reconnects).toEqual(0);
+
+    let received = 0;
+    let on_done: () => void = () => {};
+    const done = new Promise<void>((resolve) => { on_done = resolve; });
+    await connection.subscribe("live/#", QoS.AtLeastOnce, () => {
+        if (++received == 3) {
+            on_done();
+        }
+    });
+
+    for (let i = 0; i < 3; i++) {
+        await connection.publish("live/stats", "12345", QoS.AtLeastOnce);
+    }
+    await done;
+
+    expect(statistics.publishesSent).toEqual(3);
+    expect(statistics.publishBytesSent).toEqual(15);
+    expect(statistics.publishesFailed).toEqual(0);
+    expect(statistics.publishesReceived).toEqual(3);
+    expect(statistics.publishBytesReceived).toEqual(15);
+
+    await connection.disconnect();
+    await broker.stop();
+});
+
+test('MQTT311 local broker - batched subscription delivery', async () => {
+    const broker = new LocalMqttBroker();
+    await broker.start();
+
+    const connection = make_local_broker_connection(broker);
+
+    await connection.connect();
+
+    const message_count = 50;
+    let batched: ReceivedMessage[] = [];
+    let single: string[] = [];
+    let on_done: () => void = () => {};
+    const done = new Promise<void>((resolve) => { on_done = resolve; });
+    const check_done = () => {
+        if (batched.length == message_count && single.length == message_count) {
+            on_done();
+        }
+    };
+
+    await connection.subscribe_batched("batch/#", QoS.AtLeastOnce, (messages) => {
+        expect(messages.length).toBeGreaterThan(0);
+        batched.push(...messages);
+        check_done();
+    });
+    await connection.subscribe("batch/+", QoS.AtLeastOnce, (topic, payload, dup, qos, retain) => {
+        expect(dup).toEqual(false);
+        expect(retain).toEqual(false);
+        single.push(new TextDecoder().decode(payload));
+        check_done();
+    });
+
+    let publishes = [];
+    for (let i = 0; i < message_count; i++) {
+        publishes.push(connection.publish("batch/test", `${i}`, QoS.AtLeastOnce));
+    }
+    await Promise.all(publishes);
+    await done;
+
+    for (let i = 0; i < message_count; i++) {
+        expect(batched[i].topic).toEqual("batch/test");
+        expect(batched[i].qos).toEqual(QoS.AtLeastOnce);
+        expect(new TextDecoder().decode(batched[i].payload)).toEqual(`${i}`);
+        expect(single[i]).toEqual(`${i}`);
+    }
+
+    await connection.disconnect();
+    await broker.stop();
+});
+
+test('MQTT311 local broker - subscribe multiple', async () => {
+    const broker = new LocalMqttBroker();
+    await broker.start();
+
+    const connection = make_local_broker_connection(broker);
+
+    await connection.connect();
+
+    const topics = ["multi/a", "multi/b", "multi/c"];
+    let received = new Map<string, string>();
+    let on_done: () => void = () => {};
+    const done = new Promise<void>((resolve) => { on_done = resolve; });
+
+    const subscriptions = topics.map((topic) => {
+        return {
+            topic: topic,
+            qos: QoS.AtLeastOnce,
+            on_message: (message_topic: string, payload: ArrayBuffer) => {
+                expect(message_topic).toEqual(topic);
+                received.set(topic, new TextDecoder().decode(payload));
+                if (received.size == topics.length) {
+                    on_done();
+                }
+            }
+        };
+    });
+
+    const single_packet = await connection.subscribe_multiple(subscriptions.slice(0, 1));
+    expect(single_packet.packet_ids.length).toEqual(1);
+    await connection.unsubscribe(topics[0]);
+
+    const suback = await connection.subscribe_multiple(subscriptions, { max_topics_per_packet: 2 });
+    expect(suback.packet_ids.length).toEqual(2);
+    expect(suback.results.map((result) => result.topic)).toEqual(topics);
+    for (const result of suback.results) {
+        expect(result.qos).toEqual(QoS.AtLeastOnce);
+    }
+
+    for (const topic of topics) {
+        await connection.publish(topic, `payload for ${topic}`, QoS.AtLeastOnce);
+    }
+    await done;
+
+    for (const topic of topics) {
+        expect(received.get(topic)).toEqual(`payload for ${topic}`);
+    }
+
+    await expect(connection.subscribe_multiple([])).rejects.toBeDefined();
+
+    /* the second packet fails, so the first packet's subscription must be undone */
+    connection.on('error', () => {});
+    let partial_received = false;
+    await expect(connection.subscribe_multiple([
+        { topic: "partial/ok", qos: QoS.AtLeastOnce, on_message: () => { partial_received = true; } },
+        { topic: "partial/#/invalid", qos: QoS.AtLeastOnce }
+    ], { max_topics_per_packet: 1 })).rejects.toBeDefined();
+
+    await connection.publish("partial/ok", "unexpected", QoS.AtLeastOnce);
+    await new Promise(resolve => setTimeout(resolve, 500));
+    expect(partial_received).toEqual(false);
+
+    await connection.disconnect();
+    await broker.stop();
+});
+
+test('MQTT311 local broker - publish many and fire and forget', async () => {
+    const broker = new LocalMqttBroker();
+    await broker.start();
+
+    const connection = make_local_broker_connection(broker);
+
+    await connection.connect();
+
+    const message_count = 20;
+    let received: string[] = [];
+    let on_done: () => void = () => {};
+    const done = new Promise<void>((resolve) => { on_done = resolve; });
+
+    await connection.subscribe("many/#", QoS.AtLeastOnce, (topic, payload) => {
+        received.push(new TextDecoder().decode(payload));
+        if (received.length == message_count + 1) {
+            on_done();
+        }
+    });
+
+    let messages = [];
+    for (let i = 0; i < message_count; i++) {
+        messages.push({
+            topic: `many/${i}`,
+            payload: i % 2 == 0 ? `${i}` : Buffer.from(`${i}`),
+            qos: i % 2 == 0 ? QoS.AtLeastOnce : QoS.AtMostOnce,
+        });
+    }
+
+    const results = await connection.publish_many(messages);
+    expect(results.length).toEqual(message_count);
+    for (const result of results) {
+        expect(result.error_code).toEqual(0);
+    }
+
+    connection.publish_fire_and_forget("many/last", "last");
+    await done;
+
+    for (let i = 0; i < message_count; i++) {
+        expect(received).toContain(`${i}`);
+    }
+    expect(received).toContain("last");
+
+    expect(await connection.publish_many([])).toEqual([]);
+    await expect(connection.publish_many([{ topic: "many/bad", payload: "bad", qos: 4 as QoS }])).rejects.toBeDefined();
+    await expect(connection.publish_many([{ topic: "many/bad", payload: "bad", qos: 0.5 as QoS }])).rejects.toBeDefined();
+    expect(() => connection.publish_fire_and_forget(5 as any, "bad")).toThrow();
+
+    await connection.disconnect();
+    await broker.stop();
+});
+
+test('MQTT311 local broker - topic intern cache eviction', async () => {
+    const broker = new LocalMqttBroker();
+    await broker.start();
+
+    const connection = make_local_broker_connection(broker, { topic_intern_cache_size: 2 });
+
+    await connection.connect();
+
+    /* three topics through a two topic cache, so every kind of lookup happens: hit, miss, and miss with eviction */
+    const topics = ["intern/a", "intern/b", "intern/a", "intern/c", "intern/b", "intern/a", "intern/a"];
+    let received: string[] = [];
+    let on_done: () => void = () => {};
+    const done = new Promise<void>((resolve) => { on_done = resolve; });
+    await connection.subscribe("intern/+", QoS.AtLeastOnce, (topic, payload) => {
+        received.push(`${topic}=${new TextDecoder().decode(payload)}`);
+        if (received.length == topics.length) {
+            on_done();
+        }
+    });
+
+    for (let i = 0; i < topics.length; i++) {
+        await connection.publish(topics[i], `${i}`, QoS.AtLeastOnce);
+    }
+    await done;
+
+    expect(received).toEqual(topics.map((topic, i) => `${topic}=${i}`));
+
+    await connection.disconnect();
+    await broker.stop();
+});
@@ -17,9 +17,13 @@ import { NativeResource, NativeResourceMixin } from "./native_resource";
 import { BufferedEventEmitter } from '../common/event';
 import * as crt from "../common/mqtt_shared";
 import { CrtError } from './error';
+import { LiveStatistics } from './live_statistics';
 import * as io from "./io";
 import { HttpProxyOptions, HttpRequest } from './http';
+import { AwsSigningConfig } from './auth';
 export { HttpProxyOptions } from './http';
+export { MessageFilterRule } from '../common/mqtt_shared';
+export { LiveStatistics, LiveStatisticsCounter } from './live_statistics';
 import {
     QoS,
     Payload,
@@ -223,6 +227,20 @@ export interface MqttConnectionConfig {
      * The function may modify the HTTP request before it is sent to the server.
      */
     websocket_handshake_transform?: (request: HttpRequest, done: (error_code?: number) => void) => void;
+
+    /**
+     * Optional signing configuration used to sign the websocket handshake request natively, each time a websocket
+     * connection is attempted, without calling back into JavaScript.  The date in the configuration is ignored;
+     * every handshake is signed as of the time it is made.  Cannot be combined with websocket_handshake_transform.
+     */
+    websocket_signing_config?: AwsSigningConfig;
+
+    /**
+     * Number of distinct received topics whose strings the connection keeps, least recently used first out, so that
+     * messages on a recurring topic share a single string rather than allocating a new one each time.  Worthwhile
+     * when a bounded set of topics carries most traffic.  If undefined or 0, every message gets a new topic string.
+     */
+    topic_intern_cache_size?: number;
 }
 
 /**
@@ -253,8 +271,198 @@ export interface ConnectionStatistics {
      * they can be completed.
      */
     unackedOperationSize: number;
+
+    /**
+     * Total number of received messages dropped by a
+     * {@link MqttClientConnection.setMessageFilter message filter} rule's predicates.  Only present once a message
+     * filter has been set.
+     */
+    filteredMessageCount?: number;
+
+    /**
+     * Total number of received messages dropped by sampling.  Only present once a message filter has been
+     * set.
+     */
+    sampledOutMessageCount?: number;
+
+    /**
+     * Total number of received messages dropped by a rate limit.  Only present once a message filter has
+     * been set.
+     */
+    rateLimitedMessageCount?: number;
 };
 
+/**
+ * A message received on a subscription, as passed to an {@link OnMessageBatchCallback}
+ *
+ * @category MQTT
+ */
+export interface ReceivedMessage {
+
+    /** The topic the message was published to */
+    topic: string;
+
+    /**
+     * The payload data.  Every handler the message is delivered to receives a view of the same memory, so handlers
+     * should treat it as read-only.
+     */
+    payload: ArrayBuffer;
+
+    /** DUP flag.  If true, this might be re-delivery of an earlier attempt to send the message. */
+    dup: boolean;
+
+    /** Quality of Service used to deliver the message */
+    qos: QoS;
+
+    /** Retain flag.  If true, the message was sent as a result of a new subscription being made by the client. */
+    retain: boolean;
+}
+
+/**
+ * Function called with every message received on a subscription since the previous call, oldest first
+ *
+ * @category MQTT
+ */
+export type OnMessageBatchCallback = (messages: ReceivedMessage[]) => void;
+
+/**
+ * Messages as native code delivers them to subscription handlers: one (topic, payload, flags) triple per message
+ *
+ * @internal
+ */
+export type NativeMessageBatch = (string | ArrayBuffer | number)[];
+
+/* Layout of NativeMessageBatch; must match mqtt_client_connection.c */
+const BATCH_VALUES_PER_MESSAGE : number = 3;
+const BATCH_FLAG_DUP : number = 1;
+const BATCH_QOS_SHIFT : number = 1;
+const BATCH_QOS_MASK : number = 3;
+const BATCH_FLAG_RETAIN : number = 8;
+
+/*
+ * Adapts a per-message callback to the batches native code delivers.  A throwing callback must not cost the rest of
+ * the batch their delivery, so the first error is only rethrown once every message has been handed over.
+ */
+function to_batch_handler(on_message: OnMessageCallback) {
+    return (batch: NativeMessageBatch) => {
+        let first_error : any = undefined;
+        let has_error : boolean = false;
+        for (let i = 0; i < batch.length; i += BATCH_VALUES_PER_MESSAGE) {
+            const flags = batch[i + 2] as number;
+            try {
+                on_message(
+                    batch[i] as string,
+                    batch[i + 1] as ArrayBuffer,
+                    (flags & BATCH_FLAG_DUP) != 0,
+                    (flags >> BATCH_QOS_SHIFT) & BATCH_QOS_MASK,
+                    (flags & BATCH_FLAG_RETAIN) != 0);
+            } catch (e) {
+                if (!has_error) {
+                    first_error = e;
+                    has_error = true;
+                }
+            }
+        }
+
+        if (has_error) {
+            throw first_error;
+        }
+    };
+}
+
+/**
+ * One topic filter of a {@link MqttClientConnection.subscribe_multiple} call
+ *
+ * @category MQTT
+ */
+export interface MqttSubscription {
+
+    /** Topic filter to subscribe to, which may include wildcards */
+    topic: string;
+
+    /**
+     * Maximum requested QoS that server may use when sending messages to the client.
+     * The server may grant a lower QoS in the SUBACK
+     */
+    qos: QoS;
+
+    /** Optional callback invoked when a message matching this topic filter is received */
+    on_message?: OnMessageCallback;
+}
+
+/**
+ * Options for {@link MqttClientConnection.subscribe_multiple}
+ *
+ * @category MQTT
+ */
+export interface MqttSubscribeMultipleOptions {
+
+    /**
+     * Maximum number of topic filters to place in a single SUBSCRIBE packet.  Some servers (AWS IoT Core, for
+     * example) limit how many topic filters one SUBSCRIBE may carry.  Leave undefined to send every topic filter
+     * in one packet.
+     */
+    max_topics_per_packet?: number;
+}
+
+/**
+ * Result of a {@link MqttClientConnection.subscribe_multiple} call
+ *
+ * @category MQTT
+ */
+export interface MqttSubscribeMultipleRequest {
+
+    /** Packet ids of the SUBSCRIBE packets that were sent, in order */
+    packet_ids: number[];
+
+    /**
+     * One result per topic filter, in the order the subscriptions were given.  A qos of 128 (0x80) means the
+     * server rejected that topic filter.
+     */
+    results: MqttSubscribeRequest[];
+}
+
+/**
+ * One message of a {@link MqttClientConnection.publish_many} call
+ *
+ * @category MQTT
+ */
+export interface MqttPublishMessage {
+
+    /** Topic name */
+    topic: string;
+
+    /** Contents of message */
+    payload: Payload;
+
+    /** Quality of Service for delivering this message */
+    qos: QoS;
+
+    /**
+     * If true, the server will store the message and its QoS so that it can be delivered to future subscribers
+     * whose subscriptions match the topic name
+     */
+    retain?: boolean;
+}
+
+/**
+ * Outcome of one message of a {@link MqttClientConnection.publish_many} call
+ *
+ * @category MQTT
+ */
+export interface MqttPublishResult extends MqttRequest {
+
+    /** If the message could not be published, the error code.  Zero on success. */
+    error_code: number;
+}
+
+/**
+ * QoS reported in a SUBACK for a topic filter the server rejected
+ *
+ * @category MQTT
+ */
+export const SUBACK_FAILURE_QOS : number = 0x80;
+
 /**
  * MQTT client connection
  *
@@ -262,6 +470,7 @@ export interface ConnectionStatistics {
  */
 export class MqttClientConnection extends NativeResourceMixin(BufferedEventEmitter) {
     readonly tls_ctx?: io.ClientTlsContext; // this reference keeps the tls_ctx alive beyond the life of the connection
+    private live_statistics?: LiveStatistics;
 
     /**
      * @param client The client that owns this connection
@@ -321,6 +530,8 @@ export class MqttClientConnection extends NativeResourceMixin(BufferedEventEmitt
             config.websocket_handshake_transform,
             min_sec,
             max_sec,
+            config.websocket_signing_config,
+            config.topic_intern_cache_size,
         ));
         this.tls_ctx = config.tls_ctx;
         crt_native.mqtt_client_connection_on_message(this.native_handle(), this._on_any_publish.bind(this));
@@ -525,6 +736,88 @@ export class MqttClientConnection extends NativeResourceMixin(BufferedEventEmitt
         });
     }
 
+    /**
+     * Publish a QoS 0 message without tracking its completion.
+     *
+     * Unlike {@link publish}, nothing is set up to report the outcome, which makes this the cheapest way to send
+     * a message that may be lost anyway.  If the device is offline, the PUBLISH packet will be sent once the
+     * connection resumes.
+     *
+     * @param topic Topic name
+     * @param payload Contents of message.  Binary payloads are read in place rather than copied before being
+     *                handed to the connection, so they may be reused as soon as this returns.
+     * @param retain If true, the server will store the message so that it can be delivered to future subscribers
+     *               whose subscriptions match the topic name
+     */
+    publish_fire_and_forget(topic: string, payload: Payload, retain: boolean = false) {
+        if (typeof(topic) !== 'string') {
+            throw new CrtError("topic is not a string");
+        }
+        if (typeof(retain) !== 'boolean') {
+            throw new CrtError("retain is not a boolean");
+        }
+
+        crt_native.mqtt_client_connection_publish(this.native_handle(), topic, crt.normalize_payload(payload), QoS.AtMostOnce, retain, undefined);
+    }
+
+    /**
+     * Publish several messages (async).
+     *
+     * Every message is submitted with a single call into native code, and the returned Promise completes once, when
+     * every message has completed as described for {@link publish}.  A message that fails does not fail the others;
+     * its result carries a non-zero error_code instead.
+     *
+     * @param messages The messages to publish, in order
+     * @returns Promise which returns a {@link MqttPublishResult} for each message, in the order they were given.
+     */
+    async publish_many(messages: MqttPublishMessage[]) {
+        if (!Array.isArray(messages)) {
+            return Promise.reject("messages is not an array");
+        }
+
+        let native_messages : (string | Buffer | number)[] = new Array(messages.length * BATCH_VALUES_PER_MESSAGE);
+        for (let i = 0, j = 0; i < messages.length; ++i, j += BATCH_VALUES_PER_MESSAGE) {
+            const message = messages[i];
+            const retain = message.retain ?? false;
+            if (typeof(message.topic) !== 'string') {
+                return Promise.reject("topic is not a string");
+            }
+            if (typeof(message.qos) !== 'number') {
+                return Promise.reject("qos is not a number");
+            }
+            /* anything outside 0..2 would spill into the other packed flags */
+            if (!Number.isInteger(message.qos) || message.qos < QoS.AtMostOnce || message.qos > QoS.ExactlyOnce) {
+                return Promise.reject("qos is not a valid QoS");
+            }
+            if (typeof(retain) !== 'boolean') {
+                return Promise.reject("retain is not a boolean");
+            }
+
+            native_messages[j] = message.topic;
+            native_messages[j + 1] = crt.normalize_payload(message.payload);
+            native_messages[j + 2] = (message.qos << BATCH_QOS_SHIFT) | (retain ? BATCH_FLAG_RETAIN : 0);
+        }
+
+        if (messages.length == 0) {
+            return [] as MqttPublishResult[];
+        }
+
+        return new Promise<MqttPublishResult[]>((resolve, reject) => {
+            reject = this._reject(reject);
+            try {
+                crt_native.mqtt_client_connection_publish_many(this.native_handle(), native_messages, (results: number[]) => {
+                    let publish_results : MqttPublishResult[] = new Array(results.length / 2);
+                    for (let i = 0, j = 0; i < results.length; i += 2, ++j) {
+                        publish_results[j] = { packet_id: results[i], error_code: results[i + 1] };
+                    }
+                    resolve(publish_results);
+                });
+            } catch (e) {
+                reject(e);
+            }
+        });
+    }
+
     /**
      * Subscribe to a topic filter (async).
      * The client sends a SUBSCRIBE packet and the server responds with a SUBACK.
@@ -545,6 +838,45 @@ export class MqttClientConnection extends NativeResourceMixin(BufferedEventEmitt
      *          from the server or is rejected when an exception occurs.
      */
     async subscribe(topic: string, qos: QoS, on_message?: OnMessageCallback) {
+        return this._subscribe(topic, qos, on_message ? to_batch_handler(on_message) : undefined);
+    }
+
+    /**
+     * Subscribe to a topic filter (async), receiving messages in batches.
+     *
+     * Behaves like {@link subscribe}, except that `on_messages` is invoked once with every message that arrived for
+     * this subscription since its previous invocation, rather than once per message.  Under load this trades a
+     * little latency for far less per-message overhead.
+     *
+     * @param topic Subscribe to this topic filter, which may include wildcards
+     * @param qos Maximum requested QoS that server may use when sending messages to the client.
+     *            The server may grant a lower QoS in the SUBACK
+     * @param on_messages Callback invoked with the messages received since its previous invocation, oldest first
+     * @returns Promise which returns a {@link MqttSubscribeRequest} which will contain the
+     *          result of the SUBSCRIBE. The Promise resolves when a SUBACK is returned
+     *          from the server or is rejected when an exception occurs.
+     */
+    async subscribe_batched(topic: string, qos: QoS, on_messages: OnMessageBatchCallback) {
+        const on_batch = (batch: NativeMessageBatch) => {
+            let messages : ReceivedMessage[] = new Array(batch.length / BATCH_VALUES_PER_MESSAGE);
+            for (let i = 0, j = 0; i < batch.length; i += BATCH_VALUES_PER_MESSAGE, ++j) {
+                const flags = batch[i + 2] as number;
+                messages[j] = {
+                    topic: batch[i] as string,
+                    payload: batch[i + 1] as ArrayBuffer,
+                    dup: (flags & BATCH_FLAG_DUP) != 0,
+                    qos: (flags >> BATCH_QOS_SHIFT) & BATCH_QOS_MASK,
+                    retain: (flags & BATCH_FLAG_RETAIN) != 0,
+                };
+            }
+
+            on_messages(messages);
+        };
+
+        return this._subscribe(topic, qos, on_batch);
+    }
+
+    private _subscribe(topic: string, qos: QoS, on_batch?: (batch: NativeMessageBatch) => void) {
         if (typeof(topic) !== 'string') {
             return Promise.reject("topic is not a string");
         }
@@ -556,13 +888,89 @@ export class MqttClientConnection extends NativeResourceMixin(BufferedEventEmitt
             reject = this._reject(reject);
 
             try {
-                crt_native.mqtt_client_connection_subscribe(this.native_handle(), topic, qos, on_message, this._on_suback_callback.bind(this, resolve, reject));
+                crt_native.mqtt_client_connection_subscribe(this.native_handle(), topic, qos, on_batch, this._on_suback_callback.bind(this, resolve, reject));
             } catch (e) {
                 reject(e);
             }
         });
     }
 
+    /**
+     * Subscribe to several topic filters at once (async).
+     *
+     * The topic filters are sent in as few SUBSCRIBE packets as `options.max_topics_per_packet` allows, one packet
+     * by default, and the returned Promise completes once every packet has been acknowledged.  Each subscription's
+     * `on_message` behaves exactly as the `on_message` passed to {@link subscribe}.
+     *
+     * @param subscriptions The topic filters to subscribe to
+     * @param options Optional settings controlling how the subscriptions are packed into SUBSCRIBE packets
+     * @returns Promise which returns a {@link MqttSubscribeMultipleRequest} with the outcome of every topic filter.
+     *          The Promise resolves when every SUBACK has been returned from the server.  If any packet fails, the
+     *          topic filters of the packets that succeeded are unsubscribed again before the Promise is rejected
+     *          with that packet's error.
+     */
+    async subscribe_multiple(subscriptions: MqttSubscription[], options?: MqttSubscribeMultipleOptions) {
+        if (!Array.isArray(subscriptions) || subscriptions.length == 0) {
+            return Promise.reject("subscriptions is not a non-empty array");
+        }
+        for (const subscription of subscriptions) {
+            if (typeof(subscription.topic) !== 'string') {
+                return Promise.reject("topic is not a string");
+            }
+            if (typeof(subscription.qos) !== 'number') {
+                return Promise.reject("qos is not a number");
+            }
+        }
+
+        const max_topics_per_packet = options?.max_topics_per_packet ?? subscriptions.length;
+        if (!Number.isInteger(max_topics_per_packet) || max_topics_per_packet < 1) {
+            return Promise.reject("max_topics_per_packet is not a positive integer");
+        }
+
+        let packets: Promise<MqttSubscribeMultipleRequest>[] = [];
+        for (let i = 0; i < subscriptions.length; i += max_topics_per_packet) {
+            const native_subscriptions = subscriptions.slice(i, i + max_topics_per_packet).map((subscription) => {
+                return {
+                    topic: subscription.topic,
+                    qos: subscription.qos,
+                    handler: subscription.on_message ? to_batch_handler(subscription.on_message) : undefined,
+                };
+            });
+
+            packets.push(new Promise<MqttSubscribeMultipleRequest>((resolve, reject) => {
+                reject = this._reject(reject);
+
+                try {
+                    crt_native.mqtt_client_connection_subscribe_multiple(this.native_handle(), native_subscriptions, this._on_multi_suback_callback.bind(this, resolve, reject));
+                } catch (e) {
+                    reject(e);
+                }
+            }));
+        }
+
+        /* let every packet settle, so that a failure is only reported once the others are acknowledged */
+        const outcomes = await Promise.all(packets.map((packet) => packet.then(
+            (ack) => ({ ack: ack } as { ack?: MqttSubscribeMultipleRequest, error?: any }),
+            (error) => ({ error: error } as { ack?: MqttSubscribeMultipleRequest, error?: any }))));
+
+        const failure = outcomes.find((outcome) => outcome.ack === undefined);
+        if (failure !== undefined) {
+            /* don't leave the packets that did succeed subscribed behind a rejected promise */
+            const subscribed_topics = ([] as string[]).concat(...outcomes.map((outcome) => {
+                return outcome.ack ? outcome.ack.results.map((result) => result.topic) : [];
+            }));
+            await Promise.all(subscribed_topics.map((topic) => this.unsubscribe(topic).catch(() => {})));
+
+            throw failure.error;
+        }
+
+        const acks = outcomes.map((outcome) => outcome.ack as MqttSubscribeMultipleRequest);
+        return {
+            packet_ids: acks.map((ack) => ack.packet_ids[0]),
+            results: ([] as MqttSubscribeRequest[]).concat(...acks.map((ack) => ack.results)),
+        } as MqttSubscribeMultipleRequest;
+    }
+
     /**
      * Unsubscribe from a topic filter (async).
      * The client sends an UNSUBSCRIBE packet, and the server responds with an UNSUBACK.
@@ -609,6 +1017,42 @@ export class MqttClientConnection extends NativeResourceMixin(BufferedEventEmitt
         });
     }
 
+    /**
+     * Installs rules that drop or sample received messages natively, before they are copied for delivery to
+     * subscription handlers and the {@link MqttClientConnection.MESSAGE message} event.  Replaces any previous rules
+     * (along with their sampling and rate limit state); an empty or missing list removes filtering.  Dropped
+     * messages are counted in {@link getOperationalStatistics}.
+     *
+     * Each received message is evaluated once, however many subscriptions it matches, and is either delivered to all
+     * of its subscription handlers and the message event or to none of them.
+     *
+     * @param rules filter rules, evaluated in order
+     *
+     * @group Node-only
+     */
+    setMessageFilter(rules?: Array<crt.MessageFilterRule>) {
+        crt_native.mqtt_client_connection_set_message_filter(this.native_handle(), rules && rules.length > 0 ? rules : null);
+    }
+
+    /**
+     * Starts keeping counters of the connection's activity in shared memory that native code updates in place, so
+     * that they can be read at any rate without the cost of {@link getOperationalStatistics}.  Counting starts with
+     * the first call; later calls return the same counters.
+     *
+     * @returns the connection's live statistics
+     *
+     * @group Node-only
+     */
+    enableLiveStatistics(): LiveStatistics {
+        if (!this.live_statistics) {
+            const live_statistics = new LiveStatistics();
+            crt_native.mqtt_client_connection_set_live_statistics(this.native_handle(), new Uint8Array(live_statistics.memory));
+            this.live_statistics = live_statistics;
+        }
+
+        return this.live_statistics;
+    }
+
     /**
      * Queries a small set of numerical statistics about the current state of the connection's operation queue
      *
@@ -698,6 +1142,17 @@ export class MqttClientConnection extends NativeResourceMixin(BufferedEventEmitt
         }
     }
 
+    private _on_multi_suback_callback(resolve: (value: (MqttSubscribeMultipleRequest | PromiseLike<MqttSubscribeMultipleRequest>)) => void, reject: (reason?: any) => void, packet_id: number, results: { topic: string, qos: number }[], error_code: number) {
+        if (error_code == 0) {
+            resolve({
+                packet_ids: [packet_id],
+                results: results.map((result) => { return { packet_id, topic: result.topic, qos: result.qos }; }),
+            });
+        } else {
+            reject("Failed to subscribe: " + io.error_code_to_string(error_code));
+        }
+    }
+
     private _on_unsuback_callback(resolve: (value: (MqttRequest | PromiseLike<MqttRequest>)) => void, reject: (reason?: any) => void, packet_id: number, error_code: number) {
         if (error_code == 0) {
             resolve({ packet_id });
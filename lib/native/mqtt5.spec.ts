@@ -9,7 +9,12 @@ import {ClientBootstrap, ClientTlsContext, SocketDomain, SocketOptions, SocketTy
 import {HttpProxyAuthenticationType, HttpProxyConnectionType, HttpRequest} from "./http";
 import {v4 as uuid} from "uuid";
 import * as io from "./io";
+import * as auth from "./auth";
 import {once} from "events";
+import {LocalMqttBroker} from "@test/mqtt_broker";
+import * as fs from "fs";
+import * as os from "os";
+import * as path from "path";
 
 jest.setTimeout(10000);
 
@@ -400,6 +405,1532 @@ test('Client construction failure - bad config, will delay interval overflow', a
     testFailedClientConstruction(config);
 });
 
+test('Client construction failure - bad config, inbound flow control message count underflow', async () => {
+    let config : mqtt5.Mqtt5ClientConfig = getBaseConstructionFailureConfig();
+    config.inboundFlowControlOptions = {
+        maxPendingMessageCount: -1
+    };
+    testFailedClientConstruction(config);
+});
+
+test('Client construction failure - bad config, inbound flow control message size underflow', async () => {
+    let config : mqtt5.Mqtt5ClientConfig = getBaseConstructionFailureConfig();
+    config.inboundFlowControlOptions = {
+        maxPendingMessageSize: -1
+    };
+    testFailedClientConstruction(config);
+});
+
+test('Client construction failure - bad config, offline queue eviction policy out of range', async () => {
+    let config : mqtt5.Mqtt5ClientConfig = getBaseConstructionFailureConfig();
+    config.offlineQueueLimits = {
+        // @ts-ignore
+        evictionPolicy: 3
+    };
+    testFailedClientConstruction(config);
+});
+
+test('Offline queue limits - oldest publish evicted while not connected', async () => {
+    let client : mqtt5.Mqtt5Client = new mqtt5.Mqtt5Client({
+        hostName : "localhost",
+        port : 1883,
+        offlineQueueLimits: {
+            maxQueuedPublishCount: 1,
+            evictionPolicy: mqtt5.OfflineQueueEvictionPolicy.Oldest
+        }
+    });
+
+    let first = client.publish({ topicName: "offline/queue", qos: mqtt5.QoS.AtLeastOnce, payload: "first" });
+    let second = client.publish({ topicName: "offline/queue", qos: mqtt5.QoS.AtLeastOnce, payload: "second" });
+    second.catch(() => {});
+
+    await expect(first).rejects.toBeDefined();
+
+    let statistics : mqtt5.ClientStatistics = client.getOperationalStatistics();
+    expect(statistics.offlineQueuedPublishCount).toEqual(1);
+    expect(statistics.evictedPublishCount).toEqual(1);
+
+    client.close();
+});
+
+test('Offline queue limits - lowest priority publish evicted while not connected', async () => {
+    let client : mqtt5.Mqtt5Client = new mqtt5.Mqtt5Client({
+        hostName : "localhost",
+        port : 1883,
+        offlineQueueLimits: {
+            maxQueuedPublishCount: 1,
+            evictionPolicy: mqtt5.OfflineQueueEvictionPolicy.LowestPriorityFirst
+        }
+    });
+
+    let important = client.publish({ topicName: "offline/queue", qos: mqtt5.QoS.AtMostOnce, payload: "a" }, { priority: 5 });
+    important.catch(() => {});
+    let unimportant = client.publish({ topicName: "offline/queue", qos: mqtt5.QoS.AtMostOnce, payload: "b" }, { priority: 1 });
+
+    await expect(unimportant).rejects.toBeDefined();
+
+    let statistics : mqtt5.ClientStatistics = client.getOperationalStatistics();
+    expect(statistics.offlineQueuedPublishCount).toEqual(1);
+    expect(statistics.evictedPublishCount).toEqual(1);
+
+    client.close();
+});
+
+test('Outbound priority - publishes beyond the in-flight limit are queued by priority class', async () => {
+    let client : mqtt5.Mqtt5Client = new mqtt5.Mqtt5Client({
+        hostName : "localhost",
+        port : 1883,
+        outboundPriorityOptions: {
+            maxInFlightPublishes: 2
+        }
+    });
+
+    let publishes : Array<Promise<mqtt5.PublishCompletionResult>> = [];
+    for (let i = 0; i < 5; i++) {
+        publishes.push(client.publish({ topicName: "outbound/bulk", qos: mqtt5.QoS.AtMostOnce, payload: `${i}` }));
+    }
+    for (let i = 0; i < 2; i++) {
+        publishes.push(client.publish({ topicName: "outbound/alarm", qos: mqtt5.QoS.AtMostOnce, payload: `${i}` }, { priority: 7 }));
+    }
+    publishes.forEach((publish) => publish.catch(() => {}));
+
+    let statistics : mqtt5.ClientStatistics = client.getOperationalStatistics();
+    let classes : Array<mqtt5.OutboundPriorityStatistics> = statistics.outboundPriorityStatistics ?? [];
+    expect(classes.length).toEqual(mqtt5.MAX_PUBLISH_PRIORITY + 1);
+    expect(classes.map((publishClass) => publishClass.queuedCount)).toEqual([3, 0, 0, 2]);
+    expect(classes.map((publishClass) => publishClass.submittedCount)).toEqual([2, 0, 0, 0]);
+
+    client.close();
+
+    /* queued publishes are failed on close */
+    await expect(publishes[publishes.length - 1]).rejects.toBeDefined();
+});
+
+test('Outbound priority - offline publishes are bounded by the offline queue limits', async () => {
+    let client : mqtt5.Mqtt5Client = new mqtt5.Mqtt5Client({
+        hostName : "localhost",
+        port : 1883,
+        outboundPriorityOptions: {
+            maxInFlightPublishes: 1
+        },
+        offlineQueueLimits: {
+            maxQueuedPublishCount: 2,
+            evictionPolicy: mqtt5.OfflineQueueEvictionPolicy.Oldest
+        }
+    });
+
+    let publishes : Array<Promise<mqtt5.PublishCompletionResult>> = [];
+    for (let i = 0; i < 5; i++) {
+        publishes.push(client.publish({ topicName: "outbound/offline", qos: mqtt5.QoS.AtMostOnce, payload: `${i}` }, { priority: i % 2 }));
+    }
+    publishes.forEach((publish) => publish.catch(() => {}));
+
+    await expect(publishes[0]).rejects.toBeDefined();
+
+    let statistics : mqtt5.ClientStatistics = client.getOperationalStatistics();
+    expect(statistics.offlineQueuedPublishCount).toEqual(2);
+    expect(statistics.evictedPublishCount).toEqual(3);
+    expect((statistics.outboundPriorityStatistics ?? []).map((publishClass) => publishClass.queuedCount)).toEqual([0, 0, 0, 0]);
+
+    client.close();
+});
+
+test('Client construction failure - bad config, outbound priority weights of the wrong length', async () => {
+    let config : mqtt5.Mqtt5ClientConfig = getBaseConstructionFailureConfig();
+    config.outboundPriorityOptions = { weights: [1, 2] };
+    testFailedClientConstruction(config);
+});
+
+test('Client construction failure - bad config, json payload topic filter invalid', async () => {
+    let config : mqtt5.Mqtt5ClientConfig = getBaseConstructionFailureConfig();
+    config.jsonPayloadOptions = { topicFilters: ["a/#/b"] };
+    testFailedClientConstruction(config);
+});
+
+test('Client construction failure - bad config, json payload topic filter not a string', async () => {
+    let config : mqtt5.Mqtt5ClientConfig = getBaseConstructionFailureConfig();
+    // @ts-ignore
+    config.jsonPayloadOptions = { topicFilters: [Buffer.from("a/b")] };
+    testFailedClientConstruction(config);
+});
+
+test('Client construction failure - bad config, websocket signing config missing region', async () => {
+    let config : mqtt5.Mqtt5ClientConfig = getBaseConstructionFailureConfig();
+    // @ts-ignore
+    config.websocketSigningConfig = {
+        algorithm: auth.AwsSigningAlgorithm.SigV4,
+        signature_type: auth.AwsSignatureType.HttpRequestViaQueryParams,
+        provider: auth.AwsCredentialsProvider.newStatic("id", "secret"),
+        service: "iotdevicegateway",
+    };
+    testFailedClientConstruction(config);
+});
+
+test('Client construction failure - bad config, websocket signing config combined with handshake transform', async () => {
+    let config : mqtt5.Mqtt5ClientConfig = getBaseConstructionFailureConfig();
+    config.websocketSigningConfig = {
+        algorithm: auth.AwsSigningAlgorithm.SigV4,
+        signature_type: auth.AwsSignatureType.HttpRequestViaQueryParams,
+        provider: auth.AwsCredentialsProvider.newStatic("id", "secret"),
+        region: "us-east-1",
+        service: "iotdevicegateway",
+    };
+    config.websocketHandshakeTransform = (request, done) => { done(); };
+    testFailedClientConstruction(config);
+});
+
+function encodeTestJsonTapeString(value: string) : Buffer {
+    let bytes : Buffer = Buffer.from(value, 'utf8');
+    let length : Buffer = Buffer.alloc(4);
+    length.writeUInt32LE(bytes.length, 0);
+
+    return Buffer.concat([length, bytes]);
+}
+
+test('JSON tape decoder - nested values', async () => {
+    let number : Buffer = Buffer.alloc(9);
+    number.writeUInt8(3, 0);
+    number.writeDoubleLE(-1.5, 1);
+
+    let arrayHeader : Buffer = Buffer.from([5, 3, 0, 0, 0]);
+    let objectHeader : Buffer = Buffer.from([6, 3, 0, 0, 0]);
+
+    /* {"a": [null, true, -1.5], "__proto__": "x", "ç": false} */
+    let tape : Buffer = Buffer.concat([
+        objectHeader,
+        encodeTestJsonTapeString("a"), arrayHeader, Buffer.from([0, 2]), number,
+        encodeTestJsonTapeString("__proto__"), Buffer.from([4]), encodeTestJsonTapeString("x"),
+        encodeTestJsonTapeString("ç"), Buffer.from([1])
+    ]);
+
+    let value : any = mqtt5.JsonTapeDecoder.decode(tape.buffer.slice(tape.byteOffset, tape.byteOffset + tape.length));
+    expect(value).toEqual(JSON.parse('{"a": [null, true, -1.5], "__proto__": "x", "ç": false}'));
+    expect(Object.getPrototypeOf(value)).toBe(Object.prototype);
+
+    let truncated : Buffer = tape.subarray(0, tape.length - 1);
+    expect(() => { mqtt5.JsonTapeDecoder.decode(truncated.buffer.slice(truncated.byteOffset, truncated.byteOffset + truncated.length)); }).toThrow();
+});
+
+test('Client construction failure - bad config, utf8 payload delivery out of range', async () => {
+    let config : mqtt5.Mqtt5ClientConfig = getBaseConstructionFailureConfig();
+    // @ts-ignore
+    config.utf8PayloadDelivery = 3;
+    testFailedClientConstruction(config);
+});
+
+test('Client construction failure - bad config, lazy publish properties not a boolean', async () => {
+    let config : mqtt5.Mqtt5ClientConfig = getBaseConstructionFailureConfig();
+    // @ts-ignore
+    config.lazyPublishProperties = "yes";
+    testFailedClientConstruction(config);
+});
+
+test('Client construction failure - bad config, topic intern cache size not a number', async () => {
+    let config : mqtt5.Mqtt5ClientConfig = getBaseConstructionFailureConfig();
+    // @ts-ignore
+    config.topicInternCacheSize = "many";
+    testFailedClientConstruction(config);
+});
+
+test('Client construction failure - bad config, binary publish encoding combined with lazy publish properties', async () => {
+    let config : mqtt5.Mqtt5ClientConfig = getBaseConstructionFailureConfig();
+    config.lazyPublishProperties = true;
+    config.binaryPublishEncoding = true;
+    testFailedClientConstruction(config);
+});
+
+function encodeTestPublishRecord(topic: string, responseTopic: string, correlationData: Buffer, subscriptionIdentifiers: Array<number>, userProperties: Array<mqtt5.UserProperty>) : Buffer {
+    let parts : Array<Buffer> = [];
+
+    let lengthPrefixed = (value: Buffer) => {
+        let length : Buffer = Buffer.alloc(2);
+        length.writeUInt16BE(value.length);
+        parts.push(length, value);
+    };
+
+    let header : Buffer = Buffer.alloc(20);
+    header.writeUInt8(1, 0);
+    header.writeUInt8(mqtt5.QoS.AtLeastOnce, 1);
+    header.writeUInt8(0x01 | 0x02 | 0x08 | 0x10 | 0x20, 2);
+    header.writeUInt8(mqtt5.PayloadFormatIndicator.Utf8, 3);
+    header.writeUInt16BE(7, 8);
+    header.writeUInt16BE(Buffer.byteLength(topic), 10);
+    header.writeUInt32BE(subscriptionIdentifiers.length, 12);
+    header.writeUInt32BE(userProperties.length, 16);
+    parts.push(header, Buffer.from(topic));
+
+    lengthPrefixed(Buffer.from(responseTopic));
+    lengthPrefixed(correlationData);
+
+    for (let id of subscriptionIdentifiers) {
+        let encoded : Buffer = Buffer.alloc(4);
+        encoded.writeUInt32BE(id);
+        parts.push(encoded);
+    }
+
+    for (let property of userProperties) {
+        lengthPrefixed(Buffer.from(property.name));
+        lengthPrefixed(Buffer.from(property.value));
+    }
+
+    return Buffer.concat(parts);
+}
+
+test('Publish record decoder - round trip', async () => {
+    let userProperties : Array<mqtt5.UserProperty> = [{name: "ключ", value: "value"}, {name: "a", value: ""}];
+    let encoded : Buffer = encodeTestPublishRecord("a/b/ç", "reply/to", Buffer.from([1, 2, 3]), [5, 70000], userProperties);
+
+    /* mimic the native side: a record at the start of a larger, reused buffer */
+    let record : ArrayBuffer = new ArrayBuffer(encoded.length + 64);
+    encoded.copy(Buffer.from(record));
+
+    let decoder : mqtt5.PublishRecordDecoder = new mqtt5.PublishRecordDecoder();
+    let packet : mqtt5.PublishPacket = decoder.decode(record, 0, encoded.length, "payload");
+
+    /* later messages overwrite the shared buffer; decoded packets must not be affected */
+    Buffer.from(record).fill(0);
+
+    expect(packet.type).toEqual(mqtt5.PacketType.Publish);
+    expect(packet.topicName).toEqual("a/b/ç");
+    expect(packet.qos).toEqual(mqtt5.QoS.AtLeastOnce);
+    expect(packet.retain).toEqual(true);
+    expect(packet.payload).toEqual("payload");
+    expect(packet.payloadFormat).toEqual(mqtt5.PayloadFormatIndicator.Utf8);
+    expect(packet.messageExpiryIntervalSeconds).toBeUndefined();
+    expect(packet.topicAlias).toEqual(7);
+    expect(packet.responseTopic).toEqual("reply/to");
+    expect(Buffer.from(packet.correlationData as ArrayBuffer)).toEqual(Buffer.from([1, 2, 3]));
+    expect(packet.contentType).toBeUndefined();
+    expect(packet.subscriptionIdentifiers).toEqual([5, 70000]);
+    expect(packet.userProperties).toEqual(userProperties);
+});
+
+test('Publish record decoder - lazy fields are own enumerable properties', async () => {
+    let encoded : Buffer = encodeTestPublishRecord("a/b", "reply/to", Buffer.from([1, 2, 3]), [], []);
+
+    let decoder : mqtt5.PublishRecordDecoder = new mqtt5.PublishRecordDecoder();
+    let packet : mqtt5.PublishPacket = decoder.decode(encoded.buffer.slice(encoded.byteOffset, encoded.byteOffset + encoded.length), 0, encoded.length, "payload");
+
+    /* only fields the record carries appear, and nothing internal to the decoder does */
+    expect(Object.keys(packet).sort()).toEqual(["correlationData", "payload", "qos", "responseTopic", "retain", "topicAlias", "payloadFormat", "topicName", "type", "userProperties"].sort());
+
+    let spread : mqtt5.PublishPacket = { ...packet };
+    expect(spread.responseTopic).toEqual("reply/to");
+    expect(spread.userProperties).toEqual([]);
+
+    expect(JSON.parse(JSON.stringify(packet)).responseTopic).toEqual("reply/to");
+
+    packet.responseTopic = "overwritten";
+    expect(packet.responseTopic).toEqual("overwritten");
+});
+
+test('Client construction failure - bad config, shared message ring combined with lazy publish properties', async () => {
+    let config : mqtt5.Mqtt5ClientConfig = getBaseConstructionFailureConfig();
+    config.lazyPublishProperties = true;
+    config.sharedMessageRingOptions = { sizeInBytes: 65536 };
+    testFailedClientConstruction(config);
+});
+
+test('Client with shared message ring - statistics', async () => {
+    let client : mqtt5.Mqtt5Client = new mqtt5.Mqtt5Client({
+        hostName: "localhost",
+        port: 1883,
+        sharedMessageRingOptions: { sizeInBytes: 65536 }
+    });
+
+    expect(client.getOperationalStatistics().sharedMessageRingDroppedCount).toEqual(0);
+
+    client.close();
+});
+
+/* writes ring records the way shared_ring.c does, so the consumer can be exercised without a broker */
+function writeTestRingRecord(ring: mqtt5.SharedMessageRing, publishRecord: Buffer, payload: Buffer) {
+    let control : Int32Array = new Int32Array(ring.memory.buffer, 0, 4);
+    let capacity : number = ring.memory.length - 64;
+    let writePosition : number = Atomics.load(control, 0);
+    let offset : number = writePosition & (capacity - 1);
+    let recordLength : number = 4 + publishRecord.length + payload.length;
+    let entryLength : number = 4 + ((recordLength + 3) & ~3);
+
+    let data : Buffer = Buffer.from(ring.memory.buffer, 64, capacity);
+    if (entryLength > capacity - offset) {
+        data.writeUInt32BE(0xFFFFFFFF, offset);
+        writePosition = (writePosition + capacity - offset) | 0;
+        offset = 0;
+    }
+
+    data.writeUInt32BE(recordLength, offset);
+    data.writeUInt32BE(publishRecord.length, offset + 4);
+    publishRecord.copy(data, offset + 8);
+    payload.copy(data, offset + 8 + publishRecord.length);
+
+    Atomics.store(control, 0, (writePosition + entryLength) | 0);
+    return Atomics.exchange(control, 2, 0) != 0;
+}
+
+test('Shared message ring - drain across wrap', async () => {
+    let ring : mqtt5.SharedMessageRing = new mqtt5.SharedMessageRing(4096);
+    let publishRecord : Buffer = encodeTestPublishRecord("ring/topic", "reply", Buffer.from([9]), [], []);
+    let payload : Buffer = Buffer.alloc(700, 'x');
+
+    let received : Array<mqtt5.PublishPacket> = [];
+    for (let round = 0; round < 4; round++) {
+        /* first record after a drain must request a wakeup, later ones must not */
+        expect(writeTestRingRecord(ring, publishRecord, payload)).toEqual(true);
+        expect(writeTestRingRecord(ring, publishRecord, payload)).toEqual(false);
+        expect(writeTestRingRecord(ring, publishRecord, payload)).toEqual(false);
+
+        ring.drain((message: mqtt5.PublishPacket) => { received.push(message); });
+    }
+
+    expect(received.length).toEqual(12);
+    for (let message of received) {
+        expect(message.topicName).toEqual("ring/topic");
+        expect(message.responseTopic).toEqual("reply");
+        expect(Buffer.from(message.payload as ArrayBuffer)).toEqual(payload);
+    }
+    expect(ring.droppedCount).toEqual(0);
+});
+
+test('Client pool construction failure - no clients', async () => {
+    expect(() => {
+        new mqtt5.Mqtt5ClientPool({
+            clientConfig: getBaseConstructionFailureConfig(),
+            clientCount: 0
+        });
+    }).toThrow();
+});
+
+test('Client pool - aggregated statistics', async () => {
+    let pool : mqtt5.Mqtt5ClientPool = new mqtt5.Mqtt5ClientPool({
+        clientConfig: {
+            hostName : "localhost",
+            port : 1883,
+            connectProperties: {
+                keepAliveIntervalSeconds: 1200,
+                clientId: `pool-${uuid()}`
+            },
+            outboundPriorityOptions: {}
+        },
+        clientCount: 3
+    });
+
+    expect(pool.getClients().length).toEqual(3);
+
+    let statistics : mqtt5.ClientStatistics = pool.getOperationalStatistics();
+    expect(statistics.incompleteOperationCount).toEqual(0);
+    expect(statistics.unackedOperationCount).toEqual(0);
+
+    /* per-class statistics are merged class by class rather than added together as values */
+    let clientClasses = pool.getClients()[0].getOperationalStatistics().outboundPriorityStatistics ?? [];
+    expect(statistics.outboundPriorityStatistics?.length).toEqual(clientClasses.length);
+    for (let classStatistics of statistics.outboundPriorityStatistics ?? []) {
+        expect(classStatistics.queuedCount).toEqual(0);
+        expect(classStatistics.submittedCount).toEqual(0);
+    }
+
+    pool.close();
+});
+
+function createLocalBrokerClient(broker: LocalMqttBroker) : mqtt5.Mqtt5Client {
+    return new mqtt5.Mqtt5Client({
+        hostName: "127.0.0.1",
+        port: broker.port,
+        connectProperties: {
+            keepAliveIntervalSeconds: 1200,
+            clientId: `local-${uuid()}`
+        }
+    });
+}
+
+test('Local broker - sub pub unsub', async () => {
+    let broker : LocalMqttBroker = new LocalMqttBroker();
+    await broker.start();
+
+    await test_utils.subPubUnsubTest(createLocalBrokerClient(broker), mqtt5.QoS.AtLeastOnce, `test/local/${uuid()}`, "Derp");
+
+    await broker.stop();
+});
+
+test('Local broker - retained messages', async () => {
+    let broker : LocalMqttBroker = new LocalMqttBroker();
+    await broker.start();
+
+    await test_utils.doRetainTest(createLocalBrokerClient(broker), createLocalBrokerClient(broker), createLocalBrokerClient(broker));
+
+    await broker.stop();
+});
+
+test('Local broker - will message', async () => {
+    let broker : LocalMqttBroker = new LocalMqttBroker();
+    await broker.start();
+
+    let willTopic : string = `test/will/${uuid()}`;
+    let publisher : mqtt5.Mqtt5Client = new mqtt5.Mqtt5Client({
+        hostName: "127.0.0.1",
+        port: broker.port,
+        connectProperties: {
+            keepAliveIntervalSeconds: 1200,
+            will: {
+                topicName: willTopic,
+                qos: mqtt5.QoS.AtLeastOnce,
+                payload: "Bye"
+            }
+        }
+    });
+
+    await test_utils.willTest(publisher, createLocalBrokerClient(broker), willTopic);
+
+    await broker.stop();
+});
+
+test('Local broker - wildcard and shared subscriptions', async () => {
+    let broker : LocalMqttBroker = new LocalMqttBroker();
+    await broker.start();
+
+    let clients : Array<mqtt5.Mqtt5Client> = [createLocalBrokerClient(broker), createLocalBrokerClient(broker), createLocalBrokerClient(broker)];
+    let received : Array<Array<string>> = [[], [], []];
+    for (let i = 0; i < clients.length; i++) {
+        let connected = once(clients[i], mqtt5.Mqtt5Client.CONNECTION_SUCCESS);
+        clients[i].on(mqtt5.Mqtt5Client.MESSAGE_RECEIVED, (event: mqtt5.MessageReceivedEvent) => {
+            received[i].push(event.message.topicName);
+        });
+        clients[i].start();
+        await connected;
+    }
+
+    /* client 0 sees everything through a wildcard, clients 1 and 2 split the shared subscription */
+    await clients[0].subscribe({ subscriptions: [ { qos: mqtt5.QoS.AtLeastOnce, topicFilter: "sensors/+/temperature" } ] });
+    for (let client of clients.slice(1)) {
+        await client.subscribe({ subscriptions: [ { qos: mqtt5.QoS.AtLeastOnce, topicFilter: "$share/group/sensors/#" } ] });
+    }
+
+    for (let i = 0; i < 4; i++) {
+        await clients[0].publish({ topicName: `sensors/${i}/temperature`, qos: mqtt5.QoS.AtLeastOnce, payload: "20" });
+    }
+
+    await new Promise(resolve => setTimeout(resolve, 500));
+
+    expect(received[0].length).toEqual(4);
+    expect(received[1].length).toEqual(2);
+    expect(received[2].length).toEqual(2);
+
+    for (let client of clients) {
+        let stopped = once(client, mqtt5.Mqtt5Client.STOPPED);
+        client.stop();
+        await stopped;
+        client.close();
+    }
+
+    await broker.stop();
+});
+
+test('Local broker - injected drops', async () => {
+    let broker : LocalMqttBroker = new LocalMqttBroker();
+    await broker.start();
+    broker.dropRate = 1;
+
+    let client : mqtt5.Mqtt5Client = createLocalBrokerClient(broker);
+    let connected = once(client, mqtt5.Mqtt5Client.CONNECTION_SUCCESS);
+    let stopped = once(client, mqtt5.Mqtt5Client.STOPPED);
+    client.start();
+    await connected;
+
+    let topic : string = `test/drop/${uuid()}`;
+    await client.subscribe({ subscriptions: [ { qos: mqtt5.QoS.AtLeastOnce, topicFilter: topic } ] });
+    await client.publish({ topicName: topic, qos: mqtt5.QoS.AtLeastOnce, payload: "lost" });
+
+    expect(broker.statistics.publishesReceived).toEqual(1);
+    expect(broker.statistics.publishesDropped).toEqual(1);
+    expect(broker.statistics.publishesDelivered).toEqual(0);
+
+    client.stop();
+    await stopped;
+    client.close();
+
+    await broker.stop();
+});
+
+async function startLocalBrokerClients(broker: LocalMqttBroker, count: number) : Promise<Array<mqtt5.Mqtt5Client>> {
+    let clients : Array<mqtt5.Mqtt5Client> = [];
+    for (let i = 0; i < count; i++) {
+        let client : mqtt5.Mqtt5Client = createLocalBrokerClient(broker);
+        let connected = once(client, mqtt5.Mqtt5Client.CONNECTION_SUCCESS);
+        client.start();
+        await connected;
+        clients.push(client);
+    }
+
+    return clients;
+}
+
+async function stopLocalBrokerClients(clients: Array<mqtt5.Mqtt5Client>) {
+    for (let client of clients) {
+        let stopped = once(client, mqtt5.Mqtt5Client.STOPPED);
+        client.stop();
+        await stopped;
+        client.close();
+    }
+}
+
+test('Shared message ring - QoS 1 publishes that do not fit are still delivered', async () => {
+    let broker : LocalMqttBroker = new LocalMqttBroker();
+    await broker.start();
+
+    let subscriber : mqtt5.Mqtt5Client = new mqtt5.Mqtt5Client({
+        hostName: "127.0.0.1",
+        port: broker.port,
+        connectProperties: {
+            keepAliveIntervalSeconds: 1200,
+            clientId: `local-${uuid()}`
+        },
+        sharedMessageRingOptions: { sizeInBytes: 4096 }
+    });
+    let connected = once(subscriber, mqtt5.Mqtt5Client.CONNECTION_SUCCESS);
+    subscriber.start();
+    await connected;
+
+    let [publisher] = await startLocalBrokerClients(broker, 1);
+
+    let topic : string = `test/ring/${uuid()}`;
+    await subscriber.subscribe({ subscriptions: [ { qos: mqtt5.QoS.AtLeastOnce, topicFilter: topic } ] });
+
+    const messageCount : number = 10;
+    let received : number = 0;
+    let allReceived = new Promise<void>((resolve) => {
+        subscriber.on(mqtt5.Mqtt5Client.MESSAGE_RECEIVED, () => {
+            if (++received == messageCount) {
+                resolve();
+            }
+        });
+    });
+
+    let publishes : Array<Promise<mqtt5.PublishCompletionResult>> = [];
+    for (let i = 0; i < messageCount; i++) {
+        publishes.push(publisher.publish({ topicName: topic, qos: mqtt5.QoS.AtLeastOnce, payload: Buffer.alloc(1024) }));
+    }
+
+    /* keep node busy so the ring cannot be drained while the publishes arrive */
+    let busyUntil : number = Date.now() + 1000;
+    while (Date.now() < busyUntil) {}
+
+    await Promise.all(publishes);
+    await allReceived;
+    expect(subscriber.getOperationalStatistics().sharedMessageRingDroppedCount).toEqual(0);
+
+    await stopLocalBrokerClients([publisher, subscriber]);
+    await broker.stop();
+});
+
+test('Inbound flow control - QoS 0 past the limits is dropped, QoS 1 is always delivered', async () => {
+    let broker : LocalMqttBroker = new LocalMqttBroker();
+    await broker.start();
+
+    let [publisher] = await startLocalBrokerClients(broker, 1);
+
+    /* retained messages are all written to a new subscription in one go, before node gets to handle any of them */
+    const messageCount : number = 10;
+    let prefix : string = `test/flow/${uuid()}`;
+    for (let qos of [mqtt5.QoS.AtMostOnce, mqtt5.QoS.AtLeastOnce]) {
+        for (let i = 0; i < messageCount; i++) {
+            await publisher.publish({ topicName: `${prefix}/${qos}/${i}`, qos: qos, payload: "retained", retain: true });
+        }
+    }
+
+    let subscriber : mqtt5.Mqtt5Client = new mqtt5.Mqtt5Client({
+        hostName: "127.0.0.1",
+        port: broker.port,
+        connectProperties: {
+            keepAliveIntervalSeconds: 1200,
+            clientId: `local-${uuid()}`
+        },
+        inboundFlowControlOptions: { maxPendingMessageCount: 4 }
+    });
+    let connected = once(subscriber, mqtt5.Mqtt5Client.CONNECTION_SUCCESS);
+    subscriber.start();
+    await connected;
+
+    let received : Array<number> = [0, 0];
+    let isFirst : boolean = true;
+    subscriber.on(mqtt5.Mqtt5Client.MESSAGE_RECEIVED, (event: mqtt5.MessageReceivedEvent) => {
+        received[event.message.qos]++;
+
+        /* keep node busy so everything else piles up behind the first message */
+        if (isFirst) {
+            isFirst = false;
+            let busyUntil : number = Date.now() + 500;
+            while (Date.now() < busyUntil) {}
+        }
+    });
+
+    await subscriber.subscribe({ subscriptions: [ { qos: mqtt5.QoS.AtLeastOnce, topicFilter: `${prefix}/#` } ] });
+    await new Promise(resolve => setTimeout(resolve, 1000));
+
+    let dropped : number = subscriber.getOperationalStatistics().inboundFlowControlDroppedCount ?? 0;
+    expect(dropped).toBeGreaterThan(0);
+    expect(received[mqtt5.QoS.AtMostOnce]).toBeGreaterThan(0);
+    expect(received[mqtt5.QoS.AtMostOnce] + dropped).toEqual(messageCount);
+    expect(received[mqtt5.QoS.AtLeastOnce]).toEqual(messageCount);
+
+    let statistics : mqtt5.ClientStatistics = subscriber.getOperationalStatistics();
+    expect(statistics.pendingReceivedMessageCount).toEqual(0);
+
+    await stopLocalBrokerClients([publisher, subscriber]);
+    await broker.stop();
+});
+
+test('Local broker - websocket handshake signed natively', async () => {
+    let broker : LocalMqttBroker = new LocalMqttBroker();
+    await broker.start();
+
+    let client : mqtt5.Mqtt5Client = new mqtt5.Mqtt5Client({
+        hostName: "127.0.0.1",
+        port: broker.port,
+        connectProperties: {
+            keepAliveIntervalSeconds: 1200,
+            clientId: `local-${uuid()}`
+        },
+        websocketSigningConfig: {
+            algorithm: auth.AwsSigningAlgorithm.SigV4,
+            signature_type: auth.AwsSignatureType.HttpRequestViaQueryParams,
+            provider: auth.AwsCredentialsProvider.newStatic("AKIDEXAMPLE", "secret"),
+            region: "us-east-1",
+            service: "iotdevicegateway",
+        }
+    });
+
+    await test_utils.subPubUnsubTest(client, mqtt5.QoS.AtLeastOnce, `test/websocket/${uuid()}`, "Signed");
+
+    expect(broker.websocketHandshakes.length).toBeGreaterThan(0);
+    let query : URLSearchParams = new URL(broker.websocketHandshakes[0].path, "http://127.0.0.1").searchParams;
+    expect(query.get("X-Amz-Algorithm")).toEqual("AWS4-HMAC-SHA256");
+    expect(query.get("X-Amz-Credential")).toMatch(/^AKIDEXAMPLE\/\d{8}\/us-east-1\/iotdevicegateway\/aws4_request$/);
+    expect(query.get("X-Amz-Signature")).toMatch(/^[0-9a-f]{64}$/);
+
+    await broker.stop();
+});
+
+async function receiveLocalBrokerPayloads(broker: LocalMqttBroker, utf8PayloadDelivery: mqtt5.Utf8PayloadDelivery, publishes: Array<mqtt5.PublishPacket>) : Promise<Array<mqtt5.Payload | undefined>> {
+    let subscriber : mqtt5.Mqtt5Client = new mqtt5.Mqtt5Client({
+        hostName: "127.0.0.1",
+        port: broker.port,
+        connectProperties: {
+            keepAliveIntervalSeconds: 1200,
+            clientId: `local-${uuid()}`
+        },
+        utf8PayloadDelivery: utf8PayloadDelivery
+    });
+    let connected = once(subscriber, mqtt5.Mqtt5Client.CONNECTION_SUCCESS);
+    subscriber.start();
+    await connected;
+
+    let [publisher] = await startLocalBrokerClients(broker, 1);
+
+    let payloads : Array<mqtt5.Payload | undefined> = [];
+    let allReceived = new Promise<void>((resolve) => {
+        subscriber.on(mqtt5.Mqtt5Client.MESSAGE_RECEIVED, (event: mqtt5.MessageReceivedEvent) => {
+            payloads.push(event.message.payload);
+            if (payloads.length == publishes.length) {
+                resolve();
+            }
+        });
+    });
+
+    let topic : string = `test/utf8/${uuid()}`;
+    await subscriber.subscribe({ subscriptions: [ { qos: mqtt5.QoS.AtLeastOnce, topicFilter: topic } ] });
+    for (let publish of publishes) {
+        await publisher.publish({ ...publish, topicName: topic, qos: mqtt5.QoS.AtLeastOnce });
+    }
+
+    await allReceived;
+    await stopLocalBrokerClients([publisher, subscriber]);
+
+    return payloads;
+}
+
+test('Utf8 payload delivery - string if utf8 indicated', async () => {
+    let broker : LocalMqttBroker = new LocalMqttBroker();
+    await broker.start();
+
+    let invalidUtf8 : Buffer = Buffer.from([0xC3, 0x28, 0xFF, 0x80]);
+    let payloads = await receiveLocalBrokerPayloads(broker, mqtt5.Utf8PayloadDelivery.StringIfUtf8Indicated, [
+        { topicName: "", qos: mqtt5.QoS.AtLeastOnce, payload: "caf\u00e9", payloadFormat: mqtt5.PayloadFormatIndicator.Utf8 },
+        { topicName: "", qos: mqtt5.QoS.AtLeastOnce, payload: invalidUtf8 }
+    ]);
+
+    expect(typeof payloads[0]).toEqual("string");
+    expect(payloads[0]).toEqual("caf\u00e9");
+
+    /* the ArrayBuffer is created natively, outside of jest's realm, so instanceof cannot be used */
+    expect(Object.prototype.toString.call(payloads[1])).toEqual("[object ArrayBuffer]");
+    expect(Buffer.from(payloads[1] as ArrayBuffer)).toEqual(invalidUtf8);
+
+    await broker.stop();
+});
+
+test('Utf8 payload delivery - always string', async () => {
+    let broker : LocalMqttBroker = new LocalMqttBroker();
+    await broker.start();
+
+    let payloads = await receiveLocalBrokerPayloads(broker, mqtt5.Utf8PayloadDelivery.AlwaysString, [
+        { topicName: "", qos: mqtt5.QoS.AtLeastOnce, payload: Buffer.from("no indicator") }
+    ]);
+
+    expect(typeof payloads[0]).toEqual("string");
+    expect(payloads[0]).toEqual("no indicator");
+
+    await broker.stop();
+});
+
+function createPersistentQueueClient(broker: LocalMqttBroker, persistentQueueOptions: mqtt5.PersistentQueueOptions) : mqtt5.Mqtt5Client {
+    return new mqtt5.Mqtt5Client({
+        hostName: "127.0.0.1",
+        port: broker.port,
+        connectProperties: {
+            keepAliveIntervalSeconds: 1200,
+            clientId: `local-${uuid()}`
+        },
+        persistentQueueOptions: persistentQueueOptions
+    });
+}
+
+test('Persistent queue - pending publishes are replayed by the next client', async () => {
+    let broker : LocalMqttBroker = new LocalMqttBroker();
+    await broker.start();
+    let directory : string = fs.mkdtempSync(path.join(os.tmpdir(), "mqtt5-queue-"));
+
+    let [subscriber] = await startLocalBrokerClients(broker, 1);
+    let topic : string = `test/persisted/${uuid()}`;
+    await subscriber.subscribe({ subscriptions: [ { qos: mqtt5.QoS.AtLeastOnce, topicFilter: topic } ] });
+    let received = once(subscriber, mqtt5.Mqtt5Client.MESSAGE_RECEIVED);
+
+    /* never started, so the publish is still pending when the next client opens the queue */
+    let crashed : mqtt5.Mqtt5Client = createPersistentQueueClient(broker, { directory: directory });
+    let lost = crashed.publish({ topicName: topic, qos: mqtt5.QoS.AtLeastOnce, payload: "survivor" });
+    lost.catch(() => {});
+
+    let recovered : mqtt5.Mqtt5Client = createPersistentQueueClient(broker, { directory: directory });
+    expect(recovered.getOperationalStatistics().persistentQueuePendingCount).toEqual(1);
+
+    let connected = once(recovered, mqtt5.Mqtt5Client.CONNECTION_SUCCESS);
+    recovered.start();
+    await connected;
+
+    let [event] = await received;
+    expect(Buffer.from((event as mqtt5.MessageReceivedEvent).message.payload as ArrayBuffer).toString()).toEqual("survivor");
+
+    await stopLocalBrokerClients([recovered, subscriber]);
+    crashed.close();
+    fs.rmSync(directory, { recursive: true, force: true });
+    await broker.stop();
+});
+
+test('Persistent queue - completed publishes are compacted away', async () => {
+    let broker : LocalMqttBroker = new LocalMqttBroker();
+    await broker.start();
+    let directory : string = fs.mkdtempSync(path.join(os.tmpdir(), "mqtt5-queue-"));
+
+    let client : mqtt5.Mqtt5Client = createPersistentQueueClient(broker, { directory: directory, segmentSizeBytes: 256 });
+    let connected = once(client, mqtt5.Mqtt5Client.CONNECTION_SUCCESS);
+    client.start();
+    await connected;
+
+    let publishes : Array<Promise<mqtt5.PublishCompletionResult>> = [];
+    for (let i = 0; i < 20; i++) {
+        publishes.push(client.publish({ topicName: `test/compaction/${i}`, qos: mqtt5.QoS.AtLeastOnce, payload: Buffer.alloc(64) }));
+    }
+    await Promise.all(publishes);
+
+    let statistics : mqtt5.ClientStatistics = client.getOperationalStatistics();
+    expect(statistics.persistentQueuePendingCount).toEqual(0);
+    expect(statistics.persistentQueueSize).toEqual(0);
+    expect(fs.readdirSync(directory).length).toEqual(1);
+
+    await stopLocalBrokerClients([client]);
+    fs.rmSync(directory, { recursive: true, force: true });
+    await broker.stop();
+});
+
+test('Persistent queue - publishes beyond the byte budget are rejected', async () => {
+    let broker : LocalMqttBroker = new LocalMqttBroker();
+    await broker.start();
+    let directory : string = fs.mkdtempSync(path.join(os.tmpdir(), "mqtt5-queue-"));
+
+    let client : mqtt5.Mqtt5Client = createPersistentQueueClient(broker, { directory: directory, maxSizeBytes: 256 });
+
+    let accepted = client.publish({ topicName: "test/budget", qos: mqtt5.QoS.AtLeastOnce, payload: Buffer.alloc(128) });
+    accepted.catch(() => {});
+    await expect(client.publish({ topicName: "test/budget", qos: mqtt5.QoS.AtLeastOnce, payload: Buffer.alloc(128) })).rejects.toBeDefined();
+
+    let statistics : mqtt5.ClientStatistics = client.getOperationalStatistics();
+    expect(statistics.persistentQueuePendingCount).toEqual(1);
+    expect(statistics.persistentQueueSize).toBeLessThanOrEqual(256);
+
+    client.close();
+    fs.rmSync(directory, { recursive: true, force: true });
+    await broker.stop();
+});
+
+test('Request response - concurrent requests with in-flight limit', async () => {
+    let broker : LocalMqttBroker = new LocalMqttBroker();
+    await broker.start();
+
+    let [requester, responder] = await startLocalBrokerClients(broker, 2);
+
+    /* echoes each request's payload and correlation data back on its accepted topic */
+    responder.on(mqtt5.Mqtt5Client.MESSAGE_RECEIVED, (event: mqtt5.MessageReceivedEvent) => {
+        responder.publish({
+            topicName: `${event.message.topicName}/accepted`,
+            qos: mqtt5.QoS.AtLeastOnce,
+            payload: event.message.payload,
+            correlationData: event.message.correlationData
+        });
+    });
+    await responder.subscribe({ subscriptions: [ { qos: mqtt5.QoS.AtLeastOnce, topicFilter: "things/+/get" } ] });
+
+    let requestResponseClient : mqtt5.RequestResponseClient = mqtt5.RequestResponseClient.newFromMqtt5(requester, { maxInFlightRequests: 2 });
+    expect(() => { mqtt5.RequestResponseClient.newFromMqtt5(requester); }).toThrow();
+
+    let responses : Array<mqtt5.Response> = await Promise.all([0, 1, 2, 3, 4].map((i) => requestResponseClient.submitRequest({
+        subscriptionTopicFilters: [ "things/+/get/+" ],
+        responseTopics: [ `things/${i}/get/accepted`, `things/${i}/get/rejected` ],
+        publishTopic: `things/${i}/get`,
+        payload: `request-${i}`
+    })));
+
+    for (let i = 0; i < responses.length; i++) {
+        expect(responses[i].topic).toEqual(`things/${i}/get/accepted`);
+        expect(Buffer.from(responses[i].payload).toString()).toEqual(`request-${i}`);
+    }
+    expect(requester.getOperationalStatistics().unmatchedResponseCount).toEqual(0);
+
+    requestResponseClient.close();
+    await stopLocalBrokerClients([requester, responder]);
+    await broker.stop();
+});
+
+test('Request response - timeout and unmatched responses', async () => {
+    let broker : LocalMqttBroker = new LocalMqttBroker();
+    await broker.start();
+
+    let [requester, other] = await startLocalBrokerClients(broker, 2);
+    let requestResponseClient : mqtt5.RequestResponseClient = mqtt5.RequestResponseClient.newFromMqtt5(requester, { operationTimeoutInSeconds: 1 });
+
+    let request : Promise<mqtt5.Response> = requestResponseClient.submitRequest({
+        subscriptionTopicFilters: [ "jobs/+/response" ],
+        responseTopics: [ "jobs/1/response" ],
+        publishTopic: "jobs/1/request",
+        payload: "nobody is listening",
+        correlationData: Buffer.from("token-1")
+    });
+
+    /* right topic, wrong correlation data: must not complete the request or reach messageReceived */
+    requester.on(mqtt5.Mqtt5Client.MESSAGE_RECEIVED, () => { throw new Error("This shouldn't happen!"); });
+    await new Promise(resolve => setTimeout(resolve, 200));
+    await other.publish({
+        topicName: "jobs/1/response",
+        qos: mqtt5.QoS.AtLeastOnce,
+        payload: "stale",
+        correlationData: Buffer.from("token-0")
+    });
+
+    await expect(request).rejects.toThrow();
+    expect(requester.getOperationalStatistics().unmatchedResponseCount).toEqual(1);
+
+    requestResponseClient.close();
+    await expect(requestResponseClient.submitRequest({
+        subscriptionTopicFilters: [ "jobs/+/response" ],
+        responseTopics: [ "jobs/2/response" ],
+        publishTopic: "jobs/2/request",
+        payload: "closed"
+    })).rejects.toThrow();
+
+    await stopLocalBrokerClients([requester, other]);
+    await broker.stop();
+});
+
+test('Request response - responses without correlation data and re-creation after close', async () => {
+    let broker : LocalMqttBroker = new LocalMqttBroker();
+    await broker.start();
+
+    let [requester, responder] = await startLocalBrokerClients(broker, 2);
+
+    let requestCount : number = 0;
+    let requestsReceived = new Promise<void>((resolve) => {
+        responder.on(mqtt5.Mqtt5Client.MESSAGE_RECEIVED, () => {
+            if (++requestCount == 2) {
+                resolve();
+            }
+        });
+    });
+    await responder.subscribe({ subscriptions: [ { qos: mqtt5.QoS.AtLeastOnce, topicFilter: "shared/request" } ] });
+
+    let requestOptions : mqtt5.RequestOptions = {
+        subscriptionTopicFilters: [ "shared/response" ],
+        responseTopics: [ "shared/response" ],
+        publishTopic: "shared/request",
+        payload: "request"
+    };
+
+    let requestResponseClient : mqtt5.RequestResponseClient = mqtt5.RequestResponseClient.newFromMqtt5(requester);
+    let requests : Array<Promise<mqtt5.Response>> = [
+        requestResponseClient.submitRequest(requestOptions),
+        requestResponseClient.submitRequest(requestOptions)
+    ];
+    await requestsReceived;
+
+    /* two requests wait on the topic, so a response without correlation data can't be attributed to either */
+    await responder.publish({ topicName: "shared/response", qos: mqtt5.QoS.AtLeastOnce, payload: "ambiguous" });
+    await new Promise(resolve => setTimeout(resolve, 500));
+    expect(requester.getOperationalStatistics().unmatchedResponseCount).toEqual(1);
+
+    requestResponseClient.close();
+    for (let request of requests) {
+        await expect(request).rejects.toThrow();
+    }
+
+    /* closing released the native routing, so the client can host a new request-response client */
+    requestResponseClient = mqtt5.RequestResponseClient.newFromMqtt5(requester);
+    responder.on(mqtt5.Mqtt5Client.MESSAGE_RECEIVED, () => {
+        responder.publish({ topicName: "shared/response", qos: mqtt5.QoS.AtLeastOnce, payload: "only" });
+    });
+
+    let response : mqtt5.Response = await requestResponseClient.submitRequest(requestOptions);
+    expect(Buffer.from(response.payload).toString()).toEqual("only");
+
+    requestResponseClient.close();
+    await stopLocalBrokerClients([requester, responder]);
+    await broker.stop();
+});
+
+test('Local broker - lazy publish properties are own enumerable properties', async () => {
+    let broker : LocalMqttBroker = new LocalMqttBroker();
+    await broker.start();
+
+    let publisher : mqtt5.Mqtt5Client = createLocalBrokerClient(broker);
+    let subscriber : mqtt5.Mqtt5Client = new mqtt5.Mqtt5Client({
+        hostName: "127.0.0.1",
+        port: broker.port,
+        connectProperties: {
+            keepAliveIntervalSeconds: 1200,
+            clientId: `local-${uuid()}`
+        },
+        lazyPublishProperties: true
+    });
+
+    for (let client of [publisher, subscriber]) {
+        let connected = once(client, mqtt5.Mqtt5Client.CONNECTION_SUCCESS);
+        client.start();
+        await connected;
+    }
+
+    await subscriber.subscribe({ subscriptions: [ { topicFilter: "lazy/topic", qos: mqtt5.QoS.AtLeastOnce } ] });
+
+    let messageReceived = once(subscriber, mqtt5.Mqtt5Client.MESSAGE_RECEIVED);
+    await publisher.publish({
+        topicName: "lazy/topic",
+        qos: mqtt5.QoS.AtLeastOnce,
+        payload: "payload",
+        responseTopic: "lazy/reply",
+        contentType: "text/plain",
+        userProperties: [ { name: "key", value: "value" } ]
+    });
+
+    let message : mqtt5.PublishPacket = (await messageReceived)[0].message;
+
+    expect(Object.keys(message)).toEqual(expect.arrayContaining(["topicName", "responseTopic", "contentType", "userProperties"]));
+
+    let spread : mqtt5.PublishPacket = { ...message };
+    expect(spread.responseTopic).toEqual("lazy/reply");
+    expect(spread.contentType).toEqual("text/plain");
+    expect(spread.userProperties).toEqual([ { name: "key", value: "value" } ]);
+
+    let serialized : any = JSON.parse(JSON.stringify(message));
+    expect(serialized.responseTopic).toEqual("lazy/reply");
+
+    /* converted once; later reads return the same value */
+    expect(message.userProperties).toBe(message.userProperties);
+
+    await stopLocalBrokerClients([publisher, subscriber]);
+    await broker.stop();
+});
+
+test('Local broker - prepared publish', async () => {
+    let broker : LocalMqttBroker = new LocalMqttBroker();
+    await broker.start();
+
+    let [publisher, subscriber] = await startLocalBrokerClients(broker, 2);
+
+    await subscriber.subscribe({ subscriptions: [ { topicFilter: "prepared/topic", qos: mqtt5.QoS.AtLeastOnce } ] });
+
+    let received : Array<mqtt5.PublishPacket> = [];
+    let allReceived = new Promise<void>((resolve) => {
+        subscriber.on(mqtt5.Mqtt5Client.MESSAGE_RECEIVED, (event: mqtt5.MessageReceivedEvent) => {
+            received.push(event.message);
+            if (received.length == 3) {
+                resolve();
+            }
+        });
+    });
+
+    let prepared : mqtt5.PreparedPublish = publisher.preparePublish({
+        topicName: "prepared/topic",
+        qos: mqtt5.QoS.AtLeastOnce,
+        payload: "ignored",
+        contentType: "text/plain",
+        userProperties: [ { name: "source", value: "template" } ]
+    });
+
+    await prepared.publish("one");
+    await publisher.publishPrepared(prepared, Buffer.from("two"));
+    await prepared.publish(new Uint8Array([116, 104, 114, 101, 101]), { priority: 1 });
+
+    await allReceived;
+
+    expect(received.map((message) => Buffer.from(message.payload as ArrayBuffer).toString())).toEqual(["one", "two", "three"]);
+    for (let message of received) {
+        expect(message.topicName).toEqual("prepared/topic");
+        expect(message.contentType).toEqual("text/plain");
+        expect(message.userProperties).toEqual([ { name: "source", value: "template" } ]);
+    }
+
+    await expect(subscriber.publishPrepared(prepared, "wrong client")).rejects.toThrow();
+
+    await stopLocalBrokerClients([publisher, subscriber]);
+    await broker.stop();
+});
+
+test('Local broker - message filter', async () => {
+    let broker : LocalMqttBroker = new LocalMqttBroker();
+    await broker.start();
+
+    let [publisher, subscriber] = await startLocalBrokerClients(broker, 2);
+
+    subscriber.setMessageFilter([
+        { topicFilter: "filter/drop/#", drop: true },
+        { topicFilter: "filter/sample", sampleEvery: 2 },
+        { topicFilter: "filter/props", userProperty: { name: "kind", value: "command" } },
+        { topicFilter: "filter/rate", maxMessagesPerSecond: 3 }
+    ]);
+
+    let received : Array<string> = [];
+    let done = new Promise<void>((resolve) => {
+        subscriber.on(mqtt5.Mqtt5Client.MESSAGE_RECEIVED, (event: mqtt5.MessageReceivedEvent) => {
+            if (event.message.topicName == "filter/done") {
+                resolve();
+            } else {
+                received.push(`${event.message.topicName}:${Buffer.from(event.message.payload as ArrayBuffer).toString()}`);
+            }
+        });
+    });
+
+    await subscriber.subscribe({ subscriptions: [ { topicFilter: "filter/#", qos: mqtt5.QoS.AtLeastOnce } ] });
+
+    let publish = (topicName: string, payload: string, userProperties?: Array<mqtt5.UserProperty>) =>
+        publisher.publish({ topicName: topicName, qos: mqtt5.QoS.AtLeastOnce, payload: payload, userProperties: userProperties });
+
+    for (let i = 0; i < 4; i++) {
+        await publish("filter/sample", `${i}`);
+    }
+    await publish("filter/drop/a/b", "dropped");
+    await publish("filter/props", "telemetry", [ { name: "kind", value: "telemetry" } ]);
+    await publish("filter/props", "command", [ { name: "kind", value: "command" } ]);
+    await publish("filter/other", "unfiltered");
+    await Promise.all([0, 1, 2, 3, 4, 5, 6, 7, 8, 9].map((i) => publish("filter/rate", `${i}`)));
+    await publish("filter/done", "");
+    await done;
+
+    expect(received.filter((message) => !message.startsWith("filter/rate"))).toEqual([
+        "filter/sample:0", "filter/sample:2", "filter/props:command", "filter/other:unfiltered"
+    ]);
+
+    let rateLimitedDelivered : number = received.filter((message) => message.startsWith("filter/rate")).length;
+    expect(rateLimitedDelivered).toBeGreaterThanOrEqual(3);
+    expect(rateLimitedDelivered).toBeLessThan(10);
+
+    let statistics : mqtt5.ClientStatistics = subscriber.getOperationalStatistics();
+    expect(statistics.filteredMessageCount).toEqual(2);
+    expect(statistics.sampledOutMessageCount).toEqual(2);
+    expect(statistics.rateLimitedMessageCount).toEqual(10 - rateLimitedDelivered);
+
+    /* removing the filter delivers everything again */
+    subscriber.setMessageFilter();
+    let received_again = once(subscriber, mqtt5.Mqtt5Client.MESSAGE_RECEIVED);
+    await publish("filter/drop/again", "delivered");
+    expect((await received_again)[0].message.topicName).toEqual("filter/drop/again");
+
+    /* the counters outlive the filter */
+    expect(subscriber.getOperationalStatistics().filteredMessageCount).toEqual(2);
+
+    await stopLocalBrokerClients([publisher, subscriber]);
+    await broker.stop();
+});
+
+test('Local broker - delivery priority', async () => {
+    let broker : LocalMqttBroker = new LocalMqttBroker();
+    await broker.start();
+
+    let [publisher] = await startLocalBrokerClients(broker, 1);
+
+    let subscriber : mqtt5.Mqtt5Client = new mqtt5.Mqtt5Client({
+        hostName: "127.0.0.1",
+        port: broker.port,
+        connectProperties: {
+            keepAliveIntervalSeconds: 1200,
+            clientId: `local-${uuid()}`
+        },
+        deliveryPriorityOptions: {
+            rules: [
+                { topicFilter: "priority/alarm/#", priority: mqtt5.MAX_DELIVERY_PRIORITY },
+                { topicFilter: "priority/+/control", priority: 1 }
+            ]
+        }
+    });
+    let connected = once(subscriber, mqtt5.Mqtt5Client.CONNECTION_SUCCESS);
+    subscriber.start();
+    await connected;
+
+    let lowCount : number = 10;
+    let received : Array<string> = [];
+    let done = new Promise<void>((resolve) => {
+        subscriber.on(mqtt5.Mqtt5Client.MESSAGE_RECEIVED, (event: mqtt5.MessageReceivedEvent) => {
+            received.push(event.message.topicName);
+            if (received.length == 1) {
+                /* hold node's thread so that the remaining messages pile up natively */
+                let until : number = Date.now() + 500;
+                while (Date.now() < until) {}
+            }
+            if (received.length == lowCount + 2) {
+                resolve();
+            }
+        });
+    });
+
+    await subscriber.subscribe({ subscriptions: [ { topicFilter: "priority/#", qos: mqtt5.QoS.AtLeastOnce } ] });
+
+    let publishes : Array<Promise<mqtt5.PublishCompletionResult>> = [];
+    for (let i = 0; i < lowCount; i++) {
+        publishes.push(publisher.publish({ topicName: "priority/telemetry", qos: mqtt5.QoS.AtLeastOnce, payload: `${i}` }));
+    }
+    publishes.push(publisher.publish({ topicName: "priority/device/control", qos: mqtt5.QoS.AtLeastOnce, payload: "control" }));
+    publishes.push(publisher.publish({ topicName: "priority/alarm/fire", qos: mqtt5.QoS.AtLeastOnce, payload: "alarm" }));
+    await Promise.all(publishes);
+    await done;
+
+    /* everything after the first message was queued behind the blocked handler */
+    expect(received[0]).toEqual("priority/telemetry");
+    expect(received.slice(1, 3)).toEqual(["priority/alarm/fire", "priority/device/control"]);
+
+    let statistics : mqtt5.ClientStatistics = subscriber.getOperationalStatistics();
+    let lanes : Array<mqtt5.DeliveryPriorityStatistics> = statistics.deliveryPriorityStatistics ?? [];
+    expect(lanes.length).toEqual(mqtt5.MAX_DELIVERY_PRIORITY + 1);
+    expect(lanes.map((lane) => lane.deliveredCount)).toEqual([lowCount, 1, 0, 1]);
+    expect(lanes.every((lane) => lane.pendingCount == 0)).toBeTruthy();
+    expect(lanes[0].maxQueueingDelayUs).toBeGreaterThan(0);
+
+    await stopLocalBrokerClients([publisher, subscriber]);
+    await broker.stop();
+});
+
+test('Local broker - outbound priority', async () => {
+    let broker : LocalMqttBroker = new LocalMqttBroker();
+    await broker.start();
+
+    let [subscriber] = await startLocalBrokerClients(broker, 1);
+
+    let publisher : mqtt5.Mqtt5Client = new mqtt5.Mqtt5Client({
+        hostName: "127.0.0.1",
+        port: broker.port,
+        connectProperties: {
+            keepAliveIntervalSeconds: 1200,
+            clientId: `local-${uuid()}`
+        },
+        outboundPriorityOptions: {
+            maxInFlightPublishes: 1
+        }
+    });
+    let connected = once(publisher, mqtt5.Mqtt5Client.CONNECTION_SUCCESS);
+    publisher.start();
+    await connected;
+
+    let bulkCount : number = 20;
+    let received : Array<string> = [];
+    let done = new Promise<void>((resolve) => {
+        subscriber.on(mqtt5.Mqtt5Client.MESSAGE_RECEIVED, (event: mqtt5.MessageReceivedEvent) => {
+            received.push(event.message.topicName);
+            if (received.length == bulkCount + 1) {
+                resolve();
+            }
+        });
+    });
+
+    await subscriber.subscribe({ subscriptions: [ { topicFilter: "outbound/#", qos: mqtt5.QoS.AtLeastOnce } ] });
+
+    let publishes : Array<Promise<mqtt5.PublishCompletionResult>> = [];
+    for (let i = 0; i < bulkCount; i++) {
+        publishes.push(publisher.publish({ topicName: "outbound/bulk", qos: mqtt5.QoS.AtLeastOnce, payload: `${i}` }));
+    }
+    publishes.push(publisher.publish({ topicName: "outbound/alarm", qos: mqtt5.QoS.AtLeastOnce, payload: "alarm" }, { priority: mqtt5.MAX_PUBLISH_PRIORITY }));
+    await Promise.all(publishes);
+    await done;
+
+    /* only the first bulk publish was in flight when the alarm was submitted */
+    expect(received.indexOf("outbound/alarm")).toEqual(1);
+
+    let statistics : mqtt5.ClientStatistics = publisher.getOperationalStatistics();
+    let classes : Array<mqtt5.OutboundPriorityStatistics> = statistics.outboundPriorityStatistics ?? [];
+    expect(classes.map((publishClass) => publishClass.queuedCount)).toEqual([0, 0, 0, 0]);
+    expect(classes.map((publishClass) => publishClass.submittedCount)).toEqual([bulkCount, 0, 0, 1]);
+
+    await stopLocalBrokerClients([publisher, subscriber]);
+    await broker.stop();
+});
+
+test('Local broker - last value cache', async () => {
+    let broker : LocalMqttBroker = new LocalMqttBroker();
+    await broker.start();
+
+    let [publisher, subscriber] = await startLocalBrokerClients(broker, 2);
+
+    subscriber.setLastValueCache({
+        topicFilters: ["lvc/devices/+/state"],
+        maxTopicCount: 2,
+        suppressDelivery: true
+    });
+
+    let received : Array<string> = [];
+    let done = new Promise<void>((resolve) => {
+        subscriber.on(mqtt5.Mqtt5Client.MESSAGE_RECEIVED, (event: mqtt5.MessageReceivedEvent) => {
+            received.push(event.message.topicName);
+            if (event.message.topicName == "lvc/done") {
+                resolve();
+            }
+        });
+    });
+
+    await subscriber.subscribe({ subscriptions: [ { topicFilter: "lvc/#", qos: mqtt5.QoS.AtLeastOnce } ] });
+
+    let publish = (topicName: string, payload: string) =>
+        publisher.publish({ topicName: topicName, qos: mqtt5.QoS.AtLeastOnce, payload: payload });
+
+    await publish("lvc/devices/a/state", "a1");
+    await publish("lvc/devices/b/state", "b1");
+    await publish("lvc/devices/a/state", "a2");
+    await publish("lvc/devices/c/state", "c1");
+    await publish("lvc/devices/a/telemetry", "uncached");
+    await publish("lvc/done", "");
+    await done;
+
+    /* cached topics are not delivered */
+    expect(received).toEqual(["lvc/devices/a/telemetry", "lvc/done"]);
+
+    let latest : mqtt5.LastValue | undefined = subscriber.getLastValue("lvc/devices/a/state");
+    expect(latest).toBeDefined();
+    expect(Buffer.from(latest?.payload as ArrayBuffer).toString()).toEqual("a2");
+    expect(latest?.retain).toEqual(false);
+
+    /* b was least recently used when c arrived */
+    expect(subscriber.getLastValue("lvc/devices/b/state")).toBeUndefined();
+    expect(subscriber.getLastValue("lvc/devices/a/telemetry")).toBeUndefined();
+
+    let snapshot : Array<mqtt5.LastValue> = subscriber.getLastValueSnapshot("lvc/devices/");
+    expect(snapshot.map((value) => value.topic)).toEqual(["lvc/devices/c/state", "lvc/devices/a/state"]);
+    expect(subscriber.getLastValueSnapshot("lvc/other/")).toEqual([]);
+
+    let statistics : mqtt5.ClientStatistics = subscriber.getOperationalStatistics();
+    expect(statistics.lastValueCacheTopicCount).toEqual(2);
+    expect(statistics.lastValueCacheEvictedCount).toEqual(1);
+
+    subscriber.setLastValueCache();
+    expect(subscriber.getLastValue("lvc/devices/a/state")).toBeUndefined();
+    expect(subscriber.getLastValueSnapshot()).toEqual([]);
+    expect(subscriber.getOperationalStatistics().lastValueCacheTopicCount).toBeUndefined();
+
+    await stopLocalBrokerClients([publisher, subscriber]);
+    await broker.stop();
+});
+
+test('Local broker - JSON payload parsing', async () => {
+    let broker : LocalMqttBroker = new LocalMqttBroker();
+    await broker.start();
+
+    let publisher : mqtt5.Mqtt5Client = createLocalBrokerClient(broker);
+    let subscriber : mqtt5.Mqtt5Client = new mqtt5.Mqtt5Client({
+        hostName: "127.0.0.1",
+        port: broker.port,
+        connectProperties: {
+            keepAliveIntervalSeconds: 1200,
+            clientId: `local-${uuid()}`
+        },
+        jsonPayloadOptions: {
+            topicFilters: ["json/+/state"]
+        }
+    });
+
+    for (let client of [publisher, subscriber]) {
+        let connected = once(client, mqtt5.Mqtt5Client.CONNECTION_SUCCESS);
+        client.start();
+        await connected;
+    }
+
+    let events : Array<mqtt5.MessageReceivedEvent> = [];
+    let done = new Promise<void>((resolve) => {
+        subscriber.on(mqtt5.Mqtt5Client.MESSAGE_RECEIVED, (event: mqtt5.MessageReceivedEvent) => {
+            events.push(event);
+            if (events.length == 4) {
+                resolve();
+            }
+        });
+    });
+
+    await subscriber.subscribe({ subscriptions: [ { topicFilter: "json/#", qos: mqtt5.QoS.AtLeastOnce } ] });
+
+    let document : string = '{"temperature": 21.5, "tags": ["a", "\\u00e7", "\\ud83d\\ude00"], "nested": {"on": true, "off": null, "count": 12345678901234567890}}';
+    await publisher.publish({ topicName: "json/a/state", qos: mqtt5.QoS.AtLeastOnce, payload: document });
+    await publisher.publish({ topicName: "json/b/state", qos: mqtt5.QoS.AtLeastOnce, payload: '{"temperature": 21.5,}' });
+    await publisher.publish({ topicName: "json/a/other", qos: mqtt5.QoS.AtLeastOnce, payload: document });
+    await publisher.publish({ topicName: "json/c/state", qos: mqtt5.QoS.AtLeastOnce, payload: Buffer.from([0x22, 0xC3, 0x28, 0x22]) });
+    await done;
+
+    expect(events[0].json).toEqual(JSON.parse(document));
+    expect(events[0].jsonError).toBeUndefined();
+
+    expect(events[1].json).toBeUndefined();
+    expect(events[1].jsonError?.offset).toEqual(21);
+
+    /* non-matching topics are not parsed */
+    expect("json" in events[2]).toEqual(false);
+    expect(events[2].jsonError).toBeUndefined();
+
+    /* a truncated two byte sequence inside a string */
+    expect(events[3].json).toBeUndefined();
+    expect(events[3].jsonError?.offset).toEqual(1);
+
+    await stopLocalBrokerClients([publisher, subscriber]);
+    await broker.stop();
+});
+
+test('Local broker - live statistics', async () => {
+    let broker : LocalMqttBroker = new LocalMqttBroker();
+    await broker.start();
+
+    let client : mqtt5.Mqtt5Client = createLocalBrokerClient(broker);
+    let statistics : mqtt5.LiveStatistics = client.enableLiveStatistics();
+    expect(client.enableLiveStatistics()).toBe(statistics);
+
+    let connected = once(client, mqtt5.Mqtt5Client.CONNECTION_SUCCESS);
+    client.start();
+    await connected;
+
+    expect(statistics.connectionSuccesses).toEqual(1);
+    expect(statistics.reconnects).toEqual(0);
+
+    let received : number = 0;
+    let done = new Promise<void>((resolve) => {
+        client.on(mqtt5.Mqtt5Client.MESSAGE_RECEIVED, () => {
+            if (++received == 3) {
+                resolve();
+            }
+        });
+    });
+
+    await client.subscribe({ subscriptions: [ { topicFilter: "live/#", qos: mqtt5.QoS.AtLeastOnce } ] });
+
+    for (let i = 0; i < 3; i++) {
+        await client.publish({ topicName: "live/stats", qos: mqtt5.QoS.AtLeastOnce, payload: "12345" });
+    }
+    await done;
+
+    expect(statistics.publishesSent).toEqual(3);
+    expect(statistics.publishBytesSent).toEqual(15);
+    expect(statistics.publishesFailed).toEqual(0);
+    expect(statistics.publishesReceived).toEqual(3);
+    expect(statistics.publishBytesReceived).toEqual(15);
+
+    /* readable from a copy of the shared memory, as a worker thread would */
+    let shared : mqtt5.LiveStatistics = new mqtt5.LiveStatistics(statistics.memory);
+    expect(shared.get(mqtt5.LiveStatisticsCounter.PublishesReceived)).toEqual(3);
+
+    await stopLocalBrokerClients([client]);
+    expect(statistics.connectionDrops).toEqual(1);
+
+    await broker.stop();
+});
+
+test('Last value cache - invalid options', async () => {
+    let client : mqtt5.Mqtt5Client = new mqtt5.Mqtt5Client({ hostName : "localhost", port : 1883 });
+
+    expect(() => { client.setLastValueCache({ topicFilters: ["a/#/b"] }); }).toThrow();
+    expect(() => { client.setLastValueCache({ topicFilters: ["a/+"], maxTopicCount: 0 }); }).toThrow();
+
+    client.close();
+});
+
+test('Subscribe coalescer - merges within limits and splits subacks', async () => {
+    let sent : Array<mqtt5.SubscribePacket> = [];
+    let coalescer : mqtt5.SubscribeCoalescer = new mqtt5.SubscribeCoalescer(
+        { windowMs: 10, maxSubscriptionsPerPacket: 3 },
+        async (packet: mqtt5.SubscribePacket) => {
+            sent.push(packet);
+            return { reasonCodes: packet.subscriptions.map((subscription) => subscription.qos as number) };
+        },
+        () => undefined);
+
+    let subscribe = (topicFilter: string, qos: mqtt5.QoS) => coalescer.submit({ subscriptions: [ { topicFilter: topicFilter, qos: qos } ] });
+
+    let subacks : Array<mqtt5.SubackPacket> = await Promise.all([
+        subscribe("a", mqtt5.QoS.AtMostOnce),
+        subscribe("b", mqtt5.QoS.AtLeastOnce),
+        subscribe("c", mqtt5.QoS.AtMostOnce),
+        subscribe("d", mqtt5.QoS.AtLeastOnce),
+        subscribe("d", mqtt5.QoS.AtMostOnce),
+        coalescer.submit({ subscriptions: [ { topicFilter: "e", qos: mqtt5.QoS.AtLeastOnce } ], subscriptionIdentifier: 5 })
+    ]);
+
+    /*
+     * a-c fill one packet, the duplicate d starts another, and the identified subscribe is never merged but still
+     * goes out after everything submitted before it
+     */
+    expect(sent.map((packet) => packet.subscriptions.map((subscription) => subscription.topicFilter))).toEqual([
+        ["a", "b", "c"], ["d"], ["d"], ["e"]
+    ]);
+    expect(subacks.map((suback) => suback.reasonCodes)).toEqual([[0], [1], [0], [1], [0], [1]]);
+});
+
+test('Local broker - coalesced subscribes', async () => {
+    let broker : LocalMqttBroker = new LocalMqttBroker();
+    await broker.start();
+
+    let client : mqtt5.Mqtt5Client = new mqtt5.Mqtt5Client({
+        hostName: "127.0.0.1",
+        port: broker.port,
+        subscribeCoalescingOptions: { maxSubscriptionsPerPacket: 16 }
+    });
+    let connected = once(client, mqtt5.Mqtt5Client.CONNECTION_SUCCESS);
+    client.start();
+    await connected;
+
+    let filters : Array<string> = [];
+    for (let i = 0; i < 40; i++) {
+        filters.push(`coalesce/${i}`);
+    }
+
+    let subacks : Array<mqtt5.SubackPacket> = await Promise.all(filters.map((topicFilter) =>
+        client.subscribe({ subscriptions: [ { topicFilter: topicFilter, qos: mqtt5.QoS.AtLeastOnce } ] })));
+
+    for (let suback of subacks) {
+        expect(suback.reasonCodes).toEqual([mqtt5.SubackReasonCode.GrantedQoS1]);
+    }
+
+    let messageReceived = once(client, mqtt5.Mqtt5Client.MESSAGE_RECEIVED);
+    await client.publish({ topicName: "coalesce/39", qos: mqtt5.QoS.AtLeastOnce, payload: "hello" });
+    let message : mqtt5.PublishPacket = (await messageReceived)[0].message;
+    expect(message.topicName).toEqual("coalesce/39");
+
+    await stopLocalBrokerClients([client]);
+    await broker.stop();
+});
+
 function createDirectIotCoreClientConfig() : mqtt5.Mqtt5ClientConfig {
 
     let tlsContextOptions: io.TlsContextOptions = io.TlsContextOptions.create_client_with_mtls_from_path(
@@ -19,14 +19,22 @@ import { NativeResourceMixin } from "./native_resource";
 import { BufferedEventEmitter } from '../common/event';
 import * as io from "./io";
 import * as http from './http';
+import * as auth from './auth';
 import * as mqtt5_packet from "../common/mqtt5_packet";
 import * as mqtt5 from "../common/mqtt5";
 import * as mqtt_shared from "../common/mqtt_shared";
 import {CrtError} from "./error";
+import * as fs from "fs";
+import * as path from "path";
+import {randomBytes} from "crypto";
+import {LastValue, LastValueCacheOptions, MessageFilterRule} from "../common/mqtt_shared";
+import {LiveStatistics} from "./live_statistics";
 
 export { HttpProxyOptions } from './http';
 export * from "../common/mqtt5";
 export * from '../common/mqtt5_packet';
+export { LastValue, LastValueCacheOptions, MessageFilterRule } from '../common/mqtt_shared';
+export { LiveStatistics, LiveStatisticsCounter } from './live_statistics';
 
 /**
  * Websocket handshake http request transformation function signature
@@ -61,8 +69,202 @@ export interface ClientStatistics {
      * they can be completed.
      */
     unackedOperationSize : number;
+
+    /**
+     * Number of messages that have been received from the server but not yet delivered to the
+     * {@link Mqtt5Client.MESSAGE_RECEIVED messageReceived} event.
+     */
+    pendingReceivedMessageCount? : number;
+
+    /**
+     * Approximate size (topic, payload and correlation data) of messages that have been received from the server but
+     * not yet delivered to the {@link Mqtt5Client.MESSAGE_RECEIVED messageReceived} event.
+     */
+    pendingReceivedMessageSize? : number;
+
+    /**
+     * Number of QoS 0 messages dropped because the
+     * {@link Mqtt5ClientConfig.inboundFlowControlOptions inbound flow control} limits were reached.
+     */
+    inboundFlowControlDroppedCount? : number;
+
+    /**
+     * Number of QoS 1 publishes recorded in the {@link Mqtt5ClientConfig.persistentQueueOptions persistent queue}
+     * that have not yet completed.  Only present if a persistent queue is configured.
+     */
+    persistentQueuePendingCount? : number;
+
+    /**
+     * Bytes currently occupied on disk by the {@link Mqtt5ClientConfig.persistentQueueOptions persistent queue}.
+     * Only present if a persistent queue is configured.
+     */
+    persistentQueueSize? : number;
+
+    /**
+     * Number of publishes being held in the {@link Mqtt5ClientConfig.offlineQueueLimits offline queue} until the
+     * client connects.  Only present if offline queue limits are configured.
+     */
+    offlineQueuedPublishCount? : number;
+
+    /**
+     * Size (topic, payload and properties) of publishes being held in the
+     * {@link Mqtt5ClientConfig.offlineQueueLimits offline queue}.  Only present if offline queue limits are configured.
+     */
+    offlineQueuedPublishSize? : number;
+
+    /**
+     * Total number of publishes evicted from the {@link Mqtt5ClientConfig.offlineQueueLimits offline queue} to stay
+     * within its limits.  Only present if offline queue limits are configured.
+     */
+    evictedPublishCount? : number;
+
+    /**
+     * Total size of publishes evicted from the {@link Mqtt5ClientConfig.offlineQueueLimits offline queue}.  Only
+     * present if offline queue limits are configured.
+     */
+    evictedPublishSize? : number;
+
+    /**
+     * Total number of received QoS 0 publishes dropped because the
+     * {@link Mqtt5ClientConfig.sharedMessageRingOptions shared message ring} was full.  Only present if the shared
+     * message ring is enabled.
+     */
+    sharedMessageRingDroppedCount? : number;
+
+    /**
+     * Total number of publishes received on a request-response subscription that did not complete any outstanding
+     * request and were dropped.  Only present once a {@link RequestResponseClient} has been created for the client.
+     */
+    unmatchedResponseCount? : number;
+
+    /**
+     * Total number of received publishes dropped by a {@link Mqtt5Client.setMessageFilter message filter} rule's
+     * predicates.  Only present once a message filter has been set.
+     */
+    filteredMessageCount? : number;
+
+    /**
+     * Total number of received publishes dropped by {@link MessageFilterRule.sampleEvery sampling}.  Only present once
+     * a message filter has been set.
+     */
+    sampledOutMessageCount? : number;
+
+    /**
+     * Total number of received publishes dropped by a {@link MessageFilterRule.maxMessagesPerSecond rate limit}.  Only
+     * present once a message filter has been set.
+     */
+    rateLimitedMessageCount? : number;
+
+    /**
+     * Per-priority delivery statistics, indexed by priority.  Only present if
+     * {@link Mqtt5ClientConfig.deliveryPriorityOptions delivery priorities} are configured.
+     */
+    deliveryPriorityStatistics? : Array<DeliveryPriorityStatistics>;
+
+    /**
+     * Per-class outbound publish queue depths, indexed by priority.  Only present if
+     * {@link Mqtt5ClientConfig.outboundPriorityOptions outbound priority scheduling} is configured.
+     */
+    outboundPriorityStatistics? : Array<OutboundPriorityStatistics>;
+
+    /**
+     * Number of topics held by the {@link Mqtt5Client.setLastValueCache last value cache}.  Only present while a
+     * last value cache is set.
+     */
+    lastValueCacheTopicCount? : number;
+
+    /**
+     * Total size of the topics and payloads held by the {@link Mqtt5Client.setLastValueCache last value cache}.  Only
+     * present while a last value cache is set.
+     */
+    lastValueCacheSize? : number;
+
+    /**
+     * Total number of topics evicted from the {@link Mqtt5Client.setLastValueCache last value cache} to stay within
+     * its limits.  Only present while a last value cache is set.
+     */
+    lastValueCacheEvictedCount? : number;
 };
 
+/**
+ * Outbound scheduling statistics for one {@link PublishOptions.priority priority} class of publishes
+ */
+export interface OutboundPriorityStatistics {
+
+    /**
+     * Priority class these statistics describe
+     */
+    priority : number;
+
+    /**
+     * Number of publishes of this class waiting to be handed to the underlying client
+     */
+    queuedCount : number;
+
+    /**
+     * Total number of publishes of this class that have been handed to the underlying client
+     */
+    submittedCount : number;
+}
+
+/**
+ * Delivery statistics for one {@link DeliveryPriorityRule.priority priority} class of received messages
+ */
+export interface DeliveryPriorityStatistics {
+
+    /**
+     * Priority class these statistics describe
+     */
+    priority : number;
+
+    /**
+     * Number of messages of this priority that have been received but not yet delivered to node
+     */
+    pendingCount : number;
+
+    /**
+     * Total number of messages of this priority that have been delivered to node
+     */
+    deliveredCount : number;
+
+    /**
+     * Average time, in microseconds, that delivered messages of this priority spent queued between being received
+     * and being delivered to node
+     */
+    averageQueueingDelayUs : number;
+
+    /**
+     * Longest time, in microseconds, that a delivered message of this priority spent queued
+     */
+    maxQueueingDelayUs : number;
+}
+
+/**
+ * Limits on how much QoS 0 data may be waiting for delivery to node.
+ *
+ * The client never stalls its event loop thread waiting for node, since that thread is shared with other
+ * connections.  Instead, QoS 0 messages that arrive while a limit is exceeded are dropped, counted in
+ * {@link ClientStatistics.inboundFlowControlDroppedCount}, and logged as a warning once per run of drops.
+ *
+ * These limits only bound QoS 0 traffic.  The client acknowledges a QoS 1 or QoS 2 message as soon as it is received,
+ * before node has handled it, so neither these limits nor receiveMaximum can hold those back: they are always
+ * delivered, still count towards the pending totals, and may take them past the limits.  Applications that need a
+ * bound on QoS 1 and QoS 2 traffic must limit what is published to them.
+ */
+export interface InboundFlowControlOptions {
+
+    /**
+     * Maximum number of received messages waiting for delivery to node.  Zero or undefined means no limit.
+     */
+    maxPendingMessageCount? : number;
+
+    /**
+     * Maximum total size, in bytes, of received messages waiting for delivery to node.  Zero or undefined means
+     * no limit.  A single message larger than the limit is still delivered once all preceding messages have been.
+     */
+    maxPendingMessageSize? : number;
+}
+
 /**
  * Controls how disconnects affect the queued and in-progress operations tracked by the client.  Also controls
  * how operations are handled while the client is not connected.  In particular, if the client is not connected,
@@ -122,6 +324,248 @@ export enum ClientExtendedValidationAndFlowControl {
     AwsIotCoreDefaults = 1,
 }
 
+/**
+ * Controls the type of the payload on received PUBLISH packets
+ */
+export enum Utf8PayloadDelivery {
+
+    /**
+     * Payloads are always delivered as ArrayBuffers.
+     */
+    Binary = 0,
+
+    /**
+     * Payloads whose payload format indicator is {@link PayloadFormatIndicator.Utf8} are delivered as strings; all
+     * others are delivered as ArrayBuffers.
+     */
+    StringIfUtf8Indicated = 1,
+
+    /**
+     * Payloads are always delivered as strings.  Invalid UTF-8 sequences are replaced with U+FFFD.
+     */
+    AlwaysString = 2,
+}
+
+/**
+ * Controls which held publish is evicted when holding another would exceed the
+ * {@link OfflineQueueLimits offline queue limits}.
+ */
+export enum OfflineQueueEvictionPolicy {
+
+    /**
+     * Evict the oldest held publish.
+     */
+    Oldest = 0,
+
+    /**
+     * Evict the oldest held QoS 0 publish; QoS 1 publishes are only evicted once no QoS 0 publishes remain.  A new
+     * QoS 0 publish is rejected rather than evicting a QoS 1 publish.
+     */
+    Qos0First = 1,
+
+    /**
+     * Evict the oldest publish with the lowest {@link PublishOptions.priority priority}.  A new publish is rejected
+     * if every held publish has a higher priority.
+     */
+    LowestPriorityFirst = 2,
+}
+
+/**
+ * Bounds on the publishes the client holds while it is not connected.
+ *
+ * When configured, publishes submitted while the client is not connected are held until a connection is established
+ * and then submitted in order.  Publishes that must be evicted to respect the limits are rejected with
+ * AWS_CRT_NODEJS_ERROR_MQTT5_OPERATION_EVICTED.  Publishes submitted while connected are unaffected and remain
+ * subject to {@link Mqtt5ClientConfig.offlineQueueBehavior offlineQueueBehavior}.
+ */
+export interface OfflineQueueLimits {
+
+    /**
+     * Maximum number of held publishes.  Zero or undefined means no limit.
+     */
+    maxQueuedPublishCount? : number;
+
+    /**
+     * Maximum total size, in bytes, of held publishes (topic, payload and properties).  Zero or undefined means
+     * no limit.  A single publish larger than the limit is always rejected.
+     */
+    maxQueuedPublishSize? : number;
+
+    /**
+     * Which publish to evict when a limit would be exceeded.  Defaults to {@link OfflineQueueEvictionPolicy.Oldest}.
+     */
+    evictionPolicy? : OfflineQueueEvictionPolicy;
+}
+
+/**
+ * Node-specific options that apply to a single publish.
+ */
+export interface PublishOptions {
+
+    /**
+     * Relative importance of the publish; higher values are more important.  Used by
+     * {@link OfflineQueueEvictionPolicy.LowestPriorityFirst} and, capped at {@link MAX_PUBLISH_PRIORITY}, to pick the
+     * publish's class when {@link Mqtt5ClientConfig.outboundPriorityOptions outbound priority scheduling} is
+     * configured.  Defaults to zero.
+     */
+    priority? : number;
+}
+
+/**
+ * Highest outbound publish priority class; publishes with a larger {@link PublishOptions.priority priority} share it
+ */
+export const MAX_PUBLISH_PRIORITY : number = 3;
+
+/**
+ * Configuration for scheduling outbound publishes by priority.
+ *
+ * Publishes are held by the client in one queue per priority class, and only a bounded number are handed to the
+ * underlying MQTT client (whose own queue is first-in first-out) at a time.  Whenever one completes, the next publish
+ * is chosen from the non-empty classes by weighted round robin, so a latency-critical publish only waits behind a
+ * handful of earlier ones rather than the whole backlog, while lower priorities still make progress.
+ *
+ * When {@link Mqtt5ClientConfig.offlineQueueLimits offline queue limits} are configured, publishes made while the
+ * client is not connected bypass the priority queues and go straight to the offline queue, where its limits and
+ * eviction policy apply.  They are submitted in order when the connection is established.
+ */
+export interface OutboundPriorityOptions {
+
+    /**
+     * Maximum number of publishes that may be submitted to the underlying client and not yet complete.  Smaller
+     * values make priorities take effect sooner, larger values keep more publishes in flight on the connection.
+     * Defaults to 16.
+     */
+    maxInFlightPublishes? : number;
+
+    /**
+     * Relative share of submissions given to each priority class when several have publishes queued, indexed by
+     * priority.  Must hold {@link MAX_PUBLISH_PRIORITY} + 1 positive integers.  Defaults to [1, 2, 4, 8].
+     */
+    weights? : Array<number>;
+}
+
+/**
+ * Configuration for a disk-backed queue of outbound QoS 1 publishes.
+ *
+ * Every QoS 1 publish is appended to a log of segment files in the configured directory before it is submitted,
+ * and is marked complete once its outcome, success or failure, has been reported.  Publishes still pending when the
+ * process exits are resubmitted the next time a client is created with the same directory.  Fully-acknowledged
+ * segments are deleted as completions are written out.
+ *
+ * A directory must only be used by one client at a time.  Each publish is synced to disk before the publish call
+ * returns, so it survives a crash or power failure.  Completions are written lazily, so after a crash a publish that
+ * had already completed may be resubmitted once more.
+ */
+export interface PersistentQueueOptions {
+
+    /**
+     * Directory to store the queue's segment files in.  Created if it does not exist.
+     */
+    directory : string;
+
+    /**
+     * Maximum number of bytes the queue may occupy on disk.  QoS 1 publishes that would exceed this limit are
+     * rejected.  Defaults to 64MB.
+     */
+    maxSizeBytes? : number;
+
+    /**
+     * Size at which the queue starts a new segment file.  Smaller segments let disk space be reclaimed sooner.
+     * Defaults to 4MB.
+     */
+    segmentSizeBytes? : number;
+}
+
+/**
+ * Configuration for delivering received publishes through a ring buffer in shared memory.
+ *
+ * The client's I/O thread writes each received publish (topic, properties and payload) directly into a
+ * SharedArrayBuffer, and node is only woken when the ring goes from empty to non-empty.  This removes the per-message
+ * threadsafe function call and native allocations, at the cost of a bounded buffer: QoS 0 publishes that arrive while
+ * the ring is full are dropped and counted in {@link ClientStatistics.sharedMessageRingDroppedCount}.  QoS 1 and 2
+ * publishes that do not fit are never dropped; they are delivered individually, subject to
+ * {@link Mqtt5ClientConfig.inboundFlowControlOptions inbound flow control}, and may overtake messages still in the
+ * ring.
+ */
+export interface SharedMessageRingOptions {
+
+    /**
+     * Size of the ring's data region.  Rounded up to a power of two between 4KB and 1GB.  Must be large enough to
+     * hold the largest expected burst of messages, and at least as large as the largest single message.
+     */
+    sizeInBytes : number;
+}
+
+/**
+ * Configuration for merging concurrent subscribe calls into multi-topic SUBSCRIBE packets.
+ *
+ * Subscribes submitted within a short window of each other are sent as a single SUBSCRIBE, and each caller's promise
+ * is resolved with a SUBACK holding just the reason codes of its own subscriptions.  Subscribes carrying a subscription
+ * identifier or user properties are never merged, since those apply to the whole packet.
+ */
+export interface SubscribeCoalescingOptions {
+
+    /**
+     * How long, in milliseconds, the first subscribe of a batch waits for others to join it.  Defaults to 5.
+     */
+    windowMs? : number;
+
+    /**
+     * Maximum number of subscriptions in a merged SUBSCRIBE packet.  Defaults to 8, the per-packet limit of AWS IoT
+     * Core.  Merged packets are also kept within the maximum packet size negotiated with the server.
+     */
+    maxSubscriptionsPerPacket? : number;
+}
+
+/**
+ * Highest priority that may be assigned to received messages by a {@link DeliveryPriorityRule}
+ */
+export const MAX_DELIVERY_PRIORITY : number = 3;
+
+/**
+ * Assigns a delivery priority to received messages whose topic matches a topic filter
+ */
+export interface DeliveryPriorityRule {
+
+    /**
+     * Topic filter, wildcards included, selecting the messages this rule applies to
+     */
+    topicFilter : string;
+
+    /**
+     * Priority of matching messages, from 0 (lowest) to {@link MAX_DELIVERY_PRIORITY}
+     */
+    priority : number;
+}
+
+/**
+ * Configuration for delivering received messages to node in priority order.
+ *
+ * When node falls behind the rate messages are received, those waiting for delivery are handed to the
+ * {@link Mqtt5Client.MESSAGE_RECEIVED messageReceived} event highest priority first, and in arrival order within a
+ * priority.  Messages of a lower priority can therefore be delayed indefinitely by a steady stream of higher priority
+ * ones.  Does not apply to messages delivered through a shared message ring.
+ */
+export interface DeliveryPriorityOptions {
+
+    /**
+     * Ordered list of priority rules.  A message is given the priority of the first rule matching its topic, or 0 if
+     * none match.
+     */
+    rules : Array<DeliveryPriorityRule>;
+}
+
+/**
+ * Configuration for parsing received payloads as JSON off of the JavaScript thread
+ */
+export interface JsonPayloadOptions {
+
+    /**
+     * Topic filters, wildcards included, selecting the messages whose payloads are parsed
+     */
+    topicFilters : Array<string>;
+}
+
 /**
  * Configuration options for mqtt5 client creation.
  */
@@ -243,6 +687,16 @@ export interface Mqtt5ClientConfig {
      */
     websocketHandshakeTransform?: WebsocketHandshakeTransform;
 
+    /**
+     * Signs the websocket handshake natively with the given credentials provider and signing configuration, so that
+     * connection attempts do not have to call back into JavaScript.  Websockets will be used if this is set.  The
+     * date in the configuration is ignored; every handshake is signed as of the time it is made.  Cannot be combined
+     * with websocketHandshakeTransform.
+     *
+     * @group Node-only
+     */
+    websocketSigningConfig?: auth.AwsSigningConfig;
+
     /**
      * Configures (tunneling) HTTP proxy usage when establishing MQTT connections
      *
@@ -257,33 +711,165 @@ export interface Mqtt5ClientConfig {
      * @group Node-only
      */
     extendedValidationAndFlowControlOptions? : ClientExtendedValidationAndFlowControl;
-}
 
-/**
- * Node.js specific MQTT5 client implementation
- *
- * Not all parts of the MQTT5 spec are supported. We currently do not support:
- *
- * * AUTH packets and the authentication fields in the CONNECT packet
- * * QoS 2
- *
- * [MQTT5 Client User Guide](https://www.github.com/awslabs/aws-crt-nodejs/blob/main/MQTT5-UserGuide.md)
- *
- * This client is based on native resources.  When finished with the client, you must call close() to dispose of
- * them or they will leak.
- *
- */
-export class Mqtt5Client extends NativeResourceMixin(BufferedEventEmitter) implements mqtt5.IMqtt5Client {
+    /**
+     * Bounds the amount of received QoS 0 data that may be waiting for delivery to node.  If undefined, incoming
+     * messages are queued for delivery without limit.
+     *
+     * @group Node-only
+     */
+    inboundFlowControlOptions? : InboundFlowControlOptions;
 
     /**
-     * Client constructor
+     * Persists outbound QoS 1 publishes to disk so that they survive a process restart.  If undefined, queued
+     * publishes are held only in memory.
      *
-     * @param config The configuration for this client
+     * @group Node-only
      */
-    constructor(config: Mqtt5ClientConfig) {
-        super();
+    persistentQueueOptions? : PersistentQueueOptions;
 
-        this._super(crt_native.mqtt5_client_new(
+    /**
+     * Bounds the count and size of publishes held while the client is not connected.  If undefined, publishes
+     * submitted while disconnected are queued by the client without limit.
+     *
+     * @group Node-only
+     */
+    offlineQueueLimits? : OfflineQueueLimits;
+
+    /**
+     * Controls whether received payloads are delivered as strings rather than ArrayBuffers.  Strings are created
+     * natively, avoiding an extra copy and decode step in JavaScript.  Defaults to
+     * {@link Utf8PayloadDelivery.Binary}.
+     *
+     * @group Node-only
+     */
+    utf8PayloadDelivery? : Utf8PayloadDelivery;
+
+    /**
+     * When true, received PUBLISH packets only convert their topic, payload, qos and retain fields up front.  The
+     * remaining fields (user properties, subscription identifiers, response topic, correlation data, etc...) are
+     * converted from native storage the first time they are read, and that storage is kept alive until the packet is
+     * garbage collected.  They are own enumerable properties, so spread, Object.keys and JSON.stringify see them (and
+     * convert them); unlike the default packets, fields the PUBLISH didn't carry are present with a value of
+     * undefined.  Defaults to false.
+     *
+     * @group Node-only
+     */
+    lazyPublishProperties? : boolean;
+
+    /**
+     * Number of distinct received topics whose strings the client keeps, least recently used first out, so that
+     * messages on a recurring topic share a single string rather than allocating a new one each time.  Worthwhile
+     * when a bounded set of topics carries most traffic.  If undefined or 0, every message gets a new topic string.
+     *
+     * @group Node-only
+     */
+    topicInternCacheSize? : number;
+
+    /**
+     * When true, received PUBLISH packets cross the native boundary as a compact binary record in a reused buffer
+     * and are decoded in JavaScript, instead of being built one property at a time through N-API.  Variable-length
+     * secondary fields (response topic, correlation data, content type, subscription identifiers and user
+     * properties) are decoded on first access.  Cannot be combined with lazyPublishProperties.  Defaults to false.
+     *
+     * @group Node-only
+     */
+    binaryPublishEncoding? : boolean;
+
+    /**
+     * Delivers received publishes through a ring buffer in shared memory instead of one native-to-node call per
+     * message.  Messages are decoded as with binaryPublishEncoding.  Cannot be combined with lazyPublishProperties.
+     *
+     * @group Node-only
+     */
+    sharedMessageRingOptions? : SharedMessageRingOptions;
+
+    /**
+     * Merges subscribe calls made close together into multi-topic SUBSCRIBE packets, trading a few milliseconds of
+     * latency per subscribe for far fewer SUBSCRIBE/SUBACK round trips when many topics are subscribed at once.
+     *
+     * @group Node-only
+     */
+    subscribeCoalescingOptions? : SubscribeCoalescingOptions;
+
+    /**
+     * Delivers received messages waiting for node in priority order rather than arrival order, so that control or
+     * alarm topics are not stuck behind a backlog of bulk telemetry.  Per-priority queueing delay is reported in
+     * {@link ClientStatistics.deliveryPriorityStatistics}.
+     *
+     * @group Node-only
+     */
+    deliveryPriorityOptions? : DeliveryPriorityOptions;
+
+    /**
+     * Schedules outbound publishes by {@link PublishOptions.priority priority} instead of submission order, so that
+     * urgent publishes are not stuck behind large batches.
+     *
+     * @group Node-only
+     */
+    outboundPriorityOptions? : OutboundPriorityOptions;
+
+    /**
+     * Validates and tokenizes the payloads of received publishes on selected topics as JSON on the client's I/O
+     * thread.  Matching messages carry the parsed value in {@link MessageReceivedEvent.json}, built from the
+     * native tokens only when first read, or the reason the payload is not JSON in
+     * {@link MessageReceivedEvent.jsonError}.  Payloads must be valid UTF-8.  The payload itself is still
+     * delivered.  Does not apply to messages delivered through a shared message ring.
+     *
+     * Building a value from the tokens is not necessarily cheaper than JSON.parse; the gain is in moving validation
+     * off the JavaScript thread and skipping it for values that are never read.  Measure with the json_payload
+     * benchmark under benchmark/mqtt5 before relying on it.
+     *
+     * @group Node-only
+     */
+    jsonPayloadOptions? : JsonPayloadOptions;
+}
+
+/**
+ * Node.js specific MQTT5 client implementation
+ *
+ * Not all parts of the MQTT5 spec are supported. We currently do not support:
+ *
+ * * AUTH packets and the authentication fields in the CONNECT packet
+ * * QoS 2
+ *
+ * [MQTT5 Client User Guide](https://www.github.com/awslabs/aws-crt-nodejs/blob/main/MQTT5-UserGuide.md)
+ *
+ * This client is based on native resources.  When finished with the client, you must call close() to dispose of
+ * them or they will leak.
+ *
+ */
+export class Mqtt5Client extends NativeResourceMixin(BufferedEventEmitter) implements mqtt5.IMqtt5Client {
+
+    private publishRecordDecoder : PublishRecordDecoder = new PublishRecordDecoder();
+    private messageRing? : SharedMessageRing;
+    private subscribeCoalescer? : SubscribeCoalescer;
+    private maximumPacketSizeToServer? : number;
+    private liveStatistics? : LiveStatistics;
+    private lazyPublishProperties : boolean;
+
+    /**
+     * Client constructor
+     *
+     * @param config The configuration for this client
+     */
+    constructor(config: Mqtt5ClientConfig) {
+        super();
+
+        this.lazyPublishProperties = config.lazyPublishProperties ?? false;
+
+        if (config.sharedMessageRingOptions) {
+            this.messageRing = new SharedMessageRing(config.sharedMessageRingOptions.sizeInBytes, config.utf8PayloadDelivery);
+        }
+
+        if (config.subscribeCoalescingOptions) {
+            this.subscribeCoalescer = new SubscribeCoalescer(
+                config.subscribeCoalescingOptions,
+                (packet: mqtt5_packet.SubscribePacket) => this.subscribeImmediately(packet),
+                () => this.maximumPacketSizeToServer);
+        }
+
+        this._super(crt_native.mqtt5_client_new(
             this,
             config,
             (client: Mqtt5Client) => { Mqtt5Client._s_on_stopped(client); },
@@ -291,11 +877,13 @@ export class Mqtt5Client extends NativeResourceMixin(BufferedEventEmitter) imple
             (client: Mqtt5Client, connack : mqtt5_packet.ConnackPacket, settings: mqtt5.NegotiatedSettings) => { Mqtt5Client._s_on_connection_success(client, connack, settings); },
             (client: Mqtt5Client, errorCode: number, connack? : mqtt5_packet.ConnackPacket) => { Mqtt5Client._s_on_connection_failure(client, new CrtError(errorCode), connack); },
             (client: Mqtt5Client, errorCode: number, disconnect? : mqtt5_packet.DisconnectPacket) => { Mqtt5Client._s_on_disconnection(client, new CrtError(errorCode), disconnect); },
-            (client: Mqtt5Client, message : mqtt5_packet.PublishPacket) => { Mqtt5Client._s_on_message_received(client, message); },
+            (client: Mqtt5Client, message : mqtt5_packet.PublishPacket | ArrayBuffer, recordLength?: number, payload?: mqtt5_packet.Payload, json?: ArrayBuffer | mqtt5.JsonParseError) => { Mqtt5Client._s_on_message_received(client, message, recordLength, payload, json); },
             config.clientBootstrap ? config.clientBootstrap.native_handle() : null,
             config.socketOptions ? config.socketOptions.native_handle() : null,
             config.tlsCtx ? config.tlsCtx.native_handle() : null,
-            config.httpProxyOptions ? config.httpProxyOptions.create_native_handle() : null
+            config.httpProxyOptions ? config.httpProxyOptions.create_native_handle() : null,
+            this.messageRing ? this.messageRing.memory : null,
+            (client: Mqtt5Client) => { Mqtt5Client._s_on_message_ring_ready(client); }
         ));
     }
 
@@ -320,6 +908,7 @@ export class Mqtt5Client extends NativeResourceMixin(BufferedEventEmitter) imple
      * @group Node-only
      */
     close() {
+        this.subscribeCoalescer?.flush();
         crt_native.mqtt5_client_close(this.native_handle());
     }
 
@@ -355,6 +944,14 @@ export class Mqtt5Client extends NativeResourceMixin(BufferedEventEmitter) imple
      * @returns a promise that will be rejected with an error or resolved with the SUBACK response
      */
     async subscribe(packet: mqtt5_packet.SubscribePacket) : Promise<mqtt5_packet.SubackPacket> {
+        if (this.subscribeCoalescer) {
+            return this.subscribeCoalescer.submit(packet);
+        }
+
+        return this.subscribeImmediately(packet);
+    }
+
+    private subscribeImmediately(packet: mqtt5_packet.SubscribePacket) : Promise<mqtt5_packet.SubackPacket> {
         return new Promise<mqtt5_packet.SubackPacket>((resolve, reject) => {
 
             function curriedPromiseCallback(client: Mqtt5Client, errorCode: number, suback?: mqtt5_packet.SubackPacket){
@@ -376,6 +973,9 @@ export class Mqtt5Client extends NativeResourceMixin(BufferedEventEmitter) imple
      * @returns a promise that will be rejected with an error or resolved with the UNSUBACK response
      */
     async unsubscribe(packet: mqtt5_packet.UnsubscribePacket) : Promise<mqtt5_packet.UnsubackPacket> {
+        /* a subscribe still waiting to be merged must not be sent after an unsubscribe that followed it */
+        this.subscribeCoalescer?.flush();
+
         return new Promise<mqtt5_packet.UnsubackPacket>((resolve, reject) => {
 
             function curriedPromiseCallback(client: Mqtt5Client, errorCode: number, unsuback?: mqtt5_packet.UnsubackPacket){
@@ -394,10 +994,11 @@ export class Mqtt5Client extends NativeResourceMixin(BufferedEventEmitter) imple
      * Send a message to subscribing clients by queuing a PUBLISH packet to be sent to the server.
      *
      * @param packet PUBLISH packet to send to the server
+     * @param options Node-specific options for this publish
      * @returns a promise that will be rejected with an error or resolved with the PUBACK response (QoS 1) or
      * undefined (QoS 0)
      */
-    async publish(packet: mqtt5_packet.PublishPacket) : Promise<mqtt5.PublishCompletionResult> {
+    async publish(packet: mqtt5_packet.PublishPacket, options?: PublishOptions) : Promise<mqtt5.PublishCompletionResult> {
         return new Promise<mqtt5.PublishCompletionResult>((resolve, reject) => {
 
             if (packet && packet.payload) {
@@ -409,20 +1010,146 @@ export class Mqtt5Client extends NativeResourceMixin(BufferedEventEmitter) imple
             }
 
             try {
-                crt_native.mqtt5_client_publish(this.native_handle(), packet, curriedPromiseCallback);
+                crt_native.mqtt5_client_publish(this.native_handle(), packet, options, curriedPromiseCallback);
+            } catch (e) {
+                reject(e);
+            }
+        });
+    }
+
+    /**
+     * Extracts every field of a PUBLISH packet except the payload once, so that publishes which differ only by
+     * payload skip re-reading the topic and properties each time.  Any payload in the template is ignored.
+     *
+     * @param packet template for the publishes made with {@link publishPrepared}
+     * @returns a prepared publish usable only with this client
+     *
+     * @group Node-only
+     */
+    preparePublish(packet: mqtt5_packet.PublishPacket) : PreparedPublish {
+        return new PreparedPublish(this, crt_native.mqtt5_client_prepare_publish(this.native_handle(), packet));
+    }
+
+    /**
+     * Sends a message built from a prepared template and a payload.  Equivalent to {@link publish} with the
+     * template's fields and the given payload.
+     *
+     * @param prepared template created by this client's {@link preparePublish}
+     * @param payload payload of this message
+     * @param options Node-specific options for this publish
+     * @returns a promise that will be rejected with an error or resolved with the PUBACK response (QoS 1) or
+     * undefined (QoS 0)
+     *
+     * @group Node-only
+     */
+    async publishPrepared(prepared: PreparedPublish, payload?: mqtt5_packet.Payload, options?: PublishOptions) : Promise<mqtt5.PublishCompletionResult> {
+        return new Promise<mqtt5.PublishCompletionResult>((resolve, reject) => {
+
+            if (prepared.client !== this) {
+                reject(new CrtError("publishPrepared - prepared publish belongs to a different client"));
+                return;
+            }
+
+            let normalizedPayload : string | Buffer | null = payload !== undefined && payload !== null ? mqtt_shared.normalize_payload(payload) : null;
+
+            function curriedPromiseCallback(client: Mqtt5Client, errorCode: number, result: mqtt5.PublishCompletionResult){
+                return Mqtt5Client._s_on_puback_callback(resolve, reject, client, errorCode, result);
+            }
+
+            try {
+                crt_native.mqtt5_client_publish_prepared(this.native_handle(), prepared.native_handle(), normalizedPayload, options, curriedPromiseCallback);
             } catch (e) {
                 reject(e);
             }
         });
     }
 
+    /**
+     * Installs rules that drop or sample received publishes natively, before they are copied for delivery to
+     * {@link Mqtt5Client.MESSAGE_RECEIVED messageReceived} listeners.  Replaces any previous rules (along with their
+     * sampling and rate limit state); an empty or missing list removes filtering.  Dropped messages are counted in
+     * {@link getOperationalStatistics}.
+     *
+     * Request-response responses are routed before filtering and never dropped by it.
+     *
+     * @param rules filter rules, evaluated in order
+     *
+     * @group Node-only
+     */
+    setMessageFilter(rules?: Array<MessageFilterRule>) {
+        crt_native.mqtt5_client_set_message_filter(this.native_handle(), rules && rules.length > 0 ? rules : null);
+    }
+
+    /**
+     * Installs a native cache of the latest message received on each topic matching a set of topic filters, which can
+     * then be read with {@link getLastValue} and {@link getLastValueSnapshot} without handling every message in
+     * JavaScript.  Replaces any previous cache, discarding its contents; a missing options object removes caching.
+     *
+     * Messages dropped by a {@link setMessageFilter message filter} are not cached.
+     *
+     * @param options cache configuration
+     *
+     * @group Node-only
+     */
+    setLastValueCache(options?: LastValueCacheOptions) {
+        crt_native.mqtt5_client_set_last_value_cache(this.native_handle(), options ?? null);
+    }
+
+    /**
+     * Reads the latest cached message on a topic
+     *
+     * @param topic exact topic to look up
+     * @returns the latest message, or undefined if none is cached or no last value cache is set
+     *
+     * @group Node-only
+     */
+    getLastValue(topic: string) : LastValue | undefined {
+        return crt_native.mqtt5_client_get_last_value(this.native_handle(), topic);
+    }
+
+    /**
+     * Reads the latest cached message of every cached topic starting with a prefix
+     *
+     * @param topicPrefix prefix to match topics against; all cached topics are returned if omitted
+     * @returns the latest messages, least recently used topic first
+     *
+     * @group Node-only
+     */
+    getLastValueSnapshot(topicPrefix?: string) : Array<LastValue> {
+        return crt_native.mqtt5_client_get_last_value_snapshot(this.native_handle(), topicPrefix ?? "");
+    }
+
+    /**
+     * Starts keeping counters of the client's activity in shared memory that native code updates in place, so that
+     * they can be read at any rate without the cost of {@link getOperationalStatistics}.  Counting starts with the
+     * first call; later calls return the same counters.
+     *
+     * @returns the client's live statistics
+     *
+     * @group Node-only
+     */
+    enableLiveStatistics() : LiveStatistics {
+        if (!this.liveStatistics) {
+            let liveStatistics : LiveStatistics = new LiveStatistics();
+            crt_native.mqtt5_client_set_live_statistics(this.native_handle(), new Uint8Array(liveStatistics.memory));
+            this.liveStatistics = liveStatistics;
+        }
+
+        return this.liveStatistics;
+    }
+
     /**
      * Queries a small set of numerical statistics about the current state of the client's operation queue
      *
      * @group Node-only
      */
     getOperationalStatistics() : ClientStatistics {
-        return crt_native.mqtt5_client_get_queue_statistics(this.native_handle());
+        let statistics : ClientStatistics = crt_native.mqtt5_client_get_queue_statistics(this.native_handle());
+        if (this.messageRing) {
+            statistics.sharedMessageRingDroppedCount = this.messageRing.droppedCount;
+        }
+
+        return statistics;
     }
 
     /**
@@ -600,6 +1327,8 @@ export class Mqtt5Client extends NativeResourceMixin(BufferedEventEmitter) imple
     }
 
     private static _s_on_connection_success(client: Mqtt5Client, connack: mqtt5_packet.ConnackPacket, settings: mqtt5.NegotiatedSettings) {
+        client.maximumPacketSizeToServer = settings.maximumPacketSizeToServer;
+
         let connectionSuccessEvent: mqtt5.ConnectionSuccessEvent = {
             connack: connack,
             settings: settings
@@ -662,13 +1391,1300 @@ export class Mqtt5Client extends NativeResourceMixin(BufferedEventEmitter) imple
         }
     }
 
-    private static _s_on_message_received(client: Mqtt5Client, message : mqtt5_packet.PublishPacket) {
+    private static _s_on_message_ring_ready(client: Mqtt5Client) {
+        client.messageRing?.drain((message : mqtt5_packet.PublishPacket) => {
+            Mqtt5Client._s_on_message_received(client, message);
+        });
+    }
+
+    private static _s_on_message_received(client: Mqtt5Client, message : mqtt5_packet.PublishPacket | ArrayBuffer, recordLength?: number, payload?: mqtt5_packet.Payload, json?: ArrayBuffer | mqtt5.JsonParseError) {
+        if (message instanceof ArrayBuffer) {
+            /* the record buffer is reused by the next message, so it must be decoded before returning */
+            message = client.publishRecordDecoder.decode(message, 0, recordLength ?? 0, payload);
+        } else if (client.lazyPublishProperties) {
+            defineOwnLazyPublishProperties(message);
+        }
+
         let messageReceivedEvent: mqtt5.MessageReceivedEvent = {
             message: message
         };
 
+        if (json instanceof ArrayBuffer) {
+            defineLazyJsonProperty(messageReceivedEvent, json);
+        } else if (json !== undefined) {
+            messageReceivedEvent.jsonError = json;
+        }
+
         process.nextTick(() => {
             client.emit(Mqtt5Client.MESSAGE_RECEIVED, messageReceivedEvent);
         });
     }
-}
\ No newline at end of file
+}
+
+/* Flag bits of a binary PUBLISH record; must match aws_napi_mqtt5_publish_record_flags in mqtt5_client.c */
+enum PublishRecordFlags {
+    Retain = 0x01,
+    PayloadFormat = 0x02,
+    MessageExpiryInterval = 0x04,
+    TopicAlias = 0x08,
+    ResponseTopic = 0x10,
+    CorrelationData = 0x20,
+    ContentType = 0x40,
+}
+
+const PUBLISH_RECORD_VERSION : number = 1;
+const PUBLISH_RECORD_HEADER_SIZE : number = 20;
+
+interface PublishRecordTail {
+    responseTopic?: string;
+    correlationData?: ArrayBuffer;
+    contentType?: string;
+    subscriptionIdentifiers?: Array<number>;
+    userProperties?: Array<mqtt5_packet.UserProperty>;
+}
+
+/*
+ * A received PUBLISH decoded from a binary record.  Fixed-size fields are decoded eagerly; the variable-length tail
+ * is copied out of the shared record buffer and only decoded when one of its fields is first read.
+ */
+class BinaryPublishPacket implements mqtt5_packet.PublishPacket {
+    type: mqtt5_packet.PacketType = mqtt5_packet.PacketType.Publish;
+    topicName: string;
+    payload?: mqtt5_packet.Payload;
+    qos: mqtt5_packet.QoS;
+    retain?: boolean;
+    payloadFormat?: mqtt5_packet.PayloadFormatIndicator;
+    messageExpiryIntervalSeconds?: number;
+    topicAlias?: number;
+    responseTopic?: string;
+    correlationData?: ArrayBuffer;
+    contentType?: string;
+    subscriptionIdentifiers?: Array<number>;
+    userProperties?: Array<mqtt5_packet.UserProperty>;
+
+    constructor(topicName: string, qos: mqtt5_packet.QoS, flags: number, subscriptionIdentifierCount: number, userPropertyCount: number, encodedTail?: Buffer) {
+        this.topicName = topicName;
+        this.qos = qos;
+        defineLazyPublishTail(this, flags, subscriptionIdentifierCount, userPropertyCount, encodedTail);
+    }
+}
+
+/*
+ * Adds the tail fields present in a binary record to a packet as own enumerable accessors, so that spread,
+ * Object.keys and JSON.stringify see the same fields as on a packet built by the object path.  Reading any of them
+ * decodes the whole tail and replaces the accessors with plain data properties.
+ */
+function defineLazyPublishTail(packet: BinaryPublishPacket, flags: number, subscriptionIdentifierCount: number, userPropertyCount: number, encodedTail?: Buffer) {
+    let keys : Array<keyof PublishRecordTail> = [];
+    if (flags & PublishRecordFlags.ResponseTopic) {
+        keys.push('responseTopic');
+    }
+    if (flags & PublishRecordFlags.CorrelationData) {
+        keys.push('correlationData');
+    }
+    if (flags & PublishRecordFlags.ContentType) {
+        keys.push('contentType');
+    }
+    if (subscriptionIdentifierCount > 0) {
+        keys.push('subscriptionIdentifiers');
+    }
+    /* the object-building path always reports user properties, even when there are none */
+    keys.push('userProperties');
+
+    let decode = () : PublishRecordTail => {
+        let tail : PublishRecordTail = decodePublishRecordTail(flags, subscriptionIdentifierCount, userPropertyCount, encodedTail);
+        encodedTail = undefined;
+
+        for (let key of keys) {
+            Object.defineProperty(packet, key, { value: tail[key], writable: true, enumerable: true, configurable: true });
+        }
+
+        return tail;
+    };
+
+    for (let key of keys) {
+        Object.defineProperty(packet, key, {
+            enumerable: true,
+            configurable: true,
+            get: () => decode()[key],
+            set: (value: any) => {
+                decode();
+                (packet as any)[key] = value;
+            }
+        });
+    }
+}
+
+function decodePublishRecordTail(flags: number, subscriptionIdentifierCount: number, userPropertyCount: number, encodedTail?: Buffer) : PublishRecordTail {
+    let tail : PublishRecordTail = {};
+    let bytes : Buffer = encodedTail ?? Buffer.alloc(0);
+    let offset : number = 0;
+
+    let readString = () : string => {
+        let length : number = bytes.readUInt16BE(offset);
+        offset += 2;
+        let value : string = bytes.toString('utf8', offset, offset + length);
+        offset += length;
+        return value;
+    };
+
+    if (flags & PublishRecordFlags.ResponseTopic) {
+        tail.responseTopic = readString();
+    }
+
+    if (flags & PublishRecordFlags.CorrelationData) {
+        let length : number = bytes.readUInt16BE(offset);
+        offset += 2;
+        tail.correlationData = bytes.buffer.slice(bytes.byteOffset + offset, bytes.byteOffset + offset + length);
+        offset += length;
+    }
+
+    if (flags & PublishRecordFlags.ContentType) {
+        tail.contentType = readString();
+    }
+
+    if (subscriptionIdentifierCount > 0) {
+        tail.subscriptionIdentifiers = new Array<number>(subscriptionIdentifierCount);
+        for (let i = 0; i < subscriptionIdentifierCount; i++) {
+            tail.subscriptionIdentifiers[i] = bytes.readUInt32BE(offset);
+            offset += 4;
+        }
+    }
+
+    tail.userProperties = new Array<mqtt5_packet.UserProperty>(userPropertyCount);
+    for (let i = 0; i < userPropertyCount; i++) {
+        let name : string = readString();
+        tail.userProperties[i] = { name: name, value: readString() };
+    }
+
+    return tail;
+}
+
+/**
+ * A PUBLISH packet template whose fields were extracted natively once, created by {@link Mqtt5Client.preparePublish}.
+ * The native copy is released when the template is garbage collected.
+ *
+ * @group Node-only
+ */
+export class PreparedPublish {
+
+    /** @internal */
+    constructor(readonly client: Mqtt5Client, private readonly handle: any) {}
+
+    /** @internal */
+    native_handle() : any {
+        return this.handle;
+    }
+
+    /**
+     * Sends a message built from this template and a payload.  Shorthand for {@link Mqtt5Client.publishPrepared}.
+     *
+     * @param payload payload of this message
+     * @param options Node-specific options for this publish
+     */
+    publish(payload?: mqtt5_packet.Payload, options?: PublishOptions) : Promise<mqtt5.PublishCompletionResult> {
+        return this.client.publishPrepared(this, payload, options);
+    }
+}
+
+/**
+ * Decodes binary PUBLISH records produced by the native client when binaryPublishEncoding is enabled.  The layout is
+ * documented next to s_encode_publish_record in mqtt5_client.c.
+ *
+ * @internal
+ */
+export class PublishRecordDecoder {
+    private record? : ArrayBufferLike;
+    private view? : DataView;
+    private bytes? : Buffer;
+
+    decode(record: ArrayBufferLike, offset: number, length: number, payload?: mqtt5_packet.Payload) : mqtt5_packet.PublishPacket {
+        /* the native side reuses one buffer until it needs to grow, so the views are almost always cached */
+        if (record !== this.record) {
+            this.record = record;
+            this.view = new DataView(record);
+            this.bytes = Buffer.from(record);
+        }
+
+        let view : DataView = this.view!;
+        let bytes : Buffer = this.bytes!;
+
+        if (length < PUBLISH_RECORD_HEADER_SIZE || offset + length > record.byteLength || view.getUint8(offset) != PUBLISH_RECORD_VERSION) {
+            throw new CrtError("Unsupported binary publish record");
+        }
+
+        let qos : number = view.getUint8(offset + 1);
+        let flags : number = view.getUint8(offset + 2);
+        let topicLength : number = view.getUint16(offset + 10);
+        let subscriptionIdentifierCount : number = view.getUint32(offset + 12);
+        let userPropertyCount : number = view.getUint32(offset + 16);
+
+        let topicStart : number = offset + PUBLISH_RECORD_HEADER_SIZE;
+        let topicEnd : number = topicStart + topicLength;
+        let recordEnd : number = offset + length;
+        let topicName : string = bytes.toString('utf8', topicStart, topicEnd);
+
+        /* the tail must be copied since the shared buffer is overwritten by later messages */
+        let encodedTail : Buffer | undefined = (recordEnd > topicEnd) ? Buffer.from(bytes.subarray(topicEnd, recordEnd)) : undefined;
+
+        let packet : BinaryPublishPacket = new BinaryPublishPacket(topicName, qos, flags, subscriptionIdentifierCount, userPropertyCount, encodedTail);
+        packet.payload = payload;
+        packet.retain = (flags & PublishRecordFlags.Retain) != 0;
+
+        if (flags & PublishRecordFlags.PayloadFormat) {
+            packet.payloadFormat = view.getUint8(offset + 3);
+        }
+
+        if (flags & PublishRecordFlags.MessageExpiryInterval) {
+            packet.messageExpiryIntervalSeconds = view.getUint32(offset + 4);
+        }
+
+        if (flags & PublishRecordFlags.TopicAlias) {
+            packet.topicAlias = view.getUint16(offset + 8);
+        }
+
+        return packet;
+    }
+}
+
+/* Tags of a JSON tape value; must match aws_napi_json_tape_tag in json_tape.h */
+enum JsonTapeTag {
+    Null = 0,
+    False = 1,
+    True = 2,
+    Number = 3,
+    String = 4,
+    Array = 5,
+    Object = 6,
+}
+
+/**
+ * Builds values from the JSON tapes produced natively when jsonPayloadOptions are configured.  The layout is
+ * documented in json_tape.h.  The native side has already validated the text and resolved escapes, so this is a
+ * single pass with no scanning.
+ *
+ * @internal
+ */
+export class JsonTapeDecoder {
+    private readonly view : DataView;
+    private readonly bytes : Buffer;
+    private position : number = 0;
+
+    private constructor(tape: ArrayBuffer) {
+        this.view = new DataView(tape);
+        this.bytes = Buffer.from(tape);
+    }
+
+    static decode(tape: ArrayBuffer) : any {
+        let decoder : JsonTapeDecoder = new JsonTapeDecoder(tape);
+        let value : any = decoder.readValue();
+        if (decoder.position != tape.byteLength) {
+            throw new CrtError("Malformed JSON tape");
+        }
+
+        return value;
+    }
+
+    private readString() : string {
+        let length : number = this.view.getUint32(this.position, true);
+        let start : number = this.position + 4;
+        this.position = start + length;
+
+        return this.bytes.toString('utf8', start, this.position);
+    }
+
+    private readValue() : any {
+        let tag : number = this.view.getUint8(this.position++);
+        switch (tag) {
+            case JsonTapeTag.Null:
+                return null;
+
+            case JsonTapeTag.False:
+                return false;
+
+            case JsonTapeTag.True:
+                return true;
+
+            case JsonTapeTag.Number: {
+                let value : number = this.view.getFloat64(this.position, true);
+                this.position += 8;
+                return value;
+            }
+
+            case JsonTapeTag.String:
+                return this.readString();
+
+            case JsonTapeTag.Array: {
+                let count : number = this.view.getUint32(this.position, true);
+                this.position += 4;
+
+                let array : Array<any> = new Array(count);
+                for (let i = 0; i < count; i++) {
+                    array[i] = this.readValue();
+                }
+                return array;
+            }
+
+            case JsonTapeTag.Object: {
+                let count : number = this.view.getUint32(this.position, true);
+                this.position += 4;
+
+                let object : any = {};
+                for (let i = 0; i < count; i++) {
+                    let key : string = this.readString();
+                    let value : any = this.readValue();
+                    if (key === "__proto__") {
+                        /* JSON.parse creates an own property rather than replacing the prototype */
+                        Object.defineProperty(object, key, { value: value, writable: true, enumerable: true, configurable: true });
+                    } else {
+                        object[key] = value;
+                    }
+                }
+                return object;
+            }
+
+            default:
+                throw new CrtError("Malformed JSON tape");
+        }
+    }
+}
+
+const LAZY_PUBLISH_PROPERTY_KEYS : Array<string> = [
+    'payloadFormat', 'messageExpiryIntervalSeconds', 'topicAlias', 'responseTopic', 'correlationData',
+    'subscriptionIdentifiers', 'contentType', 'userProperties'
+];
+
+let lazyPublishPropertyDescriptors : PropertyDescriptorMap | undefined = undefined;
+
+/*
+ * The secondary fields of a lazy publish packet are accessors on its native prototype, which spread, Object.keys and
+ * JSON.stringify don't see.  This shadows each with an own enumerable accessor that converts the field with the
+ * prototype's getter on first read and then replaces itself with a plain data property holding the result.
+ */
+function defineOwnLazyPublishProperties(packet: mqtt5_packet.PublishPacket) {
+    if (lazyPublishPropertyDescriptors === undefined) {
+        let prototype : any = Object.getPrototypeOf(packet);
+        let descriptors : PropertyDescriptorMap = {};
+
+        for (let key of LAZY_PUBLISH_PROPERTY_KEYS) {
+            let convert : () => any = (Object.getOwnPropertyDescriptor(prototype, key) as PropertyDescriptor).get as () => any;
+
+            descriptors[key] = {
+                enumerable: true,
+                configurable: true,
+                get: function(this: any) {
+                    let value : any = convert.call(this);
+                    Object.defineProperty(this, key, { value: value, writable: true, enumerable: true, configurable: true });
+                    return value;
+                },
+                set: function(this: any, value: any) {
+                    Object.defineProperty(this, key, { value: value, writable: true, enumerable: true, configurable: true });
+                }
+            };
+        }
+
+        lazyPublishPropertyDescriptors = descriptors;
+    }
+
+    Object.defineProperties(packet, lazyPublishPropertyDescriptors);
+}
+
+/* Adds a json property to a message received event that decodes the tape the first time it is read */
+function defineLazyJsonProperty(event: mqtt5.MessageReceivedEvent, tape: ArrayBuffer) {
+    let value : any = undefined;
+    let decodedTape : ArrayBuffer | undefined = tape;
+
+    Object.defineProperty(event, 'json', {
+        enumerable: true,
+        configurable: true,
+        get: () => {
+            if (decodedTape !== undefined) {
+                value = JsonTapeDecoder.decode(decodedTape);
+                decodedTape = undefined;
+            }
+            return value;
+        }
+    });
+}
+
+const DEFAULT_SUBSCRIBE_COALESCING_WINDOW_MS : number = 5;
+const DEFAULT_MAX_SUBSCRIPTIONS_PER_PACKET : number = 8;
+
+/* Fixed header, packet id and an empty property block, rounded up */
+const SUBSCRIBE_PACKET_OVERHEAD : number = 16;
+
+interface CoalescedSubscribe {
+    packet : mqtt5_packet.SubscribePacket;
+    resolve : (suback: mqtt5_packet.SubackPacket) => void;
+    reject : (error: any) => void;
+}
+
+/**
+ * Batches subscribe calls into multi-topic SUBSCRIBE packets and splits the SUBACK back out to each caller.
+ *
+ * @internal
+ */
+export class SubscribeCoalescer {
+
+    private readonly windowMs : number;
+    private readonly maxSubscriptionsPerPacket : number;
+
+    private batch : Array<CoalescedSubscribe> = [];
+    private batchFilters : Set<string> = new Set();
+    private batchSubscriptionCount : number = 0;
+    private batchSize : number = SUBSCRIBE_PACKET_OVERHEAD;
+    private timer? : ReturnType<typeof setTimeout>;
+
+    constructor(options: SubscribeCoalescingOptions,
+                private readonly send: (packet: mqtt5_packet.SubscribePacket) => Promise<mqtt5_packet.SubackPacket>,
+                private readonly getMaximumPacketSize: () => number | undefined) {
+        this.windowMs = options.windowMs ?? DEFAULT_SUBSCRIBE_COALESCING_WINDOW_MS;
+        this.maxSubscriptionsPerPacket = options.maxSubscriptionsPerPacket ?? DEFAULT_MAX_SUBSCRIPTIONS_PER_PACKET;
+
+        if (!Number.isInteger(this.maxSubscriptionsPerPacket) || this.maxSubscriptionsPerPacket < 1) {
+            throw new CrtError("SubscribeCoalescingOptions - maxSubscriptionsPerPacket must be a positive integer");
+        }
+    }
+
+    submit(packet: mqtt5_packet.SubscribePacket) : Promise<mqtt5_packet.SubackPacket> {
+        let maximumPacketSize : number = this.getMaximumPacketSize() ?? Number.MAX_SAFE_INTEGER;
+        let subscriptionCount : number = packet.subscriptions?.length ?? 0;
+        let size : number = SubscribeCoalescer.estimateSubscriptionsSize(packet);
+
+        /*
+         * packet-wide properties cannot be split between callers, and oversized packets gain nothing from merging.
+         * Anything already batched was submitted first and must reach the broker first.
+         */
+        if (packet.subscriptionIdentifier !== undefined || packet.userProperties !== undefined || subscriptionCount == 0 ||
+            subscriptionCount > this.maxSubscriptionsPerPacket || SUBSCRIBE_PACKET_OVERHEAD + size > maximumPacketSize) {
+            this.flush();
+            return this.send(packet);
+        }
+
+        let hasDuplicateFilter : boolean = packet.subscriptions.some((subscription) => this.batchFilters.has(subscription.topicFilter));
+        if (hasDuplicateFilter || this.batchSubscriptionCount + subscriptionCount > this.maxSubscriptionsPerPacket ||
+            this.batchSize + size > maximumPacketSize) {
+            this.flush();
+        }
+
+        return new Promise<mqtt5_packet.SubackPacket>((resolve, reject) => {
+            this.batch.push({ packet: packet, resolve: resolve, reject: reject });
+            for (let subscription of packet.subscriptions) {
+                this.batchFilters.add(subscription.topicFilter);
+            }
+            this.batchSubscriptionCount += subscriptionCount;
+            this.batchSize += size;
+
+            if (this.timer === undefined) {
+                this.timer = setTimeout(() => { this.flush(); }, this.windowMs);
+            }
+        });
+    }
+
+    /**
+     * Sends the current batch, if any, without waiting for the window to close
+     */
+    flush() {
+        if (this.timer !== undefined) {
+            clearTimeout(this.timer);
+            this.timer = undefined;
+        }
+
+        let batch : Array<CoalescedSubscribe> = this.batch;
+        this.batch = [];
+        this.batchFilters = new Set();
+        this.batchSubscriptionCount = 0;
+        this.batchSize = SUBSCRIBE_PACKET_OVERHEAD;
+
+        if (batch.length == 0) {
+            return;
+        }
+
+        let merged : mqtt5_packet.SubscribePacket = {
+            subscriptions: ([] as Array<mqtt5_packet.Subscription>).concat(...batch.map((entry) => entry.packet.subscriptions))
+        };
+
+        this.send(merged).then((suback: mqtt5_packet.SubackPacket) => {
+            let offset : number = 0;
+            for (let entry of batch) {
+                let count : number = entry.packet.subscriptions.length;
+                entry.resolve({ ...suback, reasonCodes: suback.reasonCodes.slice(offset, offset + count) });
+                offset += count;
+            }
+        }, (error: any) => {
+            for (let entry of batch) {
+                entry.reject(error);
+            }
+        });
+    }
+
+    private static estimateSubscriptionsSize(packet: mqtt5_packet.SubscribePacket) : number {
+        let size : number = 0;
+        for (let subscription of packet.subscriptions ?? []) {
+            /* length prefix, filter and options byte */
+            size += 3 + Buffer.byteLength(subscription.topicFilter, 'utf8');
+        }
+
+        return size;
+    }
+}
+
+/* Must match shared_ring.h */
+const SHARED_RING_HEADER_SIZE : number = 64;
+const SHARED_RING_MIN_CAPACITY : number = 4096;
+const SHARED_RING_MAX_CAPACITY : number = 1 << 30;
+const SHARED_RING_WRAP_MARKER : number = 0xFFFFFFFF;
+
+enum SharedRingControlWord {
+    WritePosition = 0,
+    ReadPosition = 1,
+    ConsumerWaiting = 2,
+    DroppedRecords = 3,
+}
+
+/**
+ * Consumer side of the shared-memory message ring written by the native client (see shared_ring.h for the layout).
+ * Each record holds a binary publish record followed by the payload.
+ *
+ * @internal
+ */
+export class SharedMessageRing {
+
+    /** Handed to the native client, which writes into it from its I/O thread */
+    readonly memory : Uint8Array;
+
+    private control : Int32Array;
+    private view : DataView;
+    private bytes : Buffer;
+    private capacity : number;
+    private decoder : PublishRecordDecoder = new PublishRecordDecoder();
+
+    constructor(sizeInBytes: number, private utf8PayloadDelivery: Utf8PayloadDelivery = Utf8PayloadDelivery.Binary) {
+        let capacity : number = SHARED_RING_MIN_CAPACITY;
+        while (capacity < sizeInBytes && capacity < SHARED_RING_MAX_CAPACITY) {
+            capacity *= 2;
+        }
+
+        let buffer : SharedArrayBuffer = new SharedArrayBuffer(SHARED_RING_HEADER_SIZE + capacity);
+        this.memory = new Uint8Array(buffer);
+        this.control = new Int32Array(buffer, 0, 4);
+        this.view = new DataView(buffer);
+        this.bytes = Buffer.from(buffer);
+        this.capacity = capacity;
+    }
+
+    get droppedCount() : number {
+        return Atomics.load(this.control, SharedRingControlWord.DroppedRecords) >>> 0;
+    }
+
+    /**
+     * Decodes every record currently in the ring, then tells producers that the next record needs a wakeup.  If
+     * a record slipped in before that, draining continues so it is not stranded.
+     */
+    drain(onMessage: (message: mqtt5_packet.PublishPacket) => void) {
+        let readPosition : number = Atomics.load(this.control, SharedRingControlWord.ReadPosition);
+
+        while (true) {
+            let writePosition : number = Atomics.load(this.control, SharedRingControlWord.WritePosition);
+            let messages : Array<mqtt5_packet.PublishPacket> = [];
+
+            while (readPosition != writePosition) {
+                let offset : number = readPosition & (this.capacity - 1);
+                let entryStart : number = SHARED_RING_HEADER_SIZE + offset;
+                let recordLength : number = this.view.getUint32(entryStart);
+
+                if (recordLength == SHARED_RING_WRAP_MARKER) {
+                    readPosition = (readPosition + (this.capacity - offset)) | 0;
+                    continue;
+                }
+
+                messages.push(this.decodeRecord(entryStart + 4, recordLength));
+                readPosition = (readPosition + 4 + ((recordLength + 3) & ~3)) | 0;
+            }
+
+            /* everything up to here has been copied out, so producers may reuse the space */
+            Atomics.store(this.control, SharedRingControlWord.ReadPosition, readPosition);
+
+            for (let message of messages) {
+                onMessage(message);
+            }
+
+            Atomics.store(this.control, SharedRingControlWord.ConsumerWaiting, 1);
+            if (Atomics.load(this.control, SharedRingControlWord.WritePosition) == readPosition) {
+                return;
+            }
+
+            Atomics.store(this.control, SharedRingControlWord.ConsumerWaiting, 0);
+        }
+    }
+
+    private decodeRecord(start: number, length: number) : mqtt5_packet.PublishPacket {
+        let publishRecordLength : number = this.view.getUint32(start);
+        let publishRecordStart : number = start + 4;
+        let payloadStart : number = publishRecordStart + publishRecordLength;
+        let payloadEnd : number = start + length;
+
+        let packet : mqtt5_packet.PublishPacket = this.decoder.decode(this.memory.buffer, publishRecordStart, publishRecordLength);
+
+        let deliverAsString : boolean = this.utf8PayloadDelivery == Utf8PayloadDelivery.AlwaysString ||
+            (this.utf8PayloadDelivery == Utf8PayloadDelivery.StringIfUtf8Indicated && packet.payloadFormat == mqtt5_packet.PayloadFormatIndicator.Utf8);
+
+        if (deliverAsString) {
+            packet.payload = this.bytes.toString('utf8', payloadStart, payloadEnd);
+        } else {
+            let payload : ArrayBuffer = new ArrayBuffer(payloadEnd - payloadStart);
+            new Uint8Array(payload).set(this.bytes.subarray(payloadStart, payloadEnd));
+            packet.payload = payload;
+        }
+
+        return packet;
+    }
+}
+
+/**
+ * How a {@link Mqtt5ClientPool} chooses the client that sends a publish
+ */
+export enum PoolPublishRouting {
+
+    /**
+     * Publishes to the same topic always go through the same client, preserving per-topic ordering.
+     */
+    TopicHash = 0,
+
+    /**
+     * Publishes are spread evenly across clients in turn.  No ordering between publishes is preserved.
+     */
+    RoundRobin = 1,
+}
+
+/**
+ * Configuration options for creating a {@link Mqtt5ClientPool}
+ */
+export interface Mqtt5ClientPoolConfig {
+
+    /**
+     * Configuration shared by every client in the pool.  If a client id is set in the connect properties, each
+     * client appends "-&lt;index&gt;" to it.  If a persistent queue is configured, each client uses a subdirectory
+     * named after its index.
+     */
+    clientConfig : Mqtt5ClientConfig;
+
+    /**
+     * Number of clients, and therefore connections, in the pool.
+     */
+    clientCount : number;
+
+    /**
+     * How publishes are distributed across clients.  Defaults to {@link PoolPublishRouting.TopicHash}.
+     */
+    publishRouting? : PoolPublishRouting;
+
+    /**
+     * Number of dedicated event loop threads the pool's connections run on.  Defaults to clientCount so that each
+     * connection gets its own thread.  Zero shares the process-wide event loop.  Ignored if clientConfig
+     * specifies a client bootstrap.
+     */
+    eventLoopThreadCount? : number;
+}
+
+/**
+ * Spreads MQTT5 traffic across several connections to get past the throughput of a single connection (or a
+ * per-connection server quota).
+ *
+ * Every topic filter is owned by exactly one client, chosen by hashing the filter, so a message is never delivered
+ * twice because of the pool.  Publishes are routed by topic hash or round robin.  Messages received by any client
+ * are emitted from the pool as {@link Mqtt5Client.MESSAGE_RECEIVED messageReceived} events.
+ *
+ * Like {@link Mqtt5Client}, a pool must be closed when no longer needed.
+ *
+ * @group Node-only
+ */
+export class Mqtt5ClientPool extends BufferedEventEmitter {
+
+    private readonly clients : Mqtt5Client[] = [];
+    private readonly publishRouting : PoolPublishRouting;
+    private nextPublishClient : number = 0;
+    private stoppedClientCount : number = 0;
+
+    /**
+     * Pool constructor
+     *
+     * @param config The configuration for this pool
+     */
+    constructor(config: Mqtt5ClientPoolConfig) {
+        super();
+
+        if (!Number.isInteger(config.clientCount) || config.clientCount < 1) {
+            throw new CrtError("Mqtt5ClientPool - clientCount must be a positive integer");
+        }
+
+        this.publishRouting = config.publishRouting ?? PoolPublishRouting.TopicHash;
+
+        let clientBootstrap = config.clientConfig.clientBootstrap;
+        let eventLoopThreadCount = config.eventLoopThreadCount ?? config.clientCount;
+        if (!clientBootstrap && eventLoopThreadCount > 0) {
+            clientBootstrap = new io.ClientBootstrap(eventLoopThreadCount);
+        }
+
+        for (let i = 0; i < config.clientCount; i++) {
+            let client = new Mqtt5Client(Mqtt5ClientPool.makeClientConfig(config.clientConfig, i, clientBootstrap));
+
+            client.on(Mqtt5Client.MESSAGE_RECEIVED, (event: mqtt5.MessageReceivedEvent) => {
+                this.emit(Mqtt5Client.MESSAGE_RECEIVED, event);
+            });
+            client.on(Mqtt5Client.ERROR, (error: CrtError) => {
+                this.emit(Mqtt5Client.ERROR, error);
+            });
+            client.on(Mqtt5Client.STOPPED, (event: mqtt5.StoppedEvent) => {
+                this.stoppedClientCount++;
+                if (this.stoppedClientCount == this.clients.length) {
+                    this.emit(Mqtt5Client.STOPPED, event);
+                }
+            });
+
+            this.clients.push(client);
+        }
+    }
+
+    /**
+     * The clients making up the pool, for per-connection lifecycle events
+     */
+    getClients() : ReadonlyArray<Mqtt5Client> {
+        return this.clients;
+    }
+
+    /**
+     * Triggers cleanup of the native resources of every client in the pool.
+     */
+    close() {
+        for (let client of this.clients) {
+            client.close();
+        }
+    }
+
+    /**
+     * Starts every client in the pool.
+     */
+    start() {
+        this.stoppedClientCount = 0;
+        for (let client of this.clients) {
+            client.start();
+        }
+    }
+
+    /**
+     * Stops every client in the pool.  The pool emits {@link Mqtt5Client.STOPPED stopped} once all clients have
+     * stopped.
+     *
+     * @param packet (optional) properties of a DISCONNECT packet sent by each client
+     */
+    stop(packet?: mqtt5_packet.DisconnectPacket) {
+        for (let client of this.clients) {
+            client.stop(packet);
+        }
+    }
+
+    /**
+     * Subscribes to one or more topic filters.  Filters owned by different clients are sent as separate SUBSCRIBE
+     * packets; the resulting reason codes are reassembled in the order of the original subscriptions.
+     *
+     * @param packet SUBSCRIBE packet to send
+     * @returns a promise that will be rejected with an error or resolved with the combined SUBACK
+     */
+    async subscribe(packet: mqtt5_packet.SubscribePacket) : Promise<mqtt5_packet.SubackPacket> {
+        let owners = this.groupByOwner(packet.subscriptions.map((subscription) => subscription.topicFilter));
+        let reasonCodes : mqtt5_packet.SubackReasonCode[] = new Array(packet.subscriptions.length);
+
+        let subacks = await Promise.all(Array.from(owners.entries()).map(async ([clientIndex, indices]) => {
+            let suback = await this.clients[clientIndex].subscribe({
+                ...packet,
+                subscriptions: indices.map((index) => packet.subscriptions[index])
+            });
+            indices.forEach((originalIndex, i) => { reasonCodes[originalIndex] = suback.reasonCodes[i]; });
+            return suback;
+        }));
+
+        return Mqtt5ClientPool.mergeAcks<mqtt5_packet.SubackPacket>({ type: mqtt5_packet.PacketType.Suback, reasonCodes: reasonCodes }, subacks);
+    }
+
+    /**
+     * Unsubscribes from one or more topic filters, routing each filter to the client that owns it.
+     *
+     * @param packet UNSUBSCRIBE packet to send
+     * @returns a promise that will be rejected with an error or resolved with the combined UNSUBACK
+     */
+    async unsubscribe(packet: mqtt5_packet.UnsubscribePacket) : Promise<mqtt5_packet.UnsubackPacket> {
+        let owners = this.groupByOwner(packet.topicFilters);
+        let reasonCodes : mqtt5_packet.UnsubackReasonCode[] = new Array(packet.topicFilters.length);
+
+        let unsubacks = await Promise.all(Array.from(owners.entries()).map(async ([clientIndex, indices]) => {
+            let unsuback = await this.clients[clientIndex].unsubscribe({
+                ...packet,
+                topicFilters: indices.map((index) => packet.topicFilters[index])
+            });
+            indices.forEach((originalIndex, i) => { reasonCodes[originalIndex] = unsuback.reasonCodes[i]; });
+            return unsuback;
+        }));
+
+        return Mqtt5ClientPool.mergeAcks<mqtt5_packet.UnsubackPacket>({ type: mqtt5_packet.PacketType.Unsuback, reasonCodes: reasonCodes }, unsubacks);
+    }
+
+    /**
+     * Publishes through the client selected by the pool's {@link PoolPublishRouting routing}.
+     *
+     * @param packet PUBLISH packet to send
+     * @param options Node-specific options for this publish
+     * @returns a promise that will be rejected with an error or resolved with the PUBACK response (QoS 1) or
+     * undefined (QoS 0)
+     */
+    async publish(packet: mqtt5_packet.PublishPacket, options?: PublishOptions) : Promise<mqtt5.PublishCompletionResult> {
+        let clientIndex : number;
+        if (this.publishRouting == PoolPublishRouting.RoundRobin) {
+            clientIndex = this.nextPublishClient;
+            this.nextPublishClient = (this.nextPublishClient + 1) % this.clients.length;
+        } else {
+            clientIndex = this.ownerOf(packet.topicName);
+        }
+
+        return this.clients[clientIndex].publish(packet, options);
+    }
+
+    /**
+     * Sums the operational statistics of every client in the pool.  Per-priority statistics are merged class by
+     * class: counts are summed, average queueing delays are weighted by the number of messages delivered, and maximum
+     * queueing delays take the largest.
+     */
+    getOperationalStatistics() : ClientStatistics {
+        let total : any = {};
+        for (let client of this.clients) {
+            let statistics : any = client.getOperationalStatistics();
+            for (let key of Object.keys(statistics)) {
+                if (typeof(statistics[key]) === 'number') {
+                    total[key] = (total[key] ?? 0) + statistics[key];
+                }
+            }
+
+            if (statistics.deliveryPriorityStatistics) {
+                total.deliveryPriorityStatistics = Mqtt5ClientPool.mergePriorityStatistics(
+                    total.deliveryPriorityStatistics, statistics.deliveryPriorityStatistics, Mqtt5ClientPool.mergeDeliveryPriorityStatistics);
+            }
+
+            if (statistics.outboundPriorityStatistics) {
+                total.outboundPriorityStatistics = Mqtt5ClientPool.mergePriorityStatistics(
+                    total.outboundPriorityStatistics, statistics.outboundPriorityStatistics, Mqtt5ClientPool.mergeOutboundPriorityStatistics);
+            }
+        }
+
+        return total as ClientStatistics;
+    }
+
+    private static mergePriorityStatistics<T extends { priority: number }>(total: Array<T> | undefined, statistics: Array<T>, merge: (total: T, statistics: T) => T) : Array<T> {
+        let merged : Array<T> = (total ?? []).slice();
+        for (let classStatistics of statistics) {
+            let index : number = merged.findIndex((existing) => existing.priority == classStatistics.priority);
+            if (index < 0) {
+                merged.push({ ...classStatistics });
+            } else {
+                merged[index] = merge(merged[index], classStatistics);
+            }
+        }
+
+        return merged;
+    }
+
+    private static mergeDeliveryPriorityStatistics(total: DeliveryPriorityStatistics, statistics: DeliveryPriorityStatistics) : DeliveryPriorityStatistics {
+        let deliveredCount : number = total.deliveredCount + statistics.deliveredCount;
+        return {
+            priority: total.priority,
+            pendingCount: total.pendingCount + statistics.pendingCount,
+            deliveredCount: deliveredCount,
+            averageQueueingDelayUs: deliveredCount > 0 ?
+                (total.averageQueueingDelayUs * total.deliveredCount + statistics.averageQueueingDelayUs * statistics.deliveredCount) / deliveredCount :
+                0,
+            maxQueueingDelayUs: Math.max(total.maxQueueingDelayUs, statistics.maxQueueingDelayUs),
+        };
+    }
+
+    private static mergeOutboundPriorityStatistics(total: OutboundPriorityStatistics, statistics: OutboundPriorityStatistics) : OutboundPriorityStatistics {
+        return {
+            priority: total.priority,
+            queuedCount: total.queuedCount + statistics.queuedCount,
+            submittedCount: total.submittedCount + statistics.submittedCount,
+        };
+    }
+
+    private ownerOf(topic: string) : number {
+        /* 32-bit FNV-1a over the UTF-8 bytes, so ownership is stable across processes */
+        let hash = 0x811c9dc5;
+        for (let byte of Buffer.from(topic, 'utf8')) {
+            hash ^= byte;
+            hash = Math.imul(hash, 0x01000193) >>> 0;
+        }
+
+        return hash % this.clients.length;
+    }
+
+    private groupByOwner(topics: string[]) : Map<number, number[]> {
+        let owners = new Map<number, number[]>();
+        topics.forEach((topic, index) => {
+            let owner = this.ownerOf(topic);
+            let indices = owners.get(owner);
+            if (indices) {
+                indices.push(index);
+            } else {
+                owners.set(owner, [index]);
+            }
+        });
+
+        return owners;
+    }
+
+    private static mergeAcks<T extends mqtt5_packet.SubackPacket | mqtt5_packet.UnsubackPacket>(merged: T, acks: T[]) : T {
+        for (let ack of acks) {
+            if (ack.reasonString !== undefined && merged.reasonString === undefined) {
+                merged.reasonString = ack.reasonString;
+            }
+
+            if (ack.userProperties !== undefined) {
+                merged.userProperties = (merged.userProperties ?? []).concat(ack.userProperties);
+            }
+        }
+
+        return merged;
+    }
+
+    private static makeClientConfig(config: Mqtt5ClientConfig, index: number, clientBootstrap?: io.ClientBootstrap) : Mqtt5ClientConfig {
+        let clientConfig : Mqtt5ClientConfig = { ...config, clientBootstrap: clientBootstrap };
+
+        if (config.connectProperties?.clientId) {
+            clientConfig.connectProperties = {
+                ...config.connectProperties,
+                clientId: `${config.connectProperties.clientId}-${index}`
+            };
+        }
+
+        if (config.persistentQueueOptions) {
+            fs.mkdirSync(config.persistentQueueOptions.directory, { recursive: true });
+            clientConfig.persistentQueueOptions = {
+                ...config.persistentQueueOptions,
+                directory: path.join(config.persistentQueueOptions.directory, `${index}`)
+            };
+        }
+
+        return clientConfig;
+    }
+}
+
+/**
+ * Configuration for a {@link RequestResponseClient}
+ *
+ * @group Node-only
+ */
+export interface RequestResponseClientOptions {
+
+    /**
+     * Maximum number of requests awaiting a response at once.  Further requests wait for a slot.  Defaults to 32.
+     */
+    maxInFlightRequests? : number;
+
+    /**
+     * Time, from submission, after which a request that has not received a response is rejected.  Includes time spent
+     * waiting for an in-flight slot.  Defaults to 60 seconds.
+     */
+    operationTimeoutInSeconds? : number;
+}
+
+/**
+ * A single request submitted to a {@link RequestResponseClient}
+ *
+ * @group Node-only
+ */
+export interface RequestOptions {
+
+    /**
+     * Topic filters covering every response topic of the request, e.g. `$aws/things/+/shadow/get/+`.  Each filter is
+     * subscribed to the first time it is used and stays subscribed until the request-response client is closed, so
+     * wildcard filters shared by many requests avoid a subscribe per request.
+     */
+    subscriptionTopicFilters : Array<string>;
+
+    /**
+     * Exact topics the response may arrive on, e.g. the accepted and rejected topics of an operation
+     */
+    responseTopics : Array<string>;
+
+    /**
+     * Topic to publish the request to
+     */
+    publishTopic : string;
+
+    /**
+     * Request payload
+     */
+    payload : mqtt5_packet.Payload;
+
+    /**
+     * Correlation data sent with the request.  When the response echoes it back, it is matched exactly; a response
+     * without correlation data completes a request only if it is the only one waiting on the response's topic, and
+     * is dropped otherwise.  Defaults to 16 random bytes.
+     */
+    correlationData? : mqtt5_packet.BinaryData;
+}
+
+/**
+ * Response to a request submitted to a {@link RequestResponseClient}
+ *
+ * @group Node-only
+ */
+export interface Response {
+
+    /**
+     * Topic the response arrived on
+     */
+    topic : string;
+
+    /**
+     * Response payload
+     */
+    payload : ArrayBuffer;
+}
+
+const DEFAULT_MAX_IN_FLIGHT_REQUESTS : number = 32;
+const DEFAULT_OPERATION_TIMEOUT_SECONDS : number = 60;
+
+interface PendingRequest {
+    resolve : (response: Response) => void;
+    reject : (error: CrtError) => void;
+    timer : ReturnType<typeof setTimeout>;
+    isInFlight : boolean;
+}
+
+/**
+ * Request-response layer over an {@link Mqtt5Client}, for services such as IoT shadow and jobs that answer a
+ * published request on a well-known response topic.
+ *
+ * Response subscriptions are long-lived and shared between requests.  Incoming publishes on them are correlated with
+ * outstanding requests by topic and correlation data on the client's event loop thread; only the matching response
+ * reaches JavaScript, where it resolves the request's promise.  Publishes on a response subscription that match no
+ * request are dropped natively and counted in {@link ClientStatistics.unmatchedResponseCount}.
+ *
+ * At most one request-response client may be created per MQTT5 client.  It must be closed before the MQTT5 client.
+ *
+ * @group Node-only
+ */
+export class RequestResponseClient {
+
+    private static readonly clients : WeakMap<Mqtt5Client, RequestResponseClient> = new WeakMap();
+
+    private readonly maxInFlightRequests : number;
+    private readonly operationTimeoutMs : number;
+    private readonly subscriptions : Map<string, Promise<void>> = new Map();
+    private readonly pendingRequests : Map<number, PendingRequest> = new Map();
+    private readonly waitingForSlot : Array<() => void> = [];
+    private inFlightCount : number = 0;
+    private nextRequestId : number = 1;
+    private isClosed : boolean = false;
+
+    private constructor(private readonly client: Mqtt5Client, options: RequestResponseClientOptions) {
+        this.maxInFlightRequests = options.maxInFlightRequests ?? DEFAULT_MAX_IN_FLIGHT_REQUESTS;
+        this.operationTimeoutMs = (options.operationTimeoutInSeconds ?? DEFAULT_OPERATION_TIMEOUT_SECONDS) * 1000;
+
+        if (!Number.isInteger(this.maxInFlightRequests) || this.maxInFlightRequests < 1) {
+            throw new CrtError("RequestResponseClient - maxInFlightRequests must be a positive integer");
+        }
+
+        if (!(this.operationTimeoutMs > 0)) {
+            throw new CrtError("RequestResponseClient - operationTimeoutInSeconds must be positive");
+        }
+    }
+
+    /**
+     * Creates a request-response client that sends and receives through an existing MQTT5 client
+     *
+     * @param client MQTT5 client to use; its lifecycle remains the caller's responsibility
+     * @param options request-response client configuration
+     */
+    static newFromMqtt5(client: Mqtt5Client, options: RequestResponseClientOptions = {}) : RequestResponseClient {
+        if (RequestResponseClient.clients.has(client)) {
+            throw new CrtError("RequestResponseClient - the MQTT5 client already has a request-response client");
+        }
+
+        let requestResponseClient : RequestResponseClient = new RequestResponseClient(client, options);
+
+        crt_native.mqtt5_client_enable_request_response(
+            client.native_handle(),
+            (client: Mqtt5Client, requestId: number, topic: string, payload: ArrayBuffer) => {
+                RequestResponseClient._s_on_response_received(client, requestId, topic, payload);
+            });
+
+        RequestResponseClient.clients.set(client, requestResponseClient);
+
+        return requestResponseClient;
+    }
+
+    /**
+     * Publishes a request and waits for its response
+     *
+     * @param options the request
+     * @returns a promise resolved with the response, or rejected on timeout, failure to subscribe or publish, or close
+     */
+    submitRequest(options: RequestOptions) : Promise<Response> {
+        if (this.isClosed) {
+            return Promise.reject(new CrtError("RequestResponseClient - client is closed"));
+        }
+
+        if (options.responseTopics.length == 0 || options.subscriptionTopicFilters.length == 0) {
+            return Promise.reject(new CrtError("RequestResponseClient - a request needs response topics and filters"));
+        }
+
+        let requestId : number = this.nextRequestId++;
+
+        let response : Promise<Response> = new Promise<Response>((resolve, reject) => {
+            this.pendingRequests.set(requestId, {
+                resolve: resolve,
+                reject: reject,
+                timer: setTimeout(() => { this.failRequest(requestId, new CrtError("RequestResponseClient - request timed out")); }, this.operationTimeoutMs),
+                isInFlight: false,
+            });
+        });
+
+        this.sendRequest(requestId, options).catch((error) => {
+            this.failRequest(requestId, error instanceof CrtError ? error : new CrtError(error));
+        });
+
+        return response;
+    }
+
+    /**
+     * Rejects every outstanding request and releases the response subscriptions.  The MQTT5 client is left running.
+     */
+    close() {
+        if (this.isClosed) {
+            return;
+        }
+
+        this.isClosed = true;
+
+        for (let requestId of Array.from(this.pendingRequests.keys())) {
+            this.failRequest(requestId, new CrtError("RequestResponseClient - client closed"));
+        }
+
+        /* drops the response filters too, and lets a later request-response client enable routing again */
+        crt_native.mqtt5_client_disable_request_response(this.client.native_handle());
+
+        for (let topicFilter of this.subscriptions.keys()) {
+            this.client.unsubscribe({ topicFilters: [topicFilter] }).catch(() => {});
+        }
+        this.subscriptions.clear();
+
+        RequestResponseClient.clients.delete(this.client);
+    }
+
+    private async sendRequest(requestId: number, options: RequestOptions) {
+        await this.acquireSlot(requestId);
+
+        let pending : PendingRequest | undefined = this.pendingRequests.get(requestId);
+        if (!pending) {
+            this.releaseSlot();
+            return;
+        }
+        pending.isInFlight = true;
+
+        await Promise.all(options.subscriptionTopicFilters.map((topicFilter) => this.ensureSubscribed(topicFilter)));
+
+        if (!this.pendingRequests.has(requestId)) {
+            return;
+        }
+
+        let correlationData : mqtt5_packet.BinaryData = options.correlationData ?? randomBytes(16);
+
+        /* registered before publishing so that a fast response cannot overtake the registration */
+        crt_native.mqtt5_client_add_pending_request(this.client.native_handle(), requestId, options.responseTopics, correlationData);
+
+        await this.client.publish({
+            topicName: options.publishTopic,
+            qos: mqtt5_packet.QoS.AtLeastOnce,
+            payload: options.payload,
+            responseTopic: options.responseTopics[0],
+            correlationData: correlationData,
+        });
+    }
+
+    private ensureSubscribed(topicFilter: string) : Promise<void> {
+        let subscription : Promise<void> | undefined = this.subscriptions.get(topicFilter);
+        if (subscription) {
+            return subscription;
+        }
+
+        crt_native.mqtt5_client_add_response_filter(this.client.native_handle(), topicFilter);
+
+        subscription = this.client.subscribe({
+            subscriptions: [{ topicFilter: topicFilter, qos: mqtt5_packet.QoS.AtLeastOnce }]
+        }).then((suback: mqtt5_packet.SubackPacket) => {
+            if (!mqtt5_packet.isSuccessfulSubackReasonCode(suback.reasonCodes[0])) {
+                throw new CrtError(`RequestResponseClient - subscription to ${topicFilter} rejected`);
+            }
+        }).catch((error) => {
+            /* forget the failed subscription so that a later request retries it */
+            if (this.subscriptions.get(topicFilter) === subscription) {
+                this.subscriptions.delete(topicFilter);
+                crt_native.mqtt5_client_remove_response_filter(this.client.native_handle(), topicFilter);
+            }
+            throw error;
+        });
+
+        this.subscriptions.set(topicFilter, subscription);
+
+        return subscription;
+    }
+
+    private acquireSlot(requestId: number) : Promise<void> {
+        if (this.inFlightCount < this.maxInFlightRequests) {
+            this.inFlightCount++;
+            return Promise.resolve();
+        }
+
+        return new Promise<void>((resolve) => {
+            this.waitingForSlot.push(() => {
+                this.inFlightCount++;
+                resolve();
+            });
+        });
+    }
+
+    private releaseSlot() {
+        this.inFlightCount--;
+
+        let next : (() => void) | undefined = this.waitingForSlot.shift();
+        if (next) {
+            next();
+        }
+    }
+
+    /* Removes a request from both sides, returning it if it was still outstanding */
+    private completeRequest(requestId: number) : PendingRequest | undefined {
+        let pending : PendingRequest | undefined = this.pendingRequests.get(requestId);
+        if (!pending) {
+            return undefined;
+        }
+
+        this.pendingRequests.delete(requestId);
+        clearTimeout(pending.timer);
+
+        if (pending.isInFlight) {
+            crt_native.mqtt5_client_remove_pending_request(this.client.native_handle(), requestId);
+            this.releaseSlot();
+        }
+
+        return pending;
+    }
+
+    private failRequest(requestId: number, error: CrtError) {
+        this.completeRequest(requestId)?.reject(error);
+    }
+
+    private static _s_on_response_received(client: Mqtt5Client, requestId: number, topic: string, payload: ArrayBuffer) {
+        let requestResponseClient : RequestResponseClient | undefined = RequestResponseClient.clients.get(client);
+        requestResponseClient?.completeRequest(requestId)?.resolve({ topic: topic, payload: payload });
+    }
+}
@@ -18,6 +18,7 @@
 
 #include <aws/common/condition_variable.h>
 #include <aws/common/mutex.h>
+#include <aws/common/ref_count.h>
 
 #include <aws/io/tls_channel_handler.h>
 
@@ -601,14 +602,14 @@ struct signer_sign_request_state {
 };
 
 static bool s_should_sign_header(const struct aws_byte_cursor *name, void *userdata) {
-    struct signer_sign_request_state *state = userdata;
+    struct aws_array_list *header_blacklist = userdata;
 
     /* If there are params in the black_list, check them all */
-    if (state->header_blacklist.length) {
-        const size_t num_blacklisted = aws_array_list_length(&state->header_blacklist);
+    if (header_blacklist->length) {
+        const size_t num_blacklisted = aws_array_list_length(header_blacklist);
         for (size_t i = 0; i < num_blacklisted; ++i) {
             struct aws_string *blacklisted = NULL;
-            aws_array_list_get_at(&state->header_blacklist, &blacklisted, i);
+            aws_array_list_get_at(header_blacklist, &blacklisted, i);
             AWS_ASSUME(blacklisted);
 
             if (aws_string_eq_byte_cursor_ignore_case(blacklisted, name)) {
@@ -620,6 +621,16 @@ static bool s_should_sign_header(const struct aws_byte_cursor *name, void *userd
     return true;
 }
 
+static void s_header_blacklist_clean_up(struct aws_array_list *header_blacklist) {
+    const size_t num_blacklisted = header_blacklist->length;
+    for (size_t i = 0; i < num_blacklisted; ++i) {
+        struct aws_string *blacklisted = NULL;
+        aws_array_list_get_at(header_blacklist, &blacklisted, i);
+        aws_string_destroy(blacklisted);
+    }
+    aws_array_list_clean_up(header_blacklist);
+}
+
 static void s_destroy_signing_binding(
     napi_env env,
     struct aws_allocator *allocator,
@@ -631,13 +642,7 @@ static void s_destroy_signing_binding(
     /* Release references */
     napi_delete_reference(env, binding->node_request);
 
-    const size_t num_blacklisted = binding->header_blacklist.length;
-    for (size_t i = 0; i < num_blacklisted; ++i) {
-        struct aws_string *blacklisted = NULL;
-        aws_array_list_get_at(&binding->header_blacklist, &blacklisted, i);
-        aws_string_destroy(blacklisted);
-    }
-    aws_array_list_clean_up(&binding->header_blacklist);
+    s_header_blacklist_clean_up(&binding->header_blacklist);
 
     aws_signable_destroy(binding->signable);
 
@@ -680,7 +685,7 @@ static int s_get_config_from_js_config(
     struct aws_byte_buf *region_buf,
     struct aws_byte_buf *service_buf,
     struct aws_byte_buf *signed_body_value_buf,
-    struct signer_sign_request_state *state,
+    struct aws_array_list *header_blacklist,
     struct aws_allocator *allocator) {
 
     config->config_type = AWS_SIGNING_CONFIG_AWS;
@@ -808,8 +813,8 @@ static int s_get_config_from_js_config(
         });
 
         /* Initialize the string array */
-        int err = aws_array_list_init_dynamic(
-            &state->header_blacklist, allocator, blacklist_length, sizeof(struct aws_string *));
+        int err =
+            aws_array_list_init_dynamic(header_blacklist, allocator, blacklist_length, sizeof(struct aws_string *));
         if (err == AWS_OP_ERR) {
             aws_napi_throw_last_error(env);
             result = AWS_OP_ERR;
@@ -832,7 +837,7 @@ static int s_get_config_from_js_config(
                 goto done;
             }
 
-            if (aws_array_list_push_back(&state->header_blacklist, &header_name)) {
+            if (aws_array_list_push_back(header_blacklist, &header_name)) {
                 aws_string_destroy(header_name);
                 aws_napi_throw_last_error(env);
                 result = AWS_OP_ERR;
@@ -841,7 +846,7 @@ static int s_get_config_from_js_config(
         }
 
         config->should_sign_header = s_should_sign_header;
-        config->should_sign_header_ud = state;
+        config->should_sign_header_ud = header_blacklist;
     }
 
     /* Get bools */
@@ -942,7 +947,14 @@ static napi_value s_aws_sign_request(napi_env env, const struct aws_napi_callbac
     napi_value js_config = arg->node;
 
     if (s_get_config_from_js_config(
-            env, &config, js_config, &region_buf, &service_buf, &signed_body_value_buf, state, allocator)) {
+            env,
+            &config,
+            js_config,
+            &region_buf,
+            &service_buf,
+            &signed_body_value_buf,
+            &state->header_blacklist,
+            allocator)) {
         /* error already raised */
         goto error;
     }
@@ -1065,7 +1077,14 @@ static napi_value s_aws_verify_sigv4a_signing(napi_env env, const struct aws_nap
     napi_value js_config = arg->node;
 
     if (s_get_config_from_js_config(
-            env, &config, js_config, &region_buf, &service_buf, &signed_body_value_buf, state, allocator)) {
+            env,
+            &config,
+            js_config,
+            &region_buf,
+            &service_buf,
+            &signed_body_value_buf,
+            &state->header_blacklist,
+            allocator)) {
         /* error already raised */
         goto done;
     }
@@ -1146,3 +1165,150 @@ done:
 
     return result;
 }
+
+/***********************************************************************************************************************
+ * Websocket Handshake Signer
+ **********************************************************************************************************************/
+
+struct aws_napi_websocket_signer {
+    struct aws_allocator *allocator;
+    struct aws_ref_count ref_count;
+
+    /* Parsed once from JS; the date is refreshed on every signing */
+    struct aws_signing_config_aws config;
+
+    struct aws_byte_buf region_buf;
+    struct aws_byte_buf service_buf;
+    struct aws_byte_buf signed_body_value_buf;
+    struct aws_array_list header_blacklist;
+};
+
+static void s_websocket_signer_destroy(void *object) {
+    struct aws_napi_websocket_signer *signer = object;
+
+    aws_credentials_provider_release(signer->config.credentials_provider);
+
+    aws_byte_buf_clean_up(&signer->region_buf);
+    aws_byte_buf_clean_up(&signer->service_buf);
+    aws_byte_buf_clean_up(&signer->signed_body_value_buf);
+    s_header_blacklist_clean_up(&signer->header_blacklist);
+
+    aws_mem_release(signer->allocator, signer);
+}
+
+struct aws_napi_websocket_signer *aws_napi_websocket_signer_new_from_napi(
+    struct aws_allocator *allocator,
+    napi_env env,
+    napi_value node_signing_config) {
+
+    struct aws_napi_websocket_signer *signer = aws_mem_calloc(allocator, 1, sizeof(struct aws_napi_websocket_signer));
+    signer->allocator = allocator;
+    aws_ref_count_init(&signer->ref_count, signer, s_websocket_signer_destroy);
+
+    if (s_get_config_from_js_config(
+            env,
+            &signer->config,
+            node_signing_config,
+            &signer->region_buf,
+            &signer->service_buf,
+            &signer->signed_body_value_buf,
+            &signer->header_blacklist,
+            allocator)) {
+        /* error already thrown */
+        aws_napi_websocket_signer_release(signer);
+        return NULL;
+    }
+
+    return signer;
+}
+
+struct aws_napi_websocket_signer *aws_napi_websocket_signer_acquire(struct aws_napi_websocket_signer *signer) {
+    if (signer != NULL) {
+        aws_ref_count_acquire(&signer->ref_count);
+    }
+
+    return signer;
+}
+
+struct aws_napi_websocket_signer *aws_napi_websocket_signer_release(struct aws_napi_websocket_signer *signer) {
+    if (signer != NULL) {
+        aws_ref_count_release(&signer->ref_count);
+    }
+
+    return NULL;
+}
+
+struct websocket_signing_state {
+    struct aws_allocator *allocator;
+    struct aws_napi_websocket_signer *signer;
+
+    struct aws_http_message *request;
+    struct aws_signable *signable;
+    struct aws_signing_config_aws config;
+
+    aws_napi_websocket_handshake_complete_fn *complete_fn;
+    void *complete_ctx;
+};
+
+static void s_websocket_signing_state_destroy(struct websocket_signing_state *state) {
+    aws_signable_destroy(state->signable);
+    aws_napi_websocket_signer_release(state->signer);
+
+    aws_mem_release(state->allocator, state);
+}
+
+static void s_on_websocket_handshake_signed(struct aws_signing_result *result, int error_code, void *userdata) {
+    struct websocket_signing_state *state = userdata;
+
+    if (error_code == AWS_ERROR_SUCCESS) {
+        if (aws_apply_signing_result_to_http_request(state->request, state->allocator, result)) {
+            error_code = aws_last_error();
+        }
+    }
+
+    state->complete_fn(state->request, error_code, state->complete_ctx);
+
+    s_websocket_signing_state_destroy(state);
+}
+
+void aws_napi_websocket_signer_sign(
+    struct aws_napi_websocket_signer *signer,
+    struct aws_http_message *request,
+    aws_napi_websocket_handshake_complete_fn *complete_fn,
+    void *complete_ctx) {
+
+    struct aws_allocator *allocator = signer->allocator;
+
+    struct websocket_signing_state *state = aws_mem_calloc(allocator, 1, sizeof(struct websocket_signing_state));
+    state->allocator = allocator;
+    state->signer = aws_napi_websocket_signer_acquire(signer);
+    state->request = request;
+    state->complete_fn = complete_fn;
+    state->complete_ctx = complete_ctx;
+
+    /* signatures are only valid around the time they are made, so every handshake is signed as of now */
+    state->config = signer->config;
+    aws_date_time_init_now(&state->config.date);
+
+    state->signable = aws_signable_new_http_request(allocator, request);
+    if (state->signable == NULL) {
+        goto error;
+    }
+
+    if (aws_sign_request_aws(
+            allocator,
+            state->signable,
+            (struct aws_signing_config_base *)&state->config,
+            s_on_websocket_handshake_signed,
+            state)) {
+        goto error;
+    }
+
+    return;
+
+error:
+
+    complete_fn(request, aws_last_error(), complete_ctx);
+
+    s_websocket_signing_state_destroy(state);
+}
@@ -20,4 +20,32 @@ struct aws_credentials_provider *aws_napi_credentials_provider_unwrap(napi_env e
 struct aws_signing_config_aws;
 struct aws_signing_config_aws *aws_signing_config_aws_prepare_and_unwrap(napi_env env, napi_value js_object);
 
+struct aws_http_message;
+
+/*
+ * Signs websocket handshakes natively with a credentials provider and signing config bound once from a JS
+ * AwsSigningConfig, so that connection attempts made from the event loop never wait on node's thread.
+ */
+struct aws_napi_websocket_signer;
+
+typedef void(
+    aws_napi_websocket_handshake_complete_fn)(struct aws_http_message *request, int error_code, void *complete_ctx);
+
+/* Returns NULL, with a JS exception pending, if the signing config is invalid */
+struct aws_napi_websocket_signer *aws_napi_websocket_signer_new_from_napi(
+    struct aws_allocator *allocator,
+    napi_env env,
+    napi_value node_signing_config);
+
+struct aws_napi_websocket_signer *aws_napi_websocket_signer_acquire(struct aws_napi_websocket_signer *signer);
+
+struct aws_napi_websocket_signer *aws_napi_websocket_signer_release(struct aws_napi_websocket_signer *signer);
+
+/* Signs the request as of the current time; complete_fn is always invoked, possibly before this returns */
+void aws_napi_websocket_signer_sign(
+    struct aws_napi_websocket_signer *signer,
+    struct aws_http_message *request,
+    aws_napi_websocket_handshake_complete_fn *complete_fn,
+    void *complete_ctx);
+
 #endif /* AWS_CRT_NODEJS_AUTH_H */
@@ -122,6 +122,9 @@ napi_value aws_napi_is_alpn_available(napi_env env, napi_callback_info info) {
 struct client_bootstrap_binding {
     struct aws_client_bootstrap *bootstrap;
     struct aws_host_resolver *resolver;
+
+    /* only set when the bootstrap was created with its own event loop threads rather than node's shared group */
+    struct aws_event_loop_group *elg;
 };
 
 struct aws_client_bootstrap *aws_napi_get_client_bootstrap(struct client_bootstrap_binding *binding) {
@@ -141,6 +144,7 @@ static void s_client_bootstrap_finalize(napi_env env, void *finalize_data, void
 
     aws_host_resolver_release(binding->resolver);
     aws_client_bootstrap_release(binding->bootstrap);
+    aws_event_loop_group_release(binding->elg);
 
     aws_mem_release(allocator, binding);
 }
@@ -151,13 +155,41 @@ static void s_client_bootstrap_finalize(napi_env env, void *finalize_data, void
 #endif
 
 napi_value aws_napi_io_client_bootstrap_new(napi_env env, napi_callback_info info) {
-    (void)info;
+    napi_value node_args[1];
+    size_t num_args = AWS_ARRAY_SIZE(node_args);
+    if (napi_get_cb_info(env, info, &num_args, node_args, NULL, NULL)) {
+        napi_throw_error(env, NULL, "Failed to retrieve callback information");
+        return NULL;
+    }
+
+    /* optional: number of dedicated event loop threads; zero or undefined shares node's event loop group */
+    uint32_t event_loop_thread_count = 0;
+    if (num_args > 0 && !aws_napi_is_null_or_undefined(env, node_args[0])) {
+        if (napi_get_value_uint32(env, node_args[0], &event_loop_thread_count)) {
+            napi_throw_type_error(env, NULL, "event_loop_thread_count must be a number");
+            return NULL;
+        }
+
+        /* the event loop group takes a 16-bit count, where zero would quietly mean one thread per core */
+        if (event_loop_thread_count > UINT16_MAX) {
+            napi_throw_range_error(env, NULL, "event_loop_thread_count must be at most 65535");
+            return NULL;
+        }
+    }
 
     struct aws_allocator *allocator = aws_napi_get_allocator();
 
     struct client_bootstrap_binding *binding = aws_mem_acquire(allocator, sizeof(struct client_bootstrap_binding));
     AWS_ZERO_STRUCT(*binding);
 
+    if (event_loop_thread_count > 0) {
+        binding->elg = aws_event_loop_group_new_default(allocator, (uint16_t)event_loop_thread_count, NULL);
+        if (binding->elg == NULL) {
+            napi_throw_error(env, NULL, "Failed init event loop group");
+            goto clean_up;
+        }
+    }
+
     struct aws_host_resolver_default_options resolver_options = {
         .max_entries = 64,
         .el_group = aws_napi_get_node_elg(),
@@ -169,7 +201,7 @@ napi_value aws_napi_io_client_bootstrap_new(napi_env env, napi_callback_info inf
     }
 
     struct aws_client_bootstrap_options options = {
-        .event_loop_group = aws_napi_get_node_elg(),
+        .event_loop_group = binding->elg != NULL ? binding->elg : aws_napi_get_node_elg(),
         .host_resolver = binding->resolver,
     };
 
@@ -194,6 +226,9 @@ clean_up:
     if (binding->resolver) {
         aws_host_resolver_release(binding->resolver);
     }
+    if (binding->elg) {
+        aws_event_loop_group_release(binding->elg);
+    }
     if (binding) {
         aws_mem_release(allocator, binding);
     }
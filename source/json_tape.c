@@ -0,0 +1,617 @@
+/**
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0.
+ */
+
+#include "json_tape.h"
+
+#include <aws/common/byte_buf.h>
+
+#include <locale.h>
+#include <stdlib.h>
+
+/* Bound on nesting so that hostile payloads cannot exhaust the event loop thread's stack */
+#define AWS_NAPI_JSON_TAPE_MAX_DEPTH 512
+
+/* Longest number converted from a stack buffer; longer (unusual) numbers are copied to the heap */
+#define AWS_NAPI_JSON_TAPE_NUMBER_BUFFER_SIZE 64
+
+struct json_tape_parser {
+    const uint8_t *begin;
+    const uint8_t *current;
+    const uint8_t *end;
+
+    struct aws_byte_buf *tape;
+    struct aws_napi_json_tape_error *error;
+
+    size_t depth;
+};
+
+static int s_parse_value(struct json_tape_parser *parser);
+
+static int s_fail(struct json_tape_parser *parser, const char *message) {
+    parser->error->offset = (size_t)(parser->current - parser->begin);
+    parser->error->message = message;
+
+    return aws_raise_error(AWS_ERROR_INVALID_ARGUMENT);
+}
+
+static void s_skip_whitespace(struct json_tape_parser *parser) {
+    while (parser->current < parser->end) {
+        uint8_t c = *parser->current;
+        if (c != ' ' && c != '\t' && c != '\n' && c != '\r') {
+            return;
+        }
+        ++parser->current;
+    }
+}
+
+static int s_write_u8(struct json_tape_parser *parser, uint8_t value) {
+    return aws_byte_buf_append_byte_dynamic(parser->tape, value);
+}
+
+/* Reserves space for a uint32 to be filled in later with s_patch_u32; returns its offset in the tape */
+static int s_reserve_u32(struct json_tape_parser *parser, size_t *offset_out) {
+    *offset_out = parser->tape->len;
+
+    uint8_t placeholder[4] = {0};
+    struct aws_byte_cursor placeholder_cursor = aws_byte_cursor_from_array(placeholder, sizeof(placeholder));
+
+    return aws_byte_buf_append_dynamic(parser->tape, &placeholder_cursor);
+}
+
+static void s_patch_u32(struct json_tape_parser *parser, size_t offset, uint32_t value) {
+    uint8_t *destination = parser->tape->buffer + offset;
+    destination[0] = (uint8_t)(value & 0xFF);
+    destination[1] = (uint8_t)((value >> 8) & 0xFF);
+    destination[2] = (uint8_t)((value >> 16) & 0xFF);
+    destination[3] = (uint8_t)((value >> 24) & 0xFF);
+}
+
+static int s_write_f64(struct json_tape_parser *parser, double value) {
+    uint64_t bits = 0;
+    memcpy(&bits, &value, sizeof(bits));
+
+    uint8_t encoded[8];
+    for (size_t i = 0; i < sizeof(encoded); ++i) {
+        encoded[i] = (uint8_t)((bits >> (8 * i)) & 0xFF);
+    }
+
+    struct aws_byte_cursor encoded_cursor = aws_byte_cursor_from_array(encoded, sizeof(encoded));
+    return aws_byte_buf_append_dynamic(parser->tape, &encoded_cursor);
+}
+
+static int s_expect_literal(struct json_tape_parser *parser, const char *literal, uint8_t tag) {
+    size_t length = strlen(literal);
+    if ((size_t)(parser->end - parser->current) < length || memcmp(parser->current, literal, length) != 0) {
+        return s_fail(parser, "invalid literal");
+    }
+
+    parser->current += length;
+
+    return s_write_u8(parser, tag);
+}
+
+static int s_hex_value(uint8_t c) {
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    }
+
+    if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    }
+
+    if (c >= 'A' && c <= 'F') {
+        return c - 'A' + 10;
+    }
+
+    return -1;
+}
+
+/* Reads the four hex digits of a \u escape, current pointing just past the 'u' */
+static int s_parse_hex4(struct json_tape_parser *parser, uint32_t *code_unit_out) {
+    if (parser->end - parser->current < 4) {
+        return s_fail(parser, "truncated unicode escape");
+    }
+
+    uint32_t code_unit = 0;
+    for (size_t i = 0; i < 4; ++i) {
+        int digit = s_hex_value(parser->current[i]);
+        if (digit < 0) {
+            return s_fail(parser, "invalid unicode escape");
+        }
+        code_unit = (code_unit << 4) | (uint32_t)digit;
+    }
+
+    parser->current += 4;
+    *code_unit_out = code_unit;
+
+    return AWS_OP_SUCCESS;
+}
+
+static int s_write_utf8(struct json_tape_parser *parser, uint32_t code_point) {
+    uint8_t encoded[4];
+    size_t length = 0;
+
+    if (code_point < 0x80) {
+        encoded[length++] = (uint8_t)code_point;
+    } else if (code_point < 0x800) {
+        encoded[length++] = (uint8_t)(0xC0 | (code_point >> 6));
+        encoded[length++] = (uint8_t)(0x80 | (code_point & 0x3F));
+    } else if (code_point < 0x10000) {
+        encoded[length++] = (uint8_t)(0xE0 | (code_point >> 12));
+        encoded[length++] = (uint8_t)(0x80 | ((code_point >> 6) & 0x3F));
+        encoded[length++] = (uint8_t)(0x80 | (code_point & 0x3F));
+    } else {
+        encoded[length++] = (uint8_t)(0xF0 | (code_point >> 18));
+        encoded[length++] = (uint8_t)(0x80 | ((code_point >> 12) & 0x3F));
+        encoded[length++] = (uint8_t)(0x80 | ((code_point >> 6) & 0x3F));
+        encoded[length++] = (uint8_t)(0x80 | (code_point & 0x3F));
+    }
+
+    struct aws_byte_cursor encoded_cursor = aws_byte_cursor_from_array(encoded, length);
+    return aws_byte_buf_append_dynamic(parser->tape, &encoded_cursor);
+}
+
+static int s_parse_unicode_escape(struct json_tape_parser *parser) {
+    uint32_t code_unit = 0;
+    if (s_parse_hex4(parser, &code_unit)) {
+        return AWS_OP_ERR;
+    }
+
+    if (code_unit >= 0xD800 && code_unit <= 0xDBFF) {
+        /* a high surrogate only forms a code point together with an immediately following low surrogate escape */
+        if (parser->end - parser->current >= 6 && parser->current[0] == '\\' && parser->current[1] == 'u') {
+            const uint8_t *low_start = parser->current;
+            parser->current += 2;
+
+            uint32_t low_unit = 0;
+            if (s_parse_hex4(parser, &low_unit)) {
+                return AWS_OP_ERR;
+            }
+
+            if (low_unit >= 0xDC00 && low_unit <= 0xDFFF) {
+                return s_write_utf8(parser, 0x10000 + ((code_unit - 0xD800) << 10) + (low_unit - 0xDC00));
+            }
+
+            /* not a pair; the second escape is handled on its own */
+            parser->current = low_start;
+        }
+
+        return s_write_utf8(parser, 0xFFFD);
+    }
+
+    if (code_unit >= 0xDC00 && code_unit <= 0xDFFF) {
+        return s_write_utf8(parser, 0xFFFD);
+    }
+
+    return s_write_utf8(parser, code_unit);
+}
+
+/*
+ * Steps over one multi-byte UTF-8 sequence, current pointing at its lead byte.  Overlong encodings, surrogates and
+ * code points beyond U+10FFFF are rejected (RFC 3629).
+ */
+static int s_skip_utf8_sequence(struct json_tape_parser *parser) {
+    uint8_t lead = *parser->current;
+
+    size_t continuation_count = 0;
+    uint8_t second_min = 0x80;
+    uint8_t second_max = 0xBF;
+    if (lead >= 0xC2 && lead <= 0xDF) {
+        continuation_count = 1;
+    } else if (lead >= 0xE0 && lead <= 0xEF) {
+        continuation_count = 2;
+        if (lead == 0xE0) {
+            second_min = 0xA0;
+        } else if (lead == 0xED) {
+            second_max = 0x9F;
+        }
+    } else if (lead >= 0xF0 && lead <= 0xF4) {
+        continuation_count = 3;
+        if (lead == 0xF0) {
+            second_min = 0x90;
+        } else if (lead == 0xF4) {
+            second_max = 0x8F;
+        }
+    } else {
+        return s_fail(parser, "invalid UTF-8");
+    }
+
+    if ((size_t)(parser->end - parser->current) <= continuation_count) {
+        return s_fail(parser, "invalid UTF-8");
+    }
+
+    for (size_t i = 1; i <= continuation_count; ++i) {
+        uint8_t c = parser->current[i];
+        uint8_t min = (i == 1) ? second_min : 0x80;
+        uint8_t max = (i == 1) ? second_max : 0xBF;
+        if (c < min || c > max) {
+            return s_fail(parser, "invalid UTF-8");
+        }
+    }
+
+    parser->current += 1 + continuation_count;
+
+    return AWS_OP_SUCCESS;
+}
+
+/* Writes a length-prefixed string, current pointing at the opening quote */
+static int s_parse_string_body(struct json_tape_parser *parser) {
+    ++parser->current;
+
+    size_t length_offset = 0;
+    if (s_reserve_u32(parser, &length_offset)) {
+        return AWS_OP_ERR;
+    }
+    size_t start = parser->tape->len;
+
+    while (true) {
+        /* copy runs of plain characters in one go */
+        const uint8_t *run_start = parser->current;
+        while (parser->current < parser->end) {
+            uint8_t c = *parser->current;
+            if (c == '"' || c == '\\' || c < 0x20) {
+                break;
+            }
+
+            if (c < 0x80) {
+                ++parser->current;
+            } else if (s_skip_utf8_sequence(parser)) {
+                return AWS_OP_ERR;
+            }
+        }
+
+        if (parser->current > run_start) {
+            struct aws_byte_cursor run =
+                aws_byte_cursor_from_array(run_start, (size_t)(parser->current - run_start));
+            if (aws_byte_buf_append_dynamic(parser->tape, &run)) {
+                return AWS_OP_ERR;
+            }
+        }
+
+        if (parser->current >= parser->end) {
+            return s_fail(parser, "unterminated string");
+        }
+
+        uint8_t c = *parser->current;
+        if (c == '"') {
+            ++parser->current;
+            break;
+        }
+
+        if (c < 0x20) {
+            return s_fail(parser, "control character in string");
+        }
+
+        /* escape sequence */
+        ++parser->current;
+        if (parser->current >= parser->end) {
+            return s_fail(parser, "unterminated string");
+        }
+
+        uint8_t escaped = *parser->current++;
+        uint8_t replacement = 0;
+        switch (escaped) {
+            case '"':
+            case '\\':
+            case '/':
+                replacement = escaped;
+                break;
+            case 'b':
+                replacement = '\b';
+                break;
+            case 'f':
+                replacement = '\f';
+                break;
+            case 'n':
+                replacement = '\n';
+                break;
+            case 'r':
+                replacement = '\r';
+                break;
+            case 't':
+                replacement = '\t';
+                break;
+            case 'u':
+                if (s_parse_unicode_escape(parser)) {
+                    return AWS_OP_ERR;
+                }
+                continue;
+            default:
+                --parser->current;
+                return s_fail(parser, "invalid escape sequence");
+        }
+
+        if (s_write_u8(parser, replacement)) {
+            return AWS_OP_ERR;
+        }
+    }
+
+    size_t length = parser->tape->len - start;
+    if (length > UINT32_MAX) {
+        return s_fail(parser, "string too long");
+    }
+    s_patch_u32(parser, length_offset, (uint32_t)length);
+
+    return AWS_OP_SUCCESS;
+}
+
+/* strtod follows the C library's LC_NUMERIC locale, which need not use '.' as its decimal point */
+static char s_get_locale_decimal_point(void) {
+    const struct lconv *conventions = localeconv();
+    if (conventions == NULL || conventions->decimal_point == NULL || conventions->decimal_point[0] == '\0') {
+        return '.';
+    }
+
+    return conventions->decimal_point[0];
+}
+
+static bool s_is_digit(const struct json_tape_parser *parser) {
+    return parser->current < parser->end && *parser->current >= '0' && *parser->current <= '9';
+}
+
+static int s_parse_number(struct json_tape_parser *parser) {
+    const uint8_t *start = parser->current;
+    bool is_integer = true;
+
+    if (*parser->current == '-') {
+        ++parser->current;
+    }
+
+    if (!s_is_digit(parser)) {
+        return s_fail(parser, "invalid number");
+    }
+
+    if (*parser->current == '0') {
+        ++parser->current;
+    } else {
+        while (s_is_digit(parser)) {
+            ++parser->current;
+        }
+    }
+
+    if (parser->current < parser->end && *parser->current == '.') {
+        is_integer = false;
+        ++parser->current;
+        if (!s_is_digit(parser)) {
+            return s_fail(parser, "invalid number");
+        }
+        while (s_is_digit(parser)) {
+            ++parser->current;
+        }
+    }
+
+    if (parser->current < parser->end && (*parser->current == 'e' || *parser->current == 'E')) {
+        is_integer = false;
+        ++parser->current;
+        if (parser->current < parser->end && (*parser->current == '+' || *parser->current == '-')) {
+            ++parser->current;
+        }
+        if (!s_is_digit(parser)) {
+            return s_fail(parser, "invalid number");
+        }
+        while (s_is_digit(parser)) {
+            ++parser->current;
+        }
+    }
+
+    size_t length = (size_t)(parser->current - start);
+
+    if (s_write_u8(parser, AWS_NAPI_JSON_TAPE_NUMBER)) {
+        return AWS_OP_ERR;
+    }
+
+    /* integers of up to 15 digits are exactly representable, so skip strtod for the common case */
+    bool is_negative = *start == '-';
+    size_t digit_count = length - (is_negative ? 1 : 0);
+    if (is_integer && digit_count <= 15) {
+        int64_t value = 0;
+        for (const uint8_t *digit = start + (is_negative ? 1 : 0); digit < parser->current; ++digit) {
+            value = value * 10 + (*digit - '0');
+        }
+
+        /* negative zero must survive, as it does with JSON.parse */
+        double converted = is_negative ? -(double)value : (double)value;
+        return s_write_f64(parser, converted);
+    }
+
+    char stack_buffer[AWS_NAPI_JSON_TAPE_NUMBER_BUFFER_SIZE];
+    char *number_text = stack_buffer;
+    if (length >= sizeof(stack_buffer)) {
+        number_text = aws_mem_acquire(parser->tape->allocator, length + 1);
+    }
+
+    memcpy(number_text, start, length);
+    number_text[length] = '\0';
+
+    char decimal_point = s_get_locale_decimal_point();
+    if (decimal_point != '.') {
+        char *fraction = memchr(number_text, '.', length);
+        if (fraction != NULL) {
+            *fraction = decimal_point;
+        }
+    }
+
+    double value = strtod(number_text, NULL);
+
+    if (number_text != stack_buffer) {
+        aws_mem_release(parser->tape->allocator, number_text);
+    }
+
+    return s_write_f64(parser, value);
+}
+
+static int s_parse_array(struct json_tape_parser *parser) {
+    ++parser->current;
+
+    size_t count_offset = 0;
+    if (s_write_u8(parser, AWS_NAPI_JSON_TAPE_ARRAY) || s_reserve_u32(parser, &count_offset)) {
+        return AWS_OP_ERR;
+    }
+
+    uint32_t count = 0;
+
+    s_skip_whitespace(parser);
+    if (parser->current < parser->end && *parser->current == ']') {
+        ++parser->current;
+        return AWS_OP_SUCCESS;
+    }
+
+    while (true) {
+        if (s_parse_value(parser)) {
+            return AWS_OP_ERR;
+        }
+        ++count;
+
+        s_skip_whitespace(parser);
+        if (parser->current >= parser->end) {
+            return s_fail(parser, "unterminated array");
+        }
+
+        uint8_t c = *parser->current++;
+        if (c == ']') {
+            break;
+        }
+
+        if (c != ',') {
+            --parser->current;
+            return s_fail(parser, "expected ',' or ']'");
+        }
+    }
+
+    s_patch_u32(parser, count_offset, count);
+
+    return AWS_OP_SUCCESS;
+}
+
+static int s_parse_object(struct json_tape_parser *parser) {
+    ++parser->current;
+
+    size_t count_offset = 0;
+    if (s_write_u8(parser, AWS_NAPI_JSON_TAPE_OBJECT) || s_reserve_u32(parser, &count_offset)) {
+        return AWS_OP_ERR;
+    }
+
+    uint32_t count = 0;
+
+    s_skip_whitespace(parser);
+    if (parser->current < parser->end && *parser->current == '}') {
+        ++parser->current;
+        return AWS_OP_SUCCESS;
+    }
+
+    while (true) {
+        s_skip_whitespace(parser);
+        if (parser->current >= parser->end || *parser->current != '"') {
+            return s_fail(parser, "expected object key");
+        }
+
+        if (s_parse_string_body(parser)) {
+            return AWS_OP_ERR;
+        }
+
+        s_skip_whitespace(parser);
+        if (parser->current >= parser->end || *parser->current != ':') {
+            return s_fail(parser, "expected ':'");
+        }
+        ++parser->current;
+
+        if (s_parse_value(parser)) {
+            return AWS_OP_ERR;
+        }
+        ++count;
+
+        s_skip_whitespace(parser);
+        if (parser->current >= parser->end) {
+            return s_fail(parser, "unterminated object");
+        }
+
+        uint8_t c = *parser->current++;
+        if (c == '}') {
+            break;
+        }
+
+        if (c != ',') {
+            --parser->current;
+            return s_fail(parser, "expected ',' or '}'");
+        }
+    }
+
+    s_patch_u32(parser, count_offset, count);
+
+    return AWS_OP_SUCCESS;
+}
+
+static int s_parse_value(struct json_tape_parser *parser) {
+    s_skip_whitespace(parser);
+
+    if (parser->current >= parser->end) {
+        return s_fail(parser, "unexpected end of input");
+    }
+
+    switch (*parser->current) {
+        case 'n':
+            return s_expect_literal(parser, "null", AWS_NAPI_JSON_TAPE_NULL);
+
+        case 'f':
+            return s_expect_literal(parser, "false", AWS_NAPI_JSON_TAPE_FALSE);
+
+        case 't':
+            return s_expect_literal(parser, "true", AWS_NAPI_JSON_TAPE_TRUE);
+
+        case '"':
+            if (s_write_u8(parser, AWS_NAPI_JSON_TAPE_STRING)) {
+                return AWS_OP_ERR;
+            }
+            return s_parse_string_body(parser);
+
+        case '[':
+        case '{': {
+            if (parser->depth >= AWS_NAPI_JSON_TAPE_MAX_DEPTH) {
+                return s_fail(parser, "maximum nesting depth exceeded");
+            }
+
+            ++parser->depth;
+            int result = *parser->current == '[' ? s_parse_array(parser) : s_parse_object(parser);
+            --parser->depth;
+
+            return result;
+        }
+
+        default:
+            if (*parser->current == '-' || (*parser->current >= '0' && *parser->current <= '9')) {
+                return s_parse_number(parser);
+            }
+
+            return s_fail(parser, "unexpected character");
+    }
+}
+
+int aws_napi_json_tape_build(
+    struct aws_byte_cursor json,
+    struct aws_byte_buf *tape,
+    struct aws_napi_json_tape_error *error) {
+
+    AWS_ZERO_STRUCT(*error);
+
+    struct json_tape_parser parser = {
+        .begin = json.ptr,
+        .current = json.ptr,
+        .end = json.ptr + json.len,
+        .tape = tape,
+        .error = error,
+        .depth = 0,
+    };
+
+    if (s_parse_value(&parser)) {
+        return AWS_OP_ERR;
+    }
+
+    s_skip_whitespace(&parser);
+    if (parser.current != parser.end) {
+        return s_fail(&parser, "unexpected data after JSON value");
+    }
+
+    return AWS_OP_SUCCESS;
+}
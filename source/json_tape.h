@@ -0,0 +1,54 @@
+/**
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0.
+ */
+
+#ifndef AWS_CRT_NODEJS_JSON_TAPE_H
+#define AWS_CRT_NODEJS_JSON_TAPE_H
+
+#include "module.h"
+
+/*
+ * Validation and tokenization of JSON text (RFC 8259) off of node's thread.
+ *
+ * The result is a compact, self-contained "tape": a pre-order walk of the document that node can turn into values
+ * without rescanning the original text.  All integers are little-endian.  Each value is a one byte tag followed by
+ * its data:
+ *
+ *   NULL, FALSE, TRUE    - nothing
+ *   NUMBER               - float64
+ *   STRING               - uint32 byte length, then the UTF-8 bytes with escapes already resolved
+ *   ARRAY                - uint32 element count, then the elements
+ *   OBJECT               - uint32 member count, then for each member a key (uint32 byte length and UTF-8 bytes,
+ *                          without a tag) followed by the member's value
+ *
+ * The text must be UTF-8; invalid sequences are rejected.  Escaped lone surrogates, which UTF-8 cannot represent,
+ * are replaced with U+FFFD.  Numbers are converted independently of the process's locale.  Must match
+ * JsonTapeDecoder in lib/native/mqtt5.ts.
+ */
+enum aws_napi_json_tape_tag {
+    AWS_NAPI_JSON_TAPE_NULL = 0,
+    AWS_NAPI_JSON_TAPE_FALSE = 1,
+    AWS_NAPI_JSON_TAPE_TRUE = 2,
+    AWS_NAPI_JSON_TAPE_NUMBER = 3,
+    AWS_NAPI_JSON_TAPE_STRING = 4,
+    AWS_NAPI_JSON_TAPE_ARRAY = 5,
+    AWS_NAPI_JSON_TAPE_OBJECT = 6,
+};
+
+/* Where and why JSON text was rejected */
+struct aws_napi_json_tape_error {
+    size_t offset;
+    const char *message;
+};
+
+/*
+ * Appends the tape of a JSON document to a dynamically-sized buffer.  If the text is not valid JSON, fills in error
+ * and raises AWS_ERROR_INVALID_ARGUMENT; any other failure leaves error->message NULL.
+ */
+int aws_napi_json_tape_build(
+    struct aws_byte_cursor json,
+    struct aws_byte_buf *tape,
+    struct aws_napi_json_tape_error *error);
+
+#endif /* AWS_CRT_NODEJS_JSON_TAPE_H */
@@ -0,0 +1,245 @@
+/**
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0.
+ */
+
+#include "live_statistics.h"
+
+#include <aws/common/thread.h>
+
+#ifdef _MSC_VER
+#    include <intrin.h>
+#endif /* _MSC_VER */
+
+/* Readers use Atomics, which are sequentially consistent; these must be too */
+#ifdef _MSC_VER
+static uint64_t s_atomic_fetch_add(volatile uint64_t *slot, uint64_t amount) {
+    return (uint64_t)_InterlockedExchangeAdd64((volatile __int64 *)slot, (__int64)amount);
+}
+
+static void s_atomic_store(volatile uint64_t *slot, uint64_t value) {
+    _InterlockedExchange64((volatile __int64 *)slot, (__int64)value);
+}
+#else
+static uint64_t s_atomic_fetch_add(volatile uint64_t *slot, uint64_t amount) {
+    return __atomic_fetch_add(slot, amount, __ATOMIC_SEQ_CST);
+}
+
+static void s_atomic_store(volatile uint64_t *slot, uint64_t value) {
+    __atomic_store_n(slot, value, __ATOMIC_SEQ_CST);
+}
+#endif /* _MSC_VER */
+
+/* How long unbinding sleeps between checks for writers still touching the shared memory */
+#define AWS_NAPI_LIVE_STATISTICS_UNBIND_POLL_NS (10 * 1000)
+
+void aws_napi_live_statistics_init(struct aws_napi_live_statistics *statistics) {
+    AWS_ZERO_STRUCT(*statistics);
+
+    aws_atomic_init_int(&statistics->is_enabled, 0);
+    aws_atomic_init_ptr(&statistics->slots, NULL);
+    aws_atomic_init_int(&statistics->writer_count, 0);
+    aws_atomic_init_int(&statistics->is_gauge_refresh_pending, 0);
+    aws_atomic_init_int(&statistics->is_gauge_refreshing, 0);
+}
+
+void aws_napi_live_statistics_clean_up(struct aws_napi_live_statistics *statistics) {
+    /* the reference can only be released from node's thread, so it must already be gone */
+    AWS_FATAL_ASSERT(statistics->memory_ref == NULL);
+}
+
+int aws_napi_live_statistics_bind_napi(
+    struct aws_napi_live_statistics *statistics,
+    napi_env env,
+    napi_value node_memory) {
+
+    if (statistics->is_closed || aws_atomic_load_ptr(&statistics->slots) != NULL) {
+        return aws_raise_error(AWS_ERROR_INVALID_STATE);
+    }
+
+    napi_typedarray_type array_type = napi_int8_array;
+    size_t memory_size = 0;
+    void *memory = NULL;
+    AWS_NAPI_CALL(env, napi_get_typedarray_info(env, node_memory, &array_type, &memory_size, &memory, NULL, NULL), {
+        return aws_raise_error(AWS_ERROR_INVALID_ARGUMENT);
+    });
+
+    if (array_type != napi_uint8_array || memory == NULL || ((uintptr_t)memory & 7) != 0 ||
+        memory_size < AWS_NAPI_LIVE_STATISTICS_SLOT_COUNT * sizeof(uint64_t)) {
+        return aws_raise_error(AWS_ERROR_INVALID_ARGUMENT);
+    }
+
+    AWS_NAPI_CALL(env, napi_create_reference(env, node_memory, 1, &statistics->memory_ref), {
+        return aws_raise_error(AWS_CRT_NODEJS_ERROR_NAPI_FAILURE);
+    });
+
+    volatile uint64_t *slots = memory;
+    for (size_t i = 0; i < AWS_NAPI_LIVE_STATISTICS_SLOT_COUNT; ++i) {
+        s_atomic_store(&slots[i], 0);
+    }
+
+    /* publishing the slots is what lets writers see them, so they are zeroed first */
+    aws_atomic_store_ptr(&statistics->slots, (void *)slots);
+    aws_atomic_store_int(&statistics->is_enabled, 1);
+
+    return AWS_OP_SUCCESS;
+}
+
+void aws_napi_live_statistics_unbind_napi(struct aws_napi_live_statistics *statistics, napi_env env) {
+    statistics->is_closed = true;
+    aws_atomic_store_int(&statistics->is_enabled, 0);
+    aws_atomic_store_ptr(&statistics->slots, NULL);
+
+    /* a writer that picked up the slots before they were cleared is only a few atomic writes away from leaving */
+    while (aws_atomic_load_int(&statistics->writer_count) != 0) {
+        aws_thread_current_sleep(AWS_NAPI_LIVE_STATISTICS_UNBIND_POLL_NS);
+    }
+
+    /* no writer can touch the shared memory any longer, so it's safe to let it be collected */
+    if (statistics->memory_ref != NULL) {
+        napi_delete_reference(env, statistics->memory_ref);
+        statistics->memory_ref = NULL;
+    }
+}
+
+/*
+ * Writers announce themselves before looking at the slots, so that unbinding (which clears the slots and then waits
+ * for the writer count to drain) never releases the memory under them.  Returns NULL, without needing s_end_write(),
+ * if nothing is bound.
+ */
+static volatile uint64_t *s_begin_write(struct aws_napi_live_statistics *statistics) {
+    if (aws_atomic_load_int(&statistics->is_enabled) == 0) {
+        return NULL;
+    }
+
+    aws_atomic_fetch_add(&statistics->writer_count, 1);
+    volatile uint64_t *slots = aws_atomic_load_ptr(&statistics->slots);
+    if (slots == NULL) {
+        aws_atomic_fetch_sub(&statistics->writer_count, 1);
+    }
+
+    return slots;
+}
+
+static void s_end_write(struct aws_napi_live_statistics *statistics) {
+    aws_atomic_fetch_sub(&statistics->writer_count, 1);
+}
+
+static void s_set_operation_statistics(
+    volatile uint64_t *slots,
+    const struct aws_napi_live_operation_statistics *operation_statistics) {
+
+    s_atomic_store(
+        &slots[AWS_NAPI_LIVE_STAT_INCOMPLETE_OPERATION_COUNT], operation_statistics->incomplete_operation_count);
+    s_atomic_store(
+        &slots[AWS_NAPI_LIVE_STAT_INCOMPLETE_OPERATION_SIZE], operation_statistics->incomplete_operation_size);
+    s_atomic_store(&slots[AWS_NAPI_LIVE_STAT_UNACKED_OPERATION_COUNT], operation_statistics->unacked_operation_count);
+    s_atomic_store(&slots[AWS_NAPI_LIVE_STAT_UNACKED_OPERATION_SIZE], operation_statistics->unacked_operation_size);
+}
+
+bool aws_napi_live_statistics_is_enabled(struct aws_napi_live_statistics *statistics) {
+    return aws_atomic_load_int(&statistics->is_enabled) != 0;
+}
+
+void aws_napi_live_statistics_add(
+    struct aws_napi_live_statistics *statistics,
+    enum aws_napi_live_statistic statistic,
+    uint64_t amount) {
+
+    volatile uint64_t *slots = s_begin_write(statistics);
+    if (slots == NULL) {
+        return;
+    }
+
+    s_atomic_fetch_add(&slots[statistic], amount);
+
+    s_end_write(statistics);
+}
+
+void aws_napi_live_statistics_record_publish_complete(
+    struct aws_napi_live_statistics *statistics,
+    int error_code,
+    uint64_t payload_size) {
+
+    volatile uint64_t *slots = s_begin_write(statistics);
+    if (slots == NULL) {
+        return;
+    }
+
+    if (error_code == AWS_ERROR_SUCCESS) {
+        s_atomic_fetch_add(&slots[AWS_NAPI_LIVE_STAT_PUBLISHES_SENT], 1);
+        s_atomic_fetch_add(&slots[AWS_NAPI_LIVE_STAT_PUBLISH_BYTES_SENT], payload_size);
+    } else {
+        s_atomic_fetch_add(&slots[AWS_NAPI_LIVE_STAT_PUBLISHES_FAILED], 1);
+    }
+
+    s_end_write(statistics);
+}
+
+void aws_napi_live_statistics_record_publish_received(
+    struct aws_napi_live_statistics *statistics,
+    uint64_t payload_size) {
+
+    volatile uint64_t *slots = s_begin_write(statistics);
+    if (slots == NULL) {
+        return;
+    }
+
+    s_atomic_fetch_add(&slots[AWS_NAPI_LIVE_STAT_PUBLISHES_RECEIVED], 1);
+    s_atomic_fetch_add(&slots[AWS_NAPI_LIVE_STAT_PUBLISH_BYTES_RECEIVED], payload_size);
+
+    s_end_write(statistics);
+}
+
+void aws_napi_live_statistics_record_connection_success(struct aws_napi_live_statistics *statistics) {
+    volatile uint64_t *slots = s_begin_write(statistics);
+    if (slots == NULL) {
+        return;
+    }
+
+    if (s_atomic_fetch_add(&slots[AWS_NAPI_LIVE_STAT_CONNECTION_SUCCESSES], 1) > 0) {
+        s_atomic_fetch_add(&slots[AWS_NAPI_LIVE_STAT_RECONNECTS], 1);
+    }
+
+    s_end_write(statistics);
+}
+
+/*
+ * Gauges are snapshots rather than sums, so two threads writing them at once could leave an older snapshot on top of
+ * a newer one.  Only one thread refreshes them at a time; anyone else asking meanwhile just marks a refresh as pending
+ * and returns, and the refreshing thread goes round again, taking a new snapshot, until nothing is pending.  The
+ * snapshot is taken inside the write, so unbinding also waits for it.
+ */
+void aws_napi_live_statistics_refresh_operation_statistics(
+    struct aws_napi_live_statistics *statistics,
+    aws_napi_live_operation_statistics_fn *get_operation_statistics,
+    void *user_data) {
+
+    if (aws_atomic_load_int(&statistics->is_enabled) == 0) {
+        return;
+    }
+
+    aws_atomic_store_int(&statistics->is_gauge_refresh_pending, 1);
+
+    while (aws_atomic_load_int(&statistics->is_gauge_refresh_pending) != 0) {
+        size_t expected = 0;
+        if (!aws_atomic_compare_exchange_int(&statistics->is_gauge_refreshing, &expected, 1)) {
+            /* whoever is refreshing will see the pending flag once done */
+            return;
+        }
+
+        aws_atomic_store_int(&statistics->is_gauge_refresh_pending, 0);
+
+        volatile uint64_t *slots = s_begin_write(statistics);
+        if (slots != NULL) {
+            struct aws_napi_live_operation_statistics operation_statistics;
+            AWS_ZERO_STRUCT(operation_statistics);
+            get_operation_statistics(user_data, &operation_statistics);
+            s_set_operation_statistics(slots, &operation_statistics);
+
+            s_end_write(statistics);
+        }
+
+        aws_atomic_store_int(&statistics->is_gauge_refreshing, 0);
+    }
+}
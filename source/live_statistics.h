@@ -0,0 +1,116 @@
+/**
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0.
+ */
+
+#ifndef AWS_CRT_NODEJS_LIVE_STATISTICS_H
+#define AWS_CRT_NODEJS_LIVE_STATISTICS_H
+
+#include "module.h"
+
+#include <aws/common/atomics.h>
+
+/*
+ * Client counters kept in memory shared with JavaScript (a SharedArrayBuffer), so that node can read them at any
+ * rate without calling into native code.  LiveStatistics in lib/native/live_statistics.ts is the reader side and
+ * must agree with the slot indices below.
+ *
+ * Each slot is a native-endian uint64 written with sequentially consistent atomics, so a BigUint64Array read with
+ * Atomics.load never sees a torn value.  Operation counts and sizes are gauges refreshed whenever the client records
+ * an event; everything else only increases.  Unused slots are reserved for future counters and stay zero.
+ */
+enum aws_napi_live_statistic {
+    AWS_NAPI_LIVE_STAT_INCOMPLETE_OPERATION_COUNT = 0,
+    AWS_NAPI_LIVE_STAT_INCOMPLETE_OPERATION_SIZE = 1,
+    AWS_NAPI_LIVE_STAT_UNACKED_OPERATION_COUNT = 2,
+    AWS_NAPI_LIVE_STAT_UNACKED_OPERATION_SIZE = 3,
+    AWS_NAPI_LIVE_STAT_PUBLISHES_SENT = 4,
+    AWS_NAPI_LIVE_STAT_PUBLISH_BYTES_SENT = 5,
+    AWS_NAPI_LIVE_STAT_PUBLISHES_FAILED = 6,
+    AWS_NAPI_LIVE_STAT_PUBLISHES_RECEIVED = 7,
+    AWS_NAPI_LIVE_STAT_PUBLISH_BYTES_RECEIVED = 8,
+    AWS_NAPI_LIVE_STAT_CONNECTION_SUCCESSES = 9,
+    AWS_NAPI_LIVE_STAT_CONNECTION_FAILURES = 10,
+    AWS_NAPI_LIVE_STAT_CONNECTION_DROPS = 11,
+    AWS_NAPI_LIVE_STAT_RECONNECTS = 12,
+};
+
+#define AWS_NAPI_LIVE_STATISTICS_SLOT_COUNT 16
+
+/*
+ * The shared memory is owned by JS, so it must not be touched once node has let go of it.  Writers take no lock: they
+ * count themselves in and out around their atomic writes, and unbinding clears the slots and waits for that count to
+ * drain before releasing the memory.  Binding and unbinding only happen on node's thread.
+ */
+struct aws_napi_live_statistics {
+    struct aws_atomic_var is_enabled;
+    struct aws_atomic_var slots;
+    struct aws_atomic_var writer_count;
+    struct aws_atomic_var is_gauge_refresh_pending;
+    struct aws_atomic_var is_gauge_refreshing;
+    bool is_closed;
+    napi_ref memory_ref;
+};
+
+struct aws_napi_live_operation_statistics {
+    uint64_t incomplete_operation_count;
+    uint64_t incomplete_operation_size;
+    uint64_t unacked_operation_count;
+    uint64_t unacked_operation_size;
+};
+
+void aws_napi_live_statistics_init(struct aws_napi_live_statistics *statistics);
+
+void aws_napi_live_statistics_clean_up(struct aws_napi_live_statistics *statistics);
+
+/*
+ * Starts writing counters into a Uint8Array over a SharedArrayBuffer, holding a reference to it until unbound.
+ * Fails with AWS_ERROR_INVALID_STATE if counters were already bound (or unbound), and AWS_ERROR_INVALID_ARGUMENT if
+ * the array is not a suitably sized and aligned Uint8Array.
+ */
+int aws_napi_live_statistics_bind_napi(
+    struct aws_napi_live_statistics *statistics,
+    napi_env env,
+    napi_value node_memory);
+
+/* Stops all further writes and releases the shared memory; must be called from node's thread */
+void aws_napi_live_statistics_unbind_napi(struct aws_napi_live_statistics *statistics, napi_env env);
+
+/* Whether counters are currently bound, for callers that would otherwise do extra work just to record them */
+bool aws_napi_live_statistics_is_enabled(struct aws_napi_live_statistics *statistics);
+
+void aws_napi_live_statistics_add(
+    struct aws_napi_live_statistics *statistics,
+    enum aws_napi_live_statistic statistic,
+    uint64_t amount);
+
+/* Counts one completed publish as sent (with its payload size) or failed */
+void aws_napi_live_statistics_record_publish_complete(
+    struct aws_napi_live_statistics *statistics,
+    int error_code,
+    uint64_t payload_size);
+
+/* Counts one received publish along with its payload size */
+void aws_napi_live_statistics_record_publish_received(
+    struct aws_napi_live_statistics *statistics,
+    uint64_t payload_size);
+
+/* Counts a successful connection, and a reconnect if it was not the first */
+void aws_napi_live_statistics_record_connection_success(struct aws_napi_live_statistics *statistics);
+
+/* Fills in a snapshot of the client's operation statistics */
+typedef void(aws_napi_live_operation_statistics_fn)(
+    void *user_data,
+    struct aws_napi_live_operation_statistics *operation_statistics);
+
+/*
+ * Refreshes the operation gauges from a snapshot taken by get_operation_statistics.  Does nothing, without taking the
+ * snapshot, unless counters are bound.  The snapshot may be taken on another thread that is refreshing at the same
+ * time, but never once unbinding has returned, so it may use anything that outlives the binding.
+ */
+void aws_napi_live_statistics_refresh_operation_statistics(
+    struct aws_napi_live_statistics *statistics,
+    aws_napi_live_operation_statistics_fn *get_operation_statistics,
+    void *user_data);
+
+#endif /* AWS_CRT_NODEJS_LIVE_STATISTICS_H */
@@ -69,6 +69,12 @@ static struct aws_error_info s_errors[] = {
     AWS_DEFINE_ERROR_INFO_CRT_NODEJS(
         AWS_CRT_NODEJS_ERROR_EVENT_STREAM_USER_CLOSE,
         "User invoked close on an eventstream connection."),
+    AWS_DEFINE_ERROR_INFO_CRT_NODEJS(
+        AWS_CRT_NODEJS_ERROR_MQTT5_PERSISTENT_QUEUE_FULL,
+        "Publish rejected because the mqtt5 client's persistent queue has reached its size limit."),
+    AWS_DEFINE_ERROR_INFO_CRT_NODEJS(
+        AWS_CRT_NODEJS_ERROR_MQTT5_OPERATION_EVICTED,
+        "Publish evicted from the mqtt5 client's offline queue to stay within its configured limits."),
 };
 /* clang-format on */
 
@@ -268,6 +274,19 @@ static void s_finalize_external_binary_byte_buf(napi_env env, void *finalize_dat
     aws_mem_release(allocator, buffer);
 }
 
+int aws_napi_create_binary_as_finalizable_external(
+    napi_env env,
+    struct aws_byte_buf *data_buffer,
+    napi_value *result) {
+
+    AWS_NAPI_ENSURE(
+        env,
+        aws_napi_create_external_arraybuffer(
+            env, data_buffer->buffer, data_buffer->len, s_finalize_external_binary_byte_buf, data_buffer, result));
+
+    return AWS_OP_SUCCESS;
+}
+
 int aws_napi_attach_object_property_binary_as_finalizable_external(
     napi_value object,
     napi_env env,
@@ -279,16 +298,9 @@ int aws_napi_attach_object_property_binary_as_finalizable_external(
     }
 
     napi_value napi_binary = NULL;
-
-    AWS_NAPI_ENSURE(
-        env,
-        aws_napi_create_external_arraybuffer(
-            env,
-            data_buffer->buffer,
-            data_buffer->len,
-            s_finalize_external_binary_byte_buf,
-            data_buffer,
-            &napi_binary));
+    if (aws_napi_create_binary_as_finalizable_external(env, data_buffer, &napi_binary)) {
+        return AWS_OP_ERR;
+    }
 
     AWS_NAPI_CALL(env, napi_set_named_property(env, object, key_name, napi_binary), {
         return aws_raise_error(AWS_CRT_NODEJS_ERROR_NAPI_FAILURE);
@@ -687,6 +699,54 @@ napi_status aws_byte_buf_init_from_napi(struct aws_byte_buf *buf, napi_env env,
     return napi_invalid_arg;
 }
 
+napi_status aws_napi_borrow_byte_cursor_from_napi(
+    napi_env env,
+    napi_value node_value,
+    struct aws_byte_buf *scratch,
+    struct aws_byte_cursor *cursor) {
+
+    AWS_ASSERT(scratch);
+    AWS_ASSERT(cursor);
+
+    napi_valuetype type = napi_undefined;
+    AWS_NAPI_CALL(env, napi_typeof(env, node_value, &type), { return status; });
+
+    if (type == napi_string) {
+        size_t length = 0;
+        AWS_NAPI_CALL(env, napi_get_value_string_utf8(env, node_value, NULL, 0, &length), { return status; });
+
+        /* Node requires that the null terminator be written */
+        scratch->len = 0;
+        if (aws_byte_buf_reserve(scratch, length + 1)) {
+            return napi_generic_failure;
+        }
+
+        AWS_NAPI_CALL(
+            env,
+            napi_get_value_string_utf8(env, node_value, (char *)scratch->buffer, scratch->capacity, &scratch->len),
+            { return status; });
+
+        *cursor = aws_byte_cursor_from_buf(scratch);
+        return napi_ok;
+    }
+
+    /* binary values are never copied, the buffer just points at node's memory */
+    struct aws_byte_buf borrowed;
+    AWS_ZERO_STRUCT(borrowed);
+    AWS_NAPI_CALL(env, aws_byte_buf_init_from_napi(&borrowed, env, node_value), { return status; });
+
+    *cursor = aws_byte_cursor_from_buf(&borrowed);
+    return napi_ok;
+}
+
+void aws_napi_trim_scratch_buf(struct aws_byte_buf *scratch) {
+    if (scratch->capacity > AWS_NAPI_SCRATCH_BUF_RETAIN_LIMIT) {
+        struct aws_allocator *allocator = scratch->allocator;
+        aws_byte_buf_clean_up(scratch);
+        aws_byte_buf_init(scratch, allocator, 0);
+    }
+}
+
 struct aws_string *aws_string_new_from_napi(napi_env env, napi_value node_str) {
 
     struct aws_byte_buf temp_buf;
@@ -1375,7 +1435,20 @@ static bool s_create_and_register_function(
     CREATE_AND_REGISTER_FN(mqtt5_client_subscribe)
     CREATE_AND_REGISTER_FN(mqtt5_client_unsubscribe)
     CREATE_AND_REGISTER_FN(mqtt5_client_publish)
+    CREATE_AND_REGISTER_FN(mqtt5_client_prepare_publish)
+    CREATE_AND_REGISTER_FN(mqtt5_client_publish_prepared)
     CREATE_AND_REGISTER_FN(mqtt5_client_get_queue_statistics)
+    CREATE_AND_REGISTER_FN(mqtt5_client_enable_request_response)
+    CREATE_AND_REGISTER_FN(mqtt5_client_disable_request_response)
+    CREATE_AND_REGISTER_FN(mqtt5_client_add_response_filter)
+    CREATE_AND_REGISTER_FN(mqtt5_client_remove_response_filter)
+    CREATE_AND_REGISTER_FN(mqtt5_client_add_pending_request)
+    CREATE_AND_REGISTER_FN(mqtt5_client_remove_pending_request)
+    CREATE_AND_REGISTER_FN(mqtt5_client_set_message_filter)
+    CREATE_AND_REGISTER_FN(mqtt5_client_set_last_value_cache)
+    CREATE_AND_REGISTER_FN(mqtt5_client_get_last_value)
+    CREATE_AND_REGISTER_FN(mqtt5_client_get_last_value_snapshot)
+    CREATE_AND_REGISTER_FN(mqtt5_client_set_live_statistics)
     CREATE_AND_REGISTER_FN(mqtt5_client_close)
 
     /* MQTT Client */
@@ -1386,13 +1459,17 @@ static bool s_create_and_register_function(
     CREATE_AND_REGISTER_FN(mqtt_client_connection_connect)
     CREATE_AND_REGISTER_FN(mqtt_client_connection_reconnect)
     CREATE_AND_REGISTER_FN(mqtt_client_connection_publish)
+    CREATE_AND_REGISTER_FN(mqtt_client_connection_publish_many)
     CREATE_AND_REGISTER_FN(mqtt_client_connection_subscribe)
+    CREATE_AND_REGISTER_FN(mqtt_client_connection_subscribe_multiple)
     CREATE_AND_REGISTER_FN(mqtt_client_connection_on_message)
     CREATE_AND_REGISTER_FN(mqtt_client_connection_on_closed)
     CREATE_AND_REGISTER_FN(mqtt_client_connection_unsubscribe)
     CREATE_AND_REGISTER_FN(mqtt_client_connection_disconnect)
     CREATE_AND_REGISTER_FN(mqtt_client_connection_close)
     CREATE_AND_REGISTER_FN(mqtt_client_connection_get_queue_statistics)
+    CREATE_AND_REGISTER_FN(mqtt_client_connection_set_message_filter)
+    CREATE_AND_REGISTER_FN(mqtt_client_connection_set_live_statistics)
 
     /* Crypto */
     CREATE_AND_REGISTER_FN(hash_md5_new)
@@ -1441,6 +1518,7 @@ static bool s_create_and_register_function(
     AWS_NAPI_ENSURE(env, aws_napi_http_headers_bind(env, exports));
     AWS_NAPI_ENSURE(env, aws_napi_http_message_bind(env, exports));
     AWS_NAPI_ENSURE(env, aws_napi_auth_bind(env, exports));
+    AWS_NAPI_ENSURE(env, aws_napi_mqtt5_client_bind(env, exports));
 
     return exports;
 }
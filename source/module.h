@@ -35,6 +35,8 @@ enum aws_crt_nodejs_errors {
     AWS_CRT_NODEJS_ERROR_THREADSAFE_FUNCTION_NULL_NAPI_ENV = AWS_ERROR_ENUM_BEGIN_RANGE(AWS_CRT_NODEJS_PACKAGE_ID),
     AWS_CRT_NODEJS_ERROR_NAPI_FAILURE,
     AWS_CRT_NODEJS_ERROR_EVENT_STREAM_USER_CLOSE,
+    AWS_CRT_NODEJS_ERROR_MQTT5_PERSISTENT_QUEUE_FULL,
+    AWS_CRT_NODEJS_ERROR_MQTT5_OPERATION_EVICTED,
 
     AWS_CRT_NODEJS_ERROR_END_RANGE = AWS_ERROR_ENUM_END_RANGE(AWS_CRT_NODEJS_PACKAGE_ID)
 };
@@ -104,6 +106,15 @@ int aws_napi_attach_object_property_binary_as_finalizable_external(
     const char *key_name,
     struct aws_byte_buf *data_buffer);
 
+/*
+ * Creates an ArrayBuffer over a heap-allocated byte buf.  The ArrayBuffer takes ownership of the buffer and destroys
+ * it when finalized.
+ */
+int aws_napi_create_binary_as_finalizable_external(
+    napi_env env,
+    struct aws_byte_buf *data_buffer,
+    napi_value *result);
+
 /*
  * Helper functions for deconstructing JS objects into native data.
  */
@@ -206,6 +217,21 @@ int aws_napi_get_property_array_size(
     size_t *array_size_out);
 
 napi_status aws_byte_buf_init_from_napi(struct aws_byte_buf *buf, napi_env env, napi_value node_str);
+
+/* Scratch buffers larger than this are released by aws_napi_trim_scratch_buf rather than kept for the next call */
+#define AWS_NAPI_SCRATCH_BUF_RETAIN_LIMIT (64 * 1024)
+
+/**
+ * Points cursor at the bytes of a string or binary value from node.  Binary values are borrowed in place and strings
+ * are encoded into scratch, so the bytes are only valid until scratch is next used or node collects the value.
+ */
+napi_status aws_napi_borrow_byte_cursor_from_napi(
+    napi_env env,
+    napi_value node_value,
+    struct aws_byte_buf *scratch,
+    struct aws_byte_cursor *cursor);
+/** Releases scratch's memory if an unusually large value grew it past AWS_NAPI_SCRATCH_BUF_RETAIN_LIMIT. */
+void aws_napi_trim_scratch_buf(struct aws_byte_buf *scratch);
 struct aws_string *aws_string_new_from_napi(napi_env env, napi_value node_str);
 /** Copies data from cur into a new ArrayBuffer, then returns a DataView to the buffer. */
 napi_status aws_napi_create_dataview_from_byte_cursor(
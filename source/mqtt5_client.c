@@ -4,13 +4,30 @@
  */
 
 #include "mqtt5_client.h"
+#include "auth.h"
+#include "class_binder.h"
 #include "http_connection.h"
 #include "http_message.h"
 #include "io.h"
-
+#include "json_tape.h"
+#include "live_statistics.h"
+#include "mqtt5_persistent_queue.h"
+#include "mqtt5_response_router.h"
+#include "mqtt_last_value_cache.h"
+#include "mqtt_message_filter.h"
+#include "mqtt_topic_intern_cache.h"
+#include "shared_ring.h"
+
+#include <aws/common/atomics.h>
+#include <aws/common/clock.h>
+#include <aws/common/linked_list.h>
+#include <aws/common/math.h>
+#include <aws/common/mutex.h>
+#include <aws/common/priority_queue.h>
 #include <aws/http/proxy.h>
 #include <aws/io/socket.h>
 #include <aws/io/tls_channel_handler.h>
+#include <aws/mqtt/mqtt.h>
 #include <aws/mqtt/v5/mqtt5_client.h>
 #include <aws/mqtt/v5/mqtt5_packet_storage.h>
 #include <aws/mqtt/v5/mqtt5_types.h>
@@ -77,6 +94,7 @@ static const char *AWS_NAPI_KEY_CONNACK_TIMEOUT_MS = "connackTimeoutMs";
 static const char *AWS_NAPI_KEY_ACK_TIMEOUT_SECONDS = "ackTimeoutSeconds";
 static const char *AWS_NAPI_KEY_CONNECT_PROPERTIES = "connectProperties";
 static const char *AWS_NAPI_KEY_WEBSOCKET_HANDSHAKE_TRANSFORM = "websocketHandshakeTransform";
+static const char *AWS_NAPI_KEY_WEBSOCKET_SIGNING_CONFIG = "websocketSigningConfig";
 static const char *AWS_NAPI_KEY_SUBSCRIPTIONS = "subscriptions";
 static const char *AWS_NAPI_KEY_TOPIC_FILTER = "topicFilter";
 static const char *AWS_NAPI_KEY_TOPIC_FILTERS = "topicFilters";
@@ -95,6 +113,253 @@ static const char *AWS_NAPI_KEY_OUTBOUND_BEHAVIOR = "outboundBehavior";
 static const char *AWS_NAPI_KEY_OUTBOUND_CACHE_MAX_SIZE = "outboundCacheMaxSize";
 static const char *AWS_NAPI_KEY_INBOUND_BEHAVIOR = "inboundBehavior";
 static const char *AWS_NAPI_KEY_INBOUND_CACHE_MAX_SIZE = "inboundCacheMaxSize";
+static const char *AWS_NAPI_KEY_INBOUND_FLOW_CONTROL_OPTIONS = "inboundFlowControlOptions";
+static const char *AWS_NAPI_KEY_MAX_PENDING_MESSAGE_COUNT = "maxPendingMessageCount";
+static const char *AWS_NAPI_KEY_MAX_PENDING_MESSAGE_SIZE = "maxPendingMessageSize";
+static const char *AWS_NAPI_KEY_PENDING_RECEIVED_MESSAGE_COUNT = "pendingReceivedMessageCount";
+static const char *AWS_NAPI_KEY_PENDING_RECEIVED_MESSAGE_SIZE = "pendingReceivedMessageSize";
+static const char *AWS_NAPI_KEY_INBOUND_FLOW_CONTROL_DROPPED_COUNT = "inboundFlowControlDroppedCount";
+static const char *AWS_NAPI_KEY_PERSISTENT_QUEUE_OPTIONS = "persistentQueueOptions";
+static const char *AWS_NAPI_KEY_DIRECTORY = "directory";
+static const char *AWS_NAPI_KEY_MAX_SIZE_BYTES = "maxSizeBytes";
+static const char *AWS_NAPI_KEY_SEGMENT_SIZE_BYTES = "segmentSizeBytes";
+static const char *AWS_NAPI_KEY_PERSISTENT_QUEUE_PENDING_COUNT = "persistentQueuePendingCount";
+static const char *AWS_NAPI_KEY_PERSISTENT_QUEUE_SIZE = "persistentQueueSize";
+static const char *AWS_NAPI_KEY_OFFLINE_QUEUE_LIMITS = "offlineQueueLimits";
+static const char *AWS_NAPI_KEY_MAX_QUEUED_PUBLISH_COUNT = "maxQueuedPublishCount";
+static const char *AWS_NAPI_KEY_MAX_QUEUED_PUBLISH_SIZE = "maxQueuedPublishSize";
+static const char *AWS_NAPI_KEY_EVICTION_POLICY = "evictionPolicy";
+static const char *AWS_NAPI_KEY_PRIORITY = "priority";
+static const char *AWS_NAPI_KEY_OFFLINE_QUEUED_PUBLISH_COUNT = "offlineQueuedPublishCount";
+static const char *AWS_NAPI_KEY_OFFLINE_QUEUED_PUBLISH_SIZE = "offlineQueuedPublishSize";
+static const char *AWS_NAPI_KEY_EVICTED_PUBLISH_COUNT = "evictedPublishCount";
+static const char *AWS_NAPI_KEY_EVICTED_PUBLISH_SIZE = "evictedPublishSize";
+static const char *AWS_NAPI_KEY_UTF8_PAYLOAD_DELIVERY = "utf8PayloadDelivery";
+static const char *AWS_NAPI_KEY_LAZY_PUBLISH_PROPERTIES = "lazyPublishProperties";
+static const char *AWS_NAPI_KEY_TOPIC_INTERN_CACHE_SIZE = "topicInternCacheSize";
+static const char *AWS_NAPI_KEY_BINARY_PUBLISH_ENCODING = "binaryPublishEncoding";
+static const char *AWS_NAPI_KEY_UNMATCHED_RESPONSE_COUNT = "unmatchedResponseCount";
+static const char *AWS_NAPI_KEY_FILTERED_MESSAGE_COUNT = "filteredMessageCount";
+static const char *AWS_NAPI_KEY_SAMPLED_OUT_MESSAGE_COUNT = "sampledOutMessageCount";
+static const char *AWS_NAPI_KEY_RATE_LIMITED_MESSAGE_COUNT = "rateLimitedMessageCount";
+static const char *AWS_NAPI_KEY_DELIVERY_PRIORITY_OPTIONS = "deliveryPriorityOptions";
+static const char *AWS_NAPI_KEY_RULES = "rules";
+static const char *AWS_NAPI_KEY_DELIVERY_PRIORITY_STATISTICS = "deliveryPriorityStatistics";
+static const char *AWS_NAPI_KEY_PENDING_COUNT = "pendingCount";
+static const char *AWS_NAPI_KEY_DELIVERED_COUNT = "deliveredCount";
+static const char *AWS_NAPI_KEY_AVERAGE_QUEUEING_DELAY_US = "averageQueueingDelayUs";
+static const char *AWS_NAPI_KEY_MAX_QUEUEING_DELAY_US = "maxQueueingDelayUs";
+static const char *AWS_NAPI_KEY_OUTBOUND_PRIORITY_OPTIONS = "outboundPriorityOptions";
+static const char *AWS_NAPI_KEY_MAX_IN_FLIGHT_PUBLISHES = "maxInFlightPublishes";
+static const char *AWS_NAPI_KEY_WEIGHTS = "weights";
+static const char *AWS_NAPI_KEY_OUTBOUND_PRIORITY_STATISTICS = "outboundPriorityStatistics";
+static const char *AWS_NAPI_KEY_QUEUED_COUNT = "queuedCount";
+static const char *AWS_NAPI_KEY_SUBMITTED_COUNT = "submittedCount";
+static const char *AWS_NAPI_KEY_LAST_VALUE_CACHE_TOPIC_COUNT = "lastValueCacheTopicCount";
+static const char *AWS_NAPI_KEY_LAST_VALUE_CACHE_SIZE = "lastValueCacheSize";
+static const char *AWS_NAPI_KEY_LAST_VALUE_CACHE_EVICTED_COUNT = "lastValueCacheEvictedCount";
+static const char *AWS_NAPI_KEY_JSON_PAYLOAD_OPTIONS = "jsonPayloadOptions";
+static const char *AWS_NAPI_KEY_MESSAGE = "message";
+static const char *AWS_NAPI_KEY_OFFSET = "offset";
+
+/* persistent queue defaults when only a directory is configured */
+static const uint64_t s_default_persistent_queue_max_size = 64ULL * 1024ULL * 1024ULL;
+static const uint64_t s_default_persistent_queue_segment_size = 4ULL * 1024ULL * 1024ULL;
+
+/*
+ * Tracks messages that have been received by the native client but not yet delivered to node.  The event loop thread
+ * is shared with every other connection on the same event loop group, so it never waits for node: when limits are
+ * configured and exceeded, QoS 0 messages are dropped and counted instead.  The client acknowledges QoS 1 and 2
+ * messages as soon as the binding has seen them, whether or not node has, so there is no way to push back on those;
+ * they are always queued, even past the limits, which therefore only bound QoS 0 traffic.
+ *
+ * Messages are only ever admitted from the client's event loop thread and released from node's thread, so plain
+ * atomics are enough to keep the totals.
+ */
+struct aws_napi_mqtt5_inbound_flow_control {
+
+    /* zero means unlimited; set before the client starts and never changed after */
+    uint64_t max_pending_message_count;
+    uint64_t max_pending_message_size;
+
+    struct aws_atomic_var pending_message_count;
+    struct aws_atomic_var pending_message_size;
+    struct aws_atomic_var dropped_message_count;
+
+    /* set while QoS 0 messages are being dropped, so that each run of drops is logged once; event loop thread only */
+    bool is_dropping;
+};
+
+/* How received payloads are handed to node; mirrors Utf8PayloadDelivery */
+enum aws_napi_mqtt5_utf8_payload_delivery {
+    AWS_NAPI_MQTT5_UPD_BINARY = 0,
+    AWS_NAPI_MQTT5_UPD_STRING_IF_UTF8_INDICATED = 1,
+    AWS_NAPI_MQTT5_UPD_ALWAYS_STRING = 2,
+};
+
+/* Which held publish gives way when the offline queue limits would be exceeded; mirrors OfflineQueueEvictionPolicy */
+enum aws_napi_mqtt5_offline_queue_eviction_policy {
+    AWS_NAPI_MQTT5_OQEP_OLDEST = 0,
+    AWS_NAPI_MQTT5_OQEP_QOS0_FIRST = 1,
+    AWS_NAPI_MQTT5_OQEP_LOWEST_PRIORITY_FIRST = 2,
+};
+
+/*
+ * When limits are configured, publishes submitted while the client is not connected are held by the binding rather
+ * than the native client, so that their total count and size can be bounded.  Held publishes are handed to the native
+ * client, in submission order, as soon as a connection is established.  When holding another publish would exceed a
+ * limit, publishes are evicted according to the eviction policy and failed with
+ * AWS_CRT_NODEJS_ERROR_MQTT5_OPERATION_EVICTED.
+ */
+struct aws_napi_mqtt5_offline_queue {
+    bool is_enabled;
+
+    /* zero means unlimited */
+    uint64_t max_publish_count;
+    uint64_t max_publish_size;
+    enum aws_napi_mqtt5_offline_queue_eviction_policy eviction_policy;
+
+    struct aws_mutex lock;
+
+    /* protected by lock */
+    bool is_connected;
+    bool is_closed;
+
+    /* aws_napi_mqtt5_held_publish, in submission order */
+    struct aws_linked_list held_publishes;
+
+    /* aws_napi_mqtt5_held_publish *, with the next eviction candidate on top */
+    struct aws_priority_queue eviction_order;
+
+    uint64_t next_sequence_number;
+    uint64_t held_publish_count;
+    uint64_t held_publish_size;
+    uint64_t evicted_publish_count;
+    uint64_t evicted_publish_size;
+};
+
+/* Number of outbound publish priority classes; mirrors MAX_PUBLISH_PRIORITY in mqtt5.ts */
+#define AWS_NAPI_MQTT5_PUBLISH_PRIORITY_COUNT 4
+
+static const uint32_t s_default_max_in_flight_publishes = 16;
+static const uint32_t s_default_publish_priority_weights[AWS_NAPI_MQTT5_PUBLISH_PRIORITY_COUNT] = {1, 2, 4, 8};
+
+struct aws_napi_mqtt5_publish_class {
+    /* aws_napi_mqtt5_scheduled_publish, in submission order */
+    struct aws_linked_list queued_publishes;
+
+    uint32_t weight;
+
+    /* smooth weighted round robin credit */
+    int64_t current_weight;
+
+    uint64_t queued_count;
+    uint64_t submitted_count;
+};
+
+/*
+ * When configured, publishes are not handed to the native client, whose operation queue is strictly FIFO, as soon as
+ * they are submitted.  Instead the binding keeps one queue per priority class and only lets a bounded number of
+ * publishes be incomplete inside the native client at once.  Whenever there is room, the next publish is taken from
+ * the non-empty classes by smooth weighted round robin, so higher priorities get proportionally more of the
+ * connection without starving lower ones.  Publishes then go through the offline queue as usual.
+ */
+struct aws_napi_mqtt5_outbound_scheduler {
+    bool is_enabled;
+
+    uint32_t max_in_flight_publishes;
+
+    struct aws_mutex lock;
+
+    /* protected by lock */
+    bool is_closed;
+    bool is_pumping;
+    uint32_t in_flight_publishes;
+    struct aws_napi_mqtt5_publish_class classes[AWS_NAPI_MQTT5_PUBLISH_PRIORITY_COUNT];
+};
+
+struct aws_napi_mqtt5_operation_binding;
+
+/* A publish waiting in the outbound scheduler for its turn */
+struct aws_napi_mqtt5_scheduled_publish {
+    struct aws_allocator *allocator;
+    struct aws_linked_list_node node;
+
+    struct aws_mqtt5_packet_publish_storage publish_storage;
+    struct aws_napi_mqtt5_operation_binding *operation;
+
+    uint32_t priority;
+};
+
+/* A publish waiting in the offline queue for the client to connect */
+struct aws_napi_mqtt5_held_publish {
+    struct aws_allocator *allocator;
+    struct aws_linked_list_node node;
+    struct aws_priority_queue_node eviction_node;
+
+    struct aws_mqtt5_packet_publish_storage publish_storage;
+    struct aws_napi_mqtt5_operation_binding *operation;
+
+    uint64_t size;
+
+    /* lower ranks are evicted first; ties go to the oldest publish */
+    uint64_t eviction_rank;
+    uint64_t sequence_number;
+
+    /* set if handing the publish to the native client failed on connection */
+    int submit_error_code;
+};
+
+static int s_compare_held_publish_eviction_order(const void *a, const void *b) {
+    const struct aws_napi_mqtt5_held_publish *lhs = *(const struct aws_napi_mqtt5_held_publish **)a;
+    const struct aws_napi_mqtt5_held_publish *rhs = *(const struct aws_napi_mqtt5_held_publish **)b;
+
+    if (lhs->eviction_rank != rhs->eviction_rank) {
+        return lhs->eviction_rank < rhs->eviction_rank ? -1 : 1;
+    }
+
+    if (lhs->sequence_number != rhs->sequence_number) {
+        return lhs->sequence_number < rhs->sequence_number ? -1 : 1;
+    }
+
+    return 0;
+}
+
+/* Number of delivery priority classes; mirrors MAX_DELIVERY_PRIORITY in mqtt5.ts */
+#define AWS_NAPI_MQTT5_DELIVERY_PRIORITY_COUNT 4
+
+struct aws_napi_mqtt5_delivery_priority_rule {
+    struct aws_byte_buf topic_filter;
+    uint32_t priority;
+};
+
+struct aws_napi_mqtt5_delivery_lane {
+    /* on_message_received_user_data, oldest first */
+    struct aws_linked_list pending;
+
+    uint64_t pending_count;
+    uint64_t delivered_count;
+    uint64_t total_queueing_delay_ns;
+    uint64_t max_queueing_delay_ns;
+};
+
+/*
+ * Optional priority ordering of received messages on their way to node.  Every message is still queued on the
+ * message received threadsafe function, which is strictly FIFO, but is also appended to the lane for its priority.
+ * Each threadsafe function call then delivers the oldest message of the highest-priority non-empty lane rather than
+ * the message it was queued with, so the number of calls still matches the number of messages.
+ */
+struct aws_napi_mqtt5_delivery_lanes {
+    bool is_enabled;
+
+    /* aws_napi_mqtt5_delivery_priority_rule, first match wins; immutable once the client is created */
+    struct aws_array_list rules;
+
+    struct aws_mutex lock;
+
+    /* protected by lock */
+    struct aws_napi_mqtt5_delivery_lane lanes[AWS_NAPI_MQTT5_DELIVERY_PRIORITY_COUNT];
+};
 
 /*
  * Binding object that outlives the associated napi wrapper object.  When that object finalizes, then it's a signal
@@ -139,6 +404,98 @@ struct aws_mqtt5_client_binding {
     napi_threadsafe_function on_message_received;
 
     napi_threadsafe_function transform_websocket;
+
+    /* Signs websocket handshakes on the event loop thread; mutually exclusive with transform_websocket */
+    struct aws_napi_websocket_signer *websocket_signer;
+
+    struct aws_napi_mqtt5_inbound_flow_control inbound_flow_control;
+
+    struct aws_napi_mqtt5_delivery_lanes delivery_lanes;
+
+    /*
+     * aws_byte_buf, topic filters of received publishes whose payloads are parsed as JSON on the event loop thread.
+     * Immutable once the client is created.
+     */
+    struct aws_array_list json_payload_topic_filters;
+
+    /*
+     * Optional disk-backed log of outbound QoS 1 publishes.  Only destroyed along with the binding, after every
+     * publish completion has been processed.
+     */
+    struct aws_napi_mqtt5_persistent_queue *persistent_queue;
+
+    struct aws_napi_mqtt5_offline_queue offline_queue;
+
+    struct aws_napi_mqtt5_outbound_scheduler outbound_scheduler;
+
+    enum aws_napi_mqtt5_utf8_payload_delivery utf8_payload_delivery;
+
+    /* when set, secondary PUBLISH fields are only converted to js values when they are read */
+    bool lazy_publish_properties;
+
+    /*
+     * When set, received PUBLISH packets are serialized into a reusable ArrayBuffer and decoded in JS rather than
+     * built property by property.  The buffer is owned by JS; we hold a strong ref to it and only touch it from the
+     * libuv thread.
+     */
+    bool binary_publish_encoding;
+    napi_ref publish_record_buffer_ref;
+    uint8_t *publish_record_buffer;
+    size_t publish_record_buffer_capacity;
+
+    /*
+     * Optional delivery channel where the event loop thread writes received publishes directly into a
+     * SharedArrayBuffer supplied by JS.  The lock serializes producers against each other and against close, after
+     * which the shared memory may no longer be touched.
+     */
+    bool is_message_ring_enabled;
+    struct aws_mutex message_ring_lock;
+    bool is_message_ring_closed;
+    struct aws_napi_shared_ring message_ring;
+    napi_ref message_ring_ref;
+    napi_threadsafe_function on_message_ring_ready;
+
+    /*
+     * Request-response correlation, enabled from node at most once.  Publishes on a response filter are matched
+     * against outstanding requests on the event loop thread and never reach the general message path.  The router
+     * and threadsafe function are set before the enabled flag and live as long as the binding.
+     */
+    struct aws_atomic_var is_response_routing_enabled;
+    struct aws_mutex response_router_lock;
+    struct aws_napi_mqtt5_response_router *response_router;
+    napi_threadsafe_function on_response_received;
+
+    /*
+     * Optional filtering and sampling of received publishes, evaluated on the event loop thread before anything is
+     * copied for node.  The filter may be replaced or removed from node at any time; the enabled flag is set while
+     * one is installed and only gates the lock.  The drop counters are reported from the first time a filter is
+     * installed, which is only tracked on node's thread.
+     */
+    struct aws_atomic_var is_message_filter_enabled;
+    struct aws_mutex message_filter_lock;
+    struct aws_napi_mqtt_message_filter *message_filter;
+    struct aws_napi_mqtt_message_filter_statistics message_filter_statistics;
+    bool has_message_filter_statistics;
+
+    /*
+     * Optional native cache of the latest payload per topic, updated on the event loop thread and queried from node.
+     * The enabled flag is set while a cache is installed, and its statistics are only reported while it is.
+     */
+    struct aws_atomic_var is_last_value_cache_enabled;
+    struct aws_mutex last_value_cache_lock;
+    struct aws_napi_mqtt_last_value_cache *last_value_cache;
+
+    /* Optional counters written into memory shared with node, bound from node at most once */
+    struct aws_napi_live_statistics live_statistics;
+
+    /* Optional; strings for recently received topics.  Only touched from node's thread, and gone once closed. */
+    struct aws_napi_mqtt_topic_intern_cache *topic_intern_cache;
+
+    /*
+     * Encoding space for string payloads of prepared publishes, reused so that steady-state publishing does not
+     * allocate.  Only touched from node's thread, and only for the duration of a publish call.
+     */
+    struct aws_byte_buf publish_payload_scratch;
 };
 
 static void s_aws_mqtt5_client_binding_destroy(struct aws_mqtt5_client_binding *binding) {
@@ -155,6 +512,57 @@ static void s_aws_mqtt5_client_binding_destroy(struct aws_mqtt5_client_binding *
     AWS_CLEAN_THREADSAFE_FUNCTION(binding, on_disconnection);
     AWS_CLEAN_THREADSAFE_FUNCTION(binding, on_message_received);
     AWS_CLEAN_THREADSAFE_FUNCTION(binding, transform_websocket);
+    AWS_CLEAN_THREADSAFE_FUNCTION(binding, on_message_ring_ready);
+    AWS_CLEAN_THREADSAFE_FUNCTION(binding, on_response_received);
+
+    aws_napi_websocket_signer_release(binding->websocket_signer);
+
+    if (aws_array_list_is_valid(&binding->delivery_lanes.rules)) {
+        size_t rule_count = aws_array_list_length(&binding->delivery_lanes.rules);
+        for (size_t i = 0; i < rule_count; ++i) {
+            struct aws_napi_mqtt5_delivery_priority_rule *rule = NULL;
+            aws_array_list_get_at_ptr(&binding->delivery_lanes.rules, (void **)&rule, i);
+            aws_byte_buf_clean_up(&rule->topic_filter);
+        }
+        aws_array_list_clean_up(&binding->delivery_lanes.rules);
+    }
+    aws_mutex_clean_up(&binding->delivery_lanes.lock);
+
+    if (aws_array_list_is_valid(&binding->json_payload_topic_filters)) {
+        size_t filter_count = aws_array_list_length(&binding->json_payload_topic_filters);
+        for (size_t i = 0; i < filter_count; ++i) {
+            struct aws_byte_buf *topic_filter = NULL;
+            aws_array_list_get_at_ptr(&binding->json_payload_topic_filters, (void **)&topic_filter, i);
+            aws_byte_buf_clean_up(topic_filter);
+        }
+        aws_array_list_clean_up(&binding->json_payload_topic_filters);
+    }
+
+    aws_napi_mqtt5_persistent_queue_destroy(binding->persistent_queue);
+
+    AWS_FATAL_ASSERT(aws_linked_list_empty(&binding->offline_queue.held_publishes));
+    aws_priority_queue_clean_up(&binding->offline_queue.eviction_order);
+    aws_mutex_clean_up(&binding->offline_queue.lock);
+
+    for (size_t i = 0; i < AWS_NAPI_MQTT5_PUBLISH_PRIORITY_COUNT; ++i) {
+        AWS_FATAL_ASSERT(aws_linked_list_empty(&binding->outbound_scheduler.classes[i].queued_publishes));
+    }
+    aws_mutex_clean_up(&binding->outbound_scheduler.lock);
+
+    aws_mutex_clean_up(&binding->message_ring_lock);
+
+    aws_napi_mqtt5_response_router_destroy(binding->response_router);
+    aws_mutex_clean_up(&binding->response_router_lock);
+
+    aws_napi_mqtt_message_filter_destroy(binding->message_filter);
+    aws_mutex_clean_up(&binding->message_filter_lock);
+
+    aws_napi_mqtt_last_value_cache_destroy(binding->last_value_cache);
+    aws_mutex_clean_up(&binding->last_value_cache_lock);
+
+    aws_napi_live_statistics_clean_up(&binding->live_statistics);
+
+    aws_byte_buf_clean_up(&binding->publish_payload_scratch);
 
     aws_mem_release(binding->allocator, binding);
 }
@@ -186,6 +594,110 @@ static void s_aws_mqtt5_client_binding_on_client_terminate(void *user_data) {
     s_aws_mqtt5_client_binding_release(binding);
 }
 
+static bool s_inbound_flow_control_is_limited(const struct aws_napi_mqtt5_inbound_flow_control *flow_control) {
+    return flow_control->max_pending_message_count > 0 || flow_control->max_pending_message_size > 0;
+}
+
+static bool s_inbound_flow_control_has_capacity(
+    struct aws_napi_mqtt5_inbound_flow_control *flow_control,
+    uint64_t message_size) {
+
+    if (flow_control->max_pending_message_count > 0 &&
+        aws_atomic_load_int(&flow_control->pending_message_count) >= flow_control->max_pending_message_count) {
+        return false;
+    }
+
+    /* a single message larger than the byte limit is still let through once everything ahead of it has drained */
+    uint64_t pending_message_size = aws_atomic_load_int(&flow_control->pending_message_size);
+    if (flow_control->max_pending_message_size > 0 && pending_message_size > 0 &&
+        pending_message_size + message_size > flow_control->max_pending_message_size) {
+        return false;
+    }
+
+    return true;
+}
+
+/*
+ * Invoked from the client's event loop thread before an incoming message is copied.  Accounts for the message and
+ * returns true if it should be delivered, or counts it as dropped and returns false.  Never blocks.
+ */
+static bool s_inbound_flow_control_acquire(
+    struct aws_mqtt5_client_binding *binding,
+    enum aws_mqtt5_qos qos,
+    uint64_t message_size) {
+
+    struct aws_napi_mqtt5_inbound_flow_control *flow_control = &binding->inbound_flow_control;
+
+    if (qos == AWS_MQTT5_QOS_AT_MOST_ONCE && s_inbound_flow_control_is_limited(flow_control)) {
+        if (!s_inbound_flow_control_has_capacity(flow_control, message_size)) {
+            aws_atomic_fetch_add(&flow_control->dropped_message_count, 1);
+
+            if (!flow_control->is_dropping) {
+                flow_control->is_dropping = true;
+                AWS_LOGF_WARN(
+                    AWS_LS_NODEJS_CRT_GENERAL,
+                    "id=%p s_inbound_flow_control_acquire - inbound flow control limits reached, dropping QoS 0 "
+                    "publishes until node catches up",
+                    (void *)binding->client);
+            }
+            return false;
+        }
+
+        if (flow_control->is_dropping) {
+            flow_control->is_dropping = false;
+            AWS_LOGF_INFO(
+                AWS_LS_NODEJS_CRT_GENERAL,
+                "id=%p s_inbound_flow_control_acquire - inbound flow control has capacity again, %" PRIu64
+                " QoS 0 publishes dropped so far",
+                (void *)binding->client,
+                (uint64_t)aws_atomic_load_int(&flow_control->dropped_message_count));
+        }
+    }
+
+    aws_atomic_fetch_add(&flow_control->pending_message_count, 1);
+    aws_atomic_fetch_add(&flow_control->pending_message_size, (size_t)message_size);
+
+    return true;
+}
+
+/* Invoked once a message has been handed to node (or dropped) */
+static void s_inbound_flow_control_release(struct aws_mqtt5_client_binding *binding, uint64_t message_size) {
+    struct aws_napi_mqtt5_inbound_flow_control *flow_control = &binding->inbound_flow_control;
+
+    AWS_FATAL_ASSERT(aws_atomic_load_int(&flow_control->pending_message_count) > 0);
+    AWS_FATAL_ASSERT(aws_atomic_load_int(&flow_control->pending_message_size) >= message_size);
+    aws_atomic_fetch_sub(&flow_control->pending_message_count, 1);
+    aws_atomic_fetch_sub(&flow_control->pending_message_size, (size_t)message_size);
+}
+
+static void s_offline_queue_close(struct aws_mqtt5_client_binding *binding);
+static void s_outbound_scheduler_close(struct aws_mqtt5_client_binding *binding);
+
+static void s_message_ring_close(struct aws_mqtt5_client_binding *binding, napi_env env) {
+    aws_mutex_lock(&binding->message_ring_lock);
+    binding->is_message_ring_closed = true;
+    aws_mutex_unlock(&binding->message_ring_lock);
+
+    /* no producer can touch the shared memory any longer, so it's safe to let it be collected */
+    napi_ref message_ring_ref = binding->message_ring_ref;
+    binding->message_ring_ref = NULL;
+
+    if (message_ring_ref != NULL) {
+        napi_delete_reference(env, message_ring_ref);
+    }
+}
+
+static void s_publish_record_buffer_release(struct aws_mqtt5_client_binding *binding, napi_env env) {
+    napi_ref buffer_ref = binding->publish_record_buffer_ref;
+    binding->publish_record_buffer_ref = NULL;
+    binding->publish_record_buffer = NULL;
+    binding->publish_record_buffer_capacity = 0;
+
+    if (buffer_ref != NULL) {
+        napi_delete_reference(env, buffer_ref);
+    }
+}
+
 /*
  * Invoked when the node mqtt5 client is garbage collected or if fails construction partway through
  */
@@ -200,6 +712,14 @@ static void s_aws_mqtt5_client_extern_finalize(napi_env env, void *finalize_data
         "id=%p s_aws_mqtt5_client_extern_finalize - mqtt5_client node wrapper is being finalized",
         (void *)binding->client);
 
+    s_outbound_scheduler_close(binding);
+    s_offline_queue_close(binding);
+    s_publish_record_buffer_release(binding, env);
+    s_message_ring_close(binding, env);
+    aws_napi_live_statistics_unbind_napi(&binding->live_statistics, env);
+    aws_napi_mqtt_topic_intern_cache_destroy(binding->topic_intern_cache);
+    binding->topic_intern_cache = NULL;
+
     if (binding->client != NULL) {
         /* if client is not null, then this is a successfully constructed client which should shutdown normally */
         aws_mqtt5_client_release(binding->client);
@@ -220,13 +740,40 @@ struct on_message_received_user_data {
 
     struct aws_byte_buf *payload;
     struct aws_byte_buf *correlation_data;
+
+    /* amount charged against the binding's inbound flow control for this message */
+    uint64_t flow_control_size;
+    bool is_flow_control_released;
+
+    /* set once a lazy publish packet wraps this user data; it is then destroyed when that object is collected */
+    bool is_owned_by_packet;
+
+    /* delivery lane membership, only used when delivery priorities are configured */
+    struct aws_linked_list_node lane_node;
+    uint32_t priority;
+    uint64_t enqueue_ns;
+
+    /* set when the payload was parsed as JSON: either the tape, or why parsing failed */
+    struct aws_byte_buf *json_tape;
+    bool has_json_error;
+    struct aws_napi_json_tape_error json_error;
 };
 
+/* Messages count against inbound flow control until delivered, not until their native storage is released */
+static void s_on_message_received_user_data_release_flow_control(struct on_message_received_user_data *user_data) {
+    if (user_data->binding != NULL && !user_data->is_flow_control_released) {
+        s_inbound_flow_control_release(user_data->binding, user_data->flow_control_size);
+        user_data->is_flow_control_released = true;
+    }
+}
+
 static void s_on_message_received_user_data_destroy(struct on_message_received_user_data *user_data) {
     if (user_data == NULL) {
         return;
     }
 
+    s_on_message_received_user_data_release_flow_control(user_data);
+
     user_data->binding = s_aws_mqtt5_client_binding_release(user_data->binding);
     aws_mqtt5_packet_publish_storage_clean_up(&user_data->publish_storage);
 
@@ -240,12 +787,60 @@ static void s_on_message_received_user_data_destroy(struct on_message_received_u
         aws_mem_release(user_data->allocator, user_data->correlation_data);
     }
 
+    if (user_data->json_tape != NULL) {
+        aws_byte_buf_clean_up(user_data->json_tape);
+        aws_mem_release(user_data->allocator, user_data->json_tape);
+    }
+
     aws_mem_release(user_data->allocator, user_data);
 }
 
+static bool s_should_parse_json_payload(
+    const struct aws_mqtt5_client_binding *binding,
+    struct aws_byte_cursor topic) {
+
+    /* only initialized when JSON payload options are configured */
+    if (!aws_array_list_is_valid(&binding->json_payload_topic_filters)) {
+        return false;
+    }
+
+    size_t filter_count = aws_array_list_length(&binding->json_payload_topic_filters);
+    for (size_t i = 0; i < filter_count; ++i) {
+        struct aws_byte_buf *topic_filter = NULL;
+        aws_array_list_get_at_ptr(&binding->json_payload_topic_filters, (void **)&topic_filter, i);
+
+        if (aws_napi_mqtt_topic_matches_filter(topic, aws_byte_cursor_from_buf(topic_filter))) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/*
+ * Runs on the event loop thread so that node only has to materialize values from the tape.  Failing to allocate
+ * the tape is not fatal; the message is then delivered without a JSON result.
+ */
+static void s_parse_json_payload(struct on_message_received_user_data *user_data, struct aws_byte_cursor payload) {
+    struct aws_byte_buf *tape = aws_mem_calloc(user_data->allocator, 1, sizeof(struct aws_byte_buf));
+
+    /* the tape is usually no larger than the text, so this avoids most regrowth */
+    if (aws_byte_buf_init(tape, user_data->allocator, payload.len + 16) == AWS_OP_SUCCESS &&
+        aws_napi_json_tape_build(payload, tape, &user_data->json_error) == AWS_OP_SUCCESS) {
+        user_data->json_tape = tape;
+        return;
+    }
+
+    user_data->has_json_error = user_data->json_error.message != NULL;
+
+    aws_byte_buf_clean_up(tape);
+    aws_mem_release(user_data->allocator, tape);
+}
+
 static struct on_message_received_user_data *s_on_message_received_user_data_new(
     struct aws_mqtt5_client_binding *binding,
-    const struct aws_mqtt5_packet_publish_view *publish_packet) {
+    const struct aws_mqtt5_packet_publish_view *publish_packet,
+    uint64_t flow_control_size) {
 
     struct on_message_received_user_data *user_data =
         aws_mem_calloc(binding->allocator, 1, sizeof(struct on_message_received_user_data));
@@ -264,6 +859,10 @@ static struct on_message_received_user_data *s_on_message_received_user_data_new
     }
     AWS_ZERO_STRUCT(publish_copy.payload);
 
+    if (s_should_parse_json_payload(binding, publish_packet->topic)) {
+        s_parse_json_payload(user_data, publish_packet->payload);
+    }
+
     if (publish_copy.correlation_data != NULL) {
         user_data->correlation_data = aws_mem_calloc(binding->allocator, 1, sizeof(struct aws_byte_buf));
         if (aws_byte_buf_init_copy_from_cursor(
@@ -281,6 +880,7 @@ static struct on_message_received_user_data *s_on_message_received_user_data_new
         goto error;
     }
     user_data->binding = s_aws_mqtt5_client_binding_acquire(binding);
+    user_data->flow_control_size = flow_control_size;
 
     return user_data;
 
@@ -291,85 +891,267 @@ error:
     return NULL;
 }
 
-static void s_on_publish_received(const struct aws_mqtt5_packet_publish_view *publish_packet, void *user_data) {
-    struct aws_mqtt5_client_binding *binding = user_data;
+static uint32_t s_compute_delivery_priority(
+    const struct aws_napi_mqtt5_delivery_lanes *delivery_lanes,
+    struct aws_byte_cursor topic) {
 
-    if (!binding->on_message_received) {
-        return;
-    }
+    size_t rule_count = aws_array_list_length(&delivery_lanes->rules);
+    for (size_t i = 0; i < rule_count; ++i) {
+        struct aws_napi_mqtt5_delivery_priority_rule *rule = NULL;
+        aws_array_list_get_at_ptr(&delivery_lanes->rules, (void **)&rule, i);
 
-    struct on_message_received_user_data *message_received_ud =
-        s_on_message_received_user_data_new(binding, publish_packet);
-    if (message_received_ud == NULL) {
-        return;
+        if (aws_napi_mqtt_topic_matches_filter(topic, aws_byte_cursor_from_buf(&rule->topic_filter))) {
+            return rule->priority;
+        }
     }
 
-    /* queue a callback in node's libuv thread */
-    AWS_NAPI_ENSURE(NULL, aws_napi_queue_threadsafe_function(binding->on_message_received, message_received_ud));
+    return 0;
 }
 
-struct on_simple_event_user_data {
-    struct aws_allocator *allocator;
-    struct aws_mqtt5_client_binding *binding;
-};
+/* Invoked from the event loop thread just before a message is queued on the message received threadsafe function */
+static void s_delivery_lanes_push(
+    struct aws_mqtt5_client_binding *binding,
+    struct on_message_received_user_data *user_data,
+    struct aws_byte_cursor topic) {
 
-static void s_on_simple_event_user_data_destroy(struct on_simple_event_user_data *user_data) {
-    if (user_data == NULL) {
+    struct aws_napi_mqtt5_delivery_lanes *delivery_lanes = &binding->delivery_lanes;
+    if (!delivery_lanes->is_enabled) {
         return;
     }
 
-    user_data->binding = s_aws_mqtt5_client_binding_release(user_data->binding);
+    user_data->priority = s_compute_delivery_priority(delivery_lanes, topic);
+    aws_high_res_clock_get_ticks(&user_data->enqueue_ns);
 
-    aws_mem_release(user_data->allocator, user_data);
+    aws_mutex_lock(&delivery_lanes->lock);
+    struct aws_napi_mqtt5_delivery_lane *lane = &delivery_lanes->lanes[user_data->priority];
+    aws_linked_list_push_back(&lane->pending, &user_data->lane_node);
+    ++lane->pending_count;
+    aws_mutex_unlock(&delivery_lanes->lock);
 }
 
-static struct on_simple_event_user_data *s_on_simple_event_user_data_new(struct aws_mqtt5_client_binding *binding) {
+/*
+ * Invoked from the libuv thread with the user data a threadsafe function call was queued with.  Returns the message
+ * that call should deliver instead: the oldest message in the highest-priority non-empty lane.
+ */
+static struct on_message_received_user_data *s_delivery_lanes_pop(struct on_message_received_user_data *user_data) {
+    struct aws_napi_mqtt5_delivery_lanes *delivery_lanes = &user_data->binding->delivery_lanes;
+    if (!delivery_lanes->is_enabled) {
+        return user_data;
+    }
 
-    struct on_simple_event_user_data *user_data =
-        aws_mem_calloc(binding->allocator, 1, sizeof(struct on_simple_event_user_data));
-    user_data->allocator = binding->allocator;
-    user_data->binding = s_aws_mqtt5_client_binding_acquire(binding);
+    uint64_t now_ns = 0;
+    aws_high_res_clock_get_ticks(&now_ns);
 
-    return user_data;
-}
+    struct on_message_received_user_data *next = NULL;
 
-static void s_on_stopped(struct aws_mqtt5_client_binding *binding) {
-    if (!binding->on_stopped) {
-        return;
-    }
+    aws_mutex_lock(&delivery_lanes->lock);
+    for (size_t i = AWS_NAPI_MQTT5_DELIVERY_PRIORITY_COUNT; i > 0; --i) {
+        struct aws_napi_mqtt5_delivery_lane *lane = &delivery_lanes->lanes[i - 1];
+        if (aws_linked_list_empty(&lane->pending)) {
+            continue;
+        }
 
-    /* queue a callback in node's libuv thread */
-    AWS_NAPI_ENSURE(
-        NULL, aws_napi_queue_threadsafe_function(binding->on_stopped, s_on_simple_event_user_data_new(binding)));
-}
+        struct aws_linked_list_node *node = aws_linked_list_pop_front(&lane->pending);
+        next = AWS_CONTAINER_OF(node, struct on_message_received_user_data, lane_node);
 
-static void s_on_attempting_connect(struct aws_mqtt5_client_binding *binding) {
-    if (!binding->on_attempting_connect) {
-        return;
+        uint64_t queueing_delay_ns = now_ns > next->enqueue_ns ? now_ns - next->enqueue_ns : 0;
+        --lane->pending_count;
+        ++lane->delivered_count;
+        lane->total_queueing_delay_ns += queueing_delay_ns;
+        lane->max_queueing_delay_ns = aws_max_u64(lane->max_queueing_delay_ns, queueing_delay_ns);
+        break;
     }
+    aws_mutex_unlock(&delivery_lanes->lock);
 
-    /* queue a callback in node's libuv thread */
-    AWS_NAPI_ENSURE(
-        NULL,
-        aws_napi_queue_threadsafe_function(binding->on_attempting_connect, s_on_simple_event_user_data_new(binding)));
+    /* every call is preceded by a push, so at least the queued message itself is still pending */
+    AWS_FATAL_ASSERT(next != NULL);
+
+    return next;
 }
 
-/* unions callback data needed for connection succes and failure as a convenience */
-struct on_connection_result_user_data {
-    struct aws_allocator *allocator;
-    struct aws_mqtt5_client_binding *binding;
-    struct aws_mqtt5_packet_connack_storage connack_storage;
-    bool is_connack_valid;
-    int error_code;
-    struct aws_mqtt5_negotiated_settings settings;
-};
+static bool s_message_ring_append(
+    struct aws_mqtt5_client_binding *binding,
+    const struct aws_mqtt5_packet_publish_view *publish_view);
 
-static void s_on_connection_result_user_data_destroy(struct on_connection_result_user_data *connection_result_ud) {
-    if (connection_result_ud == NULL) {
-        return;
-    }
+static bool s_route_response(
+    struct aws_mqtt5_client_binding *binding,
+    const struct aws_mqtt5_packet_publish_view *publish_view);
 
-    connection_result_ud->binding = s_aws_mqtt5_client_binding_release(connection_result_ud->binding);
+/* Returns true if the installed message filter, if any, drops the publish */
+static bool s_filter_publish(
+    struct aws_mqtt5_client_binding *binding,
+    const struct aws_mqtt5_packet_publish_view *publish_view) {
+
+    if (aws_atomic_load_int(&binding->is_message_filter_enabled) == 0) {
+        return false;
+    }
+
+    uint64_t now_ns = 0;
+    aws_high_res_clock_get_ticks(&now_ns);
+
+    enum aws_napi_mqtt_message_filter_result result = AWS_NAPI_MQTT_MFR_DELIVER;
+
+    aws_mutex_lock(&binding->message_filter_lock);
+    if (binding->message_filter != NULL) {
+        result = aws_napi_mqtt_message_filter_evaluate(
+            binding->message_filter,
+            publish_view->topic,
+            publish_view->retain,
+            publish_view->user_properties,
+            publish_view->user_property_count,
+            now_ns);
+        aws_napi_mqtt_message_filter_statistics_record(&binding->message_filter_statistics, result);
+    }
+    aws_mutex_unlock(&binding->message_filter_lock);
+
+    return result != AWS_NAPI_MQTT_MFR_DELIVER;
+}
+
+/*
+ * Records the publish in the installed last value cache, if any, and its topic is cached.  Returns true if the
+ * publish should then not be delivered to node.
+ */
+static bool s_cache_last_value(
+    struct aws_mqtt5_client_binding *binding,
+    const struct aws_mqtt5_packet_publish_view *publish_view) {
+
+    if (aws_atomic_load_int(&binding->is_last_value_cache_enabled) == 0) {
+        return false;
+    }
+
+    uint64_t now_ns = 0;
+    aws_high_res_clock_get_ticks(&now_ns);
+
+    bool suppress_delivery = false;
+
+    aws_mutex_lock(&binding->last_value_cache_lock);
+    struct aws_napi_mqtt_last_value_cache *cache = binding->last_value_cache;
+    if (cache != NULL && aws_napi_mqtt_last_value_cache_matches(cache, publish_view->topic)) {
+        if (aws_napi_mqtt_last_value_cache_update(
+                cache, publish_view->topic, publish_view->payload, publish_view->retain, now_ns)) {
+            AWS_LOGF_ERROR(
+                AWS_LS_NODEJS_CRT_GENERAL,
+                "id=%p s_cache_last_value - failed to cache publish with error %d(%s)",
+                (void *)binding->client,
+                aws_last_error(),
+                aws_error_debug_str(aws_last_error()));
+        }
+        suppress_delivery = aws_napi_mqtt_last_value_cache_suppresses_delivery(cache);
+    }
+    aws_mutex_unlock(&binding->last_value_cache_lock);
+
+    return suppress_delivery;
+}
+
+static void s_on_publish_received(const struct aws_mqtt5_packet_publish_view *publish_packet, void *user_data) {
+    struct aws_mqtt5_client_binding *binding = user_data;
+
+    aws_napi_live_statistics_record_publish_received(&binding->live_statistics, publish_packet->payload.len);
+
+    if (s_route_response(binding, publish_packet)) {
+        return;
+    }
+
+    if (s_filter_publish(binding, publish_packet)) {
+        return;
+    }
+
+    if (s_cache_last_value(binding, publish_packet)) {
+        return;
+    }
+
+    if (!binding->on_message_received) {
+        return;
+    }
+
+    if (binding->is_message_ring_enabled && s_message_ring_append(binding, publish_packet)) {
+        return;
+    }
+
+    uint64_t flow_control_size = (uint64_t)publish_packet->topic.len + (uint64_t)publish_packet->payload.len;
+    if (publish_packet->correlation_data != NULL) {
+        flow_control_size += publish_packet->correlation_data->len;
+    }
+
+    if (!s_inbound_flow_control_acquire(binding, publish_packet->qos, flow_control_size)) {
+        return;
+    }
+
+    struct on_message_received_user_data *message_received_ud =
+        s_on_message_received_user_data_new(binding, publish_packet, flow_control_size);
+    if (message_received_ud == NULL) {
+        s_inbound_flow_control_release(binding, flow_control_size);
+        return;
+    }
+
+    s_delivery_lanes_push(binding, message_received_ud, publish_packet->topic);
+
+    /* queue a callback in node's libuv thread */
+    AWS_NAPI_ENSURE(NULL, aws_napi_queue_threadsafe_function(binding->on_message_received, message_received_ud));
+}
+
+struct on_simple_event_user_data {
+    struct aws_allocator *allocator;
+    struct aws_mqtt5_client_binding *binding;
+};
+
+static void s_on_simple_event_user_data_destroy(struct on_simple_event_user_data *user_data) {
+    if (user_data == NULL) {
+        return;
+    }
+
+    user_data->binding = s_aws_mqtt5_client_binding_release(user_data->binding);
+
+    aws_mem_release(user_data->allocator, user_data);
+}
+
+static struct on_simple_event_user_data *s_on_simple_event_user_data_new(struct aws_mqtt5_client_binding *binding) {
+
+    struct on_simple_event_user_data *user_data =
+        aws_mem_calloc(binding->allocator, 1, sizeof(struct on_simple_event_user_data));
+    user_data->allocator = binding->allocator;
+    user_data->binding = s_aws_mqtt5_client_binding_acquire(binding);
+
+    return user_data;
+}
+
+static void s_on_stopped(struct aws_mqtt5_client_binding *binding) {
+    if (!binding->on_stopped) {
+        return;
+    }
+
+    /* queue a callback in node's libuv thread */
+    AWS_NAPI_ENSURE(
+        NULL, aws_napi_queue_threadsafe_function(binding->on_stopped, s_on_simple_event_user_data_new(binding)));
+}
+
+static void s_on_attempting_connect(struct aws_mqtt5_client_binding *binding) {
+    if (!binding->on_attempting_connect) {
+        return;
+    }
+
+    /* queue a callback in node's libuv thread */
+    AWS_NAPI_ENSURE(
+        NULL,
+        aws_napi_queue_threadsafe_function(binding->on_attempting_connect, s_on_simple_event_user_data_new(binding)));
+}
+
+/* unions callback data needed for connection succes and failure as a convenience */
+struct on_connection_result_user_data {
+    struct aws_allocator *allocator;
+    struct aws_mqtt5_client_binding *binding;
+    struct aws_mqtt5_packet_connack_storage connack_storage;
+    bool is_connack_valid;
+    int error_code;
+    struct aws_mqtt5_negotiated_settings settings;
+};
+
+static void s_on_connection_result_user_data_destroy(struct on_connection_result_user_data *connection_result_ud) {
+    if (connection_result_ud == NULL) {
+        return;
+    }
+
+    connection_result_ud->binding = s_aws_mqtt5_client_binding_release(connection_result_ud->binding);
 
     aws_mqtt5_packet_connack_storage_clean_up(&connection_result_ud->connack_storage);
     aws_mqtt5_negotiated_settings_clean_up(&connection_result_ud->settings);
@@ -516,9 +1298,82 @@ static void s_on_disconnection(
     AWS_NAPI_ENSURE(NULL, aws_napi_queue_threadsafe_function(binding->on_disconnection, disconnection_ud));
 }
 
+static void s_offline_queue_set_connected(struct aws_mqtt5_client_binding *binding, bool is_connected);
+
+/*
+ * Only ever called by live statistics while they are bound, and they are unbound before the client is released, so
+ * the client pointer cannot be cleared underneath this even when it runs on the event loop thread.
+ */
+static void s_get_live_operation_statistics(
+    void *user_data,
+    struct aws_napi_live_operation_statistics *operation_statistics) {
+
+    struct aws_mqtt5_client_binding *binding = user_data;
+    if (binding->client == NULL) {
+        return;
+    }
+
+    struct aws_mqtt5_client_operation_statistics stats;
+    AWS_ZERO_STRUCT(stats);
+    aws_mqtt5_client_get_stats(binding->client, &stats);
+
+    operation_statistics->incomplete_operation_count = stats.incomplete_operation_count;
+    operation_statistics->incomplete_operation_size = stats.incomplete_operation_size;
+    operation_statistics->unacked_operation_count = stats.unacked_operation_count;
+    operation_statistics->unacked_operation_size = stats.unacked_operation_size;
+}
+
+/* Called whenever what the client has in flight may have changed: operations submitted or completed, and lifecycle */
+static void s_refresh_live_operation_statistics(struct aws_mqtt5_client_binding *binding) {
+    aws_napi_live_statistics_refresh_operation_statistics(
+        &binding->live_statistics, s_get_live_operation_statistics, binding);
+}
+
+static void s_update_live_statistics_on_lifecycle_event(
+    struct aws_mqtt5_client_binding *binding,
+    enum aws_mqtt5_client_lifecycle_event_type event_type) {
+
+    struct aws_napi_live_statistics *live_statistics = &binding->live_statistics;
+
+    switch (event_type) {
+        case AWS_MQTT5_CLET_CONNECTION_SUCCESS:
+            aws_napi_live_statistics_record_connection_success(live_statistics);
+            break;
+
+        case AWS_MQTT5_CLET_CONNECTION_FAILURE:
+            aws_napi_live_statistics_add(live_statistics, AWS_NAPI_LIVE_STAT_CONNECTION_FAILURES, 1);
+            break;
+
+        case AWS_MQTT5_CLET_DISCONNECTION:
+            aws_napi_live_statistics_add(live_statistics, AWS_NAPI_LIVE_STAT_CONNECTION_DROPS, 1);
+            break;
+
+        default:
+            return;
+    }
+
+    s_refresh_live_operation_statistics(binding);
+}
+
 static void s_lifecycle_event_callback(const struct aws_mqtt5_client_lifecycle_event *event) {
     struct aws_mqtt5_client_binding *binding = event->user_data;
 
+    s_update_live_statistics_on_lifecycle_event(binding, event->event_type);
+
+    switch (event->event_type) {
+        case AWS_MQTT5_CLET_CONNECTION_SUCCESS:
+            s_offline_queue_set_connected(binding, true);
+            break;
+
+        case AWS_MQTT5_CLET_DISCONNECTION:
+        case AWS_MQTT5_CLET_STOPPED:
+            s_offline_queue_set_connected(binding, false);
+            break;
+
+        default:
+            break;
+    }
+
     switch (event->event_type) {
         case AWS_MQTT5_CLET_STOPPED:
             s_on_stopped(binding);
@@ -1069,2533 +1924,5700 @@ done:
     s_on_disconnection_user_data_destroy(disconnection_ud);
 }
 
-static int s_create_napi_publish_packet(
-    napi_env env,
-    struct on_message_received_user_data *message_received_ud,
-    napi_value *packet_out) {
-
-    if (env == NULL) {
-        return aws_raise_error(AWS_CRT_NODEJS_ERROR_THREADSAFE_FUNCTION_NULL_NAPI_ENV);
-    }
+static bool s_should_deliver_payload_as_string(
+    const struct aws_mqtt5_client_binding *binding,
+    const struct aws_mqtt5_packet_publish_view *publish_view) {
 
-    const struct aws_mqtt5_packet_publish_view *publish_view = &message_received_ud->publish_storage.storage_view;
+    switch (binding->utf8_payload_delivery) {
+        case AWS_NAPI_MQTT5_UPD_ALWAYS_STRING:
+            return true;
 
-    napi_value packet = NULL;
-    AWS_NAPI_CALL(
-        env, napi_create_object(env, &packet), { return aws_raise_error(AWS_CRT_NODEJS_ERROR_NAPI_FAILURE); });
+        case AWS_NAPI_MQTT5_UPD_STRING_IF_UTF8_INDICATED:
+            return publish_view->payload_format != NULL &&
+                   *publish_view->payload_format == AWS_MQTT5_PFI_UTF8;
 
-    if (aws_napi_attach_object_property_u32(packet, env, AWS_NAPI_KEY_TYPE, (uint32_t)AWS_MQTT5_PT_PUBLISH)) {
-        return AWS_OP_ERR;
+        default:
+            return false;
     }
+}
 
-    if (aws_napi_attach_object_property_string(packet, env, AWS_NAPI_KEY_TOPIC_NAME, publish_view->topic)) {
-        return AWS_OP_ERR;
-    }
+/* PUBLISH fields that are only converted to js values on access when lazy publish properties are enabled */
+enum aws_napi_mqtt5_publish_secondary_field {
+    AWS_NAPI_MQTT5_PSF_PAYLOAD_FORMAT,
+    AWS_NAPI_MQTT5_PSF_MESSAGE_EXPIRY_INTERVAL_SECONDS,
+    AWS_NAPI_MQTT5_PSF_TOPIC_ALIAS,
+    AWS_NAPI_MQTT5_PSF_RESPONSE_TOPIC,
+    AWS_NAPI_MQTT5_PSF_CORRELATION_DATA,
+    AWS_NAPI_MQTT5_PSF_SUBSCRIPTION_IDENTIFIERS,
+    AWS_NAPI_MQTT5_PSF_CONTENT_TYPE,
+    AWS_NAPI_MQTT5_PSF_USER_PROPERTIES,
+    AWS_NAPI_MQTT5_PSF_COUNT,
+};
 
-    if (aws_napi_attach_object_property_binary_as_finalizable_external(
-            packet, env, AWS_NAPI_KEY_PAYLOAD, message_received_ud->payload)) {
-        return AWS_OP_ERR;
+static const char *s_get_publish_secondary_field_key(enum aws_napi_mqtt5_publish_secondary_field field) {
+    switch (field) {
+        case AWS_NAPI_MQTT5_PSF_PAYLOAD_FORMAT:
+            return AWS_NAPI_KEY_PAYLOAD_FORMAT;
+        case AWS_NAPI_MQTT5_PSF_MESSAGE_EXPIRY_INTERVAL_SECONDS:
+            return AWS_NAPI_KEY_MESSAGE_EXPIRY_INTERVAL_SECONDS;
+        case AWS_NAPI_MQTT5_PSF_TOPIC_ALIAS:
+            return AWS_NAPI_KEY_TOPIC_ALIAS;
+        case AWS_NAPI_MQTT5_PSF_RESPONSE_TOPIC:
+            return AWS_NAPI_KEY_RESPONSE_TOPIC;
+        case AWS_NAPI_MQTT5_PSF_CORRELATION_DATA:
+            return AWS_NAPI_KEY_CORRELATION_DATA;
+        case AWS_NAPI_MQTT5_PSF_SUBSCRIPTION_IDENTIFIERS:
+            return AWS_NAPI_KEY_SUSBCRIPTION_IDENTIFIERS;
+        case AWS_NAPI_MQTT5_PSF_CONTENT_TYPE:
+            return AWS_NAPI_KEY_CONTENT_TYPE;
+        case AWS_NAPI_MQTT5_PSF_USER_PROPERTIES:
+            return AWS_NAPI_KEY_USER_PROPERTIES;
+        default:
+            return NULL;
     }
-    message_received_ud->payload = NULL;
+}
 
-    if (aws_napi_attach_object_property_u32(packet, env, AWS_NAPI_KEY_QOS, (uint32_t)publish_view->qos)) {
-        return AWS_OP_ERR;
-    }
+/*
+ * Attaches a single secondary field to a js object.  When eagerly building a packet, correlation data ownership
+ * moves to the js ArrayBuffer; lazy getters may run many times and so copy it instead.
+ */
+static int s_attach_publish_secondary_field(
+    napi_value packet,
+    napi_env env,
+    struct on_message_received_user_data *message_received_ud,
+    enum aws_napi_mqtt5_publish_secondary_field field,
+    bool copy_binary) {
 
-    if (aws_napi_attach_object_property_boolean(packet, env, AWS_NAPI_KEY_RETAIN, publish_view->retain)) {
-        return AWS_OP_ERR;
-    }
+    const struct aws_mqtt5_packet_publish_view *publish_view = &message_received_ud->publish_storage.storage_view;
 
-    if (publish_view->payload_format != NULL) {
-        if (aws_napi_attach_object_property_u32(
-                packet, env, AWS_NAPI_KEY_PAYLOAD_FORMAT, (uint32_t)(*publish_view->payload_format))) {
-            return AWS_OP_ERR;
-        }
-    }
+    switch (field) {
+        case AWS_NAPI_MQTT5_PSF_PAYLOAD_FORMAT:
+            if (publish_view->payload_format != NULL) {
+                return aws_napi_attach_object_property_u32(
+                    packet, env, AWS_NAPI_KEY_PAYLOAD_FORMAT, (uint32_t)(*publish_view->payload_format));
+            }
+            return AWS_OP_SUCCESS;
 
-    if (aws_napi_attach_object_property_optional_u32(
-            packet, env, AWS_NAPI_KEY_MESSAGE_EXPIRY_INTERVAL_SECONDS, publish_view->message_expiry_interval_seconds)) {
-        return AWS_OP_ERR;
-    }
+        case AWS_NAPI_MQTT5_PSF_MESSAGE_EXPIRY_INTERVAL_SECONDS:
+            return aws_napi_attach_object_property_optional_u32(
+                packet,
+                env,
+                AWS_NAPI_KEY_MESSAGE_EXPIRY_INTERVAL_SECONDS,
+                publish_view->message_expiry_interval_seconds);
 
-    if (aws_napi_attach_object_property_optional_u16(
-            packet, env, AWS_NAPI_KEY_TOPIC_ALIAS, publish_view->topic_alias)) {
-        return AWS_OP_ERR;
-    }
+        case AWS_NAPI_MQTT5_PSF_TOPIC_ALIAS:
+            return aws_napi_attach_object_property_optional_u16(
+                packet, env, AWS_NAPI_KEY_TOPIC_ALIAS, publish_view->topic_alias);
 
-    if (aws_napi_attach_object_property_optional_string(
-            packet, env, AWS_NAPI_KEY_RESPONSE_TOPIC, publish_view->response_topic)) {
-        return AWS_OP_ERR;
-    }
+        case AWS_NAPI_MQTT5_PSF_RESPONSE_TOPIC:
+            return aws_napi_attach_object_property_optional_string(
+                packet, env, AWS_NAPI_KEY_RESPONSE_TOPIC, publish_view->response_topic);
 
-    if (message_received_ud->correlation_data != NULL) {
-        if (aws_napi_attach_object_property_binary_as_finalizable_external(
-                packet, env, AWS_NAPI_KEY_CORRELATION_DATA, message_received_ud->correlation_data)) {
-            return AWS_OP_ERR;
-        }
-        message_received_ud->correlation_data = NULL;
-    }
+        case AWS_NAPI_MQTT5_PSF_CORRELATION_DATA: {
+            struct aws_byte_buf *correlation_data = message_received_ud->correlation_data;
+            if (correlation_data == NULL) {
+                return AWS_OP_SUCCESS;
+            }
 
-    if (publish_view->subscription_identifier_count > 0) {
-        napi_value subscription_identifier_array = NULL;
-        AWS_NAPI_CALL(
-            env,
-            napi_create_array_with_length(
-                env, publish_view->subscription_identifier_count, &subscription_identifier_array),
-            { return aws_raise_error(AWS_CRT_NODEJS_ERROR_NAPI_FAILURE); });
+            if (!copy_binary) {
+                if (aws_napi_attach_object_property_binary_as_finalizable_external(
+                        packet, env, AWS_NAPI_KEY_CORRELATION_DATA, correlation_data)) {
+                    return AWS_OP_ERR;
+                }
+                message_received_ud->correlation_data = NULL;
+                return AWS_OP_SUCCESS;
+            }
+
+            void *data = NULL;
+            napi_value array_buffer = NULL;
+            AWS_NAPI_CALL(env, napi_create_arraybuffer(env, correlation_data->len, &data, &array_buffer), {
+                return aws_raise_error(AWS_CRT_NODEJS_ERROR_NAPI_FAILURE);
+            });
 
-        for (size_t i = 0; i < publish_view->subscription_identifier_count; ++i) {
-            uint32_t subscription_identifier = publish_view->subscription_identifiers[i];
+            if (correlation_data->len > 0) {
+                memcpy(data, correlation_data->buffer, correlation_data->len);
+            }
 
-            napi_value napi_subscription_identifier = NULL;
-            AWS_NAPI_CALL(env, napi_create_uint32(env, subscription_identifier, &napi_subscription_identifier), {
+            AWS_NAPI_CALL(env, napi_set_named_property(env, packet, AWS_NAPI_KEY_CORRELATION_DATA, array_buffer), {
                 return aws_raise_error(AWS_CRT_NODEJS_ERROR_NAPI_FAILURE);
             });
 
-            AWS_NAPI_CALL(
-                env, napi_set_element(env, subscription_identifier_array, (uint32_t)i, napi_subscription_identifier), {
-                    return aws_raise_error(AWS_CRT_NODEJS_ERROR_NAPI_FAILURE);
-                });
+            return AWS_OP_SUCCESS;
         }
 
-        AWS_NAPI_CALL(
-            env,
-            napi_set_named_property(env, packet, AWS_NAPI_KEY_SUSBCRIPTION_IDENTIFIERS, subscription_identifier_array),
-            { return aws_raise_error(AWS_CRT_NODEJS_ERROR_NAPI_FAILURE); });
-    }
+        case AWS_NAPI_MQTT5_PSF_SUBSCRIPTION_IDENTIFIERS: {
+            if (publish_view->subscription_identifier_count == 0) {
+                return AWS_OP_SUCCESS;
+            }
 
-    if (aws_napi_attach_object_property_optional_string(
-            packet, env, AWS_NAPI_KEY_CONTENT_TYPE, publish_view->content_type)) {
-        return AWS_OP_ERR;
-    }
+            napi_value subscription_identifier_array = NULL;
+            AWS_NAPI_CALL(
+                env,
+                napi_create_array_with_length(
+                    env, publish_view->subscription_identifier_count, &subscription_identifier_array),
+                { return aws_raise_error(AWS_CRT_NODEJS_ERROR_NAPI_FAILURE); });
 
-    if (s_attach_object_property_user_properties(
-            packet, env, publish_view->user_property_count, publish_view->user_properties)) {
-        return AWS_OP_ERR;
-    }
+            for (size_t i = 0; i < publish_view->subscription_identifier_count; ++i) {
+                uint32_t subscription_identifier = publish_view->subscription_identifiers[i];
 
-    *packet_out = packet;
+                napi_value napi_subscription_identifier = NULL;
+                AWS_NAPI_CALL(env, napi_create_uint32(env, subscription_identifier, &napi_subscription_identifier), {
+                    return aws_raise_error(AWS_CRT_NODEJS_ERROR_NAPI_FAILURE);
+                });
 
-    return AWS_OP_SUCCESS;
-}
+                AWS_NAPI_CALL(
+                    env,
+                    napi_set_element(env, subscription_identifier_array, (uint32_t)i, napi_subscription_identifier),
+                    { return aws_raise_error(AWS_CRT_NODEJS_ERROR_NAPI_FAILURE); });
+            }
 
-/* in-node/libuv-thread function to trigger the emission of a PUBLISH packet on the messageReceived event */
-static void s_napi_on_message_received(napi_env env, napi_value function, void *context, void *user_data) {
-    (void)context;
-
-    struct on_message_received_user_data *on_message_received_ud = user_data;
-    struct aws_mqtt5_client_binding *binding = on_message_received_ud->binding;
-
-    if (env) {
-        napi_value params[2];
-        const size_t num_params = AWS_ARRAY_SIZE(params);
-
-        /*
-         * If we can't resolve the weak ref to the mqtt5 client, then it's been garbage collected and we should not
-         * do anything.
-         */
-        params[0] = NULL;
-        if (napi_get_reference_value(env, binding->node_mqtt5_client_ref, &params[0]) != napi_ok || params[0] == NULL) {
-            AWS_LOGF_INFO(
-                AWS_LS_NODEJS_CRT_GENERAL,
-                "id=%p s_napi_on_message_received - mqtt5_client node wrapper no longer resolvable",
-                (void *)binding->client);
-            goto done;
-        }
+            AWS_NAPI_CALL(
+                env,
+                napi_set_named_property(
+                    env, packet, AWS_NAPI_KEY_SUSBCRIPTION_IDENTIFIERS, subscription_identifier_array),
+                { return aws_raise_error(AWS_CRT_NODEJS_ERROR_NAPI_FAILURE); });
 
-        if (s_create_napi_publish_packet(env, on_message_received_ud, &params[1])) {
-            AWS_LOGF_ERROR(
-                AWS_LS_NODEJS_CRT_GENERAL,
-                "id=%p s_napi_on_message_received - failed to create publish object",
-                (void *)binding->client);
-            goto done;
+            return AWS_OP_SUCCESS;
         }
 
-        AWS_NAPI_ENSURE(
-            env,
-            aws_napi_dispatch_threadsafe_function(
-                env, binding->on_message_received, NULL, function, num_params, params));
-    }
+        case AWS_NAPI_MQTT5_PSF_CONTENT_TYPE:
+            return aws_napi_attach_object_property_optional_string(
+                packet, env, AWS_NAPI_KEY_CONTENT_TYPE, publish_view->content_type);
 
-done:
+        case AWS_NAPI_MQTT5_PSF_USER_PROPERTIES:
+            return s_attach_object_property_user_properties(
+                packet, env, publish_view->user_property_count, publish_view->user_properties);
 
-    s_on_message_received_user_data_destroy(on_message_received_ud);
+        default:
+            return aws_raise_error(AWS_ERROR_INVALID_ARGUMENT);
+    }
 }
 
 /*
- * Persistent storage for user properties.
+ * Lazy publish packets are instances of a native-backed class whose secondary fields are prototype accessors.  Each
+ * instance wraps the message's user data, which stays alive until the instance is garbage collected.  Accessors do
+ * not cache; node shadows them with own properties that keep the first value read (defineOwnLazyPublishProperties in
+ * lib/native/mqtt5.ts).
  */
-struct aws_napi_mqtt5_user_property_storage {
-    struct aws_array_list user_properties;
-    struct aws_byte_buf user_property_storage;
-};
+static struct aws_napi_class_info s_lazy_publish_packet_class_info;
 
-/* Extract a set of user properties from a Napi object. */
-static int s_aws_mqtt5_user_properties_extract_from_js_object(
-    struct aws_mqtt5_client_binding *binding,
-    struct aws_napi_mqtt5_user_property_storage *user_properties_storage,
-    napi_env env,
-    napi_value node_container,
-    size_t *user_property_count_out,
-    const struct aws_mqtt5_user_property **user_properties_out) {
+static napi_value s_lazy_publish_packet_constructor(napi_env env, const struct aws_napi_callback_info *cb_info) {
+    (void)env;
+    return cb_info->native_this;
+}
 
-    napi_value node_user_properties = NULL;
-    enum aws_napi_get_named_property_result gpr = aws_napi_get_named_property(
-        env, node_container, AWS_NAPI_KEY_USER_PROPERTIES, napi_object, &node_user_properties);
-    if (gpr != AWS_NGNPR_VALID_VALUE) {
-        return (gpr == AWS_NGNPR_NO_VALUE) ? AWS_OP_SUCCESS : AWS_OP_ERR;
-    }
+static void s_lazy_publish_packet_finalize(napi_env env, void *finalize_data, void *finalize_hint) {
+    (void)env;
+    (void)finalize_hint;
 
-    if (aws_napi_is_null_or_undefined(env, node_user_properties)) {
-        return AWS_OP_SUCCESS;
-    }
+    s_on_message_received_user_data_destroy(finalize_data);
+}
 
-    struct aws_allocator *allocator = aws_napi_get_allocator();
+static napi_value s_get_lazy_publish_packet_field(
+    napi_env env,
+    void *native_this,
+    enum aws_napi_mqtt5_publish_secondary_field field) {
 
-    /* len of js array */
-    uint32_t user_property_count = 0;
-    AWS_NAPI_CALL(env, napi_get_array_length(env, node_user_properties, &user_property_count), {
-        AWS_LOGF_ERROR(
-            AWS_LS_NODEJS_CRT_GENERAL,
-            "id=%p s_aws_mqtt5_user_properties_extract_from_js_object - user properties is not an array",
-            (void *)binding->client);
-        return aws_raise_error(AWS_ERROR_INVALID_ARGUMENT);
+    struct on_message_received_user_data *message_received_ud = native_this;
+
+    /* reuse the eager attach logic against a scratch object so both modes produce identical values */
+    napi_value scratch = NULL;
+    AWS_NAPI_CALL(env, napi_create_object(env, &scratch), {
+        napi_throw_error(env, NULL, "s_get_lazy_publish_packet_field - failed to create scratch object");
+        return NULL;
     });
 
-    /* compute storage size */
-    size_t total_property_length = 0;
-    for (uint32_t i = 0; i < user_property_count; ++i) {
-        napi_value array_element;
-        AWS_NAPI_CALL(env, napi_get_element(env, node_user_properties, i, &array_element), {
-            AWS_LOGF_ERROR(
-                AWS_LS_NODEJS_CRT_GENERAL,
-                "id=%p s_aws_mqtt5_user_properties_extract_from_js_object - user properties is not indexable",
-                (void *)binding->client);
-            return aws_raise_error(AWS_CRT_NODEJS_ERROR_NAPI_FAILURE);
+    if (s_attach_publish_secondary_field(scratch, env, message_received_ud, field, true)) {
+        aws_napi_throw_last_error_with_context(env, "s_get_lazy_publish_packet_field - failed to materialize field");
+        return NULL;
+    }
+
+    napi_value value = NULL;
+    AWS_NAPI_CALL(
+        env, napi_get_named_property(env, scratch, s_get_publish_secondary_field_key(field), &value), {
+            napi_throw_error(env, NULL, "s_get_lazy_publish_packet_field - failed to read materialized field");
+            return NULL;
         });
 
-        struct aws_byte_buf name_buf;
-        AWS_ZERO_STRUCT(name_buf);
-        struct aws_byte_buf value_buf;
-        AWS_ZERO_STRUCT(value_buf);
+    return value;
+}
 
-        enum aws_napi_get_named_property_result name_gpr =
-            aws_napi_get_named_property_as_bytebuf(env, array_element, AWS_NAPI_KEY_NAME, napi_string, &name_buf);
-        enum aws_napi_get_named_property_result value_gpr =
-            aws_napi_get_named_property_as_bytebuf(env, array_element, AWS_NAPI_KEY_VALUE, napi_string, &value_buf);
+static napi_value s_get_lazy_payload_format(napi_env env, void *native_this) {
+    return s_get_lazy_publish_packet_field(env, native_this, AWS_NAPI_MQTT5_PSF_PAYLOAD_FORMAT);
+}
 
-        total_property_length += name_buf.len + value_buf.len;
+static napi_value s_get_lazy_message_expiry_interval_seconds(napi_env env, void *native_this) {
+    return s_get_lazy_publish_packet_field(env, native_this, AWS_NAPI_MQTT5_PSF_MESSAGE_EXPIRY_INTERVAL_SECONDS);
+}
 
-        aws_byte_buf_clean_up(&name_buf);
-        aws_byte_buf_clean_up(&value_buf);
+static napi_value s_get_lazy_topic_alias(napi_env env, void *native_this) {
+    return s_get_lazy_publish_packet_field(env, native_this, AWS_NAPI_MQTT5_PSF_TOPIC_ALIAS);
+}
 
-        if (name_gpr != AWS_NGNPR_VALID_VALUE || value_gpr != AWS_NGNPR_VALID_VALUE) {
-            AWS_LOGF_ERROR(
-                AWS_LS_NODEJS_CRT_GENERAL,
-                "id=%p s_aws_mqtt5_user_properties_extract_from_js_object - malformed property name/value pair",
-                (void *)binding->client);
-            return aws_raise_error(AWS_ERROR_INVALID_ARGUMENT);
-        }
-    }
+static napi_value s_get_lazy_response_topic(napi_env env, void *native_this) {
+    return s_get_lazy_publish_packet_field(env, native_this, AWS_NAPI_MQTT5_PSF_RESPONSE_TOPIC);
+}
 
-    /* allocate space */
-    if (aws_array_list_init_dynamic(
-            &user_properties_storage->user_properties,
-            allocator,
-            user_property_count,
-            sizeof(struct aws_mqtt5_user_property))) {
-        return AWS_OP_ERR;
-    }
+static napi_value s_get_lazy_correlation_data(napi_env env, void *native_this) {
+    return s_get_lazy_publish_packet_field(env, native_this, AWS_NAPI_MQTT5_PSF_CORRELATION_DATA);
+}
 
-    if (aws_byte_buf_init(&user_properties_storage->user_property_storage, allocator, total_property_length)) {
-        return AWS_OP_ERR;
-    }
+static napi_value s_get_lazy_subscription_identifiers(napi_env env, void *native_this) {
+    return s_get_lazy_publish_packet_field(env, native_this, AWS_NAPI_MQTT5_PSF_SUBSCRIPTION_IDENTIFIERS);
+}
 
-    /* persist each property */
-    for (uint32_t i = 0; i < user_property_count; ++i) {
-        napi_value array_element;
-        AWS_NAPI_CALL(env, napi_get_element(env, node_user_properties, i, &array_element), {
-            return aws_raise_error(AWS_CRT_NODEJS_ERROR_NAPI_FAILURE);
-        });
+static napi_value s_get_lazy_content_type(napi_env env, void *native_this) {
+    return s_get_lazy_publish_packet_field(env, native_this, AWS_NAPI_MQTT5_PSF_CONTENT_TYPE);
+}
 
-        struct aws_byte_buf name_buf;
-        AWS_ZERO_STRUCT(name_buf);
-        struct aws_byte_buf value_buf;
-        AWS_ZERO_STRUCT(value_buf);
+static napi_value s_get_lazy_user_properties(napi_env env, void *native_this) {
+    return s_get_lazy_publish_packet_field(env, native_this, AWS_NAPI_MQTT5_PSF_USER_PROPERTIES);
+}
 
-        aws_napi_get_named_property_as_bytebuf(env, array_element, AWS_NAPI_KEY_NAME, napi_string, &name_buf);
-        aws_napi_get_named_property_as_bytebuf(env, array_element, AWS_NAPI_KEY_VALUE, napi_string, &value_buf);
+napi_status aws_napi_mqtt5_client_bind(napi_env env, napi_value exports) {
 
-        struct aws_mqtt5_user_property user_property;
-        AWS_ZERO_STRUCT(user_property);
+    static const struct aws_napi_method_info s_lazy_publish_packet_constructor_info = {
+        .name = "Mqtt5LazyPublishPacket",
+        .method = s_lazy_publish_packet_constructor,
+        .num_arguments = 0,
+    };
 
-        user_property.name = aws_byte_cursor_from_buf(&name_buf);
-        user_property.value = aws_byte_cursor_from_buf(&value_buf);
+    static const struct aws_napi_property_info s_lazy_publish_packet_properties[] = {
+        {
+            .name = "payloadFormat",
+            .type = napi_undefined,
+            .getter = s_get_lazy_payload_format,
+            .attributes = napi_enumerable,
+        },
+        {
+            .name = "messageExpiryIntervalSeconds",
+            .type = napi_undefined,
+            .getter = s_get_lazy_message_expiry_interval_seconds,
+            .attributes = napi_enumerable,
+        },
+        {
+            .name = "topicAlias",
+            .type = napi_undefined,
+            .getter = s_get_lazy_topic_alias,
+            .attributes = napi_enumerable,
+        },
+        {
+            .name = "responseTopic",
+            .type = napi_undefined,
+            .getter = s_get_lazy_response_topic,
+            .attributes = napi_enumerable,
+        },
+        {
+            .name = "correlationData",
+            .type = napi_undefined,
+            .getter = s_get_lazy_correlation_data,
+            .attributes = napi_enumerable,
+        },
+        {
+            .name = "subscriptionIdentifiers",
+            .type = napi_undefined,
+            .getter = s_get_lazy_subscription_identifiers,
+            .attributes = napi_enumerable,
+        },
+        {
+            .name = "contentType",
+            .type = napi_undefined,
+            .getter = s_get_lazy_content_type,
+            .attributes = napi_enumerable,
+        },
+        {
+            .name = "userProperties",
+            .type = napi_undefined,
+            .getter = s_get_lazy_user_properties,
+            .attributes = napi_enumerable,
+        },
+    };
 
-        bool success =
-            aws_byte_buf_append_and_update(&user_properties_storage->user_property_storage, &user_property.name) ==
-                AWS_OP_SUCCESS &&
-            aws_byte_buf_append_and_update(&user_properties_storage->user_property_storage, &user_property.value) ==
-                AWS_OP_SUCCESS;
+    return aws_napi_define_class(
+        env,
+        exports,
+        &s_lazy_publish_packet_constructor_info,
+        s_lazy_publish_packet_properties,
+        AWS_ARRAY_SIZE(s_lazy_publish_packet_properties),
+        NULL,
+        0,
+        &s_lazy_publish_packet_class_info);
+}
 
-        aws_byte_buf_clean_up(&name_buf);
-        aws_byte_buf_clean_up(&value_buf);
+static int s_create_napi_publish_packet(
+    napi_env env,
+    struct on_message_received_user_data *message_received_ud,
+    napi_value *packet_out) {
 
-        if (!success) {
+    if (env == NULL) {
+        return aws_raise_error(AWS_CRT_NODEJS_ERROR_THREADSAFE_FUNCTION_NULL_NAPI_ENV);
+    }
+
+    const struct aws_mqtt5_packet_publish_view *publish_view = &message_received_ud->publish_storage.storage_view;
+    bool is_lazy = message_received_ud->binding->lazy_publish_properties;
+
+    napi_value packet = NULL;
+    if (is_lazy) {
+        if (aws_napi_wrap(
+                env, &s_lazy_publish_packet_class_info, message_received_ud, s_lazy_publish_packet_finalize, &packet) !=
+            napi_ok) {
+            return aws_raise_error(AWS_CRT_NODEJS_ERROR_NAPI_FAILURE);
+        }
+
+        /* from here on the packet's finalizer is responsible for the user data, even if we fail below */
+        message_received_ud->is_owned_by_packet = true;
+    } else {
+        AWS_NAPI_CALL(
+            env, napi_create_object(env, &packet), { return aws_raise_error(AWS_CRT_NODEJS_ERROR_NAPI_FAILURE); });
+    }
+
+    if (aws_napi_attach_object_property_u32(packet, env, AWS_NAPI_KEY_TYPE, (uint32_t)AWS_MQTT5_PT_PUBLISH)) {
+        return AWS_OP_ERR;
+    }
+
+    napi_value topic = NULL;
+    struct aws_napi_mqtt_topic_intern_cache *topic_intern_cache = message_received_ud->binding->topic_intern_cache;
+    AWS_NAPI_CALL(env, aws_napi_mqtt_create_topic_string(env, topic_intern_cache, publish_view->topic, &topic), {
+        return aws_raise_error(AWS_CRT_NODEJS_ERROR_NAPI_FAILURE);
+    });
+    AWS_NAPI_CALL(env, napi_set_named_property(env, packet, AWS_NAPI_KEY_TOPIC_NAME, topic), {
+        return aws_raise_error(AWS_CRT_NODEJS_ERROR_NAPI_FAILURE);
+    });
+
+    if (s_should_deliver_payload_as_string(message_received_ud->binding, publish_view)) {
+        /* one copy straight into a js string; the native buffer is released with the user data */
+        struct aws_byte_cursor payload_cursor = aws_byte_cursor_from_buf(message_received_ud->payload);
+        if (payload_cursor.ptr == NULL) {
+            payload_cursor = aws_byte_cursor_from_c_str("");
+        }
+
+        if (aws_napi_attach_object_property_string(packet, env, AWS_NAPI_KEY_PAYLOAD, payload_cursor)) {
+            return AWS_OP_ERR;
+        }
+    } else {
+        if (aws_napi_attach_object_property_binary_as_finalizable_external(
+                packet, env, AWS_NAPI_KEY_PAYLOAD, message_received_ud->payload)) {
             return AWS_OP_ERR;
         }
+        message_received_ud->payload = NULL;
+    }
 
-        aws_array_list_push_back(&user_properties_storage->user_properties, &user_property);
+    if (aws_napi_attach_object_property_u32(packet, env, AWS_NAPI_KEY_QOS, (uint32_t)publish_view->qos)) {
+        return AWS_OP_ERR;
     }
 
-    *user_property_count_out = user_property_count;
-    *user_properties_out = user_properties_storage->user_properties.data;
+    if (aws_napi_attach_object_property_boolean(packet, env, AWS_NAPI_KEY_RETAIN, publish_view->retain)) {
+        return AWS_OP_ERR;
+    }
 
-    return AWS_OP_SUCCESS;
-}
+    if (!is_lazy) {
+        for (int field = 0; field < AWS_NAPI_MQTT5_PSF_COUNT; ++field) {
+            if (s_attach_publish_secondary_field(
+                    packet, env, message_received_ud, (enum aws_napi_mqtt5_publish_secondary_field)field, false)) {
+                return AWS_OP_ERR;
+            }
+        }
+    }
 
-static void s_aws_mqtt5_user_properties_clean_up(struct aws_napi_mqtt5_user_property_storage *user_properties_storage) {
-    aws_array_list_clean_up(&user_properties_storage->user_properties);
-    aws_byte_buf_clean_up(&user_properties_storage->user_property_storage);
+    *packet_out = packet;
+
+    return AWS_OP_SUCCESS;
 }
 
 /*
- * Persistent storage for a publish packet.
+ * Binary PUBLISH record layout, decoded by PublishRecordDecoder in lib/native/mqtt5.ts.  All integers are big-endian.
+ *
+ *   u8  record version
+ *   u8  qos
+ *   u8  flags (AWS_NAPI_MQTT5_PRF_*)
+ *   u8  payload format indicator
+ *   u32 message expiry interval seconds
+ *   u16 topic alias
+ *   u16 topic length
+ *   u32 subscription identifier count
+ *   u32 user property count
+ *   topic bytes
+ *
+ * followed by the variable-length tail, whose fields are present only if flagged or counted:
+ *
+ *   u16 length + response topic bytes
+ *   u16 length + correlation data bytes
+ *   u16 length + content type bytes
+ *   u32 subscription identifier * subscription identifier count
+ *   (u16 length + name bytes, u16 length + value bytes) * user property count
+ *
+ * The payload is never copied into the record; it is delivered alongside it.
  */
-struct aws_napi_mqtt5_publish_storage {
-    struct aws_byte_buf topic;
-    struct aws_byte_buf payload;
+#define AWS_NAPI_MQTT5_PUBLISH_RECORD_VERSION 1
+#define AWS_NAPI_MQTT5_PUBLISH_RECORD_HEADER_SIZE 20
+#define AWS_NAPI_MQTT5_PUBLISH_RECORD_MIN_CAPACITY 4096
+
+enum aws_napi_mqtt5_publish_record_flags {
+    AWS_NAPI_MQTT5_PRF_RETAIN = 0x01,
+    AWS_NAPI_MQTT5_PRF_PAYLOAD_FORMAT = 0x02,
+    AWS_NAPI_MQTT5_PRF_MESSAGE_EXPIRY_INTERVAL = 0x04,
+    AWS_NAPI_MQTT5_PRF_TOPIC_ALIAS = 0x08,
+    AWS_NAPI_MQTT5_PRF_RESPONSE_TOPIC = 0x10,
+    AWS_NAPI_MQTT5_PRF_CORRELATION_DATA = 0x20,
+    AWS_NAPI_MQTT5_PRF_CONTENT_TYPE = 0x40,
+};
 
-    enum aws_mqtt5_payload_format_indicator payload_format;
-    uint32_t message_expiry_interval_seconds;
-    uint16_t topic_alias;
+static size_t s_compute_publish_record_size(
+    const struct aws_mqtt5_packet_publish_view *publish_view,
+    const struct aws_byte_cursor *correlation_data) {
 
-    struct aws_byte_buf response_topic;
-    struct aws_byte_cursor response_topic_cursor;
+    size_t size = AWS_NAPI_MQTT5_PUBLISH_RECORD_HEADER_SIZE + publish_view->topic.len;
 
-    struct aws_byte_buf correlation_data;
-    struct aws_byte_cursor correlation_data_cursor;
+    if (publish_view->response_topic != NULL) {
+        size += 2 + publish_view->response_topic->len;
+    }
 
-    struct aws_byte_buf content_type;
-    struct aws_byte_cursor content_type_cursor;
+    if (correlation_data != NULL) {
+        size += 2 + correlation_data->len;
+    }
 
-    struct aws_napi_mqtt5_user_property_storage user_properties;
-};
+    if (publish_view->content_type != NULL) {
+        size += 2 + publish_view->content_type->len;
+    }
 
-static void s_aws_napi_mqtt5_publish_storage_clean_up(struct aws_napi_mqtt5_publish_storage *storage) {
-    aws_byte_buf_clean_up(&storage->topic);
-    aws_byte_buf_clean_up(&storage->payload);
-    aws_byte_buf_clean_up(&storage->response_topic);
-    aws_byte_buf_clean_up(&storage->correlation_data);
-    aws_byte_buf_clean_up(&storage->content_type);
+    size += 4 * publish_view->subscription_identifier_count;
 
-    s_aws_mqtt5_user_properties_clean_up(&storage->user_properties);
-}
+    for (size_t i = 0; i < publish_view->user_property_count; ++i) {
+        const struct aws_mqtt5_user_property *property = &publish_view->user_properties[i];
+        size += 4 + property->name.len + property->value.len;
+    }
 
-static void s_log_get_property_error(
-    void *context,
-    const char *function_name,
-    const char *message,
-    const char *property_name) {
-    AWS_LOGF_ERROR(AWS_LS_NODEJS_CRT_GENERAL, "id=%p %s - %s: %s", context, function_name, message, property_name);
+    return size;
 }
 
-#define PARSE_REQUIRED_NAPI_PROPERTY(property_name, function_name, call_expression, success_block)                     \
-    {                                                                                                                  \
-        enum aws_napi_get_named_property_result gpr = call_expression;                                                 \
-        if (gpr == AWS_NGNPR_VALID_VALUE) {                                                                            \
-            success_block;                                                                                             \
-        } else if (gpr == AWS_NGNPR_INVALID_VALUE) {                                                                   \
-            s_log_get_property_error(                                                                                  \
-                (void *)binding->client, function_name, "invalid value for property", property_name);                  \
-            return aws_raise_error(AWS_ERROR_INVALID_ARGUMENT);                                                        \
-        } else {                                                                                                       \
-            s_log_get_property_error(                                                                                  \
-                (void *)binding->client, function_name, "failed to extract required property", property_name);         \
-            return aws_raise_error(AWS_ERROR_INVALID_ARGUMENT);                                                        \
-        }                                                                                                              \
-    }
+/* Makes sure the shared record buffer can hold at least record_size bytes, replacing it with a larger one if not */
+static int s_ensure_publish_record_buffer(
+    struct aws_mqtt5_client_binding *binding,
+    napi_env env,
+    size_t record_size,
+    napi_value *buffer_out) {
 
-#define PARSE_OPTIONAL_NAPI_PROPERTY(property_name, function_name, call_expression, success_block)                     \
-    {                                                                                                                  \
-        enum aws_napi_get_named_property_result gpr = call_expression;                                                 \
-        if (gpr == AWS_NGNPR_VALID_VALUE) {                                                                            \
-            success_block;                                                                                             \
-        } else if (gpr == AWS_NGNPR_INVALID_VALUE) {                                                                   \
-            s_log_get_property_error(                                                                                  \
-                (void *)binding->client, function_name, "invalid value for property", property_name);                  \
-            return aws_raise_error(AWS_ERROR_INVALID_ARGUMENT);                                                        \
-        }                                                                                                              \
+    if (binding->publish_record_buffer_ref != NULL && record_size <= binding->publish_record_buffer_capacity) {
+        AWS_NAPI_CALL(env, napi_get_reference_value(env, binding->publish_record_buffer_ref, buffer_out), {
+            return aws_raise_error(AWS_CRT_NODEJS_ERROR_NAPI_FAILURE);
+        });
+
+        return AWS_OP_SUCCESS;
     }
 
-/* Extract a PUBLISH packet view from a Napi object (AwsMqtt5PacketPublish) and persist its data in storage. */
-static int s_init_publish_options_from_napi(
-    struct aws_mqtt5_client_binding *binding,
-    napi_env env,
-    napi_value node_publish_config,
-    struct aws_mqtt5_packet_publish_view *publish_options,
-    struct aws_napi_mqtt5_publish_storage *publish_storage) {
+    size_t capacity = aws_max_size(binding->publish_record_buffer_capacity * 2, record_size);
+    capacity = aws_max_size(capacity, AWS_NAPI_MQTT5_PUBLISH_RECORD_MIN_CAPACITY);
 
-    PARSE_REQUIRED_NAPI_PROPERTY(
-        AWS_NAPI_KEY_TOPIC_NAME,
-        "s_init_publish_options_from_napi",
-        aws_napi_get_named_property_as_bytebuf(
-            env, node_publish_config, AWS_NAPI_KEY_TOPIC_NAME, napi_string, &publish_storage->topic),
-        { publish_options->topic = aws_byte_cursor_from_buf(&publish_storage->topic); });
+    void *data = NULL;
+    napi_value buffer = NULL;
+    AWS_NAPI_CALL(env, napi_create_arraybuffer(env, capacity, &data, &buffer), {
+        return aws_raise_error(AWS_CRT_NODEJS_ERROR_NAPI_FAILURE);
+    });
 
-    PARSE_OPTIONAL_NAPI_PROPERTY(
-        AWS_NAPI_KEY_PAYLOAD,
-        "s_init_publish_options_from_napi",
-        aws_napi_get_named_property_as_bytebuf(
-            env, node_publish_config, AWS_NAPI_KEY_PAYLOAD, napi_undefined, &publish_storage->payload),
-        { publish_options->payload = aws_byte_cursor_from_buf(&publish_storage->payload); });
+    napi_ref buffer_ref = NULL;
+    AWS_NAPI_CALL(env, napi_create_reference(env, buffer, 1, &buffer_ref), {
+        return aws_raise_error(AWS_CRT_NODEJS_ERROR_NAPI_FAILURE);
+    });
 
-    uint32_t qos = 0;
-    PARSE_REQUIRED_NAPI_PROPERTY(
-        AWS_NAPI_KEY_QOS,
-        "s_init_publish_options_from_napi",
-        aws_napi_get_named_property_as_uint32(env, node_publish_config, AWS_NAPI_KEY_QOS, &qos),
-        { publish_options->qos = qos; });
+    s_publish_record_buffer_release(binding, env);
 
-    PARSE_OPTIONAL_NAPI_PROPERTY(
-        AWS_NAPI_KEY_RETAIN,
-        "s_init_publish_options_from_napi",
-        aws_napi_get_named_property_as_boolean(env, node_publish_config, AWS_NAPI_KEY_RETAIN, &publish_options->retain),
-        {});
+    binding->publish_record_buffer_ref = buffer_ref;
+    binding->publish_record_buffer = data;
+    binding->publish_record_buffer_capacity = capacity;
 
-    uint32_t payload_format = 0;
-    PARSE_OPTIONAL_NAPI_PROPERTY(
-        AWS_NAPI_KEY_PAYLOAD_FORMAT,
-        "s_init_publish_options_from_napi",
-        aws_napi_get_named_property_as_uint32(env, node_publish_config, AWS_NAPI_KEY_PAYLOAD_FORMAT, &payload_format),
-        {
-            publish_storage->payload_format = payload_format;
-            publish_options->payload_format = &publish_storage->payload_format;
-        });
+    *buffer_out = buffer;
 
-    PARSE_OPTIONAL_NAPI_PROPERTY(
-        AWS_NAPI_KEY_MESSAGE_EXPIRY_INTERVAL_SECONDS,
-        "s_init_publish_options_from_napi",
-        aws_napi_get_named_property_as_uint32(
-            env,
-            node_publish_config,
-            AWS_NAPI_KEY_MESSAGE_EXPIRY_INTERVAL_SECONDS,
-            &publish_storage->message_expiry_interval_seconds),
-        { publish_options->message_expiry_interval_seconds = &publish_storage->message_expiry_interval_seconds; });
+    return AWS_OP_SUCCESS;
+}
 
-    PARSE_OPTIONAL_NAPI_PROPERTY(
-        AWS_NAPI_KEY_TOPIC_ALIAS,
-        "s_init_publish_options_from_napi",
-        aws_napi_get_named_property_as_uint16(
-            env, node_publish_config, AWS_NAPI_KEY_TOPIC_ALIAS, &publish_storage->topic_alias),
-        { publish_options->topic_alias = &publish_storage->topic_alias; });
+static void s_write_publish_record_length_prefixed(struct aws_byte_buf *record, struct aws_byte_cursor value) {
+    aws_byte_buf_write_be16(record, (uint16_t)value.len);
+    aws_byte_buf_write_from_whole_cursor(record, value);
+}
 
-    PARSE_OPTIONAL_NAPI_PROPERTY(
-        AWS_NAPI_KEY_RESPONSE_TOPIC,
-        "s_init_publish_options_from_napi",
-        aws_napi_get_named_property_as_bytebuf(
-            env, node_publish_config, AWS_NAPI_KEY_RESPONSE_TOPIC, napi_string, &publish_storage->response_topic),
-        {
-            publish_storage->response_topic_cursor = aws_byte_cursor_from_buf(&publish_storage->response_topic);
-            publish_options->response_topic = &publish_storage->response_topic_cursor;
-        });
+/* Writes a binary PUBLISH record; the buffer must have room for s_compute_publish_record_size() bytes */
+static void s_write_publish_record(
+    struct aws_byte_buf *record,
+    const struct aws_mqtt5_packet_publish_view *publish_view,
+    const struct aws_byte_cursor *correlation_data) {
 
-    PARSE_OPTIONAL_NAPI_PROPERTY(
-        AWS_NAPI_KEY_CORRELATION_DATA,
-        "s_init_publish_options_from_napi",
-        aws_napi_get_named_property_as_bytebuf(
-            env,
-            node_publish_config,
-            AWS_NAPI_KEY_CORRELATION_DATA,
-            napi_undefined,
-            &publish_storage->correlation_data),
-        {
-            publish_storage->correlation_data_cursor = aws_byte_cursor_from_buf(&publish_storage->correlation_data);
-            publish_options->correlation_data = &publish_storage->correlation_data_cursor;
-        });
+    uint8_t flags = 0;
+    if (publish_view->retain) {
+        flags |= AWS_NAPI_MQTT5_PRF_RETAIN;
+    }
+    if (publish_view->payload_format != NULL) {
+        flags |= AWS_NAPI_MQTT5_PRF_PAYLOAD_FORMAT;
+    }
+    if (publish_view->message_expiry_interval_seconds != NULL) {
+        flags |= AWS_NAPI_MQTT5_PRF_MESSAGE_EXPIRY_INTERVAL;
+    }
+    if (publish_view->topic_alias != NULL) {
+        flags |= AWS_NAPI_MQTT5_PRF_TOPIC_ALIAS;
+    }
+    if (publish_view->response_topic != NULL) {
+        flags |= AWS_NAPI_MQTT5_PRF_RESPONSE_TOPIC;
+    }
+    if (correlation_data != NULL) {
+        flags |= AWS_NAPI_MQTT5_PRF_CORRELATION_DATA;
+    }
+    if (publish_view->content_type != NULL) {
+        flags |= AWS_NAPI_MQTT5_PRF_CONTENT_TYPE;
+    }
 
-    PARSE_OPTIONAL_NAPI_PROPERTY(
-        AWS_NAPI_KEY_CONTENT_TYPE,
-        "s_init_publish_options_from_napi",
-        aws_napi_get_named_property_as_bytebuf(
-            env, node_publish_config, AWS_NAPI_KEY_CONTENT_TYPE, napi_string, &publish_storage->content_type),
-        {
-            publish_storage->content_type_cursor = aws_byte_cursor_from_buf(&publish_storage->content_type);
-            publish_options->content_type = &publish_storage->content_type_cursor;
-        });
+    aws_byte_buf_write_u8(record, AWS_NAPI_MQTT5_PUBLISH_RECORD_VERSION);
+    aws_byte_buf_write_u8(record, (uint8_t)publish_view->qos);
+    aws_byte_buf_write_u8(record, flags);
+    aws_byte_buf_write_u8(record, publish_view->payload_format != NULL ? (uint8_t)(*publish_view->payload_format) : 0);
+    aws_byte_buf_write_be32(
+        record,
+        publish_view->message_expiry_interval_seconds != NULL ? *publish_view->message_expiry_interval_seconds : 0);
+    aws_byte_buf_write_be16(record, publish_view->topic_alias != NULL ? *publish_view->topic_alias : 0);
+    aws_byte_buf_write_be16(record, (uint16_t)publish_view->topic.len);
+    aws_byte_buf_write_be32(record, (uint32_t)publish_view->subscription_identifier_count);
+    aws_byte_buf_write_be32(record, (uint32_t)publish_view->user_property_count);
+    aws_byte_buf_write_from_whole_cursor(record, publish_view->topic);
 
-    if (s_aws_mqtt5_user_properties_extract_from_js_object(
-            binding,
-            &publish_storage->user_properties,
-            env,
-            node_publish_config,
-            &publish_options->user_property_count,
-            &publish_options->user_properties)) {
-        AWS_LOGF_ERROR(
-            AWS_LS_NODEJS_CRT_GENERAL,
-            "id=%p s_init_publish_options_from_napi - failed to extract userProperties",
-            (void *)binding->client);
-        return AWS_OP_ERR;
+    if (publish_view->response_topic != NULL) {
+        s_write_publish_record_length_prefixed(record, *publish_view->response_topic);
     }
 
-    return AWS_OP_SUCCESS;
-}
+    if (correlation_data != NULL) {
+        s_write_publish_record_length_prefixed(record, *correlation_data);
+    }
 
-/* Persistent storage for a CONNECT packet. */
-struct aws_napi_mqtt5_connect_storage {
-    struct aws_byte_buf client_id;
-    struct aws_byte_cursor client_id_cursor;
+    if (publish_view->content_type != NULL) {
+        s_write_publish_record_length_prefixed(record, *publish_view->content_type);
+    }
 
-    struct aws_byte_buf username;
-    struct aws_byte_cursor username_cursor;
+    for (size_t i = 0; i < publish_view->subscription_identifier_count; ++i) {
+        aws_byte_buf_write_be32(record, publish_view->subscription_identifiers[i]);
+    }
 
-    struct aws_byte_buf password;
-    struct aws_byte_cursor password_cursor;
+    for (size_t i = 0; i < publish_view->user_property_count; ++i) {
+        const struct aws_mqtt5_user_property *property = &publish_view->user_properties[i];
+        s_write_publish_record_length_prefixed(record, property->name);
+        s_write_publish_record_length_prefixed(record, property->value);
+    }
+}
 
-    uint32_t session_expiry_interval_seconds;
-    uint8_t request_response_information;
-    uint8_t request_problem_information;
-    uint16_t receive_maximum;
-    uint32_t maximum_packet_size_bytes;
-    uint32_t will_delay_interval_seconds;
+/* Serializes everything but the payload of a received PUBLISH into the binding's shared record buffer */
+static int s_encode_publish_record(
+    struct aws_mqtt5_client_binding *binding,
+    napi_env env,
+    struct on_message_received_user_data *message_received_ud,
+    napi_value *buffer_out,
+    size_t *record_size_out) {
 
-    struct aws_napi_mqtt5_publish_storage will_storage;
+    const struct aws_mqtt5_packet_publish_view *publish_view = &message_received_ud->publish_storage.storage_view;
 
-    struct aws_napi_mqtt5_user_property_storage user_properties;
-};
+    struct aws_byte_cursor correlation_data_cursor;
+    const struct aws_byte_cursor *correlation_data = NULL;
+    if (message_received_ud->correlation_data != NULL) {
+        correlation_data_cursor = aws_byte_cursor_from_buf(message_received_ud->correlation_data);
+        correlation_data = &correlation_data_cursor;
+    }
 
-static void s_aws_napi_mqtt5_connect_storage_clean_up(struct aws_napi_mqtt5_connect_storage *storage) {
-    aws_byte_buf_clean_up(&storage->client_id);
-    aws_byte_buf_clean_up(&storage->username);
-    aws_byte_buf_clean_up(&storage->password);
+    size_t record_size = s_compute_publish_record_size(publish_view, correlation_data);
+    if (record_size > UINT32_MAX) {
+        return aws_raise_error(AWS_ERROR_INVALID_ARGUMENT);
+    }
 
-    s_aws_napi_mqtt5_publish_storage_clean_up(&storage->will_storage);
+    if (s_ensure_publish_record_buffer(binding, env, record_size, buffer_out)) {
+        return AWS_OP_ERR;
+    }
 
-    s_aws_mqtt5_user_properties_clean_up(&storage->user_properties);
+    struct aws_byte_buf record =
+        aws_byte_buf_from_empty_array(binding->publish_record_buffer, binding->publish_record_buffer_capacity);
+    s_write_publish_record(&record, publish_view, correlation_data);
+
+    AWS_FATAL_ASSERT(record.len == record_size);
+    *record_size_out = record_size;
+
+    return AWS_OP_SUCCESS;
 }
 
-/* Extract a CONNECT packet view from a Napi object (AwsMqtt5PacketConnect) and persist its data in storage. */
-static int s_init_connect_options_from_napi(
+/*
+ * Appends a received PUBLISH to the shared message ring, straight from the event loop thread.  Each ring record is a
+ * u32 publish record length, the publish record, then the payload.  The consumer is only woken when it has drained
+ * the ring.  QoS 0 publishes that do not fit are dropped and counted in the ring header; QoS 1 and 2 publishes have
+ * already been acknowledged, so they are left for the regular delivery path instead.
+ *
+ * Returns false if the publish was not consumed and must still be delivered.
+ */
+static bool s_message_ring_append(
     struct aws_mqtt5_client_binding *binding,
-    napi_env env,
-    napi_value node_connect_config,
-    struct aws_mqtt5_packet_connect_view *connect_options,
-    struct aws_mqtt5_packet_publish_view *will_options,
-    struct aws_napi_mqtt5_connect_storage *connect_storage) {
+    const struct aws_mqtt5_packet_publish_view *publish_view) {
 
-    PARSE_REQUIRED_NAPI_PROPERTY(
-        AWS_NAPI_KEY_KEEP_ALIVE_INTERVAL_SECONDS,
-        "s_init_connect_options_from_napi",
-        aws_napi_get_named_property_as_uint16(
-            env,
-            node_connect_config,
-            AWS_NAPI_KEY_KEEP_ALIVE_INTERVAL_SECONDS,
-            &connect_options->keep_alive_interval_seconds),
-        {});
+    size_t publish_record_size = s_compute_publish_record_size(publish_view, publish_view->correlation_data);
+    size_t ring_record_size = 4 + publish_record_size + publish_view->payload.len;
 
-    PARSE_OPTIONAL_NAPI_PROPERTY(
-        AWS_NAPI_KEY_CLIENT_ID,
-        "s_init_connect_options_from_napi",
-        aws_napi_get_named_property_as_bytebuf(
-            env, node_connect_config, AWS_NAPI_KEY_CLIENT_ID, napi_string, &connect_storage->client_id),
-        { connect_options->client_id = aws_byte_cursor_from_buf(&connect_storage->client_id); });
+    bool is_consumed = true;
+    bool wake_consumer = false;
 
-    PARSE_OPTIONAL_NAPI_PROPERTY(
-        AWS_NAPI_KEY_USERNAME,
-        "s_init_connect_options_from_napi",
-        aws_napi_get_named_property_as_bytebuf(
-            env, node_connect_config, AWS_NAPI_KEY_USERNAME, napi_string, &connect_storage->username),
-        {
-            connect_storage->username_cursor = aws_byte_cursor_from_buf(&connect_storage->username);
-            connect_options->username = &connect_storage->username_cursor;
-        });
+    aws_mutex_lock(&binding->message_ring_lock);
+    if (!binding->is_message_ring_closed) {
+        struct aws_byte_buf ring_record;
+        if (ring_record_size > UINT32_MAX ||
+            aws_napi_shared_ring_reserve(&binding->message_ring, ring_record_size, &ring_record)) {
+            if (publish_view->qos == AWS_MQTT5_QOS_AT_MOST_ONCE) {
+                AWS_LOGF_WARN(
+                    AWS_LS_NODEJS_CRT_GENERAL,
+                    "id=%p s_message_ring_append - shared message ring full, dropping publish",
+                    (void *)binding->client);
+                aws_napi_shared_ring_record_drop(&binding->message_ring);
+            } else {
+                is_consumed = false;
+            }
+        } else {
+            aws_byte_buf_write_be32(&ring_record, (uint32_t)publish_record_size);
+            s_write_publish_record(&ring_record, publish_view, publish_view->correlation_data);
+            aws_byte_buf_write_from_whole_cursor(&ring_record, publish_view->payload);
+            AWS_FATAL_ASSERT(ring_record.len == ring_record_size);
 
-    PARSE_OPTIONAL_NAPI_PROPERTY(
-        AWS_NAPI_KEY_PASSWORD,
-        "s_init_connect_options_from_napi",
-        aws_napi_get_named_property_as_bytebuf(
-            env, node_connect_config, AWS_NAPI_KEY_PASSWORD, napi_undefined, &connect_storage->password),
-        {
-            connect_storage->password_cursor = aws_byte_cursor_from_buf(&connect_storage->password);
-            connect_options->password = &connect_storage->password_cursor;
-        });
+            wake_consumer = aws_napi_shared_ring_commit(&binding->message_ring);
+        }
+    }
+    aws_mutex_unlock(&binding->message_ring_lock);
 
-    PARSE_OPTIONAL_NAPI_PROPERTY(
-        AWS_NAPI_KEY_SESSION_EXPIRY_INTERVAL_SECONDS,
-        "s_init_connect_options_from_napi",
-        aws_napi_get_named_property_as_uint32(
-            env,
-            node_connect_config,
-            AWS_NAPI_KEY_SESSION_EXPIRY_INTERVAL_SECONDS,
-            &connect_storage->session_expiry_interval_seconds),
-        { connect_options->session_expiry_interval_seconds = &connect_storage->session_expiry_interval_seconds; });
+    if (wake_consumer) {
+        AWS_NAPI_ENSURE(
+            NULL,
+            aws_napi_queue_threadsafe_function(
+                binding->on_message_ring_ready, s_on_simple_event_user_data_new(binding)));
+    }
 
-    PARSE_OPTIONAL_NAPI_PROPERTY(
-        AWS_NAPI_KEY_REQUEST_RESPONSE_INFORMATION,
-        "s_init_connect_options_from_napi",
-        aws_napi_get_named_property_boolean_as_uint8(
-            env,
-            node_connect_config,
-            AWS_NAPI_KEY_REQUEST_RESPONSE_INFORMATION,
-            &connect_storage->request_response_information),
-        { connect_options->request_response_information = &connect_storage->request_response_information; });
+    return is_consumed;
+}
 
-    PARSE_OPTIONAL_NAPI_PROPERTY(
-        AWS_NAPI_KEY_REQUEST_PROBLEM_INFORMATION,
-        "s_init_connect_options_from_napi",
-        aws_napi_get_named_property_boolean_as_uint8(
-            env,
-            node_connect_config,
-            AWS_NAPI_KEY_REQUEST_PROBLEM_INFORMATION,
-            &connect_storage->request_problem_information),
-        { connect_options->request_problem_information = &connect_storage->request_problem_information; });
-
-    PARSE_OPTIONAL_NAPI_PROPERTY(
-        AWS_NAPI_KEY_RECEIVE_MAXIMUM,
-        "s_init_connect_options_from_napi",
-        aws_napi_get_named_property_as_uint16(
-            env, node_connect_config, AWS_NAPI_KEY_RECEIVE_MAXIMUM, &connect_storage->receive_maximum),
-        { connect_options->receive_maximum = &connect_storage->receive_maximum; });
-
-    PARSE_OPTIONAL_NAPI_PROPERTY(
-        AWS_NAPI_KEY_MAXIMUM_PACKET_SIZE_BYTES,
-        "s_init_connect_options_from_napi",
-        aws_napi_get_named_property_as_uint32(
-            env,
-            node_connect_config,
-            AWS_NAPI_KEY_MAXIMUM_PACKET_SIZE_BYTES,
-            &connect_storage->maximum_packet_size_bytes),
-        { connect_options->maximum_packet_size_bytes = &connect_storage->maximum_packet_size_bytes; });
+/* in-node/libuv-thread function that lets the client drain the shared message ring */
+static void s_napi_on_message_ring_ready(napi_env env, napi_value function, void *context, void *user_data) {
+    (void)context;
 
-    PARSE_OPTIONAL_NAPI_PROPERTY(
-        AWS_NAPI_KEY_WILL_DELAY_INTERVAL_SECONDS,
-        "s_init_connect_options_from_napi",
-        aws_napi_get_named_property_as_uint32(
-            env,
-            node_connect_config,
-            AWS_NAPI_KEY_WILL_DELAY_INTERVAL_SECONDS,
-            &connect_storage->will_delay_interval_seconds),
-        { connect_options->will_delay_interval_seconds = &connect_storage->will_delay_interval_seconds; });
+    struct on_simple_event_user_data *simple_ud = user_data;
+    struct aws_mqtt5_client_binding *binding = simple_ud->binding;
 
-    napi_value napi_will = NULL;
-    if (AWS_NGNPR_VALID_VALUE ==
-        aws_napi_get_named_property(env, node_connect_config, AWS_NAPI_KEY_WILL, napi_object, &napi_will)) {
-        if (!aws_napi_is_null_or_undefined(env, napi_will)) {
-            if (s_init_publish_options_from_napi(
-                    binding, env, napi_will, will_options, &connect_storage->will_storage)) {
-                AWS_LOGF_ERROR(
-                    AWS_LS_NODEJS_CRT_GENERAL,
-                    "s_init_connect_options_from_napi - failed to destructure will properties");
-                return AWS_OP_ERR;
-            }
+    if (env) {
+        napi_value params[1];
+        const size_t num_params = AWS_ARRAY_SIZE(params);
 
-            connect_options->will = will_options;
+        params[0] = NULL;
+        if (napi_get_reference_value(env, binding->node_mqtt5_client_ref, &params[0]) != napi_ok || params[0] == NULL) {
+            AWS_LOGF_INFO(
+                AWS_LS_NODEJS_CRT_GENERAL,
+                "id=%p s_napi_on_message_ring_ready - mqtt5_client node wrapper no longer resolvable",
+                (void *)binding->client);
+            goto done;
         }
-    }
 
-    if (s_aws_mqtt5_user_properties_extract_from_js_object(
-            binding,
-            &connect_storage->user_properties,
+        AWS_NAPI_ENSURE(
             env,
-            node_connect_config,
-            &connect_options->user_property_count,
-            &connect_options->user_properties)) {
-        AWS_LOGF_ERROR(
-            AWS_LS_NODEJS_CRT_GENERAL, "s_init_connect_options_from_napi - failed to extract userProperties");
-        return AWS_OP_ERR;
+            aws_napi_dispatch_threadsafe_function(
+                env, binding->on_message_ring_ready, NULL, function, num_params, params));
     }
 
-    return AWS_OP_SUCCESS;
+done:
+
+    s_on_simple_event_user_data_destroy(simple_ud);
 }
 
-/* Extract topic aliasing configuration from a node object */
-static int s_init_topic_aliasing_options_from_napi(
-    struct aws_mqtt5_client_binding *binding,
-    napi_env env,
-    napi_value node_topic_aliasing_config,
-    struct aws_mqtt5_client_topic_alias_options *topic_aliasing_options) {
+struct on_response_received_user_data {
+    struct aws_allocator *allocator;
+    struct aws_mqtt5_client_binding *binding;
+    uint64_t request_id;
+    struct aws_byte_buf topic;
 
-    uint32_t outbound_behavior = 0;
-    PARSE_OPTIONAL_NAPI_PROPERTY(
-        AWS_NAPI_KEY_OUTBOUND_BEHAVIOR,
-        "s_init_topic_aliasing_options_from_napi",
-        aws_napi_get_named_property_as_uint32(
-            env, node_topic_aliasing_config, AWS_NAPI_KEY_OUTBOUND_BEHAVIOR, (uint32_t *)&outbound_behavior),
-        {
-            topic_aliasing_options->outbound_topic_alias_behavior =
-                (enum aws_mqtt5_client_outbound_topic_alias_behavior_type)outbound_behavior;
-        });
+    /* ownership passes to the ArrayBuffer handed to node */
+    struct aws_byte_buf *payload;
+};
 
-    PARSE_OPTIONAL_NAPI_PROPERTY(
-        AWS_NAPI_KEY_OUTBOUND_CACHE_MAX_SIZE,
-        "s_init_topic_aliasing_options_from_napi",
-        aws_napi_get_named_property_as_uint16(
-            env,
-            node_topic_aliasing_config,
-            AWS_NAPI_KEY_OUTBOUND_CACHE_MAX_SIZE,
-            &topic_aliasing_options->outbound_alias_cache_max_size),
-        {});
+static void s_on_response_received_user_data_destroy(struct on_response_received_user_data *user_data) {
+    if (user_data == NULL) {
+        return;
+    }
 
-    uint32_t inbound_behavior = 0;
-    PARSE_OPTIONAL_NAPI_PROPERTY(
-        AWS_NAPI_KEY_INBOUND_BEHAVIOR,
-        "s_init_topic_aliasing_options_from_napi",
-        aws_napi_get_named_property_as_uint32(
-            env, node_topic_aliasing_config, AWS_NAPI_KEY_INBOUND_BEHAVIOR, (uint32_t *)&inbound_behavior),
-        {
-            topic_aliasing_options->inbound_topic_alias_behavior =
-                (enum aws_mqtt5_client_inbound_topic_alias_behavior_type)inbound_behavior;
-        });
+    user_data->binding = s_aws_mqtt5_client_binding_release(user_data->binding);
 
-    PARSE_OPTIONAL_NAPI_PROPERTY(
-        AWS_NAPI_KEY_INBOUND_CACHE_MAX_SIZE,
-        "s_init_topic_aliasing_options_from_napi",
-        aws_napi_get_named_property_as_uint16(
-            env,
-            node_topic_aliasing_config,
-            AWS_NAPI_KEY_INBOUND_CACHE_MAX_SIZE,
-            &topic_aliasing_options->inbound_alias_cache_size),
-        {});
+    aws_byte_buf_clean_up(&user_data->topic);
+    if (user_data->payload != NULL) {
+        aws_byte_buf_clean_up(user_data->payload);
+        aws_mem_release(user_data->allocator, user_data->payload);
+    }
 
-    return AWS_OP_SUCCESS;
+    aws_mem_release(user_data->allocator, user_data);
 }
 
-/*
- * Persistent storage for mqtt5 client options
- */
-struct aws_napi_mqtt5_client_creation_storage {
-    struct aws_byte_buf host_name;
-
-    struct aws_napi_mqtt5_connect_storage connect_storage;
-};
+static struct on_response_received_user_data *s_on_response_received_user_data_new(
+    struct aws_mqtt5_client_binding *binding,
+    uint64_t request_id,
+    const struct aws_mqtt5_packet_publish_view *publish_view) {
 
-static void s_aws_napi_mqtt5_client_creation_storage_clean_up(struct aws_napi_mqtt5_client_creation_storage *storage) {
-    aws_byte_buf_clean_up(&storage->host_name);
+    struct on_response_received_user_data *user_data =
+        aws_mem_calloc(binding->allocator, 1, sizeof(struct on_response_received_user_data));
+    user_data->allocator = binding->allocator;
+    user_data->request_id = request_id;
 
-    s_aws_napi_mqtt5_connect_storage_clean_up(&storage->connect_storage);
-}
+    if (aws_byte_buf_init_copy_from_cursor(&user_data->topic, binding->allocator, publish_view->topic)) {
+        goto error;
+    }
 
-/* persistent storage for all the data necessary to transform the websocket handshake */
-struct mqtt5_transform_websocket_args {
-    struct aws_allocator *allocator;
-    struct aws_mqtt5_client_binding *binding;
+    user_data->payload = aws_mem_calloc(binding->allocator, 1, sizeof(struct aws_byte_buf));
+    if (aws_byte_buf_init_copy_from_cursor(user_data->payload, binding->allocator, publish_view->payload)) {
+        goto error;
+    }
 
-    struct aws_http_message *request;
+    user_data->binding = s_aws_mqtt5_client_binding_acquire(binding);
 
-    aws_mqtt5_transform_websocket_handshake_complete_fn *complete_fn;
-    void *complete_ctx;
-};
+    return user_data;
 
-static void s_mqtt5_transform_websocket_args_destroy(struct mqtt5_transform_websocket_args *args) {
-    if (args == NULL) {
-        return;
-    }
+error:
 
-    args->binding = s_aws_mqtt5_client_binding_release(args->binding);
+    s_on_response_received_user_data_destroy(user_data);
 
-    aws_mem_release(args->allocator, args);
+    return NULL;
 }
 
-/* invoked from node once the JS handshake transform callback has completed */
-static napi_value s_napi_mqtt5_transform_websocket_complete(napi_env env, napi_callback_info cb_info) {
-
-    struct mqtt5_transform_websocket_args *args = NULL;
-    int error_code = AWS_ERROR_SUCCESS;
+/*
+ * Invoked from the event loop thread for every received publish.  Publishes on a response filter are consumed here:
+ * ones that complete an outstanding request are sent to node on their own threadsafe function, the rest are dropped.
+ * Returns false if the publish should be delivered normally.
+ */
+static bool s_route_response(
+    struct aws_mqtt5_client_binding *binding,
+    const struct aws_mqtt5_packet_publish_view *publish_view) {
 
-    napi_value node_args[1];
-    size_t num_args = AWS_ARRAY_SIZE(node_args);
-    napi_value *arg = &node_args[0];
-    AWS_NAPI_CALL(env, napi_get_cb_info(env, cb_info, &num_args, node_args, NULL, (void **)&args), {
-        napi_throw_error(env, NULL, "mqtt5_transform_websocket_complete - Failed to retrieve callback information");
-        goto cleanup;
-    });
-    if (num_args > 1) {
-        napi_throw_error(env, NULL, "mqtt5_transform_websocket_complete - needs exactly 0 or 1 arguments");
-        goto cleanup;
+    if (aws_atomic_load_int(&binding->is_response_routing_enabled) == 0) {
+        return false;
     }
 
-    napi_value node_error_code = *arg++;
-    /* If the user didn't provide an error_code, the napi_value will be undefined, so we can ignore it */
-    if (!aws_napi_is_null_or_undefined(env, node_error_code)) {
-        AWS_NAPI_CALL(env, napi_get_value_int32(env, node_error_code, &error_code), {
-            napi_throw_type_error(
-                env, NULL, "mqtt5_transform_websocket_complete - error_code must be a number or undefined");
-            goto cleanup;
-        });
+    uint64_t request_id = 0;
+    bool is_consumed = true;
+
+    /*
+     * Held until the response is queued: disabling routes from node releases the router and the threadsafe function
+     * under this lock, and may have done so since the check above.
+     */
+    aws_mutex_lock(&binding->response_router_lock);
+
+    enum aws_napi_mqtt5_response_route_result result = AWS_NAPI_MQTT5_RRR_NOT_A_RESPONSE;
+    if (binding->response_router != NULL) {
+        result = aws_napi_mqtt5_response_router_route(
+            binding->response_router, publish_view->topic, publish_view->correlation_data, &request_id);
     }
 
-    args->complete_fn(args->request, error_code, args->complete_ctx);
+    switch (result) {
+        case AWS_NAPI_MQTT5_RRR_NOT_A_RESPONSE:
+            is_consumed = false;
+            break;
 
-cleanup:
+        case AWS_NAPI_MQTT5_RRR_UNMATCHED:
+            AWS_LOGF_DEBUG(
+                AWS_LS_NODEJS_CRT_GENERAL,
+                "id=%p s_route_response - dropping response that matches no outstanding request",
+                (void *)binding->client);
+            break;
 
-    s_mqtt5_transform_websocket_args_destroy(args);
+        default: {
+            struct on_response_received_user_data *response_ud =
+                s_on_response_received_user_data_new(binding, request_id, publish_view);
+            if (response_ud == NULL) {
+                /* the request will time out in node */
+                AWS_LOGF_ERROR(
+                    AWS_LS_NODEJS_CRT_GENERAL,
+                    "id=%p s_route_response - failed to copy response, error %d(%s)",
+                    (void *)binding->client,
+                    aws_last_error(),
+                    aws_error_debug_str(aws_last_error()));
+                break;
+            }
 
-    return NULL;
-}
+            AWS_NAPI_ENSURE(NULL, aws_napi_queue_threadsafe_function(binding->on_response_received, response_ud));
+            break;
+        }
+    }
 
-/* in-node/libuv-thread function to trigger websocket handshake transform callback */
-static void s_napi_mqtt5_transform_websocket(
-    napi_env env,
-    napi_value transform_websocket,
-    void *context,
-    void *user_data) {
+    aws_mutex_unlock(&binding->response_router_lock);
+
+    return is_consumed;
+}
 
+/* in-node/libuv-thread function that completes a request-response request */
+static void s_napi_on_response_received(napi_env env, napi_value function, void *context, void *user_data) {
     (void)context;
-    struct mqtt5_transform_websocket_args *args = user_data;
+
+    struct on_response_received_user_data *response_ud = user_data;
+    struct aws_mqtt5_client_binding *binding = response_ud->binding;
 
     if (env) {
-        napi_value params[2];
+        /* client, request id, topic, payload */
+        napi_value params[4];
         const size_t num_params = AWS_ARRAY_SIZE(params);
 
-        AWS_NAPI_ENSURE(env, aws_napi_http_message_wrap(env, args->request, &params[0]));
-        AWS_NAPI_ENSURE(
+        params[0] = NULL;
+        if (napi_get_reference_value(env, binding->node_mqtt5_client_ref, &params[0]) != napi_ok || params[0] == NULL) {
+            AWS_LOGF_INFO(
+                AWS_LS_NODEJS_CRT_GENERAL,
+                "id=%p s_napi_on_response_received - mqtt5_client node wrapper no longer resolvable",
+                (void *)binding->client);
+            goto done;
+        }
+
+        AWS_NAPI_CALL(env, napi_create_double(env, (double)response_ud->request_id, &params[1]), { goto done; });
+
+        AWS_NAPI_CALL(
             env,
-            napi_create_function(
-                env,
-                "mqtt5_transform_websocket_complete",
-                NAPI_AUTO_LENGTH,
-                &s_napi_mqtt5_transform_websocket_complete,
-                args,
-                &params[1]));
+            napi_create_string_utf8(
+                env, (const char *)response_ud->topic.buffer, response_ud->topic.len, &params[2]),
+            { goto done; });
+
+        if (aws_napi_create_binary_as_finalizable_external(env, response_ud->payload, &params[3])) {
+            goto done;
+        }
+        response_ud->payload = NULL;
 
         AWS_NAPI_ENSURE(
             env,
             aws_napi_dispatch_threadsafe_function(
-                env, args->binding->transform_websocket, NULL, transform_websocket, num_params, params));
-    } else {
-        args->complete_fn(args->request, AWS_CRT_NODEJS_ERROR_THREADSAFE_FUNCTION_NULL_NAPI_ENV, args->complete_ctx);
-
-        s_mqtt5_transform_websocket_args_destroy(args);
+                env, binding->on_response_received, NULL, function, num_params, params));
     }
+
+done:
+
+    s_on_response_received_user_data_destroy(response_ud);
 }
 
-static void s_mqtt5_transform_websocket(
-    struct aws_http_message *request,
-    void *user_data,
-    aws_mqtt5_transform_websocket_handshake_complete_fn *complete_fn,
-    void *complete_ctx) {
+/* Payloads travel next to the binary record: as a string when configured, otherwise as an owning ArrayBuffer */
+static int s_create_napi_publish_payload(
+    napi_env env,
+    struct on_message_received_user_data *message_received_ud,
+    napi_value *payload_out) {
 
-    struct aws_mqtt5_client_binding *binding = user_data;
+    const struct aws_mqtt5_packet_publish_view *publish_view = &message_received_ud->publish_storage.storage_view;
 
-    struct mqtt5_transform_websocket_args *args =
-        aws_mem_calloc(binding->allocator, 1, sizeof(struct mqtt5_transform_websocket_args));
+    if (s_should_deliver_payload_as_string(message_received_ud->binding, publish_view)) {
+        struct aws_byte_buf *payload = message_received_ud->payload;
+        AWS_NAPI_CALL(
+            env,
+            napi_create_string_utf8(
+                env, payload->len > 0 ? (const char *)payload->buffer : "", payload->len, payload_out),
+            { return aws_raise_error(AWS_CRT_NODEJS_ERROR_NAPI_FAILURE); });
 
-    args->binding = s_aws_mqtt5_client_binding_acquire(binding);
-    args->allocator = binding->allocator;
-    args->request = request;
-    args->complete_fn = complete_fn;
-    args->complete_ctx = complete_ctx;
+        return AWS_OP_SUCCESS;
+    }
 
-    AWS_NAPI_ENSURE(NULL, aws_napi_queue_threadsafe_function(binding->transform_websocket, args));
+    if (aws_napi_create_binary_as_finalizable_external(env, message_received_ud->payload, payload_out)) {
+        return AWS_OP_ERR;
+    }
+    message_received_ud->payload = NULL;
+
+    return AWS_OP_SUCCESS;
 }
 
-/* Extracts all mqtt5 client configuration from a napi Mqtt5ClientConfig object */
-static int s_init_client_configuration_from_js_client_configuration(
+/* The JSON tape as an owning ArrayBuffer, a {message, offset} error object, or undefined if parsing was not requested */
+static int s_create_napi_json_result(
     napi_env env,
-    napi_value node_client_config,
-    struct aws_mqtt5_client_binding *binding,
-    struct aws_mqtt5_client_options *client_options,
-    struct aws_mqtt5_packet_connect_view *connect_options,
-    struct aws_mqtt5_packet_publish_view *will_options,
-    struct aws_mqtt5_client_topic_alias_options *topic_aliasing_options,
-    struct aws_napi_mqtt5_client_creation_storage *options_storage) {
-
-    /* required config parameters */
-    PARSE_REQUIRED_NAPI_PROPERTY(
-        AWS_NAPI_KEY_HOST_NAME,
-        "s_init_client_configuration_from_js_client_configuration",
-        aws_napi_get_named_property_as_bytebuf(
-            env, node_client_config, AWS_NAPI_KEY_HOST_NAME, napi_string, &options_storage->host_name),
-        { client_options->host_name = aws_byte_cursor_from_buf(&options_storage->host_name); });
+    struct on_message_received_user_data *message_received_ud,
+    napi_value *json_result_out) {
 
-    PARSE_REQUIRED_NAPI_PROPERTY(
-        AWS_NAPI_KEY_PORT,
-        "s_init_client_configuration_from_js_client_configuration",
-        aws_napi_get_named_property_as_uint32(env, node_client_config, AWS_NAPI_KEY_PORT, &client_options->port),
-        {});
+    if (message_received_ud->json_tape != NULL) {
+        if (aws_napi_create_binary_as_finalizable_external(env, message_received_ud->json_tape, json_result_out)) {
+            return AWS_OP_ERR;
+        }
+        message_received_ud->json_tape = NULL;
 
-    /* optional config parameters */
-    uint32_t session_behavior = 0;
-    PARSE_OPTIONAL_NAPI_PROPERTY(
-        AWS_NAPI_KEY_SESSION_BEHAVIOR,
-        "s_init_client_configuration_from_js_client_configuration",
-        aws_napi_get_named_property_as_uint32(
-            env, node_client_config, AWS_NAPI_KEY_SESSION_BEHAVIOR, (uint32_t *)&session_behavior),
-        { client_options->session_behavior = (enum aws_mqtt5_client_session_behavior_type)session_behavior; });
+        return AWS_OP_SUCCESS;
+    }
 
-    uint32_t extended_validation_and_flow_control_behavior = 0;
-    PARSE_OPTIONAL_NAPI_PROPERTY(
-        AWS_NAPI_KEY_EXTENDED_VALIDATION_AND_FLOW_CONTROL_OPTIONS,
-        "s_init_client_configuration_from_js_client_configuration",
-        aws_napi_get_named_property_as_uint32(
-            env,
-            node_client_config,
-            AWS_NAPI_KEY_EXTENDED_VALIDATION_AND_FLOW_CONTROL_OPTIONS,
-            (uint32_t *)&extended_validation_and_flow_control_behavior),
-        {
-            client_options->extended_validation_and_flow_control_options =
-                (enum aws_mqtt5_extended_validation_and_flow_control_options)
-                    extended_validation_and_flow_control_behavior;
+    if (message_received_ud->has_json_error) {
+        napi_value json_error = NULL;
+        AWS_NAPI_CALL(env, napi_create_object(env, &json_error), {
+            return aws_raise_error(AWS_CRT_NODEJS_ERROR_NAPI_FAILURE);
         });
 
-    uint32_t offline_queue_behavior = 0;
-    PARSE_OPTIONAL_NAPI_PROPERTY(
-        AWS_NAPI_KEY_OFFLINE_QUEUE_BEHAVIOR,
-        "s_init_client_configuration_from_js_client_configuration",
-        aws_napi_get_named_property_as_uint32(
-            env, node_client_config, AWS_NAPI_KEY_OFFLINE_QUEUE_BEHAVIOR, (uint32_t *)&offline_queue_behavior),
-        {
-            client_options->offline_queue_behavior =
-                (enum aws_mqtt5_client_operation_queue_behavior_type)offline_queue_behavior;
-        });
+        const char *message = message_received_ud->json_error.message;
+        if (aws_napi_attach_object_property_string(
+                json_error, env, AWS_NAPI_KEY_MESSAGE, aws_byte_cursor_from_c_str(message)) ||
+            aws_napi_attach_object_property_u64(
+                json_error, env, AWS_NAPI_KEY_OFFSET, message_received_ud->json_error.offset)) {
+            return AWS_OP_ERR;
+        }
 
-    uint32_t retry_jitter_mode = 0;
-    PARSE_OPTIONAL_NAPI_PROPERTY(
-        AWS_NAPI_KEY_RETRY_JITTER_MODE,
-        "s_init_client_configuration_from_js_client_configuration",
-        aws_napi_get_named_property_as_uint32(
-            env, node_client_config, AWS_NAPI_KEY_RETRY_JITTER_MODE, (uint32_t *)&retry_jitter_mode),
-        { client_options->retry_jitter_mode = (enum aws_exponential_backoff_jitter_mode)retry_jitter_mode; });
+        *json_result_out = json_error;
 
-    PARSE_OPTIONAL_NAPI_PROPERTY(
-        AWS_NAPI_KEY_MIN_RECONNECT_DELAY_MS,
-        "s_init_client_configuration_from_js_client_configuration",
-        aws_napi_get_named_property_as_uint64(
-            env, node_client_config, AWS_NAPI_KEY_MIN_RECONNECT_DELAY_MS, &client_options->min_reconnect_delay_ms),
-        {});
+        return AWS_OP_SUCCESS;
+    }
 
-    PARSE_OPTIONAL_NAPI_PROPERTY(
-        AWS_NAPI_KEY_MAX_RECONNECT_DELAY_MS,
-        "s_init_client_configuration_from_js_client_configuration",
-        aws_napi_get_named_property_as_uint64(
-            env, node_client_config, AWS_NAPI_KEY_MAX_RECONNECT_DELAY_MS, &client_options->max_reconnect_delay_ms),
-        {});
+    AWS_NAPI_CALL(env, napi_get_undefined(env, json_result_out), {
+        return aws_raise_error(AWS_CRT_NODEJS_ERROR_NAPI_FAILURE);
+    });
 
-    PARSE_OPTIONAL_NAPI_PROPERTY(
-        AWS_NAPI_KEY_MIN_CONNECTED_TIME_TO_RESET_RECONNECT_DELAY_MS,
-        "s_init_client_configuration_from_js_client_configuration",
-        aws_napi_get_named_property_as_uint64(
-            env,
-            node_client_config,
-            AWS_NAPI_KEY_MIN_CONNECTED_TIME_TO_RESET_RECONNECT_DELAY_MS,
-            &client_options->min_connected_time_to_reset_reconnect_delay_ms),
-        {});
+    return AWS_OP_SUCCESS;
+}
 
-    PARSE_OPTIONAL_NAPI_PROPERTY(
-        AWS_NAPI_KEY_PING_TIMEOUT_MS,
-        "s_init_client_configuration_from_js_client_configuration",
-        aws_napi_get_named_property_as_uint32(
-            env, node_client_config, AWS_NAPI_KEY_PING_TIMEOUT_MS, &client_options->ping_timeout_ms),
-        {});
+/* in-node/libuv-thread function to trigger the emission of a PUBLISH packet on the messageReceived event */
+static void s_napi_on_message_received(napi_env env, napi_value function, void *context, void *user_data) {
+    (void)context;
 
-    PARSE_OPTIONAL_NAPI_PROPERTY(
-        AWS_NAPI_KEY_CONNACK_TIMEOUT_MS,
-        "s_init_client_configuration_from_js_client_configuration",
-        aws_napi_get_named_property_as_uint32(
-            env, node_client_config, AWS_NAPI_KEY_CONNACK_TIMEOUT_MS, &client_options->connack_timeout_ms),
-        {});
+    struct on_message_received_user_data *on_message_received_ud = s_delivery_lanes_pop(user_data);
+    struct aws_mqtt5_client_binding *binding = on_message_received_ud->binding;
 
-    PARSE_OPTIONAL_NAPI_PROPERTY(
-        AWS_NAPI_KEY_CONNACK_TIMEOUT_MS,
-        "s_init_client_configuration_from_js_client_configuration",
-        aws_napi_get_named_property_as_uint32(
-            env, node_client_config, AWS_NAPI_KEY_ACK_TIMEOUT_SECONDS, &client_options->ack_timeout_seconds),
-        {});
+    if (env) {
+        /*
+         * client, then either the publish object or (record buffer, record size, payload), then the JSON result if
+         * the payload was parsed
+         */
+        napi_value params[5];
+        const size_t num_params = AWS_ARRAY_SIZE(params);
+        bool has_json_result = on_message_received_ud->json_tape != NULL || on_message_received_ud->has_json_error;
 
-    napi_value napi_value_connect = NULL;
-    if (AWS_NGNPR_VALID_VALUE ==
-        aws_napi_get_named_property(
-            env, node_client_config, AWS_NAPI_KEY_CONNECT_PROPERTIES, napi_object, &napi_value_connect)) {
-        if (s_init_connect_options_from_napi(
-                binding, env, napi_value_connect, connect_options, will_options, &options_storage->connect_storage)) {
-            AWS_LOGF_ERROR(
+        /*
+         * If we can't resolve the weak ref to the mqtt5 client, then it's been garbage collected and we should not
+         * do anything.
+         */
+        params[0] = NULL;
+        if (napi_get_reference_value(env, binding->node_mqtt5_client_ref, &params[0]) != napi_ok || params[0] == NULL) {
+            AWS_LOGF_INFO(
                 AWS_LS_NODEJS_CRT_GENERAL,
-                "s_init_client_configuration_from_js_client_configuration - failed to destructure connect properties");
-            return AWS_OP_ERR;
+                "id=%p s_napi_on_message_received - mqtt5_client node wrapper no longer resolvable",
+                (void *)binding->client);
+            goto done;
         }
-    }
 
-    napi_value napi_value_topic_aliasing_options = NULL;
-    if (AWS_NGNPR_VALID_VALUE == aws_napi_get_named_property(
-                                     env,
-                                     node_client_config,
-                                     AWS_NAPI_KEY_TOPIC_ALIASING_OPTIONS,
-                                     napi_object,
-                                     &napi_value_topic_aliasing_options)) {
-        if (s_init_topic_aliasing_options_from_napi(
-                binding, env, napi_value_topic_aliasing_options, topic_aliasing_options)) {
+        if (binding->binary_publish_encoding) {
+            size_t record_size = 0;
+            if (s_encode_publish_record(binding, env, on_message_received_ud, &params[1], &record_size) ||
+                s_create_napi_publish_payload(env, on_message_received_ud, &params[3])) {
+                AWS_LOGF_ERROR(
+                    AWS_LS_NODEJS_CRT_GENERAL,
+                    "id=%p s_napi_on_message_received - failed to encode publish record",
+                    (void *)binding->client);
+                goto done;
+            }
+
+            AWS_NAPI_CALL(env, napi_create_uint32(env, (uint32_t)record_size, &params[2]), { goto done; });
+
+            if (s_create_napi_json_result(env, on_message_received_ud, &params[4])) {
+                goto done;
+            }
+
+            AWS_NAPI_ENSURE(
+                env,
+                aws_napi_dispatch_threadsafe_function(
+                    env, binding->on_message_received, NULL, function, num_params, params));
+            goto done;
+        }
+
+        if (s_create_napi_publish_packet(env, on_message_received_ud, &params[1])) {
             AWS_LOGF_ERROR(
                 AWS_LS_NODEJS_CRT_GENERAL,
-                "s_init_client_configuration_from_js_client_configuration - failed to destructure topic aliasing "
-                "properties");
-            return AWS_OP_ERR;
+                "id=%p s_napi_on_message_received - failed to create publish object",
+                (void *)binding->client);
+            goto done;
         }
 
-        client_options->topic_aliasing_options = topic_aliasing_options;
+        if (has_json_result) {
+            AWS_NAPI_CALL(env, napi_get_undefined(env, &params[2]), { goto done; });
+            params[3] = params[2];
+
+            if (s_create_napi_json_result(env, on_message_received_ud, &params[4])) {
+                goto done;
+            }
+        }
+
+        AWS_NAPI_ENSURE(
+            env,
+            aws_napi_dispatch_threadsafe_function(
+                env, binding->on_message_received, NULL, function, has_json_result ? num_params : 2, params));
     }
 
-    napi_value node_transform_websocket = NULL;
-    if (AWS_NGNPR_VALID_VALUE == aws_napi_get_named_property(
-                                     env,
-                                     node_client_config,
-                                     AWS_NAPI_KEY_WEBSOCKET_HANDSHAKE_TRANSFORM,
-                                     napi_function,
-                                     &node_transform_websocket)) {
-        if (!aws_napi_is_null_or_undefined(env, node_transform_websocket)) {
-            AWS_NAPI_CALL(
-                env,
-                aws_napi_create_threadsafe_function(
-                    env,
-                    node_transform_websocket,
-                    "aws_mqtt5_client_transform_websocket",
-                    s_napi_mqtt5_transform_websocket,
-                    binding,
-                    &binding->transform_websocket),
-                { return aws_raise_error(AWS_CRT_NODEJS_ERROR_NAPI_FAILURE); });
+done:
+
+    if (on_message_received_ud->is_owned_by_packet) {
+        /*
+         * The lazy packet keeps the message storage alive, but neither flow control nor the client binding should
+         * wait on the garbage collector.
+         */
+        s_on_message_received_user_data_release_flow_control(on_message_received_ud);
+        on_message_received_ud->binding = s_aws_mqtt5_client_binding_release(on_message_received_ud->binding);
+    } else {
+        s_on_message_received_user_data_destroy(on_message_received_ud);
+    }
+}
+
+/*
+ * Persistent storage for user properties.
+ */
+struct aws_napi_mqtt5_user_property_storage {
+    struct aws_array_list user_properties;
+    struct aws_byte_buf user_property_storage;
+};
+
+/* Extract a set of user properties from a Napi object. */
+static int s_aws_mqtt5_user_properties_extract_from_js_object(
+    struct aws_mqtt5_client_binding *binding,
+    struct aws_napi_mqtt5_user_property_storage *user_properties_storage,
+    napi_env env,
+    napi_value node_container,
+    size_t *user_property_count_out,
+    const struct aws_mqtt5_user_property **user_properties_out) {
+
+    napi_value node_user_properties = NULL;
+    enum aws_napi_get_named_property_result gpr = aws_napi_get_named_property(
+        env, node_container, AWS_NAPI_KEY_USER_PROPERTIES, napi_object, &node_user_properties);
+    if (gpr != AWS_NGNPR_VALID_VALUE) {
+        return (gpr == AWS_NGNPR_NO_VALUE) ? AWS_OP_SUCCESS : AWS_OP_ERR;
+    }
+
+    if (aws_napi_is_null_or_undefined(env, node_user_properties)) {
+        return AWS_OP_SUCCESS;
+    }
+
+    struct aws_allocator *allocator = aws_napi_get_allocator();
+
+    /* len of js array */
+    uint32_t user_property_count = 0;
+    AWS_NAPI_CALL(env, napi_get_array_length(env, node_user_properties, &user_property_count), {
+        AWS_LOGF_ERROR(
+            AWS_LS_NODEJS_CRT_GENERAL,
+            "id=%p s_aws_mqtt5_user_properties_extract_from_js_object - user properties is not an array",
+            (void *)binding->client);
+        return aws_raise_error(AWS_ERROR_INVALID_ARGUMENT);
+    });
+
+    /* compute storage size */
+    size_t total_property_length = 0;
+    for (uint32_t i = 0; i < user_property_count; ++i) {
+        napi_value array_element;
+        AWS_NAPI_CALL(env, napi_get_element(env, node_user_properties, i, &array_element), {
+            AWS_LOGF_ERROR(
+                AWS_LS_NODEJS_CRT_GENERAL,
+                "id=%p s_aws_mqtt5_user_properties_extract_from_js_object - user properties is not indexable",
+                (void *)binding->client);
+            return aws_raise_error(AWS_CRT_NODEJS_ERROR_NAPI_FAILURE);
+        });
+
+        struct aws_byte_buf name_buf;
+        AWS_ZERO_STRUCT(name_buf);
+        struct aws_byte_buf value_buf;
+        AWS_ZERO_STRUCT(value_buf);
+
+        enum aws_napi_get_named_property_result name_gpr =
+            aws_napi_get_named_property_as_bytebuf(env, array_element, AWS_NAPI_KEY_NAME, napi_string, &name_buf);
+        enum aws_napi_get_named_property_result value_gpr =
+            aws_napi_get_named_property_as_bytebuf(env, array_element, AWS_NAPI_KEY_VALUE, napi_string, &value_buf);
+
+        total_property_length += name_buf.len + value_buf.len;
+
+        aws_byte_buf_clean_up(&name_buf);
+        aws_byte_buf_clean_up(&value_buf);
+
+        if (name_gpr != AWS_NGNPR_VALID_VALUE || value_gpr != AWS_NGNPR_VALID_VALUE) {
+            AWS_LOGF_ERROR(
+                AWS_LS_NODEJS_CRT_GENERAL,
+                "id=%p s_aws_mqtt5_user_properties_extract_from_js_object - malformed property name/value pair",
+                (void *)binding->client);
+            return aws_raise_error(AWS_ERROR_INVALID_ARGUMENT);
+        }
+    }
+
+    /* allocate space */
+    if (aws_array_list_init_dynamic(
+            &user_properties_storage->user_properties,
+            allocator,
+            user_property_count,
+            sizeof(struct aws_mqtt5_user_property))) {
+        return AWS_OP_ERR;
+    }
+
+    if (aws_byte_buf_init(&user_properties_storage->user_property_storage, allocator, total_property_length)) {
+        return AWS_OP_ERR;
+    }
+
+    /* persist each property */
+    for (uint32_t i = 0; i < user_property_count; ++i) {
+        napi_value array_element;
+        AWS_NAPI_CALL(env, napi_get_element(env, node_user_properties, i, &array_element), {
+            return aws_raise_error(AWS_CRT_NODEJS_ERROR_NAPI_FAILURE);
+        });
+
+        struct aws_byte_buf name_buf;
+        AWS_ZERO_STRUCT(name_buf);
+        struct aws_byte_buf value_buf;
+        AWS_ZERO_STRUCT(value_buf);
+
+        aws_napi_get_named_property_as_bytebuf(env, array_element, AWS_NAPI_KEY_NAME, napi_string, &name_buf);
+        aws_napi_get_named_property_as_bytebuf(env, array_element, AWS_NAPI_KEY_VALUE, napi_string, &value_buf);
+
+        struct aws_mqtt5_user_property user_property;
+        AWS_ZERO_STRUCT(user_property);
+
+        user_property.name = aws_byte_cursor_from_buf(&name_buf);
+        user_property.value = aws_byte_cursor_from_buf(&value_buf);
+
+        bool success =
+            aws_byte_buf_append_and_update(&user_properties_storage->user_property_storage, &user_property.name) ==
+                AWS_OP_SUCCESS &&
+            aws_byte_buf_append_and_update(&user_properties_storage->user_property_storage, &user_property.value) ==
+                AWS_OP_SUCCESS;
+
+        aws_byte_buf_clean_up(&name_buf);
+        aws_byte_buf_clean_up(&value_buf);
+
+        if (!success) {
+            return AWS_OP_ERR;
+        }
+
+        aws_array_list_push_back(&user_properties_storage->user_properties, &user_property);
+    }
+
+    *user_property_count_out = user_property_count;
+    *user_properties_out = user_properties_storage->user_properties.data;
+
+    return AWS_OP_SUCCESS;
+}
+
+static void s_aws_mqtt5_user_properties_clean_up(struct aws_napi_mqtt5_user_property_storage *user_properties_storage) {
+    aws_array_list_clean_up(&user_properties_storage->user_properties);
+    aws_byte_buf_clean_up(&user_properties_storage->user_property_storage);
+}
+
+/*
+ * Persistent storage for a publish packet.
+ */
+struct aws_napi_mqtt5_publish_storage {
+    struct aws_byte_buf topic;
+    struct aws_byte_buf payload;
+
+    enum aws_mqtt5_payload_format_indicator payload_format;
+    uint32_t message_expiry_interval_seconds;
+    uint16_t topic_alias;
+
+    struct aws_byte_buf response_topic;
+    struct aws_byte_cursor response_topic_cursor;
+
+    struct aws_byte_buf correlation_data;
+    struct aws_byte_cursor correlation_data_cursor;
+
+    struct aws_byte_buf content_type;
+    struct aws_byte_cursor content_type_cursor;
+
+    struct aws_napi_mqtt5_user_property_storage user_properties;
+};
+
+static void s_aws_napi_mqtt5_publish_storage_clean_up(struct aws_napi_mqtt5_publish_storage *storage) {
+    aws_byte_buf_clean_up(&storage->topic);
+    aws_byte_buf_clean_up(&storage->payload);
+    aws_byte_buf_clean_up(&storage->response_topic);
+    aws_byte_buf_clean_up(&storage->correlation_data);
+    aws_byte_buf_clean_up(&storage->content_type);
+
+    s_aws_mqtt5_user_properties_clean_up(&storage->user_properties);
+}
+
+static void s_log_get_property_error(
+    void *context,
+    const char *function_name,
+    const char *message,
+    const char *property_name) {
+    AWS_LOGF_ERROR(AWS_LS_NODEJS_CRT_GENERAL, "id=%p %s - %s: %s", context, function_name, message, property_name);
+}
+
+#define PARSE_REQUIRED_NAPI_PROPERTY(property_name, function_name, call_expression, success_block)                     \
+    {                                                                                                                  \
+        enum aws_napi_get_named_property_result gpr = call_expression;                                                 \
+        if (gpr == AWS_NGNPR_VALID_VALUE) {                                                                            \
+            success_block;                                                                                             \
+        } else if (gpr == AWS_NGNPR_INVALID_VALUE) {                                                                   \
+            s_log_get_property_error(                                                                                  \
+                (void *)binding->client, function_name, "invalid value for property", property_name);                  \
+            return aws_raise_error(AWS_ERROR_INVALID_ARGUMENT);                                                        \
+        } else {                                                                                                       \
+            s_log_get_property_error(                                                                                  \
+                (void *)binding->client, function_name, "failed to extract required property", property_name);         \
+            return aws_raise_error(AWS_ERROR_INVALID_ARGUMENT);                                                        \
+        }                                                                                                              \
+    }
+
+#define PARSE_OPTIONAL_NAPI_PROPERTY(property_name, function_name, call_expression, success_block)                     \
+    {                                                                                                                  \
+        enum aws_napi_get_named_property_result gpr = call_expression;                                                 \
+        if (gpr == AWS_NGNPR_VALID_VALUE) {                                                                            \
+            success_block;                                                                                             \
+        } else if (gpr == AWS_NGNPR_INVALID_VALUE) {                                                                   \
+            s_log_get_property_error(                                                                                  \
+                (void *)binding->client, function_name, "invalid value for property", property_name);                  \
+            return aws_raise_error(AWS_ERROR_INVALID_ARGUMENT);                                                        \
+        }                                                                                                              \
+    }
+
+/* Extract a PUBLISH packet view from a Napi object (AwsMqtt5PacketPublish) and persist its data in storage. */
+static int s_init_publish_options_from_napi(
+    struct aws_mqtt5_client_binding *binding,
+    napi_env env,
+    napi_value node_publish_config,
+    struct aws_mqtt5_packet_publish_view *publish_options,
+    struct aws_napi_mqtt5_publish_storage *publish_storage) {
+
+    PARSE_REQUIRED_NAPI_PROPERTY(
+        AWS_NAPI_KEY_TOPIC_NAME,
+        "s_init_publish_options_from_napi",
+        aws_napi_get_named_property_as_bytebuf(
+            env, node_publish_config, AWS_NAPI_KEY_TOPIC_NAME, napi_string, &publish_storage->topic),
+        { publish_options->topic = aws_byte_cursor_from_buf(&publish_storage->topic); });
+
+    PARSE_OPTIONAL_NAPI_PROPERTY(
+        AWS_NAPI_KEY_PAYLOAD,
+        "s_init_publish_options_from_napi",
+        aws_napi_get_named_property_as_bytebuf(
+            env, node_publish_config, AWS_NAPI_KEY_PAYLOAD, napi_undefined, &publish_storage->payload),
+        { publish_options->payload = aws_byte_cursor_from_buf(&publish_storage->payload); });
+
+    uint32_t qos = 0;
+    PARSE_REQUIRED_NAPI_PROPERTY(
+        AWS_NAPI_KEY_QOS,
+        "s_init_publish_options_from_napi",
+        aws_napi_get_named_property_as_uint32(env, node_publish_config, AWS_NAPI_KEY_QOS, &qos),
+        { publish_options->qos = qos; });
+
+    PARSE_OPTIONAL_NAPI_PROPERTY(
+        AWS_NAPI_KEY_RETAIN,
+        "s_init_publish_options_from_napi",
+        aws_napi_get_named_property_as_boolean(env, node_publish_config, AWS_NAPI_KEY_RETAIN, &publish_options->retain),
+        {});
+
+    uint32_t payload_format = 0;
+    PARSE_OPTIONAL_NAPI_PROPERTY(
+        AWS_NAPI_KEY_PAYLOAD_FORMAT,
+        "s_init_publish_options_from_napi",
+        aws_napi_get_named_property_as_uint32(env, node_publish_config, AWS_NAPI_KEY_PAYLOAD_FORMAT, &payload_format),
+        {
+            publish_storage->payload_format = payload_format;
+            publish_options->payload_format = &publish_storage->payload_format;
+        });
+
+    PARSE_OPTIONAL_NAPI_PROPERTY(
+        AWS_NAPI_KEY_MESSAGE_EXPIRY_INTERVAL_SECONDS,
+        "s_init_publish_options_from_napi",
+        aws_napi_get_named_property_as_uint32(
+            env,
+            node_publish_config,
+            AWS_NAPI_KEY_MESSAGE_EXPIRY_INTERVAL_SECONDS,
+            &publish_storage->message_expiry_interval_seconds),
+        { publish_options->message_expiry_interval_seconds = &publish_storage->message_expiry_interval_seconds; });
+
+    PARSE_OPTIONAL_NAPI_PROPERTY(
+        AWS_NAPI_KEY_TOPIC_ALIAS,
+        "s_init_publish_options_from_napi",
+        aws_napi_get_named_property_as_uint16(
+            env, node_publish_config, AWS_NAPI_KEY_TOPIC_ALIAS, &publish_storage->topic_alias),
+        { publish_options->topic_alias = &publish_storage->topic_alias; });
+
+    PARSE_OPTIONAL_NAPI_PROPERTY(
+        AWS_NAPI_KEY_RESPONSE_TOPIC,
+        "s_init_publish_options_from_napi",
+        aws_napi_get_named_property_as_bytebuf(
+            env, node_publish_config, AWS_NAPI_KEY_RESPONSE_TOPIC, napi_string, &publish_storage->response_topic),
+        {
+            publish_storage->response_topic_cursor = aws_byte_cursor_from_buf(&publish_storage->response_topic);
+            publish_options->response_topic = &publish_storage->response_topic_cursor;
+        });
+
+    PARSE_OPTIONAL_NAPI_PROPERTY(
+        AWS_NAPI_KEY_CORRELATION_DATA,
+        "s_init_publish_options_from_napi",
+        aws_napi_get_named_property_as_bytebuf(
+            env,
+            node_publish_config,
+            AWS_NAPI_KEY_CORRELATION_DATA,
+            napi_undefined,
+            &publish_storage->correlation_data),
+        {
+            publish_storage->correlation_data_cursor = aws_byte_cursor_from_buf(&publish_storage->correlation_data);
+            publish_options->correlation_data = &publish_storage->correlation_data_cursor;
+        });
+
+    PARSE_OPTIONAL_NAPI_PROPERTY(
+        AWS_NAPI_KEY_CONTENT_TYPE,
+        "s_init_publish_options_from_napi",
+        aws_napi_get_named_property_as_bytebuf(
+            env, node_publish_config, AWS_NAPI_KEY_CONTENT_TYPE, napi_string, &publish_storage->content_type),
+        {
+            publish_storage->content_type_cursor = aws_byte_cursor_from_buf(&publish_storage->content_type);
+            publish_options->content_type = &publish_storage->content_type_cursor;
+        });
+
+    if (s_aws_mqtt5_user_properties_extract_from_js_object(
+            binding,
+            &publish_storage->user_properties,
+            env,
+            node_publish_config,
+            &publish_options->user_property_count,
+            &publish_options->user_properties)) {
+        AWS_LOGF_ERROR(
+            AWS_LS_NODEJS_CRT_GENERAL,
+            "id=%p s_init_publish_options_from_napi - failed to extract userProperties",
+            (void *)binding->client);
+        return AWS_OP_ERR;
+    }
+
+    return AWS_OP_SUCCESS;
+}
+
+/* Persistent storage for a CONNECT packet. */
+struct aws_napi_mqtt5_connect_storage {
+    struct aws_byte_buf client_id;
+    struct aws_byte_cursor client_id_cursor;
+
+    struct aws_byte_buf username;
+    struct aws_byte_cursor username_cursor;
+
+    struct aws_byte_buf password;
+    struct aws_byte_cursor password_cursor;
+
+    uint32_t session_expiry_interval_seconds;
+    uint8_t request_response_information;
+    uint8_t request_problem_information;
+    uint16_t receive_maximum;
+    uint32_t maximum_packet_size_bytes;
+    uint32_t will_delay_interval_seconds;
+
+    struct aws_napi_mqtt5_publish_storage will_storage;
+
+    struct aws_napi_mqtt5_user_property_storage user_properties;
+};
+
+static void s_aws_napi_mqtt5_connect_storage_clean_up(struct aws_napi_mqtt5_connect_storage *storage) {
+    aws_byte_buf_clean_up(&storage->client_id);
+    aws_byte_buf_clean_up(&storage->username);
+    aws_byte_buf_clean_up(&storage->password);
+
+    s_aws_napi_mqtt5_publish_storage_clean_up(&storage->will_storage);
+
+    s_aws_mqtt5_user_properties_clean_up(&storage->user_properties);
+}
+
+/* Extract a CONNECT packet view from a Napi object (AwsMqtt5PacketConnect) and persist its data in storage. */
+static int s_init_connect_options_from_napi(
+    struct aws_mqtt5_client_binding *binding,
+    napi_env env,
+    napi_value node_connect_config,
+    struct aws_mqtt5_packet_connect_view *connect_options,
+    struct aws_mqtt5_packet_publish_view *will_options,
+    struct aws_napi_mqtt5_connect_storage *connect_storage) {
+
+    PARSE_REQUIRED_NAPI_PROPERTY(
+        AWS_NAPI_KEY_KEEP_ALIVE_INTERVAL_SECONDS,
+        "s_init_connect_options_from_napi",
+        aws_napi_get_named_property_as_uint16(
+            env,
+            node_connect_config,
+            AWS_NAPI_KEY_KEEP_ALIVE_INTERVAL_SECONDS,
+            &connect_options->keep_alive_interval_seconds),
+        {});
+
+    PARSE_OPTIONAL_NAPI_PROPERTY(
+        AWS_NAPI_KEY_CLIENT_ID,
+        "s_init_connect_options_from_napi",
+        aws_napi_get_named_property_as_bytebuf(
+            env, node_connect_config, AWS_NAPI_KEY_CLIENT_ID, napi_string, &connect_storage->client_id),
+        { connect_options->client_id = aws_byte_cursor_from_buf(&connect_storage->client_id); });
+
+    PARSE_OPTIONAL_NAPI_PROPERTY(
+        AWS_NAPI_KEY_USERNAME,
+        "s_init_connect_options_from_napi",
+        aws_napi_get_named_property_as_bytebuf(
+            env, node_connect_config, AWS_NAPI_KEY_USERNAME, napi_string, &connect_storage->username),
+        {
+            connect_storage->username_cursor = aws_byte_cursor_from_buf(&connect_storage->username);
+            connect_options->username = &connect_storage->username_cursor;
+        });
+
+    PARSE_OPTIONAL_NAPI_PROPERTY(
+        AWS_NAPI_KEY_PASSWORD,
+        "s_init_connect_options_from_napi",
+        aws_napi_get_named_property_as_bytebuf(
+            env, node_connect_config, AWS_NAPI_KEY_PASSWORD, napi_undefined, &connect_storage->password),
+        {
+            connect_storage->password_cursor = aws_byte_cursor_from_buf(&connect_storage->password);
+            connect_options->password = &connect_storage->password_cursor;
+        });
+
+    PARSE_OPTIONAL_NAPI_PROPERTY(
+        AWS_NAPI_KEY_SESSION_EXPIRY_INTERVAL_SECONDS,
+        "s_init_connect_options_from_napi",
+        aws_napi_get_named_property_as_uint32(
+            env,
+            node_connect_config,
+            AWS_NAPI_KEY_SESSION_EXPIRY_INTERVAL_SECONDS,
+            &connect_storage->session_expiry_interval_seconds),
+        { connect_options->session_expiry_interval_seconds = &connect_storage->session_expiry_interval_seconds; });
+
+    PARSE_OPTIONAL_NAPI_PROPERTY(
+        AWS_NAPI_KEY_REQUEST_RESPONSE_INFORMATION,
+        "s_init_connect_options_from_napi",
+        aws_napi_get_named_property_boolean_as_uint8(
+            env,
+            node_connect_config,
+            AWS_NAPI_KEY_REQUEST_RESPONSE_INFORMATION,
+            &connect_storage->request_response_information),
+        { connect_options->request_response_information = &connect_storage->request_response_information; });
+
+    PARSE_OPTIONAL_NAPI_PROPERTY(
+        AWS_NAPI_KEY_REQUEST_PROBLEM_INFORMATION,
+        "s_init_connect_options_from_napi",
+        aws_napi_get_named_property_boolean_as_uint8(
+            env,
+            node_connect_config,
+            AWS_NAPI_KEY_REQUEST_PROBLEM_INFORMATION,
+            &connect_storage->request_problem_information),
+        { connect_options->request_problem_information = &connect_storage->request_problem_information; });
+
+    PARSE_OPTIONAL_NAPI_PROPERTY(
+        AWS_NAPI_KEY_RECEIVE_MAXIMUM,
+        "s_init_connect_options_from_napi",
+        aws_napi_get_named_property_as_uint16(
+            env, node_connect_config, AWS_NAPI_KEY_RECEIVE_MAXIMUM, &connect_storage->receive_maximum),
+        { connect_options->receive_maximum = &connect_storage->receive_maximum; });
+
+    PARSE_OPTIONAL_NAPI_PROPERTY(
+        AWS_NAPI_KEY_MAXIMUM_PACKET_SIZE_BYTES,
+        "s_init_connect_options_from_napi",
+        aws_napi_get_named_property_as_uint32(
+            env,
+            node_connect_config,
+            AWS_NAPI_KEY_MAXIMUM_PACKET_SIZE_BYTES,
+            &connect_storage->maximum_packet_size_bytes),
+        { connect_options->maximum_packet_size_bytes = &connect_storage->maximum_packet_size_bytes; });
+
+    PARSE_OPTIONAL_NAPI_PROPERTY(
+        AWS_NAPI_KEY_WILL_DELAY_INTERVAL_SECONDS,
+        "s_init_connect_options_from_napi",
+        aws_napi_get_named_property_as_uint32(
+            env,
+            node_connect_config,
+            AWS_NAPI_KEY_WILL_DELAY_INTERVAL_SECONDS,
+            &connect_storage->will_delay_interval_seconds),
+        { connect_options->will_delay_interval_seconds = &connect_storage->will_delay_interval_seconds; });
+
+    napi_value napi_will = NULL;
+    if (AWS_NGNPR_VALID_VALUE ==
+        aws_napi_get_named_property(env, node_connect_config, AWS_NAPI_KEY_WILL, napi_object, &napi_will)) {
+        if (!aws_napi_is_null_or_undefined(env, napi_will)) {
+            if (s_init_publish_options_from_napi(
+                    binding, env, napi_will, will_options, &connect_storage->will_storage)) {
+                AWS_LOGF_ERROR(
+                    AWS_LS_NODEJS_CRT_GENERAL,
+                    "s_init_connect_options_from_napi - failed to destructure will properties");
+                return AWS_OP_ERR;
+            }
+
+            connect_options->will = will_options;
+        }
+    }
+
+    if (s_aws_mqtt5_user_properties_extract_from_js_object(
+            binding,
+            &connect_storage->user_properties,
+            env,
+            node_connect_config,
+            &connect_options->user_property_count,
+            &connect_options->user_properties)) {
+        AWS_LOGF_ERROR(
+            AWS_LS_NODEJS_CRT_GENERAL, "s_init_connect_options_from_napi - failed to extract userProperties");
+        return AWS_OP_ERR;
+    }
+
+    return AWS_OP_SUCCESS;
+}
+
+/* Extract topic aliasing configuration from a node object */
+static int s_init_topic_aliasing_options_from_napi(
+    struct aws_mqtt5_client_binding *binding,
+    napi_env env,
+    napi_value node_topic_aliasing_config,
+    struct aws_mqtt5_client_topic_alias_options *topic_aliasing_options) {
+
+    uint32_t outbound_behavior = 0;
+    PARSE_OPTIONAL_NAPI_PROPERTY(
+        AWS_NAPI_KEY_OUTBOUND_BEHAVIOR,
+        "s_init_topic_aliasing_options_from_napi",
+        aws_napi_get_named_property_as_uint32(
+            env, node_topic_aliasing_config, AWS_NAPI_KEY_OUTBOUND_BEHAVIOR, (uint32_t *)&outbound_behavior),
+        {
+            topic_aliasing_options->outbound_topic_alias_behavior =
+                (enum aws_mqtt5_client_outbound_topic_alias_behavior_type)outbound_behavior;
+        });
+
+    PARSE_OPTIONAL_NAPI_PROPERTY(
+        AWS_NAPI_KEY_OUTBOUND_CACHE_MAX_SIZE,
+        "s_init_topic_aliasing_options_from_napi",
+        aws_napi_get_named_property_as_uint16(
+            env,
+            node_topic_aliasing_config,
+            AWS_NAPI_KEY_OUTBOUND_CACHE_MAX_SIZE,
+            &topic_aliasing_options->outbound_alias_cache_max_size),
+        {});
+
+    uint32_t inbound_behavior = 0;
+    PARSE_OPTIONAL_NAPI_PROPERTY(
+        AWS_NAPI_KEY_INBOUND_BEHAVIOR,
+        "s_init_topic_aliasing_options_from_napi",
+        aws_napi_get_named_property_as_uint32(
+            env, node_topic_aliasing_config, AWS_NAPI_KEY_INBOUND_BEHAVIOR, (uint32_t *)&inbound_behavior),
+        {
+            topic_aliasing_options->inbound_topic_alias_behavior =
+                (enum aws_mqtt5_client_inbound_topic_alias_behavior_type)inbound_behavior;
+        });
+
+    PARSE_OPTIONAL_NAPI_PROPERTY(
+        AWS_NAPI_KEY_INBOUND_CACHE_MAX_SIZE,
+        "s_init_topic_aliasing_options_from_napi",
+        aws_napi_get_named_property_as_uint16(
+            env,
+            node_topic_aliasing_config,
+            AWS_NAPI_KEY_INBOUND_CACHE_MAX_SIZE,
+            &topic_aliasing_options->inbound_alias_cache_size),
+        {});
+
+    return AWS_OP_SUCCESS;
+}
+
+/* Extract inbound flow control limits from a node object */
+static int s_init_inbound_flow_control_options_from_napi(
+    struct aws_mqtt5_client_binding *binding,
+    napi_env env,
+    napi_value node_inbound_flow_control_config) {
+
+    struct aws_napi_mqtt5_inbound_flow_control *flow_control = &binding->inbound_flow_control;
+
+    PARSE_OPTIONAL_NAPI_PROPERTY(
+        AWS_NAPI_KEY_MAX_PENDING_MESSAGE_COUNT,
+        "s_init_inbound_flow_control_options_from_napi",
+        aws_napi_get_named_property_as_uint64(
+            env,
+            node_inbound_flow_control_config,
+            AWS_NAPI_KEY_MAX_PENDING_MESSAGE_COUNT,
+            &flow_control->max_pending_message_count),
+        {});
+
+    PARSE_OPTIONAL_NAPI_PROPERTY(
+        AWS_NAPI_KEY_MAX_PENDING_MESSAGE_SIZE,
+        "s_init_inbound_flow_control_options_from_napi",
+        aws_napi_get_named_property_as_uint64(
+            env,
+            node_inbound_flow_control_config,
+            AWS_NAPI_KEY_MAX_PENDING_MESSAGE_SIZE,
+            &flow_control->max_pending_message_size),
+        {});
+
+    return AWS_OP_SUCCESS;
+}
+
+/* Extract the topic filters of JSON payload parsing from a node object */
+static int s_init_json_payload_options_from_napi(
+    struct aws_mqtt5_client_binding *binding,
+    napi_env env,
+    napi_value node_json_payload_options) {
+
+    napi_value node_topic_filters = NULL;
+    PARSE_REQUIRED_NAPI_PROPERTY(
+        AWS_NAPI_KEY_TOPIC_FILTERS,
+        "s_init_json_payload_options_from_napi",
+        aws_napi_get_named_property(
+            env, node_json_payload_options, AWS_NAPI_KEY_TOPIC_FILTERS, napi_object, &node_topic_filters),
+        {});
+
+    uint32_t filter_count = 0;
+    AWS_NAPI_CALL(env, napi_get_array_length(env, node_topic_filters, &filter_count), {
+        s_log_get_property_error(
+            (void *)binding->client,
+            "s_init_json_payload_options_from_napi",
+            "invalid value for property",
+            AWS_NAPI_KEY_TOPIC_FILTERS);
+        return aws_raise_error(AWS_ERROR_INVALID_ARGUMENT);
+    });
+
+    if (aws_array_list_init_dynamic(
+            &binding->json_payload_topic_filters, binding->allocator, filter_count, sizeof(struct aws_byte_buf))) {
+        return AWS_OP_ERR;
+    }
+
+    for (uint32_t i = 0; i < filter_count; ++i) {
+        napi_value node_topic_filter = NULL;
+        AWS_NAPI_CALL(env, napi_get_element(env, node_topic_filters, i, &node_topic_filter), {
+            return aws_raise_error(AWS_CRT_NODEJS_ERROR_NAPI_FAILURE);
+        });
+
+        /* aws_byte_buf_init_from_napi would also accept binary data */
+        napi_valuetype type = napi_undefined;
+        AWS_NAPI_CALL(env, napi_typeof(env, node_topic_filter, &type), {
+            return aws_raise_error(AWS_CRT_NODEJS_ERROR_NAPI_FAILURE);
+        });
+
+        if (type != napi_string) {
+            s_log_get_property_error(
+                (void *)binding->client,
+                "s_init_json_payload_options_from_napi",
+                "non-string entry in property",
+                AWS_NAPI_KEY_TOPIC_FILTERS);
+            return aws_raise_error(AWS_ERROR_INVALID_ARGUMENT);
+        }
+
+        struct aws_byte_buf topic_filter;
+        AWS_NAPI_CALL(env, aws_byte_buf_init_from_napi(&topic_filter, env, node_topic_filter), {
+            s_log_get_property_error(
+                (void *)binding->client,
+                "s_init_json_payload_options_from_napi",
+                "invalid value for property",
+                AWS_NAPI_KEY_TOPIC_FILTERS);
+            return aws_raise_error(AWS_ERROR_INVALID_ARGUMENT);
+        });
+
+        /* pushed first so that the binding cleans it up if validation fails */
+        aws_array_list_push_back(&binding->json_payload_topic_filters, &topic_filter);
+
+        struct aws_byte_cursor topic_filter_cursor = aws_byte_cursor_from_buf(&topic_filter);
+        if (!aws_mqtt_is_valid_topic_filter(&topic_filter_cursor)) {
+            AWS_LOGF_ERROR(
+                AWS_LS_NODEJS_CRT_GENERAL,
+                "id=%p s_init_json_payload_options_from_napi - invalid topic filter %" PRIu32,
+                (void *)binding->client,
+                i);
+            return aws_raise_error(AWS_ERROR_INVALID_ARGUMENT);
+        }
+    }
+
+    return AWS_OP_SUCCESS;
+}
+
+/* Extract delivery priority rules from a node object */
+static int s_init_delivery_priority_options_from_napi(
+    struct aws_mqtt5_client_binding *binding,
+    napi_env env,
+    napi_value node_delivery_priority_options) {
+
+    struct aws_napi_mqtt5_delivery_lanes *delivery_lanes = &binding->delivery_lanes;
+
+    napi_value node_rules = NULL;
+    PARSE_REQUIRED_NAPI_PROPERTY(
+        AWS_NAPI_KEY_RULES,
+        "s_init_delivery_priority_options_from_napi",
+        aws_napi_get_named_property(env, node_delivery_priority_options, AWS_NAPI_KEY_RULES, napi_object, &node_rules),
+        {});
+
+    uint32_t rule_count = 0;
+    AWS_NAPI_CALL(env, napi_get_array_length(env, node_rules, &rule_count), {
+        s_log_get_property_error(
+            (void *)binding->client,
+            "s_init_delivery_priority_options_from_napi",
+            "invalid value for property",
+            AWS_NAPI_KEY_RULES);
+        return aws_raise_error(AWS_ERROR_INVALID_ARGUMENT);
+    });
+
+    if (aws_array_list_init_dynamic(
+            &delivery_lanes->rules,
+            binding->allocator,
+            rule_count,
+            sizeof(struct aws_napi_mqtt5_delivery_priority_rule))) {
+        return AWS_OP_ERR;
+    }
+
+    for (uint32_t i = 0; i < rule_count; ++i) {
+        napi_value node_rule = NULL;
+        AWS_NAPI_CALL(env, napi_get_element(env, node_rules, i, &node_rule), {
+            return aws_raise_error(AWS_CRT_NODEJS_ERROR_NAPI_FAILURE);
+        });
+
+        struct aws_napi_mqtt5_delivery_priority_rule rule;
+        AWS_ZERO_STRUCT(rule);
+
+        /* pushed first so that the binding cleans it up if anything below fails */
+        aws_array_list_push_back(&delivery_lanes->rules, &rule);
+        struct aws_napi_mqtt5_delivery_priority_rule *stored_rule = NULL;
+        aws_array_list_get_at_ptr(&delivery_lanes->rules, (void **)&stored_rule, i);
+
+        PARSE_REQUIRED_NAPI_PROPERTY(
+            AWS_NAPI_KEY_TOPIC_FILTER,
+            "s_init_delivery_priority_options_from_napi",
+            aws_napi_get_named_property_as_bytebuf(
+                env, node_rule, AWS_NAPI_KEY_TOPIC_FILTER, napi_string, &stored_rule->topic_filter),
+            {});
+
+        PARSE_REQUIRED_NAPI_PROPERTY(
+            AWS_NAPI_KEY_PRIORITY,
+            "s_init_delivery_priority_options_from_napi",
+            aws_napi_get_named_property_as_uint32(env, node_rule, AWS_NAPI_KEY_PRIORITY, &stored_rule->priority),
+            {});
+
+        struct aws_byte_cursor topic_filter = aws_byte_cursor_from_buf(&stored_rule->topic_filter);
+        if (!aws_mqtt_is_valid_topic_filter(&topic_filter) ||
+            stored_rule->priority >= AWS_NAPI_MQTT5_DELIVERY_PRIORITY_COUNT) {
+            AWS_LOGF_ERROR(
+                AWS_LS_NODEJS_CRT_GENERAL,
+                "id=%p s_init_delivery_priority_options_from_napi - invalid delivery priority rule %" PRIu32,
+                (void *)binding->client,
+                i);
+            return aws_raise_error(AWS_ERROR_INVALID_ARGUMENT);
+        }
+    }
+
+    delivery_lanes->is_enabled = true;
+
+    return AWS_OP_SUCCESS;
+}
+
+/* Extract outbound publish scheduling options from a node object */
+static int s_init_outbound_priority_options_from_napi(
+    struct aws_mqtt5_client_binding *binding,
+    napi_env env,
+    napi_value node_outbound_priority_options) {
+
+    struct aws_napi_mqtt5_outbound_scheduler *scheduler = &binding->outbound_scheduler;
+
+    PARSE_OPTIONAL_NAPI_PROPERTY(
+        AWS_NAPI_KEY_MAX_IN_FLIGHT_PUBLISHES,
+        "s_init_outbound_priority_options_from_napi",
+        aws_napi_get_named_property_as_uint32(
+            env,
+            node_outbound_priority_options,
+            AWS_NAPI_KEY_MAX_IN_FLIGHT_PUBLISHES,
+            &scheduler->max_in_flight_publishes),
+        {});
+
+    if (scheduler->max_in_flight_publishes == 0) {
+        s_log_get_property_error(
+            (void *)binding->client,
+            "s_init_outbound_priority_options_from_napi",
+            "invalid value for property",
+            AWS_NAPI_KEY_MAX_IN_FLIGHT_PUBLISHES);
+        return aws_raise_error(AWS_ERROR_INVALID_ARGUMENT);
+    }
+
+    napi_value node_weights = NULL;
+    PARSE_OPTIONAL_NAPI_PROPERTY(
+        AWS_NAPI_KEY_WEIGHTS,
+        "s_init_outbound_priority_options_from_napi",
+        aws_napi_get_named_property(env, node_outbound_priority_options, AWS_NAPI_KEY_WEIGHTS, napi_object, &node_weights),
+        {});
+
+    if (node_weights != NULL) {
+        uint32_t weight_count = 0;
+        AWS_NAPI_CALL(env, napi_get_array_length(env, node_weights, &weight_count), { weight_count = 0; });
+
+        if (weight_count != AWS_NAPI_MQTT5_PUBLISH_PRIORITY_COUNT) {
+            s_log_get_property_error(
+                (void *)binding->client,
+                "s_init_outbound_priority_options_from_napi",
+                "invalid value for property",
+                AWS_NAPI_KEY_WEIGHTS);
+            return aws_raise_error(AWS_ERROR_INVALID_ARGUMENT);
+        }
+
+        for (uint32_t i = 0; i < AWS_NAPI_MQTT5_PUBLISH_PRIORITY_COUNT; ++i) {
+            napi_value node_weight = NULL;
+            uint32_t weight = 0;
+            AWS_NAPI_CALL(env, napi_get_element(env, node_weights, i, &node_weight), {
+                return aws_raise_error(AWS_CRT_NODEJS_ERROR_NAPI_FAILURE);
+            });
+            AWS_NAPI_CALL(env, napi_get_value_uint32(env, node_weight, &weight), { weight = 0; });
+
+            if (weight == 0) {
+                s_log_get_property_error(
+                    (void *)binding->client,
+                    "s_init_outbound_priority_options_from_napi",
+                    "invalid value for property",
+                    AWS_NAPI_KEY_WEIGHTS);
+                return aws_raise_error(AWS_ERROR_INVALID_ARGUMENT);
+            }
+
+            scheduler->classes[i].weight = weight;
+        }
+    }
+
+    scheduler->is_enabled = true;
+
+    return AWS_OP_SUCCESS;
+}
+
+/* Extract offline queue limits from a node object */
+static int s_init_offline_queue_limits_from_napi(
+    struct aws_mqtt5_client_binding *binding,
+    napi_env env,
+    napi_value node_offline_queue_limits) {
+
+    struct aws_napi_mqtt5_offline_queue *offline_queue = &binding->offline_queue;
+
+    PARSE_OPTIONAL_NAPI_PROPERTY(
+        AWS_NAPI_KEY_MAX_QUEUED_PUBLISH_COUNT,
+        "s_init_offline_queue_limits_from_napi",
+        aws_napi_get_named_property_as_uint64(
+            env, node_offline_queue_limits, AWS_NAPI_KEY_MAX_QUEUED_PUBLISH_COUNT, &offline_queue->max_publish_count),
+        {});
+
+    PARSE_OPTIONAL_NAPI_PROPERTY(
+        AWS_NAPI_KEY_MAX_QUEUED_PUBLISH_SIZE,
+        "s_init_offline_queue_limits_from_napi",
+        aws_napi_get_named_property_as_uint64(
+            env, node_offline_queue_limits, AWS_NAPI_KEY_MAX_QUEUED_PUBLISH_SIZE, &offline_queue->max_publish_size),
+        {});
+
+    uint32_t eviction_policy = AWS_NAPI_MQTT5_OQEP_OLDEST;
+    PARSE_OPTIONAL_NAPI_PROPERTY(
+        AWS_NAPI_KEY_EVICTION_POLICY,
+        "s_init_offline_queue_limits_from_napi",
+        aws_napi_get_named_property_as_uint32(
+            env, node_offline_queue_limits, AWS_NAPI_KEY_EVICTION_POLICY, &eviction_policy),
+        {});
+
+    if (eviction_policy > AWS_NAPI_MQTT5_OQEP_LOWEST_PRIORITY_FIRST) {
+        s_log_get_property_error(
+            (void *)binding->client,
+            "s_init_offline_queue_limits_from_napi",
+            "invalid value for property",
+            AWS_NAPI_KEY_EVICTION_POLICY);
+        return aws_raise_error(AWS_ERROR_INVALID_ARGUMENT);
+    }
+
+    offline_queue->eviction_policy = (enum aws_napi_mqtt5_offline_queue_eviction_policy)eviction_policy;
+    offline_queue->is_enabled = true;
+
+    return AWS_OP_SUCCESS;
+}
+
+/* Extract persistent queue configuration from a node object and open (recovering) the queue */
+static int s_init_persistent_queue_from_napi(
+    struct aws_mqtt5_client_binding *binding,
+    napi_env env,
+    napi_value node_persistent_queue_config) {
+
+    struct aws_napi_mqtt5_persistent_queue_options queue_options = {
+        .max_size = s_default_persistent_queue_max_size,
+        .segment_size = s_default_persistent_queue_segment_size,
+    };
+
+    struct aws_byte_buf directory;
+    AWS_ZERO_STRUCT(directory);
+
+    int result = AWS_OP_ERR;
+
+    if (aws_napi_get_named_property_as_bytebuf(
+            env, node_persistent_queue_config, AWS_NAPI_KEY_DIRECTORY, napi_string, &directory) !=
+        AWS_NGNPR_VALID_VALUE) {
+        s_log_get_property_error(
+            (void *)binding->client,
+            "s_init_persistent_queue_from_napi",
+            "failed to extract required property",
+            AWS_NAPI_KEY_DIRECTORY);
+        aws_raise_error(AWS_ERROR_INVALID_ARGUMENT);
+        goto done;
+    }
+    queue_options.directory = aws_byte_cursor_from_buf(&directory);
+
+    enum aws_napi_get_named_property_result gpr = aws_napi_get_named_property_as_uint64(
+        env, node_persistent_queue_config, AWS_NAPI_KEY_MAX_SIZE_BYTES, &queue_options.max_size);
+    if (gpr == AWS_NGNPR_INVALID_VALUE) {
+        s_log_get_property_error(
+            (void *)binding->client,
+            "s_init_persistent_queue_from_napi",
+            "invalid value for property",
+            AWS_NAPI_KEY_MAX_SIZE_BYTES);
+        aws_raise_error(AWS_ERROR_INVALID_ARGUMENT);
+        goto done;
+    }
+
+    gpr = aws_napi_get_named_property_as_uint64(
+        env, node_persistent_queue_config, AWS_NAPI_KEY_SEGMENT_SIZE_BYTES, &queue_options.segment_size);
+    if (gpr == AWS_NGNPR_INVALID_VALUE) {
+        s_log_get_property_error(
+            (void *)binding->client,
+            "s_init_persistent_queue_from_napi",
+            "invalid value for property",
+            AWS_NAPI_KEY_SEGMENT_SIZE_BYTES);
+        aws_raise_error(AWS_ERROR_INVALID_ARGUMENT);
+        goto done;
+    }
+
+    binding->persistent_queue = aws_napi_mqtt5_persistent_queue_new(binding->allocator, &queue_options);
+    if (binding->persistent_queue == NULL) {
+        AWS_LOGF_ERROR(
+            AWS_LS_NODEJS_CRT_GENERAL,
+            "s_init_persistent_queue_from_napi - failed to open persistent queue with error %s",
+            aws_error_debug_str(aws_last_error()));
+        goto done;
+    }
+
+    result = AWS_OP_SUCCESS;
+
+done:
+
+    aws_byte_buf_clean_up(&directory);
+
+    return result;
+}
+
+/*
+ * Persistent storage for mqtt5 client options
+ */
+struct aws_napi_mqtt5_client_creation_storage {
+    struct aws_byte_buf host_name;
+
+    struct aws_napi_mqtt5_connect_storage connect_storage;
+};
+
+static void s_aws_napi_mqtt5_client_creation_storage_clean_up(struct aws_napi_mqtt5_client_creation_storage *storage) {
+    aws_byte_buf_clean_up(&storage->host_name);
+
+    s_aws_napi_mqtt5_connect_storage_clean_up(&storage->connect_storage);
+}
+
+/* persistent storage for all the data necessary to transform the websocket handshake */
+struct mqtt5_transform_websocket_args {
+    struct aws_allocator *allocator;
+    struct aws_mqtt5_client_binding *binding;
+
+    struct aws_http_message *request;
+
+    aws_mqtt5_transform_websocket_handshake_complete_fn *complete_fn;
+    void *complete_ctx;
+};
+
+static void s_mqtt5_transform_websocket_args_destroy(struct mqtt5_transform_websocket_args *args) {
+    if (args == NULL) {
+        return;
+    }
+
+    args->binding = s_aws_mqtt5_client_binding_release(args->binding);
+
+    aws_mem_release(args->allocator, args);
+}
+
+/* invoked from node once the JS handshake transform callback has completed */
+static napi_value s_napi_mqtt5_transform_websocket_complete(napi_env env, napi_callback_info cb_info) {
+
+    struct mqtt5_transform_websocket_args *args = NULL;
+    int error_code = AWS_ERROR_SUCCESS;
+
+    napi_value node_args[1];
+    size_t num_args = AWS_ARRAY_SIZE(node_args);
+    napi_value *arg = &node_args[0];
+    AWS_NAPI_CALL(env, napi_get_cb_info(env, cb_info, &num_args, node_args, NULL, (void **)&args), {
+        napi_throw_error(env, NULL, "mqtt5_transform_websocket_complete - Failed to retrieve callback information");
+        goto cleanup;
+    });
+    if (num_args > 1) {
+        napi_throw_error(env, NULL, "mqtt5_transform_websocket_complete - needs exactly 0 or 1 arguments");
+        goto cleanup;
+    }
+
+    napi_value node_error_code = *arg++;
+    /* If the user didn't provide an error_code, the napi_value will be undefined, so we can ignore it */
+    if (!aws_napi_is_null_or_undefined(env, node_error_code)) {
+        AWS_NAPI_CALL(env, napi_get_value_int32(env, node_error_code, &error_code), {
+            napi_throw_type_error(
+                env, NULL, "mqtt5_transform_websocket_complete - error_code must be a number or undefined");
+            goto cleanup;
+        });
+    }
+
+    args->complete_fn(args->request, error_code, args->complete_ctx);
+
+cleanup:
+
+    s_mqtt5_transform_websocket_args_destroy(args);
+
+    return NULL;
+}
+
+/* in-node/libuv-thread function to trigger websocket handshake transform callback */
+static void s_napi_mqtt5_transform_websocket(
+    napi_env env,
+    napi_value transform_websocket,
+    void *context,
+    void *user_data) {
+
+    (void)context;
+    struct mqtt5_transform_websocket_args *args = user_data;
+
+    if (env) {
+        napi_value params[2];
+        const size_t num_params = AWS_ARRAY_SIZE(params);
+
+        AWS_NAPI_ENSURE(env, aws_napi_http_message_wrap(env, args->request, &params[0]));
+        AWS_NAPI_ENSURE(
+            env,
+            napi_create_function(
+                env,
+                "mqtt5_transform_websocket_complete",
+                NAPI_AUTO_LENGTH,
+                &s_napi_mqtt5_transform_websocket_complete,
+                args,
+                &params[1]));
+
+        AWS_NAPI_ENSURE(
+            env,
+            aws_napi_dispatch_threadsafe_function(
+                env, args->binding->transform_websocket, NULL, transform_websocket, num_params, params));
+    } else {
+        args->complete_fn(args->request, AWS_CRT_NODEJS_ERROR_THREADSAFE_FUNCTION_NULL_NAPI_ENV, args->complete_ctx);
+
+        s_mqtt5_transform_websocket_args_destroy(args);
+    }
+}
+
+static void s_mqtt5_transform_websocket(
+    struct aws_http_message *request,
+    void *user_data,
+    aws_mqtt5_transform_websocket_handshake_complete_fn *complete_fn,
+    void *complete_ctx) {
+
+    struct aws_mqtt5_client_binding *binding = user_data;
+
+    struct mqtt5_transform_websocket_args *args =
+        aws_mem_calloc(binding->allocator, 1, sizeof(struct mqtt5_transform_websocket_args));
+
+    args->binding = s_aws_mqtt5_client_binding_acquire(binding);
+    args->allocator = binding->allocator;
+    args->request = request;
+    args->complete_fn = complete_fn;
+    args->complete_ctx = complete_ctx;
+
+    AWS_NAPI_ENSURE(NULL, aws_napi_queue_threadsafe_function(binding->transform_websocket, args));
+}
+
+static void s_mqtt5_sign_websocket(
+    struct aws_http_message *request,
+    void *user_data,
+    aws_mqtt5_transform_websocket_handshake_complete_fn *complete_fn,
+    void *complete_ctx) {
+
+    struct aws_napi_websocket_signer *signer = user_data;
+
+    aws_napi_websocket_signer_sign(signer, request, complete_fn, complete_ctx);
+}
+
+/* Extracts all mqtt5 client configuration from a napi Mqtt5ClientConfig object */
+static int s_init_client_configuration_from_js_client_configuration(
+    napi_env env,
+    napi_value node_client_config,
+    struct aws_mqtt5_client_binding *binding,
+    struct aws_mqtt5_client_options *client_options,
+    struct aws_mqtt5_packet_connect_view *connect_options,
+    struct aws_mqtt5_packet_publish_view *will_options,
+    struct aws_mqtt5_client_topic_alias_options *topic_aliasing_options,
+    struct aws_napi_mqtt5_client_creation_storage *options_storage) {
+
+    /* required config parameters */
+    PARSE_REQUIRED_NAPI_PROPERTY(
+        AWS_NAPI_KEY_HOST_NAME,
+        "s_init_client_configuration_from_js_client_configuration",
+        aws_napi_get_named_property_as_bytebuf(
+            env, node_client_config, AWS_NAPI_KEY_HOST_NAME, napi_string, &options_storage->host_name),
+        { client_options->host_name = aws_byte_cursor_from_buf(&options_storage->host_name); });
+
+    PARSE_REQUIRED_NAPI_PROPERTY(
+        AWS_NAPI_KEY_PORT,
+        "s_init_client_configuration_from_js_client_configuration",
+        aws_napi_get_named_property_as_uint32(env, node_client_config, AWS_NAPI_KEY_PORT, &client_options->port),
+        {});
+
+    /* optional config parameters */
+    uint32_t session_behavior = 0;
+    PARSE_OPTIONAL_NAPI_PROPERTY(
+        AWS_NAPI_KEY_SESSION_BEHAVIOR,
+        "s_init_client_configuration_from_js_client_configuration",
+        aws_napi_get_named_property_as_uint32(
+            env, node_client_config, AWS_NAPI_KEY_SESSION_BEHAVIOR, (uint32_t *)&session_behavior),
+        { client_options->session_behavior = (enum aws_mqtt5_client_session_behavior_type)session_behavior; });
+
+    uint32_t extended_validation_and_flow_control_behavior = 0;
+    PARSE_OPTIONAL_NAPI_PROPERTY(
+        AWS_NAPI_KEY_EXTENDED_VALIDATION_AND_FLOW_CONTROL_OPTIONS,
+        "s_init_client_configuration_from_js_client_configuration",
+        aws_napi_get_named_property_as_uint32(
+            env,
+            node_client_config,
+            AWS_NAPI_KEY_EXTENDED_VALIDATION_AND_FLOW_CONTROL_OPTIONS,
+            (uint32_t *)&extended_validation_and_flow_control_behavior),
+        {
+            client_options->extended_validation_and_flow_control_options =
+                (enum aws_mqtt5_extended_validation_and_flow_control_options)
+                    extended_validation_and_flow_control_behavior;
+        });
+
+    uint32_t offline_queue_behavior = 0;
+    PARSE_OPTIONAL_NAPI_PROPERTY(
+        AWS_NAPI_KEY_OFFLINE_QUEUE_BEHAVIOR,
+        "s_init_client_configuration_from_js_client_configuration",
+        aws_napi_get_named_property_as_uint32(
+            env, node_client_config, AWS_NAPI_KEY_OFFLINE_QUEUE_BEHAVIOR, (uint32_t *)&offline_queue_behavior),
+        {
+            client_options->offline_queue_behavior =
+                (enum aws_mqtt5_client_operation_queue_behavior_type)offline_queue_behavior;
+        });
+
+    uint32_t retry_jitter_mode = 0;
+    PARSE_OPTIONAL_NAPI_PROPERTY(
+        AWS_NAPI_KEY_RETRY_JITTER_MODE,
+        "s_init_client_configuration_from_js_client_configuration",
+        aws_napi_get_named_property_as_uint32(
+            env, node_client_config, AWS_NAPI_KEY_RETRY_JITTER_MODE, (uint32_t *)&retry_jitter_mode),
+        { client_options->retry_jitter_mode = (enum aws_exponential_backoff_jitter_mode)retry_jitter_mode; });
+
+    PARSE_OPTIONAL_NAPI_PROPERTY(
+        AWS_NAPI_KEY_MIN_RECONNECT_DELAY_MS,
+        "s_init_client_configuration_from_js_client_configuration",
+        aws_napi_get_named_property_as_uint64(
+            env, node_client_config, AWS_NAPI_KEY_MIN_RECONNECT_DELAY_MS, &client_options->min_reconnect_delay_ms),
+        {});
+
+    PARSE_OPTIONAL_NAPI_PROPERTY(
+        AWS_NAPI_KEY_MAX_RECONNECT_DELAY_MS,
+        "s_init_client_configuration_from_js_client_configuration",
+        aws_napi_get_named_property_as_uint64(
+            env, node_client_config, AWS_NAPI_KEY_MAX_RECONNECT_DELAY_MS, &client_options->max_reconnect_delay_ms),
+        {});
+
+    PARSE_OPTIONAL_NAPI_PROPERTY(
+        AWS_NAPI_KEY_MIN_CONNECTED_TIME_TO_RESET_RECONNECT_DELAY_MS,
+        "s_init_client_configuration_from_js_client_configuration",
+        aws_napi_get_named_property_as_uint64(
+            env,
+            node_client_config,
+            AWS_NAPI_KEY_MIN_CONNECTED_TIME_TO_RESET_RECONNECT_DELAY_MS,
+            &client_options->min_connected_time_to_reset_reconnect_delay_ms),
+        {});
+
+    PARSE_OPTIONAL_NAPI_PROPERTY(
+        AWS_NAPI_KEY_PING_TIMEOUT_MS,
+        "s_init_client_configuration_from_js_client_configuration",
+        aws_napi_get_named_property_as_uint32(
+            env, node_client_config, AWS_NAPI_KEY_PING_TIMEOUT_MS, &client_options->ping_timeout_ms),
+        {});
+
+    PARSE_OPTIONAL_NAPI_PROPERTY(
+        AWS_NAPI_KEY_CONNACK_TIMEOUT_MS,
+        "s_init_client_configuration_from_js_client_configuration",
+        aws_napi_get_named_property_as_uint32(
+            env, node_client_config, AWS_NAPI_KEY_CONNACK_TIMEOUT_MS, &client_options->connack_timeout_ms),
+        {});
+
+    PARSE_OPTIONAL_NAPI_PROPERTY(
+        AWS_NAPI_KEY_CONNACK_TIMEOUT_MS,
+        "s_init_client_configuration_from_js_client_configuration",
+        aws_napi_get_named_property_as_uint32(
+            env, node_client_config, AWS_NAPI_KEY_ACK_TIMEOUT_SECONDS, &client_options->ack_timeout_seconds),
+        {});
+
+    napi_value napi_value_connect = NULL;
+    if (AWS_NGNPR_VALID_VALUE ==
+        aws_napi_get_named_property(
+            env, node_client_config, AWS_NAPI_KEY_CONNECT_PROPERTIES, napi_object, &napi_value_connect)) {
+        if (s_init_connect_options_from_napi(
+                binding, env, napi_value_connect, connect_options, will_options, &options_storage->connect_storage)) {
+            AWS_LOGF_ERROR(
+                AWS_LS_NODEJS_CRT_GENERAL,
+                "s_init_client_configuration_from_js_client_configuration - failed to destructure connect properties");
+            return AWS_OP_ERR;
+        }
+    }
+
+    napi_value napi_value_topic_aliasing_options = NULL;
+    if (AWS_NGNPR_VALID_VALUE == aws_napi_get_named_property(
+                                     env,
+                                     node_client_config,
+                                     AWS_NAPI_KEY_TOPIC_ALIASING_OPTIONS,
+                                     napi_object,
+                                     &napi_value_topic_aliasing_options)) {
+        if (s_init_topic_aliasing_options_from_napi(
+                binding, env, napi_value_topic_aliasing_options, topic_aliasing_options)) {
+            AWS_LOGF_ERROR(
+                AWS_LS_NODEJS_CRT_GENERAL,
+                "s_init_client_configuration_from_js_client_configuration - failed to destructure topic aliasing "
+                "properties");
+            return AWS_OP_ERR;
+        }
+
+        client_options->topic_aliasing_options = topic_aliasing_options;
+    }
+
+    napi_value napi_value_inbound_flow_control_options = NULL;
+    if (AWS_NGNPR_VALID_VALUE == aws_napi_get_named_property(
+                                     env,
+                                     node_client_config,
+                                     AWS_NAPI_KEY_INBOUND_FLOW_CONTROL_OPTIONS,
+                                     napi_object,
+                                     &napi_value_inbound_flow_control_options)) {
+        if (s_init_inbound_flow_control_options_from_napi(binding, env, napi_value_inbound_flow_control_options)) {
+            AWS_LOGF_ERROR(
+                AWS_LS_NODEJS_CRT_GENERAL,
+                "s_init_client_configuration_from_js_client_configuration - failed to destructure inbound flow "
+                "control properties");
+            return AWS_OP_ERR;
+        }
+    }
+
+    napi_value napi_value_outbound_priority_options = NULL;
+    if (AWS_NGNPR_VALID_VALUE == aws_napi_get_named_property(
+                                     env,
+                                     node_client_config,
+                                     AWS_NAPI_KEY_OUTBOUND_PRIORITY_OPTIONS,
+                                     napi_object,
+                                     &napi_value_outbound_priority_options)) {
+        if (s_init_outbound_priority_options_from_napi(binding, env, napi_value_outbound_priority_options)) {
+            AWS_LOGF_ERROR(
+                AWS_LS_NODEJS_CRT_GENERAL,
+                "s_init_client_configuration_from_js_client_configuration - failed to destructure outbound priority "
+                "options");
+            return AWS_OP_ERR;
+        }
+    }
+
+    napi_value napi_value_json_payload_options = NULL;
+    if (AWS_NGNPR_VALID_VALUE == aws_napi_get_named_property(
+                                     env,
+                                     node_client_config,
+                                     AWS_NAPI_KEY_JSON_PAYLOAD_OPTIONS,
+                                     napi_object,
+                                     &napi_value_json_payload_options)) {
+        if (s_init_json_payload_options_from_napi(binding, env, napi_value_json_payload_options)) {
+            AWS_LOGF_ERROR(
+                AWS_LS_NODEJS_CRT_GENERAL,
+                "s_init_client_configuration_from_js_client_configuration - failed to destructure JSON payload "
+                "options");
+            return AWS_OP_ERR;
+        }
+    }
+
+    napi_value napi_value_delivery_priority_options = NULL;
+    if (AWS_NGNPR_VALID_VALUE == aws_napi_get_named_property(
+                                     env,
+                                     node_client_config,
+                                     AWS_NAPI_KEY_DELIVERY_PRIORITY_OPTIONS,
+                                     napi_object,
+                                     &napi_value_delivery_priority_options)) {
+        if (s_init_delivery_priority_options_from_napi(binding, env, napi_value_delivery_priority_options)) {
+            AWS_LOGF_ERROR(
+                AWS_LS_NODEJS_CRT_GENERAL,
+                "s_init_client_configuration_from_js_client_configuration - failed to destructure delivery priority "
+                "options");
+            return AWS_OP_ERR;
+        }
+    }
+
+    uint32_t utf8_payload_delivery = AWS_NAPI_MQTT5_UPD_BINARY;
+    PARSE_OPTIONAL_NAPI_PROPERTY(
+        AWS_NAPI_KEY_UTF8_PAYLOAD_DELIVERY,
+        "s_init_client_configuration_from_js_client_configuration",
+        aws_napi_get_named_property_as_uint32(
+            env, node_client_config, AWS_NAPI_KEY_UTF8_PAYLOAD_DELIVERY, &utf8_payload_delivery),
+        {});
+
+    if (utf8_payload_delivery > AWS_NAPI_MQTT5_UPD_ALWAYS_STRING) {
+        s_log_get_property_error(
+            (void *)binding->client,
+            "s_init_client_configuration_from_js_client_configuration",
+            "invalid value for property",
+            AWS_NAPI_KEY_UTF8_PAYLOAD_DELIVERY);
+        return aws_raise_error(AWS_ERROR_INVALID_ARGUMENT);
+    }
+    binding->utf8_payload_delivery = (enum aws_napi_mqtt5_utf8_payload_delivery)utf8_payload_delivery;
+
+    PARSE_OPTIONAL_NAPI_PROPERTY(
+        AWS_NAPI_KEY_LAZY_PUBLISH_PROPERTIES,
+        "s_init_client_configuration_from_js_client_configuration",
+        aws_napi_get_named_property_as_boolean(
+            env, node_client_config, AWS_NAPI_KEY_LAZY_PUBLISH_PROPERTIES, &binding->lazy_publish_properties),
+        {});
+
+    uint32_t topic_intern_cache_size = 0;
+    PARSE_OPTIONAL_NAPI_PROPERTY(
+        AWS_NAPI_KEY_TOPIC_INTERN_CACHE_SIZE,
+        "s_init_client_configuration_from_js_client_configuration",
+        aws_napi_get_named_property_as_uint32(
+            env, node_client_config, AWS_NAPI_KEY_TOPIC_INTERN_CACHE_SIZE, &topic_intern_cache_size),
+        {});
+
+    if (topic_intern_cache_size > 0) {
+        binding->topic_intern_cache =
+            aws_napi_mqtt_topic_intern_cache_new(binding->allocator, env, topic_intern_cache_size);
+        if (binding->topic_intern_cache == NULL) {
+            return AWS_OP_ERR;
+        }
+    }
+
+    PARSE_OPTIONAL_NAPI_PROPERTY(
+        AWS_NAPI_KEY_BINARY_PUBLISH_ENCODING,
+        "s_init_client_configuration_from_js_client_configuration",
+        aws_napi_get_named_property_as_boolean(
+            env, node_client_config, AWS_NAPI_KEY_BINARY_PUBLISH_ENCODING, &binding->binary_publish_encoding),
+        {});
+
+    if (binding->binary_publish_encoding && binding->lazy_publish_properties) {
+        AWS_LOGF_ERROR(
+            AWS_LS_NODEJS_CRT_GENERAL,
+            "s_init_client_configuration_from_js_client_configuration - binaryPublishEncoding and "
+            "lazyPublishProperties cannot both be enabled");
+        return aws_raise_error(AWS_ERROR_INVALID_ARGUMENT);
+    }
+
+    napi_value napi_value_offline_queue_limits = NULL;
+    if (AWS_NGNPR_VALID_VALUE == aws_napi_get_named_property(
+                                     env,
+                                     node_client_config,
+                                     AWS_NAPI_KEY_OFFLINE_QUEUE_LIMITS,
+                                     napi_object,
+                                     &napi_value_offline_queue_limits)) {
+        if (s_init_offline_queue_limits_from_napi(binding, env, napi_value_offline_queue_limits)) {
+            AWS_LOGF_ERROR(
+                AWS_LS_NODEJS_CRT_GENERAL,
+                "s_init_client_configuration_from_js_client_configuration - failed to destructure offline queue "
+                "limits properties");
+            return AWS_OP_ERR;
+        }
+    }
+
+    napi_value napi_value_persistent_queue_options = NULL;
+    if (AWS_NGNPR_VALID_VALUE == aws_napi_get_named_property(
+                                     env,
+                                     node_client_config,
+                                     AWS_NAPI_KEY_PERSISTENT_QUEUE_OPTIONS,
+                                     napi_object,
+                                     &napi_value_persistent_queue_options)) {
+        if (s_init_persistent_queue_from_napi(binding, env, napi_value_persistent_queue_options)) {
+            AWS_LOGF_ERROR(
+                AWS_LS_NODEJS_CRT_GENERAL,
+                "s_init_client_configuration_from_js_client_configuration - failed to initialize persistent queue");
+            return AWS_OP_ERR;
+        }
+    }
+
+    napi_value node_transform_websocket = NULL;
+    if (AWS_NGNPR_VALID_VALUE == aws_napi_get_named_property(
+                                     env,
+                                     node_client_config,
+                                     AWS_NAPI_KEY_WEBSOCKET_HANDSHAKE_TRANSFORM,
+                                     napi_function,
+                                     &node_transform_websocket)) {
+        if (!aws_napi_is_null_or_undefined(env, node_transform_websocket)) {
+            AWS_NAPI_CALL(
+                env,
+                aws_napi_create_threadsafe_function(
+                    env,
+                    node_transform_websocket,
+                    "aws_mqtt5_client_transform_websocket",
+                    s_napi_mqtt5_transform_websocket,
+                    binding,
+                    &binding->transform_websocket),
+                { return aws_raise_error(AWS_CRT_NODEJS_ERROR_NAPI_FAILURE); });
+
+            client_options->websocket_handshake_transform = s_mqtt5_transform_websocket;
+            client_options->websocket_handshake_transform_user_data = binding;
+        }
+    }
+
+    napi_value node_websocket_signing_config = NULL;
+    if (AWS_NGNPR_VALID_VALUE == aws_napi_get_named_property(
+                                     env,
+                                     node_client_config,
+                                     AWS_NAPI_KEY_WEBSOCKET_SIGNING_CONFIG,
+                                     napi_object,
+                                     &node_websocket_signing_config)) {
+        if (binding->transform_websocket != NULL) {
+            AWS_LOGF_ERROR(
+                AWS_LS_NODEJS_CRT_GENERAL,
+                "s_init_client_configuration_from_js_client_configuration - websocketSigningConfig and "
+                "websocketHandshakeTransform cannot both be set");
+            return aws_raise_error(AWS_ERROR_INVALID_ARGUMENT);
+        }
+
+        binding->websocket_signer =
+            aws_napi_websocket_signer_new_from_napi(binding->allocator, env, node_websocket_signing_config);
+        if (binding->websocket_signer == NULL) {
+            AWS_LOGF_ERROR(
+                AWS_LS_NODEJS_CRT_GENERAL,
+                "s_init_client_configuration_from_js_client_configuration - invalid websocketSigningConfig");
+            return aws_raise_error(AWS_ERROR_INVALID_ARGUMENT);
+        }
+
+        client_options->websocket_handshake_transform = s_mqtt5_sign_websocket;
+        client_options->websocket_handshake_transform_user_data = binding->websocket_signer;
+    }
+
+    return AWS_OP_SUCCESS;
+}
+
+static int s_init_event_handler_threadsafe_function(
+    napi_env env,
+    napi_value node_event_handler,
+    const char *threadsafe_name,
+    napi_threadsafe_function_call_js callback_function,
+    napi_threadsafe_function *function_out) {
+
+    AWS_FATAL_ASSERT(function_out != NULL && *function_out == NULL);
+
+    AWS_NAPI_CALL(
+        env,
+        aws_napi_create_threadsafe_function(
+            env, node_event_handler, threadsafe_name, callback_function, NULL, function_out),
+        { return aws_raise_error(AWS_ERROR_INVALID_ARGUMENT); });
+
+    return AWS_OP_SUCCESS;
+}
+
+/*
+ * Shared configuration defaults.  These are required parameters at the C level, but we make them optional and give
+ * them sensible defaults at the binding level.
+ */
+static const uint16_t s_default_mqtt_keep_alive_interval_seconds = 1200;
+
+static void s_init_default_mqtt5_client_options(
+    struct aws_mqtt5_client_options *client_options,
+    struct aws_mqtt5_packet_connect_view *connect_options) {
+
+    connect_options->keep_alive_interval_seconds = s_default_mqtt_keep_alive_interval_seconds;
+    client_options->connect_options = connect_options;
+}
+
+/*
+ * A replayed publish has no one to report a failure to, so it stays in the log if it failed only because the client
+ * went away or could not hold it while offline; it will be replayed the next time a client opens the queue.  Any
+ * other outcome is final.  Publishes made from node are always removed once their outcome has been reported.
+ */
+static bool s_should_acknowledge_replayed_publish(int error_code) {
+    return error_code != AWS_ERROR_MQTT5_CLIENT_TERMINATED &&
+           error_code != AWS_ERROR_MQTT5_OPERATION_FAILED_DUE_TO_OFFLINE_QUEUE_POLICY;
+}
+
+struct persisted_publish_replay_user_data {
+    struct aws_allocator *allocator;
+    struct aws_mqtt5_client_binding *binding;
+    uint64_t record_id;
+};
+
+static void s_on_replayed_publish_complete(
+    enum aws_mqtt5_packet_type packet_type,
+    const void *packet,
+    int error_code,
+    void *complete_ctx) {
+
+    (void)packet_type;
+    (void)packet;
+
+    struct persisted_publish_replay_user_data *replay_ud = complete_ctx;
+
+    if (s_should_acknowledge_replayed_publish(error_code)) {
+        aws_napi_mqtt5_persistent_queue_acknowledge(replay_ud->binding->persistent_queue, replay_ud->record_id);
+    }
+
+    replay_ud->binding = s_aws_mqtt5_client_binding_release(replay_ud->binding);
+    aws_mem_release(replay_ud->allocator, replay_ud);
+}
+
+/* Resubmits a publish recovered from a previous process's persistent queue; completion is native-only */
+static void s_replay_persisted_publish(
+    uint64_t record_id,
+    const struct aws_mqtt5_packet_publish_view *publish_view,
+    void *user_data) {
+
+    struct aws_mqtt5_client_binding *binding = user_data;
+
+    struct persisted_publish_replay_user_data *replay_ud =
+        aws_mem_calloc(binding->allocator, 1, sizeof(struct persisted_publish_replay_user_data));
+    replay_ud->allocator = binding->allocator;
+    replay_ud->binding = s_aws_mqtt5_client_binding_acquire(binding);
+    replay_ud->record_id = record_id;
+
+    struct aws_mqtt5_publish_completion_options completion_options = {
+        .completion_callback = s_on_replayed_publish_complete,
+        .completion_user_data = replay_ud,
+    };
+
+    if (aws_mqtt5_client_publish(binding->client, publish_view, &completion_options)) {
+        AWS_LOGF_ERROR(
+            AWS_LS_NODEJS_CRT_GENERAL,
+            "id=%p s_replay_persisted_publish - failed to resubmit persisted publish %" PRIu64 " with error %s",
+            (void *)binding->client,
+            record_id,
+            aws_error_debug_str(aws_last_error()));
+        replay_ud->binding = s_aws_mqtt5_client_binding_release(replay_ud->binding);
+        aws_mem_release(replay_ud->allocator, replay_ud);
+    }
+}
+
+napi_value aws_napi_mqtt5_client_new(napi_env env, napi_callback_info info) {
+
+    napi_value node_args[14];
+    size_t num_args = AWS_ARRAY_SIZE(node_args);
+    napi_value *arg = &node_args[0];
+    AWS_NAPI_CALL(env, napi_get_cb_info(env, info, &num_args, node_args, NULL, NULL), {
+        napi_throw_error(env, NULL, "mqtt5_client_new - Failed to retrieve arguments");
+        return NULL;
+    });
+
+    if (num_args != AWS_ARRAY_SIZE(node_args)) {
+        napi_throw_error(env, NULL, "mqtt5_client_new - needs exactly 14 arguments");
+        return NULL;
+    }
+
+    napi_value napi_client_wrapper = NULL;
+    napi_value node_external = NULL;
+    struct aws_allocator *allocator = aws_napi_get_allocator();
+
+    struct aws_mqtt5_client_binding *binding = aws_mem_calloc(allocator, 1, sizeof(struct aws_mqtt5_client_binding));
+    binding->allocator = allocator;
+    aws_ref_count_init(&binding->ref_count, binding, s_aws_mqtt5_client_binding_on_zero);
+
+    AWS_NAPI_CALL(env, napi_create_external(env, binding, s_aws_mqtt5_client_extern_finalize, NULL, &node_external), {
+        aws_mem_release(allocator, binding);
+        napi_throw_error(env, NULL, "mqtt5_client_new - Failed to create n-api external");
+        goto cleanup;
+    });
+
+    aws_atomic_init_int(&binding->inbound_flow_control.pending_message_count, 0);
+    aws_atomic_init_int(&binding->inbound_flow_control.pending_message_size, 0);
+    aws_atomic_init_int(&binding->inbound_flow_control.dropped_message_count, 0);
+
+    aws_mutex_init(&binding->delivery_lanes.lock);
+    for (size_t i = 0; i < AWS_NAPI_MQTT5_DELIVERY_PRIORITY_COUNT; ++i) {
+        aws_linked_list_init(&binding->delivery_lanes.lanes[i].pending);
+    }
+
+    aws_mutex_init(&binding->offline_queue.lock);
+    aws_linked_list_init(&binding->offline_queue.held_publishes);
+
+    aws_mutex_init(&binding->outbound_scheduler.lock);
+    binding->outbound_scheduler.max_in_flight_publishes = s_default_max_in_flight_publishes;
+    for (size_t i = 0; i < AWS_NAPI_MQTT5_PUBLISH_PRIORITY_COUNT; ++i) {
+        aws_linked_list_init(&binding->outbound_scheduler.classes[i].queued_publishes);
+        binding->outbound_scheduler.classes[i].weight = s_default_publish_priority_weights[i];
+    }
+
+    aws_mutex_init(&binding->message_ring_lock);
+
+    aws_atomic_init_int(&binding->is_response_routing_enabled, 0);
+    aws_mutex_init(&binding->response_router_lock);
+    aws_atomic_init_int(&binding->is_message_filter_enabled, 0);
+    aws_mutex_init(&binding->message_filter_lock);
+    aws_atomic_init_int(&binding->is_last_value_cache_enabled, 0);
+    aws_mutex_init(&binding->last_value_cache_lock);
+    aws_napi_live_statistics_init(&binding->live_statistics);
+    aws_byte_buf_init(&binding->publish_payload_scratch, allocator, 0);
+
+    AWS_FATAL_ASSERT(
+        aws_priority_queue_init_dynamic(
+            &binding->offline_queue.eviction_order,
+            allocator,
+            0,
+            sizeof(struct aws_napi_mqtt5_held_publish *),
+            s_compare_held_publish_eviction_order) == AWS_OP_SUCCESS);
+
+    struct aws_mqtt5_client_options client_options;
+    AWS_ZERO_STRUCT(client_options);
+
+    struct aws_mqtt5_packet_connect_view connect_options;
+    AWS_ZERO_STRUCT(connect_options);
+
+    struct aws_mqtt5_packet_publish_view will_options;
+    AWS_ZERO_STRUCT(will_options);
+
+    struct aws_mqtt5_client_topic_alias_options topic_aliasing_options;
+    AWS_ZERO_STRUCT(topic_aliasing_options);
+
+    struct aws_napi_mqtt5_client_creation_storage options_storage;
+    AWS_ZERO_STRUCT(options_storage);
+
+    s_init_default_mqtt5_client_options(&client_options, &connect_options);
+
+    /* Arg #1: the mqtt5 client */
+    napi_value node_client = *arg++;
+    if (aws_napi_is_null_or_undefined(env, node_client)) {
+        napi_throw_error(env, NULL, "mqtt5_client_new - Required client parameter is null");
+        goto cleanup;
+    }
+
+    AWS_NAPI_CALL(env, napi_create_reference(env, node_client, 1, &binding->node_mqtt5_client_ref), {
+        napi_throw_error(env, NULL, "mqtt5_client_new - Failed to create reference to node mqtt5 client");
+        goto cleanup;
+    });
+
+    /* Arg #2: the mqtt5 client config object */
+    napi_value node_client_config = *arg++;
+    if (aws_napi_is_null_or_undefined(env, node_client_config)) {
+        napi_throw_error(env, NULL, "mqtt5_client_new - Required configuration parameter is null");
+        goto cleanup;
+    }
+
+    if (s_init_client_configuration_from_js_client_configuration(
+            env,
+            node_client_config,
+            binding,
+            &client_options,
+            &connect_options,
+            &will_options,
+            &topic_aliasing_options,
+            &options_storage)) {
+        napi_throw_error(
+            env,
+            NULL,
+            "mqtt5_client_new - failed to initialize native client configuration from js client configuration");
+        goto cleanup;
+    }
+
+    /* Arg #3: on stopped event */
+    napi_value on_stopped_event_handler = *arg++;
+    if (aws_napi_is_null_or_undefined(env, on_stopped_event_handler)) {
+        napi_throw_error(env, NULL, "mqtt5_client_new - required on_stopped event handler is null");
+        goto cleanup;
+    }
+
+    if (s_init_event_handler_threadsafe_function(
+            env, on_stopped_event_handler, "aws_mqtt5_client_on_stopped", s_napi_on_stopped, &binding->on_stopped)) {
+        napi_throw_error(env, NULL, "mqtt5_client_new - failed to initialize on_stopped event handler");
+        goto cleanup;
+    }
+
+    /* Arg #4: on attempting connect event */
+    napi_value on_attempting_connect_event_handler = *arg++;
+    if (aws_napi_is_null_or_undefined(env, on_attempting_connect_event_handler)) {
+        napi_throw_error(env, NULL, "mqtt5_client_new - required on_attempting_connect event handler is null");
+        goto cleanup;
+    }
+
+    if (s_init_event_handler_threadsafe_function(
+            env,
+            on_attempting_connect_event_handler,
+            "aws_mqtt5_client_on_attempting_connect",
+            s_napi_on_attempting_connect,
+            &binding->on_attempting_connect)) {
+        napi_throw_error(env, NULL, "mqtt5_client_new - failed to initialize on_attempting_connect event handler");
+        goto cleanup;
+    }
+
+    /* Arg #5: on connection success event */
+    napi_value on_connection_success_event_handler = *arg++;
+    if (aws_napi_is_null_or_undefined(env, on_connection_success_event_handler)) {
+        napi_throw_error(env, NULL, "mqtt5_client_new - required on_connection_success event handler is null");
+        goto cleanup;
+    }
+
+    if (s_init_event_handler_threadsafe_function(
+            env,
+            on_connection_success_event_handler,
+            "aws_mqtt5_client_on_connection_success",
+            s_napi_on_connection_success,
+            &binding->on_connection_success)) {
+        napi_throw_error(env, NULL, "mqtt5_client_new - failed to initialize on_connection_success event handler");
+        goto cleanup;
+    }
+
+    /* Arg #6: on connection failure event */
+    napi_value on_connection_failure_event_handler = *arg++;
+    if (aws_napi_is_null_or_undefined(env, on_connection_failure_event_handler)) {
+        napi_throw_error(env, NULL, "mqtt5_client_new - required on_connection_failure event handler is null");
+        goto cleanup;
+    }
+
+    if (s_init_event_handler_threadsafe_function(
+            env,
+            on_connection_failure_event_handler,
+            "aws_mqtt5_client_on_connection_failure",
+            s_napi_on_connection_failure,
+            &binding->on_connection_failure)) {
+        napi_throw_error(env, NULL, "mqtt5_client_new - failed to initialize on_connection_failure event handler");
+        goto cleanup;
+    }
+
+    /* Arg #7: on disconnection event */
+    napi_value on_disconnection_event_handler = *arg++;
+    if (aws_napi_is_null_or_undefined(env, on_disconnection_event_handler)) {
+        napi_throw_error(env, NULL, "mqtt5_client_new - required on_disconnection event handler is null");
+        goto cleanup;
+    }
+
+    if (s_init_event_handler_threadsafe_function(
+            env,
+            on_disconnection_event_handler,
+            "aws_mqtt5_client_on_disconnection",
+            s_napi_on_disconnection,
+            &binding->on_disconnection)) {
+        napi_throw_error(env, NULL, "mqtt5_client_new - failed to initialize on_disconnection event handler");
+        goto cleanup;
+    }
+
+    /* Arg #8: on message received event */
+    napi_value on_message_received_event_handler = *arg++;
+    if (aws_napi_is_null_or_undefined(env, on_message_received_event_handler)) {
+        napi_throw_error(env, NULL, "mqtt5_client_new - required on_message_received event handler is null");
+        goto cleanup;
+    }
+
+    if (s_init_event_handler_threadsafe_function(
+            env,
+            on_message_received_event_handler,
+            "aws_mqtt5_client_on_message_received",
+            s_napi_on_message_received,
+            &binding->on_message_received)) {
+        napi_throw_error(env, NULL, "mqtt5_client_new - failed to initialize on_message_received event handler");
+        goto cleanup;
+    }
+
+    /* Arg #9: client bootstrap */
+    napi_value node_client_bootstrap = *arg++;
+    if (!aws_napi_is_null_or_undefined(env, node_client_bootstrap)) {
+        struct client_bootstrap_binding *client_bootstrap_binding = NULL;
+        napi_get_value_external(env, node_client_bootstrap, (void **)&client_bootstrap_binding);
+
+        client_options.bootstrap = aws_napi_get_client_bootstrap(client_bootstrap_binding);
+    }
+
+    if (client_options.bootstrap == NULL) {
+        client_options.bootstrap = aws_napi_get_default_client_bootstrap();
+    }
+
+    /* Arg #10: socket options */
+    napi_value node_socket_options = *arg++;
+    if (!aws_napi_is_null_or_undefined(env, node_socket_options)) {
+        AWS_NAPI_CALL(env, napi_get_value_external(env, node_socket_options, (void **)&client_options.socket_options), {
+            napi_throw_error(env, NULL, "mqtt5_client_new - Unable to extract socket_options from external");
+            goto cleanup;
+        });
+    }
+
+    /* Arg #11: tls options */
+    napi_value node_tls = *arg++;
+    if (!aws_napi_is_null_or_undefined(env, node_tls)) {
+        struct aws_tls_ctx *tls_ctx;
+        AWS_NAPI_CALL(env, napi_get_value_external(env, node_tls, (void **)&tls_ctx), {
+            napi_throw_error(env, NULL, "mqtt5_client_new - Failed to extract tls_ctx from external");
+            goto cleanup;
+        });
+
+        aws_tls_connection_options_init_from_ctx(&binding->tls_connection_options, tls_ctx);
+
+        client_options.tls_options = &binding->tls_connection_options;
+    }
+
+    /* Arg #12: http proxy options */
+    napi_value node_proxy_options = *arg++;
+    if (!aws_napi_is_null_or_undefined(env, node_proxy_options)) {
+        struct http_proxy_options_binding *proxy_binding = NULL;
+        AWS_NAPI_CALL(env, napi_get_value_external(env, node_proxy_options, (void **)&proxy_binding), {
+            napi_throw_type_error(env, NULL, "mqtt5_client_new - failed to extract http proxy options from external");
+            goto cleanup;
+        });
+        /* proxy_options are copied internally, no need to go nuts on copies */
+        client_options.http_proxy_options = aws_napi_get_http_proxy_options(proxy_binding);
+    }
+
+    /* Arg #13: shared message ring (a Uint8Array over a SharedArrayBuffer) */
+    napi_value node_message_ring = *arg++;
+
+    /* Arg #14: on message ring ready */
+    napi_value on_message_ring_ready_handler = *arg++;
+
+    if (!aws_napi_is_null_or_undefined(env, node_message_ring)) {
+        if (binding->lazy_publish_properties) {
+            napi_throw_error(
+                env, NULL, "mqtt5_client_new - a shared message ring cannot be combined with lazy publish properties");
+            goto cleanup;
+        }
+
+        napi_typedarray_type ring_array_type = napi_int8_array;
+        size_t ring_size = 0;
+        void *ring_memory = NULL;
+        AWS_NAPI_CALL(
+            env,
+            napi_get_typedarray_info(env, node_message_ring, &ring_array_type, &ring_size, &ring_memory, NULL, NULL),
+            {
+                napi_throw_type_error(env, NULL, "mqtt5_client_new - shared message ring must be a Uint8Array");
+                goto cleanup;
+            });
+
+        if (ring_array_type != napi_uint8_array ||
+            aws_napi_shared_ring_init(&binding->message_ring, ring_memory, ring_size)) {
+            napi_throw_error(env, NULL, "mqtt5_client_new - invalid shared message ring");
+            goto cleanup;
+        }
+
+        /* keeps the shared memory alive until the client is closed or collected */
+        AWS_NAPI_CALL(env, napi_create_reference(env, node_message_ring, 1, &binding->message_ring_ref), {
+            napi_throw_error(env, NULL, "mqtt5_client_new - Failed to create reference to shared message ring");
+            goto cleanup;
+        });
+
+        if (aws_napi_is_null_or_undefined(env, on_message_ring_ready_handler) ||
+            s_init_event_handler_threadsafe_function(
+                env,
+                on_message_ring_ready_handler,
+                "aws_mqtt5_client_on_message_ring_ready",
+                s_napi_on_message_ring_ready,
+                &binding->on_message_ring_ready)) {
+            napi_throw_error(env, NULL, "mqtt5_client_new - failed to initialize on_message_ring_ready handler");
+            goto cleanup;
+        }
+
+        binding->is_message_ring_enabled = true;
+    }
+
+    client_options.publish_received_handler = s_on_publish_received;
+    client_options.publish_received_handler_user_data = binding;
+
+    client_options.lifecycle_event_handler = s_lifecycle_event_callback;
+    client_options.lifecycle_event_handler_user_data = binding;
+
+    client_options.client_termination_handler = s_aws_mqtt5_client_binding_on_client_terminate;
+    client_options.client_termination_handler_user_data = binding;
+
+    binding->client = aws_mqtt5_client_new(allocator, &client_options);
+    if (binding->client == NULL) {
+        aws_napi_throw_last_error_with_context(env, "mqtt5_client_new - failed to create client");
+        goto cleanup;
+    }
+
+    AWS_NAPI_CALL(env, napi_create_reference(env, node_external, 1, &binding->node_client_external_ref), {
+        napi_throw_error(env, NULL, "mqtt5_client_new - Failed to create one count reference to napi external");
+        goto cleanup;
+    });
+
+    /* publishes left over from a previous process wait in the client's operation queue until it connects */
+    if (binding->persistent_queue != NULL) {
+        aws_napi_mqtt5_persistent_queue_replay(binding->persistent_queue, s_replay_persisted_publish, binding);
+    }
+
+    napi_client_wrapper = node_external;
+
+cleanup:
+
+    s_aws_napi_mqtt5_client_creation_storage_clean_up(&options_storage);
+
+    return napi_client_wrapper;
+}
+
+napi_value aws_napi_mqtt5_client_start(napi_env env, napi_callback_info info) {
+
+    napi_value node_args[1];
+    size_t num_args = AWS_ARRAY_SIZE(node_args);
+    napi_value *arg = &node_args[0];
+    AWS_NAPI_CALL(env, napi_get_cb_info(env, info, &num_args, node_args, NULL, NULL), {
+        napi_throw_error(env, NULL, "aws_napi_mqtt5_client_start - Failed to extract parameter array");
+        return NULL;
+    });
+
+    if (num_args != AWS_ARRAY_SIZE(node_args)) {
+        napi_throw_error(env, NULL, "aws_napi_mqtt5_client_start - needs exactly 1 argument");
+        return NULL;
+    }
+
+    struct aws_mqtt5_client_binding *binding = NULL;
+    napi_value node_binding = *arg++;
+    AWS_NAPI_CALL(env, napi_get_value_external(env, node_binding, (void **)&binding), {
+        napi_throw_error(
+            env, NULL, "aws_napi_mqtt5_client_start - Failed to extract client binding from first argument");
+        return NULL;
+    });
+
+    if (binding == NULL) {
+        napi_throw_error(env, NULL, "aws_napi_mqtt5_client_start - binding was null");
+        return NULL;
+    }
+
+    if (binding->client == NULL) {
+        napi_throw_error(env, NULL, "aws_napi_mqtt5_client_start - client was null");
+        return NULL;
+    }
+
+    if (aws_mqtt5_client_start(binding->client)) {
+        aws_napi_throw_last_error_with_context(
+            env, "aws_napi_mqtt5_client_start - Failure invoking aws_mqtt5_client_start");
+        return NULL;
+    }
+
+    return NULL;
+}
+
+/* Persistent storage for a DISCONNECT packet. */
+struct aws_napi_mqtt5_packet_disconnect_storage {
+    uint32_t session_expiry_interval_seconds;
+
+    struct aws_byte_buf reason_string;
+    struct aws_byte_cursor reason_string_cursor;
+
+    struct aws_napi_mqtt5_user_property_storage user_properties;
+
+    struct aws_byte_buf server_reference;
+    struct aws_byte_cursor server_reference_cursor;
+};
+
+static void s_aws_napi_mqtt5_packet_disconnect_storage_clean_up(
+    struct aws_napi_mqtt5_packet_disconnect_storage *storage) {
+    aws_byte_buf_clean_up(&storage->reason_string);
+
+    s_aws_mqtt5_user_properties_clean_up(&storage->user_properties);
+
+    aws_byte_buf_clean_up(&storage->server_reference);
+}
+
+/* Extract a DISCONNECT packet view from a Napi object (AwsMqtt5PacketDisconnect) and persist its data in storage. */
+static int s_aws_napi_mqtt5_packet_disconnect_storage_initialize_from_js_object(
+    struct aws_mqtt5_client_binding *binding,
+    struct aws_napi_mqtt5_packet_disconnect_storage *disconnect_storage,
+    struct aws_mqtt5_packet_disconnect_view *disconnect_packet,
+    napi_env env,
+    napi_value node_disconnect_packet) {
+    uint32_t reason_code = 0;
+    PARSE_OPTIONAL_NAPI_PROPERTY(
+        AWS_NAPI_KEY_REASON_CODE,
+        "s_aws_napi_mqtt5_packet_disconnect_storage_initialize_from_js_object",
+        aws_napi_get_named_property_as_uint32(
+            env, node_disconnect_packet, AWS_NAPI_KEY_REASON_CODE, (uint32_t *)&reason_code),
+        { disconnect_packet->reason_code = (enum aws_mqtt5_disconnect_reason_code)reason_code; });
+
+    PARSE_OPTIONAL_NAPI_PROPERTY(
+        AWS_NAPI_KEY_SESSION_EXPIRY_INTERVAL_SECONDS,
+        "s_aws_napi_mqtt5_packet_disconnect_storage_initialize_from_js_object",
+        aws_napi_get_named_property_as_uint32(
+            env,
+            node_disconnect_packet,
+            AWS_NAPI_KEY_SESSION_EXPIRY_INTERVAL_SECONDS,
+            &disconnect_storage->session_expiry_interval_seconds),
+        { disconnect_packet->session_expiry_interval_seconds = &disconnect_storage->session_expiry_interval_seconds; });
+
+    PARSE_OPTIONAL_NAPI_PROPERTY(
+        AWS_NAPI_KEY_REASON_STRING,
+        "s_aws_napi_mqtt5_packet_disconnect_storage_initialize_from_js_object",
+        aws_napi_get_named_property_as_bytebuf(
+            env, node_disconnect_packet, AWS_NAPI_KEY_REASON_STRING, napi_string, &disconnect_storage->reason_string),
+        {
+            disconnect_storage->reason_string_cursor = aws_byte_cursor_from_buf(&disconnect_storage->reason_string);
+            disconnect_packet->reason_string = &disconnect_storage->reason_string_cursor;
+        });
+
+    if (s_aws_mqtt5_user_properties_extract_from_js_object(
+            binding,
+            &disconnect_storage->user_properties,
+            env,
+            node_disconnect_packet,
+            &disconnect_packet->user_property_count,
+            &disconnect_packet->user_properties)) {
+        AWS_LOGF_ERROR(
+            AWS_LS_NODEJS_CRT_GENERAL,
+            "id=%p s_aws_napi_mqtt5_packet_disconnect_storage_initialize_from_js_object - failed to extract "
+            "userProperties",
+            (void *)binding->client);
+        return AWS_OP_ERR;
+    }
+
+    /* Intentionally ignore server reference because it's a client error to send it */
+
+    return AWS_OP_SUCCESS;
+}
+
+napi_value aws_napi_mqtt5_client_stop(napi_env env, napi_callback_info info) {
+
+    napi_value node_args[2];
+    size_t num_args = AWS_ARRAY_SIZE(node_args);
+    napi_value *arg = &node_args[0];
+    AWS_NAPI_CALL(env, napi_get_cb_info(env, info, &num_args, node_args, NULL, NULL), {
+        napi_throw_error(env, NULL, "aws_napi_mqtt5_client_stop - Failed to extract parameter array");
+        return NULL;
+    });
+
+    if (num_args != AWS_ARRAY_SIZE(node_args)) {
+        napi_throw_error(env, NULL, "aws_napi_mqtt5_client_stop - needs exactly 2 arguments");
+        return NULL;
+    }
+
+    struct aws_mqtt5_client_binding *binding = NULL;
+    napi_value node_binding = *arg++;
+    AWS_NAPI_CALL(env, napi_get_value_external(env, node_binding, (void **)&binding), {
+        napi_throw_error(
+            env, NULL, "aws_napi_mqtt5_client_stop - Failed to extract client binding from first argument");
+        return NULL;
+    });
+
+    if (binding == NULL) {
+        napi_throw_error(env, NULL, "aws_napi_mqtt5_client_stop - binding was null");
+        return NULL;
+    }
+
+    if (binding->client == NULL) {
+        napi_throw_error(env, NULL, "aws_napi_mqtt5_client_stop - client was null");
+        return NULL;
+    }
+
+    struct aws_napi_mqtt5_packet_disconnect_storage disconnect_storage;
+    AWS_ZERO_STRUCT(disconnect_storage);
+
+    struct aws_mqtt5_packet_disconnect_view *disconnect_view_ptr = NULL;
+    struct aws_mqtt5_packet_disconnect_view disconnect_view;
+    AWS_ZERO_STRUCT(disconnect_view);
+
+    napi_value node_disconnect_packet = *arg++;
+    if (!aws_napi_is_null_or_undefined(env, node_disconnect_packet)) {
+        if (s_aws_napi_mqtt5_packet_disconnect_storage_initialize_from_js_object(
+                binding, &disconnect_storage, &disconnect_view, env, node_disconnect_packet)) {
+            napi_throw_error(env, NULL, "aws_napi_mqtt5_client_stop - could not initialize disconnect packet");
+            goto done;
+        }
+
+        disconnect_view_ptr = &disconnect_view;
+    }
+
+    if (aws_mqtt5_client_stop(binding->client, disconnect_view_ptr, NULL)) {
+        aws_napi_throw_last_error_with_context(
+            env, "aws_napi_mqtt5_client_stop - Failure invoking aws_mqtt5_client_stop");
+        goto done;
+    }
+
+done:
+
+    s_aws_napi_mqtt5_packet_disconnect_storage_clean_up(&disconnect_storage);
+
+    return NULL;
+}
+
+struct aws_napi_mqtt5_operation_binding {
+    struct aws_allocator *allocator;
+
+    struct aws_mqtt5_client_binding *client_binding;
+
+    napi_threadsafe_function on_operation_completion;
+
+    int error_code;
+
+    /* set when the operation is a publish recorded in the client's persistent queue */
+    bool is_persisted;
+    uint64_t persistent_record_id;
+
+    /* set when the operation is a publish counted against the outbound scheduler's in-flight limit */
+    bool is_scheduled;
+
+    /* payload length of a publish, counted as sent by live statistics on success */
+    uint64_t payload_size;
+
+    enum aws_mqtt5_packet_type valid_storage;
+
+    union {
+        struct aws_mqtt5_packet_suback_storage suback;
+        struct aws_mqtt5_packet_puback_storage puback;
+        struct aws_mqtt5_packet_unsuback_storage unsuback;
+    } packet_storage;
+};
+
+static void s_aws_napi_mqtt5_operation_binding_destroy(struct aws_napi_mqtt5_operation_binding *binding) {
+    if (binding == NULL) {
+        return;
+    }
+
+    binding->client_binding = s_aws_mqtt5_client_binding_release(binding->client_binding);
+
+    AWS_CLEAN_THREADSAFE_FUNCTION(binding, on_operation_completion);
+
+    switch (binding->valid_storage) {
+        case AWS_MQTT5_PT_SUBACK:
+            aws_mqtt5_packet_suback_storage_clean_up(&binding->packet_storage.suback);
+            break;
+
+        case AWS_MQTT5_PT_PUBACK:
+            aws_mqtt5_packet_puback_storage_clean_up(&binding->packet_storage.puback);
+            break;
+
+        case AWS_MQTT5_PT_UNSUBACK:
+            aws_mqtt5_packet_unsuback_storage_clean_up(&binding->packet_storage.unsuback);
+            break;
+
+        default:
+            break;
+    }
+
+    aws_mem_release(binding->allocator, binding);
+}
+
+static int s_create_napi_suback_packet(
+    napi_env env,
+    const struct aws_mqtt5_packet_suback_view *suback,
+    napi_value *packet_out) {
+
+    if (env == NULL) {
+        return aws_raise_error(AWS_CRT_NODEJS_ERROR_THREADSAFE_FUNCTION_NULL_NAPI_ENV);
+    }
+
+    napi_value napi_suback = NULL;
+    AWS_NAPI_CALL(
+        env, napi_create_object(env, &napi_suback), { return aws_raise_error(AWS_CRT_NODEJS_ERROR_NAPI_FAILURE); });
+
+    if (aws_napi_attach_object_property_u32(napi_suback, env, AWS_NAPI_KEY_TYPE, (uint32_t)AWS_MQTT5_PT_SUBACK)) {
+        return AWS_OP_ERR;
+    }
+
+    if (aws_napi_attach_object_property_optional_string(
+            napi_suback, env, AWS_NAPI_KEY_REASON_STRING, suback->reason_string)) {
+        return AWS_OP_ERR;
+    }
+
+    if (s_attach_object_property_user_properties(
+            napi_suback, env, suback->user_property_count, suback->user_properties)) {
+        return AWS_OP_ERR;
+    }
+
+    size_t reason_code_count = suback->reason_code_count;
+    if (reason_code_count == 0) {
+        AWS_LOGF_ERROR(AWS_LS_NODEJS_CRT_GENERAL, "s_create_napi_suback_packet - missing reason codes");
+        return aws_raise_error(AWS_ERROR_INVALID_ARGUMENT);
+    }
+
+    napi_value suback_code_array = NULL;
+    AWS_NAPI_CALL(env, napi_create_array_with_length(env, reason_code_count, &suback_code_array), {
+        return aws_raise_error(AWS_CRT_NODEJS_ERROR_NAPI_FAILURE);
+    });
+
+    for (size_t i = 0; i < reason_code_count; ++i) {
+        napi_value napi_reason_code = NULL;
+        AWS_NAPI_CALL(env, napi_create_uint32(env, (uint32_t)suback->reason_codes[i], &napi_reason_code), {
+            return aws_raise_error(AWS_CRT_NODEJS_ERROR_NAPI_FAILURE);
+        });
+
+        AWS_NAPI_CALL(env, napi_set_element(env, suback_code_array, (uint32_t)i, napi_reason_code), {
+            return aws_raise_error(AWS_CRT_NODEJS_ERROR_NAPI_FAILURE);
+        });
+    }
+
+    AWS_NAPI_CALL(env, napi_set_named_property(env, napi_suback, AWS_NAPI_KEY_REASON_CODES, suback_code_array), {
+        return aws_raise_error(AWS_CRT_NODEJS_ERROR_NAPI_FAILURE);
+    });
+
+    *packet_out = napi_suback;
+
+    return AWS_OP_SUCCESS;
+}
+
+/* in-node/libuv-thread function to trigger the emission of an ATTEMPTING_CONNECT client lifecycle event */
+static void s_napi_on_subscribe_complete(napi_env env, napi_value function, void *context, void *user_data) {
+    (void)user_data;
+
+    struct aws_napi_mqtt5_operation_binding *binding = context;
+
+    if (env) {
+        napi_value params[3];
+        const size_t num_params = AWS_ARRAY_SIZE(params);
+
+        /*
+         * If we can't resolve the weak ref to the mqtt5 client, then it's been garbage collected and we should not
+         * do anything.
+         */
+        params[0] = NULL;
+        if (napi_get_reference_value(env, binding->client_binding->node_mqtt5_client_ref, &params[0]) != napi_ok ||
+            params[0] == NULL) {
+            AWS_LOGF_INFO(
+                AWS_LS_NODEJS_CRT_GENERAL,
+                "s_napi_on_subscribe_complete - mqtt5_client node wrapper no longer resolvable");
+            goto done;
+        }
+
+        AWS_NAPI_CALL(env, napi_create_uint32(env, binding->error_code, &params[1]), { goto done; });
+
+        if (binding->valid_storage == AWS_MQTT5_PT_SUBACK) {
+            if (s_create_napi_suback_packet(env, &binding->packet_storage.suback.storage_view, &params[2])) {
+                AWS_LOGF_ERROR(
+                    AWS_LS_NODEJS_CRT_GENERAL, "s_napi_on_subscribe_complete - could not build suback napi value");
+                goto done;
+            }
+        } else {
+            if (napi_get_undefined(env, &params[2]) != napi_ok) {
+                AWS_LOGF_ERROR(
+                    AWS_LS_NODEJS_CRT_GENERAL, "s_napi_on_subscribe_complete - could not get undefined napi value");
+                goto done;
+            }
+        }
+
+        AWS_NAPI_ENSURE(
+            env,
+            aws_napi_dispatch_threadsafe_function(
+                env, binding->on_operation_completion, NULL, function, num_params, params));
+    }
+
+done:
+
+    s_aws_napi_mqtt5_operation_binding_destroy(binding);
+}
+
+static void s_on_subscribe_complete(
+    const struct aws_mqtt5_packet_suback_view *suback,
+    int error_code,
+    void *complete_ctx) {
+
+    struct aws_allocator *allocator = aws_napi_get_allocator();
+    struct aws_napi_mqtt5_operation_binding *binding = complete_ctx;
+
+    binding->error_code = error_code;
+    if (suback != NULL &&
+        aws_mqtt5_packet_suback_storage_init(&binding->packet_storage.suback, allocator, suback) == AWS_OP_SUCCESS) {
+        binding->valid_storage = AWS_MQTT5_PT_SUBACK;
+    } else if (binding->error_code == AWS_ERROR_SUCCESS) {
+        binding->error_code = aws_last_error();
+    }
+
+    s_refresh_live_operation_statistics(binding->client_binding);
+
+    /* queue a callback in node's libuv thread */
+    AWS_NAPI_ENSURE(NULL, aws_napi_queue_threadsafe_function(binding->on_operation_completion, binding));
+}
+
+struct aws_napi_mqtt5_subscribe_storage {
+    struct aws_array_list subscriptions;
+    struct aws_byte_buf topics;
+
+    uint32_t subscription_identifier;
+
+    struct aws_napi_mqtt5_user_property_storage user_properties;
+};
+
+static void s_aws_napi_mqtt5_subscribe_storage_clean_up(struct aws_napi_mqtt5_subscribe_storage *storage) {
+    aws_array_list_clean_up(&storage->subscriptions);
+    aws_byte_buf_clean_up(&storage->topics);
+
+    s_aws_mqtt5_user_properties_clean_up(&storage->user_properties);
+}
+
+static int s_aws_mqtt5_subscription_init_from_napi(
+    struct aws_mqtt5_subscription_view *subscription,
+    struct aws_mqtt5_client_binding *binding,
+    napi_env env,
+    napi_value node_subscription) {
+
+    uint32_t qos = 0;
+    PARSE_REQUIRED_NAPI_PROPERTY(
+        AWS_NAPI_KEY_QOS,
+        "s_aws_mqtt5_subscription_init_from_napi",
+        aws_napi_get_named_property_as_uint32(env, node_subscription, AWS_NAPI_KEY_QOS, &qos),
+        { subscription->qos = qos; });
+
+    PARSE_OPTIONAL_NAPI_PROPERTY(
+        AWS_NAPI_KEY_NO_LOCAL,
+        "s_aws_mqtt5_subscription_init_from_napi",
+        aws_napi_get_named_property_as_boolean(env, node_subscription, AWS_NAPI_KEY_NO_LOCAL, &subscription->no_local),
+        {});
+
+    PARSE_OPTIONAL_NAPI_PROPERTY(
+        AWS_NAPI_KEY_RETAIN_AS_PUBLISHED,
+        "s_aws_mqtt5_subscription_init_from_napi",
+        aws_napi_get_named_property_as_boolean(
+            env, node_subscription, AWS_NAPI_KEY_RETAIN_AS_PUBLISHED, &subscription->retain_as_published),
+        {});
+
+    uint32_t retain_handling_type = 0;
+    PARSE_OPTIONAL_NAPI_PROPERTY(
+        AWS_NAPI_KEY_RETAIN_HANDLING_TYPE,
+        "s_aws_mqtt5_subscription_init_from_napi",
+        aws_napi_get_named_property_as_uint32(
+            env, node_subscription, AWS_NAPI_KEY_RETAIN_HANDLING_TYPE, &retain_handling_type),
+        { subscription->retain_handling_type = retain_handling_type; });
+
+    return AWS_OP_SUCCESS;
+}
+
+static int s_aws_mqtt5_packet_subscribe_storage_init_from_napi(
+    struct aws_napi_mqtt5_subscribe_storage *subscribe_storage,
+    struct aws_mqtt5_packet_subscribe_view *subscribe_view,
+    struct aws_mqtt5_client_binding *binding,
+    napi_env env,
+    napi_value node_subscribe_packet) {
+    if (env == NULL) {
+        return aws_raise_error(AWS_CRT_NODEJS_ERROR_THREADSAFE_FUNCTION_NULL_NAPI_ENV);
+    }
+
+    napi_value napi_subscriptions = NULL;
+    if (AWS_NGNPR_VALID_VALUE !=
+        aws_napi_get_named_property(
+            env, node_subscribe_packet, AWS_NAPI_KEY_SUBSCRIPTIONS, napi_object, &napi_subscriptions)) {
+        AWS_LOGF_ERROR(
+            AWS_LS_NODEJS_CRT_GENERAL,
+            "id=%p s_aws_mqtt5_packet_subscribe_storage_init_from_napi - missing require parameter: subscriptions",
+            (void *)binding->client);
+        return aws_raise_error(AWS_ERROR_INVALID_ARGUMENT);
+    }
+
+    /* how many subscriptions and total topic length */
+    uint32_t subscription_count = 0;
+    AWS_NAPI_CALL(env, napi_get_array_length(env, napi_subscriptions, &subscription_count), {
+        AWS_LOGF_ERROR(
+            AWS_LS_NODEJS_CRT_GENERAL,
+            "id=%p s_aws_mqtt5_packet_subscribe_storage_init_from_napi - subscriptions is not an array",
+            (void *)binding->client);
+        return aws_raise_error(AWS_ERROR_INVALID_ARGUMENT);
+    });
+
+    size_t topic_length_sum = 0;
+    for (uint32_t i = 0; i < subscription_count; ++i) {
+        napi_value napi_subscription = NULL;
+        AWS_NAPI_CALL(env, napi_get_element(env, napi_subscriptions, i, &napi_subscription), { return AWS_OP_ERR; });
+
+        struct aws_byte_buf topic_filter_buf;
+        AWS_ZERO_STRUCT(topic_filter_buf);
+
+        bool success = AWS_NGNPR_VALID_VALUE ==
+                       aws_napi_get_named_property_as_bytebuf(
+                           env, napi_subscription, AWS_NAPI_KEY_TOPIC_FILTER, napi_string, &topic_filter_buf);
+
+        topic_length_sum += topic_filter_buf.len;
+
+        aws_byte_buf_clean_up(&topic_filter_buf);
+        if (!success) {
+            AWS_LOGF_ERROR(
+                AWS_LS_NODEJS_CRT_GENERAL,
+                "id=%p s_aws_mqtt5_packet_subscribe_storage_init_from_napi - missing require parameter: topicFilter",
+                (void *)binding->client);
+            return aws_raise_error(AWS_ERROR_INVALID_ARGUMENT);
+        }
+    }
+
+    struct aws_allocator *allocator = aws_napi_get_allocator();
+
+    if (aws_array_list_init_dynamic(
+            &subscribe_storage->subscriptions,
+            allocator,
+            subscription_count,
+            sizeof(struct aws_mqtt5_subscription_view))) {
+        return AWS_OP_ERR;
+    }
+
+    if (aws_byte_buf_init(&subscribe_storage->topics, allocator, topic_length_sum)) {
+        return AWS_OP_ERR;
+    }
+
+    for (uint32_t i = 0; i < subscription_count; ++i) {
+        napi_value napi_subscription = NULL;
+        AWS_NAPI_CALL(env, napi_get_element(env, napi_subscriptions, i, &napi_subscription), { return AWS_OP_ERR; });
+
+        struct aws_byte_buf topic_filter_buf;
+        AWS_ZERO_STRUCT(topic_filter_buf);
+
+        aws_napi_get_named_property_as_bytebuf(
+            env, napi_subscription, AWS_NAPI_KEY_TOPIC_FILTER, napi_string, &topic_filter_buf);
+
+        struct aws_mqtt5_subscription_view subscription;
+        AWS_ZERO_STRUCT(subscription);
+
+        subscription.topic_filter = aws_byte_cursor_from_buf(&topic_filter_buf);
+
+        bool success =
+            aws_byte_buf_append_and_update(&subscribe_storage->topics, &subscription.topic_filter) == AWS_OP_SUCCESS;
+
+        aws_byte_buf_clean_up(&topic_filter_buf);
+
+        if (!success || s_aws_mqtt5_subscription_init_from_napi(&subscription, binding, env, napi_subscription)) {
+            return AWS_OP_ERR;
+        }
+
+        aws_array_list_push_back(&subscribe_storage->subscriptions, &subscription);
+    }
+
+    subscribe_view->subscription_count = subscription_count;
+    subscribe_view->subscriptions = subscribe_storage->subscriptions.data;
+
+    PARSE_OPTIONAL_NAPI_PROPERTY(
+        AWS_NAPI_KEY_SUBSCRIPTION_IDENTIFIER,
+        "s_aws_mqtt5_packet_subscribe_storage_init_from_napi",
+        aws_napi_get_named_property_as_uint32(
+            env,
+            node_subscribe_packet,
+            AWS_NAPI_KEY_SUBSCRIPTION_IDENTIFIER,
+            &subscribe_storage->subscription_identifier),
+        { subscribe_view->subscription_identifier = &subscribe_storage->subscription_identifier; });
+
+    if (s_aws_mqtt5_user_properties_extract_from_js_object(
+            binding,
+            &subscribe_storage->user_properties,
+            env,
+            node_subscribe_packet,
+            &subscribe_view->user_property_count,
+            &subscribe_view->user_properties)) {
+        AWS_LOGF_ERROR(
+            AWS_LS_NODEJS_CRT_GENERAL,
+            "s_aws_mqtt5_packet_subscribe_storage_init_from_napi - failed to extract userProperties");
+        return AWS_OP_ERR;
+    }
+
+    return AWS_OP_SUCCESS;
+}
+
+napi_value aws_napi_mqtt5_client_subscribe(napi_env env, napi_callback_info info) {
+    struct aws_allocator *allocator = aws_napi_get_allocator();
+
+    napi_value node_args[3];
+    size_t num_args = AWS_ARRAY_SIZE(node_args);
+    napi_value *arg = &node_args[0];
+    AWS_NAPI_CALL(env, napi_get_cb_info(env, info, &num_args, node_args, NULL, NULL), {
+        napi_throw_error(env, NULL, "aws_napi_mqtt5_client_subscribe - Failed to extract parameter array");
+        return NULL;
+    });
+
+    if (num_args != AWS_ARRAY_SIZE(node_args)) {
+        napi_throw_error(env, NULL, "aws_napi_mqtt5_client_subscribe - needs exactly 3 arguments");
+        return NULL;
+    }
+
+    bool successful = false;
+    struct aws_mqtt5_client_binding *client_binding = NULL;
+    napi_value node_binding = *arg++;
+    AWS_NAPI_CALL(env, napi_get_value_external(env, node_binding, (void **)&client_binding), {
+        napi_throw_error(
+            env, NULL, "aws_napi_mqtt5_client_subscribe - Failed to extract client binding from first argument");
+        return NULL;
+    });
+
+    if (client_binding == NULL) {
+        napi_throw_error(env, NULL, "aws_napi_mqtt5_client_subscribe - binding was null");
+        return NULL;
+    }
+
+    if (client_binding->client == NULL) {
+        napi_throw_error(env, NULL, "aws_napi_mqtt5_client_subscribe - client was null");
+        return NULL;
+    }
+
+    struct aws_napi_mqtt5_operation_binding *binding =
+        aws_mem_calloc(allocator, 1, sizeof(struct aws_napi_mqtt5_operation_binding));
+    binding->allocator = allocator;
+    binding->client_binding = s_aws_mqtt5_client_binding_acquire(client_binding);
+
+    napi_value node_subscribe_packet = *arg++;
+
+    struct aws_napi_mqtt5_subscribe_storage subscribe_storage;
+    AWS_ZERO_STRUCT(subscribe_storage);
+    struct aws_mqtt5_packet_subscribe_view subscribe_view;
+    AWS_ZERO_STRUCT(subscribe_view);
+    if (s_aws_mqtt5_packet_subscribe_storage_init_from_napi(
+            &subscribe_storage, &subscribe_view, client_binding, env, node_subscribe_packet)) {
+        napi_throw_error(env, NULL, "aws_napi_mqtt5_client_subscribe - storage init failure");
+        goto done;
+    }
+
+    napi_value completion_callback = *arg++;
+    AWS_NAPI_CALL(
+        env,
+        aws_napi_create_threadsafe_function(
+            env,
+            completion_callback,
+            "aws_mqtt5_on_subsription_complete",
+            s_napi_on_subscribe_complete,
+            binding,
+            &binding->on_operation_completion),
+        {
+            napi_throw_error(env, NULL, "aws_napi_mqtt5_client_subscribe - failed to create threadsafe function");
+            goto done;
+        });
+
+    struct aws_mqtt5_subscribe_completion_options completion_options = {
+        .completion_callback = s_on_subscribe_complete,
+        .completion_user_data = binding,
+    };
+
+    if (aws_mqtt5_client_subscribe(client_binding->client, &subscribe_view, &completion_options)) {
+        napi_throw_error(env, NULL, "aws_napi_mqtt5_client_subscribe - failure invoking native client subscribe");
+        goto done;
+    }
+
+    s_refresh_live_operation_statistics(client_binding);
+
+    successful = true;
+
+done:
+
+    s_aws_napi_mqtt5_subscribe_storage_clean_up(&subscribe_storage);
+
+    if (!successful) {
+        s_aws_napi_mqtt5_operation_binding_destroy(binding);
+    }
+
+    return NULL;
+}
+
+static int s_create_napi_unsuback_packet(
+    napi_env env,
+    const struct aws_mqtt5_packet_unsuback_view *unsuback,
+    napi_value *packet_out) {
+
+    if (env == NULL) {
+        return aws_raise_error(AWS_CRT_NODEJS_ERROR_THREADSAFE_FUNCTION_NULL_NAPI_ENV);
+    }
+
+    napi_value napi_unsuback = NULL;
+    AWS_NAPI_CALL(
+        env, napi_create_object(env, &napi_unsuback), { return aws_raise_error(AWS_CRT_NODEJS_ERROR_NAPI_FAILURE); });
+
+    if (aws_napi_attach_object_property_u32(napi_unsuback, env, AWS_NAPI_KEY_TYPE, (uint32_t)AWS_MQTT5_PT_UNSUBACK)) {
+        return AWS_OP_ERR;
+    }
+
+    if (aws_napi_attach_object_property_optional_string(
+            napi_unsuback, env, AWS_NAPI_KEY_REASON_STRING, unsuback->reason_string)) {
+        return AWS_OP_ERR;
+    }
+
+    if (s_attach_object_property_user_properties(
+            napi_unsuback, env, unsuback->user_property_count, unsuback->user_properties)) {
+        return AWS_OP_ERR;
+    }
+
+    size_t reason_code_count = unsuback->reason_code_count;
+    if (reason_code_count == 0) {
+        AWS_LOGF_ERROR(AWS_LS_NODEJS_CRT_GENERAL, "s_create_napi_unsuback_packet - missing reason codes");
+        return aws_raise_error(AWS_ERROR_INVALID_ARGUMENT);
+    }
+
+    napi_value unsuback_code_array = NULL;
+    AWS_NAPI_CALL(env, napi_create_array_with_length(env, reason_code_count, &unsuback_code_array), {
+        return aws_raise_error(AWS_CRT_NODEJS_ERROR_NAPI_FAILURE);
+    });
+
+    for (size_t i = 0; i < reason_code_count; ++i) {
+        napi_value napi_reason_code = NULL;
+        AWS_NAPI_CALL(env, napi_create_uint32(env, (uint32_t)unsuback->reason_codes[i], &napi_reason_code), {
+            return aws_raise_error(AWS_CRT_NODEJS_ERROR_NAPI_FAILURE);
+        });
+
+        AWS_NAPI_CALL(env, napi_set_element(env, unsuback_code_array, (uint32_t)i, napi_reason_code), {
+            return aws_raise_error(AWS_CRT_NODEJS_ERROR_NAPI_FAILURE);
+        });
+    }
+
+    AWS_NAPI_CALL(env, napi_set_named_property(env, napi_unsuback, AWS_NAPI_KEY_REASON_CODES, unsuback_code_array), {
+        return aws_raise_error(AWS_CRT_NODEJS_ERROR_NAPI_FAILURE);
+    });
+
+    *packet_out = napi_unsuback;
+
+    return AWS_OP_SUCCESS;
+}
+
+/* in-node/libuv-thread function to trigger the emission of an ATTEMPTING_CONNECT client lifecycle event */
+static void s_napi_on_unsubscribe_complete(napi_env env, napi_value function, void *context, void *user_data) {
+    (void)user_data;
+
+    struct aws_napi_mqtt5_operation_binding *binding = context;
+
+    if (env) {
+        napi_value params[3];
+        const size_t num_params = AWS_ARRAY_SIZE(params);
+
+        /*
+         * If we can't resolve the weak ref to the mqtt5 client, then it's been garbage collected and we should not
+         * do anything.
+         */
+        params[0] = NULL;
+        if (napi_get_reference_value(env, binding->client_binding->node_mqtt5_client_ref, &params[0]) != napi_ok ||
+            params[0] == NULL) {
+            AWS_LOGF_INFO(
+                AWS_LS_NODEJS_CRT_GENERAL,
+                "s_napi_on_unsubscribe_complete - mqtt5_client node wrapper no longer resolvable");
+            goto done;
+        }
+
+        AWS_NAPI_CALL(env, napi_create_uint32(env, binding->error_code, &params[1]), { goto done; });
+
+        if (binding->valid_storage == AWS_MQTT5_PT_UNSUBACK) {
+            if (s_create_napi_unsuback_packet(env, &binding->packet_storage.unsuback.storage_view, &params[2])) {
+                AWS_LOGF_ERROR(
+                    AWS_LS_NODEJS_CRT_GENERAL, "s_napi_on_unsubscribe_complete - could not build suback napi value");
+                goto done;
+            }
+        } else if (napi_get_undefined(env, &params[2]) != napi_ok) {
+            AWS_LOGF_ERROR(
+                AWS_LS_NODEJS_CRT_GENERAL, "s_napi_on_unsubscribe_complete - could not get undefined napi_value");
+            goto done;
+        }
+
+        AWS_NAPI_ENSURE(
+            env,
+            aws_napi_dispatch_threadsafe_function(
+                env, binding->on_operation_completion, NULL, function, num_params, params));
+    }
+
+done:
+
+    s_aws_napi_mqtt5_operation_binding_destroy(binding);
+}
+
+static void s_on_unsubscribe_complete(
+    const struct aws_mqtt5_packet_unsuback_view *unsuback,
+    int error_code,
+    void *complete_ctx) {
+
+    struct aws_allocator *allocator = aws_napi_get_allocator();
+    struct aws_napi_mqtt5_operation_binding *binding = complete_ctx;
+
+    binding->error_code = error_code;
+    if (unsuback != NULL && aws_mqtt5_packet_unsuback_storage_init(
+                                &binding->packet_storage.unsuback, allocator, unsuback) == AWS_OP_SUCCESS) {
+        binding->valid_storage = AWS_MQTT5_PT_UNSUBACK;
+    } else if (binding->error_code == AWS_ERROR_SUCCESS) {
+        binding->error_code = aws_last_error();
+    }
+
+    s_refresh_live_operation_statistics(binding->client_binding);
+
+    /* queue a callback in node's libuv thread */
+    AWS_NAPI_ENSURE(NULL, aws_napi_queue_threadsafe_function(binding->on_operation_completion, binding));
+}
+
+struct aws_napi_mqtt5_unsubscribe_storage {
+    struct aws_array_list topic_filter_cursors;
+    struct aws_byte_buf topic_filters;
+
+    struct aws_napi_mqtt5_user_property_storage user_properties;
+};
+
+static void s_aws_napi_mqtt5_unsubscribe_storage_clean_up(struct aws_napi_mqtt5_unsubscribe_storage *storage) {
+    aws_array_list_clean_up(&storage->topic_filter_cursors);
+    aws_byte_buf_clean_up(&storage->topic_filters);
+
+    s_aws_mqtt5_user_properties_clean_up(&storage->user_properties);
+}
+
+static int s_aws_mqtt5_packet_unsubscribe_storage_init_from_napi(
+    struct aws_napi_mqtt5_unsubscribe_storage *unsubscribe_storage,
+    struct aws_mqtt5_packet_unsubscribe_view *unsubscribe_view,
+    struct aws_mqtt5_client_binding *binding,
+    napi_env env,
+    napi_value node_unsubscribe_packet) {
+    if (env == NULL) {
+        return aws_raise_error(AWS_CRT_NODEJS_ERROR_THREADSAFE_FUNCTION_NULL_NAPI_ENV);
+    }
+
+    napi_value napi_topic_filters = NULL;
+    if (AWS_NGNPR_VALID_VALUE !=
+        aws_napi_get_named_property(
+            env, node_unsubscribe_packet, AWS_NAPI_KEY_TOPIC_FILTERS, napi_object, &napi_topic_filters)) {
+        AWS_LOGF_ERROR(
+            AWS_LS_NODEJS_CRT_GENERAL,
+            "id=%p s_aws_mqtt5_packet_unsubscribe_storage_init_from_napi - missing require parameter: subscriptions",
+            (void *)binding->client);
+        return aws_raise_error(AWS_ERROR_INVALID_ARGUMENT);
+    }
+
+    /* how many topic filters and total topic filter length */
+    uint32_t topic_filter_count = 0;
+    AWS_NAPI_CALL(env, napi_get_array_length(env, napi_topic_filters, &topic_filter_count), {
+        AWS_LOGF_ERROR(
+            AWS_LS_NODEJS_CRT_GENERAL,
+            "id=%p s_aws_mqtt5_packet_unsubscribe_storage_init_from_napi - topic filters is not an array",
+            (void *)binding->client);
+        return aws_raise_error(AWS_ERROR_INVALID_ARGUMENT);
+    });
+
+    size_t topic_filter_length_sum = 0;
+    for (uint32_t i = 0; i < topic_filter_count; ++i) {
+        napi_value napi_topic_filter = NULL;
+        AWS_NAPI_CALL(env, napi_get_element(env, napi_topic_filters, i, &napi_topic_filter), { return AWS_OP_ERR; });
+
+        struct aws_byte_buf topic_filter_buf;
+        AWS_ZERO_STRUCT(topic_filter_buf);
+
+        AWS_NAPI_CALL(env, aws_byte_buf_init_from_napi(&topic_filter_buf, env, napi_topic_filter), {
+            return aws_raise_error(AWS_ERROR_INVALID_ARGUMENT);
+        });
+
+        topic_filter_length_sum += topic_filter_buf.len;
+
+        aws_byte_buf_clean_up(&topic_filter_buf);
+    }
+
+    struct aws_allocator *allocator = aws_napi_get_allocator();
+
+    if (aws_array_list_init_dynamic(
+            &unsubscribe_storage->topic_filter_cursors,
+            allocator,
+            topic_filter_count,
+            sizeof(struct aws_byte_cursor))) {
+        return AWS_OP_ERR;
+    }
 
-            client_options->websocket_handshake_transform = s_mqtt5_transform_websocket;
-            client_options->websocket_handshake_transform_user_data = binding;
-        }
+    if (aws_byte_buf_init(&unsubscribe_storage->topic_filters, allocator, topic_filter_length_sum)) {
+        return AWS_OP_ERR;
     }
 
-    return AWS_OP_SUCCESS;
-}
+    for (uint32_t i = 0; i < topic_filter_count; ++i) {
+        napi_value napi_topic_filter = NULL;
+        AWS_NAPI_CALL(env, napi_get_element(env, napi_topic_filters, i, &napi_topic_filter), { return AWS_OP_ERR; });
 
-static int s_init_event_handler_threadsafe_function(
-    napi_env env,
-    napi_value node_event_handler,
-    const char *threadsafe_name,
-    napi_threadsafe_function_call_js callback_function,
-    napi_threadsafe_function *function_out) {
+        struct aws_byte_buf topic_filter_buf;
+        AWS_ZERO_STRUCT(topic_filter_buf);
 
-    AWS_FATAL_ASSERT(function_out != NULL && *function_out == NULL);
+        AWS_NAPI_CALL(env, aws_byte_buf_init_from_napi(&topic_filter_buf, env, napi_topic_filter), {
+            return aws_raise_error(AWS_ERROR_INVALID_ARGUMENT);
+        });
 
-    AWS_NAPI_CALL(
-        env,
-        aws_napi_create_threadsafe_function(
-            env, node_event_handler, threadsafe_name, callback_function, NULL, function_out),
-        { return aws_raise_error(AWS_ERROR_INVALID_ARGUMENT); });
+        struct aws_byte_cursor topic_filter = aws_byte_cursor_from_buf(&topic_filter_buf);
 
-    return AWS_OP_SUCCESS;
-}
+        bool success =
+            aws_byte_buf_append_and_update(&unsubscribe_storage->topic_filters, &topic_filter) == AWS_OP_SUCCESS;
 
-/*
- * Shared configuration defaults.  These are required parameters at the C level, but we make them optional and give
- * them sensible defaults at the binding level.
- */
-static const uint16_t s_default_mqtt_keep_alive_interval_seconds = 1200;
+        aws_byte_buf_clean_up(&topic_filter_buf);
 
-static void s_init_default_mqtt5_client_options(
-    struct aws_mqtt5_client_options *client_options,
-    struct aws_mqtt5_packet_connect_view *connect_options) {
+        if (!success) {
+            return AWS_OP_ERR;
+        }
 
-    connect_options->keep_alive_interval_seconds = s_default_mqtt_keep_alive_interval_seconds;
-    client_options->connect_options = connect_options;
+        aws_array_list_push_back(&unsubscribe_storage->topic_filter_cursors, &topic_filter);
+    }
+
+    unsubscribe_view->topic_filter_count = topic_filter_count;
+    unsubscribe_view->topic_filters = unsubscribe_storage->topic_filter_cursors.data;
+
+    if (s_aws_mqtt5_user_properties_extract_from_js_object(
+            binding,
+            &unsubscribe_storage->user_properties,
+            env,
+            node_unsubscribe_packet,
+            &unsubscribe_view->user_property_count,
+            &unsubscribe_view->user_properties)) {
+        AWS_LOGF_ERROR(
+            AWS_LS_NODEJS_CRT_GENERAL,
+            "s_aws_mqtt5_packet_unsubscribe_storage_init_from_napi - failed to extract userProperties");
+        return AWS_OP_ERR;
+    }
+
+    return AWS_OP_SUCCESS;
 }
 
-napi_value aws_napi_mqtt5_client_new(napi_env env, napi_callback_info info) {
+napi_value aws_napi_mqtt5_client_unsubscribe(napi_env env, napi_callback_info info) {
+    struct aws_allocator *allocator = aws_napi_get_allocator();
 
-    napi_value node_args[12];
+    napi_value node_args[3];
     size_t num_args = AWS_ARRAY_SIZE(node_args);
     napi_value *arg = &node_args[0];
     AWS_NAPI_CALL(env, napi_get_cb_info(env, info, &num_args, node_args, NULL, NULL), {
-        napi_throw_error(env, NULL, "mqtt5_client_new - Failed to retrieve arguments");
+        napi_throw_error(env, NULL, "aws_napi_mqtt5_client_unsubscribe - Failed to extract parameter array");
         return NULL;
     });
 
     if (num_args != AWS_ARRAY_SIZE(node_args)) {
-        napi_throw_error(env, NULL, "mqtt5_client_new - needs exactly 12 arguments");
+        napi_throw_error(env, NULL, "aws_napi_mqtt5_client_unsubscribe - needs exactly 3 arguments");
         return NULL;
     }
 
-    napi_value napi_client_wrapper = NULL;
-    napi_value node_external = NULL;
-    struct aws_allocator *allocator = aws_napi_get_allocator();
-
-    struct aws_mqtt5_client_binding *binding = aws_mem_calloc(allocator, 1, sizeof(struct aws_mqtt5_client_binding));
-    binding->allocator = allocator;
-    aws_ref_count_init(&binding->ref_count, binding, s_aws_mqtt5_client_binding_on_zero);
-
-    AWS_NAPI_CALL(env, napi_create_external(env, binding, s_aws_mqtt5_client_extern_finalize, NULL, &node_external), {
-        aws_mem_release(allocator, binding);
-        napi_throw_error(env, NULL, "mqtt5_client_new - Failed to create n-api external");
-        goto cleanup;
+    bool successful = false;
+    struct aws_mqtt5_client_binding *client_binding = NULL;
+    napi_value node_binding = *arg++;
+    AWS_NAPI_CALL(env, napi_get_value_external(env, node_binding, (void **)&client_binding), {
+        napi_throw_error(
+            env, NULL, "aws_napi_mqtt5_client_unsubscribe - Failed to extract client binding from first argument");
+        return NULL;
     });
 
-    struct aws_mqtt5_client_options client_options;
-    AWS_ZERO_STRUCT(client_options);
-
-    struct aws_mqtt5_packet_connect_view connect_options;
-    AWS_ZERO_STRUCT(connect_options);
-
-    struct aws_mqtt5_packet_publish_view will_options;
-    AWS_ZERO_STRUCT(will_options);
-
-    struct aws_mqtt5_client_topic_alias_options topic_aliasing_options;
-    AWS_ZERO_STRUCT(topic_aliasing_options);
-
-    struct aws_napi_mqtt5_client_creation_storage options_storage;
-    AWS_ZERO_STRUCT(options_storage);
-
-    s_init_default_mqtt5_client_options(&client_options, &connect_options);
+    if (client_binding == NULL) {
+        napi_throw_error(env, NULL, "aws_napi_mqtt5_client_unsubscribe - binding was null");
+        return NULL;
+    }
 
-    /* Arg #1: the mqtt5 client */
-    napi_value node_client = *arg++;
-    if (aws_napi_is_null_or_undefined(env, node_client)) {
-        napi_throw_error(env, NULL, "mqtt5_client_new - Required client parameter is null");
-        goto cleanup;
+    if (client_binding->client == NULL) {
+        napi_throw_error(env, NULL, "aws_napi_mqtt5_client_unsubscribe - client was null");
+        return NULL;
     }
 
-    AWS_NAPI_CALL(env, napi_create_reference(env, node_client, 1, &binding->node_mqtt5_client_ref), {
-        napi_throw_error(env, NULL, "mqtt5_client_new - Failed to create reference to node mqtt5 client");
-        goto cleanup;
-    });
+    struct aws_napi_mqtt5_operation_binding *binding =
+        aws_mem_calloc(allocator, 1, sizeof(struct aws_napi_mqtt5_operation_binding));
+    binding->allocator = allocator;
+    binding->client_binding = s_aws_mqtt5_client_binding_acquire(client_binding);
 
-    /* Arg #2: the mqtt5 client config object */
-    napi_value node_client_config = *arg++;
-    if (aws_napi_is_null_or_undefined(env, node_client_config)) {
-        napi_throw_error(env, NULL, "mqtt5_client_new - Required configuration parameter is null");
-        goto cleanup;
+    napi_value node_unsubscribe_packet = *arg++;
+
+    struct aws_napi_mqtt5_unsubscribe_storage unsubscribe_storage;
+    AWS_ZERO_STRUCT(unsubscribe_storage);
+    struct aws_mqtt5_packet_unsubscribe_view unsubscribe_view;
+    AWS_ZERO_STRUCT(unsubscribe_view);
+    if (s_aws_mqtt5_packet_unsubscribe_storage_init_from_napi(
+            &unsubscribe_storage, &unsubscribe_view, client_binding, env, node_unsubscribe_packet)) {
+        napi_throw_error(env, NULL, "aws_napi_mqtt5_client_unsubscribe - storage init failure");
+        goto done;
     }
 
-    if (s_init_client_configuration_from_js_client_configuration(
+    napi_value completion_callback = *arg++;
+    AWS_NAPI_CALL(
+        env,
+        aws_napi_create_threadsafe_function(
             env,
-            node_client_config,
+            completion_callback,
+            "aws_mqtt5_on_unsubscribe_complete",
+            s_napi_on_unsubscribe_complete,
             binding,
-            &client_options,
-            &connect_options,
-            &will_options,
-            &topic_aliasing_options,
-            &options_storage)) {
-        napi_throw_error(
-            env,
-            NULL,
-            "mqtt5_client_new - failed to initialize native client configuration from js client configuration");
-        goto cleanup;
-    }
+            &binding->on_operation_completion),
+        {
+            napi_throw_error(env, NULL, "aws_napi_mqtt5_client_unsubscribe - failed to create threadsafe function");
+            goto done;
+        });
 
-    /* Arg #3: on stopped event */
-    napi_value on_stopped_event_handler = *arg++;
-    if (aws_napi_is_null_or_undefined(env, on_stopped_event_handler)) {
-        napi_throw_error(env, NULL, "mqtt5_client_new - required on_stopped event handler is null");
-        goto cleanup;
-    }
+    struct aws_mqtt5_unsubscribe_completion_options completion_options = {
+        .completion_callback = s_on_unsubscribe_complete,
+        .completion_user_data = binding,
+    };
 
-    if (s_init_event_handler_threadsafe_function(
-            env, on_stopped_event_handler, "aws_mqtt5_client_on_stopped", s_napi_on_stopped, &binding->on_stopped)) {
-        napi_throw_error(env, NULL, "mqtt5_client_new - failed to initialize on_stopped event handler");
-        goto cleanup;
+    if (aws_mqtt5_client_unsubscribe(client_binding->client, &unsubscribe_view, &completion_options)) {
+        napi_throw_error(env, NULL, "aws_napi_mqtt5_client_unsubscribe - failure invoking native client unsubscribe");
+        goto done;
     }
 
-    /* Arg #4: on attempting connect event */
-    napi_value on_attempting_connect_event_handler = *arg++;
-    if (aws_napi_is_null_or_undefined(env, on_attempting_connect_event_handler)) {
-        napi_throw_error(env, NULL, "mqtt5_client_new - required on_attempting_connect event handler is null");
-        goto cleanup;
-    }
+    s_refresh_live_operation_statistics(client_binding);
 
-    if (s_init_event_handler_threadsafe_function(
-            env,
-            on_attempting_connect_event_handler,
-            "aws_mqtt5_client_on_attempting_connect",
-            s_napi_on_attempting_connect,
-            &binding->on_attempting_connect)) {
-        napi_throw_error(env, NULL, "mqtt5_client_new - failed to initialize on_attempting_connect event handler");
-        goto cleanup;
-    }
+    successful = true;
 
-    /* Arg #5: on connection success event */
-    napi_value on_connection_success_event_handler = *arg++;
-    if (aws_napi_is_null_or_undefined(env, on_connection_success_event_handler)) {
-        napi_throw_error(env, NULL, "mqtt5_client_new - required on_connection_success event handler is null");
-        goto cleanup;
-    }
+done:
 
-    if (s_init_event_handler_threadsafe_function(
-            env,
-            on_connection_success_event_handler,
-            "aws_mqtt5_client_on_connection_success",
-            s_napi_on_connection_success,
-            &binding->on_connection_success)) {
-        napi_throw_error(env, NULL, "mqtt5_client_new - failed to initialize on_connection_success event handler");
-        goto cleanup;
+    s_aws_napi_mqtt5_unsubscribe_storage_clean_up(&unsubscribe_storage);
+
+    if (!successful) {
+        s_aws_napi_mqtt5_operation_binding_destroy(binding);
     }
 
-    /* Arg #6: on connection failure event */
-    napi_value on_connection_failure_event_handler = *arg++;
-    if (aws_napi_is_null_or_undefined(env, on_connection_failure_event_handler)) {
-        napi_throw_error(env, NULL, "mqtt5_client_new - required on_connection_failure event handler is null");
-        goto cleanup;
+    return NULL;
+}
+
+static int s_create_napi_puback_packet(
+    napi_env env,
+    const struct aws_mqtt5_packet_puback_view *puback,
+    napi_value *packet_out) {
+
+    if (env == NULL) {
+        return aws_raise_error(AWS_CRT_NODEJS_ERROR_THREADSAFE_FUNCTION_NULL_NAPI_ENV);
     }
 
-    if (s_init_event_handler_threadsafe_function(
-            env,
-            on_connection_failure_event_handler,
-            "aws_mqtt5_client_on_connection_failure",
-            s_napi_on_connection_failure,
-            &binding->on_connection_failure)) {
-        napi_throw_error(env, NULL, "mqtt5_client_new - failed to initialize on_connection_failure event handler");
-        goto cleanup;
+    napi_value napi_puback = NULL;
+    AWS_NAPI_CALL(
+        env, napi_create_object(env, &napi_puback), { return aws_raise_error(AWS_CRT_NODEJS_ERROR_NAPI_FAILURE); });
+
+    if (aws_napi_attach_object_property_u32(napi_puback, env, AWS_NAPI_KEY_TYPE, (uint32_t)AWS_MQTT5_PT_PUBACK)) {
+        return AWS_OP_ERR;
     }
 
-    /* Arg #7: on disconnection event */
-    napi_value on_disconnection_event_handler = *arg++;
-    if (aws_napi_is_null_or_undefined(env, on_disconnection_event_handler)) {
-        napi_throw_error(env, NULL, "mqtt5_client_new - required on_disconnection event handler is null");
-        goto cleanup;
+    if (aws_napi_attach_object_property_u32(napi_puback, env, AWS_NAPI_KEY_REASON_CODE, puback->reason_code)) {
+        return AWS_OP_ERR;
     }
 
-    if (s_init_event_handler_threadsafe_function(
-            env,
-            on_disconnection_event_handler,
-            "aws_mqtt5_client_on_disconnection",
-            s_napi_on_disconnection,
-            &binding->on_disconnection)) {
-        napi_throw_error(env, NULL, "mqtt5_client_new - failed to initialize on_disconnection event handler");
-        goto cleanup;
+    if (aws_napi_attach_object_property_optional_string(
+            napi_puback, env, AWS_NAPI_KEY_REASON_STRING, puback->reason_string)) {
+        return AWS_OP_ERR;
     }
 
-    /* Arg #8: on message received event */
-    napi_value on_message_received_event_handler = *arg++;
-    if (aws_napi_is_null_or_undefined(env, on_message_received_event_handler)) {
-        napi_throw_error(env, NULL, "mqtt5_client_new - required on_message_received event handler is null");
-        goto cleanup;
+    if (s_attach_object_property_user_properties(
+            napi_puback, env, puback->user_property_count, puback->user_properties)) {
+        return AWS_OP_ERR;
     }
 
-    if (s_init_event_handler_threadsafe_function(
-            env,
-            on_message_received_event_handler,
-            "aws_mqtt5_client_on_message_received",
-            s_napi_on_message_received,
-            &binding->on_message_received)) {
-        napi_throw_error(env, NULL, "mqtt5_client_new - failed to initialize on_message_received event handler");
-        goto cleanup;
-    }
+    *packet_out = napi_puback;
 
-    /* Arg #9: client bootstrap */
-    napi_value node_client_bootstrap = *arg++;
-    if (!aws_napi_is_null_or_undefined(env, node_client_bootstrap)) {
-        struct client_bootstrap_binding *client_bootstrap_binding = NULL;
-        napi_get_value_external(env, node_client_bootstrap, (void **)&client_bootstrap_binding);
+    return AWS_OP_SUCCESS;
+}
 
-        client_options.bootstrap = aws_napi_get_client_bootstrap(client_bootstrap_binding);
-    }
+/* in-node/libuv-thread function to trigger the completion of a publish promise */
+static void s_napi_on_publish_complete(napi_env env, napi_value function, void *context, void *user_data) {
+    (void)user_data;
 
-    if (client_options.bootstrap == NULL) {
-        client_options.bootstrap = aws_napi_get_default_client_bootstrap();
-    }
+    struct aws_napi_mqtt5_operation_binding *binding = context;
 
-    /* Arg #10: socket options */
-    napi_value node_socket_options = *arg++;
-    if (!aws_napi_is_null_or_undefined(env, node_socket_options)) {
-        AWS_NAPI_CALL(env, napi_get_value_external(env, node_socket_options, (void **)&client_options.socket_options), {
-            napi_throw_error(env, NULL, "mqtt5_client_new - Unable to extract socket_options from external");
-            goto cleanup;
-        });
+    /* the acknowledgement made on the event loop thread reaches disk here, before anyone can observe the outcome */
+    if (binding->is_persisted) {
+        aws_napi_mqtt5_persistent_queue_flush(binding->client_binding->persistent_queue);
     }
 
-    /* Arg #11: tls options */
-    napi_value node_tls = *arg++;
-    if (!aws_napi_is_null_or_undefined(env, node_tls)) {
-        struct aws_tls_ctx *tls_ctx;
-        AWS_NAPI_CALL(env, napi_get_value_external(env, node_tls, (void **)&tls_ctx), {
-            napi_throw_error(env, NULL, "mqtt5_client_new - Failed to extract tls_ctx from external");
-            goto cleanup;
-        });
+    if (env) {
+        napi_value params[3];
+        const size_t num_params = AWS_ARRAY_SIZE(params);
 
-        aws_tls_connection_options_init_from_ctx(&binding->tls_connection_options, tls_ctx);
+        /*
+         * If we can't resolve the weak ref to the mqtt5 client, then it's been garbage collected and we should not
+         * do anything.
+         */
+        params[0] = NULL;
+        if (napi_get_reference_value(env, binding->client_binding->node_mqtt5_client_ref, &params[0]) != napi_ok ||
+            params[0] == NULL) {
+            AWS_LOGF_INFO(
+                AWS_LS_NODEJS_CRT_GENERAL,
+                "s_napi_on_publish_complete - mqtt5_client node wrapper no longer resolvable");
+            goto done;
+        }
 
-        client_options.tls_options = &binding->tls_connection_options;
-    }
+        AWS_NAPI_CALL(env, napi_create_uint32(env, binding->error_code, &params[1]), { goto done; });
 
-    /* Arg #12: http proxy options */
-    napi_value node_proxy_options = *arg++;
-    if (!aws_napi_is_null_or_undefined(env, node_proxy_options)) {
-        struct http_proxy_options_binding *proxy_binding = NULL;
-        AWS_NAPI_CALL(env, napi_get_value_external(env, node_proxy_options, (void **)&proxy_binding), {
-            napi_throw_type_error(env, NULL, "mqtt5_client_new - failed to extract http proxy options from external");
-            goto cleanup;
-        });
-        /* proxy_options are copied internally, no need to go nuts on copies */
-        client_options.http_proxy_options = aws_napi_get_http_proxy_options(proxy_binding);
+        if (binding->valid_storage == AWS_MQTT5_PT_PUBACK) {
+            if (s_create_napi_puback_packet(env, &binding->packet_storage.puback.storage_view, &params[2])) {
+                AWS_LOGF_ERROR(
+                    AWS_LS_NODEJS_CRT_GENERAL, "s_napi_on_publish_complete - could not build puback napi_value");
+                goto done;
+            }
+        } else {
+            if (napi_get_undefined(env, &params[2]) != napi_ok) {
+                AWS_LOGF_ERROR(
+                    AWS_LS_NODEJS_CRT_GENERAL, "s_napi_on_publish_complete - could not get undefined napi_value");
+                goto done;
+            }
+        }
+
+        AWS_NAPI_ENSURE(
+            env,
+            aws_napi_dispatch_threadsafe_function(
+                env, binding->on_operation_completion, NULL, function, num_params, params));
     }
 
-    client_options.publish_received_handler = s_on_publish_received;
-    client_options.publish_received_handler_user_data = binding;
+done:
 
-    client_options.lifecycle_event_handler = s_lifecycle_event_callback;
-    client_options.lifecycle_event_handler_user_data = binding;
+    s_aws_napi_mqtt5_operation_binding_destroy(binding);
+}
 
-    client_options.client_termination_handler = s_aws_mqtt5_client_binding_on_client_terminate;
-    client_options.client_termination_handler_user_data = binding;
+static void s_outbound_scheduler_on_publish_complete(struct aws_mqtt5_client_binding *client_binding);
 
-    binding->client = aws_mqtt5_client_new(allocator, &client_options);
-    if (binding->client == NULL) {
-        aws_napi_throw_last_error_with_context(env, "mqtt5_client_new - failed to create client");
-        goto cleanup;
-    }
+static void s_on_publish_complete(
+    enum aws_mqtt5_packet_type packet_type,
+    const void *packet,
+    int error_code,
+    void *complete_ctx) {
 
-    AWS_NAPI_CALL(env, napi_create_reference(env, node_external, 1, &binding->node_client_external_ref), {
-        napi_throw_error(env, NULL, "mqtt5_client_new - Failed to create one count reference to napi external");
-        goto cleanup;
-    });
+    struct aws_allocator *allocator = aws_napi_get_allocator();
+    struct aws_napi_mqtt5_operation_binding *binding = complete_ctx;
 
-    napi_client_wrapper = node_external;
+    binding->error_code = error_code;
 
-cleanup:
+    if (binding->is_scheduled) {
+        s_outbound_scheduler_on_publish_complete(binding->client_binding);
+    }
 
-    s_aws_napi_mqtt5_client_creation_storage_clean_up(&options_storage);
+    aws_napi_live_statistics_record_publish_complete(
+        &binding->client_binding->live_statistics, error_code, binding->payload_size);
+    s_refresh_live_operation_statistics(binding->client_binding);
 
-    return napi_client_wrapper;
-}
+    if (binding->is_persisted) {
+        aws_napi_mqtt5_persistent_queue_acknowledge(
+            binding->client_binding->persistent_queue, binding->persistent_record_id);
+    }
 
-napi_value aws_napi_mqtt5_client_start(napi_env env, napi_callback_info info) {
+    if (packet_type == AWS_MQTT5_PT_PUBACK) {
+        const struct aws_mqtt5_packet_puback_view *puback = packet;
+        if (aws_mqtt5_packet_puback_storage_init(&binding->packet_storage.puback, allocator, puback) ==
+            AWS_OP_SUCCESS) {
+            binding->valid_storage = AWS_MQTT5_PT_PUBACK;
+        } else if (binding->error_code == AWS_ERROR_SUCCESS) {
+            binding->error_code = aws_last_error();
+        }
+    }
 
-    napi_value node_args[1];
-    size_t num_args = AWS_ARRAY_SIZE(node_args);
-    napi_value *arg = &node_args[0];
-    AWS_NAPI_CALL(env, napi_get_cb_info(env, info, &num_args, node_args, NULL, NULL), {
-        napi_throw_error(env, NULL, "aws_napi_mqtt5_client_start - Failed to extract parameter array");
-        return NULL;
-    });
+    /* queue a callback in node's libuv thread */
+    AWS_NAPI_ENSURE(NULL, aws_napi_queue_threadsafe_function(binding->on_operation_completion, binding));
+}
 
-    if (num_args != AWS_ARRAY_SIZE(node_args)) {
-        napi_throw_error(env, NULL, "aws_napi_mqtt5_client_start - needs exactly 1 argument");
-        return NULL;
-    }
+/* Bytes charged against the offline queue's size limit: the variable-length content of the publish */
+static uint64_t s_compute_held_publish_size(const struct aws_mqtt5_packet_publish_view *publish_view) {
+    uint64_t size = publish_view->topic.len + publish_view->payload.len;
 
-    struct aws_mqtt5_client_binding *binding = NULL;
-    napi_value node_binding = *arg++;
-    AWS_NAPI_CALL(env, napi_get_value_external(env, node_binding, (void **)&binding), {
-        napi_throw_error(
-            env, NULL, "aws_napi_mqtt5_client_start - Failed to extract client binding from first argument");
-        return NULL;
-    });
+    if (publish_view->response_topic != NULL) {
+        size += publish_view->response_topic->len;
+    }
 
-    if (binding == NULL) {
-        napi_throw_error(env, NULL, "aws_napi_mqtt5_client_start - binding was null");
-        return NULL;
+    if (publish_view->correlation_data != NULL) {
+        size += publish_view->correlation_data->len;
     }
 
-    if (binding->client == NULL) {
-        napi_throw_error(env, NULL, "aws_napi_mqtt5_client_start - client was null");
-        return NULL;
+    if (publish_view->content_type != NULL) {
+        size += publish_view->content_type->len;
     }
 
-    if (aws_mqtt5_client_start(binding->client)) {
-        aws_napi_throw_last_error_with_context(
-            env, "aws_napi_mqtt5_client_start - Failure invoking aws_mqtt5_client_start");
-        return NULL;
+    for (size_t i = 0; i < publish_view->user_property_count; ++i) {
+        const struct aws_mqtt5_user_property *property = &publish_view->user_properties[i];
+        size += property->name.len + property->value.len;
     }
 
-    return NULL;
+    return size;
 }
 
-/* Persistent storage for a DISCONNECT packet. */
-struct aws_napi_mqtt5_packet_disconnect_storage {
-    uint32_t session_expiry_interval_seconds;
-
-    struct aws_byte_buf reason_string;
-    struct aws_byte_cursor reason_string_cursor;
+static uint64_t s_compute_held_publish_eviction_rank(
+    enum aws_napi_mqtt5_offline_queue_eviction_policy eviction_policy,
+    enum aws_mqtt5_qos qos,
+    uint32_t priority) {
 
-    struct aws_napi_mqtt5_user_property_storage user_properties;
+    switch (eviction_policy) {
+        case AWS_NAPI_MQTT5_OQEP_QOS0_FIRST:
+            return qos == AWS_MQTT5_QOS_AT_MOST_ONCE ? 0 : 1;
 
-    struct aws_byte_buf server_reference;
-    struct aws_byte_cursor server_reference_cursor;
-};
+        case AWS_NAPI_MQTT5_OQEP_LOWEST_PRIORITY_FIRST:
+            return priority;
 
-static void s_aws_napi_mqtt5_packet_disconnect_storage_clean_up(
-    struct aws_napi_mqtt5_packet_disconnect_storage *storage) {
-    aws_byte_buf_clean_up(&storage->reason_string);
+        default:
+            return 0;
+    }
+}
 
-    s_aws_mqtt5_user_properties_clean_up(&storage->user_properties);
+static void s_held_publish_destroy(struct aws_napi_mqtt5_held_publish *held_publish) {
+    aws_mqtt5_packet_publish_storage_clean_up(&held_publish->publish_storage);
 
-    aws_byte_buf_clean_up(&storage->server_reference);
+    aws_mem_release(held_publish->allocator, held_publish);
 }
 
-/* Extract a DISCONNECT packet view from a Napi object (AwsMqtt5PacketDisconnect) and persist its data in storage. */
-static int s_aws_napi_mqtt5_packet_disconnect_storage_initialize_from_js_object(
-    struct aws_mqtt5_client_binding *binding,
-    struct aws_napi_mqtt5_packet_disconnect_storage *disconnect_storage,
-    struct aws_mqtt5_packet_disconnect_view *disconnect_packet,
-    napi_env env,
-    napi_value node_disconnect_packet) {
-    uint32_t reason_code = 0;
-    PARSE_OPTIONAL_NAPI_PROPERTY(
-        AWS_NAPI_KEY_REASON_CODE,
-        "s_aws_napi_mqtt5_packet_disconnect_storage_initialize_from_js_object",
-        aws_napi_get_named_property_as_uint32(
-            env, node_disconnect_packet, AWS_NAPI_KEY_REASON_CODE, (uint32_t *)&reason_code),
-        { disconnect_packet->reason_code = (enum aws_mqtt5_disconnect_reason_code)reason_code; });
+/* Requires the offline queue lock */
+static void s_offline_queue_remove_held_publish(
+    struct aws_napi_mqtt5_offline_queue *offline_queue,
+    struct aws_napi_mqtt5_held_publish *held_publish) {
 
-    PARSE_OPTIONAL_NAPI_PROPERTY(
-        AWS_NAPI_KEY_SESSION_EXPIRY_INTERVAL_SECONDS,
-        "s_aws_napi_mqtt5_packet_disconnect_storage_initialize_from_js_object",
-        aws_napi_get_named_property_as_uint32(
-            env,
-            node_disconnect_packet,
-            AWS_NAPI_KEY_SESSION_EXPIRY_INTERVAL_SECONDS,
-            &disconnect_storage->session_expiry_interval_seconds),
-        { disconnect_packet->session_expiry_interval_seconds = &disconnect_storage->session_expiry_interval_seconds; });
+    aws_linked_list_remove(&held_publish->node);
 
-    PARSE_OPTIONAL_NAPI_PROPERTY(
-        AWS_NAPI_KEY_REASON_STRING,
-        "s_aws_napi_mqtt5_packet_disconnect_storage_initialize_from_js_object",
-        aws_napi_get_named_property_as_bytebuf(
-            env, node_disconnect_packet, AWS_NAPI_KEY_REASON_STRING, napi_string, &disconnect_storage->reason_string),
-        {
-            disconnect_storage->reason_string_cursor = aws_byte_cursor_from_buf(&disconnect_storage->reason_string);
-            disconnect_packet->reason_string = &disconnect_storage->reason_string_cursor;
-        });
+    struct aws_napi_mqtt5_held_publish *removed = NULL;
+    aws_priority_queue_remove(&offline_queue->eviction_order, &removed, &held_publish->eviction_node);
 
-    if (s_aws_mqtt5_user_properties_extract_from_js_object(
-            binding,
-            &disconnect_storage->user_properties,
-            env,
-            node_disconnect_packet,
-            &disconnect_packet->user_property_count,
-            &disconnect_packet->user_properties)) {
-        AWS_LOGF_ERROR(
-            AWS_LS_NODEJS_CRT_GENERAL,
-            "id=%p s_aws_napi_mqtt5_packet_disconnect_storage_initialize_from_js_object - failed to extract "
-            "userProperties",
-            (void *)binding->client);
-        return AWS_OP_ERR;
-    }
+    AWS_FATAL_ASSERT(offline_queue->held_publish_count > 0);
+    AWS_FATAL_ASSERT(offline_queue->held_publish_size >= held_publish->size);
+    --offline_queue->held_publish_count;
+    offline_queue->held_publish_size -= held_publish->size;
+}
 
-    /* Intentionally ignore server reference because it's a client error to send it */
+/* Must not be called with the offline queue lock held */
+static void s_fail_held_publishes(struct aws_linked_list *held_publishes, int error_code) {
+    while (!aws_linked_list_empty(held_publishes)) {
+        struct aws_linked_list_node *node = aws_linked_list_pop_front(held_publishes);
+        struct aws_napi_mqtt5_held_publish *held_publish =
+            AWS_CONTAINER_OF(node, struct aws_napi_mqtt5_held_publish, node);
 
-    return AWS_OP_SUCCESS;
+        s_on_publish_complete(AWS_MQTT5_PT_NONE, NULL, error_code, held_publish->operation);
+        s_held_publish_destroy(held_publish);
+    }
 }
 
-napi_value aws_napi_mqtt5_client_stop(napi_env env, napi_callback_info info) {
+static bool s_offline_queue_would_exceed_limits(
+    const struct aws_napi_mqtt5_offline_queue *offline_queue,
+    uint64_t publish_size) {
 
-    napi_value node_args[2];
-    size_t num_args = AWS_ARRAY_SIZE(node_args);
-    napi_value *arg = &node_args[0];
-    AWS_NAPI_CALL(env, napi_get_cb_info(env, info, &num_args, node_args, NULL, NULL), {
-        napi_throw_error(env, NULL, "aws_napi_mqtt5_client_stop - Failed to extract parameter array");
-        return NULL;
-    });
+    if (offline_queue->max_publish_count > 0 &&
+        offline_queue->held_publish_count + 1 > offline_queue->max_publish_count) {
+        return true;
+    }
 
-    if (num_args != AWS_ARRAY_SIZE(node_args)) {
-        napi_throw_error(env, NULL, "aws_napi_mqtt5_client_stop - needs exactly 2 arguments");
-        return NULL;
+    if (offline_queue->max_publish_size > 0 &&
+        offline_queue->held_publish_size + publish_size > offline_queue->max_publish_size) {
+        return true;
     }
 
-    struct aws_mqtt5_client_binding *binding = NULL;
-    napi_value node_binding = *arg++;
-    AWS_NAPI_CALL(env, napi_get_value_external(env, node_binding, (void **)&binding), {
-        napi_throw_error(
-            env, NULL, "aws_napi_mqtt5_client_stop - Failed to extract client binding from first argument");
-        return NULL;
-    });
+    return false;
+}
 
-    if (binding == NULL) {
-        napi_throw_error(env, NULL, "aws_napi_mqtt5_client_stop - binding was null");
-        return NULL;
+/*
+ * Invoked from the client's event loop thread on lifecycle changes.  On connection success, every held publish is
+ * handed to the native client in submission order.  Submission happens under the lock so that publishes made from
+ * node at the same time cannot overtake the held ones.
+ */
+static void s_offline_queue_set_connected(struct aws_mqtt5_client_binding *binding, bool is_connected) {
+    struct aws_napi_mqtt5_offline_queue *offline_queue = &binding->offline_queue;
+    if (!offline_queue->is_enabled) {
+        return;
     }
 
-    if (binding->client == NULL) {
-        napi_throw_error(env, NULL, "aws_napi_mqtt5_client_stop - client was null");
-        return NULL;
-    }
+    /* failures are completed once the lock is released, since completion may submit more publishes */
+    struct aws_linked_list failed_publishes;
+    aws_linked_list_init(&failed_publishes);
 
-    struct aws_napi_mqtt5_packet_disconnect_storage disconnect_storage;
-    AWS_ZERO_STRUCT(disconnect_storage);
+    aws_mutex_lock(&offline_queue->lock);
 
-    struct aws_mqtt5_packet_disconnect_view *disconnect_view_ptr = NULL;
-    struct aws_mqtt5_packet_disconnect_view disconnect_view;
-    AWS_ZERO_STRUCT(disconnect_view);
+    offline_queue->is_connected = is_connected;
 
-    napi_value node_disconnect_packet = *arg++;
-    if (!aws_napi_is_null_or_undefined(env, node_disconnect_packet)) {
-        if (s_aws_napi_mqtt5_packet_disconnect_storage_initialize_from_js_object(
-                binding, &disconnect_storage, &disconnect_view, env, node_disconnect_packet)) {
-            napi_throw_error(env, NULL, "aws_napi_mqtt5_client_stop - could not initialize disconnect packet");
-            goto done;
+    if (is_connected && !offline_queue->is_closed) {
+        while (!aws_linked_list_empty(&offline_queue->held_publishes)) {
+            struct aws_linked_list_node *node = aws_linked_list_front(&offline_queue->held_publishes);
+            struct aws_napi_mqtt5_held_publish *held_publish =
+                AWS_CONTAINER_OF(node, struct aws_napi_mqtt5_held_publish, node);
+
+            s_offline_queue_remove_held_publish(offline_queue, held_publish);
+
+            struct aws_mqtt5_publish_completion_options completion_options = {
+                .completion_callback = s_on_publish_complete,
+                .completion_user_data = held_publish->operation,
+            };
+
+            if (aws_mqtt5_client_publish(
+                    binding->client, &held_publish->publish_storage.storage_view, &completion_options)) {
+                held_publish->submit_error_code = aws_last_error();
+                aws_linked_list_push_back(&failed_publishes, &held_publish->node);
+                continue;
+            }
+
+            s_held_publish_destroy(held_publish);
         }
+    }
 
-        disconnect_view_ptr = &disconnect_view;
+    aws_mutex_unlock(&offline_queue->lock);
+
+    while (!aws_linked_list_empty(&failed_publishes)) {
+        struct aws_linked_list_node *node = aws_linked_list_pop_front(&failed_publishes);
+        struct aws_napi_mqtt5_held_publish *held_publish =
+            AWS_CONTAINER_OF(node, struct aws_napi_mqtt5_held_publish, node);
+
+        s_on_publish_complete(AWS_MQTT5_PT_NONE, NULL, held_publish->submit_error_code, held_publish->operation);
+        s_held_publish_destroy(held_publish);
     }
+}
 
-    if (aws_mqtt5_client_stop(binding->client, disconnect_view_ptr, NULL)) {
-        aws_napi_throw_last_error_with_context(
-            env, "aws_napi_mqtt5_client_stop - Failure invoking aws_mqtt5_client_stop");
-        goto done;
+/* Once the node client is closed, it will never connect again, so fail everything still held */
+static void s_offline_queue_close(struct aws_mqtt5_client_binding *binding) {
+    struct aws_napi_mqtt5_offline_queue *offline_queue = &binding->offline_queue;
+    if (!offline_queue->is_enabled) {
+        return;
     }
 
-done:
+    struct aws_linked_list held_publishes;
+    aws_linked_list_init(&held_publishes);
 
-    s_aws_napi_mqtt5_packet_disconnect_storage_clean_up(&disconnect_storage);
+    aws_mutex_lock(&offline_queue->lock);
+    offline_queue->is_closed = true;
+    while (!aws_linked_list_empty(&offline_queue->held_publishes)) {
+        struct aws_linked_list_node *node = aws_linked_list_front(&offline_queue->held_publishes);
+        struct aws_napi_mqtt5_held_publish *held_publish =
+            AWS_CONTAINER_OF(node, struct aws_napi_mqtt5_held_publish, node);
 
-    return NULL;
+        s_offline_queue_remove_held_publish(offline_queue, held_publish);
+        aws_linked_list_push_back(&held_publishes, &held_publish->node);
+    }
+    aws_mutex_unlock(&offline_queue->lock);
+
+    s_fail_held_publishes(&held_publishes, AWS_ERROR_MQTT5_CLIENT_TERMINATED);
 }
 
-struct aws_napi_mqtt5_operation_binding {
-    struct aws_allocator *allocator;
+/*
+ * Holds a publish in the offline queue if limits are configured and the client is not connected.  Publishes evicted
+ * to make room (possibly including this one) are failed once the lock is released.  Otherwise the publish is handed
+ * to the native client if submit_if_connected is set, or left to the caller with *is_consumed_out set to false.
+ */
+static int s_offline_queue_submit(
+    struct aws_mqtt5_client_binding *client_binding,
+    const struct aws_mqtt5_packet_publish_view *publish_view,
+    uint32_t priority,
+    struct aws_napi_mqtt5_operation_binding *operation,
+    bool submit_if_connected,
+    bool *is_consumed_out) {
 
-    struct aws_mqtt5_client_binding *client_binding;
+    struct aws_mqtt5_publish_completion_options completion_options = {
+        .completion_callback = s_on_publish_complete,
+        .completion_user_data = operation,
+    };
 
-    napi_threadsafe_function on_operation_completion;
+    struct aws_napi_mqtt5_offline_queue *offline_queue = &client_binding->offline_queue;
 
-    int error_code;
+    int result = AWS_OP_SUCCESS;
+    bool evict_incoming = false;
+    *is_consumed_out = true;
 
-    enum aws_mqtt5_packet_type valid_storage;
+    struct aws_linked_list evicted_publishes;
+    aws_linked_list_init(&evicted_publishes);
 
-    union {
-        struct aws_mqtt5_packet_suback_storage suback;
-        struct aws_mqtt5_packet_puback_storage puback;
-        struct aws_mqtt5_packet_unsuback_storage unsuback;
-    } packet_storage;
-};
+    aws_mutex_lock(&offline_queue->lock);
 
-static void s_aws_napi_mqtt5_operation_binding_destroy(struct aws_napi_mqtt5_operation_binding *binding) {
-    if (binding == NULL) {
-        return;
+    if (offline_queue->is_connected || offline_queue->is_closed) {
+        if (submit_if_connected) {
+            result = aws_mqtt5_client_publish(client_binding->client, publish_view, &completion_options);
+        } else {
+            *is_consumed_out = false;
+        }
+        goto done;
     }
 
-    binding->client_binding = s_aws_mqtt5_client_binding_release(binding->client_binding);
+    uint64_t publish_size = s_compute_held_publish_size(publish_view);
+    uint64_t eviction_rank =
+        s_compute_held_publish_eviction_rank(offline_queue->eviction_policy, publish_view->qos, priority);
 
-    AWS_CLEAN_THREADSAFE_FUNCTION(binding, on_operation_completion);
+    /* a publish that can never fit is evicted immediately rather than flushing everything else first */
+    if (offline_queue->max_publish_size > 0 && publish_size > offline_queue->max_publish_size) {
+        evict_incoming = true;
+    }
 
-    switch (binding->valid_storage) {
-        case AWS_MQTT5_PT_SUBACK:
-            aws_mqtt5_packet_suback_storage_clean_up(&binding->packet_storage.suback);
+    while (!evict_incoming && s_offline_queue_would_exceed_limits(offline_queue, publish_size)) {
+        void *top = NULL;
+        if (aws_priority_queue_top(&offline_queue->eviction_order, &top)) {
+            evict_incoming = true;
             break;
+        }
 
-        case AWS_MQTT5_PT_PUBACK:
-            aws_mqtt5_packet_puback_storage_clean_up(&binding->packet_storage.puback);
-            break;
+        struct aws_napi_mqtt5_held_publish *candidate = *(struct aws_napi_mqtt5_held_publish **)top;
 
-        case AWS_MQTT5_PT_UNSUBACK:
-            aws_mqtt5_packet_unsuback_storage_clean_up(&binding->packet_storage.unsuback);
+        /* the incoming publish is always the newest, so it only loses to a held publish of strictly higher rank */
+        if (eviction_rank < candidate->eviction_rank) {
+            evict_incoming = true;
             break;
+        }
 
-        default:
-            break;
+        s_offline_queue_remove_held_publish(offline_queue, candidate);
+        ++offline_queue->evicted_publish_count;
+        offline_queue->evicted_publish_size += candidate->size;
+        aws_linked_list_push_back(&evicted_publishes, &candidate->node);
     }
 
-    aws_mem_release(binding->allocator, binding);
-}
-
-static int s_create_napi_suback_packet(
-    napi_env env,
-    const struct aws_mqtt5_packet_suback_view *suback,
-    napi_value *packet_out) {
-
-    if (env == NULL) {
-        return aws_raise_error(AWS_CRT_NODEJS_ERROR_THREADSAFE_FUNCTION_NULL_NAPI_ENV);
+    if (evict_incoming) {
+        ++offline_queue->evicted_publish_count;
+        offline_queue->evicted_publish_size += publish_size;
+        goto done;
     }
 
-    napi_value napi_suback = NULL;
-    AWS_NAPI_CALL(
-        env, napi_create_object(env, &napi_suback), { return aws_raise_error(AWS_CRT_NODEJS_ERROR_NAPI_FAILURE); });
+    struct aws_napi_mqtt5_held_publish *held_publish =
+        aws_mem_calloc(client_binding->allocator, 1, sizeof(struct aws_napi_mqtt5_held_publish));
+    held_publish->allocator = client_binding->allocator;
+    held_publish->operation = operation;
+    held_publish->size = publish_size;
+    held_publish->eviction_rank = eviction_rank;
+    held_publish->sequence_number = offline_queue->next_sequence_number++;
+    aws_priority_queue_node_init(&held_publish->eviction_node);
 
-    if (aws_napi_attach_object_property_u32(napi_suback, env, AWS_NAPI_KEY_TYPE, (uint32_t)AWS_MQTT5_PT_SUBACK)) {
-        return AWS_OP_ERR;
+    if (aws_mqtt5_packet_publish_storage_init(&held_publish->publish_storage, held_publish->allocator, publish_view)) {
+        aws_mem_release(held_publish->allocator, held_publish);
+        result = AWS_OP_ERR;
+        goto done;
     }
 
-    if (aws_napi_attach_object_property_optional_string(
-            napi_suback, env, AWS_NAPI_KEY_REASON_STRING, suback->reason_string)) {
-        return AWS_OP_ERR;
+    if (aws_priority_queue_push_ref(&offline_queue->eviction_order, &held_publish, &held_publish->eviction_node)) {
+        s_held_publish_destroy(held_publish);
+        result = AWS_OP_ERR;
+        goto done;
     }
 
-    if (s_attach_object_property_user_properties(
-            napi_suback, env, suback->user_property_count, suback->user_properties)) {
-        return AWS_OP_ERR;
-    }
+    aws_linked_list_push_back(&offline_queue->held_publishes, &held_publish->node);
+    ++offline_queue->held_publish_count;
+    offline_queue->held_publish_size += publish_size;
 
-    size_t reason_code_count = suback->reason_code_count;
-    if (reason_code_count == 0) {
-        AWS_LOGF_ERROR(AWS_LS_NODEJS_CRT_GENERAL, "s_create_napi_suback_packet - missing reason codes");
-        return aws_raise_error(AWS_ERROR_INVALID_ARGUMENT);
+done:
+
+    aws_mutex_unlock(&offline_queue->lock);
+
+    if (evict_incoming) {
+        AWS_LOGF_DEBUG(
+            AWS_LS_NODEJS_CRT_GENERAL,
+            "id=%p s_submit_publish - evicting incoming publish to stay within offline queue limits",
+            (void *)client_binding->client);
+        s_on_publish_complete(AWS_MQTT5_PT_NONE, NULL, AWS_CRT_NODEJS_ERROR_MQTT5_OPERATION_EVICTED, operation);
     }
 
-    napi_value suback_code_array = NULL;
-    AWS_NAPI_CALL(env, napi_create_array_with_length(env, reason_code_count, &suback_code_array), {
-        return aws_raise_error(AWS_CRT_NODEJS_ERROR_NAPI_FAILURE);
-    });
+    s_fail_held_publishes(&evicted_publishes, AWS_CRT_NODEJS_ERROR_MQTT5_OPERATION_EVICTED);
 
-    for (size_t i = 0; i < reason_code_count; ++i) {
-        napi_value napi_reason_code = NULL;
-        AWS_NAPI_CALL(env, napi_create_uint32(env, (uint32_t)suback->reason_codes[i], &napi_reason_code), {
-            return aws_raise_error(AWS_CRT_NODEJS_ERROR_NAPI_FAILURE);
-        });
+    return result;
+}
 
-        AWS_NAPI_CALL(env, napi_set_element(env, suback_code_array, (uint32_t)i, napi_reason_code), {
-            return aws_raise_error(AWS_CRT_NODEJS_ERROR_NAPI_FAILURE);
-        });
+/* Hands a publish to the native client, or to the offline queue if limits are configured */
+static int s_submit_publish(
+    struct aws_mqtt5_client_binding *client_binding,
+    const struct aws_mqtt5_packet_publish_view *publish_view,
+    uint32_t priority,
+    struct aws_napi_mqtt5_operation_binding *operation) {
+
+    if (!client_binding->offline_queue.is_enabled) {
+        struct aws_mqtt5_publish_completion_options completion_options = {
+            .completion_callback = s_on_publish_complete,
+            .completion_user_data = operation,
+        };
+
+        return aws_mqtt5_client_publish(client_binding->client, publish_view, &completion_options);
     }
 
-    AWS_NAPI_CALL(env, napi_set_named_property(env, napi_suback, AWS_NAPI_KEY_REASON_CODES, suback_code_array), {
-        return aws_raise_error(AWS_CRT_NODEJS_ERROR_NAPI_FAILURE);
-    });
+    bool is_consumed = false;
+    return s_offline_queue_submit(client_binding, publish_view, priority, operation, true, &is_consumed);
+}
 
-    *packet_out = napi_suback;
+static void s_scheduled_publish_destroy(struct aws_napi_mqtt5_scheduled_publish *scheduled_publish) {
+    aws_mqtt5_packet_publish_storage_clean_up(&scheduled_publish->publish_storage);
 
-    return AWS_OP_SUCCESS;
+    aws_mem_release(scheduled_publish->allocator, scheduled_publish);
 }
 
-/* in-node/libuv-thread function to trigger the emission of an ATTEMPTING_CONNECT client lifecycle event */
-static void s_napi_on_subscribe_complete(napi_env env, napi_value function, void *context, void *user_data) {
-    (void)user_data;
+static uint32_t s_compute_publish_class(uint32_t priority) {
+    return aws_min_u32(priority, AWS_NAPI_MQTT5_PUBLISH_PRIORITY_COUNT - 1);
+}
 
-    struct aws_napi_mqtt5_operation_binding *binding = context;
+/*
+ * Smooth weighted round robin over the non-empty classes.  Requires the scheduler lock.  Returns NULL if nothing
+ * is queued.
+ */
+static struct aws_napi_mqtt5_scheduled_publish *s_outbound_scheduler_pop_next(
+    struct aws_napi_mqtt5_outbound_scheduler *scheduler) {
 
-    if (env) {
-        napi_value params[3];
-        const size_t num_params = AWS_ARRAY_SIZE(params);
+    struct aws_napi_mqtt5_publish_class *selected = NULL;
+    int64_t total_weight = 0;
 
-        /*
-         * If we can't resolve the weak ref to the mqtt5 client, then it's been garbage collected and we should not
-         * do anything.
-         */
-        params[0] = NULL;
-        if (napi_get_reference_value(env, binding->client_binding->node_mqtt5_client_ref, &params[0]) != napi_ok ||
-            params[0] == NULL) {
-            AWS_LOGF_INFO(
-                AWS_LS_NODEJS_CRT_GENERAL,
-                "s_napi_on_subscribe_complete - mqtt5_client node wrapper no longer resolvable");
-            goto done;
+    for (size_t i = 0; i < AWS_NAPI_MQTT5_PUBLISH_PRIORITY_COUNT; ++i) {
+        struct aws_napi_mqtt5_publish_class *publish_class = &scheduler->classes[i];
+        if (aws_linked_list_empty(&publish_class->queued_publishes)) {
+            continue;
         }
 
-        AWS_NAPI_CALL(env, napi_create_uint32(env, binding->error_code, &params[1]), { goto done; });
+        publish_class->current_weight += publish_class->weight;
+        total_weight += publish_class->weight;
 
-        if (binding->valid_storage == AWS_MQTT5_PT_SUBACK) {
-            if (s_create_napi_suback_packet(env, &binding->packet_storage.suback.storage_view, &params[2])) {
-                AWS_LOGF_ERROR(
-                    AWS_LS_NODEJS_CRT_GENERAL, "s_napi_on_subscribe_complete - could not build suback napi value");
-                goto done;
-            }
-        } else {
-            if (napi_get_undefined(env, &params[2]) != napi_ok) {
-                AWS_LOGF_ERROR(
-                    AWS_LS_NODEJS_CRT_GENERAL, "s_napi_on_subscribe_complete - could not get undefined napi value");
-                goto done;
-            }
+        /* ties go to the higher priority */
+        if (selected == NULL || publish_class->current_weight >= selected->current_weight) {
+            selected = publish_class;
         }
-
-        AWS_NAPI_ENSURE(
-            env,
-            aws_napi_dispatch_threadsafe_function(
-                env, binding->on_operation_completion, NULL, function, num_params, params));
     }
 
-done:
-
-    s_aws_napi_mqtt5_operation_binding_destroy(binding);
-}
+    if (selected == NULL) {
+        return NULL;
+    }
 
-static void s_on_subscribe_complete(
-    const struct aws_mqtt5_packet_suback_view *suback,
-    int error_code,
-    void *complete_ctx) {
+    selected->current_weight -= total_weight;
 
-    struct aws_allocator *allocator = aws_napi_get_allocator();
-    struct aws_napi_mqtt5_operation_binding *binding = complete_ctx;
+    struct aws_linked_list_node *node = aws_linked_list_pop_front(&selected->queued_publishes);
+    --selected->queued_count;
+    ++selected->submitted_count;
 
-    binding->error_code = error_code;
-    if (suback != NULL &&
-        aws_mqtt5_packet_suback_storage_init(&binding->packet_storage.suback, allocator, suback) == AWS_OP_SUCCESS) {
-        binding->valid_storage = AWS_MQTT5_PT_SUBACK;
-    } else if (binding->error_code == AWS_ERROR_SUCCESS) {
-        binding->error_code = aws_last_error();
+    /* an idle class should not bank credit while it has nothing to send */
+    if (aws_linked_list_empty(&selected->queued_publishes)) {
+        selected->current_weight = 0;
     }
 
-    /* queue a callback in node's libuv thread */
-    AWS_NAPI_ENSURE(NULL, aws_napi_queue_threadsafe_function(binding->on_operation_completion, binding));
+    return AWS_CONTAINER_OF(node, struct aws_napi_mqtt5_scheduled_publish, node);
 }
 
-struct aws_napi_mqtt5_subscribe_storage {
-    struct aws_array_list subscriptions;
-    struct aws_byte_buf topics;
+/*
+ * Hands queued publishes to the offline queue/native client while the in-flight limit allows.  Only one thread pumps
+ * at a time; any other caller leaves the work to it, and the pumping thread rechecks for room under the same lock
+ * that completions update it under.  Must not be called with any other binding lock held.
+ */
+static void s_outbound_scheduler_pump(struct aws_mqtt5_client_binding *client_binding) {
+    struct aws_napi_mqtt5_outbound_scheduler *scheduler = &client_binding->outbound_scheduler;
 
-    uint32_t subscription_identifier;
+    aws_mutex_lock(&scheduler->lock);
+    if (scheduler->is_pumping) {
+        aws_mutex_unlock(&scheduler->lock);
+        return;
+    }
+    scheduler->is_pumping = true;
 
-    struct aws_napi_mqtt5_user_property_storage user_properties;
-};
+    while (!scheduler->is_closed && scheduler->in_flight_publishes < scheduler->max_in_flight_publishes) {
+        struct aws_napi_mqtt5_scheduled_publish *scheduled_publish = s_outbound_scheduler_pop_next(scheduler);
+        if (scheduled_publish == NULL) {
+            break;
+        }
 
-static void s_aws_napi_mqtt5_subscribe_storage_clean_up(struct aws_napi_mqtt5_subscribe_storage *storage) {
-    aws_array_list_clean_up(&storage->subscriptions);
-    aws_byte_buf_clean_up(&storage->topics);
+        ++scheduler->in_flight_publishes;
+        aws_mutex_unlock(&scheduler->lock);
 
-    s_aws_mqtt5_user_properties_clean_up(&storage->user_properties);
-}
+        struct aws_napi_mqtt5_operation_binding *operation = scheduled_publish->operation;
+        if (s_submit_publish(
+                client_binding,
+                &scheduled_publish->publish_storage.storage_view,
+                scheduled_publish->priority,
+                operation)) {
+            s_on_publish_complete(AWS_MQTT5_PT_NONE, NULL, aws_last_error(), operation);
+        }
 
-static int s_aws_mqtt5_subscription_init_from_napi(
-    struct aws_mqtt5_subscription_view *subscription,
-    struct aws_mqtt5_client_binding *binding,
-    napi_env env,
-    napi_value node_subscription) {
+        s_scheduled_publish_destroy(scheduled_publish);
 
-    uint32_t qos = 0;
-    PARSE_REQUIRED_NAPI_PROPERTY(
-        AWS_NAPI_KEY_QOS,
-        "s_aws_mqtt5_subscription_init_from_napi",
-        aws_napi_get_named_property_as_uint32(env, node_subscription, AWS_NAPI_KEY_QOS, &qos),
-        { subscription->qos = qos; });
+        aws_mutex_lock(&scheduler->lock);
+    }
 
-    PARSE_OPTIONAL_NAPI_PROPERTY(
-        AWS_NAPI_KEY_NO_LOCAL,
-        "s_aws_mqtt5_subscription_init_from_napi",
-        aws_napi_get_named_property_as_boolean(env, node_subscription, AWS_NAPI_KEY_NO_LOCAL, &subscription->no_local),
-        {});
+    scheduler->is_pumping = false;
+    aws_mutex_unlock(&scheduler->lock);
+}
 
-    PARSE_OPTIONAL_NAPI_PROPERTY(
-        AWS_NAPI_KEY_RETAIN_AS_PUBLISHED,
-        "s_aws_mqtt5_subscription_init_from_napi",
-        aws_napi_get_named_property_as_boolean(
-            env, node_subscription, AWS_NAPI_KEY_RETAIN_AS_PUBLISHED, &subscription->retain_as_published),
-        {});
+static void s_outbound_scheduler_on_publish_complete(struct aws_mqtt5_client_binding *client_binding) {
+    struct aws_napi_mqtt5_outbound_scheduler *scheduler = &client_binding->outbound_scheduler;
 
-    uint32_t retain_handling_type = 0;
-    PARSE_OPTIONAL_NAPI_PROPERTY(
-        AWS_NAPI_KEY_RETAIN_HANDLING_TYPE,
-        "s_aws_mqtt5_subscription_init_from_napi",
-        aws_napi_get_named_property_as_uint32(
-            env, node_subscription, AWS_NAPI_KEY_RETAIN_HANDLING_TYPE, &retain_handling_type),
-        { subscription->retain_handling_type = retain_handling_type; });
+    aws_mutex_lock(&scheduler->lock);
+    AWS_FATAL_ASSERT(scheduler->in_flight_publishes > 0);
+    --scheduler->in_flight_publishes;
+    aws_mutex_unlock(&scheduler->lock);
 
-    return AWS_OP_SUCCESS;
+    s_outbound_scheduler_pump(client_binding);
 }
 
-static int s_aws_mqtt5_packet_subscribe_storage_init_from_napi(
-    struct aws_napi_mqtt5_subscribe_storage *subscribe_storage,
-    struct aws_mqtt5_packet_subscribe_view *subscribe_view,
-    struct aws_mqtt5_client_binding *binding,
-    napi_env env,
-    napi_value node_subscribe_packet) {
-    if (env == NULL) {
-        return aws_raise_error(AWS_CRT_NODEJS_ERROR_THREADSAFE_FUNCTION_NULL_NAPI_ENV);
+/*
+ * Queues a publish behind others of its priority class, or submits it right away when nothing is queued and the
+ * in-flight limit allows.  Synchronous submission failures are raised, later ones complete the operation.
+ *
+ * While the client is offline, publishes go straight to the offline queue when it has limits, so that they are
+ * bounded and evicted by its policy rather than piling up in the class queues.
+ */
+static int s_schedule_publish(
+    struct aws_mqtt5_client_binding *client_binding,
+    const struct aws_mqtt5_packet_publish_view *publish_view,
+    uint32_t priority,
+    struct aws_napi_mqtt5_operation_binding *operation) {
+
+    struct aws_napi_mqtt5_outbound_scheduler *scheduler = &client_binding->outbound_scheduler;
+    if (!scheduler->is_enabled) {
+        return s_submit_publish(client_binding, publish_view, priority, operation);
+    }
+
+    if (client_binding->offline_queue.is_enabled) {
+        bool is_consumed = false;
+        int result = s_offline_queue_submit(client_binding, publish_view, priority, operation, false, &is_consumed);
+        if (is_consumed) {
+            return result;
+        }
     }
 
-    napi_value napi_subscriptions = NULL;
-    if (AWS_NGNPR_VALID_VALUE !=
-        aws_napi_get_named_property(
-            env, node_subscribe_packet, AWS_NAPI_KEY_SUBSCRIPTIONS, napi_object, &napi_subscriptions)) {
-        AWS_LOGF_ERROR(
-            AWS_LS_NODEJS_CRT_GENERAL,
-            "id=%p s_aws_mqtt5_packet_subscribe_storage_init_from_napi - missing require parameter: subscriptions",
-            (void *)binding->client);
-        return aws_raise_error(AWS_ERROR_INVALID_ARGUMENT);
-    }
+    operation->is_scheduled = true;
 
-    /* how many subscriptions and total topic length */
-    uint32_t subscription_count = 0;
-    AWS_NAPI_CALL(env, napi_get_array_length(env, napi_subscriptions, &subscription_count), {
-        AWS_LOGF_ERROR(
-            AWS_LS_NODEJS_CRT_GENERAL,
-            "id=%p s_aws_mqtt5_packet_subscribe_storage_init_from_napi - subscriptions is not an array",
-            (void *)binding->client);
-        return aws_raise_error(AWS_ERROR_INVALID_ARGUMENT);
-    });
+    aws_mutex_lock(&scheduler->lock);
 
-    size_t topic_length_sum = 0;
-    for (uint32_t i = 0; i < subscription_count; ++i) {
-        napi_value napi_subscription = NULL;
-        AWS_NAPI_CALL(env, napi_get_element(env, napi_subscriptions, i, &napi_subscription), { return AWS_OP_ERR; });
+    bool is_idle = !scheduler->is_closed && scheduler->in_flight_publishes < scheduler->max_in_flight_publishes;
+    for (size_t i = 0; is_idle && i < AWS_NAPI_MQTT5_PUBLISH_PRIORITY_COUNT; ++i) {
+        is_idle = aws_linked_list_empty(&scheduler->classes[i].queued_publishes);
+    }
 
-        struct aws_byte_buf topic_filter_buf;
-        AWS_ZERO_STRUCT(topic_filter_buf);
+    if (is_idle) {
+        ++scheduler->in_flight_publishes;
+        ++scheduler->classes[s_compute_publish_class(priority)].submitted_count;
+        aws_mutex_unlock(&scheduler->lock);
 
-        bool success = AWS_NGNPR_VALID_VALUE ==
-                       aws_napi_get_named_property_as_bytebuf(
-                           env, napi_subscription, AWS_NAPI_KEY_TOPIC_FILTER, napi_string, &topic_filter_buf);
+        if (s_submit_publish(client_binding, publish_view, priority, operation)) {
+            int error_code = aws_last_error();
+            operation->is_scheduled = false;
+            s_outbound_scheduler_on_publish_complete(client_binding);
+            return aws_raise_error(error_code);
+        }
 
-        topic_length_sum += topic_filter_buf.len;
+        return AWS_OP_SUCCESS;
+    }
 
-        aws_byte_buf_clean_up(&topic_filter_buf);
-        if (!success) {
-            AWS_LOGF_ERROR(
-                AWS_LS_NODEJS_CRT_GENERAL,
-                "id=%p s_aws_mqtt5_packet_subscribe_storage_init_from_napi - missing require parameter: topicFilter",
-                (void *)binding->client);
-            return aws_raise_error(AWS_ERROR_INVALID_ARGUMENT);
-        }
+    if (scheduler->is_closed) {
+        aws_mutex_unlock(&scheduler->lock);
+        operation->is_scheduled = false;
+        return aws_raise_error(AWS_ERROR_MQTT5_CLIENT_TERMINATED);
     }
 
-    struct aws_allocator *allocator = aws_napi_get_allocator();
+    struct aws_napi_mqtt5_scheduled_publish *scheduled_publish =
+        aws_mem_calloc(client_binding->allocator, 1, sizeof(struct aws_napi_mqtt5_scheduled_publish));
+    scheduled_publish->allocator = client_binding->allocator;
+    scheduled_publish->operation = operation;
+    scheduled_publish->priority = priority;
 
-    if (aws_array_list_init_dynamic(
-            &subscribe_storage->subscriptions,
-            allocator,
-            subscription_count,
-            sizeof(struct aws_mqtt5_subscription_view))) {
+    if (aws_mqtt5_packet_publish_storage_init(
+            &scheduled_publish->publish_storage, scheduled_publish->allocator, publish_view)) {
+        aws_mutex_unlock(&scheduler->lock);
+        aws_mem_release(scheduled_publish->allocator, scheduled_publish);
+        operation->is_scheduled = false;
         return AWS_OP_ERR;
     }
 
-    if (aws_byte_buf_init(&subscribe_storage->topics, allocator, topic_length_sum)) {
-        return AWS_OP_ERR;
-    }
+    struct aws_napi_mqtt5_publish_class *publish_class = &scheduler->classes[s_compute_publish_class(priority)];
+    aws_linked_list_push_back(&publish_class->queued_publishes, &scheduled_publish->node);
+    ++publish_class->queued_count;
 
-    for (uint32_t i = 0; i < subscription_count; ++i) {
-        napi_value napi_subscription = NULL;
-        AWS_NAPI_CALL(env, napi_get_element(env, napi_subscriptions, i, &napi_subscription), { return AWS_OP_ERR; });
+    aws_mutex_unlock(&scheduler->lock);
 
-        struct aws_byte_buf topic_filter_buf;
-        AWS_ZERO_STRUCT(topic_filter_buf);
+    /* room may have opened up between the check above and the enqueue */
+    s_outbound_scheduler_pump(client_binding);
 
-        aws_napi_get_named_property_as_bytebuf(
-            env, napi_subscription, AWS_NAPI_KEY_TOPIC_FILTER, napi_string, &topic_filter_buf);
+    return AWS_OP_SUCCESS;
+}
 
-        struct aws_mqtt5_subscription_view subscription;
-        AWS_ZERO_STRUCT(subscription);
+/* Once the node client is closed, queued publishes will never be submitted, so fail them */
+static void s_outbound_scheduler_close(struct aws_mqtt5_client_binding *binding) {
+    struct aws_napi_mqtt5_outbound_scheduler *scheduler = &binding->outbound_scheduler;
+    if (!scheduler->is_enabled) {
+        return;
+    }
 
-        subscription.topic_filter = aws_byte_cursor_from_buf(&topic_filter_buf);
+    struct aws_linked_list queued_publishes;
+    aws_linked_list_init(&queued_publishes);
 
-        bool success =
-            aws_byte_buf_append_and_update(&subscribe_storage->topics, &subscription.topic_filter) == AWS_OP_SUCCESS;
+    aws_mutex_lock(&scheduler->lock);
+    scheduler->is_closed = true;
+    for (size_t i = 0; i < AWS_NAPI_MQTT5_PUBLISH_PRIORITY_COUNT; ++i) {
+        struct aws_napi_mqtt5_publish_class *publish_class = &scheduler->classes[i];
+        while (!aws_linked_list_empty(&publish_class->queued_publishes)) {
+            aws_linked_list_push_back(&queued_publishes, aws_linked_list_pop_front(&publish_class->queued_publishes));
+        }
+        publish_class->queued_count = 0;
+    }
+    aws_mutex_unlock(&scheduler->lock);
 
-        aws_byte_buf_clean_up(&topic_filter_buf);
+    while (!aws_linked_list_empty(&queued_publishes)) {
+        struct aws_linked_list_node *node = aws_linked_list_pop_front(&queued_publishes);
+        struct aws_napi_mqtt5_scheduled_publish *scheduled_publish =
+            AWS_CONTAINER_OF(node, struct aws_napi_mqtt5_scheduled_publish, node);
 
-        if (!success || s_aws_mqtt5_subscription_init_from_napi(&subscription, binding, env, napi_subscription)) {
-            return AWS_OP_ERR;
-        }
+        /* never counted as in flight */
+        scheduled_publish->operation->is_scheduled = false;
+        s_on_publish_complete(AWS_MQTT5_PT_NONE, NULL, AWS_ERROR_MQTT5_CLIENT_TERMINATED, scheduled_publish->operation);
+        s_scheduled_publish_destroy(scheduled_publish);
+    }
+}
 
-        aws_array_list_push_back(&subscribe_storage->subscriptions, &subscription);
+/*
+ * Shared tail of the publish entry points.  Reads the node-specific publish options, persists the publish if needed
+ * and hands it to the client.  The view's data only needs to live until this returns.  Raises an error on failure.
+ */
+static int s_publish_from_view(
+    napi_env env,
+    struct aws_mqtt5_client_binding *client_binding,
+    const struct aws_mqtt5_packet_publish_view *publish_view,
+    napi_value node_publish_options,
+    napi_value completion_callback) {
+
+    struct aws_allocator *allocator = aws_napi_get_allocator();
+
+    uint32_t priority = 0;
+    if (!aws_napi_is_null_or_undefined(env, node_publish_options)) {
+        if (aws_napi_get_named_property_as_uint32(env, node_publish_options, AWS_NAPI_KEY_PRIORITY, &priority) ==
+            AWS_NGNPR_INVALID_VALUE) {
+            AWS_LOGF_ERROR(
+                AWS_LS_NODEJS_CRT_GENERAL,
+                "id=%p s_publish_from_view - invalid publish priority",
+                (void *)client_binding->client);
+            return aws_raise_error(AWS_ERROR_INVALID_ARGUMENT);
+        }
     }
 
-    subscribe_view->subscription_count = subscription_count;
-    subscribe_view->subscriptions = subscribe_storage->subscriptions.data;
+    struct aws_napi_mqtt5_operation_binding *binding =
+        aws_mem_calloc(allocator, 1, sizeof(struct aws_napi_mqtt5_operation_binding));
+    binding->allocator = allocator;
+    binding->client_binding = s_aws_mqtt5_client_binding_acquire(client_binding);
+    binding->payload_size = publish_view->payload.len;
 
-    PARSE_OPTIONAL_NAPI_PROPERTY(
-        AWS_NAPI_KEY_SUBSCRIPTION_IDENTIFIER,
-        "s_aws_mqtt5_packet_subscribe_storage_init_from_napi",
-        aws_napi_get_named_property_as_uint32(
+    AWS_NAPI_CALL(
+        env,
+        aws_napi_create_threadsafe_function(
             env,
-            node_subscribe_packet,
-            AWS_NAPI_KEY_SUBSCRIPTION_IDENTIFIER,
-            &subscribe_storage->subscription_identifier),
-        { subscribe_view->subscription_identifier = &subscribe_storage->subscription_identifier; });
-
-    if (s_aws_mqtt5_user_properties_extract_from_js_object(
+            completion_callback,
+            "aws_mqtt5_on_publish_complete",
+            s_napi_on_publish_complete,
             binding,
-            &subscribe_storage->user_properties,
-            env,
-            node_subscribe_packet,
-            &subscribe_view->user_property_count,
-            &subscribe_view->user_properties)) {
-        AWS_LOGF_ERROR(
-            AWS_LS_NODEJS_CRT_GENERAL,
-            "s_aws_mqtt5_packet_subscribe_storage_init_from_napi - failed to extract userProperties");
-        return AWS_OP_ERR;
+            &binding->on_operation_completion),
+        {
+            aws_raise_error(AWS_CRT_NODEJS_ERROR_NAPI_FAILURE);
+            goto error;
+        });
+
+    if (client_binding->persistent_queue != NULL && publish_view->qos == AWS_MQTT5_QOS_AT_LEAST_ONCE) {
+        if (aws_napi_mqtt5_persistent_queue_append(
+                client_binding->persistent_queue, publish_view, &binding->persistent_record_id)) {
+            goto error;
+        }
+        binding->is_persisted = true;
+    }
+
+    if (s_schedule_publish(client_binding, publish_view, priority, binding)) {
+        if (binding->is_persisted) {
+            int error_code = aws_last_error();
+            aws_napi_mqtt5_persistent_queue_acknowledge(
+                client_binding->persistent_queue, binding->persistent_record_id);
+            aws_raise_error(error_code);
+        }
+        goto error;
     }
 
+    s_refresh_live_operation_statistics(client_binding);
+
     return AWS_OP_SUCCESS;
-}
 
-napi_value aws_napi_mqtt5_client_subscribe(napi_env env, napi_callback_info info) {
-    struct aws_allocator *allocator = aws_napi_get_allocator();
+error:
 
-    napi_value node_args[3];
+    s_aws_napi_mqtt5_operation_binding_destroy(binding);
+
+    return AWS_OP_ERR;
+}
+
+napi_value aws_napi_mqtt5_client_publish(napi_env env, napi_callback_info info) {
+    napi_value node_args[4];
     size_t num_args = AWS_ARRAY_SIZE(node_args);
     napi_value *arg = &node_args[0];
     AWS_NAPI_CALL(env, napi_get_cb_info(env, info, &num_args, node_args, NULL, NULL), {
-        napi_throw_error(env, NULL, "aws_napi_mqtt5_client_subscribe - Failed to extract parameter array");
+        napi_throw_error(env, NULL, "aws_napi_mqtt5_client_publish - Failed to extract parameter array");
         return NULL;
     });
 
     if (num_args != AWS_ARRAY_SIZE(node_args)) {
-        napi_throw_error(env, NULL, "aws_napi_mqtt5_client_subscribe - needs exactly 3 arguments");
+        napi_throw_error(env, NULL, "aws_napi_mqtt5_client_publish - needs exactly 4 arguments");
         return NULL;
     }
 
-    bool successful = false;
     struct aws_mqtt5_client_binding *client_binding = NULL;
     napi_value node_binding = *arg++;
     AWS_NAPI_CALL(env, napi_get_value_external(env, node_binding, (void **)&client_binding), {
         napi_throw_error(
-            env, NULL, "aws_napi_mqtt5_client_subscribe - Failed to extract client binding from first argument");
+            env, NULL, "aws_napi_mqtt5_client_publish - Failed to extract client binding from first argument");
         return NULL;
     });
 
     if (client_binding == NULL) {
-        napi_throw_error(env, NULL, "aws_napi_mqtt5_client_subscribe - binding was null");
+        napi_throw_error(env, NULL, "aws_napi_mqtt5_client_publish - binding was null");
         return NULL;
     }
 
     if (client_binding->client == NULL) {
-        napi_throw_error(env, NULL, "aws_napi_mqtt5_client_subscribe - client was null");
+        napi_throw_error(env, NULL, "aws_napi_mqtt5_client_publish - client was null");
         return NULL;
     }
 
-    struct aws_napi_mqtt5_operation_binding *binding =
-        aws_mem_calloc(allocator, 1, sizeof(struct aws_napi_mqtt5_operation_binding));
-    binding->allocator = allocator;
-    binding->client_binding = s_aws_mqtt5_client_binding_acquire(client_binding);
-
-    napi_value node_subscribe_packet = *arg++;
+    napi_value node_publish_packet = *arg++;
 
-    struct aws_napi_mqtt5_subscribe_storage subscribe_storage;
-    AWS_ZERO_STRUCT(subscribe_storage);
-    struct aws_mqtt5_packet_subscribe_view subscribe_view;
-    AWS_ZERO_STRUCT(subscribe_view);
-    if (s_aws_mqtt5_packet_subscribe_storage_init_from_napi(
-            &subscribe_storage, &subscribe_view, client_binding, env, node_subscribe_packet)) {
-        napi_throw_error(env, NULL, "aws_napi_mqtt5_client_subscribe - storage init failure");
+    struct aws_napi_mqtt5_publish_storage publish_storage;
+    AWS_ZERO_STRUCT(publish_storage);
+    struct aws_mqtt5_packet_publish_view publish_view;
+    AWS_ZERO_STRUCT(publish_view);
+    if (s_init_publish_options_from_napi(client_binding, env, node_publish_packet, &publish_view, &publish_storage)) {
+        napi_throw_error(env, NULL, "aws_napi_mqtt5_client_publish - storage init failure");
         goto done;
     }
 
+    napi_value node_publish_options = *arg++;
     napi_value completion_callback = *arg++;
-    AWS_NAPI_CALL(
-        env,
-        aws_napi_create_threadsafe_function(
-            env,
-            completion_callback,
-            "aws_mqtt5_on_subsription_complete",
-            s_napi_on_subscribe_complete,
-            binding,
-            &binding->on_operation_completion),
-        {
-            napi_throw_error(env, NULL, "aws_napi_mqtt5_client_subscribe - failed to create threadsafe function");
-            goto done;
-        });
 
-    struct aws_mqtt5_subscribe_completion_options completion_options = {
-        .completion_callback = s_on_subscribe_complete,
-        .completion_user_data = binding,
-    };
-
-    if (aws_mqtt5_client_subscribe(client_binding->client, &subscribe_view, &completion_options)) {
-        napi_throw_error(env, NULL, "aws_napi_mqtt5_client_subscribe - failure invoking native client subscribe");
+    if (s_publish_from_view(env, client_binding, &publish_view, node_publish_options, completion_callback)) {
+        aws_napi_throw_last_error_with_context(env, "aws_napi_mqtt5_client_publish - failed to submit publish");
         goto done;
     }
 
-    successful = true;
+done:
+
+    s_aws_napi_mqtt5_publish_storage_clean_up(&publish_storage);
+
+    return NULL;
+}
+
+/*
+ * A publish packet whose fields, other than the payload, were extracted from node once and are reused for every
+ * publish made from it.
+ */
+struct aws_napi_mqtt5_prepared_publish {
+    struct aws_allocator *allocator;
+    struct aws_napi_mqtt5_publish_storage publish_storage;
+    struct aws_mqtt5_packet_publish_view publish_view;
+};
+
+static void s_prepared_publish_finalize(napi_env env, void *finalize_data, void *finalize_hint) {
+    (void)env;
+    (void)finalize_hint;
+
+    struct aws_napi_mqtt5_prepared_publish *prepared_publish = finalize_data;
+    s_aws_napi_mqtt5_publish_storage_clean_up(&prepared_publish->publish_storage);
+    aws_mem_release(prepared_publish->allocator, prepared_publish);
+}
+
+napi_value aws_napi_mqtt5_client_prepare_publish(napi_env env, napi_callback_info info) {
+    struct aws_allocator *allocator = aws_napi_get_allocator();
+
+    napi_value node_args[2];
+    size_t num_args = AWS_ARRAY_SIZE(node_args);
+    AWS_NAPI_CALL(env, napi_get_cb_info(env, info, &num_args, node_args, NULL, NULL), {
+        napi_throw_error(env, NULL, "aws_napi_mqtt5_client_prepare_publish - Failed to extract parameter array");
+        return NULL;
+    });
+
+    if (num_args != AWS_ARRAY_SIZE(node_args)) {
+        napi_throw_error(env, NULL, "aws_napi_mqtt5_client_prepare_publish - needs exactly 2 arguments");
+        return NULL;
+    }
+
+    struct aws_mqtt5_client_binding *client_binding = NULL;
+    AWS_NAPI_CALL(env, napi_get_value_external(env, node_args[0], (void **)&client_binding), {
+        napi_throw_error(
+            env, NULL, "aws_napi_mqtt5_client_prepare_publish - Failed to extract client binding from first argument");
+        return NULL;
+    });
+
+    if (client_binding == NULL) {
+        napi_throw_error(env, NULL, "aws_napi_mqtt5_client_prepare_publish - binding was null");
+        return NULL;
+    }
+
+    struct aws_napi_mqtt5_prepared_publish *prepared_publish =
+        aws_mem_calloc(allocator, 1, sizeof(struct aws_napi_mqtt5_prepared_publish));
+    prepared_publish->allocator = allocator;
+
+    if (s_init_publish_options_from_napi(
+            client_binding, env, node_args[1], &prepared_publish->publish_view, &prepared_publish->publish_storage)) {
+        napi_throw_error(env, NULL, "aws_napi_mqtt5_client_prepare_publish - storage init failure");
+        goto error;
+    }
+
+    /* the payload is supplied with each publish */
+    aws_byte_buf_clean_up(&prepared_publish->publish_storage.payload);
+    AWS_ZERO_STRUCT(prepared_publish->publish_view.payload);
+
+    napi_value node_external = NULL;
+    AWS_NAPI_CALL(
+        env, napi_create_external(env, prepared_publish, s_prepared_publish_finalize, NULL, &node_external), {
+            napi_throw_error(env, NULL, "aws_napi_mqtt5_client_prepare_publish - Failed to create n-api external");
+            goto error;
+        });
 
-done:
+    return node_external;
 
-    s_aws_napi_mqtt5_subscribe_storage_clean_up(&subscribe_storage);
+error:
 
-    if (!successful) {
-        s_aws_napi_mqtt5_operation_binding_destroy(binding);
-    }
+    s_prepared_publish_finalize(env, prepared_publish, NULL);
 
     return NULL;
 }
 
-static int s_create_napi_unsuback_packet(
-    napi_env env,
-    const struct aws_mqtt5_packet_unsuback_view *unsuback,
-    napi_value *packet_out) {
+napi_value aws_napi_mqtt5_client_publish_prepared(napi_env env, napi_callback_info info) {
+    napi_value node_args[5];
+    size_t num_args = AWS_ARRAY_SIZE(node_args);
+    napi_value *arg = &node_args[0];
+    AWS_NAPI_CALL(env, napi_get_cb_info(env, info, &num_args, node_args, NULL, NULL), {
+        napi_throw_error(env, NULL, "aws_napi_mqtt5_client_publish_prepared - Failed to extract parameter array");
+        return NULL;
+    });
 
-    if (env == NULL) {
-        return aws_raise_error(AWS_CRT_NODEJS_ERROR_THREADSAFE_FUNCTION_NULL_NAPI_ENV);
+    if (num_args != AWS_ARRAY_SIZE(node_args)) {
+        napi_throw_error(env, NULL, "aws_napi_mqtt5_client_publish_prepared - needs exactly 5 arguments");
+        return NULL;
     }
 
-    napi_value napi_unsuback = NULL;
-    AWS_NAPI_CALL(
-        env, napi_create_object(env, &napi_unsuback), { return aws_raise_error(AWS_CRT_NODEJS_ERROR_NAPI_FAILURE); });
+    struct aws_mqtt5_client_binding *client_binding = NULL;
+    AWS_NAPI_CALL(env, napi_get_value_external(env, *arg++, (void **)&client_binding), {
+        napi_throw_error(
+            env, NULL, "aws_napi_mqtt5_client_publish_prepared - Failed to extract client binding from first argument");
+        return NULL;
+    });
 
-    if (aws_napi_attach_object_property_u32(napi_unsuback, env, AWS_NAPI_KEY_TYPE, (uint32_t)AWS_MQTT5_PT_UNSUBACK)) {
-        return AWS_OP_ERR;
+    if (client_binding == NULL) {
+        napi_throw_error(env, NULL, "aws_napi_mqtt5_client_publish_prepared - binding was null");
+        return NULL;
     }
 
-    if (aws_napi_attach_object_property_optional_string(
-            napi_unsuback, env, AWS_NAPI_KEY_REASON_STRING, unsuback->reason_string)) {
-        return AWS_OP_ERR;
+    if (client_binding->client == NULL) {
+        napi_throw_error(env, NULL, "aws_napi_mqtt5_client_publish_prepared - client was null");
+        return NULL;
     }
 
-    if (s_attach_object_property_user_properties(
-            napi_unsuback, env, unsuback->user_property_count, unsuback->user_properties)) {
-        return AWS_OP_ERR;
+    struct aws_napi_mqtt5_prepared_publish *prepared_publish = NULL;
+    AWS_NAPI_CALL(env, napi_get_value_external(env, *arg++, (void **)&prepared_publish), {
+        napi_throw_error(
+            env,
+            NULL,
+            "aws_napi_mqtt5_client_publish_prepared - Failed to extract prepared publish from second argument");
+        return NULL;
+    });
+
+    if (prepared_publish == NULL) {
+        napi_throw_error(env, NULL, "aws_napi_mqtt5_client_publish_prepared - prepared publish was null");
+        return NULL;
     }
 
-    size_t reason_code_count = unsuback->reason_code_count;
-    if (reason_code_count == 0) {
-        AWS_LOGF_ERROR(AWS_LS_NODEJS_CRT_GENERAL, "s_create_napi_unsuback_packet - missing reason codes");
-        return aws_raise_error(AWS_ERROR_INVALID_ARGUMENT);
+    /*
+     * Binary payloads are referenced in place and string payloads are encoded into the binding's scratch buffer.
+     * Either way the client takes the only copy of the packet when the publish is queued.
+     */
+    struct aws_byte_cursor payload_cur;
+    AWS_ZERO_STRUCT(payload_cur);
+    napi_value node_payload = *arg++;
+    if (!aws_napi_is_null_or_undefined(env, node_payload)) {
+        AWS_NAPI_CALL(
+            env,
+            aws_napi_borrow_byte_cursor_from_napi(
+                env, node_payload, &client_binding->publish_payload_scratch, &payload_cur),
+            {
+                napi_throw_type_error(env, NULL, "aws_napi_mqtt5_client_publish_prepared - invalid payload");
+                aws_napi_trim_scratch_buf(&client_binding->publish_payload_scratch);
+                return NULL;
+            });
     }
 
-    napi_value unsuback_code_array = NULL;
-    AWS_NAPI_CALL(env, napi_create_array_with_length(env, reason_code_count, &unsuback_code_array), {
-        return aws_raise_error(AWS_CRT_NODEJS_ERROR_NAPI_FAILURE);
-    });
+    struct aws_mqtt5_packet_publish_view publish_view = prepared_publish->publish_view;
+    publish_view.payload = payload_cur;
 
-    for (size_t i = 0; i < reason_code_count; ++i) {
-        napi_value napi_reason_code = NULL;
-        AWS_NAPI_CALL(env, napi_create_uint32(env, (uint32_t)unsuback->reason_codes[i], &napi_reason_code), {
-            return aws_raise_error(AWS_CRT_NODEJS_ERROR_NAPI_FAILURE);
-        });
+    napi_value node_publish_options = *arg++;
+    napi_value completion_callback = *arg++;
 
-        AWS_NAPI_CALL(env, napi_set_element(env, unsuback_code_array, (uint32_t)i, napi_reason_code), {
-            return aws_raise_error(AWS_CRT_NODEJS_ERROR_NAPI_FAILURE);
-        });
+    if (s_publish_from_view(env, client_binding, &publish_view, node_publish_options, completion_callback)) {
+        aws_napi_throw_last_error_with_context(
+            env, "aws_napi_mqtt5_client_publish_prepared - failed to submit publish");
     }
 
-    AWS_NAPI_CALL(env, napi_set_named_property(env, napi_unsuback, AWS_NAPI_KEY_REASON_CODES, unsuback_code_array), {
-        return aws_raise_error(AWS_CRT_NODEJS_ERROR_NAPI_FAILURE);
-    });
-
-    *packet_out = napi_unsuback;
+    aws_napi_trim_scratch_buf(&client_binding->publish_payload_scratch);
 
-    return AWS_OP_SUCCESS;
+    return NULL;
 }
 
-/* in-node/libuv-thread function to trigger the emission of an ATTEMPTING_CONNECT client lifecycle event */
-static void s_napi_on_unsubscribe_complete(napi_env env, napi_value function, void *context, void *user_data) {
-    (void)user_data;
+/* Adds an array of per-priority outbound scheduler queue depths, lowest priority first */
+static int s_attach_outbound_priority_statistics(
+    napi_env env,
+    struct aws_mqtt5_client_binding *binding,
+    napi_value napi_stats) {
 
-    struct aws_napi_mqtt5_operation_binding *binding = context;
+    struct aws_napi_mqtt5_outbound_scheduler *scheduler = &binding->outbound_scheduler;
 
-    if (env) {
-        napi_value params[3];
-        const size_t num_params = AWS_ARRAY_SIZE(params);
+    uint64_t queued_counts[AWS_NAPI_MQTT5_PUBLISH_PRIORITY_COUNT];
+    uint64_t submitted_counts[AWS_NAPI_MQTT5_PUBLISH_PRIORITY_COUNT];
+    aws_mutex_lock(&scheduler->lock);
+    for (size_t i = 0; i < AWS_NAPI_MQTT5_PUBLISH_PRIORITY_COUNT; ++i) {
+        queued_counts[i] = scheduler->classes[i].queued_count;
+        submitted_counts[i] = scheduler->classes[i].submitted_count;
+    }
+    aws_mutex_unlock(&scheduler->lock);
 
-        /*
-         * If we can't resolve the weak ref to the mqtt5 client, then it's been garbage collected and we should not
-         * do anything.
-         */
-        params[0] = NULL;
-        if (napi_get_reference_value(env, binding->client_binding->node_mqtt5_client_ref, &params[0]) != napi_ok ||
-            params[0] == NULL) {
-            AWS_LOGF_INFO(
-                AWS_LS_NODEJS_CRT_GENERAL,
-                "s_napi_on_unsubscribe_complete - mqtt5_client node wrapper no longer resolvable");
-            goto done;
-        }
+    napi_value napi_classes = NULL;
+    AWS_NAPI_CALL(env, napi_create_array_with_length(env, AWS_NAPI_MQTT5_PUBLISH_PRIORITY_COUNT, &napi_classes), {
+        return aws_raise_error(AWS_CRT_NODEJS_ERROR_NAPI_FAILURE);
+    });
 
-        AWS_NAPI_CALL(env, napi_create_uint32(env, binding->error_code, &params[1]), { goto done; });
+    for (uint32_t i = 0; i < AWS_NAPI_MQTT5_PUBLISH_PRIORITY_COUNT; ++i) {
+        napi_value napi_class = NULL;
+        AWS_NAPI_CALL(
+            env, napi_create_object(env, &napi_class), { return aws_raise_error(AWS_CRT_NODEJS_ERROR_NAPI_FAILURE); });
 
-        if (binding->valid_storage == AWS_MQTT5_PT_UNSUBACK) {
-            if (s_create_napi_unsuback_packet(env, &binding->packet_storage.unsuback.storage_view, &params[2])) {
-                AWS_LOGF_ERROR(
-                    AWS_LS_NODEJS_CRT_GENERAL, "s_napi_on_unsubscribe_complete - could not build suback napi value");
-                goto done;
-            }
-        } else if (napi_get_undefined(env, &params[2]) != napi_ok) {
-            AWS_LOGF_ERROR(
-                AWS_LS_NODEJS_CRT_GENERAL, "s_napi_on_unsubscribe_complete - could not get undefined napi_value");
-            goto done;
+        if (aws_napi_attach_object_property_u32(napi_class, env, AWS_NAPI_KEY_PRIORITY, i) ||
+            aws_napi_attach_object_property_u64(napi_class, env, AWS_NAPI_KEY_QUEUED_COUNT, queued_counts[i]) ||
+            aws_napi_attach_object_property_u64(napi_class, env, AWS_NAPI_KEY_SUBMITTED_COUNT, submitted_counts[i])) {
+            return AWS_OP_ERR;
         }
 
-        AWS_NAPI_ENSURE(
-            env,
-            aws_napi_dispatch_threadsafe_function(
-                env, binding->on_operation_completion, NULL, function, num_params, params));
+        AWS_NAPI_CALL(env, napi_set_element(env, napi_classes, i, napi_class), {
+            return aws_raise_error(AWS_CRT_NODEJS_ERROR_NAPI_FAILURE);
+        });
     }
 
-done:
+    AWS_NAPI_CALL(
+        env, napi_set_named_property(env, napi_stats, AWS_NAPI_KEY_OUTBOUND_PRIORITY_STATISTICS, napi_classes), {
+            return aws_raise_error(AWS_CRT_NODEJS_ERROR_NAPI_FAILURE);
+        });
 
-    s_aws_napi_mqtt5_operation_binding_destroy(binding);
+    return AWS_OP_SUCCESS;
 }
 
-static void s_on_unsubscribe_complete(
-    const struct aws_mqtt5_packet_unsuback_view *unsuback,
-    int error_code,
-    void *complete_ctx) {
+/* Adds an array of per-priority delivery lane statistics, lowest priority first */
+static int s_attach_delivery_priority_statistics(
+    napi_env env,
+    struct aws_mqtt5_client_binding *binding,
+    napi_value napi_stats) {
 
-    struct aws_allocator *allocator = aws_napi_get_allocator();
-    struct aws_napi_mqtt5_operation_binding *binding = complete_ctx;
+    struct aws_napi_mqtt5_delivery_lanes *delivery_lanes = &binding->delivery_lanes;
 
-    binding->error_code = error_code;
-    if (unsuback != NULL && aws_mqtt5_packet_unsuback_storage_init(
-                                &binding->packet_storage.unsuback, allocator, unsuback) == AWS_OP_SUCCESS) {
-        binding->valid_storage = AWS_MQTT5_PT_UNSUBACK;
-    } else if (binding->error_code == AWS_ERROR_SUCCESS) {
-        binding->error_code = aws_last_error();
-    }
+    struct aws_napi_mqtt5_delivery_lane lanes[AWS_NAPI_MQTT5_DELIVERY_PRIORITY_COUNT];
+    aws_mutex_lock(&delivery_lanes->lock);
+    memcpy(lanes, delivery_lanes->lanes, sizeof(lanes));
+    aws_mutex_unlock(&delivery_lanes->lock);
 
-    /* queue a callback in node's libuv thread */
-    AWS_NAPI_ENSURE(NULL, aws_napi_queue_threadsafe_function(binding->on_operation_completion, binding));
-}
+    napi_value napi_lanes = NULL;
+    AWS_NAPI_CALL(env, napi_create_array_with_length(env, AWS_NAPI_MQTT5_DELIVERY_PRIORITY_COUNT, &napi_lanes), {
+        return aws_raise_error(AWS_CRT_NODEJS_ERROR_NAPI_FAILURE);
+    });
 
-struct aws_napi_mqtt5_unsubscribe_storage {
-    struct aws_array_list topic_filter_cursors;
-    struct aws_byte_buf topic_filters;
+    for (uint32_t i = 0; i < AWS_NAPI_MQTT5_DELIVERY_PRIORITY_COUNT; ++i) {
+        const struct aws_napi_mqtt5_delivery_lane *lane = &lanes[i];
 
-    struct aws_napi_mqtt5_user_property_storage user_properties;
-};
+        napi_value napi_lane = NULL;
+        AWS_NAPI_CALL(
+            env, napi_create_object(env, &napi_lane), { return aws_raise_error(AWS_CRT_NODEJS_ERROR_NAPI_FAILURE); });
 
-static void s_aws_napi_mqtt5_unsubscribe_storage_clean_up(struct aws_napi_mqtt5_unsubscribe_storage *storage) {
-    aws_array_list_clean_up(&storage->topic_filter_cursors);
-    aws_byte_buf_clean_up(&storage->topic_filters);
+        uint64_t average_delay_ns = lane->delivered_count > 0 ? lane->total_queueing_delay_ns / lane->delivered_count : 0;
 
-    s_aws_mqtt5_user_properties_clean_up(&storage->user_properties);
+        if (aws_napi_attach_object_property_u32(napi_lane, env, AWS_NAPI_KEY_PRIORITY, i) ||
+            aws_napi_attach_object_property_u64(napi_lane, env, AWS_NAPI_KEY_PENDING_COUNT, lane->pending_count) ||
+            aws_napi_attach_object_property_u64(napi_lane, env, AWS_NAPI_KEY_DELIVERED_COUNT, lane->delivered_count) ||
+            aws_napi_attach_object_property_u64(
+                napi_lane, env, AWS_NAPI_KEY_AVERAGE_QUEUEING_DELAY_US, average_delay_ns / 1000) ||
+            aws_napi_attach_object_property_u64(
+                napi_lane, env, AWS_NAPI_KEY_MAX_QUEUEING_DELAY_US, lane->max_queueing_delay_ns / 1000)) {
+            return AWS_OP_ERR;
+        }
+
+        AWS_NAPI_CALL(env, napi_set_element(env, napi_lanes, i, napi_lane), {
+            return aws_raise_error(AWS_CRT_NODEJS_ERROR_NAPI_FAILURE);
+        });
+    }
+
+    AWS_NAPI_CALL(
+        env, napi_set_named_property(env, napi_stats, AWS_NAPI_KEY_DELIVERY_PRIORITY_STATISTICS, napi_lanes), {
+            return aws_raise_error(AWS_CRT_NODEJS_ERROR_NAPI_FAILURE);
+        });
+
+    return AWS_OP_SUCCESS;
 }
 
-static int s_aws_mqtt5_packet_unsubscribe_storage_init_from_napi(
-    struct aws_napi_mqtt5_unsubscribe_storage *unsubscribe_storage,
-    struct aws_mqtt5_packet_unsubscribe_view *unsubscribe_view,
-    struct aws_mqtt5_client_binding *binding,
+static int s_create_napi_mqtt5_client_statistics(
     napi_env env,
-    napi_value node_unsubscribe_packet) {
+    struct aws_mqtt5_client_binding *binding,
+    const struct aws_mqtt5_client_operation_statistics *stats,
+    napi_value *stats_out) {
+
     if (env == NULL) {
         return aws_raise_error(AWS_CRT_NODEJS_ERROR_THREADSAFE_FUNCTION_NULL_NAPI_ENV);
     }
 
-    napi_value napi_topic_filters = NULL;
-    if (AWS_NGNPR_VALID_VALUE !=
-        aws_napi_get_named_property(
-            env, node_unsubscribe_packet, AWS_NAPI_KEY_TOPIC_FILTERS, napi_object, &napi_topic_filters)) {
-        AWS_LOGF_ERROR(
-            AWS_LS_NODEJS_CRT_GENERAL,
-            "id=%p s_aws_mqtt5_packet_unsubscribe_storage_init_from_napi - missing require parameter: subscriptions",
-            (void *)binding->client);
-        return aws_raise_error(AWS_ERROR_INVALID_ARGUMENT);
+    napi_value napi_stats = NULL;
+    AWS_NAPI_CALL(
+        env, napi_create_object(env, &napi_stats), { return aws_raise_error(AWS_CRT_NODEJS_ERROR_NAPI_FAILURE); });
+
+    if (aws_napi_attach_object_property_u64(
+            napi_stats, env, AWS_NAPI_KEY_INCOMPLETE_OPERATION_COUNT, stats->incomplete_operation_count)) {
+        return AWS_OP_ERR;
     }
 
-    /* how many topic filters and total topic filter length */
-    uint32_t topic_filter_count = 0;
-    AWS_NAPI_CALL(env, napi_get_array_length(env, napi_topic_filters, &topic_filter_count), {
-        AWS_LOGF_ERROR(
-            AWS_LS_NODEJS_CRT_GENERAL,
-            "id=%p s_aws_mqtt5_packet_unsubscribe_storage_init_from_napi - topic filters is not an array",
-            (void *)binding->client);
-        return aws_raise_error(AWS_ERROR_INVALID_ARGUMENT);
-    });
+    if (aws_napi_attach_object_property_u64(
+            napi_stats, env, AWS_NAPI_KEY_INCOMPLETE_OPERATION_SIZE, stats->incomplete_operation_size)) {
+        return AWS_OP_ERR;
+    }
 
-    size_t topic_filter_length_sum = 0;
-    for (uint32_t i = 0; i < topic_filter_count; ++i) {
-        napi_value napi_topic_filter = NULL;
-        AWS_NAPI_CALL(env, napi_get_element(env, napi_topic_filters, i, &napi_topic_filter), { return AWS_OP_ERR; });
+    if (aws_napi_attach_object_property_u64(
+            napi_stats, env, AWS_NAPI_KEY_UNACKED_OPERATION_COUNT, stats->unacked_operation_count)) {
+        return AWS_OP_ERR;
+    }
 
-        struct aws_byte_buf topic_filter_buf;
-        AWS_ZERO_STRUCT(topic_filter_buf);
+    if (aws_napi_attach_object_property_u64(
+            napi_stats, env, AWS_NAPI_KEY_UNACKED_OPERATION_SIZE, stats->unacked_operation_size)) {
+        return AWS_OP_ERR;
+    };
 
-        AWS_NAPI_CALL(env, aws_byte_buf_init_from_napi(&topic_filter_buf, env, napi_topic_filter), {
-            return aws_raise_error(AWS_ERROR_INVALID_ARGUMENT);
-        });
+    struct aws_napi_mqtt5_inbound_flow_control *flow_control = &binding->inbound_flow_control;
 
-        topic_filter_length_sum += topic_filter_buf.len;
+    uint64_t pending_received_message_count = aws_atomic_load_int(&flow_control->pending_message_count);
+    uint64_t pending_received_message_size = aws_atomic_load_int(&flow_control->pending_message_size);
+    uint64_t inbound_flow_control_dropped_count = aws_atomic_load_int(&flow_control->dropped_message_count);
 
-        aws_byte_buf_clean_up(&topic_filter_buf);
+    if (aws_napi_attach_object_property_u64(
+            napi_stats, env, AWS_NAPI_KEY_PENDING_RECEIVED_MESSAGE_COUNT, pending_received_message_count)) {
+        return AWS_OP_ERR;
     }
 
-    struct aws_allocator *allocator = aws_napi_get_allocator();
-
-    if (aws_array_list_init_dynamic(
-            &unsubscribe_storage->topic_filter_cursors,
-            allocator,
-            topic_filter_count,
-            sizeof(struct aws_byte_cursor))) {
+    if (aws_napi_attach_object_property_u64(
+            napi_stats, env, AWS_NAPI_KEY_PENDING_RECEIVED_MESSAGE_SIZE, pending_received_message_size)) {
         return AWS_OP_ERR;
     }
 
-    if (aws_byte_buf_init(&unsubscribe_storage->topic_filters, allocator, topic_filter_length_sum)) {
+    if (aws_napi_attach_object_property_u64(
+            napi_stats, env, AWS_NAPI_KEY_INBOUND_FLOW_CONTROL_DROPPED_COUNT, inbound_flow_control_dropped_count)) {
         return AWS_OP_ERR;
     }
 
-    for (uint32_t i = 0; i < topic_filter_count; ++i) {
-        napi_value napi_topic_filter = NULL;
-        AWS_NAPI_CALL(env, napi_get_element(env, napi_topic_filters, i, &napi_topic_filter), { return AWS_OP_ERR; });
+    if (binding->persistent_queue != NULL) {
+        struct aws_napi_mqtt5_persistent_queue_statistics queue_stats;
+        AWS_ZERO_STRUCT(queue_stats);
+        aws_napi_mqtt5_persistent_queue_get_statistics(binding->persistent_queue, &queue_stats);
+
+        if (aws_napi_attach_object_property_u64(
+                napi_stats, env, AWS_NAPI_KEY_PERSISTENT_QUEUE_PENDING_COUNT, queue_stats.pending_count)) {
+            return AWS_OP_ERR;
+        }
+
+        if (aws_napi_attach_object_property_u64(napi_stats, env, AWS_NAPI_KEY_PERSISTENT_QUEUE_SIZE, queue_stats.size)) {
+            return AWS_OP_ERR;
+        }
+    }
+
+    struct aws_napi_mqtt5_offline_queue *offline_queue = &binding->offline_queue;
+    if (offline_queue->is_enabled) {
+        aws_mutex_lock(&offline_queue->lock);
+        uint64_t offline_queued_publish_count = offline_queue->held_publish_count;
+        uint64_t offline_queued_publish_size = offline_queue->held_publish_size;
+        uint64_t evicted_publish_count = offline_queue->evicted_publish_count;
+        uint64_t evicted_publish_size = offline_queue->evicted_publish_size;
+        aws_mutex_unlock(&offline_queue->lock);
+
+        if (aws_napi_attach_object_property_u64(
+                napi_stats, env, AWS_NAPI_KEY_OFFLINE_QUEUED_PUBLISH_COUNT, offline_queued_publish_count)) {
+            return AWS_OP_ERR;
+        }
+
+        if (aws_napi_attach_object_property_u64(
+                napi_stats, env, AWS_NAPI_KEY_OFFLINE_QUEUED_PUBLISH_SIZE, offline_queued_publish_size)) {
+            return AWS_OP_ERR;
+        }
+
+        if (aws_napi_attach_object_property_u64(
+                napi_stats, env, AWS_NAPI_KEY_EVICTED_PUBLISH_COUNT, evicted_publish_count)) {
+            return AWS_OP_ERR;
+        }
+
+        if (aws_napi_attach_object_property_u64(napi_stats, env, AWS_NAPI_KEY_EVICTED_PUBLISH_SIZE, evicted_publish_size)) {
+            return AWS_OP_ERR;
+        }
+    }
+
+    if (aws_atomic_load_int(&binding->is_response_routing_enabled) != 0) {
+        aws_mutex_lock(&binding->response_router_lock);
+        uint64_t unmatched_response_count = aws_napi_mqtt5_response_router_get_unmatched_count(binding->response_router);
+        aws_mutex_unlock(&binding->response_router_lock);
 
-        struct aws_byte_buf topic_filter_buf;
-        AWS_ZERO_STRUCT(topic_filter_buf);
+        if (aws_napi_attach_object_property_u64(
+                napi_stats, env, AWS_NAPI_KEY_UNMATCHED_RESPONSE_COUNT, unmatched_response_count)) {
+            return AWS_OP_ERR;
+        }
+    }
 
-        AWS_NAPI_CALL(env, aws_byte_buf_init_from_napi(&topic_filter_buf, env, napi_topic_filter), {
-            return aws_raise_error(AWS_ERROR_INVALID_ARGUMENT);
-        });
+    if (binding->outbound_scheduler.is_enabled) {
+        if (s_attach_outbound_priority_statistics(env, binding, napi_stats)) {
+            return AWS_OP_ERR;
+        }
+    }
 
-        struct aws_byte_cursor topic_filter = aws_byte_cursor_from_buf(&topic_filter_buf);
+    if (binding->delivery_lanes.is_enabled) {
+        if (s_attach_delivery_priority_statistics(env, binding, napi_stats)) {
+            return AWS_OP_ERR;
+        }
+    }
 
-        bool success =
-            aws_byte_buf_append_and_update(&unsubscribe_storage->topic_filters, &topic_filter) == AWS_OP_SUCCESS;
+    if (binding->has_message_filter_statistics) {
+        aws_mutex_lock(&binding->message_filter_lock);
+        struct aws_napi_mqtt_message_filter_statistics filter_stats = binding->message_filter_statistics;
+        aws_mutex_unlock(&binding->message_filter_lock);
 
-        aws_byte_buf_clean_up(&topic_filter_buf);
+        if (aws_napi_attach_object_property_u64(
+                napi_stats, env, AWS_NAPI_KEY_FILTERED_MESSAGE_COUNT, filter_stats.filtered_count)) {
+            return AWS_OP_ERR;
+        }
 
-        if (!success) {
+        if (aws_napi_attach_object_property_u64(
+                napi_stats, env, AWS_NAPI_KEY_SAMPLED_OUT_MESSAGE_COUNT, filter_stats.sampled_out_count)) {
             return AWS_OP_ERR;
         }
 
-        aws_array_list_push_back(&unsubscribe_storage->topic_filter_cursors, &topic_filter);
+        if (aws_napi_attach_object_property_u64(
+                napi_stats, env, AWS_NAPI_KEY_RATE_LIMITED_MESSAGE_COUNT, filter_stats.rate_limited_count)) {
+            return AWS_OP_ERR;
+        }
     }
 
-    unsubscribe_view->topic_filter_count = topic_filter_count;
-    unsubscribe_view->topic_filters = unsubscribe_storage->topic_filter_cursors.data;
+    if (aws_atomic_load_int(&binding->is_last_value_cache_enabled) != 0) {
+        struct aws_napi_mqtt_last_value_cache_statistics cache_stats;
+        AWS_ZERO_STRUCT(cache_stats);
 
-    if (s_aws_mqtt5_user_properties_extract_from_js_object(
-            binding,
-            &unsubscribe_storage->user_properties,
-            env,
-            node_unsubscribe_packet,
-            &unsubscribe_view->user_property_count,
-            &unsubscribe_view->user_properties)) {
-        AWS_LOGF_ERROR(
-            AWS_LS_NODEJS_CRT_GENERAL,
-            "s_aws_mqtt5_packet_unsubscribe_storage_init_from_napi - failed to extract userProperties");
-        return AWS_OP_ERR;
+        aws_mutex_lock(&binding->last_value_cache_lock);
+        if (binding->last_value_cache != NULL) {
+            aws_napi_mqtt_last_value_cache_get_statistics(binding->last_value_cache, &cache_stats);
+        }
+        aws_mutex_unlock(&binding->last_value_cache_lock);
+
+        if (aws_napi_attach_object_property_u64(
+                napi_stats, env, AWS_NAPI_KEY_LAST_VALUE_CACHE_TOPIC_COUNT, cache_stats.topic_count) ||
+            aws_napi_attach_object_property_u64(
+                napi_stats, env, AWS_NAPI_KEY_LAST_VALUE_CACHE_SIZE, cache_stats.size) ||
+            aws_napi_attach_object_property_u64(
+                napi_stats, env, AWS_NAPI_KEY_LAST_VALUE_CACHE_EVICTED_COUNT, cache_stats.evicted_count)) {
+            return AWS_OP_ERR;
+        }
     }
 
+    *stats_out = napi_stats;
+
     return AWS_OP_SUCCESS;
 }
 
-napi_value aws_napi_mqtt5_client_unsubscribe(napi_env env, napi_callback_info info) {
-    struct aws_allocator *allocator = aws_napi_get_allocator();
+napi_value aws_napi_mqtt5_client_get_queue_statistics(napi_env env, napi_callback_info info) {
 
-    napi_value node_args[3];
+    napi_value node_args[1];
     size_t num_args = AWS_ARRAY_SIZE(node_args);
     napi_value *arg = &node_args[0];
     AWS_NAPI_CALL(env, napi_get_cb_info(env, info, &num_args, node_args, NULL, NULL), {
-        napi_throw_error(env, NULL, "aws_napi_mqtt5_client_unsubscribe - Failed to extract parameter array");
+        napi_throw_error(env, NULL, "aws_napi_mqtt5_client_get_queue_statistics - Failed to extract parameter array");
         return NULL;
     });
 
     if (num_args != AWS_ARRAY_SIZE(node_args)) {
-        napi_throw_error(env, NULL, "aws_napi_mqtt5_client_unsubscribe - needs exactly 3 arguments");
+        napi_throw_error(env, NULL, "aws_napi_mqtt5_client_get_queue_statistics - needs exactly 1 argument");
         return NULL;
     }
 
-    bool successful = false;
     struct aws_mqtt5_client_binding *client_binding = NULL;
     napi_value node_binding = *arg++;
     AWS_NAPI_CALL(env, napi_get_value_external(env, node_binding, (void **)&client_binding), {
         napi_throw_error(
-            env, NULL, "aws_napi_mqtt5_client_unsubscribe - Failed to extract client binding from first argument");
+            env,
+            NULL,
+            "aws_napi_mqtt5_client_get_queue_statistics - Failed to extract client binding from first argument");
         return NULL;
     });
 
     if (client_binding == NULL) {
-        napi_throw_error(env, NULL, "aws_napi_mqtt5_client_unsubscribe - binding was null");
+        napi_throw_error(env, NULL, "aws_napi_mqtt5_client_get_queue_statistics - binding was null");
         return NULL;
     }
 
     if (client_binding->client == NULL) {
-        napi_throw_error(env, NULL, "aws_napi_mqtt5_client_unsubscribe - client was null");
+        napi_throw_error(env, NULL, "aws_napi_mqtt5_client_get_queue_statistics - client was null");
         return NULL;
     }
 
-    struct aws_napi_mqtt5_operation_binding *binding =
-        aws_mem_calloc(allocator, 1, sizeof(struct aws_napi_mqtt5_operation_binding));
-    binding->allocator = allocator;
-    binding->client_binding = s_aws_mqtt5_client_binding_acquire(client_binding);
+    struct aws_mqtt5_client_operation_statistics stats;
+    AWS_ZERO_STRUCT(stats);
 
-    napi_value node_unsubscribe_packet = *arg++;
+    aws_mqtt5_client_get_stats(client_binding->client, &stats);
 
-    struct aws_napi_mqtt5_unsubscribe_storage unsubscribe_storage;
-    AWS_ZERO_STRUCT(unsubscribe_storage);
-    struct aws_mqtt5_packet_unsubscribe_view unsubscribe_view;
-    AWS_ZERO_STRUCT(unsubscribe_view);
-    if (s_aws_mqtt5_packet_unsubscribe_storage_init_from_napi(
-            &unsubscribe_storage, &unsubscribe_view, client_binding, env, node_unsubscribe_packet)) {
-        napi_throw_error(env, NULL, "aws_napi_mqtt5_client_unsubscribe - storage init failure");
-        goto done;
+    napi_value napi_stats = NULL;
+    if (s_create_napi_mqtt5_client_statistics(env, client_binding, &stats, &napi_stats)) {
+        napi_throw_error(env, NULL, "aws_napi_mqtt5_client_get_queue_statistics - failed to build statistics value");
+        return NULL;
     }
 
-    napi_value completion_callback = *arg++;
-    AWS_NAPI_CALL(
-        env,
-        aws_napi_create_threadsafe_function(
-            env,
-            completion_callback,
-            "aws_mqtt5_on_unsubscribe_complete",
-            s_napi_on_unsubscribe_complete,
-            binding,
-            &binding->on_operation_completion),
-        {
-            napi_throw_error(env, NULL, "aws_napi_mqtt5_client_unsubscribe - failed to create threadsafe function");
-            goto done;
-        });
+    return napi_stats;
+}
 
-    struct aws_mqtt5_unsubscribe_completion_options completion_options = {
-        .completion_callback = s_on_unsubscribe_complete,
-        .completion_user_data = binding,
-    };
+/* Extracts the client binding from the external passed as the first argument of a native client function */
+static struct aws_mqtt5_client_binding *s_get_client_binding_argument(
+    napi_env env,
+    napi_value node_binding,
+    const char *function_name) {
 
-    if (aws_mqtt5_client_unsubscribe(client_binding->client, &unsubscribe_view, &completion_options)) {
-        napi_throw_error(env, NULL, "aws_napi_mqtt5_client_unsubscribe - failure invoking native client unsubscribe");
-        goto done;
+    struct aws_mqtt5_client_binding *binding = NULL;
+    AWS_NAPI_CALL(env, napi_get_value_external(env, node_binding, (void **)&binding), {
+        napi_throw_error(env, NULL, function_name);
+        return NULL;
+    });
+
+    if (binding == NULL || binding->client == NULL) {
+        napi_throw_error(env, NULL, function_name);
+        return NULL;
     }
 
-    successful = true;
+    return binding;
+}
 
-done:
+napi_value aws_napi_mqtt5_client_enable_request_response(napi_env env, napi_callback_info info) {
 
-    s_aws_napi_mqtt5_unsubscribe_storage_clean_up(&unsubscribe_storage);
+    napi_value node_args[2];
+    size_t num_args = AWS_ARRAY_SIZE(node_args);
+    napi_value *arg = &node_args[0];
+    AWS_NAPI_CALL(env, napi_get_cb_info(env, info, &num_args, node_args, NULL, NULL), {
+        napi_throw_error(env, NULL, "aws_napi_mqtt5_client_enable_request_response - Failed to extract parameter array");
+        return NULL;
+    });
 
-    if (!successful) {
-        s_aws_napi_mqtt5_operation_binding_destroy(binding);
+    if (num_args != AWS_ARRAY_SIZE(node_args)) {
+        napi_throw_error(env, NULL, "aws_napi_mqtt5_client_enable_request_response - needs exactly 2 arguments");
+        return NULL;
+    }
+
+    struct aws_mqtt5_client_binding *binding = s_get_client_binding_argument(
+        env, *arg++, "aws_napi_mqtt5_client_enable_request_response - invalid client binding");
+    if (binding == NULL) {
+        return NULL;
+    }
+
+    napi_value on_response_received_handler = *arg++;
+
+    if (aws_atomic_load_int(&binding->is_response_routing_enabled) != 0) {
+        napi_throw_error(env, NULL, "aws_napi_mqtt5_client_enable_request_response - already enabled");
+        return NULL;
+    }
+
+    if (aws_napi_is_null_or_undefined(env, on_response_received_handler) ||
+        s_init_event_handler_threadsafe_function(
+            env,
+            on_response_received_handler,
+            "aws_mqtt5_client_on_response_received",
+            s_napi_on_response_received,
+            &binding->on_response_received)) {
+        napi_throw_error(
+            env, NULL, "aws_napi_mqtt5_client_enable_request_response - failed to initialize response handler");
+        return NULL;
+    }
+
+    struct aws_napi_mqtt5_response_router *router = aws_napi_mqtt5_response_router_new(binding->allocator);
+    if (router == NULL) {
+        aws_napi_throw_last_error_with_context(
+            env, "aws_napi_mqtt5_client_enable_request_response - failed to create response router");
+        return NULL;
     }
 
+    aws_mutex_lock(&binding->response_router_lock);
+    binding->response_router = router;
+    aws_mutex_unlock(&binding->response_router_lock);
+
+    /* the threadsafe function and router must be visible to the event loop thread before this is */
+    aws_atomic_store_int(&binding->is_response_routing_enabled, 1);
+
     return NULL;
 }
 
-static int s_create_napi_puback_packet(
-    napi_env env,
-    const struct aws_mqtt5_packet_puback_view *puback,
-    napi_value *packet_out) {
+napi_value aws_napi_mqtt5_client_disable_request_response(napi_env env, napi_callback_info info) {
 
-    if (env == NULL) {
-        return aws_raise_error(AWS_CRT_NODEJS_ERROR_THREADSAFE_FUNCTION_NULL_NAPI_ENV);
+    napi_value node_args[1];
+    size_t num_args = AWS_ARRAY_SIZE(node_args);
+    napi_value *arg = &node_args[0];
+    AWS_NAPI_CALL(env, napi_get_cb_info(env, info, &num_args, node_args, NULL, NULL), {
+        napi_throw_error(env, NULL, "aws_napi_mqtt5_client_disable_request_response - Failed to extract parameter array");
+        return NULL;
+    });
+
+    if (num_args != AWS_ARRAY_SIZE(node_args)) {
+        napi_throw_error(env, NULL, "aws_napi_mqtt5_client_disable_request_response - needs exactly 1 argument");
+        return NULL;
     }
 
-    napi_value napi_puback = NULL;
-    AWS_NAPI_CALL(
-        env, napi_create_object(env, &napi_puback), { return aws_raise_error(AWS_CRT_NODEJS_ERROR_NAPI_FAILURE); });
+    struct aws_mqtt5_client_binding *binding = s_get_client_binding_argument(
+        env, *arg++, "aws_napi_mqtt5_client_disable_request_response - invalid client binding");
+    if (binding == NULL) {
+        return NULL;
+    }
 
-    if (aws_napi_attach_object_property_u32(napi_puback, env, AWS_NAPI_KEY_TYPE, (uint32_t)AWS_MQTT5_PT_PUBACK)) {
-        return AWS_OP_ERR;
+    if (aws_atomic_load_int(&binding->is_response_routing_enabled) == 0) {
+        return NULL;
     }
 
-    if (aws_napi_attach_object_property_u32(napi_puback, env, AWS_NAPI_KEY_REASON_CODE, puback->reason_code)) {
-        return AWS_OP_ERR;
+    aws_atomic_store_int(&binding->is_response_routing_enabled, 0);
+
+    /*
+     * The event loop thread may have seen routing as enabled just before the store above; it only touches the router
+     * and the threadsafe function under this lock, and treats a missing router as routing being disabled.  Responses
+     * already queued are discarded by the abort release rather than delivered to a later request-response client.
+     */
+    aws_mutex_lock(&binding->response_router_lock);
+    aws_napi_mqtt5_response_router_destroy(binding->response_router);
+    binding->response_router = NULL;
+    AWS_CLEAN_THREADSAFE_FUNCTION(binding, on_response_received);
+    aws_mutex_unlock(&binding->response_router_lock);
+
+    return NULL;
+}
+
+/* Shared argument handling for adding and removing a response filter */
+static napi_value s_update_response_filter(napi_env env, napi_callback_info info, bool is_add) {
+
+    napi_value node_args[2];
+    size_t num_args = AWS_ARRAY_SIZE(node_args);
+    napi_value *arg = &node_args[0];
+    AWS_NAPI_CALL(env, napi_get_cb_info(env, info, &num_args, node_args, NULL, NULL), {
+        napi_throw_error(env, NULL, "s_update_response_filter - Failed to extract parameter array");
+        return NULL;
+    });
+
+    if (num_args != AWS_ARRAY_SIZE(node_args)) {
+        napi_throw_error(env, NULL, "s_update_response_filter - needs exactly 2 arguments");
+        return NULL;
     }
 
-    if (aws_napi_attach_object_property_optional_string(
-            napi_puback, env, AWS_NAPI_KEY_REASON_STRING, puback->reason_string)) {
-        return AWS_OP_ERR;
+    struct aws_mqtt5_client_binding *binding =
+        s_get_client_binding_argument(env, *arg++, "s_update_response_filter - invalid client binding");
+    if (binding == NULL) {
+        return NULL;
     }
 
-    if (s_attach_object_property_user_properties(
-            napi_puback, env, puback->user_property_count, puback->user_properties)) {
-        return AWS_OP_ERR;
+    if (aws_atomic_load_int(&binding->is_response_routing_enabled) == 0) {
+        napi_throw_error(env, NULL, "s_update_response_filter - request-response is not enabled");
+        return NULL;
     }
 
-    *packet_out = napi_puback;
+    struct aws_byte_buf topic_filter;
+    AWS_ZERO_STRUCT(topic_filter);
+    AWS_NAPI_CALL(env, aws_byte_buf_init_from_napi(&topic_filter, env, *arg++), {
+        napi_throw_type_error(env, NULL, "s_update_response_filter - topic filter must be a string");
+        return NULL;
+    });
 
-    return AWS_OP_SUCCESS;
+    int result = AWS_OP_SUCCESS;
+
+    aws_mutex_lock(&binding->response_router_lock);
+    if (is_add) {
+        result = aws_napi_mqtt5_response_router_add_filter(
+            binding->response_router, aws_byte_cursor_from_buf(&topic_filter));
+    } else {
+        aws_napi_mqtt5_response_router_remove_filter(binding->response_router, aws_byte_cursor_from_buf(&topic_filter));
+    }
+    aws_mutex_unlock(&binding->response_router_lock);
+
+    aws_byte_buf_clean_up(&topic_filter);
+
+    if (result) {
+        aws_napi_throw_last_error_with_context(env, "s_update_response_filter - failed to add response filter");
+    }
+
+    return NULL;
 }
 
-/* in-node/libuv-thread function to trigger the completion of a publish promise */
-static void s_napi_on_publish_complete(napi_env env, napi_value function, void *context, void *user_data) {
-    (void)user_data;
+napi_value aws_napi_mqtt5_client_add_response_filter(napi_env env, napi_callback_info info) {
+    return s_update_response_filter(env, info, true);
+}
+
+napi_value aws_napi_mqtt5_client_remove_response_filter(napi_env env, napi_callback_info info) {
+    return s_update_response_filter(env, info, false);
+}
+
+napi_value aws_napi_mqtt5_client_add_pending_request(napi_env env, napi_callback_info info) {
+    struct aws_allocator *allocator = aws_napi_get_allocator();
+
+    napi_value node_args[4];
+    size_t num_args = AWS_ARRAY_SIZE(node_args);
+    napi_value *arg = &node_args[0];
+    AWS_NAPI_CALL(env, napi_get_cb_info(env, info, &num_args, node_args, NULL, NULL), {
+        napi_throw_error(env, NULL, "aws_napi_mqtt5_client_add_pending_request - Failed to extract parameter array");
+        return NULL;
+    });
+
+    if (num_args != AWS_ARRAY_SIZE(node_args)) {
+        napi_throw_error(env, NULL, "aws_napi_mqtt5_client_add_pending_request - needs exactly 4 arguments");
+        return NULL;
+    }
+
+    struct aws_mqtt5_client_binding *binding = s_get_client_binding_argument(
+        env, *arg++, "aws_napi_mqtt5_client_add_pending_request - invalid client binding");
+    if (binding == NULL) {
+        return NULL;
+    }
+
+    if (aws_atomic_load_int(&binding->is_response_routing_enabled) == 0) {
+        napi_throw_error(env, NULL, "aws_napi_mqtt5_client_add_pending_request - request-response is not enabled");
+        return NULL;
+    }
+
+    int64_t request_id = 0;
+    AWS_NAPI_CALL(env, napi_get_value_int64(env, *arg++, &request_id), {
+        napi_throw_type_error(env, NULL, "aws_napi_mqtt5_client_add_pending_request - request id must be a number");
+        return NULL;
+    });
+
+    napi_value node_response_topics = *arg++;
+    uint32_t response_topic_count = 0;
+    AWS_NAPI_CALL(env, napi_get_array_length(env, node_response_topics, &response_topic_count), {
+        napi_throw_type_error(
+            env, NULL, "aws_napi_mqtt5_client_add_pending_request - response topics must be an array");
+        return NULL;
+    });
+
+    napi_value node_correlation_data = *arg++;
+
+    struct aws_byte_buf correlation_data;
+    AWS_ZERO_STRUCT(correlation_data);
+    struct aws_byte_cursor correlation_data_cursor;
+    AWS_ZERO_STRUCT(correlation_data_cursor);
+    const struct aws_byte_cursor *correlation_data_ptr = NULL;
+
+    struct aws_byte_buf *response_topics = NULL;
+    struct aws_byte_cursor *response_topic_cursors = NULL;
+    uint32_t initialized_topic_count = 0;
+
+    if (!aws_napi_is_null_or_undefined(env, node_correlation_data)) {
+        AWS_NAPI_CALL(env, aws_byte_buf_init_from_napi(&correlation_data, env, node_correlation_data), {
+            napi_throw_type_error(
+                env, NULL, "aws_napi_mqtt5_client_add_pending_request - invalid correlation data");
+            goto done;
+        });
+
+        correlation_data_cursor = aws_byte_cursor_from_buf(&correlation_data);
+        correlation_data_ptr = &correlation_data_cursor;
+    }
+
+    if (response_topic_count == 0) {
+        napi_throw_error(env, NULL, "aws_napi_mqtt5_client_add_pending_request - at least one response topic needed");
+        goto done;
+    }
 
-    struct aws_napi_mqtt5_operation_binding *binding = context;
+    response_topics = aws_mem_calloc(allocator, response_topic_count, sizeof(struct aws_byte_buf));
+    response_topic_cursors = aws_mem_calloc(allocator, response_topic_count, sizeof(struct aws_byte_cursor));
 
-    if (env) {
-        napi_value params[3];
-        const size_t num_params = AWS_ARRAY_SIZE(params);
+    for (uint32_t i = 0; i < response_topic_count; ++i) {
+        napi_value node_topic = NULL;
+        AWS_NAPI_CALL(env, napi_get_element(env, node_response_topics, i, &node_topic), {
+            napi_throw_error(env, NULL, "aws_napi_mqtt5_client_add_pending_request - failed to read response topic");
+            goto done;
+        });
 
-        /*
-         * If we can't resolve the weak ref to the mqtt5 client, then it's been garbage collected and we should not
-         * do anything.
-         */
-        params[0] = NULL;
-        if (napi_get_reference_value(env, binding->client_binding->node_mqtt5_client_ref, &params[0]) != napi_ok ||
-            params[0] == NULL) {
-            AWS_LOGF_INFO(
-                AWS_LS_NODEJS_CRT_GENERAL,
-                "s_napi_on_publish_complete - mqtt5_client node wrapper no longer resolvable");
+        AWS_NAPI_CALL(env, aws_byte_buf_init_from_napi(&response_topics[i], env, node_topic), {
+            napi_throw_type_error(
+                env, NULL, "aws_napi_mqtt5_client_add_pending_request - response topics must be strings");
             goto done;
-        }
+        });
 
-        AWS_NAPI_CALL(env, napi_create_uint32(env, binding->error_code, &params[1]), { goto done; });
+        ++initialized_topic_count;
+        response_topic_cursors[i] = aws_byte_cursor_from_buf(&response_topics[i]);
+    }
 
-        if (binding->valid_storage == AWS_MQTT5_PT_PUBACK) {
-            if (s_create_napi_puback_packet(env, &binding->packet_storage.puback.storage_view, &params[2])) {
-                AWS_LOGF_ERROR(
-                    AWS_LS_NODEJS_CRT_GENERAL, "s_napi_on_publish_complete - could not build puback napi_value");
-                goto done;
-            }
-        } else {
-            if (napi_get_undefined(env, &params[2]) != napi_ok) {
-                AWS_LOGF_ERROR(
-                    AWS_LS_NODEJS_CRT_GENERAL, "s_napi_on_publish_complete - could not get undefined napi_value");
-                goto done;
-            }
-        }
+    aws_mutex_lock(&binding->response_router_lock);
+    int result = aws_napi_mqtt5_response_router_add_request(
+        binding->response_router,
+        (uint64_t)request_id,
+        response_topic_cursors,
+        response_topic_count,
+        correlation_data_ptr);
+    aws_mutex_unlock(&binding->response_router_lock);
 
-        AWS_NAPI_ENSURE(
-            env,
-            aws_napi_dispatch_threadsafe_function(
-                env, binding->on_operation_completion, NULL, function, num_params, params));
+    if (result) {
+        aws_napi_throw_last_error_with_context(
+            env, "aws_napi_mqtt5_client_add_pending_request - failed to register request");
     }
 
 done:
 
-    s_aws_napi_mqtt5_operation_binding_destroy(binding);
-}
-
-static void s_on_publish_complete(
-    enum aws_mqtt5_packet_type packet_type,
-    const void *packet,
-    int error_code,
-    void *complete_ctx) {
-
-    struct aws_allocator *allocator = aws_napi_get_allocator();
-    struct aws_napi_mqtt5_operation_binding *binding = complete_ctx;
+    for (uint32_t i = 0; i < initialized_topic_count; ++i) {
+        aws_byte_buf_clean_up(&response_topics[i]);
+    }
 
-    binding->error_code = error_code;
+    if (response_topics != NULL) {
+        aws_mem_release(allocator, response_topics);
+    }
 
-    if (packet_type == AWS_MQTT5_PT_PUBACK) {
-        const struct aws_mqtt5_packet_puback_view *puback = packet;
-        if (aws_mqtt5_packet_puback_storage_init(&binding->packet_storage.puback, allocator, puback) ==
-            AWS_OP_SUCCESS) {
-            binding->valid_storage = AWS_MQTT5_PT_PUBACK;
-        } else if (binding->error_code == AWS_ERROR_SUCCESS) {
-            binding->error_code = aws_last_error();
-        }
+    if (response_topic_cursors != NULL) {
+        aws_mem_release(allocator, response_topic_cursors);
     }
 
-    /* queue a callback in node's libuv thread */
-    AWS_NAPI_ENSURE(NULL, aws_napi_queue_threadsafe_function(binding->on_operation_completion, binding));
+    aws_byte_buf_clean_up(&correlation_data);
+
+    return NULL;
 }
 
-napi_value aws_napi_mqtt5_client_publish(napi_env env, napi_callback_info info) {
-    struct aws_allocator *allocator = aws_napi_get_allocator();
+napi_value aws_napi_mqtt5_client_remove_pending_request(napi_env env, napi_callback_info info) {
 
-    napi_value node_args[3];
+    napi_value node_args[2];
     size_t num_args = AWS_ARRAY_SIZE(node_args);
     napi_value *arg = &node_args[0];
     AWS_NAPI_CALL(env, napi_get_cb_info(env, info, &num_args, node_args, NULL, NULL), {
-        napi_throw_error(env, NULL, "aws_napi_mqtt5_client_publish - Failed to extract parameter array");
+        napi_throw_error(env, NULL, "aws_napi_mqtt5_client_remove_pending_request - Failed to extract parameter array");
         return NULL;
     });
 
     if (num_args != AWS_ARRAY_SIZE(node_args)) {
-        napi_throw_error(env, NULL, "aws_napi_mqtt5_client_publish - needs exactly 3 arguments");
+        napi_throw_error(env, NULL, "aws_napi_mqtt5_client_remove_pending_request - needs exactly 2 arguments");
         return NULL;
     }
 
-    bool successful = false;
-    struct aws_mqtt5_client_binding *client_binding = NULL;
-    napi_value node_binding = *arg++;
-    AWS_NAPI_CALL(env, napi_get_value_external(env, node_binding, (void **)&client_binding), {
-        napi_throw_error(
-            env, NULL, "aws_napi_mqtt5_client_publish - Failed to extract client binding from first argument");
+    struct aws_mqtt5_client_binding *binding = s_get_client_binding_argument(
+        env, *arg++, "aws_napi_mqtt5_client_remove_pending_request - invalid client binding");
+    if (binding == NULL) {
+        return NULL;
+    }
+
+    int64_t request_id = 0;
+    AWS_NAPI_CALL(env, napi_get_value_int64(env, *arg++, &request_id), {
+        napi_throw_type_error(env, NULL, "aws_napi_mqtt5_client_remove_pending_request - request id must be a number");
         return NULL;
     });
 
-    if (client_binding == NULL) {
-        napi_throw_error(env, NULL, "aws_napi_mqtt5_client_publish - binding was null");
+    bool was_pending = false;
+    if (aws_atomic_load_int(&binding->is_response_routing_enabled) != 0) {
+        aws_mutex_lock(&binding->response_router_lock);
+        was_pending = aws_napi_mqtt5_response_router_remove_request(binding->response_router, (uint64_t)request_id);
+        aws_mutex_unlock(&binding->response_router_lock);
+    }
+
+    napi_value napi_was_pending = NULL;
+    AWS_NAPI_CALL(env, napi_get_boolean(env, was_pending, &napi_was_pending), {
+        napi_throw_error(env, NULL, "aws_napi_mqtt5_client_remove_pending_request - failed to create result");
+        return NULL;
+    });
+
+    return napi_was_pending;
+}
+
+napi_value aws_napi_mqtt5_client_set_message_filter(napi_env env, napi_callback_info info) {
+    napi_value node_args[2];
+    size_t num_args = AWS_ARRAY_SIZE(node_args);
+    napi_value *arg = &node_args[0];
+    AWS_NAPI_CALL(env, napi_get_cb_info(env, info, &num_args, node_args, NULL, NULL), {
+        napi_throw_error(env, NULL, "aws_napi_mqtt5_client_set_message_filter - Failed to extract parameter array");
+        return NULL;
+    });
+
+    if (num_args != AWS_ARRAY_SIZE(node_args)) {
+        napi_throw_error(env, NULL, "aws_napi_mqtt5_client_set_message_filter - needs exactly 2 arguments");
         return NULL;
     }
 
-    if (client_binding->client == NULL) {
-        napi_throw_error(env, NULL, "aws_napi_mqtt5_client_publish - client was null");
+    struct aws_mqtt5_client_binding *binding = s_get_client_binding_argument(
+        env, *arg++, "aws_napi_mqtt5_client_set_message_filter - invalid client binding");
+    if (binding == NULL) {
         return NULL;
     }
 
-    struct aws_napi_mqtt5_operation_binding *binding =
-        aws_mem_calloc(allocator, 1, sizeof(struct aws_napi_mqtt5_operation_binding));
-    binding->allocator = allocator;
-    binding->client_binding = s_aws_mqtt5_client_binding_acquire(client_binding);
+    /* null or undefined removes the current filter */
+    struct aws_napi_mqtt_message_filter *filter = NULL;
+    napi_value node_rules = *arg++;
+    if (!aws_napi_is_null_or_undefined(env, node_rules)) {
+        filter = aws_napi_mqtt_message_filter_new_from_napi(binding->allocator, env, node_rules);
+        if (filter == NULL) {
+            aws_napi_throw_last_error_with_context(
+                env, "aws_napi_mqtt5_client_set_message_filter - invalid message filter rules");
+            return NULL;
+        }
+    }
 
-    napi_value node_publish_packet = *arg++;
+    aws_mutex_lock(&binding->message_filter_lock);
+    struct aws_napi_mqtt_message_filter *previous_filter = binding->message_filter;
+    binding->message_filter = filter;
+    aws_mutex_unlock(&binding->message_filter_lock);
 
-    struct aws_napi_mqtt5_publish_storage publish_storage;
-    AWS_ZERO_STRUCT(publish_storage);
-    struct aws_mqtt5_packet_publish_view publish_view;
-    AWS_ZERO_STRUCT(publish_view);
-    if (s_init_publish_options_from_napi(client_binding, env, node_publish_packet, &publish_view, &publish_storage)) {
-        napi_throw_error(env, NULL, "aws_napi_mqtt5_client_publish - storage init failure");
-        goto done;
+    aws_napi_mqtt_message_filter_destroy(previous_filter);
+
+    aws_atomic_store_int(&binding->is_message_filter_enabled, filter != NULL ? 1 : 0);
+    if (filter != NULL) {
+        binding->has_message_filter_statistics = true;
     }
 
-    napi_value completion_callback = *arg++;
-    AWS_NAPI_CALL(
-        env,
-        aws_napi_create_threadsafe_function(
-            env,
-            completion_callback,
-            "aws_mqtt5_on_publish_complete",
-            s_napi_on_publish_complete,
-            binding,
-            &binding->on_operation_completion),
-        {
-            napi_throw_error(env, NULL, "aws_napi_mqtt5_client_publish - failed to create threadsafe function");
-            goto done;
-        });
+    return NULL;
+}
 
-    struct aws_mqtt5_publish_completion_options completion_options = {
-        .completion_callback = s_on_publish_complete,
-        .completion_user_data = binding,
-    };
+napi_value aws_napi_mqtt5_client_set_last_value_cache(napi_env env, napi_callback_info info) {
+    napi_value node_args[2];
+    size_t num_args = AWS_ARRAY_SIZE(node_args);
+    napi_value *arg = &node_args[0];
+    AWS_NAPI_CALL(env, napi_get_cb_info(env, info, &num_args, node_args, NULL, NULL), {
+        napi_throw_error(env, NULL, "aws_napi_mqtt5_client_set_last_value_cache - Failed to extract parameter array");
+        return NULL;
+    });
 
-    if (aws_mqtt5_client_publish(client_binding->client, &publish_view, &completion_options)) {
-        napi_throw_error(env, NULL, "aws_napi_mqtt5_client_publish - failure invoking native client publish");
-        goto done;
+    if (num_args != AWS_ARRAY_SIZE(node_args)) {
+        napi_throw_error(env, NULL, "aws_napi_mqtt5_client_set_last_value_cache - needs exactly 2 arguments");
+        return NULL;
     }
 
-    successful = true;
+    struct aws_mqtt5_client_binding *binding = s_get_client_binding_argument(
+        env, *arg++, "aws_napi_mqtt5_client_set_last_value_cache - invalid client binding");
+    if (binding == NULL) {
+        return NULL;
+    }
 
-done:
+    /* null or undefined removes the current cache */
+    struct aws_napi_mqtt_last_value_cache *cache = NULL;
+    napi_value node_options = *arg++;
+    if (!aws_napi_is_null_or_undefined(env, node_options)) {
+        cache = aws_napi_mqtt_last_value_cache_new_from_napi(binding->allocator, env, node_options);
+        if (cache == NULL) {
+            aws_napi_throw_last_error_with_context(
+                env, "aws_napi_mqtt5_client_set_last_value_cache - invalid last value cache options");
+            return NULL;
+        }
+    }
 
-    s_aws_napi_mqtt5_publish_storage_clean_up(&publish_storage);
+    aws_mutex_lock(&binding->last_value_cache_lock);
+    struct aws_napi_mqtt_last_value_cache *previous_cache = binding->last_value_cache;
+    binding->last_value_cache = cache;
+    aws_mutex_unlock(&binding->last_value_cache_lock);
 
-    if (!successful) {
-        s_aws_napi_mqtt5_operation_binding_destroy(binding);
-    }
+    aws_napi_mqtt_last_value_cache_destroy(previous_cache);
+
+    aws_atomic_store_int(&binding->is_last_value_cache_enabled, cache != NULL ? 1 : 0);
 
     return NULL;
 }
 
-static int s_create_napi_mqtt5_client_statistics(
-    napi_env env,
-    const struct aws_mqtt5_client_operation_statistics *stats,
-    napi_value *stats_out) {
+napi_value aws_napi_mqtt5_client_get_last_value(napi_env env, napi_callback_info info) {
+    napi_value node_args[2];
+    size_t num_args = AWS_ARRAY_SIZE(node_args);
+    napi_value *arg = &node_args[0];
+    AWS_NAPI_CALL(env, napi_get_cb_info(env, info, &num_args, node_args, NULL, NULL), {
+        napi_throw_error(env, NULL, "aws_napi_mqtt5_client_get_last_value - Failed to extract parameter array");
+        return NULL;
+    });
 
-    if (env == NULL) {
-        return aws_raise_error(AWS_CRT_NODEJS_ERROR_THREADSAFE_FUNCTION_NULL_NAPI_ENV);
+    if (num_args != AWS_ARRAY_SIZE(node_args)) {
+        napi_throw_error(env, NULL, "aws_napi_mqtt5_client_get_last_value - needs exactly 2 arguments");
+        return NULL;
     }
 
-    napi_value napi_stats = NULL;
-    AWS_NAPI_CALL(
-        env, napi_create_object(env, &napi_stats), { return aws_raise_error(AWS_CRT_NODEJS_ERROR_NAPI_FAILURE); });
-
-    if (aws_napi_attach_object_property_u64(
-            napi_stats, env, AWS_NAPI_KEY_INCOMPLETE_OPERATION_COUNT, stats->incomplete_operation_count)) {
-        return AWS_OP_ERR;
+    struct aws_mqtt5_client_binding *binding =
+        s_get_client_binding_argument(env, *arg++, "aws_napi_mqtt5_client_get_last_value - invalid client binding");
+    if (binding == NULL) {
+        return NULL;
     }
 
-    if (aws_napi_attach_object_property_u64(
-            napi_stats, env, AWS_NAPI_KEY_INCOMPLETE_OPERATION_SIZE, stats->incomplete_operation_size)) {
-        return AWS_OP_ERR;
+    struct aws_byte_buf topic;
+    AWS_NAPI_CALL(env, aws_byte_buf_init_from_napi(&topic, env, *arg++), {
+        napi_throw_type_error(env, NULL, "aws_napi_mqtt5_client_get_last_value - topic must be a string");
+        return NULL;
+    });
+
+    uint64_t now_ns = 0;
+    aws_high_res_clock_get_ticks(&now_ns);
+
+    struct aws_napi_mqtt_last_value_snapshot snapshot;
+    AWS_ZERO_STRUCT(snapshot);
+    int get_result = AWS_OP_SUCCESS;
+
+    /* node values are built after unlocking so that the event loop thread is not kept waiting to cache publishes */
+    aws_mutex_lock(&binding->last_value_cache_lock);
+    if (binding->last_value_cache != NULL) {
+        get_result = aws_napi_mqtt_last_value_cache_get(
+            binding->last_value_cache, aws_byte_cursor_from_buf(&topic), now_ns, &snapshot);
     }
+    aws_mutex_unlock(&binding->last_value_cache_lock);
 
-    if (aws_napi_attach_object_property_u64(
-            napi_stats, env, AWS_NAPI_KEY_UNACKED_OPERATION_COUNT, stats->unacked_operation_count)) {
-        return AWS_OP_ERR;
+    aws_byte_buf_clean_up(&topic);
+
+    napi_value result = NULL;
+    if (get_result == AWS_OP_SUCCESS) {
+        get_result = aws_napi_mqtt_last_value_snapshot_first_to_napi(&snapshot, env, &result);
     }
 
-    if (aws_napi_attach_object_property_u64(
-            napi_stats, env, AWS_NAPI_KEY_UNACKED_OPERATION_SIZE, stats->unacked_operation_size)) {
-        return AWS_OP_ERR;
-    };
+    aws_napi_mqtt_last_value_snapshot_clean_up(&snapshot);
 
-    *stats_out = napi_stats;
+    if (get_result) {
+        aws_napi_throw_last_error_with_context(env, "aws_napi_mqtt5_client_get_last_value - failed to create value");
+        return NULL;
+    }
 
-    return AWS_OP_SUCCESS;
+    return result;
 }
 
-napi_value aws_napi_mqtt5_client_get_queue_statistics(napi_env env, napi_callback_info info) {
-
-    napi_value node_args[1];
+napi_value aws_napi_mqtt5_client_get_last_value_snapshot(napi_env env, napi_callback_info info) {
+    napi_value node_args[2];
     size_t num_args = AWS_ARRAY_SIZE(node_args);
     napi_value *arg = &node_args[0];
     AWS_NAPI_CALL(env, napi_get_cb_info(env, info, &num_args, node_args, NULL, NULL), {
-        napi_throw_error(env, NULL, "aws_napi_mqtt5_client_get_queue_statistics - Failed to extract parameter array");
+        napi_throw_error(
+            env, NULL, "aws_napi_mqtt5_client_get_last_value_snapshot - Failed to extract parameter array");
         return NULL;
     });
 
     if (num_args != AWS_ARRAY_SIZE(node_args)) {
-        napi_throw_error(env, NULL, "aws_napi_mqtt5_client_get_queue_statistics - needs exactly 1 argument");
+        napi_throw_error(env, NULL, "aws_napi_mqtt5_client_get_last_value_snapshot - needs exactly 2 arguments");
         return NULL;
     }
 
-    struct aws_mqtt5_client_binding *client_binding = NULL;
-    napi_value node_binding = *arg++;
-    AWS_NAPI_CALL(env, napi_get_value_external(env, node_binding, (void **)&client_binding), {
-        napi_throw_error(
-            env,
-            NULL,
-            "aws_napi_mqtt5_client_get_queue_statistics - Failed to extract client binding from first argument");
+    struct aws_mqtt5_client_binding *binding = s_get_client_binding_argument(
+        env, *arg++, "aws_napi_mqtt5_client_get_last_value_snapshot - invalid client binding");
+    if (binding == NULL) {
         return NULL;
-    });
+    }
 
-    if (client_binding == NULL) {
-        napi_throw_error(env, NULL, "aws_napi_mqtt5_client_get_queue_statistics - binding was null");
+    struct aws_byte_buf topic_prefix;
+    AWS_NAPI_CALL(env, aws_byte_buf_init_from_napi(&topic_prefix, env, *arg++), {
+        napi_throw_type_error(
+            env, NULL, "aws_napi_mqtt5_client_get_last_value_snapshot - topic prefix must be a string");
         return NULL;
+    });
+
+    uint64_t now_ns = 0;
+    aws_high_res_clock_get_ticks(&now_ns);
+
+    struct aws_napi_mqtt_last_value_snapshot snapshot;
+    AWS_ZERO_STRUCT(snapshot);
+    int snapshot_result = AWS_OP_SUCCESS;
+
+    /* copied out under the lock; the (possibly large) node array is built after unlocking */
+    aws_mutex_lock(&binding->last_value_cache_lock);
+    if (binding->last_value_cache != NULL) {
+        snapshot_result = aws_napi_mqtt_last_value_cache_snapshot(
+            binding->last_value_cache, aws_byte_cursor_from_buf(&topic_prefix), now_ns, &snapshot);
     }
+    aws_mutex_unlock(&binding->last_value_cache_lock);
 
-    if (client_binding->client == NULL) {
-        napi_throw_error(env, NULL, "aws_napi_mqtt5_client_get_queue_statistics - client was null");
+    aws_byte_buf_clean_up(&topic_prefix);
+
+    napi_value result = NULL;
+    if (snapshot_result == AWS_OP_SUCCESS) {
+        snapshot_result = aws_napi_mqtt_last_value_snapshot_to_napi(&snapshot, env, &result);
+    }
+
+    aws_napi_mqtt_last_value_snapshot_clean_up(&snapshot);
+
+    if (snapshot_result) {
+        aws_napi_throw_last_error_with_context(
+            env, "aws_napi_mqtt5_client_get_last_value_snapshot - failed to create snapshot");
         return NULL;
     }
 
-    struct aws_mqtt5_client_operation_statistics stats;
-    AWS_ZERO_STRUCT(stats);
+    return result;
+}
 
-    aws_mqtt5_client_get_stats(client_binding->client, &stats);
+napi_value aws_napi_mqtt5_client_set_live_statistics(napi_env env, napi_callback_info info) {
+    napi_value node_args[2];
+    size_t num_args = AWS_ARRAY_SIZE(node_args);
+    napi_value *arg = &node_args[0];
+    AWS_NAPI_CALL(env, napi_get_cb_info(env, info, &num_args, node_args, NULL, NULL), {
+        napi_throw_error(env, NULL, "aws_napi_mqtt5_client_set_live_statistics - Failed to extract parameter array");
+        return NULL;
+    });
 
-    napi_value napi_stats = NULL;
-    if (s_create_napi_mqtt5_client_statistics(env, &stats, &napi_stats)) {
-        napi_throw_error(env, NULL, "aws_napi_mqtt5_client_get_queue_statistics - failed to build statistics value");
+    if (num_args != AWS_ARRAY_SIZE(node_args)) {
+        napi_throw_error(env, NULL, "aws_napi_mqtt5_client_set_live_statistics - needs exactly 2 arguments");
         return NULL;
     }
 
-    return napi_stats;
+    struct aws_mqtt5_client_binding *binding = s_get_client_binding_argument(
+        env, *arg++, "aws_napi_mqtt5_client_set_live_statistics - invalid client binding");
+    if (binding == NULL) {
+        return NULL;
+    }
+
+    if (aws_napi_live_statistics_bind_napi(&binding->live_statistics, env, *arg++)) {
+        aws_napi_throw_last_error_with_context(
+            env, "aws_napi_mqtt5_client_set_live_statistics - failed to bind live statistics memory");
+        return NULL;
+    }
+
+    s_refresh_live_operation_statistics(binding);
+
+    return NULL;
 }
 
 napi_value aws_napi_mqtt5_client_close(napi_env env, napi_callback_info info) {
@@ -3630,6 +7652,14 @@ napi_value aws_napi_mqtt5_client_close(napi_env env, napi_callback_info info) {
         return NULL;
     }
 
+    s_outbound_scheduler_close(binding);
+    s_offline_queue_close(binding);
+    s_publish_record_buffer_release(binding, env);
+    s_message_ring_close(binding, env);
+    aws_napi_live_statistics_unbind_napi(&binding->live_statistics, env);
+    aws_napi_mqtt_topic_intern_cache_destroy(binding->topic_intern_cache);
+    binding->topic_intern_cache = NULL;
+
     napi_ref node_client_external_ref = binding->node_client_external_ref;
     binding->node_client_external_ref = NULL;
 
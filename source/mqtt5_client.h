@@ -20,8 +20,37 @@ napi_value aws_napi_mqtt5_client_unsubscribe(napi_env env, napi_callback_info in
 
 napi_value aws_napi_mqtt5_client_publish(napi_env env, napi_callback_info info);
 
+napi_value aws_napi_mqtt5_client_prepare_publish(napi_env env, napi_callback_info info);
+
+napi_value aws_napi_mqtt5_client_publish_prepared(napi_env env, napi_callback_info info);
+
 napi_value aws_napi_mqtt5_client_get_queue_statistics(napi_env env, napi_callback_info info);
 
+napi_value aws_napi_mqtt5_client_enable_request_response(napi_env env, napi_callback_info info);
+
+napi_value aws_napi_mqtt5_client_disable_request_response(napi_env env, napi_callback_info info);
+
+napi_value aws_napi_mqtt5_client_add_response_filter(napi_env env, napi_callback_info info);
+
+napi_value aws_napi_mqtt5_client_remove_response_filter(napi_env env, napi_callback_info info);
+
+napi_value aws_napi_mqtt5_client_add_pending_request(napi_env env, napi_callback_info info);
+
+napi_value aws_napi_mqtt5_client_remove_pending_request(napi_env env, napi_callback_info info);
+
+napi_value aws_napi_mqtt5_client_set_message_filter(napi_env env, napi_callback_info info);
+
+napi_value aws_napi_mqtt5_client_set_last_value_cache(napi_env env, napi_callback_info info);
+
+napi_value aws_napi_mqtt5_client_get_last_value(napi_env env, napi_callback_info info);
+
+napi_value aws_napi_mqtt5_client_get_last_value_snapshot(napi_env env, napi_callback_info info);
+
+napi_value aws_napi_mqtt5_client_set_live_statistics(napi_env env, napi_callback_info info);
+
 napi_value aws_napi_mqtt5_client_close(napi_env env, napi_callback_info info);
 
+/* Registers the native-backed class used for lazily-materialized received PUBLISH packets */
+napi_status aws_napi_mqtt5_client_bind(napi_env env, napi_value exports);
+
 #endif /* AWS_CRT_NODEJS_MQTT5_CLIENT_H */
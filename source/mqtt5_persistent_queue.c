@@ -0,0 +1,981 @@
+/**
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0.
+ */
+
+#include "mqtt5_persistent_queue.h"
+
+#include <aws/checksums/crc.h>
+#include <aws/common/array_list.h>
+#include <aws/common/byte_buf.h>
+#include <aws/common/file.h>
+#include <aws/common/mutex.h>
+#include <aws/common/string.h>
+#include <aws/mqtt/v5/mqtt5_types.h>
+
+#include <errno.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#ifdef _WIN32
+#    include <io.h>
+#else
+#    include <unistd.h>
+#endif
+
+/*
+ * On-disk format
+ *
+ * The log is a sequence of segment files named mqtt5-queue-<20 digit segment id>.log.  Each segment is a sequence of
+ * records:
+ *
+ *   u8   record type (publish or ack)
+ *   u32  body length
+ *   u64  record id
+ *   ...  body
+ *   u32  crc32 of everything above
+ *
+ * An ack record has an empty body and carries the id of the publish it acknowledges.  Records are only ever appended
+ * to the newest segment; recovery never appends to a segment written by a previous process, so a torn record at the
+ * tail of a segment simply ends that segment.
+ *
+ * Threading
+ *
+ * Acknowledgements arrive on the client's event loop thread, which must never wait on disk.  They only update the
+ * in-memory accounting and are queued; the thread that appends (node's) writes them out, compacts the log and does
+ * all other file I/O.  The lock therefore only ever guards memory.
+ */
+
+#define SEGMENT_FILE_PREFIX "mqtt5-queue-"
+#define SEGMENT_FILE_SUFFIX ".log"
+
+enum aws_napi_mqtt5_persistent_record_type {
+    AWS_NMPRT_PUBLISH = 1,
+    AWS_NMPRT_ACK = 2,
+};
+
+/* type + body length + record id */
+static const size_t s_record_header_size = 1 + 4 + 8;
+static const size_t s_record_trailer_size = 4;
+
+/* optional-field presence bits in a publish record body */
+enum aws_napi_mqtt5_persistent_publish_flags {
+    AWS_NMPPF_PAYLOAD_FORMAT = 1 << 0,
+    AWS_NMPPF_MESSAGE_EXPIRY_INTERVAL = 1 << 1,
+    AWS_NMPPF_RESPONSE_TOPIC = 1 << 2,
+    AWS_NMPPF_CORRELATION_DATA = 1 << 3,
+    AWS_NMPPF_CONTENT_TYPE = 1 << 4,
+};
+
+struct aws_napi_mqtt5_persistent_segment {
+    uint64_t id;
+
+    /* publishes with ids >= first_record_id (and below the next segment's first_record_id) live in this segment */
+    uint64_t first_record_id;
+
+    uint64_t size;
+
+    /* number of unacknowledged publishes in this segment */
+    uint64_t live_count;
+};
+
+struct aws_napi_mqtt5_recovered_publish {
+    uint64_t record_id;
+    struct aws_byte_buf body;
+    bool acknowledged;
+};
+
+struct aws_napi_mqtt5_persistent_queue {
+    struct aws_allocator *allocator;
+
+    struct aws_string *directory;
+    uint64_t max_size;
+    uint64_t segment_size;
+
+    /* only touched by the appending thread */
+    FILE *current_segment_file;
+    uint64_t next_segment_id;
+    struct aws_byte_buf record_buffer;
+
+    struct aws_mutex lock;
+
+    /*
+     * Everything below is protected by lock.  Only the appending thread adds or removes segments and changes sizes
+     * or next_record_id, so it may read those without the lock.
+     */
+
+    /* aws_napi_mqtt5_persistent_segment, oldest first; the last entry is the segment being appended to */
+    struct aws_array_list segments;
+
+    uint64_t next_record_id;
+    uint64_t size;
+    uint64_t pending_count;
+
+    /* uint64_t record ids acknowledged since the last flush, not yet written to the log */
+    struct aws_array_list unwritten_acks;
+
+    /* aws_napi_mqtt5_recovered_publish, in append order; emptied by replay */
+    struct aws_array_list recovered_publishes;
+};
+
+static struct aws_napi_mqtt5_persistent_segment *s_get_current_segment(struct aws_napi_mqtt5_persistent_queue *queue) {
+    struct aws_napi_mqtt5_persistent_segment *current = NULL;
+    aws_array_list_get_at_ptr(&queue->segments, (void **)&current, aws_array_list_length(&queue->segments) - 1);
+
+    return current;
+}
+
+static struct aws_string *s_segment_path_new(struct aws_napi_mqtt5_persistent_queue *queue, uint64_t segment_id) {
+    char path[1024];
+    snprintf(
+        path,
+        AWS_ARRAY_SIZE(path),
+        "%s%c" SEGMENT_FILE_PREFIX "%020" PRIu64 SEGMENT_FILE_SUFFIX,
+        aws_string_c_str(queue->directory),
+        aws_get_platform_directory_separator(),
+        segment_id);
+
+    return aws_string_new_from_c_str(queue->allocator, path);
+}
+
+static void s_delete_segment_file(struct aws_napi_mqtt5_persistent_queue *queue, uint64_t segment_id) {
+    struct aws_string *path = s_segment_path_new(queue, segment_id);
+    if (aws_file_delete(path)) {
+        AWS_LOGF_WARN(
+            AWS_LS_NODEJS_CRT_GENERAL,
+            "id=%p mqtt5 persistent queue - failed to delete segment %s with error %s",
+            (void *)queue,
+            aws_string_c_str(path),
+            aws_error_debug_str(aws_last_error()));
+    }
+    aws_string_destroy(path);
+}
+
+static int s_open_new_segment(struct aws_napi_mqtt5_persistent_queue *queue) {
+    if (queue->current_segment_file != NULL) {
+        fclose(queue->current_segment_file);
+        queue->current_segment_file = NULL;
+    }
+
+    struct aws_napi_mqtt5_persistent_segment segment = {
+        .id = queue->next_segment_id,
+        .first_record_id = queue->next_record_id,
+        .size = 0,
+        .live_count = 0,
+    };
+
+    struct aws_string *path = s_segment_path_new(queue, segment.id);
+    queue->current_segment_file = aws_fopen(aws_string_c_str(path), "wb");
+    aws_string_destroy(path);
+
+    if (queue->current_segment_file == NULL) {
+        return AWS_OP_ERR;
+    }
+
+    aws_mutex_lock(&queue->lock);
+    int push_result = aws_array_list_push_back(&queue->segments, &segment);
+    aws_mutex_unlock(&queue->lock);
+
+    if (push_result) {
+        fclose(queue->current_segment_file);
+        queue->current_segment_file = NULL;
+        s_delete_segment_file(queue, segment.id);
+        return AWS_OP_ERR;
+    }
+
+    ++queue->next_segment_id;
+
+    return AWS_OP_SUCCESS;
+}
+
+static struct aws_napi_mqtt5_persistent_segment *s_get_segment_for_record(
+    struct aws_napi_mqtt5_persistent_queue *queue,
+    uint64_t record_id) {
+
+    struct aws_napi_mqtt5_persistent_segment *result = NULL;
+
+    size_t segment_count = aws_array_list_length(&queue->segments);
+    for (size_t i = 0; i < segment_count; ++i) {
+        struct aws_napi_mqtt5_persistent_segment *segment = NULL;
+        aws_array_list_get_at_ptr(&queue->segments, (void **)&segment, i);
+
+        if (segment->first_record_id > record_id) {
+            break;
+        }
+
+        result = segment;
+    }
+
+    return result;
+}
+
+/*
+ * Compaction: drop fully-acknowledged segments from the head of the log.  Acks for a segment may live in later
+ * segments, so only a prefix of the log can ever be dropped without resurrecting acknowledged publishes.  If nothing
+ * is pending at all, the whole log is discarded and restarted.  Segments are unlinked from the log under the lock and
+ * their files deleted after it is released.  Appending thread only.
+ */
+static void s_compact(struct aws_napi_mqtt5_persistent_queue *queue) {
+    struct aws_array_list dropped_segments;
+    if (aws_array_list_init_dynamic(
+            &dropped_segments, queue->allocator, 4, sizeof(struct aws_napi_mqtt5_persistent_segment))) {
+        return;
+    }
+
+    bool restart = false;
+
+    aws_mutex_lock(&queue->lock);
+    if (queue->pending_count == 0) {
+        size_t segment_count = aws_array_list_length(&queue->segments);
+        if (segment_count > 1 || (segment_count == 1 && s_get_current_segment(queue)->size > 0)) {
+            aws_array_list_swap_contents(&queue->segments, &dropped_segments);
+            queue->size = 0;
+            restart = true;
+        }
+    } else {
+        while (aws_array_list_length(&queue->segments) > 1) {
+            struct aws_napi_mqtt5_persistent_segment head;
+            aws_array_list_front(&queue->segments, &head);
+            if (head.live_count > 0 || aws_array_list_push_back(&dropped_segments, &head)) {
+                break;
+            }
+
+            queue->size -= head.size;
+            aws_array_list_pop_front(&queue->segments);
+        }
+    }
+    aws_mutex_unlock(&queue->lock);
+
+    if (restart && queue->current_segment_file != NULL) {
+        fclose(queue->current_segment_file);
+        queue->current_segment_file = NULL;
+    }
+
+    size_t dropped_count = aws_array_list_length(&dropped_segments);
+    for (size_t i = 0; i < dropped_count; ++i) {
+        struct aws_napi_mqtt5_persistent_segment *segment = NULL;
+        aws_array_list_get_at_ptr(&dropped_segments, (void **)&segment, i);
+        s_delete_segment_file(queue, segment->id);
+    }
+    aws_array_list_clean_up(&dropped_segments);
+
+    if (restart && s_open_new_segment(queue)) {
+        AWS_LOGF_ERROR(
+            AWS_LS_NODEJS_CRT_GENERAL,
+            "id=%p mqtt5 persistent queue - failed to open a new segment after compaction",
+            (void *)queue);
+    }
+}
+
+/* Forces a segment's contents to stable storage, not just the OS page cache */
+static int s_sync_segment_file(FILE *file) {
+#ifdef _WIN32
+    if (_commit(_fileno(file)) != 0) {
+        return aws_translate_and_raise_io_error(errno);
+    }
+#else
+    if (fsync(fileno(file)) != 0) {
+        return aws_translate_and_raise_io_error(errno);
+    }
+#endif
+
+    return AWS_OP_SUCCESS;
+}
+
+static void s_write_cursor_u16(struct aws_byte_buf *buffer, struct aws_byte_cursor cursor) {
+    aws_byte_buf_write_be16(buffer, (uint16_t)cursor.len);
+    aws_byte_buf_write_from_whole_cursor(buffer, cursor);
+}
+
+static size_t s_compute_publish_body_size(const struct aws_mqtt5_packet_publish_view *publish_view) {
+    size_t size = 3 + 2 + publish_view->topic.len;
+
+    if (publish_view->payload_format != NULL) {
+        size += 1;
+    }
+    if (publish_view->message_expiry_interval_seconds != NULL) {
+        size += 4;
+    }
+    if (publish_view->response_topic != NULL) {
+        size += 2 + publish_view->response_topic->len;
+    }
+    if (publish_view->correlation_data != NULL) {
+        size += 2 + publish_view->correlation_data->len;
+    }
+    if (publish_view->content_type != NULL) {
+        size += 2 + publish_view->content_type->len;
+    }
+
+    size += 2;
+    for (size_t i = 0; i < publish_view->user_property_count; ++i) {
+        size += 4 + publish_view->user_properties[i].name.len + publish_view->user_properties[i].value.len;
+    }
+
+    size += 4 + publish_view->payload.len;
+
+    return size;
+}
+
+static void s_write_publish_body(struct aws_byte_buf *buffer, const struct aws_mqtt5_packet_publish_view *publish_view) {
+    uint8_t flags = 0;
+    if (publish_view->payload_format != NULL) {
+        flags |= AWS_NMPPF_PAYLOAD_FORMAT;
+    }
+    if (publish_view->message_expiry_interval_seconds != NULL) {
+        flags |= AWS_NMPPF_MESSAGE_EXPIRY_INTERVAL;
+    }
+    if (publish_view->response_topic != NULL) {
+        flags |= AWS_NMPPF_RESPONSE_TOPIC;
+    }
+    if (publish_view->correlation_data != NULL) {
+        flags |= AWS_NMPPF_CORRELATION_DATA;
+    }
+    if (publish_view->content_type != NULL) {
+        flags |= AWS_NMPPF_CONTENT_TYPE;
+    }
+
+    aws_byte_buf_write_u8(buffer, (uint8_t)publish_view->qos);
+    aws_byte_buf_write_u8(buffer, publish_view->retain ? 1 : 0);
+    aws_byte_buf_write_u8(buffer, flags);
+
+    s_write_cursor_u16(buffer, publish_view->topic);
+
+    if (publish_view->payload_format != NULL) {
+        aws_byte_buf_write_u8(buffer, (uint8_t)*publish_view->payload_format);
+    }
+    if (publish_view->message_expiry_interval_seconds != NULL) {
+        aws_byte_buf_write_be32(buffer, *publish_view->message_expiry_interval_seconds);
+    }
+    if (publish_view->response_topic != NULL) {
+        s_write_cursor_u16(buffer, *publish_view->response_topic);
+    }
+    if (publish_view->correlation_data != NULL) {
+        s_write_cursor_u16(buffer, *publish_view->correlation_data);
+    }
+    if (publish_view->content_type != NULL) {
+        s_write_cursor_u16(buffer, *publish_view->content_type);
+    }
+
+    aws_byte_buf_write_be16(buffer, (uint16_t)publish_view->user_property_count);
+    for (size_t i = 0; i < publish_view->user_property_count; ++i) {
+        s_write_cursor_u16(buffer, publish_view->user_properties[i].name);
+        s_write_cursor_u16(buffer, publish_view->user_properties[i].value);
+    }
+
+    aws_byte_buf_write_be32(buffer, (uint32_t)publish_view->payload.len);
+    aws_byte_buf_write_from_whole_cursor(buffer, publish_view->payload);
+}
+
+/*
+ * Serializes a record into the scratch buffer and writes it to the current segment.  With sync, the record is on
+ * stable storage when this returns; otherwise it has only been handed to the OS.  Appending thread only, without the
+ * lock held.
+ */
+static int s_append_record(
+    struct aws_napi_mqtt5_persistent_queue *queue,
+    enum aws_napi_mqtt5_persistent_record_type type,
+    uint64_t record_id,
+    const struct aws_mqtt5_packet_publish_view *publish_view,
+    bool enforce_budget,
+    bool sync) {
+
+    size_t body_size = (publish_view != NULL) ? s_compute_publish_body_size(publish_view) : 0;
+    size_t record_size = s_record_header_size + body_size + s_record_trailer_size;
+
+    if (enforce_budget && queue->size + record_size > queue->max_size) {
+        return aws_raise_error(AWS_CRT_NODEJS_ERROR_MQTT5_PERSISTENT_QUEUE_FULL);
+    }
+
+    /* a previous compaction may have failed to start a fresh segment */
+    if (queue->current_segment_file == NULL && s_open_new_segment(queue)) {
+        return AWS_OP_ERR;
+    }
+
+    struct aws_napi_mqtt5_persistent_segment *current = s_get_current_segment(queue);
+    if (current->size > 0 && current->size + record_size > queue->segment_size) {
+        if (s_open_new_segment(queue)) {
+            return AWS_OP_ERR;
+        }
+    }
+
+    aws_byte_buf_reset(&queue->record_buffer, false);
+    if (aws_byte_buf_reserve(&queue->record_buffer, record_size)) {
+        return AWS_OP_ERR;
+    }
+
+    aws_byte_buf_write_u8(&queue->record_buffer, (uint8_t)type);
+    aws_byte_buf_write_be32(&queue->record_buffer, (uint32_t)body_size);
+    aws_byte_buf_write_be64(&queue->record_buffer, record_id);
+    if (publish_view != NULL) {
+        s_write_publish_body(&queue->record_buffer, publish_view);
+    }
+
+    uint32_t crc = aws_checksums_crc32_ex(queue->record_buffer.buffer, queue->record_buffer.len, 0);
+    aws_byte_buf_write_be32(&queue->record_buffer, crc);
+    AWS_FATAL_ASSERT(queue->record_buffer.len == record_size);
+
+    if (fwrite(queue->record_buffer.buffer, 1, record_size, queue->current_segment_file) != record_size ||
+        fflush(queue->current_segment_file) != 0) {
+        return aws_translate_and_raise_io_error(errno);
+    }
+
+    if (sync && s_sync_segment_file(queue->current_segment_file)) {
+        return AWS_OP_ERR;
+    }
+
+    aws_mutex_lock(&queue->lock);
+    current = s_get_current_segment(queue);
+    current->size += record_size;
+    queue->size += record_size;
+    aws_mutex_unlock(&queue->lock);
+
+    return AWS_OP_SUCCESS;
+}
+
+/*
+ * Recovery
+ */
+
+struct segment_file_listing {
+    struct aws_array_list segment_ids;
+};
+
+static bool s_on_directory_entry(const struct aws_directory_entry *entry, void *user_data) {
+    struct segment_file_listing *listing = user_data;
+
+    if ((entry->file_type & AWS_FILE_TYPE_FILE) == 0) {
+        return true;
+    }
+
+    struct aws_byte_cursor name = entry->relative_path;
+    struct aws_byte_cursor prefix = aws_byte_cursor_from_c_str(SEGMENT_FILE_PREFIX);
+    struct aws_byte_cursor suffix = aws_byte_cursor_from_c_str(SEGMENT_FILE_SUFFIX);
+    if (name.len != prefix.len + 20 + suffix.len || !aws_byte_cursor_starts_with(&name, &prefix)) {
+        return true;
+    }
+
+    char digits[21];
+    memcpy(digits, name.ptr + prefix.len, 20);
+    digits[20] = 0;
+
+    char *end = NULL;
+    uint64_t segment_id = strtoull(digits, &end, 10);
+    if (end != digits + 20) {
+        return true;
+    }
+
+    aws_array_list_push_back(&listing->segment_ids, &segment_id);
+
+    return true;
+}
+
+static int s_compare_segment_ids(const void *a, const void *b) {
+    uint64_t lhs = *(const uint64_t *)a;
+    uint64_t rhs = *(const uint64_t *)b;
+
+    return (lhs < rhs) ? -1 : ((lhs > rhs) ? 1 : 0);
+}
+
+static void s_recovered_publish_clean_up(struct aws_napi_mqtt5_recovered_publish *recovered) {
+    aws_byte_buf_clean_up(&recovered->body);
+}
+
+/* publish records are appended in id order, so the recovered list is sorted by record id */
+static struct aws_napi_mqtt5_recovered_publish *s_find_recovered_publish(
+    struct aws_napi_mqtt5_persistent_queue *queue,
+    uint64_t record_id) {
+
+    size_t low = 0;
+    size_t high = aws_array_list_length(&queue->recovered_publishes);
+    while (low < high) {
+        size_t middle = low + (high - low) / 2;
+
+        struct aws_napi_mqtt5_recovered_publish *recovered = NULL;
+        aws_array_list_get_at_ptr(&queue->recovered_publishes, (void **)&recovered, middle);
+
+        if (recovered->record_id == record_id) {
+            return recovered;
+        } else if (recovered->record_id < record_id) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+
+    return NULL;
+}
+
+/* Replays one segment file into the in-memory recovery state */
+static void s_recover_segment(struct aws_napi_mqtt5_persistent_queue *queue, uint64_t segment_id) {
+    struct aws_string *path = s_segment_path_new(queue, segment_id);
+
+    struct aws_byte_buf contents;
+    AWS_ZERO_STRUCT(contents);
+    if (aws_byte_buf_init_from_file(&contents, queue->allocator, aws_string_c_str(path))) {
+        AWS_LOGF_WARN(
+            AWS_LS_NODEJS_CRT_GENERAL,
+            "id=%p mqtt5 persistent queue - unable to read segment %s, skipping",
+            (void *)queue,
+            aws_string_c_str(path));
+        aws_string_destroy(path);
+        return;
+    }
+
+    struct aws_napi_mqtt5_persistent_segment segment = {
+        .id = segment_id,
+        .first_record_id = queue->next_record_id,
+        .size = contents.len,
+        .live_count = 0,
+    };
+    aws_array_list_push_back(&queue->segments, &segment);
+    queue->size += contents.len;
+
+    struct aws_byte_cursor cursor = aws_byte_cursor_from_buf(&contents);
+    while (cursor.len > 0) {
+        struct aws_byte_cursor record_start = cursor;
+
+        uint8_t type = 0;
+        uint32_t body_size = 0;
+        uint64_t record_id = 0;
+        if (!aws_byte_cursor_read_u8(&cursor, &type) || !aws_byte_cursor_read_be32(&cursor, &body_size) ||
+            !aws_byte_cursor_read_be64(&cursor, &record_id) || cursor.len < (size_t)body_size + s_record_trailer_size) {
+            break;
+        }
+
+        struct aws_byte_cursor body = aws_byte_cursor_advance(&cursor, body_size);
+
+        uint32_t stored_crc = 0;
+        aws_byte_cursor_read_be32(&cursor, &stored_crc);
+        uint32_t crc = aws_checksums_crc32_ex(record_start.ptr, s_record_header_size + body_size, 0);
+        if (crc != stored_crc) {
+            break;
+        }
+
+        if (type == AWS_NMPRT_PUBLISH) {
+            struct aws_napi_mqtt5_recovered_publish recovered = {
+                .record_id = record_id,
+            };
+            if (aws_byte_buf_init_copy_from_cursor(&recovered.body, queue->allocator, body) ||
+                aws_array_list_push_back(&queue->recovered_publishes, &recovered)) {
+                aws_byte_buf_clean_up(&recovered.body);
+                break;
+            }
+
+            if (record_id >= queue->next_record_id) {
+                queue->next_record_id = record_id + 1;
+            }
+        } else if (type == AWS_NMPRT_ACK) {
+            struct aws_napi_mqtt5_recovered_publish *recovered = s_find_recovered_publish(queue, record_id);
+            if (recovered != NULL) {
+                recovered->acknowledged = true;
+            }
+        }
+    }
+
+    if (cursor.len > 0) {
+        AWS_LOGF_WARN(
+            AWS_LS_NODEJS_CRT_GENERAL,
+            "id=%p mqtt5 persistent queue - segment %s ends with %zu unreadable bytes",
+            (void *)queue,
+            aws_string_c_str(path),
+            cursor.len);
+    }
+
+    aws_byte_buf_clean_up(&contents);
+    aws_string_destroy(path);
+}
+
+static int s_recover(struct aws_napi_mqtt5_persistent_queue *queue) {
+    struct segment_file_listing listing;
+    if (aws_array_list_init_dynamic(&listing.segment_ids, queue->allocator, 8, sizeof(uint64_t))) {
+        return AWS_OP_ERR;
+    }
+
+    if (aws_directory_traverse(queue->allocator, queue->directory, false, s_on_directory_entry, &listing)) {
+        aws_array_list_clean_up(&listing.segment_ids);
+        return AWS_OP_ERR;
+    }
+
+    aws_array_list_sort(&listing.segment_ids, s_compare_segment_ids);
+
+    size_t segment_count = aws_array_list_length(&listing.segment_ids);
+    for (size_t i = 0; i < segment_count; ++i) {
+        uint64_t segment_id = 0;
+        aws_array_list_get_at(&listing.segment_ids, &segment_id, i);
+
+        s_recover_segment(queue, segment_id);
+
+        if (segment_id >= queue->next_segment_id) {
+            queue->next_segment_id = segment_id + 1;
+        }
+    }
+
+    aws_array_list_clean_up(&listing.segment_ids);
+
+    /* drop acknowledged publishes and charge the rest to the segments they live in */
+    size_t recovered_count = aws_array_list_length(&queue->recovered_publishes);
+    size_t kept_count = 0;
+    for (size_t i = 0; i < recovered_count; ++i) {
+        struct aws_napi_mqtt5_recovered_publish recovered;
+        aws_array_list_get_at(&queue->recovered_publishes, &recovered, i);
+
+        if (recovered.acknowledged) {
+            s_recovered_publish_clean_up(&recovered);
+            continue;
+        }
+
+        ++s_get_segment_for_record(queue, recovered.record_id)->live_count;
+        ++queue->pending_count;
+
+        aws_array_list_set_at(&queue->recovered_publishes, &recovered, kept_count++);
+    }
+
+    while (aws_array_list_length(&queue->recovered_publishes) > kept_count) {
+        aws_array_list_pop_back(&queue->recovered_publishes);
+    }
+
+    AWS_LOGF_INFO(
+        AWS_LS_NODEJS_CRT_GENERAL,
+        "id=%p mqtt5 persistent queue - recovered %" PRIu64 " unacknowledged publishes from %zu segments",
+        (void *)queue,
+        queue->pending_count,
+        segment_count);
+
+    return AWS_OP_SUCCESS;
+}
+
+static void s_persistent_queue_clean_up(struct aws_napi_mqtt5_persistent_queue *queue) {
+    if (queue->current_segment_file != NULL) {
+        fclose(queue->current_segment_file);
+    }
+
+    size_t recovered_count = aws_array_list_length(&queue->recovered_publishes);
+    for (size_t i = 0; i < recovered_count; ++i) {
+        struct aws_napi_mqtt5_recovered_publish *recovered = NULL;
+        aws_array_list_get_at_ptr(&queue->recovered_publishes, (void **)&recovered, i);
+        s_recovered_publish_clean_up(recovered);
+    }
+
+    aws_array_list_clean_up(&queue->recovered_publishes);
+    aws_array_list_clean_up(&queue->unwritten_acks);
+    aws_array_list_clean_up(&queue->segments);
+    aws_byte_buf_clean_up(&queue->record_buffer);
+    aws_string_destroy(queue->directory);
+    aws_mutex_clean_up(&queue->lock);
+
+    aws_mem_release(queue->allocator, queue);
+}
+
+struct aws_napi_mqtt5_persistent_queue *aws_napi_mqtt5_persistent_queue_new(
+    struct aws_allocator *allocator,
+    const struct aws_napi_mqtt5_persistent_queue_options *options) {
+
+    if (options->directory.len == 0 || options->max_size == 0 || options->segment_size == 0) {
+        aws_raise_error(AWS_ERROR_INVALID_ARGUMENT);
+        return NULL;
+    }
+
+    struct aws_napi_mqtt5_persistent_queue *queue =
+        aws_mem_calloc(allocator, 1, sizeof(struct aws_napi_mqtt5_persistent_queue));
+    queue->allocator = allocator;
+    queue->max_size = options->max_size;
+    queue->segment_size = options->segment_size;
+    queue->next_record_id = 1;
+    aws_mutex_init(&queue->lock);
+
+    queue->directory = aws_string_new_from_cursor(allocator, &options->directory);
+    if (aws_array_list_init_dynamic(
+            &queue->segments, allocator, 4, sizeof(struct aws_napi_mqtt5_persistent_segment)) ||
+        aws_array_list_init_dynamic(
+            &queue->recovered_publishes, allocator, 0, sizeof(struct aws_napi_mqtt5_recovered_publish)) ||
+        aws_array_list_init_dynamic(&queue->unwritten_acks, allocator, 16, sizeof(uint64_t)) ||
+        aws_byte_buf_init(&queue->record_buffer, allocator, 1024)) {
+        goto error;
+    }
+
+    if (!aws_directory_exists(queue->directory) && aws_directory_create(queue->directory)) {
+        AWS_LOGF_ERROR(
+            AWS_LS_NODEJS_CRT_GENERAL,
+            "id=%p mqtt5 persistent queue - unable to create directory %s",
+            (void *)queue,
+            aws_string_c_str(queue->directory));
+        goto error;
+    }
+
+    if (s_recover(queue)) {
+        goto error;
+    }
+
+    /* never append to a segment written by a previous process */
+    if (s_open_new_segment(queue)) {
+        goto error;
+    }
+
+    return queue;
+
+error:
+
+    s_persistent_queue_clean_up(queue);
+
+    return NULL;
+}
+
+void aws_napi_mqtt5_persistent_queue_destroy(struct aws_napi_mqtt5_persistent_queue *queue) {
+    if (queue == NULL) {
+        return;
+    }
+
+    aws_napi_mqtt5_persistent_queue_flush(queue);
+
+    s_persistent_queue_clean_up(queue);
+}
+
+int aws_napi_mqtt5_persistent_queue_append(
+    struct aws_napi_mqtt5_persistent_queue *queue,
+    const struct aws_mqtt5_packet_publish_view *publish_view,
+    uint64_t *record_id_out) {
+
+    /* written-out acks and compaction keep the byte budget honest */
+    aws_napi_mqtt5_persistent_queue_flush(queue);
+
+    uint64_t record_id = queue->next_record_id;
+    if (s_append_record(queue, AWS_NMPRT_PUBLISH, record_id, publish_view, true, true)) {
+        return AWS_OP_ERR;
+    }
+
+    aws_mutex_lock(&queue->lock);
+    ++s_get_current_segment(queue)->live_count;
+    ++queue->next_record_id;
+    ++queue->pending_count;
+    aws_mutex_unlock(&queue->lock);
+
+    *record_id_out = record_id;
+
+    return AWS_OP_SUCCESS;
+}
+
+int aws_napi_mqtt5_persistent_queue_acknowledge(struct aws_napi_mqtt5_persistent_queue *queue, uint64_t record_id) {
+    int result = AWS_OP_SUCCESS;
+
+    aws_mutex_lock(&queue->lock);
+
+    struct aws_napi_mqtt5_persistent_segment *owner = s_get_segment_for_record(queue, record_id);
+    if (owner == NULL || owner->live_count == 0) {
+        result = aws_raise_error(AWS_ERROR_INVALID_ARGUMENT);
+        goto done;
+    }
+
+    --owner->live_count;
+    --queue->pending_count;
+
+    if (aws_array_list_push_back(&queue->unwritten_acks, &record_id)) {
+        /* the publish will be replayed after a restart; not fatal, but worth knowing about */
+        AWS_LOGF_ERROR(
+            AWS_LS_NODEJS_CRT_GENERAL,
+            "id=%p mqtt5 persistent queue - failed to queue ack for record %" PRIu64 " with error %s",
+            (void *)queue,
+            record_id,
+            aws_error_debug_str(aws_last_error()));
+        result = AWS_OP_ERR;
+    }
+
+done:
+
+    aws_mutex_unlock(&queue->lock);
+
+    return result;
+}
+
+int aws_napi_mqtt5_persistent_queue_flush(struct aws_napi_mqtt5_persistent_queue *queue) {
+    int result = AWS_OP_SUCCESS;
+
+    struct aws_array_list acks;
+    if (aws_array_list_init_dynamic(&acks, queue->allocator, 0, sizeof(uint64_t))) {
+        return AWS_OP_ERR;
+    }
+
+    aws_mutex_lock(&queue->lock);
+    aws_array_list_swap_contents(&queue->unwritten_acks, &acks);
+    bool is_pending = queue->pending_count > 0;
+    aws_mutex_unlock(&queue->lock);
+
+    /* if nothing is pending, compaction discards the whole log and no ack records are needed */
+    size_t ack_count = is_pending ? aws_array_list_length(&acks) : 0;
+    for (size_t i = 0; i < ack_count; ++i) {
+        uint64_t record_id = 0;
+        aws_array_list_get_at(&acks, &record_id, i);
+
+        if (s_append_record(queue, AWS_NMPRT_ACK, record_id, NULL, false, false)) {
+            /* the publish will be replayed after a restart; not fatal, but worth knowing about */
+            AWS_LOGF_ERROR(
+                AWS_LS_NODEJS_CRT_GENERAL,
+                "id=%p mqtt5 persistent queue - failed to record ack for record %" PRIu64 " with error %s",
+                (void *)queue,
+                record_id,
+                aws_error_debug_str(aws_last_error()));
+            result = AWS_OP_ERR;
+        }
+    }
+
+    aws_array_list_clean_up(&acks);
+
+    s_compact(queue);
+
+    return result;
+}
+
+static int s_decode_cursor_u16(struct aws_byte_cursor *cursor, struct aws_byte_cursor *value_out) {
+    uint16_t length = 0;
+    if (!aws_byte_cursor_read_be16(cursor, &length) || cursor->len < length) {
+        return aws_raise_error(AWS_ERROR_INVALID_ARGUMENT);
+    }
+
+    *value_out = aws_byte_cursor_advance(cursor, length);
+    return AWS_OP_SUCCESS;
+}
+
+/* storage backing a decoded publish view; all cursors point into the record body */
+struct aws_napi_mqtt5_decoded_publish {
+    struct aws_mqtt5_packet_publish_view view;
+
+    enum aws_mqtt5_payload_format_indicator payload_format;
+    uint32_t message_expiry_interval_seconds;
+    struct aws_byte_cursor response_topic;
+    struct aws_byte_cursor correlation_data;
+    struct aws_byte_cursor content_type;
+
+    struct aws_array_list user_properties;
+};
+
+static int s_decode_publish_body(struct aws_byte_cursor body, struct aws_napi_mqtt5_decoded_publish *decoded) {
+    uint8_t qos = 0;
+    uint8_t retain = 0;
+    uint8_t flags = 0;
+    if (!aws_byte_cursor_read_u8(&body, &qos) || !aws_byte_cursor_read_u8(&body, &retain) ||
+        !aws_byte_cursor_read_u8(&body, &flags)) {
+        return aws_raise_error(AWS_ERROR_INVALID_ARGUMENT);
+    }
+
+    decoded->view.qos = (enum aws_mqtt5_qos)qos;
+    decoded->view.retain = retain != 0;
+
+    if (s_decode_cursor_u16(&body, &decoded->view.topic)) {
+        return AWS_OP_ERR;
+    }
+
+    if (flags & AWS_NMPPF_PAYLOAD_FORMAT) {
+        uint8_t payload_format = 0;
+        if (!aws_byte_cursor_read_u8(&body, &payload_format)) {
+            return aws_raise_error(AWS_ERROR_INVALID_ARGUMENT);
+        }
+        decoded->payload_format = (enum aws_mqtt5_payload_format_indicator)payload_format;
+        decoded->view.payload_format = &decoded->payload_format;
+    }
+
+    if (flags & AWS_NMPPF_MESSAGE_EXPIRY_INTERVAL) {
+        if (!aws_byte_cursor_read_be32(&body, &decoded->message_expiry_interval_seconds)) {
+            return aws_raise_error(AWS_ERROR_INVALID_ARGUMENT);
+        }
+        decoded->view.message_expiry_interval_seconds = &decoded->message_expiry_interval_seconds;
+    }
+
+    if (flags & AWS_NMPPF_RESPONSE_TOPIC) {
+        if (s_decode_cursor_u16(&body, &decoded->response_topic)) {
+            return AWS_OP_ERR;
+        }
+        decoded->view.response_topic = &decoded->response_topic;
+    }
+
+    if (flags & AWS_NMPPF_CORRELATION_DATA) {
+        if (s_decode_cursor_u16(&body, &decoded->correlation_data)) {
+            return AWS_OP_ERR;
+        }
+        decoded->view.correlation_data = &decoded->correlation_data;
+    }
+
+    if (flags & AWS_NMPPF_CONTENT_TYPE) {
+        if (s_decode_cursor_u16(&body, &decoded->content_type)) {
+            return AWS_OP_ERR;
+        }
+        decoded->view.content_type = &decoded->content_type;
+    }
+
+    uint16_t user_property_count = 0;
+    if (!aws_byte_cursor_read_be16(&body, &user_property_count)) {
+        return aws_raise_error(AWS_ERROR_INVALID_ARGUMENT);
+    }
+
+    for (uint16_t i = 0; i < user_property_count; ++i) {
+        struct aws_mqtt5_user_property property;
+        if (s_decode_cursor_u16(&body, &property.name) || s_decode_cursor_u16(&body, &property.value)) {
+            return AWS_OP_ERR;
+        }
+        if (aws_array_list_push_back(&decoded->user_properties, &property)) {
+            return AWS_OP_ERR;
+        }
+    }
+
+    decoded->view.user_property_count = aws_array_list_length(&decoded->user_properties);
+    decoded->view.user_properties = decoded->user_properties.data;
+
+    uint32_t payload_length = 0;
+    if (!aws_byte_cursor_read_be32(&body, &payload_length) || body.len < payload_length) {
+        return aws_raise_error(AWS_ERROR_INVALID_ARGUMENT);
+    }
+    decoded->view.payload = aws_byte_cursor_advance(&body, payload_length);
+
+    return AWS_OP_SUCCESS;
+}
+
+void aws_napi_mqtt5_persistent_queue_replay(
+    struct aws_napi_mqtt5_persistent_queue *queue,
+    aws_napi_mqtt5_persistent_queue_replay_fn *replay_fn,
+    void *user_data) {
+
+    /* take ownership of the recovered publishes so replay_fn may call back into the queue */
+    struct aws_array_list recovered_publishes;
+    aws_mutex_lock(&queue->lock);
+    recovered_publishes = queue->recovered_publishes;
+    aws_array_list_init_dynamic(
+        &queue->recovered_publishes, queue->allocator, 0, sizeof(struct aws_napi_mqtt5_recovered_publish));
+    aws_mutex_unlock(&queue->lock);
+
+    size_t recovered_count = aws_array_list_length(&recovered_publishes);
+    for (size_t i = 0; i < recovered_count; ++i) {
+        struct aws_napi_mqtt5_recovered_publish *recovered = NULL;
+        aws_array_list_get_at_ptr(&recovered_publishes, (void **)&recovered, i);
+
+        struct aws_napi_mqtt5_decoded_publish decoded;
+        AWS_ZERO_STRUCT(decoded);
+        aws_array_list_init_dynamic(
+            &decoded.user_properties, queue->allocator, 0, sizeof(struct aws_mqtt5_user_property));
+
+        if (s_decode_publish_body(aws_byte_cursor_from_buf(&recovered->body), &decoded) == AWS_OP_SUCCESS) {
+            replay_fn(recovered->record_id, &decoded.view, user_data);
+        } else {
+            AWS_LOGF_ERROR(
+                AWS_LS_NODEJS_CRT_GENERAL,
+                "id=%p mqtt5 persistent queue - discarding undecodable record %" PRIu64,
+                (void *)queue,
+                recovered->record_id);
+            aws_napi_mqtt5_persistent_queue_acknowledge(queue, recovered->record_id);
+        }
+
+        aws_array_list_clean_up(&decoded.user_properties);
+        s_recovered_publish_clean_up(recovered);
+    }
+
+    aws_array_list_clean_up(&recovered_publishes);
+}
+
+void aws_napi_mqtt5_persistent_queue_get_statistics(
+    struct aws_napi_mqtt5_persistent_queue *queue,
+    struct aws_napi_mqtt5_persistent_queue_statistics *stats) {
+
+    aws_mutex_lock(&queue->lock);
+    stats->pending_count = queue->pending_count;
+    stats->size = queue->size;
+    stats->segment_count = aws_array_list_length(&queue->segments);
+    aws_mutex_unlock(&queue->lock);
+}
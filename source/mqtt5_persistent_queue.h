@@ -0,0 +1,89 @@
+/**
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0.
+ */
+
+#ifndef AWS_CRT_NODEJS_MQTT5_PERSISTENT_QUEUE_H
+#define AWS_CRT_NODEJS_MQTT5_PERSISTENT_QUEUE_H
+
+#include "module.h"
+
+struct aws_mqtt5_packet_publish_view;
+
+/*
+ * A disk-backed, append-only log of outbound QoS 1 publishes.  Publishes are appended before they are handed to the
+ * native client and acknowledged once they complete.  Fully-acknowledged segments at the head of the log are deleted
+ * as acknowledgements are flushed, and anything left unacknowledged when the process exits is recovered the next time
+ * a queue is opened on the same directory.
+ *
+ * Appends are synced to stable storage before they return.  Acknowledgements are not: they are cheap enough to call
+ * from an event loop thread and only reach the log on the next flush, so a crash may cause an already-completed
+ * publish to be replayed (at-least-once, never lost).
+ *
+ * acknowledge and get_statistics may be called from any thread.  Every other function performs file I/O and must
+ * only be called from the single thread that appends.
+ */
+struct aws_napi_mqtt5_persistent_queue;
+
+struct aws_napi_mqtt5_persistent_queue_options {
+    /* directory holding the segment files; created if it does not exist */
+    struct aws_byte_cursor directory;
+
+    /* total bytes the log may occupy on disk; appends that would exceed this fail */
+    uint64_t max_size;
+
+    /* a new segment is started once the current one reaches this size */
+    uint64_t segment_size;
+};
+
+struct aws_napi_mqtt5_persistent_queue_statistics {
+    uint64_t pending_count;
+    uint64_t size;
+    uint64_t segment_count;
+};
+
+/*
+ * Invoked once for each recovered, unacknowledged publish, in the order the publishes were originally appended.
+ * The view is only valid for the duration of the call.
+ */
+typedef void(aws_napi_mqtt5_persistent_queue_replay_fn)(
+    uint64_t record_id,
+    const struct aws_mqtt5_packet_publish_view *publish_view,
+    void *user_data);
+
+/* Opens (and recovers) the log stored in options->directory */
+struct aws_napi_mqtt5_persistent_queue *aws_napi_mqtt5_persistent_queue_new(
+    struct aws_allocator *allocator,
+    const struct aws_napi_mqtt5_persistent_queue_options *options);
+
+void aws_napi_mqtt5_persistent_queue_destroy(struct aws_napi_mqtt5_persistent_queue *queue);
+
+/* Durably records a publish and returns the id to acknowledge it with later.  Flushes pending acknowledgements first. */
+int aws_napi_mqtt5_persistent_queue_append(
+    struct aws_napi_mqtt5_persistent_queue *queue,
+    const struct aws_mqtt5_packet_publish_view *publish_view,
+    uint64_t *record_id_out);
+
+/*
+ * Marks a previously appended or recovered publish as complete so it will not be replayed.  Performs no I/O; the
+ * acknowledgement is written by the next flush.
+ */
+int aws_napi_mqtt5_persistent_queue_acknowledge(struct aws_napi_mqtt5_persistent_queue *queue, uint64_t record_id);
+
+/* Writes out acknowledgements made since the last flush and deletes segments that no longer hold pending publishes */
+int aws_napi_mqtt5_persistent_queue_flush(struct aws_napi_mqtt5_persistent_queue *queue);
+
+/*
+ * Hands every publish recovered when the queue was opened to replay_fn.  Recovered publishes are only replayed once;
+ * subsequent calls do nothing.
+ */
+void aws_napi_mqtt5_persistent_queue_replay(
+    struct aws_napi_mqtt5_persistent_queue *queue,
+    aws_napi_mqtt5_persistent_queue_replay_fn *replay_fn,
+    void *user_data);
+
+void aws_napi_mqtt5_persistent_queue_get_statistics(
+    struct aws_napi_mqtt5_persistent_queue *queue,
+    struct aws_napi_mqtt5_persistent_queue_statistics *stats);
+
+#endif /* AWS_CRT_NODEJS_MQTT5_PERSISTENT_QUEUE_H */
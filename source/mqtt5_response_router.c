@@ -0,0 +1,372 @@
+/**
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0.
+ */
+
+#include "mqtt5_response_router.h"
+
+#include "mqtt_message_filter.h"
+
+#include <aws/common/array_list.h>
+#include <aws/common/byte_buf.h>
+#include <aws/common/hash_table.h>
+#include <aws/common/linked_list.h>
+
+struct aws_napi_mqtt5_response_topic_entry;
+struct aws_napi_mqtt5_pending_request;
+
+/* Links a request into the wait list of one of its response topics */
+struct aws_napi_mqtt5_response_route {
+    struct aws_linked_list_node node;
+    struct aws_napi_mqtt5_pending_request *request;
+    struct aws_napi_mqtt5_response_topic_entry *entry;
+};
+
+/* All requests waiting on a single response topic, oldest first */
+struct aws_napi_mqtt5_response_topic_entry {
+    struct aws_byte_buf topic;
+
+    /* hash table key, points into topic */
+    struct aws_byte_cursor topic_cursor;
+
+    /* aws_napi_mqtt5_response_route */
+    struct aws_linked_list routes;
+};
+
+struct aws_napi_mqtt5_pending_request {
+    uint64_t id;
+
+    bool has_correlation_data;
+    struct aws_byte_buf correlation_data;
+
+    size_t route_count;
+    struct aws_napi_mqtt5_response_route *routes;
+};
+
+struct aws_napi_mqtt5_response_router {
+    struct aws_allocator *allocator;
+
+    /* aws_byte_buf, duplicates allowed */
+    struct aws_array_list filters;
+
+    /* uint64_t * -> aws_napi_mqtt5_pending_request * */
+    struct aws_hash_table requests_by_id;
+
+    /* aws_byte_cursor * -> aws_napi_mqtt5_response_topic_entry * */
+    struct aws_hash_table entries_by_topic;
+
+    uint64_t unmatched_count;
+};
+
+static uint64_t s_hash_request_id(const void *item) {
+    return *(const uint64_t *)item;
+}
+
+static bool s_request_id_eq(const void *a, const void *b) {
+    return *(const uint64_t *)a == *(const uint64_t *)b;
+}
+
+static bool s_byte_cursor_ptr_eq(const void *a, const void *b) {
+    return aws_byte_cursor_eq(a, b);
+}
+
+static void s_topic_entry_destroy(struct aws_allocator *allocator, struct aws_napi_mqtt5_response_topic_entry *entry) {
+    aws_byte_buf_clean_up(&entry->topic);
+    aws_mem_release(allocator, entry);
+}
+
+static void s_pending_request_destroy(
+    struct aws_allocator *allocator,
+    struct aws_napi_mqtt5_pending_request *request) {
+
+    aws_byte_buf_clean_up(&request->correlation_data);
+    aws_mem_release(allocator, request->routes);
+    aws_mem_release(allocator, request);
+}
+
+struct aws_napi_mqtt5_response_router *aws_napi_mqtt5_response_router_new(struct aws_allocator *allocator) {
+    struct aws_napi_mqtt5_response_router *router =
+        aws_mem_calloc(allocator, 1, sizeof(struct aws_napi_mqtt5_response_router));
+    router->allocator = allocator;
+
+    if (aws_array_list_init_dynamic(&router->filters, allocator, 4, sizeof(struct aws_byte_buf))) {
+        goto error;
+    }
+
+    if (aws_hash_table_init(
+            &router->requests_by_id, allocator, 16, s_hash_request_id, s_request_id_eq, NULL, NULL)) {
+        goto error;
+    }
+
+    if (aws_hash_table_init(
+            &router->entries_by_topic, allocator, 16, aws_hash_byte_cursor_ptr, s_byte_cursor_ptr_eq, NULL, NULL)) {
+        goto error;
+    }
+
+    return router;
+
+error:
+
+    aws_napi_mqtt5_response_router_destroy(router);
+
+    return NULL;
+}
+
+void aws_napi_mqtt5_response_router_destroy(struct aws_napi_mqtt5_response_router *router) {
+    if (router == NULL) {
+        return;
+    }
+
+    if (aws_hash_table_is_valid(&router->requests_by_id)) {
+        for (struct aws_hash_iter iter = aws_hash_iter_begin(&router->requests_by_id); !aws_hash_iter_done(&iter);
+             aws_hash_iter_next(&iter)) {
+            s_pending_request_destroy(router->allocator, iter.element.value);
+        }
+        aws_hash_table_clean_up(&router->requests_by_id);
+    }
+
+    if (aws_hash_table_is_valid(&router->entries_by_topic)) {
+        for (struct aws_hash_iter iter = aws_hash_iter_begin(&router->entries_by_topic); !aws_hash_iter_done(&iter);
+             aws_hash_iter_next(&iter)) {
+            s_topic_entry_destroy(router->allocator, iter.element.value);
+        }
+        aws_hash_table_clean_up(&router->entries_by_topic);
+    }
+
+    if (aws_array_list_is_valid(&router->filters)) {
+        size_t filter_count = aws_array_list_length(&router->filters);
+        for (size_t i = 0; i < filter_count; ++i) {
+            struct aws_byte_buf *filter = NULL;
+            aws_array_list_get_at_ptr(&router->filters, (void **)&filter, i);
+            aws_byte_buf_clean_up(filter);
+        }
+        aws_array_list_clean_up(&router->filters);
+    }
+
+    aws_mem_release(router->allocator, router);
+}
+
+int aws_napi_mqtt5_response_router_add_filter(
+    struct aws_napi_mqtt5_response_router *router,
+    struct aws_byte_cursor topic_filter) {
+
+    struct aws_byte_buf filter;
+    if (aws_byte_buf_init_copy_from_cursor(&filter, router->allocator, topic_filter)) {
+        return AWS_OP_ERR;
+    }
+
+    if (aws_array_list_push_back(&router->filters, &filter)) {
+        aws_byte_buf_clean_up(&filter);
+        return AWS_OP_ERR;
+    }
+
+    return AWS_OP_SUCCESS;
+}
+
+void aws_napi_mqtt5_response_router_remove_filter(
+    struct aws_napi_mqtt5_response_router *router,
+    struct aws_byte_cursor topic_filter) {
+
+    size_t filter_count = aws_array_list_length(&router->filters);
+    for (size_t i = 0; i < filter_count; ++i) {
+        struct aws_byte_buf *filter = NULL;
+        aws_array_list_get_at_ptr(&router->filters, (void **)&filter, i);
+
+        if (aws_byte_cursor_eq_byte_buf(&topic_filter, filter)) {
+            aws_byte_buf_clean_up(filter);
+
+            /* order doesn't matter, so fill the hole with the last filter */
+            if (i + 1 < filter_count) {
+                aws_array_list_swap(&router->filters, i, filter_count - 1);
+            }
+            aws_array_list_pop_back(&router->filters);
+            return;
+        }
+    }
+}
+
+static void s_remove_route(struct aws_napi_mqtt5_response_router *router, struct aws_napi_mqtt5_response_route *route) {
+    struct aws_napi_mqtt5_response_topic_entry *entry = route->entry;
+    if (entry == NULL) {
+        return;
+    }
+
+    aws_linked_list_remove(&route->node);
+    route->entry = NULL;
+
+    if (aws_linked_list_empty(&entry->routes)) {
+        aws_hash_table_remove(&router->entries_by_topic, &entry->topic_cursor, NULL, NULL);
+        s_topic_entry_destroy(router->allocator, entry);
+    }
+}
+
+/* Unlinks a request from every topic it waits on, and forgets it */
+static void s_remove_pending_request(
+    struct aws_napi_mqtt5_response_router *router,
+    struct aws_napi_mqtt5_pending_request *request) {
+
+    for (size_t i = 0; i < request->route_count; ++i) {
+        s_remove_route(router, &request->routes[i]);
+    }
+
+    aws_hash_table_remove(&router->requests_by_id, &request->id, NULL, NULL);
+    s_pending_request_destroy(router->allocator, request);
+}
+
+static struct aws_napi_mqtt5_response_topic_entry *s_get_or_create_topic_entry(
+    struct aws_napi_mqtt5_response_router *router,
+    struct aws_byte_cursor topic) {
+
+    struct aws_hash_element *element = NULL;
+    aws_hash_table_find(&router->entries_by_topic, &topic, &element);
+    if (element != NULL) {
+        return element->value;
+    }
+
+    struct aws_napi_mqtt5_response_topic_entry *entry =
+        aws_mem_calloc(router->allocator, 1, sizeof(struct aws_napi_mqtt5_response_topic_entry));
+    if (aws_byte_buf_init_copy_from_cursor(&entry->topic, router->allocator, topic)) {
+        aws_mem_release(router->allocator, entry);
+        return NULL;
+    }
+
+    entry->topic_cursor = aws_byte_cursor_from_buf(&entry->topic);
+    aws_linked_list_init(&entry->routes);
+
+    if (aws_hash_table_put(&router->entries_by_topic, &entry->topic_cursor, entry, NULL)) {
+        s_topic_entry_destroy(router->allocator, entry);
+        return NULL;
+    }
+
+    return entry;
+}
+
+int aws_napi_mqtt5_response_router_add_request(
+    struct aws_napi_mqtt5_response_router *router,
+    uint64_t request_id,
+    const struct aws_byte_cursor *response_topics,
+    size_t response_topic_count,
+    const struct aws_byte_cursor *correlation_data) {
+
+    if (response_topic_count == 0) {
+        return aws_raise_error(AWS_ERROR_INVALID_ARGUMENT);
+    }
+
+    struct aws_hash_element *existing = NULL;
+    aws_hash_table_find(&router->requests_by_id, &request_id, &existing);
+    if (existing != NULL) {
+        return aws_raise_error(AWS_ERROR_INVALID_ARGUMENT);
+    }
+
+    struct aws_napi_mqtt5_pending_request *request =
+        aws_mem_calloc(router->allocator, 1, sizeof(struct aws_napi_mqtt5_pending_request));
+    request->id = request_id;
+    request->routes =
+        aws_mem_calloc(router->allocator, response_topic_count, sizeof(struct aws_napi_mqtt5_response_route));
+
+    if (correlation_data != NULL) {
+        request->has_correlation_data = true;
+        if (aws_byte_buf_init_copy_from_cursor(&request->correlation_data, router->allocator, *correlation_data)) {
+            s_pending_request_destroy(router->allocator, request);
+            return AWS_OP_ERR;
+        }
+    }
+
+    if (aws_hash_table_put(&router->requests_by_id, &request->id, request, NULL)) {
+        s_pending_request_destroy(router->allocator, request);
+        return AWS_OP_ERR;
+    }
+
+    for (size_t i = 0; i < response_topic_count; ++i) {
+        struct aws_napi_mqtt5_response_topic_entry *entry = s_get_or_create_topic_entry(router, response_topics[i]);
+        if (entry == NULL) {
+            s_remove_pending_request(router, request);
+            return AWS_OP_ERR;
+        }
+
+        struct aws_napi_mqtt5_response_route *route = &request->routes[request->route_count++];
+        route->request = request;
+        route->entry = entry;
+        aws_linked_list_push_back(&entry->routes, &route->node);
+    }
+
+    return AWS_OP_SUCCESS;
+}
+
+bool aws_napi_mqtt5_response_router_remove_request(struct aws_napi_mqtt5_response_router *router, uint64_t request_id) {
+    struct aws_hash_element *element = NULL;
+    aws_hash_table_find(&router->requests_by_id, &request_id, &element);
+    if (element == NULL) {
+        return false;
+    }
+
+    s_remove_pending_request(router, element->value);
+
+    return true;
+}
+
+static bool s_is_response_topic(struct aws_napi_mqtt5_response_router *router, struct aws_byte_cursor topic) {
+    size_t filter_count = aws_array_list_length(&router->filters);
+    for (size_t i = 0; i < filter_count; ++i) {
+        struct aws_byte_buf *filter = NULL;
+        aws_array_list_get_at_ptr(&router->filters, (void **)&filter, i);
+
+        if (aws_napi_mqtt_topic_matches_filter(topic, aws_byte_cursor_from_buf(filter))) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+enum aws_napi_mqtt5_response_route_result aws_napi_mqtt5_response_router_route(
+    struct aws_napi_mqtt5_response_router *router,
+    struct aws_byte_cursor topic,
+    const struct aws_byte_cursor *correlation_data,
+    uint64_t *request_id_out) {
+
+    if (!s_is_response_topic(router, topic)) {
+        return AWS_NAPI_MQTT5_RRR_NOT_A_RESPONSE;
+    }
+
+    struct aws_hash_element *element = NULL;
+    aws_hash_table_find(&router->entries_by_topic, &topic, &element);
+
+    if (element != NULL) {
+        struct aws_napi_mqtt5_response_topic_entry *entry = element->value;
+
+        /* without correlation data a response is only attributable when a single request waits on its topic */
+        if (correlation_data == NULL &&
+            aws_linked_list_begin(&entry->routes) != aws_linked_list_rbegin(&entry->routes)) {
+            goto unmatched;
+        }
+
+        for (struct aws_linked_list_node *node = aws_linked_list_begin(&entry->routes);
+             node != aws_linked_list_end(&entry->routes);
+             node = aws_linked_list_next(node)) {
+            struct aws_napi_mqtt5_response_route *route =
+                AWS_CONTAINER_OF(node, struct aws_napi_mqtt5_response_route, node);
+            struct aws_napi_mqtt5_pending_request *request = route->request;
+
+            if (correlation_data != NULL && request->has_correlation_data &&
+                !aws_byte_cursor_eq_byte_buf(correlation_data, &request->correlation_data)) {
+                continue;
+            }
+
+            *request_id_out = request->id;
+            s_remove_pending_request(router, request);
+
+            return AWS_NAPI_MQTT5_RRR_MATCHED;
+        }
+    }
+
+unmatched:
+
+    ++router->unmatched_count;
+
+    return AWS_NAPI_MQTT5_RRR_UNMATCHED;
+}
+
+uint64_t aws_napi_mqtt5_response_router_get_unmatched_count(const struct aws_napi_mqtt5_response_router *router) {
+    return router->unmatched_count;
+}
@@ -0,0 +1,68 @@
+/**
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0.
+ */
+
+#ifndef AWS_CRT_NODEJS_MQTT5_RESPONSE_ROUTER_H
+#define AWS_CRT_NODEJS_MQTT5_RESPONSE_ROUTER_H
+
+#include "module.h"
+
+/*
+ * Correlates incoming publishes with outstanding request-response requests.
+ *
+ * Response filters are the long-lived (usually wildcard) subscriptions that responses arrive on.  Each request lists
+ * the exact topics its response may arrive on and, optionally, the correlation data the responder echoes back.  An
+ * incoming publish on a response filter completes the oldest request waiting on its topic whose correlation data
+ * matches; a publish without correlation data completes the request waiting on its topic only if it is the only one
+ * waiting there.  Publishes on a response filter that complete nothing are counted and should be dropped by the
+ * caller.
+ *
+ * Not thread-safe; the caller serializes access.
+ */
+struct aws_napi_mqtt5_response_router;
+
+enum aws_napi_mqtt5_response_route_result {
+    /* the publish does not match any response filter and should be delivered normally */
+    AWS_NAPI_MQTT5_RRR_NOT_A_RESPONSE,
+
+    /* the publish matches a response filter but no outstanding request */
+    AWS_NAPI_MQTT5_RRR_UNMATCHED,
+
+    /* the publish completes a request, which has been removed from the router */
+    AWS_NAPI_MQTT5_RRR_MATCHED,
+};
+
+struct aws_napi_mqtt5_response_router *aws_napi_mqtt5_response_router_new(struct aws_allocator *allocator);
+
+void aws_napi_mqtt5_response_router_destroy(struct aws_napi_mqtt5_response_router *router);
+
+/* Filters may be added more than once; each addition must be balanced by a removal */
+int aws_napi_mqtt5_response_router_add_filter(
+    struct aws_napi_mqtt5_response_router *router,
+    struct aws_byte_cursor topic_filter);
+
+void aws_napi_mqtt5_response_router_remove_filter(
+    struct aws_napi_mqtt5_response_router *router,
+    struct aws_byte_cursor topic_filter);
+
+/* correlation_data may be NULL, in which case the request completes on the first response on any of its topics */
+int aws_napi_mqtt5_response_router_add_request(
+    struct aws_napi_mqtt5_response_router *router,
+    uint64_t request_id,
+    const struct aws_byte_cursor *response_topics,
+    size_t response_topic_count,
+    const struct aws_byte_cursor *correlation_data);
+
+/* Returns true if the request was still outstanding */
+bool aws_napi_mqtt5_response_router_remove_request(struct aws_napi_mqtt5_response_router *router, uint64_t request_id);
+
+enum aws_napi_mqtt5_response_route_result aws_napi_mqtt5_response_router_route(
+    struct aws_napi_mqtt5_response_router *router,
+    struct aws_byte_cursor topic,
+    const struct aws_byte_cursor *correlation_data,
+    uint64_t *request_id_out);
+
+uint64_t aws_napi_mqtt5_response_router_get_unmatched_count(const struct aws_napi_mqtt5_response_router *router);
+
+#endif /* AWS_CRT_NODEJS_MQTT5_RESPONSE_ROUTER_H */
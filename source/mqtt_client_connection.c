@@ -4,7 +4,11 @@
  */
 #include "mqtt_client_connection.h"
 
+#include "auth.h"
+#include "live_statistics.h"
 #include "mqtt_client.h"
+#include "mqtt_message_filter.h"
+#include "mqtt_topic_intern_cache.h"
 
 #include "http_connection.h"
 #include "http_message.h"
@@ -16,13 +20,22 @@
 #include <aws/io/socket.h>
 #include <aws/io/tls_channel_handler.h>
 
+#include <aws/common/atomics.h>
+#include <aws/common/clock.h>
 #include <aws/common/linked_list.h>
 #include <aws/common/mutex.h>
+#include <aws/common/ref_count.h>
 
 static const char *AWS_NAPI_KEY_INCOMPLETE_OPERATION_COUNT = "incompleteOperationCount";
 static const char *AWS_NAPI_KEY_INCOMPLETE_OPERATION_SIZE = "incompleteOperationSize";
 static const char *AWS_NAPI_KEY_UNACKED_OPERATION_COUNT = "unackedOperationCount";
 static const char *AWS_NAPI_KEY_UNACKED_OPERATION_SIZE = "unackedOperationSize";
+static const char *AWS_NAPI_KEY_FILTERED_MESSAGE_COUNT = "filteredMessageCount";
+static const char *AWS_NAPI_KEY_SAMPLED_OUT_MESSAGE_COUNT = "sampledOutMessageCount";
+static const char *AWS_NAPI_KEY_RATE_LIMITED_MESSAGE_COUNT = "rateLimitedMessageCount";
+static const char *AWS_NAPI_KEY_TOPIC = "topic";
+static const char *AWS_NAPI_KEY_QOS = "qos";
+static const char *AWS_NAPI_KEY_HANDLER = "handler";
 
 static void s_transform_websocket_call(napi_env env, napi_value transform_websocket, void *context, void *user_data);
 void s_transform_websocket(
@@ -30,6 +43,11 @@ void s_transform_websocket(
     void *user_data,
     aws_mqtt_transform_websocket_handshake_complete_fn *complete_fn,
     void *complete_ctx);
+static void s_sign_websocket(
+    struct aws_http_message *request,
+    void *user_data,
+    aws_mqtt_transform_websocket_handshake_complete_fn *complete_fn,
+    void *complete_ctx);
 
 struct mqtt_connection_binding {
     struct aws_allocator *allocator;
@@ -44,12 +62,208 @@ struct mqtt_connection_binding {
     napi_threadsafe_function on_connection_resumed;
     napi_threadsafe_function on_any_publish;
     napi_threadsafe_function transform_websocket;
+    /* Signs websocket handshakes on the event loop thread; mutually exclusive with transform_websocket */
+    struct aws_napi_websocket_signer *websocket_signer;
     napi_threadsafe_function on_closed;
     napi_threadsafe_function on_connection_success;
     napi_threadsafe_function on_connection_failure;
     bool first_successfull_connection;
+
+    /*
+     * Optional filtering and sampling of received publishes, evaluated on the event loop thread before anything is
+     * copied for node.  The enabled flag is set while a filter is installed and only gates the lock.  The counters
+     * are reported from the first time a filter is installed, which is only tracked on node's thread.
+     */
+    struct aws_atomic_var is_message_filter_enabled;
+    struct aws_mutex message_filter_lock;
+    struct aws_napi_mqtt_message_filter *message_filter;
+    struct aws_napi_mqtt_message_filter_statistics message_filter_statistics;
+    bool has_message_filter_statistics;
+
+    /*
+     * The filter verdict for the message the client is currently dispatching.  For each message the client calls
+     * every matching subscription's callback and then the any-publish callback, which node always installs; the first
+     * of these evaluates the filter, the rest reuse the verdict, and the any-publish callback forgets it.  Only
+     * touched from the connection's event loop thread.
+     */
+    bool has_dispatched_message_verdict;
+    bool is_dispatched_message_dropped;
+    const uint8_t *dispatched_message_topic;
+    const uint8_t *dispatched_message_payload;
+
+    /* Optional counters written into memory shared with node, bound from node at most once */
+    struct aws_napi_live_statistics live_statistics;
+
+    /*
+     * The message the client is currently dispatching, so that every handler it is delivered to (the on-message
+     * handler and any number of overlapping subscriptions) shares one copy.  Released by the any-publish callback,
+     * the last for each message, once every delivery has been queued.  Only touched from the connection's event loop
+     * thread.
+     */
+    struct mqtt_message_record *last_message_record;
+
+    /* Optional; strings for recently received topics.  Only touched from node's thread, and gone once closed. */
+    struct aws_napi_mqtt_topic_intern_cache *topic_intern_cache;
+
+    /*
+     * Encoding space for string topics and payloads being published, reused so that steady-state publishing does not
+     * allocate.  Only touched from node's thread, and only for the duration of a publish call.
+     */
+    struct aws_byte_buf publish_topic_scratch;
+    struct aws_byte_buf publish_payload_scratch;
+};
+
+/*
+ * A received message, shared between all of its deliveries to node.  Topic and payload live in the same allocation
+ * as the record.  Each queued delivery holds a reference, as does an external ArrayBuffer exposing the payload, so
+ * the record is freed when the last delivery completes or the payload buffer is garbage collected.
+ */
+struct mqtt_message_record {
+    struct aws_allocator *allocator;
+    struct aws_ref_count ref_count;
+
+    struct aws_byte_cursor topic;
+    struct aws_byte_cursor payload;
+    bool dup;
+    enum aws_mqtt_qos qos;
+    bool retain;
+
+    /* where the client's decoder held the message; only ever compared, never dereferenced */
+    const uint8_t *source_topic;
+    const uint8_t *source_payload;
 };
 
+static void s_mqtt_message_record_destroy(void *object) {
+    struct mqtt_message_record *record = object;
+
+    aws_mem_release(record->allocator, record);
+}
+
+static struct mqtt_message_record *s_mqtt_message_record_acquire(struct mqtt_message_record *record) {
+    aws_ref_count_acquire(&record->ref_count);
+
+    return record;
+}
+
+static struct mqtt_message_record *s_mqtt_message_record_release(struct mqtt_message_record *record) {
+    if (record != NULL) {
+        aws_ref_count_release(&record->ref_count);
+    }
+
+    return NULL;
+}
+
+static bool s_mqtt_message_record_matches(
+    const struct mqtt_message_record *record,
+    const struct aws_byte_cursor *topic,
+    const struct aws_byte_cursor *payload,
+    bool dup,
+    enum aws_mqtt_qos qos,
+    bool retain) {
+
+    /*
+     * Every handler for one message sees the same decoded packet, so identical source pointers are the cheap test.
+     * The decoder may reuse the same memory for a later message, so the bytes must also still agree; a later message
+     * that is byte-for-byte identical can safely share the record anyway.
+     */
+    return record->source_topic == topic->ptr && record->source_payload == payload->ptr && record->dup == dup &&
+           record->qos == qos && record->retain == retain && aws_byte_cursor_eq(&record->topic, topic) &&
+           aws_byte_cursor_eq(&record->payload, payload);
+}
+
+/* Returns a new reference to the binding's record of this message, copying it only if it is not the last one seen */
+static struct mqtt_message_record *s_acquire_message_record(
+    struct mqtt_connection_binding *binding,
+    const struct aws_byte_cursor *topic,
+    const struct aws_byte_cursor *payload,
+    bool dup,
+    enum aws_mqtt_qos qos,
+    bool retain) {
+
+    struct mqtt_message_record *record = binding->last_message_record;
+    if (record != NULL && s_mqtt_message_record_matches(record, topic, payload, dup, qos, retain)) {
+        return s_mqtt_message_record_acquire(record);
+    }
+
+    struct aws_allocator *allocator = binding->allocator;
+    record = aws_mem_calloc(allocator, 1, sizeof(struct mqtt_message_record) + topic->len + payload->len);
+    AWS_FATAL_ASSERT(record);
+
+    record->allocator = allocator;
+    aws_ref_count_init(&record->ref_count, record, s_mqtt_message_record_destroy);
+
+    uint8_t *storage = (uint8_t *)(record + 1);
+    if (topic->len > 0) {
+        memcpy(storage, topic->ptr, topic->len);
+    }
+    record->topic = aws_byte_cursor_from_array(storage, topic->len);
+
+    storage += topic->len;
+    if (payload->len > 0) {
+        memcpy(storage, payload->ptr, payload->len);
+    }
+    record->payload = aws_byte_cursor_from_array(storage, payload->len);
+
+    record->dup = dup;
+    record->qos = qos;
+    record->retain = retain;
+    record->source_topic = topic->ptr;
+    record->source_payload = payload->ptr;
+
+    s_mqtt_message_record_release(binding->last_message_record);
+    binding->last_message_record = record;
+
+    return s_mqtt_message_record_acquire(record);
+}
+
+/* Finalizer for a payload ArrayBuffer; the hint is the record it references */
+static void s_message_record_payload_finalizer(napi_env env, void *finalize_data, void *finalize_hint) {
+    (void)env;
+    (void)finalize_data;
+
+    s_mqtt_message_record_release(finalize_hint);
+}
+
+/*
+ * Builds the topic string and payload buffer for one delivery of a message.  Every delivery wraps the record's memory
+ * rather than copying it, so all the handlers of a message share one payload, which they must treat as read-only.
+ */
+static void s_create_message_record_topic_and_payload(
+    napi_env env,
+    struct mqtt_connection_binding *binding,
+    struct mqtt_message_record *record,
+    napi_value *topic_out,
+    napi_value *payload_out) {
+
+    AWS_NAPI_ENSURE(env, aws_napi_mqtt_create_topic_string(env, binding->topic_intern_cache, record->topic, topic_out));
+
+    /* the payload buffer keeps the record alive until node collects it */
+    s_mqtt_message_record_acquire(record);
+    AWS_NAPI_ENSURE(
+        env,
+        aws_napi_create_external_arraybuffer(
+            env,
+            record->payload.ptr,
+            record->payload.len,
+            s_message_record_payload_finalizer,
+            record,
+            payload_out));
+}
+
+/* Builds the (topic, payload, dup, qos, retain) arguments that the any-publish handler receives */
+static void s_create_message_record_params(
+    napi_env env,
+    struct mqtt_connection_binding *binding,
+    struct mqtt_message_record *record,
+    napi_value params[5]) {
+
+    s_create_message_record_topic_and_payload(env, binding, record, &params[0], &params[1]);
+
+    AWS_NAPI_ENSURE(env, napi_get_boolean(env, record->dup, &params[2]));
+    AWS_NAPI_ENSURE(env, napi_create_int32(env, record->qos, &params[3]));
+    AWS_NAPI_ENSURE(env, napi_get_boolean(env, record->retain, &params[4]));
+}
+
 static void s_mqtt_client_connection_release_threadsafe_function_on_failure(struct mqtt_connection_binding *binding) {
 
     if (binding->on_connection_failure != NULL) {
@@ -98,7 +312,6 @@ static void s_mqtt_client_connection_release_threadsafe_function(struct mqtt_con
 
 static void s_mqtt_client_connection_finalize(napi_env env, void *finalize_data, void *finalize_hint) {
     (void)finalize_hint;
-    (void)env;
     struct mqtt_connection_binding *binding = finalize_data;
 
     AWS_LOGF_DEBUG(AWS_LS_NODEJS_CRT_GENERAL, "Destroying binding for connection %p", (void *)binding->connection);
@@ -110,10 +323,30 @@ static void s_mqtt_client_connection_finalize(napi_env env, void *finalize_data,
     if (binding->use_tls_options) {
         aws_tls_connection_options_clean_up(&binding->tls_options);
     }
+
+    /* gauge refreshes read the connection, so stop them first */
+    aws_napi_live_statistics_unbind_napi(&binding->live_statistics, env);
+
     if (binding->connection) {
         aws_mqtt_client_connection_release(binding->connection);
     }
 
+    /* deliveries still queued or payloads still referenced from node hold their own references */
+    s_mqtt_message_record_release(binding->last_message_record);
+
+    /* a handshake still being signed holds its own reference */
+    aws_napi_websocket_signer_release(binding->websocket_signer);
+
+    aws_napi_mqtt_message_filter_destroy(binding->message_filter);
+    aws_mutex_clean_up(&binding->message_filter_lock);
+
+    aws_napi_live_statistics_clean_up(&binding->live_statistics);
+
+    aws_napi_mqtt_topic_intern_cache_destroy(binding->topic_intern_cache);
+
+    aws_byte_buf_clean_up(&binding->publish_topic_scratch);
+    aws_byte_buf_clean_up(&binding->publish_payload_scratch);
+
     aws_mem_release(binding->allocator, binding);
 }
 
@@ -149,6 +382,10 @@ napi_value aws_napi_mqtt_client_connection_close(napi_env env, napi_callback_inf
     s_mqtt_client_connection_release_threadsafe_function_on_failure(binding);
 
     /* no more node interop will be done, free node resources */
+    aws_napi_live_statistics_unbind_napi(&binding->live_statistics, env);
+    aws_napi_mqtt_topic_intern_cache_destroy(binding->topic_intern_cache);
+    binding->topic_intern_cache = NULL;
+
     if (binding->node_external) {
         napi_delete_reference(env, binding->node_external);
         binding->node_external = NULL;
@@ -203,6 +440,8 @@ static void s_on_connection_interrupted(
     (void)connection;
 
     struct mqtt_connection_binding *binding = user_data;
+    aws_napi_live_statistics_add(&binding->live_statistics, AWS_NAPI_LIVE_STAT_CONNECTION_DROPS, 1);
+
     if (!binding->on_connection_interrupted) {
         return;
     }
@@ -315,6 +554,8 @@ static void s_on_connection_success(
 
     struct mqtt_connection_binding *binding = user_data;
     binding->first_successfull_connection = true;
+    aws_napi_live_statistics_record_connection_success(&binding->live_statistics);
+
     if (!binding->on_connection_success) {
         return;
     }
@@ -365,6 +606,8 @@ static void s_on_connection_failure(struct aws_mqtt_client_connection *connectio
     (void)connection;
 
     struct mqtt_connection_binding *binding = user_data;
+    aws_napi_live_statistics_add(&binding->live_statistics, AWS_NAPI_LIVE_STAT_CONNECTION_FAILURES, 1);
+
     if (!binding->on_connection_failure) {
         return;
     }
@@ -381,7 +624,7 @@ napi_value aws_napi_mqtt_client_connection_new(napi_env env, napi_callback_info
 
     struct aws_allocator *allocator = aws_napi_get_allocator();
 
-    napi_value node_args[14];
+    napi_value node_args[16];
     size_t num_args = AWS_ARRAY_SIZE(node_args);
     napi_value *arg = &node_args[0];
     AWS_NAPI_CALL(env, napi_get_cb_info(env, cb_info, &num_args, node_args, NULL, NULL), {
@@ -398,6 +641,11 @@ napi_value aws_napi_mqtt_client_connection_new(napi_env env, napi_callback_info
     binding->env = env;
     binding->allocator = allocator;
     binding->first_successfull_connection = false;
+    aws_atomic_init_int(&binding->is_message_filter_enabled, 0);
+    aws_mutex_init(&binding->message_filter_lock);
+    aws_napi_live_statistics_init(&binding->live_statistics);
+    aws_byte_buf_init(&binding->publish_topic_scratch, allocator, 0);
+    aws_byte_buf_init(&binding->publish_payload_scratch, allocator, 0);
 
     napi_value node_external;
     AWS_NAPI_CALL(env, napi_create_external(env, binding, s_mqtt_client_connection_finalize, NULL, &node_external), {
@@ -614,8 +862,24 @@ napi_value aws_napi_mqtt_client_connection_new(napi_env env, napi_callback_info
     }
 
     napi_value node_transform_websocket = *arg++;
+    napi_value node_websocket_signing_config = *arg++;
     if (use_websocket) {
-        if (!aws_napi_is_null_or_undefined(env, node_transform_websocket)) {
+        if (!aws_napi_is_null_or_undefined(env, node_websocket_signing_config)) {
+            if (!aws_napi_is_null_or_undefined(env, node_transform_websocket)) {
+                napi_throw_type_error(
+                    env, NULL, "websocket_signing_config and websocket_handshake_transform cannot both be set");
+                goto cleanup;
+            }
+
+            binding->websocket_signer =
+                aws_napi_websocket_signer_new_from_napi(allocator, env, node_websocket_signing_config);
+            if (binding->websocket_signer == NULL) {
+                /* error already thrown */
+                goto cleanup;
+            }
+            aws_mqtt_client_connection_use_websockets(
+                binding->connection, s_sign_websocket, binding->websocket_signer, NULL, NULL);
+        } else if (!aws_napi_is_null_or_undefined(env, node_transform_websocket)) {
             AWS_NAPI_CALL(
                 env,
                 aws_napi_create_threadsafe_function(
@@ -678,6 +942,23 @@ napi_value aws_napi_mqtt_client_connection_new(napi_env env, napi_callback_info
         goto cleanup;
     }
 
+    napi_value node_topic_intern_cache_size = *arg++;
+    if (!aws_napi_is_null_or_undefined(env, node_topic_intern_cache_size)) {
+        uint32_t topic_intern_cache_size = 0;
+        AWS_NAPI_CALL(env, napi_get_value_uint32(env, node_topic_intern_cache_size, &topic_intern_cache_size), {
+            napi_throw_type_error(env, NULL, "topic_intern_cache_size must be a Number");
+            goto cleanup;
+        });
+
+        if (topic_intern_cache_size > 0) {
+            binding->topic_intern_cache = aws_napi_mqtt_topic_intern_cache_new(allocator, env, topic_intern_cache_size);
+            if (binding->topic_intern_cache == NULL) {
+                aws_napi_throw_last_error(env);
+                goto cleanup;
+            }
+        }
+    }
+
     /* napi_create_reference() must be the last thing called by this function.
      * Once this succeeds, the external will not be cleaned up automatically */
     AWS_NAPI_CALL(env, napi_create_reference(env, node_external, 1, &binding->node_external), {
@@ -878,6 +1159,17 @@ void s_transform_websocket(
     AWS_NAPI_ENSURE(NULL, aws_napi_queue_threadsafe_function(binding->transform_websocket, args));
 }
 
+static void s_sign_websocket(
+    struct aws_http_message *request,
+    void *user_data,
+    aws_mqtt_transform_websocket_handshake_complete_fn *complete_fn,
+    void *complete_ctx) {
+
+    struct aws_napi_websocket_signer *signer = user_data;
+
+    aws_napi_websocket_signer_sign(signer, request, complete_fn, complete_ctx);
+}
+
 napi_value aws_napi_mqtt_client_connection_connect(napi_env env, napi_callback_info cb_info) {
 
     bool success = false;
@@ -1102,6 +1394,17 @@ on_error:
     return NULL;
 }
 
+/*
+ * Layout of the array a subscription handler receives, and of the array publish_many takes: one (topic, payload,
+ * flags) triple per message, with dup, qos and retain packed into flags.  Must match lib/native/mqtt.ts.
+ */
+enum {
+    AWS_NAPI_MQTT_BATCH_VALUES_PER_MESSAGE = 3,
+    AWS_NAPI_MQTT_BATCH_FLAG_DUP = 1 << 0,
+    AWS_NAPI_MQTT_BATCH_QOS_SHIFT = 1,
+    AWS_NAPI_MQTT_BATCH_FLAG_RETAIN = 1 << 3,
+};
+
 /*******************************************************************************
  * Publish
  ******************************************************************************/
@@ -1110,6 +1413,7 @@ struct puback_args {
     struct mqtt_connection_binding *binding;
     uint16_t packet_id;
     int error_code;
+    uint64_t payload_size;
     napi_threadsafe_function on_puback;
 };
 
@@ -1146,6 +1450,31 @@ static void s_on_publish_complete_call(napi_env env, napi_value on_puback, void
     s_destroy_puback_args(args);
 }
 
+static void s_get_live_operation_statistics(
+    void *user_data,
+    struct aws_napi_live_operation_statistics *operation_statistics) {
+
+    struct mqtt_connection_binding *binding = user_data;
+    if (binding->connection == NULL) {
+        return;
+    }
+
+    struct aws_mqtt_connection_operation_statistics stats;
+    AWS_ZERO_STRUCT(stats);
+    aws_mqtt_client_connection_get_stats(binding->connection, &stats);
+
+    operation_statistics->incomplete_operation_count = stats.incomplete_operation_count;
+    operation_statistics->incomplete_operation_size = stats.incomplete_operation_size;
+    operation_statistics->unacked_operation_count = stats.unacked_operation_count;
+    operation_statistics->unacked_operation_size = stats.unacked_operation_size;
+}
+
+/* Called whenever what the connection has in flight may have changed: publishes, subscribes and unsubscribes */
+static void s_refresh_live_operation_statistics(struct mqtt_connection_binding *binding) {
+    aws_napi_live_statistics_refresh_operation_statistics(
+        &binding->live_statistics, s_get_live_operation_statistics, binding);
+}
+
 static void s_on_publish_complete(
     struct aws_mqtt_client_connection *connection,
     uint16_t packet_id,
@@ -1159,59 +1488,119 @@ static void s_on_publish_complete(
     args->packet_id = packet_id;
     args->error_code = error_code;
 
+    aws_napi_live_statistics_record_publish_complete(&args->binding->live_statistics, error_code, args->payload_size);
+    s_refresh_live_operation_statistics(args->binding);
+
     AWS_NAPI_ENSURE(NULL, aws_napi_queue_threadsafe_function(args->on_puback, args));
 }
 
-napi_value aws_napi_mqtt_client_connection_publish(napi_env env, napi_callback_info info) {
+/*
+ * Publishes without a completion callback normally go out with no per-publish state at all.  A QoS 0 publish has no
+ * outcome beyond being accepted by the connection, so it is counted as sent right away; a QoS 1 or 2 publish can still
+ * fail or time out, so while live statistics are kept it gets a small native completion and is counted once it does.
+ */
+struct untracked_publish_args {
+    struct aws_allocator *allocator;
+    struct mqtt_connection_binding *binding;
+    uint64_t payload_size;
+};
 
-    struct aws_allocator *allocator = aws_napi_get_allocator();
+static void s_on_untracked_publish_complete(
+    struct aws_mqtt_client_connection *connection,
+    uint16_t packet_id,
+    int error_code,
+    void *user_data) {
 
-    struct puback_args *args = aws_mem_calloc(allocator, 1, sizeof(struct puback_args));
-    AWS_FATAL_ASSERT(args);
-    args->allocator = allocator;
+    (void)connection;
+    (void)packet_id;
+
+    struct untracked_publish_args *args = user_data;
+
+    aws_napi_live_statistics_record_publish_complete(&args->binding->live_statistics, error_code, args->payload_size);
+    s_refresh_live_operation_statistics(args->binding);
+
+    aws_mem_release(args->allocator, args);
+}
+
+/* Returns the packet id, or 0 with the error raised if the connection did not accept the publish */
+static uint16_t s_publish_untracked(
+    struct mqtt_connection_binding *binding,
+    const struct aws_byte_cursor *topic,
+    enum aws_mqtt_qos qos,
+    bool retain,
+    const struct aws_byte_cursor *payload) {
+
+    struct untracked_publish_args *args = NULL;
+    if (qos != AWS_MQTT_QOS_AT_MOST_ONCE && aws_napi_live_statistics_is_enabled(&binding->live_statistics)) {
+        struct aws_allocator *allocator = aws_napi_get_allocator();
+        args = aws_mem_calloc(allocator, 1, sizeof(struct untracked_publish_args));
+        AWS_FATAL_ASSERT(args);
+        args->allocator = allocator;
+        args->binding = binding;
+        args->payload_size = payload->len;
+    }
+
+    uint16_t packet_id = aws_mqtt_client_connection_publish(
+        binding->connection, topic, qos, retain, payload, args != NULL ? s_on_untracked_publish_complete : NULL, args);
+    if (packet_id == 0) {
+        if (args != NULL) {
+            aws_mem_release(args->allocator, args);
+        }
+        return 0;
+    }
+
+    if (qos == AWS_MQTT_QOS_AT_MOST_ONCE) {
+        aws_napi_live_statistics_record_publish_complete(&binding->live_statistics, AWS_ERROR_SUCCESS, payload->len);
+    }
+    s_refresh_live_operation_statistics(binding);
+
+    return packet_id;
+}
 
-    struct aws_byte_buf topic_buf;
-    struct aws_byte_buf payload_buf;
-    AWS_ZERO_STRUCT(topic_buf);
-    AWS_ZERO_STRUCT(payload_buf);
+napi_value aws_napi_mqtt_client_connection_publish(napi_env env, napi_callback_info info) {
+
+    struct aws_allocator *allocator = aws_napi_get_allocator();
+    struct mqtt_connection_binding *binding = NULL;
+    struct puback_args *args = NULL;
 
     napi_value node_args[6];
     size_t num_args = AWS_ARRAY_SIZE(node_args);
     napi_value *arg = &node_args[0];
     AWS_NAPI_CALL(env, napi_get_cb_info(env, info, &num_args, node_args, NULL, NULL), {
         napi_throw_error(env, NULL, "Failed to retreive callback information");
-        goto cleanup;
+        return NULL;
     });
     if (num_args != AWS_ARRAY_SIZE(node_args)) {
         napi_throw_error(env, NULL, "mqtt_client_connection_publish needs exactly 6 arguments");
-        goto cleanup;
+        return NULL;
     }
 
     napi_value node_binding = *arg++;
-    struct mqtt_connection_binding *binding = NULL;
     AWS_NAPI_CALL(env, napi_get_value_external(env, node_binding, (void **)&binding), {
         napi_throw_error(env, NULL, "Failed to extract binding from external");
-        goto cleanup;
+        return NULL;
     });
 
-    args->binding = binding;
-
     if (binding->connection == NULL) {
         napi_throw_error(env, NULL, "Connection has been closed and can no longer be used");
-        goto cleanup;
+        return NULL;
     }
 
     napi_value node_topic = *arg++;
-    AWS_NAPI_CALL(env, aws_byte_buf_init_from_napi(&topic_buf, env, node_topic), {
-        napi_throw_type_error(env, NULL, "topic must be a String");
-        goto cleanup;
-    });
+    struct aws_byte_cursor topic_cur;
+    AWS_NAPI_CALL(
+        env, aws_napi_borrow_byte_cursor_from_napi(env, node_topic, &binding->publish_topic_scratch, &topic_cur), {
+            napi_throw_type_error(env, NULL, "topic must be a String");
+            goto cleanup;
+        });
 
     napi_value node_payload = *arg++;
-    AWS_NAPI_CALL(env, aws_byte_buf_init_from_napi(&payload_buf, env, node_payload), {
-        napi_throw_type_error(env, NULL, "payload is invalid type");
-        goto cleanup;
-    });
+    struct aws_byte_cursor payload_cur;
+    AWS_NAPI_CALL(
+        env, aws_napi_borrow_byte_cursor_from_napi(env, node_payload, &binding->publish_payload_scratch, &payload_cur), {
+            napi_throw_type_error(env, NULL, "payload is invalid type");
+            goto cleanup;
+        });
 
     napi_value node_qos = *arg++;
     uint32_t qos_uint = 0;
@@ -1230,6 +1619,12 @@ napi_value aws_napi_mqtt_client_connection_publish(napi_env env, napi_callback_i
 
     napi_value node_on_puback = *arg++;
     if (!aws_napi_is_null_or_undefined(env, node_on_puback)) {
+        args = aws_mem_calloc(allocator, 1, sizeof(struct puback_args));
+        AWS_FATAL_ASSERT(args);
+        args->allocator = allocator;
+        args->binding = binding;
+        args->payload_size = payload_cur.len;
+
         AWS_NAPI_CALL(
             env,
             aws_napi_create_threadsafe_function(
@@ -1242,23 +1637,30 @@ napi_value aws_napi_mqtt_client_connection_publish(napi_env env, napi_callback_i
             { goto cleanup; });
     }
 
-    const struct aws_byte_cursor topic_cur = aws_byte_cursor_from_buf(&topic_buf);
-    const struct aws_byte_cursor payload_cur = aws_byte_cursor_from_buf(&payload_buf);
-    uint16_t pub_id = aws_mqtt_client_connection_publish(
-        binding->connection, &topic_cur, qos, retain, &payload_cur, s_on_publish_complete, args);
+    uint16_t pub_id = 0;
+    if (args != NULL) {
+        pub_id = aws_mqtt_client_connection_publish(
+            binding->connection, &topic_cur, qos, retain, &payload_cur, s_on_publish_complete, args);
+    } else {
+        pub_id = s_publish_untracked(binding, &topic_cur, qos, retain, &payload_cur);
+    }
     if (!pub_id) {
         aws_napi_throw_last_error(env);
         goto cleanup;
     }
 
-    aws_byte_buf_clean_up(&payload_buf);
-    aws_byte_buf_clean_up(&topic_buf);
+    if (args != NULL) {
+        s_refresh_live_operation_statistics(binding);
+    }
+
+    aws_napi_trim_scratch_buf(&binding->publish_topic_scratch);
+    aws_napi_trim_scratch_buf(&binding->publish_payload_scratch);
     return NULL;
 
 cleanup:
 
-    aws_byte_buf_clean_up(&payload_buf);
-    aws_byte_buf_clean_up(&topic_buf);
+    aws_napi_trim_scratch_buf(&binding->publish_topic_scratch);
+    aws_napi_trim_scratch_buf(&binding->publish_payload_scratch);
 
     s_destroy_puback_args(args);
 
@@ -1266,190 +1668,495 @@ cleanup:
 }
 
 /*******************************************************************************
- * Subscribe
+ * Publish Many
  ******************************************************************************/
-struct suback_args {
-    struct aws_allocator *allocator;
-    struct mqtt_connection_binding *binding;
+
+/* The outcome of one message of a publish_many call */
+struct publish_many_result {
+    struct publish_many_args *args;
     uint16_t packet_id;
-    enum aws_mqtt_qos qos;
     int error_code;
-    struct aws_byte_buf topic; /* not confident that we can guarantee a cursor ref will always be valid */
-    napi_threadsafe_function on_suback;
+    uint64_t payload_size;
 };
 
-static void s_destroy_suback_args(struct suback_args *args) {
+/*
+ * One publish_many call.  The results follow the struct in the same allocation, and node hears about all of them at
+ * once when the last message completes.
+ */
+struct publish_many_args {
+    struct aws_allocator *allocator;
+    struct mqtt_connection_binding *binding;
+    napi_threadsafe_function on_complete;
+
+    /* messages still outstanding, plus one held by the submitting call until every message has been handed over */
+    struct aws_atomic_var pending_count;
+
+    size_t message_count;
+    struct publish_many_result *results;
+};
+
+static void s_destroy_publish_many_args(struct publish_many_args *args) {
     if (args == NULL) {
         return;
     }
 
-    AWS_FATAL_ASSERT(args->allocator != NULL);
-
-    aws_byte_buf_clean_up(&args->topic);
-
-    if (args->on_suback != 0) {
-        AWS_FATAL_ASSERT(args->binding != NULL);
-        AWS_NAPI_ENSURE(args->binding->env, aws_napi_release_threadsafe_function(args->on_suback, napi_tsfn_abort));
+    if (args->on_complete != 0) {
+        AWS_NAPI_ENSURE(args->binding->env, aws_napi_release_threadsafe_function(args->on_complete, napi_tsfn_abort));
     }
 
     aws_mem_release(args->allocator, args);
 }
 
-static void s_on_suback_call(napi_env env, napi_value on_suback, void *context, void *user_data) {
+static void s_on_publish_many_complete_call(napi_env env, napi_value on_complete, void *context, void *user_data) {
     (void)context;
-    struct suback_args *args = user_data;
+    struct publish_many_args *args = user_data;
 
     if (env) {
-        napi_value params[4];
+        /* (packet id, error code) for each message, in submission order */
+        napi_value params[1];
         const size_t num_params = AWS_ARRAY_SIZE(params);
 
-        AWS_NAPI_ENSURE(env, napi_create_int32(env, args->packet_id, &params[0]));
-        AWS_NAPI_ENSURE(
-            env, napi_create_string_utf8(env, (const char *)args->topic.buffer, args->topic.len, &params[1]));
-        AWS_NAPI_ENSURE(env, napi_create_int32(env, args->qos, &params[2]));
-        AWS_NAPI_ENSURE(env, napi_create_int32(env, args->error_code, &params[3]));
+        AWS_NAPI_ENSURE(env, napi_create_array_with_length(env, args->message_count * 2, &params[0]));
+        for (size_t i = 0; i < args->message_count; ++i) {
+            const struct publish_many_result *result = &args->results[i];
+
+            napi_value node_packet_id = NULL;
+            napi_value node_error_code = NULL;
+            AWS_NAPI_ENSURE(env, napi_create_uint32(env, result->packet_id, &node_packet_id));
+            AWS_NAPI_ENSURE(env, napi_create_int32(env, result->error_code, &node_error_code));
+            AWS_NAPI_ENSURE(env, napi_set_element(env, params[0], (uint32_t)(i * 2), node_packet_id));
+            AWS_NAPI_ENSURE(env, napi_set_element(env, params[0], (uint32_t)(i * 2 + 1), node_error_code));
+        }
 
         AWS_NAPI_ENSURE(
-            env, aws_napi_dispatch_threadsafe_function(env, args->on_suback, NULL, on_suback, num_params, params));
+            env, aws_napi_dispatch_threadsafe_function(env, args->on_complete, NULL, on_complete, num_params, params));
     }
 
-    s_destroy_suback_args(args);
+    s_destroy_publish_many_args(args);
 }
 
-static void s_on_suback(
+static void s_publish_many_release_pending(struct publish_many_args *args) {
+    if (aws_atomic_fetch_sub(&args->pending_count, 1) == 1) {
+        AWS_NAPI_ENSURE(NULL, aws_napi_queue_threadsafe_function(args->on_complete, args));
+    }
+}
+
+static void s_on_publish_many_message_complete(
     struct aws_mqtt_client_connection *connection,
     uint16_t packet_id,
-    const struct aws_byte_cursor *topic,
-    enum aws_mqtt_qos qos,
     int error_code,
     void *user_data) {
+
     (void)connection;
-    (void)topic;
 
-    struct suback_args *args = user_data;
-    if (args == NULL) {
-        return;
-    }
+    struct publish_many_result *result = user_data;
+    struct publish_many_args *args = result->args;
 
-    if (!args->on_suback) {
-        s_destroy_suback_args(args);
-        return;
-    }
+    result->packet_id = packet_id;
+    result->error_code = error_code;
 
-    args->error_code = error_code;
-    args->qos = qos;
-    args->packet_id = packet_id;
+    aws_napi_live_statistics_record_publish_complete(&args->binding->live_statistics, error_code, result->payload_size);
+    s_refresh_live_operation_statistics(args->binding);
 
-    AWS_NAPI_ENSURE(args->binding->env, aws_napi_queue_threadsafe_function(args->on_suback, args));
+    s_publish_many_release_pending(args);
 }
 
-/* user data which describes a subscription, passed to aws_mqtt_connection_subscribe */
-struct subscription {
-    struct aws_allocator *allocator;
-    struct aws_byte_buf topic; /* stored here as long as the sub is active, referenced by callbacks */
-    napi_threadsafe_function on_publish;
-};
+napi_value aws_napi_mqtt_client_connection_publish_many(napi_env env, napi_callback_info info) {
 
-static void s_destroy_subscription(struct subscription *sub) {
-    if (sub == NULL) {
-        return;
+    struct aws_allocator *allocator = aws_napi_get_allocator();
+
+    napi_value node_args[3];
+    size_t num_args = AWS_ARRAY_SIZE(node_args);
+    napi_value *arg = &node_args[0];
+    AWS_NAPI_CALL(env, napi_get_cb_info(env, info, &num_args, node_args, NULL, NULL), {
+        napi_throw_error(env, NULL, "Failed to retreive callback information");
+        return NULL;
+    });
+    if (num_args != AWS_ARRAY_SIZE(node_args)) {
+        napi_throw_error(env, NULL, "mqtt_client_connection_publish_many needs exactly 3 arguments");
+        return NULL;
     }
 
-    AWS_FATAL_ASSERT(sub->allocator != NULL);
+    napi_value node_binding = *arg++;
+    struct mqtt_connection_binding *binding = NULL;
+    AWS_NAPI_CALL(env, napi_get_value_external(env, node_binding, (void **)&binding), {
+        napi_throw_error(env, NULL, "Failed to extract binding from external");
+        return NULL;
+    });
 
-    if (sub->on_publish != 0) {
-        AWS_NAPI_ENSURE(NULL, aws_napi_release_threadsafe_function(sub->on_publish, napi_tsfn_release));
+    if (binding->connection == NULL) {
+        napi_throw_error(env, NULL, "Connection has been closed and can no longer be used");
+        return NULL;
     }
 
-    aws_byte_buf_clean_up(&sub->topic);
-    aws_mem_release(sub->allocator, sub);
-}
+    /* Same (topic, payload, flags) layout as the batches delivered to subscription handlers */
+    napi_value node_messages = *arg++;
+    bool is_array = false;
+    AWS_NAPI_CALL(env, napi_is_array(env, node_messages, &is_array), {
+        napi_throw_error(env, NULL, "Failed to check if messages is an array");
+        return NULL;
+    });
+    if (!is_array) {
+        napi_throw_type_error(env, NULL, "messages must be an array");
+        return NULL;
+    }
 
-static void s_on_publish_user_data_clean_up(void *user_data) {
-    s_destroy_subscription(user_data);
+    uint32_t value_count = 0;
+    AWS_NAPI_CALL(env, napi_get_array_length(env, node_messages, &value_count), {
+        napi_throw_error(env, NULL, "Failed to get the length of messages");
+        return NULL;
+    });
+    if (value_count % AWS_NAPI_MQTT_BATCH_VALUES_PER_MESSAGE != 0) {
+        napi_throw_range_error(env, NULL, "messages must hold a (topic, payload, flags) triple per message");
+        return NULL;
+    }
+    const size_t message_count = value_count / AWS_NAPI_MQTT_BATCH_VALUES_PER_MESSAGE;
+
+    struct publish_many_args *args = NULL;
+    napi_value node_on_complete = *arg++;
+    if (!aws_napi_is_null_or_undefined(env, node_on_complete)) {
+        args = aws_mem_calloc(
+            allocator, 1, sizeof(struct publish_many_args) + message_count * sizeof(struct publish_many_result));
+        AWS_FATAL_ASSERT(args);
+        args->allocator = allocator;
+        args->binding = binding;
+        args->message_count = message_count;
+        args->results = (struct publish_many_result *)(args + 1);
+        aws_atomic_init_int(&args->pending_count, message_count + 1);
+
+        AWS_NAPI_CALL(
+            env,
+            aws_napi_create_threadsafe_function(
+                env,
+                node_on_complete,
+                "aws_mqtt_client_connection_on_publish_many_complete",
+                s_on_publish_many_complete_call,
+                binding,
+                &args->on_complete),
+            {
+                s_destroy_publish_many_args(args);
+                return NULL;
+            });
+    }
+
+    /*
+     * A message that cannot be submitted fails on its own rather than failing the whole call, since the messages
+     * before it are already on their way.
+     */
+    for (size_t i = 0; i < message_count; ++i) {
+        struct publish_many_result *result = args != NULL ? &args->results[i] : NULL;
+        if (result != NULL) {
+            result->args = args;
+        }
+
+        napi_value node_topic = NULL;
+        napi_value node_payload = NULL;
+        napi_value node_flags = NULL;
+        uint32_t flags = 0;
+        struct aws_byte_cursor topic_cur;
+        struct aws_byte_cursor payload_cur;
+        const uint32_t base = (uint32_t)(i * AWS_NAPI_MQTT_BATCH_VALUES_PER_MESSAGE);
+
+        if (napi_get_element(env, node_messages, base, &node_topic) != napi_ok ||
+            napi_get_element(env, node_messages, base + 1, &node_payload) != napi_ok ||
+            napi_get_element(env, node_messages, base + 2, &node_flags) != napi_ok ||
+            napi_get_value_uint32(env, node_flags, &flags) != napi_ok ||
+            aws_napi_borrow_byte_cursor_from_napi(env, node_topic, &binding->publish_topic_scratch, &topic_cur) !=
+                napi_ok ||
+            aws_napi_borrow_byte_cursor_from_napi(
+                env, node_payload, &binding->publish_payload_scratch, &payload_cur) != napi_ok) {
+            aws_raise_error(AWS_ERROR_INVALID_ARGUMENT);
+            goto message_failed;
+        }
+
+        enum aws_mqtt_qos qos = (enum aws_mqtt_qos)((flags >> AWS_NAPI_MQTT_BATCH_QOS_SHIFT) & 0x03);
+        if (qos > AWS_MQTT_QOS_EXACTLY_ONCE) {
+            aws_raise_error(AWS_ERROR_INVALID_ARGUMENT);
+            goto message_failed;
+        }
+        bool retain = (flags & AWS_NAPI_MQTT_BATCH_FLAG_RETAIN) != 0;
+
+        if (result != NULL) {
+            result->payload_size = payload_cur.len;
+        }
+
+        uint16_t packet_id = 0;
+        if (result != NULL) {
+            packet_id = aws_mqtt_client_connection_publish(
+                binding->connection, &topic_cur, qos, retain, &payload_cur, s_on_publish_many_message_complete, result);
+        } else {
+            packet_id = s_publish_untracked(binding, &topic_cur, qos, retain, &payload_cur);
+        }
+        if (packet_id == 0) {
+            goto message_failed;
+        }
+        continue;
+
+    message_failed:
+        if (result != NULL) {
+            result->error_code = aws_last_error();
+            s_publish_many_release_pending(args);
+        }
+    }
+
+    aws_napi_trim_scratch_buf(&binding->publish_topic_scratch);
+    aws_napi_trim_scratch_buf(&binding->publish_payload_scratch);
+
+    if (args != NULL) {
+        s_refresh_live_operation_statistics(binding);
+
+        s_publish_many_release_pending(args);
+    }
+
+    return NULL;
 }
 
-/* arguments for publish callbacks */
-struct on_publish_args {
+/*******************************************************************************
+ * Subscribe
+ ******************************************************************************/
+struct suback_args {
     struct aws_allocator *allocator;
-    struct aws_byte_buf topic;    /* owned by this */
-    struct aws_byte_buf *payload; /* owned by this until the external array buffer in the direct callback is created */
-    bool dup;
+    struct mqtt_connection_binding *binding;
+    uint16_t packet_id;
     enum aws_mqtt_qos qos;
-    bool retain;
-    /* created by subscription, but we add/dec ref on our copy of the pointer too */
-    napi_threadsafe_function on_publish;
+    int error_code;
+    struct aws_byte_buf topic; /* not confident that we can guarantee a cursor ref will always be valid */
+    napi_threadsafe_function on_suback;
 };
 
-static void s_destroy_on_publish_args(struct on_publish_args *args) {
+static void s_destroy_suback_args(struct suback_args *args) {
     if (args == NULL) {
         return;
     }
 
     AWS_FATAL_ASSERT(args->allocator != NULL);
 
-    if (args->on_publish != NULL) {
-        AWS_NAPI_ENSURE(NULL, aws_napi_release_threadsafe_function(args->on_publish, napi_tsfn_release));
+    aws_byte_buf_clean_up(&args->topic);
+
+    if (args->on_suback != 0) {
+        AWS_FATAL_ASSERT(args->binding != NULL);
+        AWS_NAPI_ENSURE(args->binding->env, aws_napi_release_threadsafe_function(args->on_suback, napi_tsfn_abort));
     }
 
-    if (args->payload != NULL) {
-        aws_byte_buf_clean_up(args->payload);
-        aws_mem_release(args->allocator, args->payload);
+    aws_mem_release(args->allocator, args);
+}
+
+static void s_on_suback_call(napi_env env, napi_value on_suback, void *context, void *user_data) {
+    (void)context;
+    struct suback_args *args = user_data;
+
+    if (env) {
+        napi_value params[4];
+        const size_t num_params = AWS_ARRAY_SIZE(params);
+
+        AWS_NAPI_ENSURE(env, napi_create_int32(env, args->packet_id, &params[0]));
+        AWS_NAPI_ENSURE(
+            env, napi_create_string_utf8(env, (const char *)args->topic.buffer, args->topic.len, &params[1]));
+        AWS_NAPI_ENSURE(env, napi_create_int32(env, args->qos, &params[2]));
+        AWS_NAPI_ENSURE(env, napi_create_int32(env, args->error_code, &params[3]));
+
+        AWS_NAPI_ENSURE(
+            env, aws_napi_dispatch_threadsafe_function(env, args->on_suback, NULL, on_suback, num_params, params));
     }
 
-    aws_byte_buf_clean_up(&args->topic);
+    s_destroy_suback_args(args);
+}
 
-    aws_mem_release(args->allocator, args);
+static void s_on_suback(
+    struct aws_mqtt_client_connection *connection,
+    uint16_t packet_id,
+    const struct aws_byte_cursor *topic,
+    enum aws_mqtt_qos qos,
+    int error_code,
+    void *user_data) {
+    (void)connection;
+    (void)topic;
+
+    struct suback_args *args = user_data;
+    if (args == NULL) {
+        return;
+    }
+
+    s_refresh_live_operation_statistics(args->binding);
+
+    if (!args->on_suback) {
+        s_destroy_suback_args(args);
+        return;
+    }
+
+    args->error_code = error_code;
+    args->qos = qos;
+    args->packet_id = packet_id;
+
+    AWS_NAPI_ENSURE(args->binding->env, aws_napi_queue_threadsafe_function(args->on_suback, args));
 }
 
-static void s_publish_external_arraybuffer_finalizer(napi_env env, void *finalize_data, void *finalize_hint) {
-    (void)env;
-    (void)finalize_data;
-    struct aws_byte_buf *buf = finalize_hint;
+/*
+ * user data which describes a subscription, passed to aws_mqtt_connection_subscribe.
+ *
+ * Messages for a subscription are delivered to node in batches: the event loop thread appends to pending_messages
+ * and only queues a call into node when the list was empty, and node's thread takes everything pending at once and
+ * hands it to the handler in a single call.  Each queued call holds a reference, so the subscription outlives
+ * an unsubscribe that races with delivery.
+ */
+struct subscription {
+    struct aws_allocator *allocator;
+    struct aws_ref_count ref_count;
+    struct aws_byte_buf topic; /* stored here as long as the sub is active, referenced by callbacks */
+    napi_threadsafe_function on_publish;
+
+    struct aws_mutex lock;
+    /* struct mqtt_message_record *, protected by lock */
+    struct aws_array_list pending_messages;
+    bool is_delivery_queued;
+
+    /* struct mqtt_message_record *, only touched from node's thread; swapped with pending_messages when delivering */
+    struct aws_array_list delivering_messages;
+};
+
+static void s_release_message_records(struct aws_array_list *records) {
+    const size_t record_count = aws_array_list_length(records);
+    for (size_t i = 0; i < record_count; ++i) {
+        struct mqtt_message_record *record = NULL;
+        aws_array_list_get_at(records, &record, i);
+        s_mqtt_message_record_release(record);
+    }
+    aws_array_list_clear(records);
+}
+
+static void s_destroy_subscription(void *object) {
+    struct subscription *sub = object;
+
+    AWS_FATAL_ASSERT(sub->allocator != NULL);
+
+    if (sub->on_publish != 0) {
+        AWS_NAPI_ENSURE(NULL, aws_napi_release_threadsafe_function(sub->on_publish, napi_tsfn_release));
+    }
+
+    s_release_message_records(&sub->pending_messages);
+    aws_array_list_clean_up(&sub->pending_messages);
+    s_release_message_records(&sub->delivering_messages);
+    aws_array_list_clean_up(&sub->delivering_messages);
+    aws_mutex_clean_up(&sub->lock);
+
+    aws_byte_buf_clean_up(&sub->topic);
+    aws_mem_release(sub->allocator, sub);
+}
+
+static struct subscription *s_subscription_new(struct aws_allocator *allocator) {
+    struct subscription *sub = aws_mem_calloc(allocator, 1, sizeof(struct subscription));
+    AWS_FATAL_ASSERT(sub);
+
+    sub->allocator = allocator;
+    aws_ref_count_init(&sub->ref_count, sub, s_destroy_subscription);
+    aws_mutex_init(&sub->lock);
+    aws_array_list_init_dynamic(&sub->pending_messages, allocator, 8, sizeof(struct mqtt_message_record *));
+    aws_array_list_init_dynamic(&sub->delivering_messages, allocator, 8, sizeof(struct mqtt_message_record *));
+
+    return sub;
+}
+
+static struct subscription *s_subscription_release(struct subscription *sub) {
+    if (sub != NULL) {
+        aws_ref_count_release(&sub->ref_count);
+    }
 
-    struct aws_allocator *allocator = buf->allocator;
-    AWS_FATAL_ASSERT(allocator != NULL);
+    return NULL;
+}
 
-    aws_byte_buf_clean_up(buf);
-    aws_mem_release(allocator, buf);
+static void s_on_publish_user_data_clean_up(void *user_data) {
+    s_subscription_release(user_data);
 }
 
 static void s_on_publish_call(napi_env env, napi_value on_publish, void *context, void *user_data) {
-    (void)context;
-    struct on_publish_args *args = user_data;
+    struct mqtt_connection_binding *binding = context;
+    struct subscription *sub = user_data;
 
-    if (env) {
-        napi_value params[5];
-        const size_t num_params = AWS_ARRAY_SIZE(params);
+    /* take everything that arrived since the last delivery; new messages will queue another call */
+    aws_mutex_lock(&sub->lock);
+    aws_array_list_swap_contents(&sub->pending_messages, &sub->delivering_messages);
+    sub->is_delivery_queued = false;
+    aws_mutex_unlock(&sub->lock);
 
-        AWS_NAPI_ENSURE(
-            env, napi_create_string_utf8(env, (const char *)args->topic.buffer, args->topic.len, &params[0]));
+    if (env) {
+        const size_t message_count = aws_array_list_length(&sub->delivering_messages);
 
+        napi_value batch = NULL;
         AWS_NAPI_ENSURE(
             env,
-            aws_napi_create_external_arraybuffer(
-                env,
-                args->payload->buffer,
-                args->payload->len,
-                s_publish_external_arraybuffer_finalizer,
-                args->payload,
-                &params[1]));
+            napi_create_array_with_length(env, message_count * AWS_NAPI_MQTT_BATCH_VALUES_PER_MESSAGE, &batch));
 
-        AWS_NAPI_ENSURE(env, napi_get_boolean(env, args->dup, &params[2]));
-        AWS_NAPI_ENSURE(env, napi_create_int32(env, args->qos, &params[3]));
-        AWS_NAPI_ENSURE(env, napi_get_boolean(env, args->retain, &params[4]));
+        uint32_t index = 0;
+        for (size_t i = 0; i < message_count; ++i) {
+            struct mqtt_message_record *record = NULL;
+            aws_array_list_get_at(&sub->delivering_messages, &record, i);
 
-        /*
-         * We've successfully created the external array buffer whose finalizer will clean this byte_buf up.
-         * It's now safe and correct to set this to NULL in the args so that the args destructor does not clean it up.
-         */
-        args->payload = NULL;
+            napi_value node_topic = NULL;
+            napi_value node_payload = NULL;
+            s_create_message_record_topic_and_payload(env, binding, record, &node_topic, &node_payload);
 
-        AWS_NAPI_ENSURE(
-            env, aws_napi_dispatch_threadsafe_function(env, args->on_publish, NULL, on_publish, num_params, params));
+            uint32_t flags = ((uint32_t)record->qos << AWS_NAPI_MQTT_BATCH_QOS_SHIFT);
+            if (record->dup) {
+                flags |= AWS_NAPI_MQTT_BATCH_FLAG_DUP;
+            }
+            if (record->retain) {
+                flags |= AWS_NAPI_MQTT_BATCH_FLAG_RETAIN;
+            }
+
+            napi_value node_flags = NULL;
+            AWS_NAPI_ENSURE(env, napi_create_uint32(env, flags, &node_flags));
+
+            AWS_NAPI_ENSURE(env, napi_set_element(env, batch, index++, node_topic));
+            AWS_NAPI_ENSURE(env, napi_set_element(env, batch, index++, node_payload));
+            AWS_NAPI_ENSURE(env, napi_set_element(env, batch, index++, node_flags));
+        }
+
+        AWS_NAPI_ENSURE(env, aws_napi_dispatch_threadsafe_function(env, sub->on_publish, NULL, on_publish, 1, &batch));
+    }
+
+    /* any payload buffers created above hold their own references */
+    s_release_message_records(&sub->delivering_messages);
+
+    s_subscription_release(sub);
+}
+
+/*
+ * Returns true if the installed message filter, if any, drops the message.  Evaluated (and counted) once per message,
+ * by whichever of its callbacks comes first.
+ */
+static bool s_filter_publish(
+    struct mqtt_connection_binding *binding,
+    const struct aws_byte_cursor *topic,
+    const struct aws_byte_cursor *payload,
+    bool retain) {
+
+    if (aws_atomic_load_int(&binding->is_message_filter_enabled) == 0) {
+        return false;
     }
 
-    s_destroy_on_publish_args(args);
+    if (binding->has_dispatched_message_verdict && binding->dispatched_message_topic == topic->ptr &&
+        binding->dispatched_message_payload == payload->ptr) {
+        return binding->is_dispatched_message_dropped;
+    }
+
+    uint64_t now_ns = 0;
+    aws_high_res_clock_get_ticks(&now_ns);
+
+    enum aws_napi_mqtt_message_filter_result result = AWS_NAPI_MQTT_MFR_DELIVER;
+
+    aws_mutex_lock(&binding->message_filter_lock);
+    if (binding->message_filter != NULL) {
+        result = aws_napi_mqtt_message_filter_evaluate(binding->message_filter, *topic, retain, NULL, 0, now_ns);
+        aws_napi_mqtt_message_filter_statistics_record(&binding->message_filter_statistics, result);
+    }
+    aws_mutex_unlock(&binding->message_filter_lock);
+
+    binding->has_dispatched_message_verdict = true;
+    binding->is_dispatched_message_dropped = result != AWS_NAPI_MQTT_MFR_DELIVER;
+    binding->dispatched_message_topic = topic->ptr;
+    binding->dispatched_message_payload = payload->ptr;
+
+    return binding->is_dispatched_message_dropped;
 }
 
 /* called in response to a message being published to an active subscription */
@@ -1473,52 +2180,29 @@ static void s_on_publish(
     struct mqtt_connection_binding *binding = NULL;
     AWS_NAPI_ENSURE(NULL, napi_get_threadsafe_function_context(sub->on_publish, (void **)&binding));
 
-    struct aws_allocator *allocator = binding->allocator;
-    struct on_publish_args *args = aws_mem_calloc(allocator, 1, sizeof(struct on_publish_args));
-    AWS_FATAL_ASSERT(args);
-
-    args->allocator = allocator;
-    args->dup = dup;
-    args->qos = qos;
-    args->retain = retain;
-    args->on_publish = sub->on_publish;
-
-    /*
-     * We share this threadsafe function with the subscription structure.  Each applies a inc/dec ref because
-     * it isn't clear that we can guarantee the order of destruction because we don't really have any
-     * guarantees about V8's internal scheduling/ordering invariants for queued functions.
-     */
-    if (args->on_publish != 0) {
-        AWS_NAPI_ENSURE(NULL, aws_napi_acquire_threadsafe_function(args->on_publish));
+    if (s_filter_publish(binding, topic, payload, retain)) {
+        return;
     }
 
-    if (aws_byte_buf_init_copy_from_cursor(&args->topic, allocator, *topic)) {
-        AWS_LOGF_ERROR(AWS_LS_NODEJS_CRT_GENERAL, "Failed to copy MQTT topic, message will not be delivered");
-        goto on_error;
-    }
+    /* shared with the on-message handler and any other subscriptions matching the same message */
+    struct mqtt_message_record *record = s_acquire_message_record(binding, topic, payload, dup, qos, retain);
 
-    /*
-     * Create the payload as a pointer-to-buf so cleanup responsibilities can be transferred to the payload's
-     * finalizer.
-     */
-    args->payload = aws_mem_calloc(allocator, 1, sizeof(struct aws_byte_buf));
-    if (args->payload == NULL) {
-        goto on_error;
-    }
+    bool should_queue_delivery = false;
 
-    /* this is freed after being delivered to node in s_on_publish_call */
-    if (aws_byte_buf_init_copy_from_cursor(args->payload, allocator, *payload)) {
-        AWS_LOGF_ERROR(AWS_LS_NODEJS_CRT_GENERAL, "Failed to copy MQTT payload buffer, message will not be delivered");
-        goto on_error;
+    aws_mutex_lock(&sub->lock);
+    if (aws_array_list_push_back(&sub->pending_messages, &record)) {
+        AWS_LOGF_ERROR(AWS_LS_NODEJS_CRT_GENERAL, "Failed to queue MQTT message, message will not be delivered");
+        s_mqtt_message_record_release(record);
+    } else if (!sub->is_delivery_queued) {
+        sub->is_delivery_queued = true;
+        should_queue_delivery = true;
     }
+    aws_mutex_unlock(&sub->lock);
 
-    AWS_NAPI_ENSURE(NULL, aws_napi_queue_threadsafe_function(args->on_publish, args));
-
-    return;
-
-on_error:
-
-    s_destroy_on_publish_args(args);
+    if (should_queue_delivery) {
+        aws_ref_count_acquire(&sub->ref_count);
+        AWS_NAPI_ENSURE(NULL, aws_napi_queue_threadsafe_function(sub->on_publish, sub));
+    }
 }
 
 napi_value aws_napi_mqtt_client_connection_subscribe(napi_env env, napi_callback_info cb_info) {
@@ -1544,9 +2228,7 @@ napi_value aws_napi_mqtt_client_connection_subscribe(napi_env env, napi_callback
 
     struct aws_allocator *allocator = binding->allocator;
     struct suback_args *suback = NULL;
-    struct subscription *sub = aws_mem_calloc(allocator, 1, sizeof(struct subscription));
-    AWS_FATAL_ASSERT(sub);
-    sub->allocator = allocator;
+    struct subscription *sub = s_subscription_new(allocator);
 
     if (binding->connection == NULL) {
         napi_throw_error(env, NULL, "Connection has been closed and can no longer be used");
@@ -1609,58 +2291,330 @@ napi_value aws_napi_mqtt_client_connection_subscribe(napi_env env, napi_callback
         goto cleanup;
     }
 
+    s_refresh_live_operation_statistics(binding);
+
     return NULL;
 
 cleanup:
 
-    s_destroy_subscription(sub);
+    s_subscription_release(sub);
     s_destroy_suback_args(suback);
 
     return NULL;
 }
 
-/*
- * on-any publish
- */
-struct on_any_publish_args {
+/*******************************************************************************
+ * Subscribe Multiple
+ ******************************************************************************/
+
+/* The outcome of one topic filter of a multi-topic SUBSCRIBE */
+struct subscribe_multiple_result {
+    struct aws_byte_buf topic;
+    enum aws_mqtt_qos qos; /* AWS_MQTT_QOS_FAILURE if the server rejected this topic filter */
+};
+
+struct multi_suback_args {
     struct aws_allocator *allocator;
-    struct aws_string *topic;
-    struct aws_byte_buf *payload;
-    bool dup;
-    enum aws_mqtt_qos qos;
-    bool retain;
+    struct mqtt_connection_binding *binding;
+    uint16_t packet_id;
+    int error_code;
+    struct aws_array_list results; /* struct subscribe_multiple_result */
+    napi_threadsafe_function on_suback;
 };
 
-static void s_destroy_on_any_publish_args(struct on_any_publish_args *args) {
+static void s_destroy_multi_suback_args(struct multi_suback_args *args) {
     if (args == NULL) {
         return;
     }
 
-    aws_string_destroy(args->topic);
+    AWS_FATAL_ASSERT(args->allocator != NULL);
 
-    /*
-     * Between payload construction and transfer to the external array the only failure options are fatal, but
-     * as a pattern I believe it to be better (future-proofing, consistency) to properly handle the possibility
-     * of the payload getting created but not transferred to the external array's finalizer
-     */
-    if (args->payload) {
-        aws_byte_buf_clean_up(args->payload);
-        aws_mem_release(args->allocator, args->payload);
+    const size_t result_count = aws_array_list_length(&args->results);
+    for (size_t i = 0; i < result_count; ++i) {
+        struct subscribe_multiple_result *result = NULL;
+        aws_array_list_get_at_ptr(&args->results, (void **)&result, i);
+        aws_byte_buf_clean_up(&result->topic);
+    }
+    aws_array_list_clean_up(&args->results);
+
+    if (args->on_suback != 0) {
+        AWS_FATAL_ASSERT(args->binding != NULL);
+        AWS_NAPI_ENSURE(args->binding->env, aws_napi_release_threadsafe_function(args->on_suback, napi_tsfn_abort));
     }
 
     aws_mem_release(args->allocator, args);
 }
 
-static void s_any_publish_external_arraybuffer_finalizer(napi_env env, void *finalize_data, void *finalize_hint) {
-    (void)env;
-    (void)finalize_data;
+static void s_on_multi_suback_call(napi_env env, napi_value on_suback, void *context, void *user_data) {
+    (void)context;
+    struct multi_suback_args *args = user_data;
+
+    if (env) {
+        napi_value params[3];
+        const size_t num_params = AWS_ARRAY_SIZE(params);
+
+        AWS_NAPI_ENSURE(env, napi_create_int32(env, args->packet_id, &params[0]));
+
+        const size_t result_count = aws_array_list_length(&args->results);
+        AWS_NAPI_ENSURE(env, napi_create_array_with_length(env, result_count, &params[1]));
+        for (size_t i = 0; i < result_count; ++i) {
+            struct subscribe_multiple_result *result = NULL;
+            aws_array_list_get_at_ptr(&args->results, (void **)&result, i);
+
+            napi_value node_result = NULL;
+            AWS_NAPI_ENSURE(env, napi_create_object(env, &node_result));
+            AWS_FATAL_ASSERT(
+                aws_napi_attach_object_property_string(
+                    node_result, env, AWS_NAPI_KEY_TOPIC, aws_byte_cursor_from_buf(&result->topic)) ==
+                AWS_OP_SUCCESS);
+            AWS_FATAL_ASSERT(
+                aws_napi_attach_object_property_u32(node_result, env, AWS_NAPI_KEY_QOS, (uint32_t)result->qos) ==
+                AWS_OP_SUCCESS);
+
+            AWS_NAPI_ENSURE(env, napi_set_element(env, params[1], (uint32_t)i, node_result));
+        }
+
+        AWS_NAPI_ENSURE(env, napi_create_int32(env, args->error_code, &params[2]));
+
+        AWS_NAPI_ENSURE(
+            env, aws_napi_dispatch_threadsafe_function(env, args->on_suback, NULL, on_suback, num_params, params));
+    }
+
+    s_destroy_multi_suback_args(args);
+}
+
+static void s_on_multi_suback(
+    struct aws_mqtt_client_connection *connection,
+    uint16_t packet_id,
+    const struct aws_array_list *topic_subacks,
+    int error_code,
+    void *user_data) {
+    (void)connection;
+
+    struct multi_suback_args *args = user_data;
+    if (args == NULL) {
+        return;
+    }
+
+    s_refresh_live_operation_statistics(args->binding);
+
+    if (!args->on_suback) {
+        s_destroy_multi_suback_args(args);
+        return;
+    }
+
+    args->error_code = error_code;
+    args->packet_id = packet_id;
+
+    /* struct aws_mqtt_topic_subscription *, with the granted qos */
+    const size_t suback_count = topic_subacks != NULL ? aws_array_list_length(topic_subacks) : 0;
+    for (size_t i = 0; i < suback_count; ++i) {
+        struct aws_mqtt_topic_subscription *suback = NULL;
+        aws_array_list_get_at(topic_subacks, &suback, i);
+
+        struct subscribe_multiple_result result;
+        AWS_ZERO_STRUCT(result);
+        result.qos = suback->qos;
+        if (aws_byte_buf_init_copy_from_cursor(&result.topic, args->allocator, suback->topic) ||
+            aws_array_list_push_back(&args->results, &result)) {
+            aws_byte_buf_clean_up(&result.topic);
+            if (args->error_code == AWS_ERROR_SUCCESS) {
+                args->error_code = aws_last_error();
+            }
+            break;
+        }
+    }
+
+    AWS_NAPI_ENSURE(args->binding->env, aws_napi_queue_threadsafe_function(args->on_suback, args));
+}
+
+napi_value aws_napi_mqtt_client_connection_subscribe_multiple(napi_env env, napi_callback_info cb_info) {
+
+    napi_value node_args[3];
+    size_t num_args = AWS_ARRAY_SIZE(node_args);
+    napi_value *arg = &node_args[0];
+    AWS_NAPI_CALL(env, napi_get_cb_info(env, cb_info, &num_args, node_args, NULL, NULL), {
+        napi_throw_error(env, NULL, "Failed to retreive callback information");
+        return NULL;
+    });
+    if (num_args != AWS_ARRAY_SIZE(node_args)) {
+        napi_throw_error(env, NULL, "mqtt_client_connection_subscribe_multiple needs exactly 3 arguments");
+        return NULL;
+    }
+
+    napi_value node_binding = *arg++;
+    struct mqtt_connection_binding *binding = NULL;
+    AWS_NAPI_CALL(env, napi_get_value_external(env, node_binding, (void **)&binding), {
+        napi_throw_error(env, NULL, "Failed to extract binding from external");
+        return NULL;
+    });
+
+    if (binding->connection == NULL) {
+        napi_throw_error(env, NULL, "Connection has been closed and can no longer be used");
+        return NULL;
+    }
+
+    napi_value node_subscriptions = *arg++;
+    bool is_array = false;
+    AWS_NAPI_CALL(env, napi_is_array(env, node_subscriptions, &is_array), {
+        napi_throw_error(env, NULL, "Failed to check if subscriptions is an array");
+        return NULL;
+    });
+    if (!is_array) {
+        napi_throw_type_error(env, NULL, "subscriptions must be an array");
+        return NULL;
+    }
+
+    uint32_t subscription_count = 0;
+    AWS_NAPI_CALL(env, napi_get_array_length(env, node_subscriptions, &subscription_count), {
+        napi_throw_error(env, NULL, "Failed to get the length of subscriptions");
+        return NULL;
+    });
+    if (subscription_count == 0) {
+        napi_throw_range_error(env, NULL, "subscriptions must not be empty");
+        return NULL;
+    }
+
+    struct aws_allocator *allocator = binding->allocator;
+    struct multi_suback_args *suback = NULL;
+
+    /* struct subscription *, released here unless the connection takes them over */
+    struct aws_array_list subscriptions;
+    aws_array_list_init_dynamic(&subscriptions, allocator, subscription_count, sizeof(struct subscription *));
+
+    /* struct aws_mqtt_topic_subscription, referencing the topics owned by the subscriptions */
+    struct aws_array_list topic_filters;
+    aws_array_list_init_dynamic(
+        &topic_filters, allocator, subscription_count, sizeof(struct aws_mqtt_topic_subscription));
+
+    for (uint32_t i = 0; i < subscription_count; ++i) {
+        napi_value node_subscription = NULL;
+        AWS_NAPI_CALL(env, napi_get_element(env, node_subscriptions, i, &node_subscription), {
+            napi_throw_error(env, NULL, "Failed to get element from subscriptions");
+            goto cleanup;
+        });
+
+        struct subscription *sub = s_subscription_new(allocator);
+        aws_array_list_push_back(&subscriptions, &sub);
+
+        napi_value node_topic = NULL;
+        if (aws_napi_get_named_property(env, node_subscription, AWS_NAPI_KEY_TOPIC, napi_string, &node_topic) !=
+            AWS_NGNPR_VALID_VALUE) {
+            napi_throw_type_error(env, NULL, "each subscription must have a String topic");
+            goto cleanup;
+        }
+        AWS_NAPI_CALL(env, aws_byte_buf_init_from_napi(&sub->topic, env, node_topic), {
+            napi_throw_type_error(env, NULL, "each subscription must have a String topic");
+            goto cleanup;
+        });
+
+        uint32_t qos_uint = 0;
+        if (aws_napi_get_named_property_as_uint32(env, node_subscription, AWS_NAPI_KEY_QOS, &qos_uint) !=
+            AWS_NGNPR_VALID_VALUE) {
+            napi_throw_type_error(env, NULL, "each subscription must have a Number qos");
+            goto cleanup;
+        }
+        if (qos_uint > AWS_MQTT_QOS_EXACTLY_ONCE) {
+            napi_throw_range_error(env, NULL, "qos must be 0, 1 or 2");
+            goto cleanup;
+        }
+
+        napi_value node_handler = NULL;
+        enum aws_napi_get_named_property_result handler_result =
+            aws_napi_get_named_property(env, node_subscription, AWS_NAPI_KEY_HANDLER, napi_function, &node_handler);
+        if (handler_result == AWS_NGNPR_INVALID_VALUE && !aws_napi_is_null_or_undefined(env, node_handler)) {
+            napi_throw_type_error(env, NULL, "subscription handler must be a function or undefined");
+            goto cleanup;
+        }
+        if (handler_result == AWS_NGNPR_VALID_VALUE) {
+            AWS_NAPI_CALL(
+                env,
+                aws_napi_create_threadsafe_function(
+                    env,
+                    node_handler,
+                    "aws_mqtt_client_connection_on_publish",
+                    s_on_publish_call,
+                    binding,
+                    &sub->on_publish),
+                { goto cleanup; });
+        }
+
+        struct aws_mqtt_topic_subscription topic_filter = {
+            .topic = aws_byte_cursor_from_buf(&sub->topic),
+            .qos = (enum aws_mqtt_qos)qos_uint,
+            .on_publish = s_on_publish,
+            .on_cleanup = s_on_publish_user_data_clean_up,
+            .on_publish_ud = sub,
+        };
+        aws_array_list_push_back(&topic_filters, &topic_filter);
+    }
+
+    napi_value node_on_suback = *arg++;
+    if (!aws_napi_is_null_or_undefined(env, node_on_suback)) {
+        suback = aws_mem_calloc(allocator, 1, sizeof(struct multi_suback_args));
+        AWS_FATAL_ASSERT(suback);
+        suback->allocator = allocator;
+        suback->binding = binding;
+        aws_array_list_init_dynamic(
+            &suback->results, allocator, subscription_count, sizeof(struct subscribe_multiple_result));
+        AWS_NAPI_CALL(
+            env,
+            aws_napi_create_threadsafe_function(
+                env,
+                node_on_suback,
+                "aws_mqtt_client_connection_on_multi_suback",
+                s_on_multi_suback_call,
+                binding,
+                &suback->on_suback),
+            { goto cleanup; });
+    }
+
+    /* all of the topic filters go out in a single SUBSCRIBE packet */
+    uint16_t sub_id =
+        aws_mqtt_client_connection_subscribe_multiple(binding->connection, &topic_filters, s_on_multi_suback, suback);
+
+    if (!sub_id) {
+        aws_napi_throw_last_error(env);
+        goto cleanup;
+    }
+
+    /* the connection now owns the subscriptions and the suback args */
+    aws_array_list_clear(&subscriptions);
+    suback = NULL;
+
+    s_refresh_live_operation_statistics(binding);
+
+cleanup:
+
+    for (size_t i = 0; i < aws_array_list_length(&subscriptions); ++i) {
+        struct subscription *sub = NULL;
+        aws_array_list_get_at(&subscriptions, &sub, i);
+        s_subscription_release(sub);
+    }
+    aws_array_list_clean_up(&subscriptions);
+    aws_array_list_clean_up(&topic_filters);
+
+    s_destroy_multi_suback_args(suback);
+
+    return NULL;
+}
+
+/*
+ * on-any publish
+ */
+struct on_any_publish_args {
+    struct aws_allocator *allocator;
+    struct mqtt_message_record *message;
+};
+
+static void s_destroy_on_any_publish_args(struct on_any_publish_args *args) {
+    if (args == NULL) {
+        return;
+    }
 
-    struct aws_byte_buf *payload = finalize_hint;
-    struct aws_allocator *allocator = payload->allocator;
-    AWS_FATAL_ASSERT(allocator != NULL);
+    s_mqtt_message_record_release(args->message);
 
-    aws_byte_buf_clean_up(payload);
-    aws_mem_release(allocator, payload);
+    aws_mem_release(args->allocator, args);
 }
 
 static void s_on_any_publish_call(napi_env env, napi_value on_publish, void *context, void *user_data) {
@@ -1672,29 +2626,7 @@ static void s_on_any_publish_call(napi_env env, napi_value on_publish, void *con
             napi_value params[5];
             const size_t num_params = AWS_ARRAY_SIZE(params);
 
-            AWS_NAPI_ENSURE(
-                env, napi_create_string_utf8(env, aws_string_c_str(args->topic), args->topic->len, &params[0]));
-
-            AWS_NAPI_ENSURE(
-                env,
-                aws_napi_create_external_arraybuffer(
-                    env,
-                    args->payload->buffer,
-                    args->payload->len,
-                    s_any_publish_external_arraybuffer_finalizer,
-                    args->payload,
-                    &params[1]));
-
-            AWS_NAPI_ENSURE(env, napi_get_boolean(env, args->dup, &params[2]));
-            AWS_NAPI_ENSURE(env, napi_create_int32(env, args->qos, &params[3]));
-            AWS_NAPI_ENSURE(env, napi_get_boolean(env, args->retain, &params[4]));
-
-            /*
-             * We've successfully created the external array buffer whose finalizer will clean this byte_buf up.
-             * It's now safe and correct to set this to NULL in the args so that the args destructor does not clean it
-             * up.
-             */
-            args->payload = NULL;
+            s_create_message_record_params(env, binding, args->message, params);
 
             AWS_NAPI_ENSURE(
                 env,
@@ -1727,30 +2659,28 @@ static void s_on_any_publish(
         return;
     }
 
-    struct aws_allocator *allocator = binding->allocator;
-    struct on_any_publish_args *args = aws_mem_calloc(allocator, 1, sizeof(struct on_publish_args));
-    AWS_FATAL_ASSERT(args);
+    /* every received message passes through here, while subscription handlers only see some of them */
+    aws_napi_live_statistics_record_publish_received(&binding->live_statistics, payload->len);
 
-    args->allocator = allocator;
-    args->topic = aws_string_new_from_array(allocator, topic->ptr, topic->len);
-    args->dup = dup;
-    args->qos = qos;
-    args->retain = retain;
-    args->payload = aws_mem_calloc(allocator, 1, sizeof(struct aws_byte_buf));
+    bool is_dropped = s_filter_publish(binding, topic, payload, retain);
 
-    /* this is freed after being delivered to node in s_on_any_publish_call */
-    if (aws_byte_buf_init_copy_from_cursor(args->payload, allocator, *payload)) {
-        AWS_LOGF_ERROR(AWS_LS_NODEJS_CRT_GENERAL, "Failed to copy MQTT payload buffer, payload will not be delivered");
-        goto on_error;
-    }
+    /* the last callback for this message; the decoder may reuse the same memory for the next one */
+    binding->has_dispatched_message_verdict = false;
 
-    AWS_NAPI_ENSURE(NULL, aws_napi_queue_threadsafe_function(binding->on_any_publish, args));
+    if (!is_dropped) {
+        struct aws_allocator *allocator = binding->allocator;
+        struct on_any_publish_args *args = aws_mem_calloc(allocator, 1, sizeof(struct on_any_publish_args));
+        AWS_FATAL_ASSERT(args);
 
-    return;
+        args->allocator = allocator;
+        /* shared with any subscription handlers this message is also delivered to */
+        args->message = s_acquire_message_record(binding, topic, payload, dup, qos, retain);
 
-on_error:
+        AWS_NAPI_ENSURE(NULL, aws_napi_queue_threadsafe_function(binding->on_any_publish, args));
+    }
 
-    s_destroy_on_any_publish_args(args);
+    /* every delivery of this message is queued and holds its own reference */
+    binding->last_message_record = s_mqtt_message_record_release(binding->last_message_record);
 }
 
 napi_value aws_napi_mqtt_client_connection_on_message(napi_env env, napi_callback_info cb_info) {
@@ -1860,6 +2790,8 @@ static void s_on_unsubscribe_complete(
 
     struct unsuback_args *args = user_data;
 
+    s_refresh_live_operation_statistics(args->binding);
+
     if (!args->on_unsuback) {
         s_destroy_unsuback_args(args);
         return;
@@ -1934,6 +2866,8 @@ napi_value aws_napi_mqtt_client_connection_unsubscribe(napi_env env, napi_callba
 
     args->packet_id = unsub_id;
 
+    s_refresh_live_operation_statistics(binding);
+
     return NULL;
 
 cleanup:
@@ -2058,6 +2992,7 @@ on_error:
 
 static int s_create_napi_mqtt_connection_statistics(
     napi_env env,
+    struct mqtt_connection_binding *binding,
     const struct aws_mqtt_connection_operation_statistics *stats,
     napi_value *stats_out) {
 
@@ -2089,6 +3024,27 @@ static int s_create_napi_mqtt_connection_statistics(
         return AWS_OP_ERR;
     };
 
+    if (binding->has_message_filter_statistics) {
+        aws_mutex_lock(&binding->message_filter_lock);
+        struct aws_napi_mqtt_message_filter_statistics filter_stats = binding->message_filter_statistics;
+        aws_mutex_unlock(&binding->message_filter_lock);
+
+        if (aws_napi_attach_object_property_u64(
+                napi_stats, env, AWS_NAPI_KEY_FILTERED_MESSAGE_COUNT, filter_stats.filtered_count)) {
+            return AWS_OP_ERR;
+        }
+
+        if (aws_napi_attach_object_property_u64(
+                napi_stats, env, AWS_NAPI_KEY_SAMPLED_OUT_MESSAGE_COUNT, filter_stats.sampled_out_count)) {
+            return AWS_OP_ERR;
+        }
+
+        if (aws_napi_attach_object_property_u64(
+                napi_stats, env, AWS_NAPI_KEY_RATE_LIMITED_MESSAGE_COUNT, filter_stats.rate_limited_count)) {
+            return AWS_OP_ERR;
+        }
+    }
+
     *stats_out = napi_stats;
 
     return AWS_OP_SUCCESS;
@@ -2132,7 +3088,7 @@ napi_value aws_napi_mqtt_client_connection_get_queue_statistics(napi_env env, na
     aws_mqtt_client_connection_get_stats(binding->connection, &stats);
 
     napi_value napi_stats = NULL;
-    if (s_create_napi_mqtt_connection_statistics(env, &stats, &napi_stats)) {
+    if (s_create_napi_mqtt_connection_statistics(env, binding, &stats, &napi_stats)) {
         napi_throw_error(
             env, NULL, "aws_napi_mqtt_client_connection_get_queue_statistics - failed to build statistics value");
         return NULL;
@@ -2141,6 +3097,105 @@ napi_value aws_napi_mqtt_client_connection_get_queue_statistics(napi_env env, na
     return napi_stats;
 }
 
+napi_value aws_napi_mqtt_client_connection_set_message_filter(napi_env env, napi_callback_info info) {
+
+    napi_value node_args[2];
+    size_t num_args = AWS_ARRAY_SIZE(node_args);
+    napi_value *arg = &node_args[0];
+    AWS_NAPI_CALL(env, napi_get_cb_info(env, info, &num_args, node_args, NULL, NULL), {
+        napi_throw_error(
+            env, NULL, "aws_napi_mqtt_client_connection_set_message_filter - Failed to extract parameter array");
+        return NULL;
+    });
+
+    if (num_args != AWS_ARRAY_SIZE(node_args)) {
+        napi_throw_error(env, NULL, "aws_napi_mqtt_client_connection_set_message_filter - needs exactly 2 arguments");
+        return NULL;
+    }
+
+    struct mqtt_connection_binding *binding = NULL;
+    napi_value node_binding = *arg++;
+    AWS_NAPI_CALL(env, napi_get_value_external(env, node_binding, (void **)&binding), {
+        napi_throw_error(env, NULL, "Failed to extract binding from external");
+        return NULL;
+    });
+
+    if (binding == NULL) {
+        napi_throw_error(env, NULL, "aws_napi_mqtt_client_connection_set_message_filter - binding was null");
+        return NULL;
+    }
+
+    /* null or undefined removes the current filter */
+    struct aws_napi_mqtt_message_filter *filter = NULL;
+    napi_value node_rules = *arg++;
+    if (!aws_napi_is_null_or_undefined(env, node_rules)) {
+        filter = aws_napi_mqtt_message_filter_new_from_napi(binding->allocator, env, node_rules);
+        if (filter == NULL) {
+            aws_napi_throw_last_error_with_context(
+                env, "aws_napi_mqtt_client_connection_set_message_filter - invalid message filter rules");
+            return NULL;
+        }
+    }
+
+    aws_mutex_lock(&binding->message_filter_lock);
+    struct aws_napi_mqtt_message_filter *previous_filter = binding->message_filter;
+    binding->message_filter = filter;
+    aws_mutex_unlock(&binding->message_filter_lock);
+
+    aws_napi_mqtt_message_filter_destroy(previous_filter);
+
+    aws_atomic_store_int(&binding->is_message_filter_enabled, filter != NULL ? 1 : 0);
+    if (filter != NULL) {
+        binding->has_message_filter_statistics = true;
+    }
+
+    return NULL;
+}
+
+napi_value aws_napi_mqtt_client_connection_set_live_statistics(napi_env env, napi_callback_info info) {
+
+    napi_value node_args[2];
+    size_t num_args = AWS_ARRAY_SIZE(node_args);
+    napi_value *arg = &node_args[0];
+    AWS_NAPI_CALL(env, napi_get_cb_info(env, info, &num_args, node_args, NULL, NULL), {
+        napi_throw_error(
+            env, NULL, "aws_napi_mqtt_client_connection_set_live_statistics - Failed to extract parameter array");
+        return NULL;
+    });
+
+    if (num_args != AWS_ARRAY_SIZE(node_args)) {
+        napi_throw_error(env, NULL, "aws_napi_mqtt_client_connection_set_live_statistics - needs exactly 2 arguments");
+        return NULL;
+    }
+
+    struct mqtt_connection_binding *binding = NULL;
+    napi_value node_binding = *arg++;
+    AWS_NAPI_CALL(env, napi_get_value_external(env, node_binding, (void **)&binding), {
+        napi_throw_error(env, NULL, "Failed to extract binding from external");
+        return NULL;
+    });
+
+    if (binding == NULL) {
+        napi_throw_error(env, NULL, "aws_napi_mqtt_client_connection_set_live_statistics - binding was null");
+        return NULL;
+    }
+
+    if (binding->connection == NULL) {
+        napi_throw_error(env, NULL, "Connection has been closed and can no longer be used");
+        return NULL;
+    }
+
+    if (aws_napi_live_statistics_bind_napi(&binding->live_statistics, env, *arg++)) {
+        aws_napi_throw_last_error_with_context(
+            env, "aws_napi_mqtt_client_connection_set_live_statistics - failed to bind live statistics memory");
+        return NULL;
+    }
+
+    s_refresh_live_operation_statistics(binding);
+
+    return NULL;
+}
+
 /*******************************************************************************
  * On Closed
  ******************************************************************************/
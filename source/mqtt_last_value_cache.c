@@ -0,0 +1,507 @@
+/**
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0.
+ */
+
+#include "mqtt_last_value_cache.h"
+
+#include "mqtt_message_filter.h"
+
+#include <aws/common/array_list.h>
+#include <aws/common/byte_buf.h>
+#include <aws/common/linked_hash_table.h>
+#include <aws/mqtt/mqtt.h>
+
+static const char *AWS_NAPI_KEY_TOPIC_FILTERS = "topicFilters";
+static const char *AWS_NAPI_KEY_MAX_TOPIC_COUNT = "maxTopicCount";
+static const char *AWS_NAPI_KEY_MAX_SIZE_BYTES = "maxSizeBytes";
+static const char *AWS_NAPI_KEY_SUPPRESS_DELIVERY = "suppressDelivery";
+static const char *AWS_NAPI_KEY_TOPIC = "topic";
+static const char *AWS_NAPI_KEY_PAYLOAD = "payload";
+static const char *AWS_NAPI_KEY_RETAIN = "retain";
+static const char *AWS_NAPI_KEY_AGE_MS = "ageMs";
+
+static const uint32_t s_default_max_topic_count = 10000;
+static const uint64_t s_default_max_size_bytes = 16 * 1024 * 1024;
+
+#define NS_PER_MS 1000000ULL
+
+/* Latest value of one topic */
+struct aws_napi_mqtt_last_value {
+    struct aws_allocator *allocator;
+
+    struct aws_byte_buf topic;
+
+    /* hash table key, points into topic */
+    struct aws_byte_cursor topic_cursor;
+
+    struct aws_byte_buf payload;
+    bool retain;
+    uint64_t updated_ns;
+};
+
+struct aws_napi_mqtt_last_value_cache {
+    struct aws_allocator *allocator;
+
+    /* aws_byte_buf, topic filters whose publishes are cached */
+    struct aws_array_list topic_filters;
+
+    uint32_t max_topic_count;
+    uint64_t max_size;
+    bool suppress_delivery;
+
+    /* aws_byte_cursor * -> aws_napi_mqtt_last_value *, least recently used first */
+    struct aws_linked_hash_table values;
+
+    struct aws_napi_mqtt_last_value_cache_statistics statistics;
+};
+
+static bool s_byte_cursor_ptr_eq(const void *a, const void *b) {
+    return aws_byte_cursor_eq(a, b);
+}
+
+static uint64_t s_last_value_size(const struct aws_napi_mqtt_last_value *value) {
+    return value->topic.len + value->payload.len;
+}
+
+static void s_last_value_destroy(void *element) {
+    struct aws_napi_mqtt_last_value *value = element;
+
+    aws_byte_buf_clean_up(&value->topic);
+    aws_byte_buf_clean_up(&value->payload);
+    aws_mem_release(value->allocator, value);
+}
+
+void aws_napi_mqtt_last_value_cache_destroy(struct aws_napi_mqtt_last_value_cache *cache) {
+    if (cache == NULL) {
+        return;
+    }
+
+    aws_linked_hash_table_clean_up(&cache->values);
+
+    if (aws_array_list_is_valid(&cache->topic_filters)) {
+        size_t filter_count = aws_array_list_length(&cache->topic_filters);
+        for (size_t i = 0; i < filter_count; ++i) {
+            struct aws_byte_buf *topic_filter = NULL;
+            aws_array_list_get_at_ptr(&cache->topic_filters, (void **)&topic_filter, i);
+            aws_byte_buf_clean_up(topic_filter);
+        }
+        aws_array_list_clean_up(&cache->topic_filters);
+    }
+
+    aws_mem_release(cache->allocator, cache);
+}
+
+static void s_log_invalid_options(const char *message) {
+    AWS_LOGF_ERROR(AWS_LS_NODEJS_CRT_GENERAL, "aws_napi_mqtt_last_value_cache_new_from_napi - %s", message);
+}
+
+static int s_init_topic_filters_from_napi(
+    struct aws_napi_mqtt_last_value_cache *cache,
+    napi_env env,
+    napi_value node_options) {
+
+    napi_value node_topic_filters = NULL;
+    bool is_array = false;
+    if (aws_napi_get_named_property(env, node_options, AWS_NAPI_KEY_TOPIC_FILTERS, napi_object, &node_topic_filters) !=
+            AWS_NGNPR_VALID_VALUE ||
+        napi_is_array(env, node_topic_filters, &is_array) != napi_ok || !is_array) {
+        s_log_invalid_options("topicFilters is required and must be an array");
+        return aws_raise_error(AWS_ERROR_INVALID_ARGUMENT);
+    }
+
+    uint32_t filter_count = 0;
+    AWS_NAPI_CALL(env, napi_get_array_length(env, node_topic_filters, &filter_count), {
+        return aws_raise_error(AWS_CRT_NODEJS_ERROR_NAPI_FAILURE);
+    });
+
+    if (aws_array_list_init_dynamic(&cache->topic_filters, cache->allocator, filter_count, sizeof(struct aws_byte_buf))) {
+        return AWS_OP_ERR;
+    }
+
+    for (uint32_t i = 0; i < filter_count; ++i) {
+        napi_value node_topic_filter = NULL;
+        AWS_NAPI_CALL(env, napi_get_element(env, node_topic_filters, i, &node_topic_filter), {
+            return aws_raise_error(AWS_CRT_NODEJS_ERROR_NAPI_FAILURE);
+        });
+
+        napi_valuetype type = napi_undefined;
+        AWS_NAPI_CALL(env, napi_typeof(env, node_topic_filter, &type), {
+            return aws_raise_error(AWS_CRT_NODEJS_ERROR_NAPI_FAILURE);
+        });
+
+        if (type != napi_string) {
+            s_log_invalid_options("topicFilters must only contain strings");
+            return aws_raise_error(AWS_ERROR_INVALID_ARGUMENT);
+        }
+
+        struct aws_byte_buf topic_filter;
+        AWS_NAPI_CALL(env, aws_byte_buf_init_from_napi(&topic_filter, env, node_topic_filter), {
+            return aws_raise_error(AWS_CRT_NODEJS_ERROR_NAPI_FAILURE);
+        });
+
+        /* pushed before validation so that it is cleaned up with the rest */
+        aws_array_list_push_back(&cache->topic_filters, &topic_filter);
+
+        struct aws_byte_cursor topic_filter_cursor = aws_byte_cursor_from_buf(&topic_filter);
+        if (!aws_mqtt_is_valid_topic_filter(&topic_filter_cursor)) {
+            s_log_invalid_options("topicFilters contains an invalid topic filter");
+            return aws_raise_error(AWS_ERROR_INVALID_ARGUMENT);
+        }
+    }
+
+    return AWS_OP_SUCCESS;
+}
+
+struct aws_napi_mqtt_last_value_cache *aws_napi_mqtt_last_value_cache_new_from_napi(
+    struct aws_allocator *allocator,
+    napi_env env,
+    napi_value node_options) {
+
+    struct aws_napi_mqtt_last_value_cache *cache =
+        aws_mem_calloc(allocator, 1, sizeof(struct aws_napi_mqtt_last_value_cache));
+    cache->allocator = allocator;
+    cache->max_topic_count = s_default_max_topic_count;
+    cache->max_size = s_default_max_size_bytes;
+
+    if (aws_linked_hash_table_init(
+            &cache->values,
+            allocator,
+            aws_hash_byte_cursor_ptr,
+            s_byte_cursor_ptr_eq,
+            NULL,
+            s_last_value_destroy,
+            16)) {
+        aws_mem_release(allocator, cache);
+        return NULL;
+    }
+
+    if (s_init_topic_filters_from_napi(cache, env, node_options)) {
+        goto error;
+    }
+
+    if (aws_napi_get_named_property_as_uint32(env, node_options, AWS_NAPI_KEY_MAX_TOPIC_COUNT, &cache->max_topic_count) ==
+            AWS_NGNPR_INVALID_VALUE ||
+        cache->max_topic_count == 0) {
+        s_log_invalid_options("maxTopicCount must be a positive integer");
+        aws_raise_error(AWS_ERROR_INVALID_ARGUMENT);
+        goto error;
+    }
+
+    if (aws_napi_get_named_property_as_uint64(env, node_options, AWS_NAPI_KEY_MAX_SIZE_BYTES, &cache->max_size) ==
+            AWS_NGNPR_INVALID_VALUE ||
+        cache->max_size == 0) {
+        s_log_invalid_options("maxSizeBytes must be a positive integer");
+        aws_raise_error(AWS_ERROR_INVALID_ARGUMENT);
+        goto error;
+    }
+
+    if (aws_napi_get_named_property_as_boolean(
+            env, node_options, AWS_NAPI_KEY_SUPPRESS_DELIVERY, &cache->suppress_delivery) == AWS_NGNPR_INVALID_VALUE) {
+        s_log_invalid_options("suppressDelivery must be a boolean");
+        aws_raise_error(AWS_ERROR_INVALID_ARGUMENT);
+        goto error;
+    }
+
+    return cache;
+
+error:
+
+    aws_napi_mqtt_last_value_cache_destroy(cache);
+
+    return NULL;
+}
+
+bool aws_napi_mqtt_last_value_cache_matches(
+    const struct aws_napi_mqtt_last_value_cache *cache,
+    struct aws_byte_cursor topic) {
+
+    size_t filter_count = aws_array_list_length(&cache->topic_filters);
+    for (size_t i = 0; i < filter_count; ++i) {
+        struct aws_byte_buf *topic_filter = NULL;
+        aws_array_list_get_at_ptr(&cache->topic_filters, (void **)&topic_filter, i);
+
+        if (aws_napi_mqtt_topic_matches_filter(topic, aws_byte_cursor_from_buf(topic_filter))) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool aws_napi_mqtt_last_value_cache_suppresses_delivery(const struct aws_napi_mqtt_last_value_cache *cache) {
+    return cache->suppress_delivery;
+}
+
+static void s_remove_value(struct aws_napi_mqtt_last_value_cache *cache, struct aws_napi_mqtt_last_value *value) {
+    cache->statistics.size -= s_last_value_size(value);
+    --cache->statistics.topic_count;
+
+    /* destroys the value, and with it the key */
+    aws_linked_hash_table_remove(&cache->values, &value->topic_cursor);
+}
+
+static void s_evict_to_limits(struct aws_napi_mqtt_last_value_cache *cache) {
+    const struct aws_linked_list *lru_list = aws_linked_hash_table_get_element_list(&cache->values);
+
+    while (!aws_linked_list_empty(lru_list) &&
+           (cache->statistics.topic_count > cache->max_topic_count || cache->statistics.size > cache->max_size)) {
+        struct aws_linked_hash_table_node *node =
+            AWS_CONTAINER_OF(aws_linked_list_front(lru_list), struct aws_linked_hash_table_node, node);
+
+        s_remove_value(cache, node->value);
+        ++cache->statistics.evicted_count;
+    }
+}
+
+int aws_napi_mqtt_last_value_cache_update(
+    struct aws_napi_mqtt_last_value_cache *cache,
+    struct aws_byte_cursor topic,
+    struct aws_byte_cursor payload,
+    bool retain,
+    uint64_t now_ns) {
+
+    ++cache->statistics.update_count;
+
+    struct aws_napi_mqtt_last_value *value = NULL;
+    aws_linked_hash_table_find_and_move_to_back(&cache->values, &topic, (void **)&value);
+
+    if (topic.len + payload.len > cache->max_size) {
+        if (value != NULL) {
+            s_remove_value(cache, value);
+        }
+        ++cache->statistics.evicted_count;
+        return AWS_OP_SUCCESS;
+    }
+
+    if (value == NULL) {
+        value = aws_mem_calloc(cache->allocator, 1, sizeof(struct aws_napi_mqtt_last_value));
+        value->allocator = cache->allocator;
+
+        if (aws_byte_buf_init_copy_from_cursor(&value->topic, cache->allocator, topic) ||
+            aws_byte_buf_init(&value->payload, cache->allocator, payload.len)) {
+            s_last_value_destroy(value);
+            return AWS_OP_ERR;
+        }
+        value->topic_cursor = aws_byte_cursor_from_buf(&value->topic);
+
+        if (aws_linked_hash_table_put(&cache->values, &value->topic_cursor, value)) {
+            s_last_value_destroy(value);
+            return AWS_OP_ERR;
+        }
+
+        ++cache->statistics.topic_count;
+        cache->statistics.size += value->topic.len;
+    }
+
+    cache->statistics.size -= value->payload.len;
+    aws_byte_buf_reset(&value->payload, false);
+    if (aws_byte_buf_append_dynamic(&value->payload, &payload)) {
+        s_remove_value(cache, value);
+        return AWS_OP_ERR;
+    }
+    cache->statistics.size += value->payload.len;
+
+    value->retain = retain;
+    value->updated_ns = now_ns;
+
+    s_evict_to_limits(cache);
+
+    return AWS_OP_SUCCESS;
+}
+
+/* Sizes the snapshot's storage for value_count values totalling size bytes, so that copying them never reallocates */
+static int s_snapshot_reserve(
+    struct aws_napi_mqtt_last_value_snapshot *snapshot,
+    struct aws_allocator *allocator,
+    size_t value_count,
+    size_t size) {
+
+    if (aws_array_list_init_dynamic(
+            &snapshot->entries, allocator, value_count, sizeof(struct aws_napi_mqtt_last_value_snapshot_entry))) {
+        return AWS_OP_ERR;
+    }
+
+    return aws_byte_buf_init(&snapshot->storage, allocator, size);
+}
+
+static void s_snapshot_push(
+    struct aws_napi_mqtt_last_value_snapshot *snapshot,
+    const struct aws_napi_mqtt_last_value *value,
+    uint64_t now_ns) {
+
+    struct aws_napi_mqtt_last_value_snapshot_entry entry = {
+        .retain = value->retain,
+        .age_ns = now_ns > value->updated_ns ? now_ns - value->updated_ns : 0,
+    };
+
+    entry.topic = aws_byte_cursor_from_array(snapshot->storage.buffer + snapshot->storage.len, value->topic.len);
+    aws_byte_buf_write_from_whole_buffer(&snapshot->storage, value->topic);
+
+    entry.payload = aws_byte_cursor_from_array(snapshot->storage.buffer + snapshot->storage.len, value->payload.len);
+    aws_byte_buf_write_from_whole_buffer(&snapshot->storage, value->payload);
+
+    /* capacity was reserved up front */
+    aws_array_list_push_back(&snapshot->entries, &entry);
+}
+
+int aws_napi_mqtt_last_value_cache_get(
+    struct aws_napi_mqtt_last_value_cache *cache,
+    struct aws_byte_cursor topic,
+    uint64_t now_ns,
+    struct aws_napi_mqtt_last_value_snapshot *snapshot) {
+
+    struct aws_napi_mqtt_last_value *value = NULL;
+    aws_linked_hash_table_find_and_move_to_back(&cache->values, &topic, (void **)&value);
+
+    if (value == NULL) {
+        return s_snapshot_reserve(snapshot, cache->allocator, 0, 0);
+    }
+
+    if (s_snapshot_reserve(snapshot, cache->allocator, 1, (size_t)s_last_value_size(value))) {
+        return AWS_OP_ERR;
+    }
+
+    s_snapshot_push(snapshot, value, now_ns);
+
+    return AWS_OP_SUCCESS;
+}
+
+int aws_napi_mqtt_last_value_cache_snapshot(
+    struct aws_napi_mqtt_last_value_cache *cache,
+    struct aws_byte_cursor topic_prefix,
+    uint64_t now_ns,
+    struct aws_napi_mqtt_last_value_snapshot *snapshot) {
+
+    const struct aws_linked_list *lru_list = aws_linked_hash_table_get_element_list(&cache->values);
+
+    size_t value_count = 0;
+    size_t size = 0;
+    for (const struct aws_linked_list_node *iter = aws_linked_list_begin(lru_list);
+         iter != aws_linked_list_end(lru_list);
+         iter = aws_linked_list_next(iter)) {
+
+        const struct aws_linked_hash_table_node *node =
+            AWS_CONTAINER_OF(iter, const struct aws_linked_hash_table_node, node);
+        const struct aws_napi_mqtt_last_value *value = node->value;
+
+        if (aws_byte_cursor_starts_with(&value->topic_cursor, &topic_prefix)) {
+            ++value_count;
+            size += (size_t)s_last_value_size(value);
+        }
+    }
+
+    if (s_snapshot_reserve(snapshot, cache->allocator, value_count, size)) {
+        return AWS_OP_ERR;
+    }
+
+    for (const struct aws_linked_list_node *iter = aws_linked_list_begin(lru_list);
+         iter != aws_linked_list_end(lru_list);
+         iter = aws_linked_list_next(iter)) {
+
+        const struct aws_linked_hash_table_node *node =
+            AWS_CONTAINER_OF(iter, const struct aws_linked_hash_table_node, node);
+        const struct aws_napi_mqtt_last_value *value = node->value;
+
+        if (aws_byte_cursor_starts_with(&value->topic_cursor, &topic_prefix)) {
+            s_snapshot_push(snapshot, value, now_ns);
+        }
+    }
+
+    return AWS_OP_SUCCESS;
+}
+
+void aws_napi_mqtt_last_value_snapshot_clean_up(struct aws_napi_mqtt_last_value_snapshot *snapshot) {
+    aws_array_list_clean_up(&snapshot->entries);
+    aws_byte_buf_clean_up(&snapshot->storage);
+}
+
+static int s_create_napi_last_value(
+    napi_env env,
+    const struct aws_napi_mqtt_last_value_snapshot_entry *entry,
+    napi_value *result) {
+
+    napi_value napi_value_out = NULL;
+    AWS_NAPI_CALL(env, napi_create_object(env, &napi_value_out), {
+        return aws_raise_error(AWS_CRT_NODEJS_ERROR_NAPI_FAILURE);
+    });
+
+    void *payload_data = NULL;
+    napi_value napi_payload = NULL;
+    AWS_NAPI_CALL(env, napi_create_arraybuffer(env, entry->payload.len, &payload_data, &napi_payload), {
+        return aws_raise_error(AWS_CRT_NODEJS_ERROR_NAPI_FAILURE);
+    });
+
+    if (entry->payload.len > 0) {
+        memcpy(payload_data, entry->payload.ptr, entry->payload.len);
+    }
+
+    AWS_NAPI_CALL(env, napi_set_named_property(env, napi_value_out, AWS_NAPI_KEY_PAYLOAD, napi_payload), {
+        return aws_raise_error(AWS_CRT_NODEJS_ERROR_NAPI_FAILURE);
+    });
+
+    if (aws_napi_attach_object_property_string(napi_value_out, env, AWS_NAPI_KEY_TOPIC, entry->topic) ||
+        aws_napi_attach_object_property_boolean(napi_value_out, env, AWS_NAPI_KEY_RETAIN, entry->retain) ||
+        aws_napi_attach_object_property_u64(napi_value_out, env, AWS_NAPI_KEY_AGE_MS, entry->age_ns / NS_PER_MS)) {
+        return AWS_OP_ERR;
+    }
+
+    *result = napi_value_out;
+
+    return AWS_OP_SUCCESS;
+}
+
+int aws_napi_mqtt_last_value_snapshot_first_to_napi(
+    const struct aws_napi_mqtt_last_value_snapshot *snapshot,
+    napi_env env,
+    napi_value *result) {
+
+    struct aws_napi_mqtt_last_value_snapshot_entry *entry = NULL;
+    if (aws_array_list_get_at_ptr(&snapshot->entries, (void **)&entry, 0)) {
+        AWS_NAPI_CALL(env, napi_get_undefined(env, result), {
+            return aws_raise_error(AWS_CRT_NODEJS_ERROR_NAPI_FAILURE);
+        });
+
+        return AWS_OP_SUCCESS;
+    }
+
+    return s_create_napi_last_value(env, entry, result);
+}
+
+int aws_napi_mqtt_last_value_snapshot_to_napi(
+    const struct aws_napi_mqtt_last_value_snapshot *snapshot,
+    napi_env env,
+    napi_value *result) {
+
+    size_t value_count = aws_array_list_length(&snapshot->entries);
+
+    napi_value napi_values = NULL;
+    AWS_NAPI_CALL(env, napi_create_array_with_length(env, value_count, &napi_values), {
+        return aws_raise_error(AWS_CRT_NODEJS_ERROR_NAPI_FAILURE);
+    });
+
+    for (size_t i = 0; i < value_count; ++i) {
+        struct aws_napi_mqtt_last_value_snapshot_entry *entry = NULL;
+        aws_array_list_get_at_ptr(&snapshot->entries, (void **)&entry, i);
+
+        napi_value napi_last_value = NULL;
+        if (s_create_napi_last_value(env, entry, &napi_last_value)) {
+            return AWS_OP_ERR;
+        }
+
+        AWS_NAPI_CALL(env, napi_set_element(env, napi_values, (uint32_t)i, napi_last_value), {
+            return aws_raise_error(AWS_CRT_NODEJS_ERROR_NAPI_FAILURE);
+        });
+    }
+
+    *result = napi_values;
+
+    return AWS_OP_SUCCESS;
+}
+
+void aws_napi_mqtt_last_value_cache_get_statistics(
+    const struct aws_napi_mqtt_last_value_cache *cache,
+    struct aws_napi_mqtt_last_value_cache_statistics *statistics) {
+
+    *statistics = cache->statistics;
+}
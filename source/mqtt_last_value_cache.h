@@ -0,0 +1,110 @@
+/**
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0.
+ */
+
+#ifndef AWS_CRT_NODEJS_MQTT_LAST_VALUE_CACHE_H
+#define AWS_CRT_NODEJS_MQTT_LAST_VALUE_CACHE_H
+
+#include "module.h"
+
+#include <aws/common/array_list.h>
+#include <aws/common/byte_buf.h>
+
+/*
+ * Most recent payload per topic for received publishes matching a set of topic filters, kept natively so that
+ * latest-value lookups do not require every message to be delivered to node.
+ *
+ * Bounded by a topic count and a byte limit (topic plus payload); when either would be exceeded, the least recently
+ * used topics (by update or lookup) are evicted.  A payload larger than the byte limit is not cached, and any older
+ * value for its topic is discarded.
+ *
+ * Not thread-safe; the caller serializes access.
+ */
+struct aws_napi_mqtt_last_value_cache;
+
+struct aws_napi_mqtt_last_value_cache_statistics {
+    uint64_t topic_count;
+    uint64_t size;
+    uint64_t update_count;
+    uint64_t evicted_count;
+};
+
+/*
+ * Builds a cache from a node options object (LastValueCacheOptions in lib/common/mqtt_shared.ts).  Returns NULL and
+ * raises an error if the options are invalid.
+ */
+struct aws_napi_mqtt_last_value_cache *aws_napi_mqtt_last_value_cache_new_from_napi(
+    struct aws_allocator *allocator,
+    napi_env env,
+    napi_value node_options);
+
+void aws_napi_mqtt_last_value_cache_destroy(struct aws_napi_mqtt_last_value_cache *cache);
+
+/* True if publishes to the topic are cached */
+bool aws_napi_mqtt_last_value_cache_matches(const struct aws_napi_mqtt_last_value_cache *cache, struct aws_byte_cursor topic);
+
+/* True if publishes that are cached should not also be delivered to node */
+bool aws_napi_mqtt_last_value_cache_suppresses_delivery(const struct aws_napi_mqtt_last_value_cache *cache);
+
+/* Records a publish to a matching topic as the latest value of that topic */
+int aws_napi_mqtt_last_value_cache_update(
+    struct aws_napi_mqtt_last_value_cache *cache,
+    struct aws_byte_cursor topic,
+    struct aws_byte_cursor payload,
+    bool retain,
+    uint64_t now_ns);
+
+/*
+ * Copies of cached values, taken while the caller serializes access to the cache so that node values can be built
+ * from them afterwards, without holding up the thread that updates the cache.
+ */
+struct aws_napi_mqtt_last_value_snapshot_entry {
+    struct aws_byte_cursor topic;
+    struct aws_byte_cursor payload;
+    bool retain;
+    uint64_t age_ns;
+};
+
+struct aws_napi_mqtt_last_value_snapshot {
+    /* aws_napi_mqtt_last_value_snapshot_entry, whose cursors point into storage */
+    struct aws_array_list entries;
+    struct aws_byte_buf storage;
+};
+
+/* Copies the latest value of a topic, if one is cached, into a zeroed snapshot */
+int aws_napi_mqtt_last_value_cache_get(
+    struct aws_napi_mqtt_last_value_cache *cache,
+    struct aws_byte_cursor topic,
+    uint64_t now_ns,
+    struct aws_napi_mqtt_last_value_snapshot *snapshot);
+
+/*
+ * Copies the latest values of all cached topics starting with a prefix, least recently used first, into a zeroed
+ * snapshot
+ */
+int aws_napi_mqtt_last_value_cache_snapshot(
+    struct aws_napi_mqtt_last_value_cache *cache,
+    struct aws_byte_cursor topic_prefix,
+    uint64_t now_ns,
+    struct aws_napi_mqtt_last_value_snapshot *snapshot);
+
+void aws_napi_mqtt_last_value_snapshot_clean_up(struct aws_napi_mqtt_last_value_snapshot *snapshot);
+
+/* Creates a node value for the first value in a snapshot, or undefined if it is empty */
+int aws_napi_mqtt_last_value_snapshot_first_to_napi(
+    const struct aws_napi_mqtt_last_value_snapshot *snapshot,
+    napi_env env,
+    napi_value *result);
+
+/* Creates a node array of all values in a snapshot, in order */
+int aws_napi_mqtt_last_value_snapshot_to_napi(
+    const struct aws_napi_mqtt_last_value_snapshot *snapshot,
+    napi_env env,
+    napi_value *result);
+
+void aws_napi_mqtt_last_value_cache_get_statistics(
+    const struct aws_napi_mqtt_last_value_cache *cache,
+    struct aws_napi_mqtt_last_value_cache_statistics *statistics);
+
+#endif /* AWS_CRT_NODEJS_MQTT_LAST_VALUE_CACHE_H */
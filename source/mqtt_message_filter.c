@@ -0,0 +1,477 @@
+/**
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0.
+ */
+
+#include "mqtt_message_filter.h"
+
+#include <aws/common/array_list.h>
+#include <aws/common/byte_buf.h>
+#include <aws/common/hash_table.h>
+#include <aws/common/math.h>
+#include <aws/mqtt/mqtt.h>
+#include <aws/mqtt/v5/mqtt5_types.h>
+
+static const char *AWS_NAPI_KEY_TOPIC_FILTER = "topicFilter";
+static const char *AWS_NAPI_KEY_DROP = "drop";
+static const char *AWS_NAPI_KEY_RETAIN = "retain";
+static const char *AWS_NAPI_KEY_USER_PROPERTY = "userProperty";
+static const char *AWS_NAPI_KEY_NAME = "name";
+static const char *AWS_NAPI_KEY_VALUE = "value";
+static const char *AWS_NAPI_KEY_SAMPLE_EVERY = "sampleEvery";
+static const char *AWS_NAPI_KEY_MAX_MESSAGES_PER_SECOND = "maxMessagesPerSecond";
+
+/* Per-rule bound on the number of distinct topics with sampling or rate limit state */
+#define AWS_NAPI_MQTT_MESSAGE_FILTER_MAX_TRACKED_TOPICS 1024
+
+#define NS_PER_SEC 1000000000ULL
+
+enum aws_napi_mqtt_retain_predicate {
+    AWS_NAPI_MQTT_RP_ANY,
+    AWS_NAPI_MQTT_RP_RETAINED,
+    AWS_NAPI_MQTT_RP_NOT_RETAINED,
+};
+
+/* Sampling and rate limit state for one topic matched by a rule */
+struct aws_napi_mqtt_topic_state {
+    struct aws_byte_buf topic;
+
+    /* hash table key, points into topic */
+    struct aws_byte_cursor topic_cursor;
+
+    uint64_t seen_count;
+
+    /* token bucket holding up to one second's worth of messages, in units of 1/NS_PER_SEC messages */
+    uint64_t budget;
+    uint64_t last_refill_ns;
+};
+
+struct aws_napi_mqtt_message_filter_rule {
+    struct aws_byte_buf topic_filter;
+
+    bool drop;
+    enum aws_napi_mqtt_retain_predicate retain;
+
+    bool has_user_property_predicate;
+    struct aws_byte_buf user_property_name;
+    bool has_user_property_value;
+    struct aws_byte_buf user_property_value;
+
+    uint32_t sample_every;
+    uint32_t max_messages_per_second;
+
+    /* aws_byte_cursor * -> aws_napi_mqtt_topic_state *, only initialized for sampling or rate limiting rules */
+    struct aws_hash_table topic_states;
+};
+
+struct aws_napi_mqtt_message_filter {
+    struct aws_allocator *allocator;
+
+    /* aws_napi_mqtt_message_filter_rule, in evaluation order */
+    struct aws_array_list rules;
+};
+
+bool aws_napi_mqtt_topic_matches_filter(struct aws_byte_cursor topic, struct aws_byte_cursor filter) {
+    if (topic.len > 0 && topic.ptr[0] == '$' && filter.len > 0 && (filter.ptr[0] == '+' || filter.ptr[0] == '#')) {
+        return false;
+    }
+
+    struct aws_byte_cursor topic_level;
+    AWS_ZERO_STRUCT(topic_level);
+    struct aws_byte_cursor filter_level;
+    AWS_ZERO_STRUCT(filter_level);
+
+    bool has_topic_level = aws_byte_cursor_next_split(&topic, '/', &topic_level);
+    while (aws_byte_cursor_next_split(&filter, '/', &filter_level)) {
+        if (aws_byte_cursor_eq_c_str(&filter_level, "#")) {
+            return true;
+        }
+
+        if (!has_topic_level) {
+            return false;
+        }
+
+        if (!aws_byte_cursor_eq_c_str(&filter_level, "+") && !aws_byte_cursor_eq(&filter_level, &topic_level)) {
+            return false;
+        }
+
+        has_topic_level = aws_byte_cursor_next_split(&topic, '/', &topic_level);
+    }
+
+    return !has_topic_level;
+}
+
+static bool s_byte_cursor_ptr_eq(const void *a, const void *b) {
+    return aws_byte_cursor_eq(a, b);
+}
+
+static void s_topic_state_destroy(void *value) {
+    struct aws_napi_mqtt_topic_state *state = value;
+    struct aws_allocator *allocator = state->topic.allocator;
+
+    aws_byte_buf_clean_up(&state->topic);
+    aws_mem_release(allocator, state);
+}
+
+static void s_rule_clean_up(struct aws_napi_mqtt_message_filter_rule *rule) {
+    aws_byte_buf_clean_up(&rule->topic_filter);
+    aws_byte_buf_clean_up(&rule->user_property_name);
+    aws_byte_buf_clean_up(&rule->user_property_value);
+
+    if (aws_hash_table_is_valid(&rule->topic_states)) {
+        aws_hash_table_clean_up(&rule->topic_states);
+    }
+}
+
+void aws_napi_mqtt_message_filter_destroy(struct aws_napi_mqtt_message_filter *filter) {
+    if (filter == NULL) {
+        return;
+    }
+
+    if (aws_array_list_is_valid(&filter->rules)) {
+        size_t rule_count = aws_array_list_length(&filter->rules);
+        for (size_t i = 0; i < rule_count; ++i) {
+            struct aws_napi_mqtt_message_filter_rule *rule = NULL;
+            aws_array_list_get_at_ptr(&filter->rules, (void **)&rule, i);
+            s_rule_clean_up(rule);
+        }
+        aws_array_list_clean_up(&filter->rules);
+    }
+
+    aws_mem_release(filter->allocator, filter);
+}
+
+static void s_log_invalid_rule(size_t index, const char *message) {
+    AWS_LOGF_ERROR(
+        AWS_LS_NODEJS_CRT_GENERAL,
+        "aws_napi_mqtt_message_filter_new_from_napi - message filter rule %zu: %s",
+        index,
+        message);
+}
+
+static int s_init_rule_from_napi(
+    struct aws_allocator *allocator,
+    napi_env env,
+    napi_value node_rule,
+    size_t index,
+    struct aws_napi_mqtt_message_filter_rule *rule) {
+
+    if (aws_napi_get_named_property_as_bytebuf(
+            env, node_rule, AWS_NAPI_KEY_TOPIC_FILTER, napi_string, &rule->topic_filter) != AWS_NGNPR_VALID_VALUE) {
+        s_log_invalid_rule(index, "topicFilter is required and must be a string");
+        return aws_raise_error(AWS_ERROR_INVALID_ARGUMENT);
+    }
+
+    struct aws_byte_cursor topic_filter = aws_byte_cursor_from_buf(&rule->topic_filter);
+    if (!aws_mqtt_is_valid_topic_filter(&topic_filter)) {
+        s_log_invalid_rule(index, "topicFilter is not a valid topic filter");
+        return aws_raise_error(AWS_ERROR_INVALID_ARGUMENT);
+    }
+
+    if (aws_napi_get_named_property_as_boolean(env, node_rule, AWS_NAPI_KEY_DROP, &rule->drop) ==
+        AWS_NGNPR_INVALID_VALUE) {
+        s_log_invalid_rule(index, "drop must be a boolean");
+        return aws_raise_error(AWS_ERROR_INVALID_ARGUMENT);
+    }
+
+    bool retain = false;
+    switch (aws_napi_get_named_property_as_boolean(env, node_rule, AWS_NAPI_KEY_RETAIN, &retain)) {
+        case AWS_NGNPR_VALID_VALUE:
+            rule->retain = retain ? AWS_NAPI_MQTT_RP_RETAINED : AWS_NAPI_MQTT_RP_NOT_RETAINED;
+            break;
+
+        case AWS_NGNPR_INVALID_VALUE:
+            s_log_invalid_rule(index, "retain must be a boolean");
+            return aws_raise_error(AWS_ERROR_INVALID_ARGUMENT);
+
+        default:
+            rule->retain = AWS_NAPI_MQTT_RP_ANY;
+            break;
+    }
+
+    napi_value node_user_property = NULL;
+    switch (aws_napi_get_named_property(env, node_rule, AWS_NAPI_KEY_USER_PROPERTY, napi_object, &node_user_property)) {
+        case AWS_NGNPR_VALID_VALUE:
+            rule->has_user_property_predicate = true;
+            if (aws_napi_get_named_property_as_bytebuf(
+                    env, node_user_property, AWS_NAPI_KEY_NAME, napi_string, &rule->user_property_name) !=
+                AWS_NGNPR_VALID_VALUE) {
+                s_log_invalid_rule(index, "userProperty.name is required and must be a string");
+                return aws_raise_error(AWS_ERROR_INVALID_ARGUMENT);
+            }
+
+            switch (aws_napi_get_named_property_as_bytebuf(
+                env, node_user_property, AWS_NAPI_KEY_VALUE, napi_string, &rule->user_property_value)) {
+                case AWS_NGNPR_VALID_VALUE:
+                    rule->has_user_property_value = true;
+                    break;
+
+                case AWS_NGNPR_INVALID_VALUE:
+                    s_log_invalid_rule(index, "userProperty.value must be a string");
+                    return aws_raise_error(AWS_ERROR_INVALID_ARGUMENT);
+
+                default:
+                    break;
+            }
+            break;
+
+        case AWS_NGNPR_INVALID_VALUE:
+            s_log_invalid_rule(index, "userProperty must be an object");
+            return aws_raise_error(AWS_ERROR_INVALID_ARGUMENT);
+
+        default:
+            break;
+    }
+
+    if (aws_napi_get_named_property_as_uint32(env, node_rule, AWS_NAPI_KEY_SAMPLE_EVERY, &rule->sample_every) ==
+        AWS_NGNPR_INVALID_VALUE) {
+        s_log_invalid_rule(index, "sampleEvery must be a non-negative integer");
+        return aws_raise_error(AWS_ERROR_INVALID_ARGUMENT);
+    }
+
+    if (aws_napi_get_named_property_as_uint32(
+            env, node_rule, AWS_NAPI_KEY_MAX_MESSAGES_PER_SECOND, &rule->max_messages_per_second) ==
+        AWS_NGNPR_INVALID_VALUE) {
+        s_log_invalid_rule(index, "maxMessagesPerSecond must be a non-negative integer");
+        return aws_raise_error(AWS_ERROR_INVALID_ARGUMENT);
+    }
+
+    if (rule->sample_every > 1 || rule->max_messages_per_second > 0) {
+        if (aws_hash_table_init(
+                &rule->topic_states,
+                allocator,
+                16,
+                aws_hash_byte_cursor_ptr,
+                s_byte_cursor_ptr_eq,
+                NULL,
+                s_topic_state_destroy)) {
+            return AWS_OP_ERR;
+        }
+    }
+
+    return AWS_OP_SUCCESS;
+}
+
+struct aws_napi_mqtt_message_filter *aws_napi_mqtt_message_filter_new_from_napi(
+    struct aws_allocator *allocator,
+    napi_env env,
+    napi_value node_rules) {
+
+    bool is_array = false;
+    AWS_NAPI_CALL(env, napi_is_array(env, node_rules, &is_array), {
+        aws_raise_error(AWS_CRT_NODEJS_ERROR_NAPI_FAILURE);
+        return NULL;
+    });
+
+    if (!is_array) {
+        AWS_LOGF_ERROR(
+            AWS_LS_NODEJS_CRT_GENERAL, "aws_napi_mqtt_message_filter_new_from_napi - rules must be an array");
+        aws_raise_error(AWS_ERROR_INVALID_ARGUMENT);
+        return NULL;
+    }
+
+    uint32_t rule_count = 0;
+    AWS_NAPI_CALL(env, napi_get_array_length(env, node_rules, &rule_count), {
+        aws_raise_error(AWS_CRT_NODEJS_ERROR_NAPI_FAILURE);
+        return NULL;
+    });
+
+    struct aws_napi_mqtt_message_filter *filter =
+        aws_mem_calloc(allocator, 1, sizeof(struct aws_napi_mqtt_message_filter));
+    filter->allocator = allocator;
+
+    if (aws_array_list_init_dynamic(
+            &filter->rules, allocator, rule_count, sizeof(struct aws_napi_mqtt_message_filter_rule))) {
+        goto error;
+    }
+
+    for (uint32_t i = 0; i < rule_count; ++i) {
+        napi_value node_rule = NULL;
+        AWS_NAPI_CALL(env, napi_get_element(env, node_rules, i, &node_rule), {
+            aws_raise_error(AWS_CRT_NODEJS_ERROR_NAPI_FAILURE);
+            goto error;
+        });
+
+        struct aws_napi_mqtt_message_filter_rule rule;
+        AWS_ZERO_STRUCT(rule);
+
+        /* pushed before initialization so that a partially-initialized rule is cleaned up with the rest */
+        aws_array_list_push_back(&filter->rules, &rule);
+        struct aws_napi_mqtt_message_filter_rule *stored_rule = NULL;
+        aws_array_list_get_at_ptr(&filter->rules, (void **)&stored_rule, i);
+
+        if (s_init_rule_from_napi(allocator, env, node_rule, i, stored_rule)) {
+            goto error;
+        }
+    }
+
+    return filter;
+
+error:
+
+    aws_napi_mqtt_message_filter_destroy(filter);
+
+    return NULL;
+}
+
+static bool s_rule_accepts_user_properties(
+    const struct aws_napi_mqtt_message_filter_rule *rule,
+    const struct aws_mqtt5_user_property *user_properties,
+    size_t user_property_count) {
+
+    if (!rule->has_user_property_predicate) {
+        return true;
+    }
+
+    struct aws_byte_cursor name = aws_byte_cursor_from_buf(&rule->user_property_name);
+    struct aws_byte_cursor value = aws_byte_cursor_from_buf(&rule->user_property_value);
+
+    for (size_t i = 0; i < user_property_count; ++i) {
+        const struct aws_mqtt5_user_property *property = &user_properties[i];
+        if (!aws_byte_cursor_eq(&property->name, &name)) {
+            continue;
+        }
+
+        if (!rule->has_user_property_value || aws_byte_cursor_eq(&property->value, &value)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static struct aws_napi_mqtt_topic_state *s_get_topic_state(
+    struct aws_napi_mqtt_message_filter *filter,
+    struct aws_napi_mqtt_message_filter_rule *rule,
+    struct aws_byte_cursor topic,
+    uint64_t now_ns) {
+
+    struct aws_hash_element *element = NULL;
+    aws_hash_table_find(&rule->topic_states, &topic, &element);
+    if (element != NULL) {
+        return element->value;
+    }
+
+    if (aws_hash_table_get_entry_count(&rule->topic_states) >= AWS_NAPI_MQTT_MESSAGE_FILTER_MAX_TRACKED_TOPICS) {
+        aws_hash_table_clear(&rule->topic_states);
+    }
+
+    struct aws_napi_mqtt_topic_state *state =
+        aws_mem_calloc(filter->allocator, 1, sizeof(struct aws_napi_mqtt_topic_state));
+    if (aws_byte_buf_init_copy_from_cursor(&state->topic, filter->allocator, topic)) {
+        aws_mem_release(filter->allocator, state);
+        return NULL;
+    }
+
+    state->topic_cursor = aws_byte_cursor_from_buf(&state->topic);
+    state->budget = (uint64_t)rule->max_messages_per_second * NS_PER_SEC;
+    state->last_refill_ns = now_ns;
+
+    if (aws_hash_table_put(&rule->topic_states, &state->topic_cursor, state, NULL)) {
+        s_topic_state_destroy(state);
+        return NULL;
+    }
+
+    return state;
+}
+
+static bool s_topic_state_consume_budget(
+    struct aws_napi_mqtt_topic_state *state,
+    uint32_t max_messages_per_second,
+    uint64_t now_ns) {
+
+    uint64_t capacity = (uint64_t)max_messages_per_second * NS_PER_SEC;
+
+    /* a full second refills the bucket, so capping the elapsed time keeps the product in range */
+    uint64_t elapsed_ns = now_ns > state->last_refill_ns ? now_ns - state->last_refill_ns : 0;
+    if (elapsed_ns > NS_PER_SEC) {
+        elapsed_ns = NS_PER_SEC;
+    }
+
+    state->budget = aws_min_u64(capacity, state->budget + elapsed_ns * max_messages_per_second);
+    state->last_refill_ns = now_ns;
+
+    if (state->budget < NS_PER_SEC) {
+        return false;
+    }
+
+    state->budget -= NS_PER_SEC;
+    return true;
+}
+
+enum aws_napi_mqtt_message_filter_result aws_napi_mqtt_message_filter_evaluate(
+    struct aws_napi_mqtt_message_filter *filter,
+    struct aws_byte_cursor topic,
+    bool retain,
+    const struct aws_mqtt5_user_property *user_properties,
+    size_t user_property_count,
+    uint64_t now_ns) {
+
+    size_t rule_count = aws_array_list_length(&filter->rules);
+    for (size_t i = 0; i < rule_count; ++i) {
+        struct aws_napi_mqtt_message_filter_rule *rule = NULL;
+        aws_array_list_get_at_ptr(&filter->rules, (void **)&rule, i);
+
+        if (!aws_napi_mqtt_topic_matches_filter(topic, aws_byte_cursor_from_buf(&rule->topic_filter))) {
+            continue;
+        }
+
+        if (rule->drop) {
+            return AWS_NAPI_MQTT_MFR_FILTERED;
+        }
+
+        if ((rule->retain == AWS_NAPI_MQTT_RP_RETAINED && !retain) ||
+            (rule->retain == AWS_NAPI_MQTT_RP_NOT_RETAINED && retain)) {
+            return AWS_NAPI_MQTT_MFR_FILTERED;
+        }
+
+        if (!s_rule_accepts_user_properties(rule, user_properties, user_property_count)) {
+            return AWS_NAPI_MQTT_MFR_FILTERED;
+        }
+
+        if (!aws_hash_table_is_valid(&rule->topic_states)) {
+            return AWS_NAPI_MQTT_MFR_DELIVER;
+        }
+
+        /* if per-topic state can't be allocated, err on the side of delivering */
+        struct aws_napi_mqtt_topic_state *state = s_get_topic_state(filter, rule, topic, now_ns);
+        if (state == NULL) {
+            return AWS_NAPI_MQTT_MFR_DELIVER;
+        }
+
+        if (rule->sample_every > 1 && (state->seen_count++ % rule->sample_every) != 0) {
+            return AWS_NAPI_MQTT_MFR_SAMPLED_OUT;
+        }
+
+        if (rule->max_messages_per_second > 0 &&
+            !s_topic_state_consume_budget(state, rule->max_messages_per_second, now_ns)) {
+            return AWS_NAPI_MQTT_MFR_RATE_LIMITED;
+        }
+
+        return AWS_NAPI_MQTT_MFR_DELIVER;
+    }
+
+    return AWS_NAPI_MQTT_MFR_DELIVER;
+}
+
+void aws_napi_mqtt_message_filter_statistics_record(
+    struct aws_napi_mqtt_message_filter_statistics *statistics,
+    enum aws_napi_mqtt_message_filter_result result) {
+
+    switch (result) {
+        case AWS_NAPI_MQTT_MFR_FILTERED:
+            ++statistics->filtered_count;
+            break;
+
+        case AWS_NAPI_MQTT_MFR_SAMPLED_OUT:
+            ++statistics->sampled_out_count;
+            break;
+
+        case AWS_NAPI_MQTT_MFR_RATE_LIMITED:
+            ++statistics->rate_limited_count;
+            break;
+
+        default:
+            break;
+    }
+}
@@ -0,0 +1,71 @@
+/**
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0.
+ */
+
+#ifndef AWS_CRT_NODEJS_MQTT_MESSAGE_FILTER_H
+#define AWS_CRT_NODEJS_MQTT_MESSAGE_FILTER_H
+
+#include "module.h"
+
+struct aws_mqtt5_user_property;
+
+/*
+ * Declarative filtering and sampling of received publishes, evaluated before a message is copied for delivery to node.
+ *
+ * A filter is an ordered list of rules.  The first rule whose topic filter matches a message's topic decides its fate;
+ * messages matching no rule are delivered.  A matching rule drops the message if:
+ *   (1) the rule drops everything, or the message fails the rule's retain flag or user property predicates
+ *   (2) sampling is configured and the message is not the first of every N seen on its topic
+ *   (3) a rate limit is configured and the message's topic has used up its per-second budget
+ *
+ * Sampling and rate limit state is kept per distinct topic, up to a fixed number of topics per rule; when a rule
+ * exceeds that, its per-topic state is reset.
+ *
+ * Not thread-safe; the caller serializes access.
+ */
+struct aws_napi_mqtt_message_filter;
+
+enum aws_napi_mqtt_message_filter_result {
+    AWS_NAPI_MQTT_MFR_DELIVER,
+    AWS_NAPI_MQTT_MFR_FILTERED,
+    AWS_NAPI_MQTT_MFR_SAMPLED_OUT,
+    AWS_NAPI_MQTT_MFR_RATE_LIMITED,
+};
+
+/* Counts of messages dropped by a filter, by reason */
+struct aws_napi_mqtt_message_filter_statistics {
+    uint64_t filtered_count;
+    uint64_t sampled_out_count;
+    uint64_t rate_limited_count;
+};
+
+/*
+ * Builds a filter from an array of node rule objects (MessageFilterRule in lib/common/mqtt_shared.ts).  Returns NULL
+ * and raises an error if the rules are invalid.
+ */
+struct aws_napi_mqtt_message_filter *aws_napi_mqtt_message_filter_new_from_napi(
+    struct aws_allocator *allocator,
+    napi_env env,
+    napi_value node_rules);
+
+void aws_napi_mqtt_message_filter_destroy(struct aws_napi_mqtt_message_filter *filter);
+
+/* user_properties may be NULL for MQTT 3.1.1 messages, which never satisfy a user property predicate */
+enum aws_napi_mqtt_message_filter_result aws_napi_mqtt_message_filter_evaluate(
+    struct aws_napi_mqtt_message_filter *filter,
+    struct aws_byte_cursor topic,
+    bool retain,
+    const struct aws_mqtt5_user_property *user_properties,
+    size_t user_property_count,
+    uint64_t now_ns);
+
+/* Adds a result to a set of drop counters */
+void aws_napi_mqtt_message_filter_statistics_record(
+    struct aws_napi_mqtt_message_filter_statistics *statistics,
+    enum aws_napi_mqtt_message_filter_result result);
+
+/* MQTT topic filter matching; wildcards at the first level never match topics starting with '$' */
+bool aws_napi_mqtt_topic_matches_filter(struct aws_byte_cursor topic, struct aws_byte_cursor filter);
+
+#endif /* AWS_CRT_NODEJS_MQTT_MESSAGE_FILTER_H */
@@ -0,0 +1,142 @@
+/**
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0.
+ */
+
+#include "mqtt_topic_intern_cache.h"
+
+#include <aws/common/linked_hash_table.h>
+
+/* One interned topic; the topic bytes follow the struct in the same allocation */
+struct aws_napi_mqtt_interned_topic {
+    struct aws_napi_mqtt_topic_intern_cache *cache;
+    struct aws_byte_cursor topic;
+    napi_ref string_ref;
+};
+
+struct aws_napi_mqtt_topic_intern_cache {
+    struct aws_allocator *allocator;
+    napi_env env;
+    size_t max_topic_count;
+
+    /* topic cursor -> struct aws_napi_mqtt_interned_topic, least recently used first */
+    struct aws_linked_hash_table topics;
+};
+
+static bool s_byte_cursor_ptr_eq(const void *a, const void *b) {
+    return aws_byte_cursor_eq(a, b);
+}
+
+static void s_interned_topic_destroy(void *value) {
+    struct aws_napi_mqtt_interned_topic *interned = value;
+    struct aws_napi_mqtt_topic_intern_cache *cache = interned->cache;
+
+    if (interned->string_ref != NULL) {
+        napi_delete_reference(cache->env, interned->string_ref);
+    }
+
+    aws_mem_release(cache->allocator, interned);
+}
+
+struct aws_napi_mqtt_topic_intern_cache *aws_napi_mqtt_topic_intern_cache_new(
+    struct aws_allocator *allocator,
+    napi_env env,
+    size_t max_topic_count) {
+
+    AWS_FATAL_ASSERT(max_topic_count > 0);
+
+    struct aws_napi_mqtt_topic_intern_cache *cache =
+        aws_mem_calloc(allocator, 1, sizeof(struct aws_napi_mqtt_topic_intern_cache));
+    cache->allocator = allocator;
+    cache->env = env;
+    cache->max_topic_count = max_topic_count;
+
+    if (aws_linked_hash_table_init(
+            &cache->topics,
+            allocator,
+            aws_hash_byte_cursor_ptr,
+            s_byte_cursor_ptr_eq,
+            NULL,
+            s_interned_topic_destroy,
+            max_topic_count < 64 ? max_topic_count : 64)) {
+        aws_mem_release(allocator, cache);
+        return NULL;
+    }
+
+    return cache;
+}
+
+void aws_napi_mqtt_topic_intern_cache_destroy(struct aws_napi_mqtt_topic_intern_cache *cache) {
+    if (cache == NULL) {
+        return;
+    }
+
+    aws_linked_hash_table_clean_up(&cache->topics);
+
+    aws_mem_release(cache->allocator, cache);
+}
+
+napi_status aws_napi_mqtt_topic_intern_cache_get(
+    struct aws_napi_mqtt_topic_intern_cache *cache,
+    struct aws_byte_cursor topic,
+    napi_value *result) {
+
+    napi_env env = cache->env;
+
+    struct aws_napi_mqtt_interned_topic *interned = NULL;
+    if (aws_linked_hash_table_find_and_move_to_back(&cache->topics, &topic, (void **)&interned) == AWS_OP_SUCCESS &&
+        interned != NULL) {
+        return napi_get_reference_value(env, interned->string_ref, result);
+    }
+
+    napi_status status = napi_create_string_utf8(env, (const char *)topic.ptr, topic.len, result);
+    if (status != napi_ok) {
+        return status;
+    }
+
+    interned = aws_mem_calloc(cache->allocator, 1, sizeof(struct aws_napi_mqtt_interned_topic) + topic.len);
+    interned->cache = cache;
+
+    uint8_t *topic_storage = (uint8_t *)(interned + 1);
+    if (topic.len > 0) {
+        memcpy(topic_storage, topic.ptr, topic.len);
+    }
+    interned->topic = aws_byte_cursor_from_array(topic_storage, topic.len);
+
+    status = napi_create_reference(env, *result, 1, &interned->string_ref);
+    if (status != napi_ok) {
+        s_interned_topic_destroy(interned);
+        return status;
+    }
+
+    if (aws_linked_hash_table_put(&cache->topics, &interned->topic, interned)) {
+        /* the string is still perfectly usable, it just won't be shared */
+        s_interned_topic_destroy(interned);
+        return napi_ok;
+    }
+
+    const struct aws_linked_list *lru_list = aws_linked_hash_table_get_element_list(&cache->topics);
+    while (aws_linked_hash_table_get_element_count(&cache->topics) > cache->max_topic_count) {
+        struct aws_linked_hash_table_node *node =
+            AWS_CONTAINER_OF(aws_linked_list_front(lru_list), struct aws_linked_hash_table_node, node);
+        struct aws_napi_mqtt_interned_topic *evicted = node->value;
+
+        /* destroys the entry, and with it the key */
+        aws_linked_hash_table_remove(&cache->topics, &evicted->topic);
+    }
+
+    return napi_ok;
+}
+
+napi_status aws_napi_mqtt_create_topic_string(
+    napi_env env,
+    struct aws_napi_mqtt_topic_intern_cache *cache,
+    struct aws_byte_cursor topic,
+    napi_value *result) {
+
+    if (cache != NULL) {
+        return aws_napi_mqtt_topic_intern_cache_get(cache, topic, result);
+    }
+
+    return napi_create_string_utf8(env, (const char *)topic.ptr, topic.len, result);
+}
@@ -0,0 +1,43 @@
+/**
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0.
+ */
+
+#ifndef AWS_CRT_NODEJS_MQTT_TOPIC_INTERN_CACHE_H
+#define AWS_CRT_NODEJS_MQTT_TOPIC_INTERN_CACHE_H
+
+#include "module.h"
+
+/*
+ * Node strings for recently received topics, held by persistent references so that a topic seen again is delivered
+ * as the very same string instead of a fresh allocation.  Bounded by a topic count; the least recently used topic is
+ * evicted when a new one would exceed it.
+ *
+ * Holds node references, so it may only be used and destroyed on node's thread.
+ */
+struct aws_napi_mqtt_topic_intern_cache;
+
+struct aws_napi_mqtt_topic_intern_cache *aws_napi_mqtt_topic_intern_cache_new(
+    struct aws_allocator *allocator,
+    napi_env env,
+    size_t max_topic_count);
+
+void aws_napi_mqtt_topic_intern_cache_destroy(struct aws_napi_mqtt_topic_intern_cache *cache);
+
+/* Returns the interned string for a topic, creating and caching it if necessary */
+napi_status aws_napi_mqtt_topic_intern_cache_get(
+    struct aws_napi_mqtt_topic_intern_cache *cache,
+    struct aws_byte_cursor topic,
+    napi_value *result);
+
+/*
+ * Creates a node string for a topic, through the cache if there is one.  Convenience for delivery paths where the
+ * cache is optional or may already be gone.
+ */
+napi_status aws_napi_mqtt_create_topic_string(
+    napi_env env,
+    struct aws_napi_mqtt_topic_intern_cache *cache,
+    struct aws_byte_cursor topic,
+    napi_value *result);
+
+#endif /* AWS_CRT_NODEJS_MQTT_TOPIC_INTERN_CACHE_H */
@@ -0,0 +1,144 @@
+/**
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0.
+ */
+
+#include "shared_ring.h"
+
+#include <aws/common/byte_buf.h>
+
+#ifdef _MSC_VER
+#    include <intrin.h>
+#endif /* _MSC_VER */
+
+enum aws_napi_shared_ring_control_word {
+    AWS_NAPI_SRCW_WRITE_POSITION = 0,
+    AWS_NAPI_SRCW_READ_POSITION = 1,
+    AWS_NAPI_SRCW_CONSUMER_WAITING = 2,
+    AWS_NAPI_SRCW_DROPPED_RECORDS = 3,
+};
+
+/*
+ * The consumer uses Atomics, which are sequentially consistent; these must be too.  In particular, the producer's
+ * store of the write position followed by its load of the waiting flag must not be reordered, or a wakeup could be
+ * lost against the consumer's store of the flag followed by its load of the write position.
+ */
+#ifdef _MSC_VER
+static uint32_t s_atomic_load(volatile uint32_t *word) {
+    return (uint32_t)_InterlockedOr((volatile long *)word, 0);
+}
+
+static void s_atomic_store(volatile uint32_t *word, uint32_t value) {
+    _InterlockedExchange((volatile long *)word, (long)value);
+}
+
+static uint32_t s_atomic_exchange(volatile uint32_t *word, uint32_t value) {
+    return (uint32_t)_InterlockedExchange((volatile long *)word, (long)value);
+}
+
+static void s_atomic_increment(volatile uint32_t *word) {
+    _InterlockedIncrement((volatile long *)word);
+}
+#else
+static uint32_t s_atomic_load(volatile uint32_t *word) {
+    return __atomic_load_n(word, __ATOMIC_SEQ_CST);
+}
+
+static void s_atomic_store(volatile uint32_t *word, uint32_t value) {
+    __atomic_store_n(word, value, __ATOMIC_SEQ_CST);
+}
+
+static uint32_t s_atomic_exchange(volatile uint32_t *word, uint32_t value) {
+    return __atomic_exchange_n(word, value, __ATOMIC_SEQ_CST);
+}
+
+static void s_atomic_increment(volatile uint32_t *word) {
+    __atomic_add_fetch(word, 1, __ATOMIC_SEQ_CST);
+}
+#endif /* _MSC_VER */
+
+static size_t s_align_record(size_t size) {
+    return (size + 3) & ~(size_t)3;
+}
+
+int aws_napi_shared_ring_init(struct aws_napi_shared_ring *ring, uint8_t *memory, size_t memory_size) {
+    AWS_ZERO_STRUCT(*ring);
+
+    if (memory == NULL || ((uintptr_t)memory & 3) != 0 || memory_size < AWS_NAPI_SHARED_RING_HEADER_SIZE) {
+        return aws_raise_error(AWS_ERROR_INVALID_ARGUMENT);
+    }
+
+    size_t capacity = memory_size - AWS_NAPI_SHARED_RING_HEADER_SIZE;
+
+    /* positions are free-running u32s, so the capacity must divide 2^32 */
+    if (capacity < AWS_NAPI_SHARED_RING_MIN_CAPACITY || capacity > ((size_t)1 << 30) ||
+        (capacity & (capacity - 1)) != 0) {
+        return aws_raise_error(AWS_ERROR_INVALID_ARGUMENT);
+    }
+
+    ring->control = (volatile uint32_t *)memory;
+    ring->data = memory + AWS_NAPI_SHARED_RING_HEADER_SIZE;
+    ring->capacity = capacity;
+
+    s_atomic_store(&ring->control[AWS_NAPI_SRCW_WRITE_POSITION], 0);
+    s_atomic_store(&ring->control[AWS_NAPI_SRCW_READ_POSITION], 0);
+    s_atomic_store(&ring->control[AWS_NAPI_SRCW_CONSUMER_WAITING], 1);
+    s_atomic_store(&ring->control[AWS_NAPI_SRCW_DROPPED_RECORDS], 0);
+
+    return AWS_OP_SUCCESS;
+}
+
+int aws_napi_shared_ring_reserve(
+    struct aws_napi_shared_ring *ring,
+    size_t record_size,
+    struct aws_byte_buf *record_out) {
+
+    uint32_t write_position = s_atomic_load(&ring->control[AWS_NAPI_SRCW_WRITE_POSITION]);
+    uint32_t read_position = s_atomic_load(&ring->control[AWS_NAPI_SRCW_READ_POSITION]);
+
+    size_t used = (uint32_t)(write_position - read_position);
+    size_t entry_size = 4 + s_align_record(record_size);
+    size_t offset = write_position & (ring->capacity - 1);
+
+    /* a record never straddles the end of the data region; the remainder is skipped instead */
+    size_t padding = 0;
+    if (entry_size > ring->capacity - offset) {
+        padding = ring->capacity - offset;
+    }
+
+    if (entry_size > ring->capacity || padding + entry_size > ring->capacity - used) {
+        return aws_raise_error(AWS_ERROR_SHORT_BUFFER);
+    }
+
+    if (padding > 0) {
+        struct aws_byte_buf marker = aws_byte_buf_from_empty_array(ring->data + offset, padding);
+        aws_byte_buf_write_be32(&marker, AWS_NAPI_SHARED_RING_WRAP_MARKER);
+        offset = 0;
+    }
+
+    ring->pending_write_position = write_position + (uint32_t)(padding + entry_size);
+    ring->pending_record = ring->data + offset;
+    ring->pending_record_size = record_size;
+
+    *record_out = aws_byte_buf_from_empty_array(ring->pending_record + 4, record_size);
+
+    return AWS_OP_SUCCESS;
+}
+
+bool aws_napi_shared_ring_commit(struct aws_napi_shared_ring *ring) {
+    AWS_FATAL_ASSERT(ring->pending_record != NULL);
+
+    struct aws_byte_buf length = aws_byte_buf_from_empty_array(ring->pending_record, 4);
+    aws_byte_buf_write_be32(&length, (uint32_t)ring->pending_record_size);
+
+    s_atomic_store(&ring->control[AWS_NAPI_SRCW_WRITE_POSITION], ring->pending_write_position);
+
+    ring->pending_record = NULL;
+    ring->pending_record_size = 0;
+
+    return s_atomic_exchange(&ring->control[AWS_NAPI_SRCW_CONSUMER_WAITING], 0) != 0;
+}
+
+void aws_napi_shared_ring_record_drop(struct aws_napi_shared_ring *ring) {
+    s_atomic_increment(&ring->control[AWS_NAPI_SRCW_DROPPED_RECORDS]);
+}
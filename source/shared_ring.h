@@ -0,0 +1,65 @@
+/**
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0.
+ */
+
+#ifndef AWS_CRT_NODEJS_SHARED_RING_H
+#define AWS_CRT_NODEJS_SHARED_RING_H
+
+#include "module.h"
+
+/*
+ * A byte ring living in memory shared with JavaScript (a SharedArrayBuffer).  Native producers append records and
+ * a single JS consumer reads them with Atomics; the consumer only needs to be woken when the ring goes from empty to
+ * non-empty.  SharedMessageRing in lib/native/mqtt5.ts is the consumer side and must agree with this layout.
+ *
+ * The shared memory starts with AWS_NAPI_SHARED_RING_HEADER_SIZE bytes of native-endian int32 control words:
+ *
+ *   [0] write position - free-running byte count, advanced by producers
+ *   [1] read position - free-running byte count, advanced by the consumer
+ *   [2] consumer waiting - set by the consumer once it has drained the ring, cleared by the producer that wakes it
+ *   [3] dropped records - records that did not fit
+ *
+ * followed by the data region, whose size must be a power of two.  Each record is a big-endian u32 length followed
+ * by that many bytes, padded to a 4-byte boundary.  A length of AWS_NAPI_SHARED_RING_WRAP_MARKER means the rest of
+ * the data region is unused and the next record starts at its beginning.
+ *
+ * Producers must be serialized by the caller; the ring itself does no locking.
+ */
+#define AWS_NAPI_SHARED_RING_HEADER_SIZE 64
+#define AWS_NAPI_SHARED_RING_MIN_CAPACITY 4096
+#define AWS_NAPI_SHARED_RING_WRAP_MARKER 0xFFFFFFFF
+
+struct aws_napi_shared_ring {
+    volatile uint32_t *control;
+    uint8_t *data;
+    size_t capacity;
+
+    /* write position to publish on commit, valid between reserve and commit */
+    uint32_t pending_write_position;
+    uint8_t *pending_record;
+    size_t pending_record_size;
+};
+
+/* Binds a ring to shared memory of the given total size; the memory must outlive the ring's use */
+int aws_napi_shared_ring_init(struct aws_napi_shared_ring *ring, uint8_t *memory, size_t memory_size);
+
+/*
+ * Reserves contiguous space for a record of record_size bytes and points record_out at it.  Fails with
+ * AWS_ERROR_SHORT_BUFFER if the consumer has not freed enough space; nothing is written in that case.
+ */
+int aws_napi_shared_ring_reserve(
+    struct aws_napi_shared_ring *ring,
+    size_t record_size,
+    struct aws_byte_buf *record_out);
+
+/*
+ * Makes the reserved record visible to the consumer.  Returns true if the consumer was waiting and must be woken by
+ * the caller.
+ */
+bool aws_napi_shared_ring_commit(struct aws_napi_shared_ring *ring);
+
+/* Counts a record that was not delivered so the consumer can report it */
+void aws_napi_shared_ring_record_drop(struct aws_napi_shared_ring *ring);
+
+#endif /* AWS_CRT_NODEJS_SHARED_RING_H */
@@ -0,0 +1,1044 @@
+/**
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0.
+ */
+
+/*
+ * A minimal in-process MQTT broker for offline tests and benchmarks.
+ *
+ * Speaks MQTT 3.1.1 and MQTT 5 over plain TCP or websockets and supports QoS 0 and 1 (inbound QoS 2 is
+ * acknowledged and delivered at QoS 1), retained messages, + and # wildcards, and $share/<group>/<filter> shared
+ * subscriptions.
+ * Sessions are never persisted, outbound QoS 1 publishes are not retransmitted, and there is no authentication;
+ * websocket handshake requests are recorded so that tests can check how they were signed.
+ * Latency and message loss can be injected at runtime through latencyMs and dropRate.
+ */
+
+import * as crypto from "crypto";
+import * as net from "net";
+
+enum PacketType {
+    Connect = 1,
+    Connack = 2,
+    Publish = 3,
+    Puback = 4,
+    Pubrec = 5,
+    Pubrel = 6,
+    Pubcomp = 7,
+    Subscribe = 8,
+    Suback = 9,
+    Unsubscribe = 10,
+    Unsuback = 11,
+    Pingreq = 12,
+    Pingresp = 13,
+    Disconnect = 14,
+}
+
+const PROTOCOL_LEVEL_311 : number = 4;
+const PROTOCOL_LEVEL_5 : number = 5;
+
+/* MQTT5 property identifiers that the broker reads or writes */
+const PROPERTY_SUBSCRIPTION_IDENTIFIER : number = 0x0B;
+const PROPERTY_ASSIGNED_CLIENT_IDENTIFIER : number = 0x12;
+const PROPERTY_TOPIC_ALIAS_MAXIMUM : number = 0x22;
+const PROPERTY_TOPIC_ALIAS : number = 0x23;
+const PROPERTY_MAXIMUM_QOS : number = 0x24;
+const PROPERTY_RETAIN_AVAILABLE : number = 0x25;
+const PROPERTY_WILDCARD_SUBSCRIPTIONS_AVAILABLE : number = 0x28;
+const PROPERTY_SUBSCRIPTION_IDENTIFIERS_AVAILABLE : number = 0x29;
+const PROPERTY_SHARED_SUBSCRIPTIONS_AVAILABLE : number = 0x2A;
+
+const TOPIC_ALIAS_MAXIMUM : number = 16;
+const DISCONNECT_WITH_WILL_MESSAGE : number = 0x04;
+
+/* RFC 6455 constants */
+const WEBSOCKET_ACCEPT_GUID : string = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+const WEBSOCKET_OPCODE_CONTINUATION : number = 0x0;
+const WEBSOCKET_OPCODE_TEXT : number = 0x1;
+const WEBSOCKET_OPCODE_BINARY : number = 0x2;
+const WEBSOCKET_OPCODE_CLOSE : number = 0x8;
+const WEBSOCKET_OPCODE_PING : number = 0x9;
+const WEBSOCKET_OPCODE_PONG : number = 0xA;
+const WEBSOCKET_MAX_HANDSHAKE_SIZE : number = 16 * 1024;
+
+enum PropertyType {
+    Byte,
+    TwoByteInteger,
+    FourByteInteger,
+    VariableByteInteger,
+    String,
+    Binary,
+    StringPair,
+}
+
+const PROPERTY_TYPES : Map<number, PropertyType> = new Map([
+    [0x01, PropertyType.Byte], [0x02, PropertyType.FourByteInteger], [0x03, PropertyType.String],
+    [0x08, PropertyType.String], [0x09, PropertyType.Binary], [0x0B, PropertyType.VariableByteInteger],
+    [0x11, PropertyType.FourByteInteger], [0x12, PropertyType.String], [0x13, PropertyType.TwoByteInteger],
+    [0x15, PropertyType.String], [0x16, PropertyType.Binary], [0x17, PropertyType.Byte],
+    [0x18, PropertyType.FourByteInteger], [0x19, PropertyType.Byte], [0x1A, PropertyType.String],
+    [0x1C, PropertyType.String], [0x1F, PropertyType.String], [0x21, PropertyType.TwoByteInteger],
+    [0x22, PropertyType.TwoByteInteger], [0x23, PropertyType.TwoByteInteger], [0x24, PropertyType.Byte],
+    [0x25, PropertyType.Byte], [0x26, PropertyType.StringPair], [0x27, PropertyType.FourByteInteger],
+    [0x28, PropertyType.Byte], [0x29, PropertyType.Byte], [0x2A, PropertyType.Byte],
+]);
+
+class MalformedPacketError extends Error {}
+
+/* Sequential reader over the variable header and payload of one packet */
+class PacketReader {
+    constructor(private buffer: Buffer, public offset: number = 0) {}
+
+    get remaining() : number { return this.buffer.length - this.offset; }
+
+    private require(length: number) {
+        if (this.remaining < length) {
+            throw new MalformedPacketError("packet too short");
+        }
+    }
+
+    readByte() : number {
+        this.require(1);
+        return this.buffer.readUInt8(this.offset++);
+    }
+
+    readUInt16() : number {
+        this.require(2);
+        let value : number = this.buffer.readUInt16BE(this.offset);
+        this.offset += 2;
+        return value;
+    }
+
+    readUInt32() : number {
+        this.require(4);
+        let value : number = this.buffer.readUInt32BE(this.offset);
+        this.offset += 4;
+        return value;
+    }
+
+    readVariableByteInteger() : number {
+        let value : number = 0;
+        for (let shift = 0; shift < 28; shift += 7) {
+            let byte : number = this.readByte();
+            value += (byte & 0x7F) * Math.pow(2, shift);
+            if ((byte & 0x80) == 0) {
+                return value;
+            }
+        }
+
+        throw new MalformedPacketError("variable byte integer too long");
+    }
+
+    readBytes(length: number) : Buffer {
+        this.require(length);
+        let value : Buffer = this.buffer.subarray(this.offset, this.offset + length);
+        this.offset += length;
+        return value;
+    }
+
+    readBinary() : Buffer {
+        return this.readBytes(this.readUInt16());
+    }
+
+    readString() : string {
+        return this.readBinary().toString('utf8');
+    }
+
+    readRest() : Buffer {
+        return this.readBytes(this.remaining);
+    }
+
+    /* Returns each property's id and its raw encoding (id included) so properties can be forwarded untouched */
+    readProperties() : Array<RawProperty> {
+        let end : number = this.offset + this.readVariableByteInteger();
+        if (end > this.buffer.length) {
+            throw new MalformedPacketError("properties overflow packet");
+        }
+
+        let properties : Array<RawProperty> = [];
+        while (this.offset < end) {
+            let start : number = this.offset;
+            let id : number = this.readVariableByteInteger();
+            let value : number = 0;
+
+            switch (PROPERTY_TYPES.get(id)) {
+                case PropertyType.Byte: value = this.readByte(); break;
+                case PropertyType.TwoByteInteger: value = this.readUInt16(); break;
+                case PropertyType.FourByteInteger: value = this.readUInt32(); break;
+                case PropertyType.VariableByteInteger: value = this.readVariableByteInteger(); break;
+                case PropertyType.String: case PropertyType.Binary: this.readBinary(); break;
+                case PropertyType.StringPair: this.readBinary(); this.readBinary(); break;
+                default: throw new MalformedPacketError(`unknown property ${id}`);
+            }
+
+            properties.push({ id: id, value: value, encoding: this.buffer.subarray(start, this.offset) });
+        }
+
+        if (this.offset != end) {
+            throw new MalformedPacketError("property length mismatch");
+        }
+
+        return properties;
+    }
+}
+
+interface RawProperty {
+    id: number;
+    value: number;
+    encoding: Buffer;
+}
+
+function encodeVariableByteInteger(value: number) : Buffer {
+    let bytes : Array<number> = [];
+    do {
+        let byte : number = value % 128;
+        value = Math.floor(value / 128);
+        bytes.push(value > 0 ? byte | 0x80 : byte);
+    } while (value > 0);
+
+    return Buffer.from(bytes);
+}
+
+function encodeUInt16(value: number) : Buffer {
+    let buffer : Buffer = Buffer.alloc(2);
+    buffer.writeUInt16BE(value);
+    return buffer;
+}
+
+function encodeString(value: string | Buffer) : Buffer {
+    let bytes : Buffer = typeof value === "string" ? Buffer.from(value, 'utf8') : value;
+    return Buffer.concat([encodeUInt16(bytes.length), bytes]);
+}
+
+function encodeProperties(properties: Array<Buffer>) : Buffer {
+    let body : Buffer = Buffer.concat(properties);
+    return Buffer.concat([encodeVariableByteInteger(body.length), body]);
+}
+
+function encodePacket(firstByte: number, parts: Array<Buffer>) : Buffer {
+    let body : Buffer = Buffer.concat(parts);
+    return Buffer.concat([Buffer.from([firstByte]), encodeVariableByteInteger(body.length), body]);
+}
+
+/* Server frames are never masked and never fragmented */
+function encodeWebsocketFrame(opcode: number, payload: Buffer) : Buffer {
+    let header : Buffer;
+    if (payload.length < 126) {
+        header = Buffer.from([0x80 | opcode, payload.length]);
+    } else if (payload.length <= 0xFFFF) {
+        header = Buffer.alloc(4);
+        header[0] = 0x80 | opcode;
+        header[1] = 126;
+        header.writeUInt16BE(payload.length, 2);
+    } else {
+        header = Buffer.alloc(10);
+        header[0] = 0x80 | opcode;
+        header[1] = 127;
+        header.writeBigUInt64BE(BigInt(payload.length), 2);
+    }
+
+    return Buffer.concat([header, payload]);
+}
+
+/* True if a topic filter is well-formed: wildcards occupy whole levels and # only appears last */
+function isValidTopicFilter(filter: string) : boolean {
+    if (filter.length == 0) {
+        return false;
+    }
+
+    let levels : Array<string> = filter.split('/');
+    for (let i = 0; i < levels.length; i++) {
+        let level : string = levels[i];
+        if (level.includes('#') && (level != '#' || i != levels.length - 1)) {
+            return false;
+        }
+        if (level.includes('+') && level != '+') {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+function topicMatchesFilter(topic: string, filter: string) : boolean {
+    let topicLevels : Array<string> = topic.split('/');
+    let filterLevels : Array<string> = filter.split('/');
+
+    /* wildcards at the first level never match topics reserved by the server */
+    if (topic.startsWith('$') && (filterLevels[0] == '+' || filterLevels[0] == '#')) {
+        return false;
+    }
+
+    for (let i = 0; i < filterLevels.length; i++) {
+        if (filterLevels[i] == '#') {
+            return true;
+        }
+
+        if (i >= topicLevels.length || (filterLevels[i] != '+' && filterLevels[i] != topicLevels[i])) {
+            return false;
+        }
+    }
+
+    return topicLevels.length == filterLevels.length;
+}
+
+interface Subscription {
+    connection: BrokerConnection;
+    filter: string;
+    qos: number;
+    noLocal: boolean;
+    retainAsPublished: boolean;
+}
+
+interface SharedSubscriptionGroup {
+    filter: string;
+    members: Array<Subscription>;
+    next: number;
+}
+
+interface BrokerMessage {
+    topic: string;
+    payload: Buffer;
+    qos: number;
+    retain: boolean;
+
+    /* MQTT5 properties to forward, already stripped of connection-scoped properties like topic aliases */
+    properties: Array<Buffer>;
+}
+
+/**
+ * A websocket upgrade request as the broker received it
+ */
+export interface LocalMqttBrokerWebsocketHandshake {
+
+    /**
+     * Request path, including any query string
+     */
+    path: string;
+
+    /**
+     * Request headers, keyed by lower case name
+     */
+    headers: Map<string, string>;
+}
+
+/**
+ * Counters describing what the broker has done since it started
+ */
+export interface LocalMqttBrokerStatistics {
+    connections: number;
+    publishesReceived: number;
+    publishesDelivered: number;
+    publishesDropped: number;
+}
+
+/**
+ * Configuration for a {@link LocalMqttBroker}
+ */
+export interface LocalMqttBrokerOptions {
+
+    /**
+     * Port to listen on.  Defaults to 0, which picks a free port.
+     */
+    port?: number;
+
+    /**
+     * Address to listen on.  Defaults to 127.0.0.1.
+     */
+    host?: string;
+}
+
+class BrokerConnection {
+    protocolLevel : number = 0;
+    clientId : string = "";
+    isConnected : boolean = false;
+
+    private pending : Buffer = Buffer.alloc(0);
+
+    /* undefined until the first bytes show whether the client opened with a websocket upgrade */
+    private isWebsocket? : boolean;
+    private isWebsocketUpgraded : boolean = false;
+    private pendingWebsocket : Buffer = Buffer.alloc(0);
+    private nextPacketId : number = 1;
+    private inboundTopicAliases : Map<number, string> = new Map();
+    private will? : BrokerMessage;
+
+    constructor(private broker: LocalMqttBroker, readonly socket: net.Socket) {
+        socket.setNoDelay(true);
+        socket.on('data', (data: Buffer) => { this.onSocketData(data); });
+        socket.on('close', () => { this.onClose(); });
+        socket.on('error', () => { socket.destroy(); });
+    }
+
+    get isMqtt5() : boolean { return this.protocolLevel == PROTOCOL_LEVEL_5; }
+
+    send(packet: Buffer) {
+        if (!this.socket.destroyed) {
+            this.socket.write(this.isWebsocket ? encodeWebsocketFrame(WEBSOCKET_OPCODE_BINARY, packet) : packet);
+        }
+    }
+
+    close() {
+        this.will = undefined;
+        this.socket.destroy();
+    }
+
+    /* Encodes and sends a publish to this connection, downgrading its QoS to the subscription's */
+    deliver(message: BrokerMessage, qos: number, retain: boolean) {
+        let firstByte : number = (PacketType.Publish << 4) | (qos << 1) | (retain ? 1 : 0);
+        let parts : Array<Buffer> = [encodeString(message.topic)];
+
+        if (qos > 0) {
+            parts.push(encodeUInt16(this.allocatePacketId()));
+        }
+
+        if (this.isMqtt5) {
+            parts.push(encodeProperties(message.properties));
+        }
+
+        parts.push(message.payload);
+        this.send(encodePacket(firstByte, parts));
+    }
+
+    private allocatePacketId() : number {
+        let packetId : number = this.nextPacketId;
+        this.nextPacketId = (this.nextPacketId % 65535) + 1;
+        return packetId;
+    }
+
+    private onSocketData(data: Buffer) {
+        if (this.isWebsocket === undefined) {
+            /* a CONNECT packet starts with 0x10, so it can never be mistaken for an http request */
+            this.isWebsocket = data[0] == 'G'.charCodeAt(0);
+        }
+
+        if (!this.isWebsocket) {
+            this.onData(data);
+            return;
+        }
+
+        this.pendingWebsocket = this.pendingWebsocket.length > 0 ? Buffer.concat([this.pendingWebsocket, data]) : data;
+
+        try {
+            if (!this.isWebsocketUpgraded && !this.onWebsocketHandshake()) {
+                return;
+            }
+
+            this.onWebsocketFrames();
+        } catch (e) {
+            this.socket.destroy();
+        }
+    }
+
+    /* Answers the upgrade request once all of it has arrived; returns false while still waiting for more */
+    private onWebsocketHandshake() : boolean {
+        let end : number = this.pendingWebsocket.indexOf("\r\n\r\n");
+        if (end < 0) {
+            if (this.pendingWebsocket.length > WEBSOCKET_MAX_HANDSHAKE_SIZE) {
+                throw new MalformedPacketError("websocket handshake too large");
+            }
+            return false;
+        }
+
+        let lines : Array<string> = this.pendingWebsocket.subarray(0, end).toString('latin1').split("\r\n");
+        this.pendingWebsocket = this.pendingWebsocket.subarray(end + 4);
+
+        let requestLine : Array<string> = lines[0].split(' ');
+        if (requestLine.length != 3 || requestLine[0] != "GET") {
+            throw new MalformedPacketError("websocket handshake must be a GET request");
+        }
+
+        let headers : Map<string, string> = new Map();
+        for (let line of lines.slice(1)) {
+            let separator : number = line.indexOf(':');
+            if (separator > 0) {
+                headers.set(line.substring(0, separator).trim().toLowerCase(), line.substring(separator + 1).trim());
+            }
+        }
+
+        let key : string | undefined = headers.get("sec-websocket-key");
+        if (key === undefined) {
+            throw new MalformedPacketError("websocket handshake without a key");
+        }
+
+        this.broker.websocketHandshakes.push({ path: requestLine[1], headers: headers });
+
+        let accept : string = crypto.createHash('sha1').update(key + WEBSOCKET_ACCEPT_GUID).digest('base64');
+        let response : Array<string> = [
+            "HTTP/1.1 101 Switching Protocols",
+            "Upgrade: websocket",
+            "Connection: Upgrade",
+            `Sec-WebSocket-Accept: ${accept}`,
+        ];
+        if (headers.get("sec-websocket-protocol")?.split(',').some((protocol) => protocol.trim() == "mqtt")) {
+            response.push("Sec-WebSocket-Protocol: mqtt");
+        }
+
+        this.socket.write(response.join("\r\n") + "\r\n\r\n");
+        this.isWebsocketUpgraded = true;
+
+        return true;
+    }
+
+    /* Unmasks every complete client frame and feeds data frames through the MQTT packet parser */
+    private onWebsocketFrames() {
+        while (this.pendingWebsocket.length >= 2 && !this.socket.destroyed) {
+            let frame : Buffer = this.pendingWebsocket;
+            let opcode : number = frame[0] & 0x0F;
+            if ((frame[1] & 0x80) == 0) {
+                throw new MalformedPacketError("client websocket frames must be masked");
+            }
+
+            let length : number = frame[1] & 0x7F;
+            let offset : number = 2;
+            if (length == 126) {
+                if (frame.length < 4) {
+                    return;
+                }
+                length = frame.readUInt16BE(2);
+                offset = 4;
+            } else if (length == 127) {
+                if (frame.length < 10) {
+                    return;
+                }
+                length = Number(frame.readBigUInt64BE(2));
+                offset = 10;
+            }
+
+            let frameEnd : number = offset + 4 + length;
+            if (frame.length < frameEnd) {
+                return;
+            }
+
+            let mask : Buffer = frame.subarray(offset, offset + 4);
+            let payload : Buffer = Buffer.from(frame.subarray(offset + 4, frameEnd));
+            for (let i = 0; i < payload.length; i++) {
+                payload[i] ^= mask[i % 4];
+            }
+            this.pendingWebsocket = frame.subarray(frameEnd);
+
+            switch (opcode) {
+                case WEBSOCKET_OPCODE_CONTINUATION:
+                case WEBSOCKET_OPCODE_TEXT:
+                case WEBSOCKET_OPCODE_BINARY:
+                    this.onData(payload);
+                    break;
+                case WEBSOCKET_OPCODE_CLOSE:
+                    this.socket.end(encodeWebsocketFrame(WEBSOCKET_OPCODE_CLOSE, Buffer.alloc(0)));
+                    return;
+                case WEBSOCKET_OPCODE_PING:
+                    this.socket.write(encodeWebsocketFrame(WEBSOCKET_OPCODE_PONG, payload));
+                    break;
+                case WEBSOCKET_OPCODE_PONG:
+                    break;
+                default:
+                    throw new MalformedPacketError(`unexpected websocket opcode ${opcode}`);
+            }
+        }
+    }
+
+    private onData(data: Buffer) {
+        this.pending = this.pending.length > 0 ? Buffer.concat([this.pending, data]) : data;
+
+        try {
+            while (this.pending.length >= 2 && !this.socket.destroyed) {
+                let header : PacketReader = new PacketReader(this.pending, 1);
+                let remainingLength : number;
+                try {
+                    remainingLength = header.readVariableByteInteger();
+                } catch (e) {
+                    if (this.pending.length < 5) {
+                        return;
+                    }
+                    throw e;
+                }
+
+                let packetEnd : number = header.offset + remainingLength;
+                if (this.pending.length < packetEnd) {
+                    return;
+                }
+
+                let firstByte : number = this.pending[0];
+                let body : Buffer = this.pending.subarray(header.offset, packetEnd);
+                this.pending = this.pending.subarray(packetEnd);
+
+                this.onPacket(firstByte >> 4, firstByte & 0x0F, new PacketReader(body));
+            }
+        } catch (e) {
+            this.socket.destroy();
+        }
+    }
+
+    private onClose() {
+        if (this.will) {
+            this.broker.publish(this, this.will);
+            this.will = undefined;
+        }
+
+        this.broker.removeConnection(this);
+    }
+
+    private onPacket(type: number, flags: number, reader: PacketReader) {
+        if (!this.isConnected && type != PacketType.Connect) {
+            throw new MalformedPacketError("first packet must be CONNECT");
+        }
+
+        switch (type) {
+            case PacketType.Connect: this.onConnect(reader); break;
+            case PacketType.Publish: this.onPublish(flags, reader); break;
+            case PacketType.Puback: break;
+            case PacketType.Pubrel:
+                this.send(encodePacket(PacketType.Pubcomp << 4, this.acknowledgementBody(reader.readUInt16())));
+                break;
+            case PacketType.Subscribe: this.onSubscribe(reader); break;
+            case PacketType.Unsubscribe: this.onUnsubscribe(reader); break;
+            case PacketType.Pingreq: this.send(Buffer.from([PacketType.Pingresp << 4, 0])); break;
+            case PacketType.Disconnect: this.onDisconnect(reader); break;
+            default: throw new MalformedPacketError(`unexpected packet type ${type}`);
+        }
+    }
+
+    private acknowledgementBody(packetId: number) : Array<Buffer> {
+        /* an MQTT5 acknowledgement with a success reason code and no properties may omit both */
+        return [encodeUInt16(packetId)];
+    }
+
+    private onConnect(reader: PacketReader) {
+        if (this.isConnected) {
+            throw new MalformedPacketError("duplicate CONNECT");
+        }
+
+        reader.readString();
+        this.protocolLevel = reader.readByte();
+        if (this.protocolLevel != PROTOCOL_LEVEL_311 && this.protocolLevel != PROTOCOL_LEVEL_5) {
+            /* 3.1.1 "unacceptable protocol version", which older and newer clients both understand */
+            this.send(Buffer.from([PacketType.Connack << 4, 2, 0, 1]));
+            this.socket.end();
+            return;
+        }
+
+        let connectFlags : number = reader.readByte();
+        reader.readUInt16();
+        if (this.isMqtt5) {
+            reader.readProperties();
+        }
+
+        this.clientId = reader.readString();
+
+        if (connectFlags & 0x04) {
+            let willProperties : Array<Buffer> = this.isMqtt5 ? reader.readProperties().map((property) => property.encoding) : [];
+            let willTopic : string = reader.readString();
+            let willPayload : Buffer = Buffer.from(reader.readBinary());
+            this.will = {
+                topic: willTopic,
+                payload: willPayload,
+                qos: Math.min((connectFlags >> 3) & 0x03, 1),
+                retain: (connectFlags & 0x20) != 0,
+                properties: willProperties,
+            };
+        }
+
+        if (connectFlags & 0x80) {
+            reader.readString();
+        }
+
+        if (connectFlags & 0x40) {
+            reader.readBinary();
+        }
+
+        let properties : Array<Buffer> = [];
+        if (this.isMqtt5) {
+            properties.push(
+                Buffer.from([PROPERTY_MAXIMUM_QOS, 1]),
+                Buffer.from([PROPERTY_RETAIN_AVAILABLE, 1]),
+                Buffer.from([PROPERTY_WILDCARD_SUBSCRIPTIONS_AVAILABLE, 1]),
+                Buffer.from([PROPERTY_SUBSCRIPTION_IDENTIFIERS_AVAILABLE, 0]),
+                Buffer.from([PROPERTY_SHARED_SUBSCRIPTIONS_AVAILABLE, 1]),
+                Buffer.concat([Buffer.from([PROPERTY_TOPIC_ALIAS_MAXIMUM]), encodeUInt16(TOPIC_ALIAS_MAXIMUM)]));
+        }
+
+        if (this.clientId.length == 0) {
+            this.clientId = this.broker.assignClientId();
+            if (this.isMqtt5) {
+                properties.push(Buffer.concat([Buffer.from([PROPERTY_ASSIGNED_CLIENT_IDENTIFIER]), encodeString(this.clientId)]));
+            }
+        }
+
+        this.broker.addConnection(this);
+        this.isConnected = true;
+
+        let parts : Array<Buffer> = [Buffer.from([0, 0])];
+        if (this.isMqtt5) {
+            parts.push(encodeProperties(properties));
+        }
+        this.send(encodePacket(PacketType.Connack << 4, parts));
+    }
+
+    private onPublish(flags: number, reader: PacketReader) {
+        let qos : number = (flags >> 1) & 0x03;
+        let retain : boolean = (flags & 0x01) != 0;
+        if (qos > 2) {
+            throw new MalformedPacketError("invalid publish QoS");
+        }
+
+        let topic : string = reader.readString();
+        let packetId : number = qos > 0 ? reader.readUInt16() : 0;
+
+        let properties : Array<Buffer> = [];
+        if (this.isMqtt5) {
+            for (let property of reader.readProperties()) {
+                if (property.id == PROPERTY_TOPIC_ALIAS) {
+                    if (property.value == 0 || property.value > TOPIC_ALIAS_MAXIMUM) {
+                        throw new MalformedPacketError("invalid topic alias");
+                    }
+
+                    if (topic.length > 0) {
+                        this.inboundTopicAliases.set(property.value, topic);
+                    } else {
+                        topic = this.inboundTopicAliases.get(property.value) ?? "";
+                    }
+                } else if (property.id != PROPERTY_SUBSCRIPTION_IDENTIFIER) {
+                    properties.push(property.encoding);
+                }
+            }
+        }
+
+        if (topic.length == 0 || topic.includes('+') || topic.includes('#')) {
+            throw new MalformedPacketError("invalid publish topic");
+        }
+
+        /* copy out of the receive buffer, which is reused for later packets */
+        let message : BrokerMessage = {
+            topic: topic,
+            payload: Buffer.from(reader.readRest()),
+            qos: Math.min(qos, 1),
+            retain: retain,
+            properties: properties.map((property) => Buffer.from(property)),
+        };
+
+        this.broker.publish(this, message);
+
+        if (qos == 1) {
+            this.send(encodePacket(PacketType.Puback << 4, this.acknowledgementBody(packetId)));
+        } else if (qos == 2) {
+            this.send(encodePacket(PacketType.Pubrec << 4, this.acknowledgementBody(packetId)));
+        }
+    }
+
+    private onSubscribe(reader: PacketReader) {
+        let packetId : number = reader.readUInt16();
+        if (this.isMqtt5) {
+            reader.readProperties();
+        }
+
+        let reasonCodes : Array<number> = [];
+        while (reader.remaining > 0) {
+            let filter : string = reader.readString();
+            let options : number = reader.readByte();
+            let qos : number = options & 0x03;
+
+            if (qos > 2 || !this.broker.subscribe(this, filter, options)) {
+                reasonCodes.push(this.isMqtt5 ? 0x8F : 0x80);
+            } else {
+                reasonCodes.push(Math.min(qos, 1));
+            }
+        }
+
+        let parts : Array<Buffer> = [encodeUInt16(packetId)];
+        if (this.isMqtt5) {
+            parts.push(encodeProperties([]));
+        }
+        parts.push(Buffer.from(reasonCodes));
+
+        this.send(encodePacket((PacketType.Suback << 4), parts));
+    }
+
+    private onUnsubscribe(reader: PacketReader) {
+        let packetId : number = reader.readUInt16();
+        if (this.isMqtt5) {
+            reader.readProperties();
+        }
+
+        let reasonCodes : Array<number> = [];
+        while (reader.remaining > 0) {
+            let existed : boolean = this.broker.unsubscribe(this, reader.readString());
+            reasonCodes.push(existed ? 0x00 : 0x11);
+        }
+
+        let parts : Array<Buffer> = [encodeUInt16(packetId)];
+        if (this.isMqtt5) {
+            parts.push(encodeProperties([]), Buffer.from(reasonCodes));
+        }
+
+        this.send(encodePacket((PacketType.Unsuback << 4), parts));
+    }
+
+    private onDisconnect(reader: PacketReader) {
+        let reasonCode : number = (this.isMqtt5 && reader.remaining > 0) ? reader.readByte() : 0;
+        if (reasonCode != DISCONNECT_WITH_WILL_MESSAGE) {
+            this.will = undefined;
+        }
+
+        this.socket.end();
+    }
+}
+
+/**
+ * In-process MQTT 3.1.1/5 broker for tests and benchmarks that should not depend on a live endpoint.
+ *
+ * Not suitable for production use: nothing is persisted, outbound QoS 1 delivery is not retried, and every client is
+ * accepted.
+ */
+export class LocalMqttBroker {
+
+    /**
+     * Delay, in milliseconds, applied to every publish the broker delivers to a subscriber.
+     */
+    latencyMs : number = 0;
+
+    /**
+     * Probability (0 to 1) that any individual delivery to a subscriber is silently dropped.
+     */
+    dropRate : number = 0;
+
+    readonly statistics : LocalMqttBrokerStatistics = {
+        connections: 0,
+        publishesReceived: 0,
+        publishesDelivered: 0,
+        publishesDropped: 0,
+    };
+
+    /**
+     * Every websocket upgrade request received, in order
+     */
+    readonly websocketHandshakes : Array<LocalMqttBrokerWebsocketHandshake> = [];
+
+    private server : net.Server;
+    private connections : Map<string, BrokerConnection> = new Map();
+    private sockets : Set<net.Socket> = new Set();
+    private subscriptions : Array<Subscription> = [];
+    private sharedSubscriptions : Map<string, SharedSubscriptionGroup> = new Map();
+    private retained : Map<string, BrokerMessage> = new Map();
+    private nextClientId : number = 1;
+
+    constructor(private options: LocalMqttBrokerOptions = {}) {
+        this.server = net.createServer((socket: net.Socket) => {
+            this.sockets.add(socket);
+            socket.on('close', () => { this.sockets.delete(socket); });
+            new BrokerConnection(this, socket);
+        });
+    }
+
+    /**
+     * Starts listening and resolves with the port clients should connect to
+     */
+    async start() : Promise<number> {
+        await new Promise<void>((resolve, reject) => {
+            this.server.once('error', reject);
+            this.server.listen(this.options.port ?? 0, this.options.host ?? "127.0.0.1", () => {
+                this.server.removeListener('error', reject);
+                resolve();
+            });
+        });
+
+        return this.port;
+    }
+
+    /**
+     * Disconnects every client and stops listening
+     */
+    async stop() : Promise<void> {
+        this.disconnectAllClients();
+        await new Promise<void>((resolve) => { this.server.close(() => { resolve(); }); });
+    }
+
+    get port() : number {
+        return (this.server.address() as net.AddressInfo).port;
+    }
+
+    /**
+     * Drops every client connection without sending DISCONNECT, as if the network failed
+     */
+    disconnectAllClients() {
+        for (let socket of this.sockets) {
+            socket.destroy();
+        }
+    }
+
+    /** @internal */
+    assignClientId() : string {
+        return `local-broker-client-${this.nextClientId++}`;
+    }
+
+    /** @internal */
+    addConnection(connection: BrokerConnection) {
+        /* a new connection with the same client id takes over; sessions are never resumed */
+        let existing : BrokerConnection | undefined = this.connections.get(connection.clientId);
+        if (existing) {
+            existing.close();
+            this.removeConnection(existing);
+        }
+
+        this.connections.set(connection.clientId, connection);
+        this.statistics.connections++;
+    }
+
+    /** @internal */
+    removeConnection(connection: BrokerConnection) {
+        if (this.connections.get(connection.clientId) === connection) {
+            this.connections.delete(connection.clientId);
+        }
+
+        this.subscriptions = this.subscriptions.filter((subscription) => subscription.connection !== connection);
+        for (let [key, group] of this.sharedSubscriptions) {
+            group.members = group.members.filter((subscription) => subscription.connection !== connection);
+            if (group.members.length == 0) {
+                this.sharedSubscriptions.delete(key);
+            }
+        }
+    }
+
+    /** @internal */
+    subscribe(connection: BrokerConnection, filter: string, options: number) : boolean {
+        let subscription : Subscription = {
+            connection: connection,
+            filter: filter,
+            qos: Math.min(options & 0x03, 1),
+            noLocal: connection.isMqtt5 && (options & 0x04) != 0,
+            retainAsPublished: connection.isMqtt5 && (options & 0x08) != 0,
+        };
+
+        let shared : {group: string, filter: string} | undefined = LocalMqttBroker.parseSharedFilter(filter);
+        if (shared) {
+            if (!isValidTopicFilter(shared.filter) || shared.group.length == 0) {
+                return false;
+            }
+
+            subscription.filter = shared.filter;
+            subscription.noLocal = false;
+
+            let group : SharedSubscriptionGroup = this.sharedSubscriptions.get(filter) ?? { filter: shared.filter, members: [], next: 0 };
+            group.members = group.members.filter((member) => member.connection !== connection);
+            group.members.push(subscription);
+            this.sharedSubscriptions.set(filter, group);
+
+            /* retained messages are never sent for shared subscriptions */
+            return true;
+        }
+
+        if (!isValidTopicFilter(filter)) {
+            return false;
+        }
+
+        let existingIndex : number = this.subscriptions.findIndex((existing) => existing.connection === connection && existing.filter == filter);
+        let isNew : boolean = existingIndex < 0;
+        if (isNew) {
+            this.subscriptions.push(subscription);
+        } else {
+            this.subscriptions[existingIndex] = subscription;
+        }
+
+        /* MQTT5 retain handling: 0 = always send retained, 1 = only for new subscriptions, 2 = never */
+        let retainHandling : number = connection.isMqtt5 ? (options >> 4) & 0x03 : 0;
+        if (retainHandling == 0 || (retainHandling == 1 && isNew)) {
+            for (let message of this.retained.values()) {
+                if (topicMatchesFilter(message.topic, filter)) {
+                    this.deliver(subscription, message, true);
+                }
+            }
+        }
+
+        return true;
+    }
+
+    /** @internal */
+    unsubscribe(connection: BrokerConnection, filter: string) : boolean {
+        let group : SharedSubscriptionGroup | undefined = this.sharedSubscriptions.get(filter);
+        if (group) {
+            let count : number = group.members.length;
+            group.members = group.members.filter((member) => member.connection !== connection);
+            if (group.members.length == 0) {
+                this.sharedSubscriptions.delete(filter);
+            }
+
+            return group.members.length != count;
+        }
+
+        let count : number = this.subscriptions.length;
+        this.subscriptions = this.subscriptions.filter((subscription) => subscription.connection !== connection || subscription.filter != filter);
+
+        return this.subscriptions.length != count;
+    }
+
+    /** @internal */
+    publish(source: BrokerConnection, message: BrokerMessage) {
+        this.statistics.publishesReceived++;
+
+        if (message.retain) {
+            if (message.payload.length == 0) {
+                this.retained.delete(message.topic);
+            } else {
+                this.retained.set(message.topic, message);
+            }
+        }
+
+        /* a client receives one copy per publish even if several of its subscriptions match, at the highest QoS */
+        let targets : Map<BrokerConnection, Subscription> = new Map();
+        for (let subscription of this.subscriptions) {
+            if ((subscription.noLocal && subscription.connection === source) || !topicMatchesFilter(message.topic, subscription.filter)) {
+                continue;
+            }
+
+            let existing : Subscription | undefined = targets.get(subscription.connection);
+            if (!existing || existing.qos < subscription.qos) {
+                targets.set(subscription.connection, subscription);
+            }
+        }
+
+        for (let subscription of targets.values()) {
+            this.deliver(subscription, message, subscription.retainAsPublished && message.retain);
+        }
+
+        for (let group of this.sharedSubscriptions.values()) {
+            if (group.members.length > 0 && topicMatchesFilter(message.topic, group.filter)) {
+                let member : Subscription = group.members[group.next % group.members.length];
+                group.next = (group.next + 1) % group.members.length;
+                this.deliver(member, message, false);
+            }
+        }
+    }
+
+    private deliver(subscription: Subscription, message: BrokerMessage, retain: boolean) {
+        if (this.dropRate > 0 && Math.random() < this.dropRate) {
+            this.statistics.publishesDropped++;
+            return;
+        }
+
+        let qos : number = Math.min(subscription.qos, message.qos);
+        let send = () => {
+            if (subscription.connection.isConnected) {
+                subscription.connection.deliver(message, qos, retain);
+                this.statistics.publishesDelivered++;
+            }
+        };
+
+        if (this.latencyMs > 0) {
+            setTimeout(send, this.latencyMs);
+        } else {
+            send();
+        }
+    }
+
+    private static parseSharedFilter(filter: string) : {group: string, filter: string} | undefined {
+        if (!filter.startsWith("$share/")) {
+            return undefined;
+        }
+
+        let groupEnd : number = filter.indexOf('/', 7);
+        if (groupEnd < 0) {
+            return { group: "", filter: "" };
+        }
+
+        return { group: filter.substring(7, groupEnd), filter: filter.substring(groupEnd + 1) };
+    }
+}